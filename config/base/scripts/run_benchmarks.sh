@@ -0,0 +1,17 @@
+#!/bin/bash
+
+# ------------------------------------------------------------------------------------------------ #
+#                                This file is part of CosmoScout VR                                #
+#       and may be used under the terms of the MIT license. See the LICENSE file for details.      #
+#                         Copyright: (c) 2019 German Aerospace Center (DLR)                        #
+# ------------------------------------------------------------------------------------------------ #
+
+# Change working directory to the location of this script.
+SCRIPT_DIR="$( cd "$( dirname "$0" )" && pwd )"
+cd "$SCRIPT_DIR"
+
+# Set paths so that all libraries are found.
+export LD_LIBRARY_PATH=../lib:../lib/DriverPlugins:$LD_LIBRARY_PATH
+
+# Run all test cases which are marked as benchmarks. They print their timings to the console.
+./cosmoscout --run-tests --test-case="*[benchmark]*"
@@ -45,7 +45,8 @@ AnchorLabel::AnchorLabel(cs::scene::CelestialBody const* const body,
     , mInputManager(std::move(inputManager))
     , mGuiArea(std::make_unique<cs::gui::WorldSpaceGuiArea>(120, 30)) // NOLINT
     , mGuiItem(
-          std::make_unique<cs::gui::GuiItem>("file://../share/resources/gui/anchor_label.html")) {
+          std::make_unique<cs::gui::GuiItem>("file://../share/resources/gui/anchor_label.html"))
+    , mRawAnchor(mBody->getCenterName(), mBody->getFrameName()) {
   auto* sceneGraph = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
 
   mAnchor = std::make_shared<cs::scene::CelestialAnchorNode>(sceneGraph->GetRoot(),
@@ -101,22 +102,22 @@ void AnchorLabel::update() {
   if (mBody->getIsInExistence()) {
     double simulationTime(mTimeControl->pSimulationTime.get());
 
-    cs::scene::CelestialAnchor rawAnchor(mAnchor->getCenterName(), mAnchor->getFrameName());
-    rawAnchor.setAnchorPosition(mAnchor->getAnchorPosition());
+    mRawAnchor.setAnchorPosition(mAnchor->getAnchorPosition());
 
-    mRelativeAnchorPosition =
-        mSolarSystem->getObserver().getRelativePosition(simulationTime, rawAnchor);
+    // The transformation of the observer relative to the anchor is computed only once. The
+    // position of the anchor relative to the observer is derived from its inverse.
+    auto observerTransform =
+        mRawAnchor.getRelativeTransform(simulationTime, mSolarSystem->getObserver());
 
-    double distanceToObserver = distanceToCamera();
+    mRelativeAnchorPosition = glm::inverse(observerTransform)[3];
+    mDistanceToCamera       = glm::length(mRelativeAnchorPosition);
 
     double const scaleFactor = 0.05;
     double       scale       = mSolarSystem->getObserver().getAnchorScale();
-    scale *= glm::pow(distanceToObserver, mPluginSettings->mDepthScale.get()) *
+    scale *= glm::pow(mDistanceToCamera, mPluginSettings->mDepthScale.get()) *
              mPluginSettings->mLabelScale.get() * scaleFactor;
     mAnchor->setAnchorScale(scale);
 
-    auto observerTransform =
-        rawAnchor.getRelativeTransform(simulationTime, mSolarSystem->getObserver());
     glm::dvec3 observerPos = observerTransform[3];
     glm::dvec3 y           = observerTransform * glm::dvec4(0, 1, 0, 0);
     glm::dvec3 camDir      = glm::normalize(observerPos);
@@ -132,23 +133,22 @@ void AnchorLabel::update() {
     mAnchor->setAnchorRotation(rot);
 
     mAnchor->update(simulationTime, mSolarSystem->getObserver());
+
+    double const width =
+        mPluginSettings->mLabelScale.get() * static_cast<double>(mGuiArea->getWidth()) * 0.0005;
+    double const height =
+        mPluginSettings->mLabelScale.get() * static_cast<double>(mGuiArea->getHeight()) * 0.0005;
+
+    auto const screenPos = (mRelativeAnchorPosition.xyz() / mRelativeAnchorPosition.z).xy();
+
+    mScreenSpaceBB = {screenPos.x - (width / 2.0), screenPos.y - (height / 2.0), width, height};
   }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 glm::dvec4 AnchorLabel::getScreenSpaceBB() const {
-  double const width =
-      mPluginSettings->mLabelScale.get() * static_cast<double>(mGuiArea->getWidth()) * 0.0005;
-  double const height =
-      mPluginSettings->mLabelScale.get() * static_cast<double>(mGuiArea->getHeight()) * 0.0005;
-
-  auto const screenPos = (mRelativeAnchorPosition.xyz() / mRelativeAnchorPosition.z).xy();
-
-  double const x = screenPos.x - (width / 2.0);
-  double const y = screenPos.y - (height / 2.0);
-
-  return {x, y, width, height};
+  return mScreenSpaceBB;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -165,6 +165,12 @@ void AnchorLabel::disable() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+bool AnchorLabel::isEnabled() const {
+  return mGuiItem->getIsEnabled();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 std::string const& AnchorLabel::getCenterName() const {
   return mBody->getCenterName();
 }
@@ -184,7 +190,7 @@ double AnchorLabel::bodySize() const {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 double AnchorLabel::distanceToCamera() const {
-  return glm::length(mRelativeAnchorPosition);
+  return mDistanceToCamera;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
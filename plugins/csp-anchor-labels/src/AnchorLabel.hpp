@@ -55,6 +55,7 @@ class AnchorLabel {
 
   void enable() const;
   void disable() const;
+  bool isEnabled() const;
 
   glm::dvec4 getScreenSpaceBB() const;
 
@@ -74,8 +75,16 @@ class AnchorLabel {
   std::unique_ptr<VistaOpenGLNode>            mGuiNode;
   std::unique_ptr<VistaTransformNode>         mGuiTransform;
 
+  // This has the same position as mAnchor but no rotation or scale. It is used to compute the
+  // position and orientation of the observer relative to the anchor.
+  cs::scene::CelestialAnchor mRawAnchor;
+
+  // These are computed once per frame in update().
   glm::dvec3 mRelativeAnchorPosition{};
-  int        mOffsetConnection = -1;
+  glm::dvec4 mScreenSpaceBB{};
+  double     mDistanceToCamera = 0.0;
+
+  int mOffsetConnection = -1;
 };
 } // namespace csp::anchorlabels
 
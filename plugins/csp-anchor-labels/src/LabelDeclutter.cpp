@@ -0,0 +1,157 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "LabelDeclutter.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace csp::anchorlabels {
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Cell coordinates are clamped to this range, so that labels far off screen do not overflow the
+// cell keys.
+double const MAX_CELL = 1 << 30;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int64_t getCell(double coordinate, double cellSize) {
+  return static_cast<int64_t>(std::clamp(std::floor(coordinate / cellSize), -MAX_CELL, MAX_CELL));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int64_t getKey(int64_t x, int64_t y) {
+  return x * (int64_t(1) << 32) + y;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool collide(glm::dvec4 const& a, glm::dvec4 const& b) {
+  return b.x + b.z > a.x && b.y + b.w > a.y && a.x + a.z > b.x && a.y + a.w > b.y;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LabelDeclutter::declutter(std::vector<Label> const& labels, std::vector<bool>& visible) {
+  visible.assign(labels.size(), false);
+
+  // The cells are as large as the largest label, so that each label overlaps at most four cells.
+  double cellSize = 0.0;
+  for (auto const& label : labels) {
+    if (!label.mHidden) {
+      cellSize = std::max({cellSize, label.mScreenSpaceBB.z, label.mScreenSpaceBB.w});
+    }
+  }
+
+  if (!(cellSize > 0.0) || !std::isfinite(cellSize)) {
+    cellSize = 1.0;
+  }
+
+  // The cells of the last frame are reused to avoid allocations. If the cells of many frames have
+  // accumulated, they are removed.
+  if (mCells.size() > 4 * labels.size()) {
+    mCells.clear();
+  } else {
+    for (auto& cell : mCells) {
+      cell.second.clear();
+    }
+  }
+
+  double const maxRelativeDistance = 1.0 + mIgnoreOverlapThreshold * 0.1;
+
+  // With larger values, visible labels would never be hidden.
+  double const hysteresis = std::clamp(mHysteresis, 0.0, 0.45);
+
+  for (uint32_t i = 0; i < labels.size(); ++i) {
+    auto const& label = labels[i];
+
+    if (label.mHidden) {
+      continue;
+    }
+
+    glm::dvec4 const& bb = label.mScreenSpaceBB;
+
+    // Labels at the position of the camera cannot be projected to the screen. As they do not
+    // collide with any other label, they are shown.
+    if (!std::isfinite(bb.x) || !std::isfinite(bb.y)) {
+      visible[i] = true;
+      continue;
+    }
+
+    // Labels which have been visible before are made smaller, all others larger.
+    double     factor = label.mWasVisible ? -hysteresis : hysteresis;
+    glm::dvec2 margin = glm::dvec2(bb.z, bb.w) * factor;
+    glm::dvec4 testBB(
+        bb.x - margin.x, bb.y - margin.y, bb.z + 2.0 * margin.x, bb.w + 2.0 * margin.y);
+
+    int64_t minX = getCell(testBB.x, cellSize);
+    int64_t minY = getCell(testBB.y, cellSize);
+    int64_t maxX = getCell(testBB.x + testBB.z, cellSize);
+    int64_t maxY = getCell(testBB.y + testBB.w, cellSize);
+
+    bool canBeAdded = true;
+
+    for (int64_t x = minX; x <= maxX && canBeAdded; ++x) {
+      for (int64_t y = minY; y <= maxY && canBeAdded; ++y) {
+        auto cell = mCells.find(getKey(x, y));
+
+        if (cell == mCells.end()) {
+          continue;
+        }
+
+        for (uint32_t j : cell->second) {
+          auto const& other = labels[j];
+
+          if (mEnableDepthOverlap) {
+            // Check the distance relative to each other. If they are far apart we can display
+            // both.
+            double relativeDistance = label.mDistance < other.mDistance
+                                          ? other.mDistance / label.mDistance
+                                          : label.mDistance / other.mDistance;
+            if (relativeDistance > maxRelativeDistance) {
+              continue;
+            }
+          }
+
+          if (collide(testBB, other.mScreenSpaceBB)) {
+            canBeAdded = false;
+            break;
+          }
+        }
+      }
+    }
+
+    if (!canBeAdded) {
+      continue;
+    }
+
+    visible[i] = true;
+
+    // Accepted labels are stored with their actual size.
+    minX = getCell(bb.x, cellSize);
+    minY = getCell(bb.y, cellSize);
+    maxX = getCell(bb.x + bb.z, cellSize);
+    maxY = getCell(bb.y + bb.w, cellSize);
+
+    for (int64_t x = minX; x <= maxX; ++x) {
+      for (int64_t y = minY; y <= maxY; ++y) {
+        mCells[getKey(x, y)].push_back(i);
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::anchorlabels
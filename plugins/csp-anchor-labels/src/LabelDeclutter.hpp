@@ -0,0 +1,57 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_ANCHOR_LABELS_LABEL_DECLUTTER_HPP
+#define CSP_ANCHOR_LABELS_LABEL_DECLUTTER_HPP
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace csp::anchorlabels {
+
+/// The LabelDeclutter decides which labels can be shown without overlapping other labels on
+/// screen. Labels which have already been accepted are stored in a uniform screen-space grid, so
+/// that each label has to be compared with its neighbors only. To avoid flickering, labels which
+/// were visible in the last frame are kept a bit longer than new labels would be shown.
+class LabelDeclutter {
+ public:
+  /// The data of a label which is required for decluttering. This should be computed once per
+  /// frame for each label.
+  struct Label {
+    glm::dvec4 mScreenSpaceBB{}; ///< x, y, width and height of the label on screen.
+    double     mDistance{};      ///< The distance of the label to the camera.
+    bool       mHidden{};        ///< If true, the label is not shown in any case.
+    bool       mWasVisible{};    ///< If true, the label was shown in the last frame.
+  };
+
+  /// If set to false, labels will never overlap. See Plugin::Settings::mEnableDepthOverlap.
+  bool mEnableDepthOverlap = true;
+
+  /// Labels whose relative difference in distance to the camera exceeds this value may overlap.
+  /// See Plugin::Settings::mIgnoreOverlapThreshold.
+  double mIgnoreOverlapThreshold = 0.025;
+
+  /// Labels which were visible in the last frame are shrunk by this fraction of their size when
+  /// they are tested for collisions, all other labels are enlarged accordingly. Hence a label
+  /// disappears only if it clearly overlaps another label and re-appears only if there is some
+  /// space around it.
+  double mHysteresis = 0.1;
+
+  /// Decides which of the given labels should be visible. The labels have to be sorted by
+  /// decreasing priority, if two labels collide, the one coming first is shown. The result is
+  /// stored in the given vector, which is resized to the number of labels.
+  void declutter(std::vector<Label> const& labels, std::vector<bool>& visible);
+
+ private:
+  // The labels which have been accepted so far, indexed by the grid cells they overlap.
+  std::unordered_map<int64_t, std::vector<uint32_t>> mCells;
+};
+
+} // namespace csp::anchorlabels
+
+#endif // CSP_ANCHOR_LABELS_LABEL_DECLUTTER_HPP
@@ -41,6 +41,7 @@ void from_json(nlohmann::json const& j, Plugin::Settings& o) {
   cs::core::Settings::deserialize(j, "labelScale", o.mLabelScale);
   cs::core::Settings::deserialize(j, "depthScale", o.mDepthScale);
   cs::core::Settings::deserialize(j, "labelOffset", o.mLabelOffset);
+  cs::core::Settings::deserialize(j, "hysteresis", o.mHysteresis);
 }
 
 void to_json(nlohmann::json& j, Plugin::Settings const& o) {
@@ -50,6 +51,7 @@ void to_json(nlohmann::json& j, Plugin::Settings const& o) {
   cs::core::Settings::serialize(j, "labelScale", o.mLabelScale);
   cs::core::Settings::serialize(j, "depthScale", o.mDepthScale);
   cs::core::Settings::serialize(j, "labelOffset", o.mLabelOffset);
+  cs::core::Settings::serialize(j, "hysteresis", o.mHysteresis);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -152,51 +154,31 @@ void Plugin::update() {
       label->update();
     }
 
-    std::unordered_set<AnchorLabel*> labelsToDraw;
-    for (auto const& label : mAnchorLabels) {
-      if (label->shouldBeHidden()) {
-        continue;
-      }
-
-      glm::dvec4 A             = label->getScreenSpaceBB();
-      double     distToCameraA = label->distanceToCamera();
-
-      bool canBeAdded = true;
-      for (auto&& drawLabel : labelsToDraw) {
-        if (mPluginSettings->mEnableDepthOverlap.get()) {
-          // Check the distance relative to each other. If they are far apart we can display both.
-          double distToCameraB    = drawLabel->distanceToCamera();
-          double relativeDistance = distToCameraA < distToCameraB ? distToCameraB / distToCameraA
-                                                                  : distToCameraA / distToCameraB;
-          if (relativeDistance > 1 + mPluginSettings->mIgnoreOverlapThreshold.get() * 0.1) {
-            continue;
-          }
-        }
-
-        // Check if they are colliding. If they collide the bigger label survives. Since the list
-        // is sorted by body size, it is assured that the bigger label gets displayed.
-        glm::dvec4 B   = drawLabel->getScreenSpaceBB();
-        bool collision = B.x + B.z > A.x && B.y + B.w > A.y && A.x + A.z > B.x && A.y + A.w > B.y;
-        if (collision) {
-          canBeAdded = false;
-          break;
-        }
-      }
-
-      if (canBeAdded) {
-        labelsToDraw.insert(label.get());
-      }
+    // The screen-space bounding boxes and distances are computed once per label in
+    // AnchorLabel::update(). Since the list is sorted by body size, it is assured that the bigger
+    // label gets displayed if two labels collide.
+    mDeclutterLabels.resize(mAnchorLabels.size());
+    for (std::size_t i = 0; i < mAnchorLabels.size(); ++i) {
+      auto const& label   = mAnchorLabels[i];
+      mDeclutterLabels[i] = {label->getScreenSpaceBB(), label->distanceToCamera(),
+          label->shouldBeHidden(), label->isEnabled()};
     }
 
-    for (auto&& label : mAnchorLabels) {
-      if (labelsToDraw.find(label.get()) != labelsToDraw.end()) {
-        label->enable();
+    mDeclutter.mEnableDepthOverlap     = mPluginSettings->mEnableDepthOverlap.get();
+    mDeclutter.mIgnoreOverlapThreshold = mPluginSettings->mIgnoreOverlapThreshold.get();
+    mDeclutter.mHysteresis             = mPluginSettings->mHysteresis.get();
+    mDeclutter.declutter(mDeclutterLabels, mVisibleLabels);
+
+    std::vector<AnchorLabel*> sortedLabels;
+    for (std::size_t i = 0; i < mAnchorLabels.size(); ++i) {
+      if (mVisibleLabels[i]) {
+        mAnchorLabels[i]->enable();
+        sortedLabels.push_back(mAnchorLabels[i].get());
       } else {
-        label->disable();
+        mAnchorLabels[i]->disable();
       }
     }
 
-    std::vector<AnchorLabel*> sortedLabels(labelsToDraw.begin(), labelsToDraw.end());
     std::sort(sortedLabels.begin(), sortedLabels.end(), [](AnchorLabel* a, AnchorLabel* b) {
       return a->distanceToCamera() < b->distanceToCamera();
     });
@@ -10,6 +10,8 @@
 #include "../../../src/cs-core/PluginBase.hpp"
 #include "../../../src/cs-core/Settings.hpp"
 #include "../../../src/cs-utils/Property.hpp"
+#include "LabelDeclutter.hpp"
+
 #include <memory>
 #include <vector>
 
@@ -47,6 +49,11 @@ class Plugin : public cs::core::PluginBase {
 
     /// The value describes the labels height over the anchor.
     cs::utils::DefaultProperty<double> mLabelOffset{0.2};
+
+    /// Prevents labels from flickering when they are close to colliding. Labels are hidden only if
+    /// they overlap another label by this fraction of their size and are shown again only if there
+    /// is as much space around them.
+    cs::utils::DefaultProperty<double> mHysteresis{0.1};
   };
 
   void init() override;
@@ -59,6 +66,11 @@ class Plugin : public cs::core::PluginBase {
   std::shared_ptr<Settings>                 mPluginSettings = std::make_shared<Settings>();
   std::vector<std::unique_ptr<AnchorLabel>> mAnchorLabels;
 
+  // These are reused each frame to avoid allocations.
+  LabelDeclutter                     mDeclutter;
+  std::vector<LabelDeclutter::Label> mDeclutterLabels;
+  std::vector<bool>                  mVisibleLabels;
+
   bool mNeedsResort = true; ///< When a new label gets added resort the vector
 
   uint64_t addListenerId{};
@@ -0,0 +1,192 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "../src/LabelDeclutter.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+#include "../src/logger.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+namespace csp::anchorlabels {
+
+namespace {
+
+// The size of the labels with the default label scale.
+double const LABEL_WIDTH  = 0.006;
+double const LABEL_HEIGHT = 0.0015;
+
+// Creates labels at random screen positions. About a tenth of them is hidden.
+std::vector<LabelDeclutter::Label> createLabels(std::size_t count, double screenSize) {
+  std::mt19937                     generator(42);
+  std::uniform_real_distribution<> position(-screenSize, screenSize);
+  std::uniform_real_distribution<> distance(1.0, 1.1);
+  std::uniform_int_distribution<>  hidden(0, 9);
+
+  std::vector<LabelDeclutter::Label> labels(count);
+
+  for (auto& label : labels) {
+    label.mScreenSpaceBB = {position(generator), position(generator), LABEL_WIDTH, LABEL_HEIGHT};
+    label.mDistance      = distance(generator);
+    label.mHidden        = hidden(generator) == 0;
+  }
+
+  return labels;
+}
+
+// This is how labels were decluttered before: each label is compared to all accepted labels.
+std::vector<bool> declutterBruteForce(std::vector<LabelDeclutter::Label> const& labels,
+    bool enableDepthOverlap, double ignoreOverlapThreshold) {
+  std::vector<bool>   visible(labels.size(), false);
+  std::vector<size_t> accepted;
+
+  for (std::size_t i = 0; i < labels.size(); ++i) {
+    auto const& a = labels[i];
+
+    if (a.mHidden) {
+      continue;
+    }
+
+    bool canBeAdded = true;
+    for (auto j : accepted) {
+      auto const& b = labels[j];
+
+      if (enableDepthOverlap) {
+        double relativeDistance =
+            a.mDistance < b.mDistance ? b.mDistance / a.mDistance : a.mDistance / b.mDistance;
+        if (relativeDistance > 1 + ignoreOverlapThreshold * 0.1) {
+          continue;
+        }
+      }
+
+      glm::dvec4 const& A = a.mScreenSpaceBB;
+      glm::dvec4 const& B = b.mScreenSpaceBB;
+      if (B.x + B.z > A.x && B.y + B.w > A.y && A.x + A.z > B.x && A.y + A.w > B.y) {
+        canBeAdded = false;
+        break;
+      }
+    }
+
+    if (canBeAdded) {
+      visible[i] = true;
+      accepted.push_back(i);
+    }
+  }
+
+  return visible;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("csp::anchorlabels::LabelDeclutter") {
+  LabelDeclutter    declutter;
+  std::vector<bool> visible;
+
+  declutter.mHysteresis = 0.0;
+
+  SUBCASE("The result equals a comparison of all labels") {
+    auto labels = createLabels(2000, 0.1);
+
+    for (bool enableDepthOverlap : {true, false}) {
+      declutter.mEnableDepthOverlap = enableDepthOverlap;
+      declutter.declutter(labels, visible);
+
+      CHECK(visible == declutterBruteForce(labels, enableDepthOverlap, 0.025));
+    }
+  }
+
+  SUBCASE("Labels with higher priority are shown") {
+    std::vector<LabelDeclutter::Label> labels(3);
+    labels[0] = {{0.0, 0.0, 1.0, 1.0}, 1.0, false, false};
+    labels[1] = {{0.5, 0.5, 1.0, 1.0}, 1.0, false, false};
+    labels[2] = {{1.2, 1.2, 1.0, 1.0}, 1.0, false, false};
+
+    declutter.declutter(labels, visible);
+    CHECK(visible == std::vector<bool>{true, false, true});
+
+    // Hidden labels do not hide other labels.
+    labels[0].mHidden = true;
+    declutter.declutter(labels, visible);
+    CHECK(visible == std::vector<bool>{false, true, false});
+  }
+
+  SUBCASE("Labels do not flicker") {
+    declutter.mHysteresis = 0.1;
+
+    // The second label overlaps the first one by 5 percent of its width.
+    std::vector<LabelDeclutter::Label> labels(2);
+    labels[0] = {{0.0, 0.0, 1.0, 1.0}, 1.0, false, false};
+    labels[1] = {{0.95, 0.0, 1.0, 1.0}, 1.0, false, true};
+
+    // A label which has been visible before stays visible.
+    declutter.declutter(labels, visible);
+    CHECK(visible == std::vector<bool>{true, true});
+
+    // A label which has been hidden before stays hidden.
+    labels[1].mWasVisible = false;
+    declutter.declutter(labels, visible);
+    CHECK(visible == std::vector<bool>{true, false});
+
+    // Even if there is a small gap, it stays hidden.
+    labels[1].mScreenSpaceBB.x = 1.05;
+    declutter.declutter(labels, visible);
+    CHECK(visible == std::vector<bool>{true, false});
+
+    // Once the gap is large enough, it becomes visible.
+    labels[1].mScreenSpaceBB.x = 1.15;
+    declutter.declutter(labels, visible);
+    CHECK(visible == std::vector<bool>{true, true});
+  }
+
+  SUBCASE("Labels which cannot be projected are shown") {
+    std::vector<LabelDeclutter::Label> labels(2);
+    labels[0] = {{0.0, 0.0, 1.0, 1.0}, 1.0, false, false};
+    labels[1] = {{std::nan(""), std::nan(""), 1.0, 1.0}, 1.0, false, false};
+
+    declutter.declutter(labels, visible);
+    CHECK(visible == std::vector<bool>{true, true});
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("[benchmark] csp::anchorlabels::LabelDeclutter") {
+  // Ten thousand labels, for instance of a catalogue of asteroids.
+  auto labels = createLabels(10000, 0.3);
+
+  LabelDeclutter    declutter;
+  std::vector<bool> visible;
+
+  auto start    = std::chrono::high_resolution_clock::now();
+  auto expected = declutterBruteForce(labels, true, 0.025);
+  auto middle   = std::chrono::high_resolution_clock::now();
+
+  int const frames = 10;
+  for (int i = 0; i < frames; ++i) {
+    declutter.declutter(labels, visible);
+
+    for (std::size_t j = 0; j < labels.size(); ++j) {
+      labels[j].mWasVisible = visible[j];
+    }
+  }
+
+  auto end = std::chrono::high_resolution_clock::now();
+
+  logger().info("Decluttered {} labels: {:.2f} ms comparing all labels ({} visible), {:.2f} ms "
+                "with the screen-space grid ({} visible).",
+      labels.size(), std::chrono::duration<double, std::milli>(middle - start).count(),
+      std::count(expected.begin(), expected.end(), true),
+      std::chrono::duration<double, std::milli>(end - middle).count() / frames,
+      std::count(visible.begin(), visible.end(), true));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::anchorlabels
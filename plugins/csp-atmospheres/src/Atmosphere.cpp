@@ -16,15 +16,17 @@
 #include <VistaKernel/VistaSystem.h>
 #include <VistaKernelOpenSGExt/VistaOpenSGMaterialTools.h>
 
+#include <utility>
+
 namespace csp::atmospheres {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 Atmosphere::Atmosphere(std::shared_ptr<Plugin::Settings> const& settings,
-    std::string const& sCenterName, std::string const& sFrameName, double tStartExistence,
-    double tEndExistence)
+    std::shared_ptr<cs::graphics::AsyncTextureLoader> textureLoader, std::string const& sCenterName,
+    std::string const& sFrameName, double tStartExistence, double tEndExistence)
     : cs::scene::CelestialObject(sCenterName, sFrameName, tStartExistence, tEndExistence)
-    , mRenderer(settings)
+    , mRenderer(settings, std::move(textureLoader))
     , mPluginSettings(settings) {
 
   auto radii(cs::core::SolarSystem::getRadii(sCenterName));
@@ -18,8 +18,10 @@ namespace csp::atmospheres {
 /// This is a wrapper around a AtmosphereRenderer, adding SPICE based positioning.
 class Atmosphere : public cs::scene::CelestialObject {
  public:
-  Atmosphere(std::shared_ptr<Plugin::Settings> const& pSettings, std::string const& sCenterName,
-      std::string const& sFrameName, double tStartExistence, double tEndExistence);
+  Atmosphere(std::shared_ptr<Plugin::Settings> const& pSettings,
+      std::shared_ptr<cs::graphics::AsyncTextureLoader> textureLoader,
+      std::string const& sCenterName, std::string const& sFrameName, double tStartExistence,
+      double tEndExistence);
   ~Atmosphere();
 
   /// Configures the internal renderer according to the given values.
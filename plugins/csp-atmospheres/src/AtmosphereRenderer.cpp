@@ -13,9 +13,10 @@
 #include "../../../src/cs-core/GraphicsEngine.hpp"
 #include "../../../src/cs-core/SolarSystem.hpp"
 #include "../../../src/cs-graphics/Shadows.hpp"
-#include "../../../src/cs-graphics/TextureLoader.hpp"
 #include "../../../src/cs-utils/FrameTimings.hpp"
+#include "../../../src/cs-utils/filesystem.hpp"
 #include "../../../src/cs-utils/utils.hpp"
+#include "logger.hpp"
 
 #include <VistaKernel/DisplayManager/VistaDisplayManager.h>
 #include <VistaKernel/DisplayManager/VistaViewport.h>
@@ -29,13 +30,16 @@
 #include <VistaOGLExt/VistaTexture.h>
 #include <VistaTools/tinyXML/tinyxml.h>
 
+#include <chrono>
 #include <glm/gtc/type_ptr.hpp>
 #include <utility>
 
 namespace csp::atmospheres {
 
-AtmosphereRenderer::AtmosphereRenderer(std::shared_ptr<Plugin::Settings> settings)
-    : mPluginSettings(std::move(settings)) {
+AtmosphereRenderer::AtmosphereRenderer(std::shared_ptr<Plugin::Settings> settings,
+    std::shared_ptr<cs::graphics::AsyncTextureLoader> textureLoader)
+    : mPluginSettings(std::move(settings))
+    , mTextureLoader(std::move(textureLoader)) {
 
   initData();
 
@@ -52,6 +56,9 @@ AtmosphereRenderer::AtmosphereRenderer(std::shared_ptr<Plugin::Settings> setting
   });
 
   mPluginSettings->mWaterLevel.connectAndTouch([this](float val) { setWaterLevel(val / 1000); });
+
+  mPluginSettings->mEnablePrecomputedScattering.connectAndTouch(
+      [this](bool val) { setUsePrecomputedScattering(val); });
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -81,7 +88,7 @@ void AtmosphereRenderer::setClouds(std::string const& textureFile, float height)
     mCloudTextureFile = textureFile;
     mCloudTexture.reset();
     if (!textureFile.empty()) {
-      mCloudTexture = cs::graphics::TextureLoader::loadFromFile(textureFile);
+      mCloudTexture = mTextureLoader->loadFromFile(textureFile);
     }
     mShaderDirty = true;
     mUseClouds   = mCloudTexture != nullptr;
@@ -311,6 +318,19 @@ void AtmosphereRenderer::setUseLinearDepthBuffer(bool bEnable) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+bool AtmosphereRenderer::getUsePrecomputedScattering() const {
+  return mUsePrecomputedScattering;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void AtmosphereRenderer::setUsePrecomputedScattering(bool bEnable) {
+  mUsePrecomputedScattering = bEnable;
+  mShaderDirty              = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void AtmosphereRenderer::updateShader() {
   mAtmoShader = VistaGLSLShader();
 
@@ -339,11 +359,37 @@ void AtmosphereRenderer::updateShader() {
   cs::utils::replaceString(sFrag, "DRAW_SUN", std::to_string(mDrawSun));
   cs::utils::replaceString(sFrag, "DRAW_WATER", std::to_string(mDrawWater));
   cs::utils::replaceString(sFrag, "USE_SHADOWMAP", std::to_string(mShadowMap != nullptr));
-  cs::utils::replaceString(sFrag, "USE_CLOUDMAP", std::to_string(mUseClouds && mCloudTexture));
+  cs::utils::replaceString(
+      sFrag, "USE_CLOUDMAP", std::to_string(mUseClouds && mCloudTextureReady));
   cs::utils::replaceString(sFrag, "ENABLE_HDR", std::to_string(mHDRBuffer != nullptr));
   cs::utils::replaceString(sFrag, "HDR_SAMPLES",
       mHDRBuffer == nullptr ? "0" : std::to_string(mHDRBuffer->getMultiSamples()));
 
+  // The table sizes are inserted as float literals.
+  auto toFloatString = [](int value) { return std::to_string(value) + ".0"; };
+
+  cs::utils::replaceString(
+      sFrag, "USE_PRECOMPUTED_SCATTERING", std::to_string(getHasScatteringTables()));
+  cs::utils::replaceString(sFrag, "TRANSMITTANCE_TEXTURE_WIDTH",
+      toFloatString(ScatteringTables::TRANSMITTANCE_WIDTH));
+  cs::utils::replaceString(sFrag, "TRANSMITTANCE_TEXTURE_HEIGHT",
+      toFloatString(ScatteringTables::TRANSMITTANCE_HEIGHT));
+  cs::utils::replaceString(sFrag, "SCATTERING_TEXTURE_R_SIZE",
+      toFloatString(ScatteringTables::SCATTERING_R_SIZE));
+  cs::utils::replaceString(sFrag, "SCATTERING_TEXTURE_MU_SIZE",
+      toFloatString(ScatteringTables::SCATTERING_MU_SIZE));
+  cs::utils::replaceString(sFrag, "SCATTERING_TEXTURE_MU_S_SIZE",
+      toFloatString(ScatteringTables::SCATTERING_MU_S_SIZE));
+  cs::utils::replaceString(sFrag, "SCATTERING_TEXTURE_NU_SIZE",
+      toFloatString(ScatteringTables::SCATTERING_NU_SIZE));
+  cs::utils::replaceString(sFrag, "IRRADIANCE_TEXTURE_WIDTH",
+      toFloatString(ScatteringTables::IRRADIANCE_WIDTH));
+  cs::utils::replaceString(sFrag, "IRRADIANCE_TEXTURE_HEIGHT",
+      toFloatString(ScatteringTables::IRRADIANCE_HEIGHT));
+  cs::utils::replaceString(
+      sFrag, "SUN_ANGULAR_RADIUS", cs::utils::toString(ScatteringTables::cSunAngularRadius));
+  cs::utils::replaceString(sFrag, "MU_S_MIN", cs::utils::toString(mUploadedMuSMin));
+
   mAtmoShader.InitVertexShaderFromString(sVert);
   mAtmoShader.InitFragmentShaderFromString(sFrag);
 
@@ -355,6 +401,16 @@ void AtmosphereRenderer::updateShader() {
 bool AtmosphereRenderer::Do() {
   cs::utils::FrameTimings::ScopedTimer timer("csp-atmospheres");
 
+  if (mUsePrecomputedScattering) {
+    updateScatteringTables();
+  }
+
+  bool cloudTextureReady = mCloudTexture && mCloudTexture->isReady();
+  if (mCloudTextureReady != cloudTextureReady) {
+    mCloudTextureReady = cloudTextureReady;
+    mShaderDirty       = true;
+  }
+
   if (mShaderDirty) {
     updateShader();
     mShaderDirty = false;
@@ -431,12 +487,25 @@ bool AtmosphereRenderer::Do() {
   mAtmoShader.SetUniform(mAtmoShader.GetUniformLocation("uDepthBuffer"), 0);
   mAtmoShader.SetUniform(mAtmoShader.GetUniformLocation("uColorBuffer"), 1);
 
-  if (mUseClouds && mCloudTexture) {
-    mCloudTexture->Bind(GL_TEXTURE3);
+  if (mUseClouds && mCloudTextureReady) {
+    mCloudTexture->get()->Bind(GL_TEXTURE3);
     mAtmoShader.SetUniform(mAtmoShader.GetUniformLocation("uCloudTexture"), 3);
     mAtmoShader.SetUniform(mAtmoShader.GetUniformLocation("uCloudAltitude"), mCloudHeight);
   }
 
+  bool useScatteringTables = getHasScatteringTables();
+
+  if (useScatteringTables) {
+    mTransmittanceTexture->Bind(GL_TEXTURE9);
+    mRayleighScatteringTexture->Bind(GL_TEXTURE10);
+    mMieScatteringTexture->Bind(GL_TEXTURE11);
+    mIrradianceTexture->Bind(GL_TEXTURE12);
+    mAtmoShader.SetUniform(mAtmoShader.GetUniformLocation("uTransmittanceTexture"), 9);
+    mAtmoShader.SetUniform(mAtmoShader.GetUniformLocation("uRayleighScatteringTexture"), 10);
+    mAtmoShader.SetUniform(mAtmoShader.GetUniformLocation("uMieScatteringTexture"), 11);
+    mAtmoShader.SetUniform(mAtmoShader.GetUniformLocation("uIrradianceTexture"), 12);
+  }
+
   if (mShadowMap) {
     int texUnitShadow = 4;
     mAtmoShader.SetUniform(mAtmoShader.GetUniformLocation("uShadowCascades"),
@@ -483,8 +552,15 @@ bool AtmosphereRenderer::Do() {
     data.mColorBuffer->Unbind(GL_TEXTURE1);
   }
 
-  if (mUseClouds && mCloudTexture) {
-    mCloudTexture->Unbind(GL_TEXTURE3);
+  if (mUseClouds && mCloudTextureReady) {
+    mCloudTexture->get()->Unbind(GL_TEXTURE3);
+  }
+
+  if (useScatteringTables) {
+    mTransmittanceTexture->Unbind(GL_TEXTURE9);
+    mRayleighScatteringTexture->Unbind(GL_TEXTURE10);
+    mMieScatteringTexture->Unbind(GL_TEXTURE11);
+    mIrradianceTexture->Unbind(GL_TEXTURE12);
   }
 
   mAtmoShader.Release();
@@ -537,6 +613,123 @@ bool AtmosphereRenderer::GetBoundingBox(VistaBoundingBox& bb) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void AtmosphereRenderer::updateScatteringTables() {
+
+  // There is at most one generation in flight. Once it is finished, its tables are uploaded even
+  // if the parameters have changed in the meantime; the shader will only use them if they match.
+  if (mPendingTables.valid()) {
+    if (mPendingTables.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+      return;
+    }
+
+    // If the generation failed, the atmosphere is ray-marched instead. The same parameters are
+    // not tried again, as this would most likely fail once more.
+    try {
+      auto tables = mPendingTables.get();
+      uploadScatteringTables(*tables);
+      mShaderDirty = true;
+    } catch (std::exception const& e) {
+      logger().warn("Failed to generate scattering tables: {}", e.what());
+      mFailedParameters = mPendingParameters;
+    }
+  }
+
+  if (getHasScatteringTables()) {
+    return;
+  }
+
+  auto parameters = getScatteringParameters();
+
+  if (mFailedParameters == parameters) {
+    return;
+  }
+
+  // Start a new generation. Until it has finished, the atmosphere is ray-marched. Tables which
+  // have been generated before for the same parameters are loaded from the cache directory.
+  mPendingParameters = parameters;
+  mPendingTables     = mTableGenerator.enqueue(
+      [parameters, cacheDirectory = mPluginSettings->mScatteringCache.get()]() {
+        std::string fileName =
+            cacheDirectory + "/" + ScatteringTables::getCacheFileName(parameters);
+        auto tables = ScatteringTables::load(fileName, parameters);
+
+        if (!tables) {
+          logger().info("Generating scattering tables '{}'...", fileName);
+
+          tables = ScatteringTables::generate(parameters);
+
+          cs::utils::filesystem::createDirectoryRecursively(cacheDirectory);
+          tables->save(fileName);
+        }
+
+        return tables;
+      });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void AtmosphereRenderer::uploadScatteringTables(ScatteringTables const& tables) {
+  auto createTexture = [](GLenum target) {
+    auto texture = std::make_unique<VistaTexture>(target);
+    texture->Bind();
+    glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    return texture;
+  };
+
+  mTransmittanceTexture = createTexture(GL_TEXTURE_2D);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, ScatteringTables::TRANSMITTANCE_WIDTH,
+      ScatteringTables::TRANSMITTANCE_HEIGHT, 0, GL_RG, GL_FLOAT,
+      tables.getTransmittance().data());
+  mTransmittanceTexture->Unbind();
+
+  mRayleighScatteringTexture = createTexture(GL_TEXTURE_3D);
+  glTexImage3D(GL_TEXTURE_3D, 0, GL_RGB32F, ScatteringTables::SCATTERING_WIDTH,
+      ScatteringTables::SCATTERING_HEIGHT, ScatteringTables::SCATTERING_DEPTH, 0, GL_RGB, GL_FLOAT,
+      tables.getRayleighScattering().data());
+  mRayleighScatteringTexture->Unbind();
+
+  mMieScatteringTexture = createTexture(GL_TEXTURE_3D);
+  glTexImage3D(GL_TEXTURE_3D, 0, GL_RGB32F, ScatteringTables::SCATTERING_WIDTH,
+      ScatteringTables::SCATTERING_HEIGHT, ScatteringTables::SCATTERING_DEPTH, 0, GL_RGB, GL_FLOAT,
+      tables.getMieScattering().data());
+  mMieScatteringTexture->Unbind();
+
+  mIrradianceTexture = createTexture(GL_TEXTURE_2D);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB32F, ScatteringTables::IRRADIANCE_WIDTH,
+      ScatteringTables::IRRADIANCE_HEIGHT, 0, GL_RGB, GL_FLOAT, tables.getIrradiance().data());
+  mIrradianceTexture->Unbind();
+
+  mUploadedParameters = tables.getParameters();
+  mUploadedMuSMin     = tables.getMuSMin();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ScatteringTables::Parameters AtmosphereRenderer::getScatteringParameters() const {
+  ScatteringTables::Parameters parameters;
+  parameters.mAtmosphereHeight   = mAtmosphereHeight;
+  parameters.mRayleighHeight     = mRayleighHeight;
+  parameters.mRayleighScattering = mRayleighScattering;
+  parameters.mRayleighAnisotropy = mRayleighAnisotropy;
+  parameters.mMieHeight          = mMieHeight;
+  parameters.mMieScattering      = mMieScattering;
+  parameters.mMieAnisotropy      = mMieAnisotropy;
+  return parameters;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool AtmosphereRenderer::getHasScatteringTables() const {
+  return mUsePrecomputedScattering && mTransmittanceTexture &&
+         mUploadedParameters == getScatteringParameters();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void AtmosphereRenderer::initData() {
   // create quad -------------------------------------------------------------
   std::array<float, 8> const data{-1, 1, 1, 1, -1, -1, 1, -1};
@@ -7,8 +7,11 @@
 #ifndef CSP_ATMOSPHERE_RENDERER_HPP
 #define CSP_ATMOSPHERE_RENDERER_HPP
 
+#include "../../../src/cs-graphics/AsyncTextureLoader.hpp"
 #include "../../../src/cs-scene/CelestialObject.hpp"
+#include "../../../src/cs-utils/ThreadPool.hpp"
 #include "Plugin.hpp"
+#include "ScatteringTables.hpp"
 
 #include <VistaBase/VistaVectorMath.h>
 #include <VistaKernel/DisplayManager/VistaViewport.h>
@@ -18,8 +21,10 @@
 #include <VistaOGLExt/VistaTexture.h>
 #include <VistaOGLExt/VistaVertexArrayObject.h>
 
+#include <future>
 #include <glm/glm.hpp>
 #include <memory>
+#include <optional>
 #include <unordered_map>
 
 namespace cs::graphics {
@@ -33,7 +38,10 @@ namespace csp::atmospheres {
 /// very same position as your planet. Set its scale to the same size as your planet.
 class AtmosphereRenderer : public IVistaOpenGLDraw {
  public:
-  AtmosphereRenderer(std::shared_ptr<Plugin::Settings> settings);
+  /// The cloud texture is loaded in the background with the given loader. The clouds are not drawn
+  /// until it has been uploaded.
+  AtmosphereRenderer(std::shared_ptr<Plugin::Settings>  settings,
+      std::shared_ptr<cs::graphics::AsyncTextureLoader> textureLoader);
 
   /// Updates the current sun position and brightness.
   void setSun(glm::vec3 const& direction, float illuminance);
@@ -129,20 +137,40 @@ class AtmosphereRenderer : public IVistaOpenGLDraw {
   bool getUseLinearDepthBuffer() const;
   void setUseLinearDepthBuffer(bool bEnable);
 
+  /// If true, the scattering is looked up in precomputed ScatteringTables instead of being
+  /// ray-marched for each pixel. The tables are generated on a background thread whenever the
+  /// parameters of the atmosphere change; until they are available, ray-marching is used. Light
+  /// shafts are not drawn in this mode.
+  bool getUsePrecomputedScattering() const;
+  void setUsePrecomputedScattering(bool bEnable);
+
   bool Do() override;
   bool GetBoundingBox(VistaBoundingBox& bb) override;
 
  private:
   void initData();
   void updateShader();
+  void updateScatteringTables();
+  void uploadScatteringTables(ScatteringTables const& tables);
+
+  ScatteringTables::Parameters getScatteringParameters() const;
+
+  /// Returns true if the uploaded ScatteringTables match the current parameters.
+  bool getHasScatteringTables() const;
+
+  std::shared_ptr<Plugin::Settings>                                mPluginSettings;
+  std::shared_ptr<cs::graphics::AsyncTextureLoader>                mTextureLoader;
+  std::shared_ptr<cs::graphics::AsyncTextureLoader::Texture const> mCloudTexture;
+  std::string                                                      mCloudTextureFile;
 
-  std::shared_ptr<Plugin::Settings> mPluginSettings;
-  std::unique_ptr<VistaTexture>     mCloudTexture;
-  std::string                       mCloudTextureFile;
-  float                             mCloudHeight    = 0.001F;
-  bool                              mUseClouds      = false;
-  glm::dvec3                        mRadii          = glm::dvec3(1.0, 1.0, 1.0);
-  glm::dmat4                        mWorldTransform = glm::dmat4(1.0);
+  float      mCloudHeight    = 0.001F;
+  bool       mUseClouds      = false;
+  glm::dvec3 mRadii          = glm::dvec3(1.0, 1.0, 1.0);
+  glm::dmat4 mWorldTransform = glm::dmat4(1.0);
+
+  // The shader only samples the cloud texture once it has been uploaded. It is recompiled when
+  // this changes.
+  bool mCloudTextureReady = false;
 
   std::shared_ptr<cs::graphics::ShadowMap> mShadowMap;
   std::shared_ptr<cs::graphics::HDRBuffer> mHDRBuffer;
@@ -184,6 +212,20 @@ class AtmosphereRenderer : public IVistaOpenGLDraw {
   float mExposure             = 0.6F;
   float mGamma                = 2.2F;
 
+  bool                          mUsePrecomputedScattering = false;
+  std::unique_ptr<VistaTexture> mTransmittanceTexture;
+  std::unique_ptr<VistaTexture> mRayleighScatteringTexture;
+  std::unique_ptr<VistaTexture> mMieScatteringTexture;
+  std::unique_ptr<VistaTexture> mIrradianceTexture;
+
+  ScatteringTables::Parameters mUploadedParameters;
+  float                        mUploadedMuSMin = -0.2F;
+
+  std::future<std::unique_ptr<ScatteringTables>> mPendingTables;
+  ScatteringTables::Parameters                   mPendingParameters;
+  std::optional<ScatteringTables::Parameters>    mFailedParameters;
+  cs::utils::ThreadPool                          mTableGenerator{1};
+
   static const char* cAtmosphereVert;
   static const char* cAtmosphereFrag0;
   static const char* cAtmosphereFrag1;
@@ -78,6 +78,9 @@ void from_json(nlohmann::json const& j, Plugin::Settings& o) {
   cs::core::Settings::deserialize(j, "enableClouds", o.mEnableClouds);
   cs::core::Settings::deserialize(j, "enableLightShafts", o.mEnableLightShafts);
   cs::core::Settings::deserialize(j, "enableWater", o.mEnableWater);
+  cs::core::Settings::deserialize(
+      j, "enablePrecomputedScattering", o.mEnablePrecomputedScattering);
+  cs::core::Settings::deserialize(j, "scatteringCache", o.mScatteringCache);
 }
 
 void to_json(nlohmann::json& j, Plugin::Settings const& o) {
@@ -88,6 +91,8 @@ void to_json(nlohmann::json& j, Plugin::Settings const& o) {
   cs::core::Settings::serialize(j, "enableClouds", o.mEnableClouds);
   cs::core::Settings::serialize(j, "enableLightShafts", o.mEnableLightShafts);
   cs::core::Settings::serialize(j, "enableWater", o.mEnableWater);
+  cs::core::Settings::serialize(j, "enablePrecomputedScattering", o.mEnablePrecomputedScattering);
+  cs::core::Settings::serialize(j, "scatteringCache", o.mScatteringCache);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -130,6 +135,14 @@ void Plugin::init() {
     mGuiManager->setCheckboxValue("atmosphere.setEnableLightShafts", enable);
   });
 
+  mGuiManager->getGui()->registerCallback("atmosphere.setEnablePrecomputedScattering",
+      "Enables or disables the use of precomputed scattering tables instead of ray-marching.",
+      std::function(
+          [this](bool enable) { mPluginSettings->mEnablePrecomputedScattering = enable; }));
+  mPluginSettings->mEnablePrecomputedScattering.connectAndTouch([this](bool enable) {
+    mGuiManager->setCheckboxValue("atmosphere.setEnablePrecomputedScattering", enable);
+  });
+
   mGuiManager->getGui()->registerCallback("atmosphere.setQuality",
       "Higher values create a more realistic atmosphere.",
       std::function([this](double value) { mPluginSettings->mQuality = static_cast<int>(value); }));
@@ -207,6 +220,7 @@ void Plugin::deInit() {
   mGuiManager->getGui()->unregisterCallback("atmosphere.setEnableClouds");
   mGuiManager->getGui()->unregisterCallback("atmosphere.setEnable");
   mGuiManager->getGui()->unregisterCallback("atmosphere.setEnableLightShafts");
+  mGuiManager->getGui()->unregisterCallback("atmosphere.setEnablePrecomputedScattering");
   mGuiManager->getGui()->unregisterCallback("atmosphere.setQuality");
   mGuiManager->getGui()->unregisterCallback("atmosphere.setWaterLevel");
 
@@ -289,8 +303,9 @@ void Plugin::onLoad() {
 
     auto [tStartExistence, tEndExistence] = anchor->second.getExistence();
 
-    auto atmosphere = std::make_shared<Atmosphere>(mPluginSettings, anchor->second.mCenter,
-        anchor->second.mFrame, tStartExistence, tEndExistence);
+    auto atmosphere = std::make_shared<Atmosphere>(mPluginSettings,
+        mGraphicsEngine->getTextureLoader(), anchor->second.mCenter, anchor->second.mFrame,
+        tStartExistence, tEndExistence);
 
     atmosphere->getRenderer().setHDRBuffer(mGraphicsEngine->getHDRBuffer());
     atmosphere->configure(settings.second);
@@ -47,6 +47,11 @@ class Plugin : public cs::core::PluginBase {
     cs::utils::DefaultProperty<bool>  mEnableClouds{true};
     cs::utils::DefaultProperty<bool>  mEnableLightShafts{false};
     cs::utils::DefaultProperty<bool>  mEnableWater{false};
+
+    /// If enabled, precomputed scattering tables are used instead of ray-marching. The tables are
+    /// cached in the given directory.
+    cs::utils::DefaultProperty<bool>        mEnablePrecomputedScattering{false};
+    cs::utils::DefaultProperty<std::string> mScatteringCache{"atmosphere-cache"};
   };
 
   void init() override;
@@ -0,0 +1,917 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ScatteringTables.hpp"
+
+#include "../../../src/cs-utils/ThreadPool.hpp"
+#include "../../../src/cs-utils/utils.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <array>
+#include <boost/filesystem.hpp>
+#include <cmath>
+#include <fstream>
+#include <spdlog/fmt/fmt.h>
+#include <stdexcept>
+
+namespace csp::atmospheres {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const uint32_t ScatteringTables::cVersion          = 1;
+const float    ScatteringTables::cSunAngularRadius = 0.004675F;
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const uint32_t MAGIC = 0x53435354; // "SCST"
+
+// The number of samples which are used for the integrals along rays.
+const int TRANSMITTANCE_SAMPLES = 500;
+const int SCATTERING_SAMPLES    = 50;
+
+// The number of polar angles which are used for integrals over the sphere of directions. Twice as
+// many azimuth angles are used.
+const int SPHERE_SAMPLES = 16;
+
+const float PI = glm::pi<float>();
+
+struct Header {
+  uint32_t                     mMagic;
+  uint32_t                     mVersion;
+  ScatteringTables::Parameters mParameters;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+float clampCosine(float mu) {
+  return std::clamp(mu, -1.F, 1.F);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+float safeSqrt(float a) {
+  return std::sqrt(std::max(a, 0.F));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+float smoothstep(float edge0, float edge1, float x) {
+  float t = std::clamp((x - edge0) / (edge1 - edge0), 0.F, 1.F);
+  return t * t * (3.F - 2.F * t);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Maps [0..1] to texture coordinates, so that the texel centers at the border of the texture
+// correspond to zero and one.
+float getTextureCoord(float x, int size) {
+  return 0.5F / static_cast<float>(size) + x * (1.F - 1.F / static_cast<float>(size));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+float getUnitRange(float u, int size) {
+  return (u - 0.5F / static_cast<float>(size)) / (1.F - 1.F / static_cast<float>(size));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Samples a table like a texture with linear filtering and GL_CLAMP_TO_EDGE. For 2D tables, the
+// depth is one.
+template <int C>
+std::array<float, C> sample(std::vector<float> const& table, int width, int height, int depth,
+    float u, float v, float w) {
+  std::array<int, 2>   x{};
+  std::array<int, 2>   y{};
+  std::array<int, 2>   z{};
+  std::array<float, 3> f{};
+
+  auto getTexels = [](float coord, int size, std::array<int, 2>& texels, float& fraction) {
+    float texel = coord * static_cast<float>(size) - 0.5F;
+    float base  = std::floor(texel);
+    fraction    = texel - base;
+    texels[0]   = std::clamp(static_cast<int>(base), 0, size - 1);
+    texels[1]   = std::clamp(static_cast<int>(base) + 1, 0, size - 1);
+  };
+
+  getTexels(u, width, x, f[0]);
+  getTexels(v, height, y, f[1]);
+  getTexels(w, depth, z, f[2]);
+
+  std::array<float, C> result{};
+
+  for (int k = 0; k < 2; ++k) {
+    for (int j = 0; j < 2; ++j) {
+      for (int i = 0; i < 2; ++i) {
+        float weight = (i == 0 ? 1.F - f[0] : f[0]) * (j == 0 ? 1.F - f[1] : f[1]) *
+                       (k == 0 ? 1.F - f[2] : f[2]);
+
+        std::size_t index =
+            ((static_cast<std::size_t>(z.at(k)) * height + y.at(j)) * width + x.at(i)) * C;
+
+        for (int c = 0; c < C; ++c) {
+          result.at(c) += weight * table[index + c];
+        }
+      }
+    }
+  }
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Returns the distance of the i-th of SCATTERING_SAMPLES + 1 samples along a ray of the given
+// length. The Mie layer is much thinner than the distance between evenly spaced samples, therefore
+// the samples are placed more densely close to the ground: at the start of rays which leave the
+// atmosphere and at the end of rays which hit the ground.
+float getSampleDistance(int i, float length, bool rayIntersectsGround) {
+  float x = static_cast<float>(i) / static_cast<float>(SCATTERING_SAMPLES);
+  return length * (rayIntersectsGround ? 1.F - (1.F - x) * (1.F - x) : x * x);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Returns the weight of the i-th sample for the trapezoidal rule with the sample distances above.
+float getSampleWeight(int i, float length, bool rayIntersectsGround) {
+  float previous = getSampleDistance(std::max(i - 1, 0), length, rayIntersectsGround);
+  float next =
+      getSampleDistance(std::min(i + 1, SCATTERING_SAMPLES), length, rayIntersectsGround);
+  return 0.5F * (next - previous);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void store(std::vector<float>& table, std::size_t texel, glm::vec3 const& value) {
+  table[texel * 3 + 0] = value.x;
+  table[texel * 3 + 1] = value.y;
+  table[texel * 3 + 2] = value.z;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool ScatteringTables::Parameters::operator==(Parameters const& other) const {
+  return mAtmosphereHeight == other.mAtmosphereHeight && mRayleighHeight == other.mRayleighHeight &&
+         mRayleighScattering == other.mRayleighScattering &&
+         mRayleighAnisotropy == other.mRayleighAnisotropy && mMieHeight == other.mMieHeight &&
+         mMieScattering == other.mMieScattering && mMieAnisotropy == other.mMieAnisotropy &&
+         mScatteringOrders == other.mScatteringOrders;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool ScatteringTables::Parameters::operator!=(Parameters const& other) const {
+  return !(*this == other);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::unique_ptr<ScatteringTables> ScatteringTables::generate(Parameters const& parameters) {
+  // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+  std::unique_ptr<ScatteringTables> tables(new ScatteringTables(parameters));
+
+  tables->computeTransmittance();
+  tables->computeSingleScattering();
+
+  // The light of each scattering order is the source of the next one. It is added to the Rayleigh
+  // table, divided by the Rayleigh phase function which is applied again on lookup.
+  std::vector<float> deltaScattering;
+
+  for (int order = 2; order <= parameters.mScatteringOrders; ++order) {
+    tables->computeMultipleScattering(order, deltaScattering);
+
+    for (std::size_t i = 0; i < deltaScattering.size() / 3; ++i) {
+      int   x  = static_cast<int>(i % SCATTERING_WIDTH);
+      int   y  = static_cast<int>(i / SCATTERING_WIDTH % SCATTERING_HEIGHT);
+      int   z  = static_cast<int>(i / SCATTERING_WIDTH / SCATTERING_HEIGHT);
+      float r  = 0.F;
+      float mu = 0.F;
+      float muS{};
+      float nu{};
+      bool  rayIntersectsGround{};
+      tables->getScatteringTexel(x, y, z, r, mu, muS, nu, rayIntersectsGround);
+
+      float phase = getPhase(nu, parameters.mRayleighAnisotropy);
+      for (std::size_t c = 0; c < 3; ++c) {
+        tables->mRayleighScattering[i * 3 + c] += deltaScattering[i * 3 + c] / phase;
+      }
+    }
+  }
+
+  tables->computeIrradiance();
+
+  return tables;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::unique_ptr<ScatteringTables> ScatteringTables::load(
+    std::string const& fileName, Parameters const& parameters) {
+  std::ifstream file(fileName, std::ios::in | std::ios::binary);
+
+  if (!file.is_open()) {
+    return nullptr;
+  }
+
+  Header header{};
+  file.read(reinterpret_cast<char*>(&header), sizeof(Header)); // NOLINT
+
+  if (!file.good() || header.mMagic != MAGIC || header.mVersion != cVersion) {
+    logger().info("Ignoring scattering tables '{}': The file is corrupt or outdated.", fileName);
+    return nullptr;
+  }
+
+  if (header.mParameters != parameters) {
+    logger().info(
+        "Ignoring scattering tables '{}': They have been created for another atmosphere.",
+        fileName);
+    return nullptr;
+  }
+
+  // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+  std::unique_ptr<ScatteringTables> tables(new ScatteringTables(parameters));
+
+  for (auto* table : {&tables->mTransmittance, &tables->mRayleighScattering,
+           &tables->mMieScattering, &tables->mIrradiance}) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    file.read(reinterpret_cast<char*>(table->data()),
+        static_cast<std::streamsize>(table->size() * sizeof(float)));
+  }
+
+  if (!file.good()) {
+    logger().info("Ignoring scattering tables '{}': The file is incomplete.", fileName);
+    return nullptr;
+  }
+
+  return tables;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string ScatteringTables::getCacheFileName(Parameters const& parameters) {
+
+  // Hash of all parameters and the version.
+  cs::utils::Fnv1aHash hash;
+  hash.add(cVersion);
+  hash.add(parameters.mAtmosphereHeight);
+  hash.add(parameters.mRayleighHeight);
+  hash.add(parameters.mRayleighScattering.x);
+  hash.add(parameters.mRayleighScattering.y);
+  hash.add(parameters.mRayleighScattering.z);
+  hash.add(parameters.mRayleighAnisotropy);
+  hash.add(parameters.mMieHeight);
+  hash.add(parameters.mMieScattering.x);
+  hash.add(parameters.mMieScattering.y);
+  hash.add(parameters.mMieScattering.z);
+  hash.add(parameters.mMieAnisotropy);
+  hash.add(parameters.mScatteringOrders);
+
+  return fmt::format("scattering-{:016x}.bin", hash.get());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ScatteringTables::ScatteringTables(Parameters const& parameters)
+    : mParameters(parameters)
+    , mBottomRadius(1.F - parameters.mAtmosphereHeight)
+    , mHorizonDistance(safeSqrt(1.F - mBottomRadius * mBottomRadius))
+    // Below this sun angle, not even the top of the atmosphere is lit. For thin atmospheres, some
+    // more twilight is included.
+    , mMuSMin(std::min(-0.2F, -mHorizonDistance))
+    , mTransmittance(static_cast<std::size_t>(TRANSMITTANCE_WIDTH * TRANSMITTANCE_HEIGHT * 2))
+    , mRayleighScattering(
+          static_cast<std::size_t>(SCATTERING_WIDTH * SCATTERING_HEIGHT * SCATTERING_DEPTH * 3))
+    , mMieScattering(mRayleighScattering.size())
+    , mIrradiance(static_cast<std::size_t>(IRRADIANCE_WIDTH * IRRADIANCE_HEIGHT * 3)) {
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool ScatteringTables::save(std::string const& fileName) const {
+  // The file is written under a unique temporary name first and then renamed, so that other
+  // instances which share the cache directory never load an incomplete file.
+  std::string tmpFile =
+      fileName + "." + boost::filesystem::unique_path("%%%%%%%%%%%%%%%%").string() + ".tmp";
+
+  try {
+    std::ofstream file(tmpFile, std::ios::out | std::ios::binary);
+
+    if (!file.is_open()) {
+      throw std::runtime_error("Cannot open file for writing.");
+    }
+
+    Header header{MAGIC, cVersion, mParameters};
+    file.write(reinterpret_cast<char const*>(&header), sizeof(Header)); // NOLINT
+
+    for (auto const* table :
+        {&mTransmittance, &mRayleighScattering, &mMieScattering, &mIrradiance}) {
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+      file.write(reinterpret_cast<char const*>(table->data()),
+          static_cast<std::streamsize>(table->size() * sizeof(float)));
+    }
+
+    file.close();
+
+    if (!file.good()) {
+      throw std::runtime_error("Cannot write to file.");
+    }
+
+    boost::filesystem::rename(tmpFile, fileName);
+  } catch (std::exception const& e) {
+    logger().error("Failed to write scattering tables '{}': {}", fileName, e.what());
+
+    boost::system::error_code error;
+    boost::filesystem::remove(tmpFile, error);
+
+    return false;
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ScatteringTables::Parameters const& ScatteringTables::getParameters() const {
+  return mParameters;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+float ScatteringTables::getBottomRadius() const {
+  return mBottomRadius;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+float ScatteringTables::getMuSMin() const {
+  return mMuSMin;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<float> const& ScatteringTables::getTransmittance() const {
+  return mTransmittance;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<float> const& ScatteringTables::getRayleighScattering() const {
+  return mRayleighScattering;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<float> const& ScatteringTables::getMieScattering() const {
+  return mMieScattering;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<float> const& ScatteringTables::getIrradiance() const {
+  return mIrradiance;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::vec2 ScatteringTables::getOpticalDepthToTop(float r, float mu) const {
+  glm::vec2 uv = getTransmittanceUV(r, mu);
+  auto      depth =
+      sample<2>(mTransmittance, TRANSMITTANCE_WIDTH, TRANSMITTANCE_HEIGHT, 1, uv.x, uv.y, 0.5F);
+  return glm::vec2(depth[0], depth[1]);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::vec3 ScatteringTables::getTransmittance(
+    float r, float mu, float d, bool rayIntersectsGround) const {
+  float rD  = std::clamp(std::sqrt(d * d + 2.F * r * mu * d + r * r), mBottomRadius, 1.F);
+  float muD = clampCosine((r * mu + d) / rD);
+
+  // Rays towards the ground are reversed, as the table only contains rays which do not hit the
+  // ground.
+  glm::vec2 depth = rayIntersectsGround
+                        ? getOpticalDepthToTop(rD, -muD) - getOpticalDepthToTop(r, -mu)
+                        : getOpticalDepthToTop(r, mu) - getOpticalDepthToTop(rD, muD);
+
+  return getExtinction(glm::max(depth, glm::vec2(0.F)));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::vec3 ScatteringTables::getTransmittanceToSun(float r, float muS) const {
+  float sinThetaH = mBottomRadius / r;
+  float cosThetaH = -safeSqrt(1.F - sinThetaH * sinThetaH);
+
+  return getExtinction(getOpticalDepthToTop(r, muS)) *
+         smoothstep(-sinThetaH * cSunAngularRadius, sinThetaH * cSunAngularRadius, muS - cosThetaH);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ScatteringTables::getScattering(float r, float mu, float muS, float nu,
+    bool rayIntersectsGround, glm::vec3& rayleigh, glm::vec3& mie) const {
+  rayleigh = lookupScattering(mRayleighScattering, r, mu, muS, nu, rayIntersectsGround);
+  mie      = lookupScattering(mMieScattering, r, mu, muS, nu, rayIntersectsGround);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::vec3 ScatteringTables::getSkyIrradiance(float r, float muS) const {
+  float xR   = (r - mBottomRadius) / (1.F - mBottomRadius);
+  float xMuS = muS * 0.5F + 0.5F;
+
+  auto irradiance = sample<3>(mIrradiance, IRRADIANCE_WIDTH, IRRADIANCE_HEIGHT, 1,
+      getTextureCoord(xMuS, IRRADIANCE_WIDTH), getTextureCoord(xR, IRRADIANCE_HEIGHT), 0.5F);
+
+  return glm::vec3(irradiance[0], irradiance[1], irradiance[2]);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::vec3 ScatteringTables::getInscatter(glm::vec3 const& rayOrigin, glm::vec3 const& rayDir,
+    float tStart, float tEnd, bool hitsSurface, glm::vec3 const& sunDir) const {
+  glm::vec3 start = rayOrigin + rayDir * tStart;
+
+  float r   = std::clamp(glm::length(start), mBottomRadius, 1.F);
+  float mu  = clampCosine(glm::dot(start, rayDir) / r);
+  float muS = clampCosine(glm::dot(start, sunDir) / r);
+  float nu  = clampCosine(glm::dot(rayDir, sunDir));
+  float d   = tEnd - tStart;
+
+  bool rayIntersectsGround = this->rayIntersectsGround(r, mu);
+
+  glm::vec3 rayleigh;
+  glm::vec3 mie;
+  getScattering(r, mu, muS, nu, rayIntersectsGround, rayleigh, mie);
+
+  // If the ray ends at an object, the light scattered behind the object is subtracted.
+  if (hitsSurface) {
+    float rD   = std::clamp(std::sqrt(d * d + 2.F * r * mu * d + r * r), mBottomRadius, 1.F);
+    float muD  = clampCosine((r * mu + d) / rD);
+    float muSD = clampCosine((r * muS + d * nu) / rD);
+
+    glm::vec3 rayleighD;
+    glm::vec3 mieD;
+    getScattering(rD, muD, muSD, nu, rayIntersectsGround, rayleighD, mieD);
+
+    glm::vec3 transmittance = getTransmittance(r, mu, d, rayIntersectsGround);
+    rayleigh                = glm::max(rayleigh - transmittance * rayleighD, glm::vec3(0.F));
+    mie                     = glm::max(mie - transmittance * mieD, glm::vec3(0.F));
+  }
+
+  return rayleigh * getPhase(nu, mParameters.mRayleighAnisotropy) +
+         mie * getPhase(nu, mParameters.mMieAnisotropy);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool ScatteringTables::rayIntersectsGround(float r, float mu) const {
+  return mu < 0.F && r * r * (mu * mu - 1.F) + mBottomRadius * mBottomRadius >= 0.F;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+float ScatteringTables::getPhase(float cosine, float anisotropy) {
+  float anisotropy2 = anisotropy * anisotropy;
+  float cosine2     = cosine * cosine;
+
+  float a = (1.F - anisotropy2) * (1.F + cosine2);
+  float b = 1.F + anisotropy2 - 2.F * anisotropy * cosine;
+
+  b *= std::sqrt(b);
+  b *= 2.F + anisotropy2;
+
+  return 3.F / (8.F * PI) * a / b;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+float ScatteringTables::distanceToTop(float r, float mu) const {
+  return std::max(0.F, -r * mu + safeSqrt(r * r * (mu * mu - 1.F) + 1.F));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+float ScatteringTables::distanceToBottom(float r, float mu) const {
+  return std::max(
+      0.F, -r * mu - safeSqrt(r * r * (mu * mu - 1.F) + mBottomRadius * mBottomRadius));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+float ScatteringTables::distanceToNearestBoundary(
+    float r, float mu, bool rayIntersectsGround) const {
+  return rayIntersectsGround ? distanceToBottom(r, mu) : distanceToTop(r, mu);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::vec2 ScatteringTables::getDensity(float r) const {
+  float height = std::max(0.F, r - mBottomRadius);
+  return glm::vec2(std::exp(-height / mParameters.mRayleighHeight),
+      std::exp(-height / mParameters.mMieHeight));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::vec3 ScatteringTables::getExtinction(glm::vec2 const& opticalDepth) const {
+  return glm::exp(-mParameters.mRayleighScattering * opticalDepth.x -
+                  mParameters.mMieScattering * opticalDepth.y);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::vec2 ScatteringTables::getTransmittanceUV(float r, float mu) const {
+  float rho  = safeSqrt(r * r - mBottomRadius * mBottomRadius);
+  float d    = distanceToTop(r, mu);
+  float dMin = 1.F - r;
+  float dMax = rho + mHorizonDistance;
+  float xMu  = (d - dMin) / (dMax - dMin);
+  float xR   = rho / mHorizonDistance;
+
+  return glm::vec2(
+      getTextureCoord(xMu, TRANSMITTANCE_WIDTH), getTextureCoord(xR, TRANSMITTANCE_HEIGHT));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::vec4 ScatteringTables::getScatteringUVWZ(
+    float r, float mu, float muS, float nu, bool rayIntersectsGround) const {
+  float rho = safeSqrt(r * r - mBottomRadius * mBottomRadius);
+  float uR  = getTextureCoord(rho / mHorizonDistance, SCATTERING_R_SIZE);
+
+  // The view angle is mapped separately for rays which hit the ground (lower half) and rays which
+  // do not (upper half), so that there is no interpolation across the horizon.
+  float rMu            = r * mu;
+  float discriminant   = rMu * rMu - r * r + mBottomRadius * mBottomRadius;
+  float uMu            = 0.F;
+  int   halfMuSize     = SCATTERING_MU_SIZE / 2;
+
+  if (rayIntersectsGround) {
+    float d    = -rMu - safeSqrt(discriminant);
+    float dMin = r - mBottomRadius;
+    float dMax = rho;
+    uMu        = 0.5F - 0.5F * getTextureCoord(dMax == dMin ? 0.F : (d - dMin) / (dMax - dMin),
+                                 halfMuSize);
+  } else {
+    float d    = -rMu + safeSqrt(discriminant + mHorizonDistance * mHorizonDistance);
+    float dMin = 1.F - r;
+    float dMax = rho + mHorizonDistance;
+    uMu        = 0.5F + 0.5F * getTextureCoord((d - dMin) / (dMax - dMin), halfMuSize);
+  }
+
+  float d    = distanceToTop(mBottomRadius, muS);
+  float dMin = 1.F - mBottomRadius;
+  float dMax = mHorizonDistance;
+  float a    = (d - dMin) / (dMax - dMin);
+  float A    = (distanceToTop(mBottomRadius, mMuSMin) - dMin) / (dMax - dMin);
+  float uMuS = getTextureCoord(std::max(1.F - a / A, 0.F) / (1.F + a), SCATTERING_MU_S_SIZE);
+
+  float uNu = (nu + 1.F) / 2.F;
+
+  return glm::vec4(uNu, uMuS, uMu, uR);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::vec3 ScatteringTables::lookupScattering(std::vector<float> const& table, float r, float mu,
+    float muS, float nu, bool rayIntersectsGround) const {
+  glm::vec4 uvwz = getScatteringUVWZ(r, mu, muS, nu, rayIntersectsGround);
+
+  // The sun angle and the view-sun angle share the x-axis; the latter is interpolated manually.
+  float texCoordX = uvwz.x * static_cast<float>(SCATTERING_NU_SIZE - 1);
+  float texX      = std::floor(texCoordX);
+  float lerp      = texCoordX - texX;
+
+  auto a = sample<3>(table, SCATTERING_WIDTH, SCATTERING_HEIGHT, SCATTERING_DEPTH,
+      (texX + uvwz.y) / static_cast<float>(SCATTERING_NU_SIZE), uvwz.z, uvwz.w);
+  auto b = sample<3>(table, SCATTERING_WIDTH, SCATTERING_HEIGHT, SCATTERING_DEPTH,
+      (texX + 1.F + uvwz.y) / static_cast<float>(SCATTERING_NU_SIZE), uvwz.z, uvwz.w);
+
+  return glm::vec3(a[0], a[1], a[2]) * (1.F - lerp) + glm::vec3(b[0], b[1], b[2]) * lerp;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ScatteringTables::getScatteringTexel(int x, int y, int z, float& r, float& mu, float& muS,
+    float& nu, bool& rayIntersectsGround) const {
+
+  glm::vec4 uvwz(
+      static_cast<float>(x / SCATTERING_MU_S_SIZE) / static_cast<float>(SCATTERING_NU_SIZE - 1),
+      (static_cast<float>(x % SCATTERING_MU_S_SIZE) + 0.5F) /
+          static_cast<float>(SCATTERING_MU_S_SIZE),
+      (static_cast<float>(y) + 0.5F) / static_cast<float>(SCATTERING_MU_SIZE),
+      (static_cast<float>(z) + 0.5F) / static_cast<float>(SCATTERING_R_SIZE));
+
+  float rho = mHorizonDistance * getUnitRange(uvwz.w, SCATTERING_R_SIZE);
+  r         = safeSqrt(rho * rho + mBottomRadius * mBottomRadius);
+
+  int halfMuSize = SCATTERING_MU_SIZE / 2;
+
+  if (uvwz.z < 0.5F) {
+    float dMin = r - mBottomRadius;
+    float dMax = rho;
+    float d    = dMin + (dMax - dMin) * getUnitRange(1.F - 2.F * uvwz.z, halfMuSize);
+    mu         = d == 0.F ? -1.F : clampCosine(-(rho * rho + d * d) / (2.F * r * d));
+    rayIntersectsGround = true;
+  } else {
+    float dMin = 1.F - r;
+    float dMax = rho + mHorizonDistance;
+    float d    = dMin + (dMax - dMin) * getUnitRange(2.F * uvwz.z - 1.F, halfMuSize);
+    mu         = d == 0.F ? 1.F
+                          : clampCosine((mHorizonDistance * mHorizonDistance - rho * rho - d * d) /
+                                        (2.F * r * d));
+    rayIntersectsGround = false;
+  }
+
+  float xMuS = getUnitRange(uvwz.y, SCATTERING_MU_S_SIZE);
+  float dMin = 1.F - mBottomRadius;
+  float dMax = mHorizonDistance;
+  float A    = (distanceToTop(mBottomRadius, mMuSMin) - dMin) / (dMax - dMin);
+  float a    = (A - xMuS * A) / (1.F + xMuS * A);
+  float d    = dMin + std::min(a, A) * (dMax - dMin);
+  muS        = d == 0.F ? 1.F
+                        : clampCosine((mHorizonDistance * mHorizonDistance - d * d) /
+                               (2.F * mBottomRadius * d));
+
+  // Not all combinations of view angle, sun angle and view-sun angle are possible.
+  nu                = clampCosine(uvwz.x * 2.F - 1.F);
+  float sinMuSinMuS = safeSqrt((1.F - mu * mu) * (1.F - muS * muS));
+  nu                = std::clamp(nu, mu * muS - sinMuSinMuS, mu * muS + sinMuSinMuS);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ScatteringTables::computeTransmittance() {
+  for (int y = 0; y < TRANSMITTANCE_HEIGHT; ++y) {
+    for (int x = 0; x < TRANSMITTANCE_WIDTH; ++x) {
+      float xMu = getUnitRange((static_cast<float>(x) + 0.5F) / TRANSMITTANCE_WIDTH,
+          TRANSMITTANCE_WIDTH);
+      float xR  = getUnitRange((static_cast<float>(y) + 0.5F) / TRANSMITTANCE_HEIGHT,
+          TRANSMITTANCE_HEIGHT);
+
+      float rho  = mHorizonDistance * xR;
+      float r    = safeSqrt(rho * rho + mBottomRadius * mBottomRadius);
+      float dMin = 1.F - r;
+      float dMax = rho + mHorizonDistance;
+      float d    = dMin + xMu * (dMax - dMin);
+      float mu   = d == 0.F ? 1.F
+                            : clampCosine((mHorizonDistance * mHorizonDistance - rho * rho -
+                                              d * d) /
+                                          (2.F * r * d));
+
+      // Trapezoidal rule along the ray to the atmosphere boundary.
+      float     dx = distanceToTop(r, mu) / TRANSMITTANCE_SAMPLES;
+      glm::vec2 sum(0.F);
+
+      for (int i = 0; i <= TRANSMITTANCE_SAMPLES; ++i) {
+        float dI     = static_cast<float>(i) * dx;
+        float rI     = std::sqrt(dI * dI + 2.F * r * mu * dI + r * r);
+        float weight = (i == 0 || i == TRANSMITTANCE_SAMPLES) ? 0.5F : 1.F;
+        sum += getDensity(rI) * weight;
+      }
+
+      std::size_t texel            = static_cast<std::size_t>(y) * TRANSMITTANCE_WIDTH + x;
+      mTransmittance[texel * 2 + 0] = sum.x * dx;
+      mTransmittance[texel * 2 + 1] = sum.y * dx;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ScatteringTables::computeSingleScattering() {
+  cs::utils::parallelFor(SCATTERING_DEPTH, [this](int z) {
+    for (int y = 0; y < SCATTERING_HEIGHT; ++y) {
+      for (int x = 0; x < SCATTERING_WIDTH; ++x) {
+        float r{};
+        float mu{};
+        float muS{};
+        float nu{};
+        bool  rayIntersectsGround{};
+        getScatteringTexel(x, y, z, r, mu, muS, nu, rayIntersectsGround);
+
+        float     length = distanceToNearestBoundary(r, mu, rayIntersectsGround);
+        glm::vec3 rayleigh(0.F);
+        glm::vec3 mie(0.F);
+
+        for (int i = 0; i <= SCATTERING_SAMPLES; ++i) {
+          float dI   = getSampleDistance(i, length, rayIntersectsGround);
+          float rI =
+              std::clamp(std::sqrt(dI * dI + 2.F * r * mu * dI + r * r), mBottomRadius, 1.F);
+          float muSI = clampCosine((r * muS + dI * nu) / rI);
+
+          glm::vec3 transmittance = getTransmittance(r, mu, dI, rayIntersectsGround) *
+                                    getTransmittanceToSun(rI, muSI);
+          glm::vec2 density = getDensity(rI);
+          float     weight  = getSampleWeight(i, length, rayIntersectsGround);
+
+          rayleigh += transmittance * density.x * weight;
+          mie += transmittance * density.y * weight;
+        }
+
+        std::size_t texel =
+            (static_cast<std::size_t>(z) * SCATTERING_HEIGHT + y) * SCATTERING_WIDTH + x;
+        store(mRayleighScattering, texel, rayleigh * mParameters.mRayleighScattering);
+        store(mMieScattering, texel, mie * mParameters.mMieScattering);
+      }
+    }
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ScatteringTables::computeMultipleScattering(
+    int order, std::vector<float>& deltaScattering) const {
+
+  // First, the light which is scattered once more at each point of the atmosphere is computed.
+  // For this, the light of the previous scattering order which arrives at a point from all
+  // directions is integrated, weighted with the phase functions.
+  std::vector<float> density(mRayleighScattering.size());
+
+  float const dTheta = PI / SPHERE_SAMPLES;
+  float const dPhi   = PI / SPHERE_SAMPLES;
+
+  cs::utils::parallelFor(SCATTERING_DEPTH, [&](int z) {
+    std::vector<glm::vec3> directions;
+    std::vector<float>     solidAngles;
+    std::vector<glm::vec3> radiances;
+
+    for (int muSIndex = 0; muSIndex < SCATTERING_MU_S_SIZE; ++muSIndex) {
+
+      // The radiance arriving from all directions depends only on the altitude and the sun
+      // angle. The sun is in the x-z-plane, z points to the zenith.
+      float r{};
+      float mu{};
+      float muS{};
+      float nu{};
+      bool  rayIntersectsGround{};
+      getScatteringTexel(muSIndex, 0, z, r, mu, muS, nu, rayIntersectsGround);
+
+      glm::vec3 sunDir(safeSqrt(1.F - muS * muS), 0.F, muS);
+
+      directions.clear();
+      solidAngles.clear();
+      radiances.clear();
+
+      for (int l = 0; l < SPHERE_SAMPLES; ++l) {
+        float theta    = (static_cast<float>(l) + 0.5F) * dTheta;
+        float cosTheta = std::cos(theta);
+        float sinTheta = std::sin(theta);
+        bool  ground   = this->rayIntersectsGround(r, cosTheta);
+
+        for (int m = 0; m < 2 * SPHERE_SAMPLES; ++m) {
+          float     phi = (static_cast<float>(m) + 0.5F) * dPhi;
+          glm::vec3 direction(std::cos(phi) * sinTheta, std::sin(phi) * sinTheta, cosTheta);
+          float     nuI = clampCosine(glm::dot(sunDir, direction));
+
+          glm::vec3 radiance;
+          if (order == 2) {
+            radiance =
+                lookupScattering(mRayleighScattering, r, cosTheta, muS, nuI, ground) *
+                    getPhase(nuI, mParameters.mRayleighAnisotropy) +
+                lookupScattering(mMieScattering, r, cosTheta, muS, nuI, ground) *
+                    getPhase(nuI, mParameters.mMieAnisotropy);
+          } else {
+            radiance = lookupScattering(deltaScattering, r, cosTheta, muS, nuI, ground);
+          }
+
+          directions.push_back(direction);
+          solidAngles.push_back(dTheta * dPhi * sinTheta);
+          radiances.push_back(radiance);
+        }
+      }
+
+      glm::vec2 particles = getDensity(r);
+
+      for (int y = 0; y < SCATTERING_HEIGHT; ++y) {
+        for (int nuIndex = 0; nuIndex < SCATTERING_NU_SIZE; ++nuIndex) {
+          int x = nuIndex * SCATTERING_MU_S_SIZE + muSIndex;
+          getScatteringTexel(x, y, z, r, mu, muS, nu, rayIntersectsGround);
+
+          // The view direction with the given angles to the zenith and to the sun.
+          float     sinMuS = sunDir.x;
+          float     viewX  = sinMuS == 0.F ? 0.F : (nu - mu * muS) / sinMuS;
+          glm::vec3 viewDir(viewX, safeSqrt(1.F - mu * mu - viewX * viewX), mu);
+
+          glm::vec3 rayleigh(0.F);
+          glm::vec3 mie(0.F);
+
+          for (std::size_t i = 0; i < directions.size(); ++i) {
+            float cosine = glm::dot(viewDir, directions[i]);
+            rayleigh +=
+                radiances[i] * (getPhase(cosine, mParameters.mRayleighAnisotropy) * solidAngles[i]);
+            mie += radiances[i] * (getPhase(cosine, mParameters.mMieAnisotropy) * solidAngles[i]);
+          }
+
+          std::size_t texel =
+              (static_cast<std::size_t>(z) * SCATTERING_HEIGHT + y) * SCATTERING_WIDTH + x;
+          store(density, texel,
+              rayleigh * mParameters.mRayleighScattering * particles.x +
+                  mie * mParameters.mMieScattering * particles.y);
+        }
+      }
+    }
+  });
+
+  // Then, this light is integrated along all view rays.
+  deltaScattering.resize(mRayleighScattering.size());
+
+  cs::utils::parallelFor(SCATTERING_DEPTH, [&](int z) {
+    for (int y = 0; y < SCATTERING_HEIGHT; ++y) {
+      for (int x = 0; x < SCATTERING_WIDTH; ++x) {
+        float r{};
+        float mu{};
+        float muS{};
+        float nu{};
+        bool  rayIntersectsGround{};
+        getScatteringTexel(x, y, z, r, mu, muS, nu, rayIntersectsGround);
+
+        float     length = distanceToNearestBoundary(r, mu, rayIntersectsGround);
+        glm::vec3 sum(0.F);
+
+        for (int i = 0; i <= SCATTERING_SAMPLES; ++i) {
+          float dI   = getSampleDistance(i, length, rayIntersectsGround);
+          float rI =
+              std::clamp(std::sqrt(dI * dI + 2.F * r * mu * dI + r * r), mBottomRadius, 1.F);
+          float muI  = clampCosine((r * mu + dI) / rI);
+          float muSI = clampCosine((r * muS + dI * nu) / rI);
+
+          glm::vec3 scattering =
+              lookupScattering(density, rI, muI, muSI, nu, rayIntersectsGround) *
+              getTransmittance(r, mu, dI, rayIntersectsGround);
+          float weight = getSampleWeight(i, length, rayIntersectsGround);
+
+          sum += scattering * weight;
+        }
+
+        std::size_t texel =
+            (static_cast<std::size_t>(z) * SCATTERING_HEIGHT + y) * SCATTERING_WIDTH + x;
+        store(deltaScattering, texel, sum);
+      }
+    }
+  });
+
+  logger().debug("Computed scattering order {}.", order);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ScatteringTables::computeIrradiance() {
+  float const dTheta = PI / SPHERE_SAMPLES;
+  float const dPhi   = PI / SPHERE_SAMPLES;
+
+  for (int y = 0; y < IRRADIANCE_HEIGHT; ++y) {
+    for (int x = 0; x < IRRADIANCE_WIDTH; ++x) {
+      float xMuS =
+          getUnitRange((static_cast<float>(x) + 0.5F) / IRRADIANCE_WIDTH, IRRADIANCE_WIDTH);
+      float xR =
+          getUnitRange((static_cast<float>(y) + 0.5F) / IRRADIANCE_HEIGHT, IRRADIANCE_HEIGHT);
+
+      float     r   = mBottomRadius + xR * (1.F - mBottomRadius);
+      float     muS = clampCosine(2.F * xMuS - 1.F);
+      glm::vec3 sunDir(safeSqrt(1.F - muS * muS), 0.F, muS);
+
+      // The scattered light is integrated over the upper hemisphere, weighted with the cosine to
+      // the zenith.
+      glm::vec3 irradiance(0.F);
+
+      for (int l = 0; l < SPHERE_SAMPLES / 2; ++l) {
+        float theta    = (static_cast<float>(l) + 0.5F) * dTheta;
+        float cosTheta = std::cos(theta);
+        float sinTheta = std::sin(theta);
+
+        for (int m = 0; m < 2 * SPHERE_SAMPLES; ++m) {
+          float     phi = (static_cast<float>(m) + 0.5F) * dPhi;
+          glm::vec3 direction(std::cos(phi) * sinTheta, std::sin(phi) * sinTheta, cosTheta);
+          float     nu = clampCosine(glm::dot(sunDir, direction));
+
+          glm::vec3 rayleigh;
+          glm::vec3 mie;
+          getScattering(r, cosTheta, muS, nu, false, rayleigh, mie);
+
+          glm::vec3 radiance = rayleigh * getPhase(nu, mParameters.mRayleighAnisotropy) +
+                               mie * getPhase(nu, mParameters.mMieAnisotropy);
+
+          irradiance += radiance * (cosTheta * sinTheta * dTheta * dPhi);
+        }
+      }
+
+      store(mIrradiance, static_cast<std::size_t>(y) * IRRADIANCE_WIDTH + x, irradiance);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::atmospheres
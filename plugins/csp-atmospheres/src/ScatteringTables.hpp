@@ -0,0 +1,191 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_ATMOSPHERES_SCATTERING_TABLES_HPP
+#define CSP_ATMOSPHERES_SCATTERING_TABLES_HPP
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace csp::atmospheres {
+
+/// The ScatteringTables contain the precomputed light transport of an atmosphere. They are based
+/// on "Precomputed Atmospheric Scattering" by Eric Bruneton and Fabrice Neyret (2008) and use the
+/// table parametrization of its revised implementation (2017). When they are used by the
+/// AtmosphereRenderer, the fragment shader needs a few texture lookups per pixel instead of
+/// ray-marching along the view ray and towards the sun for each sample.
+///
+/// All distances are given in the model space of the AtmosphereRenderer: The atmosphere boundary
+/// has a radius of one and the planet's surface a radius of one minus the atmosphere height. The
+/// tables are computed for a sun illuminance of one. There are four tables:
+///  - The optical depth for Rayleigh and Mie scattering from any point in the atmosphere towards
+///    the atmosphere boundary, indexed by altitude and view angle. The transmittance between any
+///    two points of the atmosphere can be derived from it.
+///  - The Rayleigh scattering (single and multiple) and the single Mie scattering towards a point
+///    in the atmosphere, integrated along the view ray up to the atmosphere boundary or the
+///    ground. These are indexed by altitude, view angle, sun angle and the angle between view ray
+///    and sun. The phase functions are applied when the tables are used. The 4D tables are stored
+///    as 3D textures with the sun angle and the view-sun angle packed into the x-axis.
+///  - The irradiance due to the sky, indexed by altitude and sun angle.
+///
+/// The lookup methods of this class are implemented exactly like their counterparts in the
+/// fragment shader, so that the tables can be tested on the CPU.
+class ScatteringTables {
+ public:
+  /// The parameters of the atmosphere. See AtmosphereRenderer for a description of each value.
+  struct Parameters {
+    float     mAtmosphereHeight{};
+    float     mRayleighHeight{};
+    glm::vec3 mRayleighScattering{};
+    float     mRayleighAnisotropy{};
+    float     mMieHeight{};
+    glm::vec3 mMieScattering{};
+    float     mMieAnisotropy{};
+
+    /// The number of scattering events which are considered. One means single scattering only.
+    int32_t mScatteringOrders = 4;
+
+    bool operator==(Parameters const& other) const;
+    bool operator!=(Parameters const& other) const;
+  };
+
+  /// Increase this if the binary format or the computation changed. This will force all cached
+  /// tables to be recomputed.
+  static const uint32_t cVersion;
+
+  /// Size of the optical depth table (view angle x altitude), two floats per texel.
+  static constexpr int TRANSMITTANCE_WIDTH  = 256;
+  static constexpr int TRANSMITTANCE_HEIGHT = 64;
+
+  /// Size of the 4D scattering tables, three floats per texel.
+  static constexpr int SCATTERING_R_SIZE    = 32;
+  static constexpr int SCATTERING_MU_SIZE   = 128;
+  static constexpr int SCATTERING_MU_S_SIZE = 32;
+  static constexpr int SCATTERING_NU_SIZE   = 8;
+
+  /// Size of the 3D textures the scattering tables are stored in.
+  static constexpr int SCATTERING_WIDTH  = SCATTERING_NU_SIZE * SCATTERING_MU_S_SIZE;
+  static constexpr int SCATTERING_HEIGHT = SCATTERING_MU_SIZE;
+  static constexpr int SCATTERING_DEPTH  = SCATTERING_R_SIZE;
+
+  /// Size of the irradiance table (sun angle x altitude), three floats per texel.
+  static constexpr int IRRADIANCE_WIDTH  = 64;
+  static constexpr int IRRADIANCE_HEIGHT = 16;
+
+  /// The angular radius of the sun. Sun light fades out while the sun sets behind the horizon.
+  static const float cSunAngularRadius;
+
+  /// Computes all tables. This takes a few seconds; it uses all available CPU cores and should be
+  /// called from a background thread.
+  static std::unique_ptr<ScatteringTables> generate(Parameters const& parameters);
+
+  /// Loads tables which have been saved before. Returns nullptr if the file does not exist, has an
+  /// incompatible version or has been created with other parameters.
+  static std::unique_ptr<ScatteringTables> load(
+      std::string const& fileName, Parameters const& parameters);
+
+  /// Returns a file name which is unique for the given parameters and the current version.
+  static std::string getCacheFileName(Parameters const& parameters);
+
+  ScatteringTables(ScatteringTables const& other) = delete;
+  ScatteringTables(ScatteringTables&& other)      = delete;
+
+  ScatteringTables& operator=(ScatteringTables const& other) = delete;
+  ScatteringTables& operator=(ScatteringTables&& other) = delete;
+
+  ~ScatteringTables() = default;
+
+  /// Writes the tables into a binary file. The file is replaced atomically, so other instances
+  /// never load partially written tables. Returns false if the file could not be written.
+  bool save(std::string const& fileName) const;
+
+  Parameters const& getParameters() const;
+
+  /// The radius of the planet's surface in model space.
+  float getBottomRadius() const;
+
+  /// Below this cosine between zenith and sun direction, there is no scattering.
+  float getMuSMin() const;
+
+  /// The raw table data in the layout described above, row by row.
+  std::vector<float> const& getTransmittance() const;
+  std::vector<float> const& getRayleighScattering() const;
+  std::vector<float> const& getMieScattering() const;
+  std::vector<float> const& getIrradiance() const;
+
+  /// Returns the Rayleigh and Mie optical depth from a point at the given radius towards the
+  /// atmosphere boundary. The direction is given as cosine to the zenith; the ray must not hit the
+  /// ground.
+  glm::vec2 getOpticalDepthToTop(float r, float mu) const;
+
+  /// Returns the transmittance along the given ray up to the given distance.
+  glm::vec3 getTransmittance(float r, float mu, float d, bool rayIntersectsGround) const;
+
+  /// Returns the fraction of sun light which reaches a point at the given radius and the given
+  /// cosine between zenith and sun direction.
+  glm::vec3 getTransmittanceToSun(float r, float muS) const;
+
+  /// Returns the light which is scattered towards a point along the given ray, without phase
+  /// functions. The Rayleigh scattering contains the multiple scattering divided by the Rayleigh
+  /// phase function.
+  void getScattering(float r, float mu, float muS, float nu, bool rayIntersectsGround,
+      glm::vec3& rayleigh, glm::vec3& mie) const;
+
+  /// Returns the irradiance due to the sky at a point at the given radius.
+  glm::vec3 getSkyIrradiance(float r, float muS) const;
+
+  /// Returns the light which is scattered towards the origin of the given ray between the two
+  /// given distances along the ray. Set hitsSurface to false if the ray ends at the atmosphere
+  /// boundary. This mirrors GetInscatter() of the fragment shader without tone mapping.
+  glm::vec3 getInscatter(glm::vec3 const& rayOrigin, glm::vec3 const& rayDir, float tStart,
+      float tEnd, bool hitsSurface, glm::vec3 const& sunDir) const;
+
+  /// Returns true if a ray starting at the given radius in the given direction hits the planet.
+  bool rayIntersectsGround(float r, float mu) const;
+
+  /// The phase function used by the AtmosphereRenderer, see GetPhase() in the fragment shader.
+  static float getPhase(float cosine, float anisotropy);
+
+ private:
+  explicit ScatteringTables(Parameters const& parameters);
+
+  float     distanceToTop(float r, float mu) const;
+  float     distanceToBottom(float r, float mu) const;
+  float     distanceToNearestBoundary(float r, float mu, bool rayIntersectsGround) const;
+  glm::vec2 getDensity(float r) const;
+  glm::vec3 getExtinction(glm::vec2 const& opticalDepth) const;
+
+  glm::vec2 getTransmittanceUV(float r, float mu) const;
+  glm::vec4 getScatteringUVWZ(float r, float mu, float muS, float nu, bool rayIntersectsGround)
+      const;
+  glm::vec3 lookupScattering(std::vector<float> const& table, float r, float mu, float muS,
+      float nu, bool rayIntersectsGround) const;
+
+  void getScatteringTexel(int x, int y, int z, float& r, float& mu, float& muS, float& nu,
+      bool& rayIntersectsGround) const;
+
+  void computeTransmittance();
+  void computeSingleScattering();
+  void computeMultipleScattering(int order, std::vector<float>& deltaScattering) const;
+  void computeIrradiance();
+
+  Parameters mParameters;
+  float      mBottomRadius;
+  float      mHorizonDistance;
+  float      mMuSMin;
+
+  std::vector<float> mTransmittance;
+  std::vector<float> mRayleighScattering;
+  std::vector<float> mMieScattering;
+  std::vector<float> mIrradiance;
+};
+
+} // namespace csp::atmospheres
+
+#endif // CSP_ATMOSPHERES_SCATTERING_TABLES_HPP
@@ -77,6 +77,14 @@ const char* AtmosphereRenderer::cAtmosphereFrag0 = R"(
   uniform float     uAmbientBrightness;
   uniform float     uFarClip;
 
+  // precomputed scattering, see ScatteringTables.hpp
+  #if USE_PRECOMPUTED_SCATTERING
+    uniform sampler2D uTransmittanceTexture;
+    uniform sampler3D uRayleighScatteringTexture;
+    uniform sampler3D uMieScatteringTexture;
+    uniform sampler2D uIrradianceTexture;
+  #endif
+
   // shadow stuff
   uniform sampler2DShadow uShadowMaps[5];
   uniform mat4            uShadowProjectionViewMatrices[5];
@@ -191,32 +199,6 @@ const char* AtmosphereRenderer::cAtmosphereFrag0 = R"(
     return exp(-BR*vOpticalDepth.x-BM*vOpticalDepth.y);
   }
 
-  // vec3 GetExtinction(vec3 vRayOrigin, vec3 vRayDir)
-  // {
-  //     float angle = dot(normalize(vRayOrigin), vRayDir);
-  //     float altitude = max(0.0, length(vRayOrigin) - 1.0 + HEIGHT_ATMO);
-  //     float u = acos(angle) / (98.0 / 180.0 * PI);
-  //     float v = altitude / HEIGHT_ATMO;
-  //     return texture(uTransmittanceTexture, vec2(u, v)).rgb;
-  // }
-
-
-  // returns the irradiance for the current pixel
-  // This is based on the color buffer and the extinction of light.
-  vec3 GetExtinction(vec3 vRayOrigin, vec3 vRayDir, float fTStart, float fTEnd) {
-    vec2 vOpticalDepth = GetOpticalDepth(vRayOrigin, vRayDir, fTStart, fTEnd);
-    return GetExtinction(vOpticalDepth);
-
-    // With precomputed transmittance, this code should be used. As there is no
-    // significant performance gain, the code is kept here only for reference
-    // vec3 entry = vRayOrigin + vRayDir*fTStart;
-    // vec3 exit = vRayOrigin + vRayDir*fTEnd;
-    // vec3 extinctionZenith = clamp(GetExtinction(entry, vRayDir) / GetExtinction(exit, vRayDir), vec3(0), vec3(1));
-    // vec3 extinctionNadir = clamp(GetExtinction(exit, -vRayDir) / GetExtinction(entry, -vRayDir), vec3(0), vec3(1));
-    // float angle = dot(normalize(vRayOrigin), vRayDir);
-    // return mix(extinctionNadir, extinctionZenith, clamp((angle+0.01)/0.02, 0.0, 1.0));
-  }
-
   // compute intersections with the atmosphere
   // two T parameters are returned -- if no intersection is found, the first will
   // larger than the second
@@ -241,6 +223,173 @@ const char* AtmosphereRenderer::cAtmosphereFrag0 = R"(
     return IntersectSphere(vRayOrigin, vRayDir, 1.0-HEIGHT_ATMO);
   }
 
+  #if USE_PRECOMPUTED_SCATTERING
+
+    // The following functions make lookups in the precomputed tables. They are implemented
+    // exactly like their counterparts in ScatteringTables.cpp, see there for details. The
+    // direction of a ray is given by the cosine (mu) between ray and zenith; the direction of the
+    // sun by the cosine (muS) between sun and zenith. nu is the cosine between ray and sun.
+    const float BOTTOM_RADIUS    = 1.0 - HEIGHT_ATMO;
+    const float HORIZON_DISTANCE = sqrt(1.0 - BOTTOM_RADIUS * BOTTOM_RADIUS);
+
+    float ClampCosine(float mu) {
+      return clamp(mu, -1.0, 1.0);
+    }
+
+    float SafeSqrt(float a) {
+      return sqrt(max(a, 0.0));
+    }
+
+    // maps [0..1] to texture coordinates, so that the texel centers at the border of the
+    // texture correspond to zero and one
+    float GetTextureCoord(float x, float fSize) {
+      return 0.5 / fSize + x * (1.0 - 1.0 / fSize);
+    }
+
+    float DistanceToTop(float r, float mu) {
+      return max(0.0, -r * mu + SafeSqrt(r * r * (mu * mu - 1.0) + 1.0));
+    }
+
+    bool RayIntersectsGround(float r, float mu) {
+      return mu < 0.0 && r * r * (mu * mu - 1.0) + BOTTOM_RADIUS * BOTTOM_RADIUS >= 0.0;
+    }
+
+    // returns the rayleigh and mie optical depth towards the atmosphere boundary
+    vec2 GetOpticalDepthToTop(float r, float mu) {
+      float rho  = SafeSqrt(r * r - BOTTOM_RADIUS * BOTTOM_RADIUS);
+      float d    = DistanceToTop(r, mu);
+      float dMin = 1.0 - r;
+      float dMax = rho + HORIZON_DISTANCE;
+
+      vec2 uv = vec2(GetTextureCoord((d - dMin) / (dMax - dMin), TRANSMITTANCE_TEXTURE_WIDTH),
+                     GetTextureCoord(rho / HORIZON_DISTANCE, TRANSMITTANCE_TEXTURE_HEIGHT));
+
+      return texture(uTransmittanceTexture, uv).rg;
+    }
+
+    // returns the transmittance along the given ray up to the given distance
+    vec3 GetTransmittance(float r, float mu, float d, bool bRayIntersectsGround) {
+      float rD  = clamp(sqrt(d * d + 2.0 * r * mu * d + r * r), BOTTOM_RADIUS, 1.0);
+      float muD = ClampCosine((r * mu + d) / rD);
+
+      // the table contains only rays which do not hit the ground, others are reversed
+      vec2 vOpticalDepth = bRayIntersectsGround ?
+        GetOpticalDepthToTop(rD, -muD) - GetOpticalDepthToTop(r, -mu) :
+        GetOpticalDepthToTop(r, mu) - GetOpticalDepthToTop(rD, muD);
+
+      return GetExtinction(max(vOpticalDepth, vec2(0.0)));
+    }
+
+    // returns the fraction of sun light which reaches the given altitude
+    vec3 GetTransmittanceToSun(float r, float muS) {
+      float sinThetaH = BOTTOM_RADIUS / r;
+      float cosThetaH = -SafeSqrt(1.0 - sinThetaH * sinThetaH);
+
+      return GetExtinction(GetOpticalDepthToTop(r, muS)) *
+        smoothstep(-sinThetaH * SUN_ANGULAR_RADIUS, sinThetaH * SUN_ANGULAR_RADIUS, muS - cosThetaH);
+    }
+
+    vec4 GetScatteringUVWZ(float r, float mu, float muS, float nu, bool bRayIntersectsGround) {
+      float rho = SafeSqrt(r * r - BOTTOM_RADIUS * BOTTOM_RADIUS);
+      float uR  = GetTextureCoord(rho / HORIZON_DISTANCE, SCATTERING_TEXTURE_R_SIZE);
+
+      // rays which hit the ground are stored in the lower half, all others in the upper half
+      float rMu          = r * mu;
+      float discriminant = rMu * rMu - r * r + BOTTOM_RADIUS * BOTTOM_RADIUS;
+      float halfMuSize   = SCATTERING_TEXTURE_MU_SIZE / 2.0;
+      float uMu;
+
+      if (bRayIntersectsGround) {
+        float d    = -rMu - SafeSqrt(discriminant);
+        float dMin = r - BOTTOM_RADIUS;
+        float dMax = rho;
+        uMu = 0.5 - 0.5 * GetTextureCoord(dMax == dMin ? 0.0 : (d - dMin) / (dMax - dMin),
+                                          halfMuSize);
+      } else {
+        float d    = -rMu + SafeSqrt(discriminant + HORIZON_DISTANCE * HORIZON_DISTANCE);
+        float dMin = 1.0 - r;
+        float dMax = rho + HORIZON_DISTANCE;
+        uMu = 0.5 + 0.5 * GetTextureCoord((d - dMin) / (dMax - dMin), halfMuSize);
+      }
+
+      float d    = DistanceToTop(BOTTOM_RADIUS, muS);
+      float dMin = 1.0 - BOTTOM_RADIUS;
+      float dMax = HORIZON_DISTANCE;
+      float a    = (d - dMin) / (dMax - dMin);
+      float A    = (DistanceToTop(BOTTOM_RADIUS, MU_S_MIN) - dMin) / (dMax - dMin);
+      float uMuS = GetTextureCoord(max(1.0 - a / A, 0.0) / (1.0 + a), SCATTERING_TEXTURE_MU_S_SIZE);
+
+      return vec4((nu + 1.0) / 2.0, uMuS, uMu, uR);
+    }
+
+    // returns the light which is scattered towards a point along the given ray, without phase
+    // function
+    vec3 GetScattering(sampler3D table, float r, float mu, float muS, float nu,
+                       bool bRayIntersectsGround) {
+      vec4 uvwz = GetScatteringUVWZ(r, mu, muS, nu, bRayIntersectsGround);
+
+      // sun angle and view-sun angle share the x-axis, the latter is interpolated manually
+      float fTexCoordX = uvwz.x * (SCATTERING_TEXTURE_NU_SIZE - 1.0);
+      float fTexX      = floor(fTexCoordX);
+      float fLerp      = fTexCoordX - fTexX;
+
+      vec3 a = texture(table, vec3((fTexX + uvwz.y) / SCATTERING_TEXTURE_NU_SIZE, uvwz.z, uvwz.w)).rgb;
+      vec3 b = texture(table, vec3((fTexX + 1.0 + uvwz.y) / SCATTERING_TEXTURE_NU_SIZE, uvwz.z, uvwz.w)).rgb;
+
+      return mix(a, b, fLerp);
+    }
+
+    // returns the irradiance due to the sky at the given altitude
+    vec3 GetSkyIrradiance(float r, float muS) {
+      vec2 uv = vec2(GetTextureCoord(muS * 0.5 + 0.5, IRRADIANCE_TEXTURE_WIDTH),
+                     GetTextureCoord((r - BOTTOM_RADIUS) / (1.0 - BOTTOM_RADIUS), IRRADIANCE_TEXTURE_HEIGHT));
+      return texture(uIrradianceTexture, uv).rgb;
+    }
+
+  #endif
+
+  // returns the extinction of light between two points in model space
+  // The ray is defined by its origin and direction. The two points are defined
+  // by two T parameters along the ray.
+  vec3 GetExtinction(vec3 vRayOrigin, vec3 vRayDir, float fTStart, float fTEnd) {
+    #if USE_PRECOMPUTED_SCATTERING
+      // the tables only cover the inside of the atmosphere
+      vec2 vIntersections = IntersectAtmosphere(vRayOrigin, vRayDir);
+      fTStart = max(fTStart, vIntersections.x);
+      fTEnd   = min(fTEnd, vIntersections.y);
+
+      if (fTStart >= fTEnd) {
+        return vec3(1.0);
+      }
+
+      vec3  vStart = vRayOrigin + vRayDir * fTStart;
+      float r      = clamp(length(vStart), BOTTOM_RADIUS, 1.0);
+      float mu     = ClampCosine(dot(vStart, vRayDir) / r);
+
+      return GetTransmittance(r, mu, fTEnd - fTStart, RayIntersectsGround(r, mu));
+    #else
+      return GetExtinction(GetOpticalDepth(vRayOrigin, vRayDir, fTStart, fTEnd));
+    #endif
+  }
+
+  // returns the fraction of sun light which reaches the given point in model space
+  vec3 GetSunExtinction(vec3 vPosition, vec3 vSunDir) {
+    #if USE_PRECOMPUTED_SCATTERING
+      if (length(vPosition) < 1.0) {
+        float r = max(length(vPosition), BOTTOM_RADIUS);
+        return GetTransmittanceToSun(r, ClampCosine(dot(vPosition, vSunDir) / length(vPosition)));
+      }
+    #endif
+
+    vec2 vSunStartEnd = IntersectAtmosphere(vPosition, vSunDir);
+
+    if (vSunStartEnd.x < vSunStartEnd.y && vSunStartEnd.y > 0) {
+      return GetExtinction(vPosition, vSunDir, max(0, vSunStartEnd.x), vSunStartEnd.y);
+    }
+
+    return vec3(1.0);
+  }
+
   vec2 GetLngLat(vec3 vPosition) {
     vec2 result = vec2(-2);
 
@@ -286,9 +435,19 @@ const char* AtmosphereRenderer::cAtmosphereFrag0 = R"(
 
   vec4 SampleCloudColor(vec3 vRayOrigin, vec3 vRayDir, vec3 vSunDir, float fTIntersection) {
     vec3 point = vRayOrigin + vRayDir * fTIntersection;
-    vec2 sunStartEnd = IntersectAtmosphere(point, vSunDir);
-    vec3 extinction = GetExtinction(GetOpticalDepth(point, vSunDir, 0, sunStartEnd.y)
-                                  + GetOpticalDepth(vRayOrigin, vRayDir, 0, fTIntersection));
+
+    #if USE_PRECOMPUTED_SCATTERING
+      // with precomputed scattering, the clouds are lit by the sun and the sky
+      float r = clamp(length(point), BOTTOM_RADIUS, 1.0);
+      vec3 extinction = (GetSunExtinction(point, vSunDir) +
+                         GetSkyIrradiance(r, ClampCosine(dot(point, vSunDir) / length(point)))) *
+                        GetExtinction(vRayOrigin, vRayDir, 0, fTIntersection);
+    #else
+      vec2 sunStartEnd = IntersectAtmosphere(point, vSunDir);
+      vec3 extinction = GetExtinction(GetOpticalDepth(point, vSunDir, 0, sunStartEnd.y)
+                                    + GetOpticalDepth(vRayOrigin, vRayDir, 0, fTIntersection));
+    #endif
+
     float density = SampleCloudDensity(point);
 
     return vec4(extinction * density * uSunIntensity, density);
@@ -438,12 +597,6 @@ const char* AtmosphereRenderer::cAtmosphereFrag1 = R"(
       vec2 vOpticalDepth    = GetOpticalDepth(vRayOrigin, vRayDir, fTStart, fTMid);
       vec2 vOpticalDepthSun = GetOpticalDepth(vPos, vLightDir, 0, fTSunExit);
       vec3 vExtinction      = GetExtinction(vOpticalDepthSun+vOpticalDepth);
-
-      // With precomputed transmittance, this code should be used. As there is no
-      // significant performance gain, the code is kept here only for reference
-      // vec3 vExtinction      = GetExtinction(vRayOrigin, vRayDir, fTStart, fTMid) * 
-      //                         GetExtinction(vPos, vLightDir, 0, fTSunExit);
-
       vec2 vDensity         = GetDensity(vPos);
 
       sumR += vExtinction*vDensity.x * (fTSegmentEnd - fTSegmentBegin) * shadow;
@@ -457,6 +610,44 @@ const char* AtmosphereRenderer::cAtmosphereFrag1 = R"(
     return ToneMapping(uSunIntensity * vInScatter);
   }
 
+  #if USE_PRECOMPUTED_SCATTERING
+    // same as GetInscatter, but based on the precomputed tables
+    // The tables contain the light scattered along the entire ray until it hits the
+    // ground or leaves the atmosphere. Light shafts are not available in this mode.
+    vec3 GetPrecomputedInscatter(vec3 vRayOrigin, vec3 vRayDir, float fTStart,
+                                 float fTEnd, bool bHitsSurface, vec3 vLightDir) {
+      vec3  vStart = vRayOrigin + vRayDir * fTStart;
+      float r      = clamp(length(vStart), BOTTOM_RADIUS, 1.0);
+      float mu     = ClampCosine(dot(vStart, vRayDir) / r);
+      float muS    = ClampCosine(dot(vStart, vLightDir) / r);
+      float nu     = ClampCosine(dot(vRayDir, vLightDir));
+      float d      = fTEnd - fTStart;
+
+      bool bRayIntersectsGround = RayIntersectsGround(r, mu);
+
+      vec3 sumR = GetScattering(uRayleighScatteringTexture, r, mu, muS, nu, bRayIntersectsGround);
+      vec3 sumM = GetScattering(uMieScatteringTexture, r, mu, muS, nu, bRayIntersectsGround);
+
+      // if the ray ends at an object, the light scattered behind the object is subtracted
+      if (bHitsSurface) {
+        float rD   = clamp(sqrt(d * d + 2.0 * r * mu * d + r * r), BOTTOM_RADIUS, 1.0);
+        float muD  = ClampCosine((r * mu + d) / rD);
+        float muSD = ClampCosine((r * muS + d * nu) / rD);
+
+        vec3 vTransmittance = GetTransmittance(r, mu, d, bRayIntersectsGround);
+
+        sumR = max(sumR - vTransmittance * GetScattering(uRayleighScatteringTexture, rD, muD,
+                                                         muSD, nu, bRayIntersectsGround), 0.0);
+        sumM = max(sumM - vTransmittance * GetScattering(uMieScatteringTexture, rD, muD,
+                                                         muSD, nu, bRayIntersectsGround), 0.0);
+      }
+
+      vec3 vInScatter = sumR * GetPhase(nu, ANISOTROPY_R) + sumM * GetPhase(nu, ANISOTROPY_M);
+
+      return ToneMapping(uSunIntensity * vInScatter);
+    }
+  #endif
+
   // returns the model space distance to the surface of the depth buffer at the
   // current pixel, or 10 if there is nothing in the depth buffer
   float GetOpaqueDepth() {
@@ -583,7 +774,7 @@ const char* AtmosphereRenderer::cAtmosphereFrag1 = R"(
     vec2 sunStartEnd = IntersectAtmosphere(surfacePoint, uSunDir);
 
     if (sunStartEnd.x < sunStartEnd.y && sunStartEnd.y > 0) {
-      vec3 sunExtinction = GetExtinction(surfacePoint, uSunDir, max(0, sunStartEnd.x), sunStartEnd.y);
+      vec3 sunExtinction = GetSunExtinction(surfacePoint, uSunDir);
       
       #if USE_CLOUDMAP
         // add cloud shadow to the surface color
@@ -621,7 +812,11 @@ const char* AtmosphereRenderer::cAtmosphereFrag1 = R"(
       #endif
 
       oColor *= GetExtinction(vsIn.vRayOrigin, vRayDir, vStartEnd.x, vStartEnd.y);
-      oColor += GetInscatter(vsIn.vRayOrigin, vRayDir, vStartEnd.x, vStartEnd.y, bHitsSurface, uSunDir);
+      #if USE_PRECOMPUTED_SCATTERING
+        oColor += GetPrecomputedInscatter(vsIn.vRayOrigin, vRayDir, vStartEnd.x, vStartEnd.y, bHitsSurface, uSunDir);
+      #else
+        oColor += GetInscatter(vsIn.vRayOrigin, vRayDir, vStartEnd.x, vStartEnd.y, bHitsSurface, uSunDir);
+      #endif
 
       // add clouds themselves
       #if USE_CLOUDMAP
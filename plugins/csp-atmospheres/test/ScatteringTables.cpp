@@ -0,0 +1,286 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "../src/ScatteringTables.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+#include "../src/logger.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+namespace csp::atmospheres {
+
+namespace {
+
+// The Earth preset of the default configuration.
+ScatteringTables::Parameters getEarthParameters(int scatteringOrders) {
+  ScatteringTables::Parameters parameters;
+  parameters.mAtmosphereHeight   = 0.015F;
+  parameters.mRayleighHeight     = 0.001257862F;
+  parameters.mRayleighScattering = glm::vec3(36.89F, 85.86F, 210.516F);
+  parameters.mRayleighAnisotropy = 0.F;
+  parameters.mMieHeight          = 0.000188679F;
+  parameters.mMieScattering      = glm::vec3(133.56F, 133.56F, 133.56F);
+  parameters.mMieAnisotropy      = 0.76F;
+  parameters.mScatteringOrders   = scatteringOrders;
+  return parameters;
+}
+
+// This is a port of the ray-marching code of the fragment shader, see GetInscatter() in
+// Shaders.cpp. It is used as reference for the precomputed tables.
+class RayMarcher {
+ public:
+  RayMarcher(ScatteringTables::Parameters const& parameters, int primarySteps, int secondarySteps)
+      : mParameters(parameters)
+      , mPrimarySteps(primarySteps)
+      , mSecondarySteps(secondarySteps) {
+  }
+
+  glm::vec2 getDensity(glm::vec3 const& position) const {
+    float height = std::max(0.F, glm::length(position) - 1.F + mParameters.mAtmosphereHeight);
+    return glm::vec2(std::exp(-height / mParameters.mRayleighHeight),
+        std::exp(-height / mParameters.mMieHeight));
+  }
+
+  glm::vec2 getOpticalDepth(
+      glm::vec3 const& rayOrigin, glm::vec3 const& rayDir, float tStart, float tEnd) const {
+    float     step = (tEnd - tStart) / static_cast<float>(mSecondarySteps);
+    glm::vec2 sum(0.F);
+
+    for (int i = 0; i < mSecondarySteps; ++i) {
+      float tCurr = tStart + (static_cast<float>(i) + 0.5F) * step;
+      sum += getDensity(rayOrigin + rayDir * tCurr);
+    }
+
+    return sum * step;
+  }
+
+  glm::vec3 getExtinction(glm::vec2 const& opticalDepth) const {
+    return glm::exp(-mParameters.mRayleighScattering * opticalDepth.x -
+                    mParameters.mMieScattering * opticalDepth.y);
+  }
+
+  static glm::vec2 intersectSphere(glm::vec3 const& rayOrigin, glm::vec3 const& rayDir, float r) {
+    float b   = glm::dot(rayOrigin, rayDir);
+    float c   = glm::dot(rayOrigin, rayOrigin) - r * r;
+    float det = b * b - c;
+
+    if (det < 0.F) {
+      return glm::vec2(10000.F, -10000.F);
+    }
+
+    det = std::sqrt(det);
+    return glm::vec2(-b - det, -b + det);
+  }
+
+  glm::vec3 getInscatter(glm::vec3 const& rayOrigin, glm::vec3 const& rayDir, float tStart,
+      float tEnd, bool hitsSurface, glm::vec3 const& lightDir) const {
+    float startHeight = std::clamp((glm::length(rayOrigin + rayDir * tStart) - 1.F +
+                                       mParameters.mAtmosphereHeight) /
+                                       mParameters.mAtmosphereHeight,
+        0.F, 1.F);
+    float exponent = hitsSurface ? 1.F : (1.F - startHeight) * 2.F + 1.F;
+    float dist     = tEnd - tStart;
+    auto  steps    = static_cast<float>(mPrimarySteps);
+
+    glm::vec3 sumR(0.F);
+    glm::vec3 sumM(0.F);
+
+    for (int i = 0; i < mPrimarySteps; ++i) {
+      auto  fi            = static_cast<float>(i);
+      float tSegmentBegin = tStart + std::pow(fi / steps, exponent) * dist;
+      float tMid          = tStart + std::pow((fi + 0.5F) / steps, exponent) * dist;
+      float tSegmentEnd   = tStart + std::pow((fi + 1.F) / steps, exponent) * dist;
+
+      glm::vec3 pos     = rayOrigin + rayDir * tMid;
+      float     tSunExit = intersectSphere(pos, lightDir, 1.F).y;
+
+      glm::vec3 extinction = getExtinction(getOpticalDepth(rayOrigin, rayDir, tStart, tMid) +
+                                           getOpticalDepth(pos, lightDir, 0.F, tSunExit));
+      glm::vec2 density    = getDensity(pos);
+
+      sumR += extinction * density.x * (tSegmentEnd - tSegmentBegin);
+      sumM += extinction * density.y * (tSegmentEnd - tSegmentBegin);
+    }
+
+    float cosine = glm::dot(rayDir, lightDir);
+    return sumR * mParameters.mRayleighScattering *
+               ScatteringTables::getPhase(cosine, mParameters.mRayleighAnisotropy) +
+           sumM * mParameters.mMieScattering *
+               ScatteringTables::getPhase(cosine, mParameters.mMieAnisotropy);
+  }
+
+ private:
+  ScatteringTables::Parameters mParameters;
+  int                          mPrimarySteps;
+  int                          mSecondarySteps;
+};
+
+// Returns the largest relative difference of the color channels, relative to the brightest one.
+float getRelativeError(glm::vec3 const& value, glm::vec3 const& reference) {
+  float maximum = std::max({reference.x, reference.y, reference.z});
+  glm::vec3 error = value - reference;
+  return std::max({std::abs(error.x), std::abs(error.y), std::abs(error.z)}) / maximum;
+}
+
+// Returns the distance from the given point to the ground or the atmosphere boundary.
+float getRayLength(glm::vec3 const& origin, glm::vec3 const& direction, float groundRadius) {
+  glm::vec2 ground = RayMarcher::intersectSphere(origin, direction, groundRadius);
+
+  if (ground.x < ground.y && ground.x > 0.F) {
+    return ground.x;
+  }
+
+  return RayMarcher::intersectSphere(origin, direction, 1.F).y;
+}
+
+glm::vec3 getDirection(float elevation, float azimuth) {
+  return glm::vec3(std::cos(elevation) * std::cos(azimuth),
+      std::cos(elevation) * std::sin(azimuth), std::sin(elevation));
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("csp::atmospheres::ScatteringTables") {
+  auto parameters = getEarthParameters(1);
+  auto tables     = ScatteringTables::generate(parameters);
+
+  RayMarcher rayMarcher(parameters, 1000, 200);
+
+  float     groundRadius = 1.F - parameters.mAtmosphereHeight;
+  glm::vec3 zenith(0.F, 0.F, 1.F);
+
+  SUBCASE("The transmittance equals the ray-marched extinction") {
+    for (float altitude : {0.F, 0.1F, 0.5F}) {
+      glm::vec3 origin = zenith * (groundRadius + altitude * parameters.mAtmosphereHeight);
+
+      for (float elevation : {1.5F, 0.5F, 0.1F, 0.02F, -0.02F, -0.5F}) {
+        glm::vec3 direction = getDirection(elevation, 0.F);
+        float     distance  = getRayLength(origin, direction, groundRadius);
+        glm::vec3 expected =
+            rayMarcher.getExtinction(rayMarcher.getOpticalDepth(origin, direction, 0.F, distance));
+
+        float r  = glm::length(origin);
+        float mu = glm::dot(origin, direction) / r;
+
+        glm::vec3 transmittance =
+            tables->getTransmittance(r, mu, distance, tables->rayIntersectsGround(r, mu));
+
+        CHECK(glm::length(transmittance - expected) < 0.01F);
+      }
+    }
+  }
+
+  SUBCASE("The single scattering equals the ray-marched inscattering") {
+    glm::vec3 sun = getDirection(0.3F, 0.F);
+
+    for (float altitude : {0.F, 0.2F}) {
+      glm::vec3 origin = zenith * (groundRadius + altitude * parameters.mAtmosphereHeight);
+
+      for (float elevation : {1.5F, 0.7F, 0.2F, 0.05F, -0.1F, -0.5F}) {
+        // Rays from the ground into the ground are not considered.
+        if (altitude == 0.F && elevation < 0.F) {
+          continue;
+        }
+
+        for (float azimuth : {0.F, 1.5F, 3.F}) {
+          glm::vec3 direction = getDirection(elevation, azimuth);
+          float     distance   = getRayLength(origin, direction, groundRadius);
+          bool      hitsGround = distance < RayMarcher::intersectSphere(origin, direction, 1.F).y;
+
+          glm::vec3 expected =
+              rayMarcher.getInscatter(origin, direction, 0.F, distance, hitsGround, sun);
+          glm::vec3 inscatter =
+              tables->getInscatter(origin, direction, 0.F, distance, hitsGround, sun);
+
+          CHECK(getRelativeError(inscatter, expected) < 0.05F);
+        }
+      }
+    }
+  }
+
+  SUBCASE("Light scattered behind an object is not visible") {
+    glm::vec3 sun       = getDirection(0.5F, 0.F);
+    glm::vec3 origin    = zenith * (groundRadius + 0.1F * parameters.mAtmosphereHeight);
+    glm::vec3 direction = getDirection(0.05F, 0.5F);
+    float     distance  = 0.5F * RayMarcher::intersectSphere(origin, direction, 1.F).y;
+
+    glm::vec3 expected = rayMarcher.getInscatter(origin, direction, 0.F, distance, true, sun);
+    glm::vec3 inscatter = tables->getInscatter(origin, direction, 0.F, distance, true, sun);
+
+    CHECK(getRelativeError(inscatter, expected) < 0.05F);
+  }
+
+  SUBCASE("Tables can be saved and loaded") {
+    std::string fileName = ScatteringTables::getCacheFileName(parameters);
+
+    CHECK(tables->save(fileName));
+
+    // Existing files are replaced, files in missing directories cannot be written.
+    CHECK(tables->save(fileName));
+    CHECK_FALSE(tables->save("./missing-directory/" + fileName));
+
+    auto loaded = ScatteringTables::load(fileName, parameters);
+    REQUIRE(loaded);
+    CHECK(loaded->getRayleighScattering() == tables->getRayleighScattering());
+    CHECK(loaded->getIrradiance() == tables->getIrradiance());
+
+    // Tables of other atmospheres are not used.
+    auto other = getEarthParameters(2);
+    CHECK(ScatteringTables::getCacheFileName(other) != fileName);
+    CHECK_FALSE(ScatteringTables::load(fileName, other));
+
+    std::remove(fileName.c_str());
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("csp::atmospheres::ScatteringTables multiple scattering") {
+  auto single   = ScatteringTables::generate(getEarthParameters(1));
+  auto multiple = ScatteringTables::generate(getEarthParameters(2));
+
+  glm::vec3 origin(0.F, 0.F, single->getBottomRadius());
+  glm::vec3 sun = getDirection(0.3F, 0.F);
+
+  for (float elevation : {1.5F, 0.5F, 0.1F}) {
+    glm::vec3 direction = getDirection(elevation, 2.F);
+    float     distance  = RayMarcher::intersectSphere(origin, direction, 1.F).y;
+
+    glm::vec3 a = single->getInscatter(origin, direction, 0.F, distance, false, sun);
+    glm::vec3 b = multiple->getInscatter(origin, direction, 0.F, distance, false, sun);
+
+    // Multiple scattering adds some light, especially in the blue channel.
+    CHECK(b.x >= a.x);
+    CHECK(b.z > a.z);
+    CHECK(b.z < 2.F * a.z);
+  }
+
+  // The sky is bright at day and dark at night.
+  glm::vec3 day   = multiple->getSkyIrradiance(single->getBottomRadius(), 1.F);
+  glm::vec3 night = multiple->getSkyIrradiance(single->getBottomRadius(), -0.5F);
+  CHECK(day.z > 0.01F);
+  CHECK(day.z < 1.F);
+  CHECK(night.z < 0.0001F);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("[benchmark] csp::atmospheres::ScatteringTables") {
+  auto start  = std::chrono::high_resolution_clock::now();
+  auto tables = ScatteringTables::generate(getEarthParameters(4));
+  auto end    = std::chrono::high_resolution_clock::now();
+
+  logger().info("Generated scattering tables with four scattering orders in {:.2f} s.",
+      std::chrono::duration<double>(end - start).count());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::atmospheres
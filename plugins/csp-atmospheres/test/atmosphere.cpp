@@ -63,7 +63,7 @@ TEST_CASE("[graphical] csp::atmospheres::Atmosphere") {
   // Create the atmosphere.
   auto settings           = std::make_shared<Plugin::Settings>();
   settings->mEnableClouds = false;
-  AtmosphereRenderer atmosphere(settings);
+  AtmosphereRenderer atmosphere(settings, std::make_shared<cs::graphics::AsyncTextureLoader>());
 
   atmosphere.setSun(glm::vec3(1, 0, 0), 15.0);
   atmosphere.setAtmosphereHeight(70.0 / 3460.0);
@@ -28,6 +28,8 @@ out VS_OUT
 
 void main(void)
 {
+    VP_forwardTileIndex();
+
     // all in view space
     vsOut.position       = VP_getVertexPosition(VP_iPosition, $TERRAIN_PROJECTION_TYPE);
     gl_Position = VP_matProjection * vec4(vsOut.position, 1);
@@ -4,6 +4,12 @@
 //                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+#ifdef VP_MULTI_DRAW
+// Index of the current tile in VP_tiles, see VP_forwardTileIndex().
+flat in int VP_vsTileIndex;
+#define VP_tileIndex VP_vsTileIndex
+#endif
+
 vec3 VP_getShadowMapCoords(int cascade, vec3 position)
 {
     vec4 smap_coords = VP_shadowProjectionViewMatrices[cascade] * vec4(position, 1.0);
@@ -17,6 +17,23 @@
 
 layout(location = 0) in ivec2 VP_iPosition;
 
+#ifdef VP_MULTI_DRAW
+// Index of the current tile in VP_tiles. This is an instanced attribute, the
+// base instance of each draw command selects the tile.
+layout(location = 1) in int VP_iTileIndex;
+flat out int VP_vsTileIndex;
+#define VP_tileIndex VP_iTileIndex
+#endif
+
+// Passes the index of the current tile on to the fragment shader. This has to
+// be called in the main function of every terrain vertex shader.
+void VP_forwardTileIndex()
+{
+#ifdef VP_MULTI_DRAW
+    VP_vsTileIndex = VP_iTileIndex;
+#endif
+}
+
 float VP_getJR(vec2 posXY)
 {
     return VP_f1f2.x - posXY.x - posXY.y;
@@ -236,8 +253,8 @@ vec3 VP_getVertexPositionInterpolated(ivec2 iPosition)
     vec2 alpha = vec2(iPosition) / VP_demOffsetScale.z;
 
     // calculate normal direction by slerping
-    vec3 normalSW = mix(VP_normals[2], VP_normals[1], alpha.y);
-    vec3 normalNE = mix(VP_normals[3], VP_normals[0], alpha.y);
+    vec3 normalSW = mix(VP_normals[2].xyz, VP_normals[1].xyz, alpha.y);
+    vec3 normalNE = mix(VP_normals[3].xyz, VP_normals[0].xyz, alpha.y);
     vec3 normal   = mix(normalSW, normalNE, alpha.x);
 
     // calculate height above surface
@@ -251,14 +268,14 @@ vec3 VP_getVertexPositionInterpolated(ivec2 iPosition)
     if (alpha.x + alpha.y < 1.0)
     {
         // southern triangle
-        result += VP_corners[2] + (VP_corners[3] - VP_corners[2]) * alpha.x
-                                + (VP_corners[1] - VP_corners[2]) * alpha.y;
+        result += VP_corners[2].xyz + (VP_corners[3].xyz - VP_corners[2].xyz) * alpha.x
+                                    + (VP_corners[1].xyz - VP_corners[2].xyz) * alpha.y;
     }
     else
     {
         // northern triangle
-        result += VP_corners[0] + (VP_corners[1] - VP_corners[0]) * (1-alpha.x)
-                                + (VP_corners[3] - VP_corners[0]) * (1-alpha.y);
+        result += VP_corners[0].xyz + (VP_corners[1].xyz - VP_corners[0].xyz) * (1-alpha.x)
+                                    + (VP_corners[3].xyz - VP_corners[0].xyz) * (1-alpha.y);
     }
 
     return result;
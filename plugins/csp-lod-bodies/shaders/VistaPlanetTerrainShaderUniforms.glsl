@@ -32,6 +32,48 @@ uniform sampler2DArray VP_texIMG;
 
 // uniforms - current tile -----------------------------------------------------
 
+#ifdef VP_MULTI_DRAW
+
+// If all tiles are drawn with a single glMultiDrawElementsIndirect, the
+// parameters of each tile are read from this buffer instead of the uniforms
+// below. VP_tileIndex is declared by the shader functions of each stage. The
+// layout has to match TileRenderer::TileData.
+struct VP_TileData
+{
+    vec4  corners[4];
+    vec4  normals[4];
+    ivec4 tileOffsetScale;
+    ivec4 demOffsetScale;
+    ivec4 imgOffsetScale;
+    ivec4 edgeDelta;
+    ivec4 edgeLayerDEM;
+    ivec4 edgeOffset;
+    ivec2 f1f2;
+    int   layerDEM;
+    int   layerIMG;
+    float demAverageHeight;
+};
+
+layout(std430, binding = 0) readonly buffer VP_TileBuffer
+{
+    VP_TileData VP_tiles[];
+};
+
+#define VP_demAverageHeight VP_tiles[VP_tileIndex].demAverageHeight
+#define VP_tileOffsetScale  VP_tiles[VP_tileIndex].tileOffsetScale.xyz
+#define VP_demOffsetScale   VP_tiles[VP_tileIndex].demOffsetScale.xyz
+#define VP_imgOffsetScale   VP_tiles[VP_tileIndex].imgOffsetScale.xyz
+#define VP_edgeDelta        VP_tiles[VP_tileIndex].edgeDelta
+#define VP_edgeLayerDEM     VP_tiles[VP_tileIndex].edgeLayerDEM
+#define VP_edgeOffset       VP_tiles[VP_tileIndex].edgeOffset
+#define VP_f1f2             VP_tiles[VP_tileIndex].f1f2
+#define VP_layerDEM         VP_tiles[VP_tileIndex].layerDEM
+#define VP_layerIMG         VP_tiles[VP_tileIndex].layerIMG
+#define VP_corners          VP_tiles[VP_tileIndex].corners
+#define VP_normals          VP_tiles[VP_tileIndex].normals
+
+#else
+
 uniform float VP_demAverageHeight;
 
 // offset (xy) and total number of patches (z) (relative to base patch)
@@ -63,8 +105,12 @@ uniform int VP_layerDEM;
 // layer of VP_texIMG the current patch's image data is stored in
 uniform int VP_layerIMG;
 
-uniform vec3 VP_corners[4];
-uniform vec3 VP_normals[4];
+// view space positions (xyz) of the tile's corners (N, W, S, E) and their
+// surface normals
+uniform vec4 VP_corners[4];
+uniform vec4 VP_normals[4];
+
+#endif
 
 // uniforms - shadow stuff -----------------------------------------------------
 uniform bool            VP_shadowMapMode;
@@ -13,9 +13,13 @@
 #include "TreeManagerBase.hpp"
 #include "logger.hpp"
 
+#include "../../../src/cs-utils/ThreadPool.hpp"
+
 #include <VistaBase/VistaStreamUtils.h>
 #include <glm/gtc/matrix_inverse.hpp>
 
+#include <algorithm>
+
 namespace csp::lodbodies {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -217,7 +221,9 @@ LODVisitor::LODVisitor(
     , mStackTop(-1)
     , mFrameCount(0)
     , mUpdateLOD(true)
-    , mUpdateCulling(true) {
+    , mUpdateCulling(true)
+    , mParallel(false)
+    , mIsWorker(false) {
   setTreeManagerDEM(treeMgrDEM);
   setTreeManagerIMG(treeMgrIMG);
 
@@ -226,7 +232,58 @@ LODVisitor::LODVisitor(
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+LODVisitor::~LODVisitor() {
+  // the pending traversal accesses this, but its exceptions are of no
+  // interest anymore
+  if (mPendingTraversal.valid()) {
+    mPendingTraversal.wait();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LODVisitor::visitAsync() {
+  wait();
+
+  if (!mAsyncThread) {
+    mAsyncThread = std::make_unique<cs::utils::ThreadPool>(1);
+  }
+
+  mPendingTraversal = mAsyncThread->enqueue([this]() { visit(); });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LODVisitor::wait() const {
+  if (mPendingTraversal.valid()) {
+    mPendingTraversal.get();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LODVisitor::hasPendingTraversal() const {
+  return mPendingTraversal.valid();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LODVisitor::setParallel(bool enable) {
+  wait();
+  mParallel = enable;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LODVisitor::getParallel() const {
+  return mParallel;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void LODVisitor::setTreeManagerDEM(TreeManagerBase* treeMgr) {
+  wait();
+
   // unset tree from OLD tree manager
   if (mTreeMgrDEM) {
     setTreeDEM(nullptr);
@@ -248,6 +305,8 @@ void LODVisitor::setTreeManagerDEM(TreeManagerBase* treeMgr) {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void LODVisitor::setTreeManagerIMG(TreeManagerBase* treeMgr) {
+  wait();
+
   // unset tree from OLD tree manager
   if (mTreeMgrIMG) {
     setTreeIMG(nullptr);
@@ -367,6 +426,43 @@ void LODVisitor::postTraverse() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void LODVisitor::visitRoots() {
+  if (!mParallel) {
+    TileVisitor<LODVisitor>::visitRoots();
+    return;
+  }
+
+  if (mWorkers.empty()) {
+    for (int i = 0; i < TileQuadTree::sNumRoots; ++i) {
+      mWorkers.push_back(std::make_unique<LODVisitor>(*mParams));
+    }
+  }
+
+  // traverse each base patch with a separate worker, all workers are
+  // finished before an exception is rethrown
+  for (auto const& worker : mWorkers) {
+    prepareWorker(*worker);
+  }
+
+  cs::utils::parallelFor(mWorkers.size(),
+      [this](std::size_t i) { mWorkers[i]->visitRoot(static_cast<int>(i)); });
+
+  // merge the lists of the workers in the order of the base patches and
+  // mark the used nodes in the same order as a serial traversal would do
+  for (auto const& worker : mWorkers) {
+    mLoadDEM.insert(mLoadDEM.end(), worker->mLoadDEM.begin(), worker->mLoadDEM.end());
+    mLoadIMG.insert(mLoadIMG.end(), worker->mLoadIMG.begin(), worker->mLoadIMG.end());
+    mRenderDEM.insert(mRenderDEM.end(), worker->mRenderDEM.begin(), worker->mRenderDEM.end());
+    mRenderIMG.insert(mRenderIMG.end(), worker->mRenderIMG.begin(), worker->mRenderIMG.end());
+
+    for (auto* rd : worker->mUsedRData) {
+      rd->setLastFrame(mFrameCount);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 bool LODVisitor::preVisitRoot(TileId const& tileId) {
   LODState& state = getLODState();
 
@@ -380,7 +476,7 @@ bool LODVisitor::preVisitRoot(TileId const& tileId) {
   if (mTreeMgrDEM && state.mNodeDEM) {
     auto* rd     = mTreeMgrDEM->find<RenderDataDEM>(state.mNodeDEM);
     state.mRdDEM = rd;
-    state.mRdDEM->setLastFrame(mFrameCount);
+    markUsed(state.mRdDEM);
   } else {
     state.mRdDEM = nullptr;
   }
@@ -389,7 +485,7 @@ bool LODVisitor::preVisitRoot(TileId const& tileId) {
   if (mTreeMgrIMG && state.mNodeIMG) {
     auto* rd     = mTreeMgrIMG->find<RenderDataImg>(state.mNodeIMG);
     state.mRdIMG = rd;
-    state.mRdIMG->setLastFrame(mFrameCount);
+    markUsed(state.mRdIMG);
   } else {
     state.mRdIMG = nullptr;
   }
@@ -421,7 +517,7 @@ bool LODVisitor::preVisit(TileId const& tileId) {
   if (mTreeMgrDEM && !state.mLastDEM && state.mNodeDEM) {
     auto* rd     = mTreeMgrDEM->find<RenderDataDEM>(state.mNodeDEM);
     state.mRdDEM = rd;
-    state.mRdDEM->setLastFrame(mFrameCount);
+    markUsed(state.mRdDEM);
   } else {
     // copy value from parent state to ensure this matches state.mLastDEM
     state.mRdDEM = stateP.mRdDEM;
@@ -431,7 +527,7 @@ bool LODVisitor::preVisit(TileId const& tileId) {
   if (mTreeMgrIMG && !state.mLastIMG && state.mNodeIMG) {
     auto* rd     = mTreeMgrIMG->find<RenderDataImg>(state.mNodeIMG);
     state.mRdIMG = rd;
-    state.mRdIMG->setLastFrame(mFrameCount);
+    markUsed(state.mRdIMG);
   } else {
     // copy value from parent state to ensure this matches state.mLastIMG
     state.mRdIMG = stateP.mRdIMG;
@@ -546,7 +642,7 @@ void LODVisitor::addLoadChildrenDEM(TileNode* node) {
         // mark child as used to avoid it being removed while waiting
         // for its siblings to be loaded
         RenderData* rd = mTreeMgrDEM->findRData(node->getChild(i));
-        rd->setLastFrame(mFrameCount);
+        markUsed(rd);
       }
     }
   }
@@ -565,7 +661,7 @@ void LODVisitor::addLoadChildrenIMG(TileNode* node) {
         // mark child as used to avoid it being removed while waiting
         // for its siblings to be loaded
         RenderData* rd = mTreeMgrIMG->findRData(node->getChild(i));
-        rd->setLastFrame(mFrameCount);
+        markUsed(rd);
       }
     }
   }
@@ -715,6 +811,37 @@ bool LODVisitor::testNeedRefine(TileId const& tileId) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void LODVisitor::markUsed(RenderData* rdata) {
+  if (mIsWorker) {
+    mUsedRData.push_back(rdata);
+  } else {
+    rdata->setLastFrame(mFrameCount);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LODVisitor::prepareWorker(LODVisitor& worker) const {
+  worker.mParams     = mParams;
+  worker.mTreeMgrDEM = mTreeMgrDEM;
+  worker.mTreeMgrIMG = mTreeMgrIMG;
+  worker.mTreeDEM    = mTreeDEM;
+  worker.mTreeIMG    = mTreeIMG;
+  worker.mLodData    = mLodData;
+  worker.mCullData   = mCullData;
+  worker.mFrameCount = mFrameCount;
+  worker.mIsWorker   = true;
+  worker.mStackTop   = -1;
+
+  worker.mLoadDEM.clear();
+  worker.mLoadIMG.clear();
+  worker.mRenderDEM.clear();
+  worker.mRenderIMG.clear();
+  worker.mUsedRData.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void LODVisitor::drawLevel() {
   LODState& state = getLODState();
 
@@ -759,6 +886,7 @@ int LODVisitor::getFrameCount() const {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void LODVisitor::setFrameCount(int frameCount) {
+  wait();
   mFrameCount = frameCount;
 }
 
@@ -771,6 +899,7 @@ glm::ivec4 const& LODVisitor::getViewport() const {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void LODVisitor::setViewport(glm::ivec4 const& vp) {
+  wait();
   mViewport = vp;
 }
 
@@ -783,6 +912,7 @@ glm::dmat4 const& LODVisitor::getModelview() const {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void LODVisitor::setModelview(glm::dmat4 const& m) {
+  wait();
   mMatVM = m;
 }
 
@@ -795,12 +925,14 @@ glm::dmat4 const& LODVisitor::getProjection() const {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void LODVisitor::setProjection(glm::dmat4 const& m) {
+  wait();
   mMatP = m;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void LODVisitor::setUpdateLOD(bool enable) {
+  wait();
   mUpdateLOD = enable;
 }
 
@@ -813,6 +945,7 @@ bool LODVisitor::getUpdateLOD() const {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void LODVisitor::setUpdateCulling(bool enable) {
+  wait();
   mUpdateCulling = enable;
 }
 
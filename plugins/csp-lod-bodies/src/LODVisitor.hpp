@@ -13,8 +13,14 @@
 #include "TileId.hpp"
 #include "TileVisitor.hpp"
 
+#include <future>
+#include <memory>
 #include <vector>
 
+namespace cs::utils {
+class ThreadPool;
+} // namespace cs::utils
+
 namespace csp::lodbodies {
 
 struct PlanetParameters;
@@ -24,11 +30,49 @@ class TreeManagerBase;
 
 /// Specialization of TileVisitor that determines the necessary level of detail for tiles and
 /// produces lists of tiles to load and draw respectively.
+///
+/// The subtrees of the twelve HEALPix base patches are independent of each other, so they can
+/// optionally be traversed concurrently (see setParallel()). Additionally, the traversal can be
+/// started on a background thread with visitAsync(), for example in order to select the tiles for
+/// the next frame while the current frame is being drawn.
 class LODVisitor : public TileVisitor<LODVisitor> {
  public:
   explicit LODVisitor(PlanetParameters const& params, TreeManagerBase* treeMgrDEM = nullptr,
       TreeManagerBase* treeMgrIMG = nullptr);
 
+  LODVisitor(LODVisitor const& other) = delete;
+  LODVisitor(LODVisitor&& other)      = delete;
+
+  LODVisitor& operator=(LODVisitor const& other) = delete;
+  LODVisitor& operator=(LODVisitor&& other) = delete;
+
+  /// Waits for a traversal started with visitAsync() to finish.
+  ~LODVisitor();
+
+  /// Starts a traversal like visit() but returns immediately, the traversal is performed on a
+  /// separate thread. Until wait() has been called, neither the results of the traversal may be
+  /// accessed nor the traversed trees may be modified. All setters of this class call wait()
+  /// implicitly. The traversal uses the camera set before this call; if the results are used for
+  /// a later frame, the tiles have been culled against the view frustum of this earlier camera.
+  void visitAsync();
+
+  /// Blocks until the traversal started with visitAsync() has finished. Exceptions thrown during
+  /// the traversal are rethrown here. Does nothing if there is no pending traversal. This is const
+  /// so that read-only users of the traversed trees can synchronize with the traversal, too.
+  void wait() const;
+
+  /// Returns true if visitAsync() has been called but wait() has not been called since.
+  bool hasPendingTraversal() const;
+
+  /// Controls whether the subtrees of the twelve base patches are traversed concurrently with
+  /// cs::utils::parallelFor(). Each subtree is traversed by a separate worker with its own load and
+  /// render lists; these are concatenated in the order of the base patches afterwards. The workers
+  /// do not mark nodes as used themselves, this is done after all workers have finished in the same
+  /// order as in a serial traversal. Hence the results are identical in both modes. Disabled by
+  /// default.
+  void setParallel(bool enable);
+  bool getParallel() const;
+
   TreeManagerBase* getTreeManagerDEM() const;
   void             setTreeManagerDEM(TreeManagerBase* treeMgr);
 
@@ -107,6 +151,7 @@ class LODVisitor : public TileVisitor<LODVisitor> {
 
   bool preTraverse() override;
   void postTraverse() override;
+  void visitRoots() override;
 
   bool preVisitRoot(TileId const& tileId) override;
   void postVisitRoot(TileId const& tileId) override;
@@ -143,6 +188,13 @@ class LODVisitor : public TileVisitor<LODVisitor> {
 
   void drawLevel();
 
+  /// Marks rdata as used in the current frame. The workers of a parallel traversal must not modify
+  /// the TreeManagerBase, they only store rdata in mUsedRData.
+  void markUsed(RenderData* rdata);
+
+  /// Copies the current frame's LOD and culling data to worker and clears its lists.
+  void prepareWorker(LODVisitor& worker) const;
+
   friend class TileVisitor<LODVisitor>;
 
   static std::size_t const sMaxStackDepth = 32;
@@ -168,6 +220,18 @@ class LODVisitor : public TileVisitor<LODVisitor> {
   int  mFrameCount;
   bool mUpdateLOD;
   bool mUpdateCulling;
+  bool mParallel;
+  bool mIsWorker;
+
+  /// The workers of a parallel traversal, one for each base patch. These are created on demand.
+  std::vector<std::unique_ptr<LODVisitor>> mWorkers;
+
+  /// The RenderData used during the traversal of a worker.
+  std::vector<RenderData*> mUsedRData;
+
+  /// A single thread running the traversals started with visitAsync().
+  std::unique_ptr<cs::utils::ThreadPool> mAsyncThread;
+  mutable std::future<void>              mPendingTraversal;
 };
 
 } // namespace csp::lodbodies
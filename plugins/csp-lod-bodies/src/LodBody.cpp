@@ -69,6 +69,19 @@ LodBody::LodBody(std::shared_ptr<cs::core::Settings> const& settings,
     mPlanet.getLODVisitor().setUpdateCulling(!val);
   });
 
+  mPluginSettings->mParallelTraversal.connectAndTouch(
+      [this](bool val) { mPlanet.setParallelTraversal(val); });
+
+  mPluginSettings->mPipelinedTraversal.connectAndTouch(
+      [this](bool val) { mPlanet.setPipelinedTraversal(val); });
+
+  mPluginSettings->mMultiDrawIndirect.connectAndTouch(
+      [this](bool val) { mPlanet.getTileRenderer().setMultiDrawIndirect(val); });
+
+  mPluginSettings->mMemoryCacheSize.connectAndTouch([this](uint32_t val) {
+    mPlanet.setMemoryCacheSize(static_cast<uint64_t>(val) * 1024 * 1024);
+  });
+
   // Add to scenegraph.
   VistaSceneGraph* pSG = GetVistaSystem()->GetGraphicsManager()->GetSceneGraph();
   mGLNode.reset(pSG->NewOpenGLNode(pSG->GetRoot(), this));
@@ -113,6 +126,13 @@ double LodBody::getHeight(glm::dvec2 lngLat) const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void LodBody::getHeights(
+    std::vector<glm::dvec2> const& lngLats, std::vector<double>& heights) const {
+  utils::getHeights(&mPlanet, HeightSamplePrecision::eActual, lngLats, heights);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 glm::dvec3 LodBody::getRadii() const {
   return mRadii;
 }
@@ -75,6 +75,9 @@ class LodBody : public cs::scene::CelestialBody, public IVistaOpenGLDraw {
   double     getHeight(glm::dvec2 lngLat) const override;
   glm::dvec3 getRadii() const override;
 
+  void getHeights(
+      std::vector<glm::dvec2> const& lngLats, std::vector<double>& heights) const override;
+
   void update(double tTime, cs::scene::CelestialObserver const& oObs) override;
 
   bool Do() override;
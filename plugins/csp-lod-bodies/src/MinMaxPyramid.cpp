@@ -7,157 +7,180 @@
 #include "MinMaxPyramid.hpp"
 #include "Tile.hpp"
 
+#include <algorithm>
+#include <array>
+
 namespace csp::lodbodies {
 
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The index of the first cell of each level.
+constexpr std::array<std::size_t, MinMaxPyramid::sLevels + 1> getLevelOffsets() {
+  std::array<std::size_t, MinMaxPyramid::sLevels + 1> offsets{};
+
+  for (int level = 0; level < MinMaxPyramid::sLevels; ++level) {
+    std::size_t size      = 128 >> level;
+    offsets.at(level + 1) = offsets.at(level) + size * size;
+  }
+
+  return offsets;
+}
+
+constexpr std::array<std::size_t, MinMaxPyramid::sLevels + 1> cLevelOffsets = getLevelOffsets();
+
+static_assert(cLevelOffsets.back() == MinMaxPyramid::sCellCount);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 MinMaxPyramid::MinMaxPyramid()
-    : mMinPyramid(7, std::vector<float>())
-    , mMaxPyramid(7, std::vector<float>()) {
-  mMinPyramid[0] = std::vector<float>(128 * 128, std::numeric_limits<float>::max());
-  mMinPyramid[1] = std::vector<float>(64 * 64, std::numeric_limits<float>::max());
-  mMinPyramid[2] = std::vector<float>(32 * 32, std::numeric_limits<float>::max());
-  mMinPyramid[3] = std::vector<float>(16 * 16, std::numeric_limits<float>::max());
-  mMinPyramid[4] = std::vector<float>(8 * 8, std::numeric_limits<float>::max());
-  mMinPyramid[5] = std::vector<float>(4 * 4, std::numeric_limits<float>::max());
-  mMinPyramid[6] = std::vector<float>(2 * 2, std::numeric_limits<float>::max());
-
-  mMaxPyramid[0] = std::vector<float>(128 * 128, -std::numeric_limits<float>::max());
-  mMaxPyramid[1] = std::vector<float>(64 * 64, -std::numeric_limits<float>::max());
-  mMaxPyramid[2] = std::vector<float>(32 * 32, -std::numeric_limits<float>::max());
-  mMaxPyramid[3] = std::vector<float>(16 * 16, -std::numeric_limits<float>::max());
-  mMaxPyramid[4] = std::vector<float>(8 * 8, -std::numeric_limits<float>::max());
-  mMaxPyramid[5] = std::vector<float>(4 * 4, -std::numeric_limits<float>::max());
-  mMaxPyramid[6] = std::vector<float>(2 * 2, -std::numeric_limits<float>::max());
+    : mData(sCellCount * 2, std::numeric_limits<float>::max()) {
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-MinMaxPyramid::MinMaxPyramid(Tile<float>* tile)
-    : mMinPyramid(7, std::vector<float>())
-    , mMaxPyramid(7, std::vector<float>()) {
-  mMinPyramid[0] = std::vector<float>(128 * 128, std::numeric_limits<float>::max());
-  mMinPyramid[1] = std::vector<float>(64 * 64, std::numeric_limits<float>::max());
-  mMinPyramid[2] = std::vector<float>(32 * 32, std::numeric_limits<float>::max());
-  mMinPyramid[3] = std::vector<float>(16 * 16, std::numeric_limits<float>::max());
-  mMinPyramid[4] = std::vector<float>(8 * 8, std::numeric_limits<float>::max());
-  mMinPyramid[5] = std::vector<float>(4 * 4, std::numeric_limits<float>::max());
-  mMinPyramid[6] = std::vector<float>(2 * 2, std::numeric_limits<float>::max());
-
-  mMaxPyramid[0] = std::vector<float>(128 * 128, -std::numeric_limits<float>::max());
-  mMaxPyramid[1] = std::vector<float>(64 * 64, -std::numeric_limits<float>::max());
-  mMaxPyramid[2] = std::vector<float>(32 * 32, -std::numeric_limits<float>::max());
-  mMaxPyramid[3] = std::vector<float>(16 * 16, -std::numeric_limits<float>::max());
-  mMaxPyramid[4] = std::vector<float>(8 * 8, -std::numeric_limits<float>::max());
-  mMaxPyramid[5] = std::vector<float>(4 * 4, -std::numeric_limits<float>::max());
-  mMaxPyramid[6] = std::vector<float>(2 * 2, -std::numeric_limits<float>::max());
-
-  int HalfSizeX = static_cast<int32_t>((TileBase::SizeX - 1) * 0.5); // 128
-  int x2        = 0;                                                 // 0..128
-  int y2        = 0;                                                 // 0..128
-
-  for (int y = 0; y < TileBase::SizeY; ++y) {
-    x2 = 0;
-    for (int x = 0; x < TileBase::SizeX; ++x) {
-      float const v = tile->data()[y * TileBase::SizeX + x];
-
-      mMinValue = std::min(mMinValue, v);
-      mMaxValue = std::max(mMaxValue, v);
-      mAvgValue += v / (TileBase::SizeY * TileBase::SizeY);
-
-      // Construct first 128x128 MinMaxPyramid layer by sampling 256x256 values
-      x2                                  = std::min(x2, 127);
-      y2                                  = std::min(y2, 127);
-      mMinPyramid[0][y2 * HalfSizeX + x2] = std::min(mMinPyramid[0][y2 * HalfSizeX + x2], v);
-      mMaxPyramid[0][y2 * HalfSizeX + x2] = std::max(mMaxPyramid[0][y2 * HalfSizeX + x2], v);
-
-      // 256 -> 128
-      if (x % 2 == 1) {
-        x2 += 1;
+MinMaxPyramid::MinMaxPyramid(Tile<float>* tile, std::shared_ptr<MinMaxPyramidArena> arena)
+    : mData(arena ? arena->acquire() : std::vector<float>(sCellCount * 2))
+    , mArena(std::move(arena)) {
+
+  // All loops below operate on contiguous rows and only use element-wise minimum and maximum
+  // operations, so that they can be vectorized by the compiler.
+  std::array<float, TileBase::SizeX>  rowMin{};
+  std::array<float, TileBase::SizeX>  rowMax{};
+  std::array<double, TileBase::SizeX> columnSums{};
+
+  float const* samples = tile->data().data();
+  int const    size    = getLevelSize(0);
+
+  // Construct the first 128x128 layer from the 257x257 samples. The last row of cells also covers
+  // the last row of samples.
+  for (int y = 0; y < size; ++y) {
+    int const rows = y == size - 1 ? 3 : 2;
+
+    for (int r = 0; r < rows; ++r) {
+      float const* row = samples + (2 * y + r) * TileBase::SizeX;
+
+      if (r == 0) {
+        std::copy(row, row + TileBase::SizeX, rowMin.begin());
+        std::copy(row, row + TileBase::SizeX, rowMax.begin());
+      } else {
+        for (int x = 0; x < TileBase::SizeX; ++x) {
+          float const value = row[x];
+          rowMin[x]         = std::min(rowMin[x], value);
+          rowMax[x]         = std::max(rowMax[x], value);
+        }
+      }
+
+      for (int x = 0; x < TileBase::SizeX; ++x) {
+        columnSums[x] += row[x];
       }
     }
 
-    // 256 -> 128
-    if (y % 2 == 1) {
-      y2 += 1;
+    // The same goes for the last column.
+    float* cells = mData.data() + 2 * size * y;
+
+    for (int x = 0; x < size; ++x) {
+      cells[2 * x]     = std::min(rowMin[2 * x], rowMin[2 * x + 1]);
+      cells[2 * x + 1] = -std::max(rowMax[2 * x], rowMax[2 * x + 1]);
     }
+
+    cells[2 * size - 2] = std::min(cells[2 * size - 2], rowMin[TileBase::SizeX - 1]);
+    cells[2 * size - 1] = std::min(cells[2 * size - 1], -rowMax[TileBase::SizeX - 1]);
   }
 
-  // Build remaining MinMaxPyramid layers 64x62-2x2
-  for (int i(1); i < 7; ++i) {
-    y2 = 0;
-    for (int y = 0; y < (TileBase::SizeY - 1) * std::pow(0.5, i); ++y) {
-      x2 = 0;
-      for (int x = 0; x < (TileBase::SizeX - 1) * std::pow(0.5, i); ++x) {
-        mMinPyramid[i][static_cast<uint64_t>(y2 * HalfSizeX * std::pow(0.5, i) + x2)] = std::min(
-            mMinPyramid[i - 1]
-                       [static_cast<uint64_t>(y * (TileBase::SizeX - 1) * std::pow(0.5, i) + x)],
-            mMinPyramid[i][static_cast<uint64_t>(y2 * HalfSizeX * std::pow(0.5, i) + x2)]);
-        mMaxPyramid[i][static_cast<uint64_t>(y2 * HalfSizeX * std::pow(0.5, i) + x2)] = std::max(
-            mMaxPyramid[i - 1]
-                       [static_cast<uint64_t>(y * (TileBase::SizeX - 1) * std::pow(0.5, i) + x)],
-            mMaxPyramid[i][static_cast<uint64_t>(y2 * HalfSizeX * std::pow(0.5, i) + x2)]);
-        if (x % 2 == 1) {
-          x2 += 1;
-        }
-      }
-      if (y % 2 == 1) {
-        y2 += 1;
+  // Build the remaining layers 64x64 to 2x2. As the maxima are stored negated, each pair of cell
+  // values is reduced with the minimum of the four corresponding pairs in the finer layer.
+  for (int level = 1; level < sLevels; ++level) {
+    int const    levelSize = getLevelSize(level);
+    float const* src       = mData.data() + 2 * cLevelOffsets.at(level - 1);
+    float*       dst       = mData.data() + 2 * cLevelOffsets.at(level);
+
+    for (int y = 0; y < levelSize; ++y) {
+      float const* row0 = src + 8 * levelSize * y;
+      float const* row1 = row0 + 4 * levelSize;
+      float*       out  = dst + 2 * levelSize * y;
+
+      for (int x = 0; x < levelSize; ++x) {
+        float const min0 = std::min(row0[4 * x], row1[4 * x]);
+        float const min1 = std::min(row0[4 * x + 2], row1[4 * x + 2]);
+        float const max0 = std::min(row0[4 * x + 1], row1[4 * x + 1]);
+        float const max1 = std::min(row0[4 * x + 3], row1[4 * x + 3]);
+        out[2 * x]       = std::min(min0, min1);
+        out[2 * x + 1]   = std::min(max0, max1);
       }
     }
   }
+
+  float const* top = mData.data() + 2 * cLevelOffsets.at(sLevels - 1);
+  mMinValue        = std::min({top[0], top[2], top[4], top[6]});
+  mMaxValue        = -std::min({top[1], top[3], top[5], top[7]});
+
+  double sum = 0.0;
+  for (double columnSum : columnSums) {
+    sum += columnSum;
+  }
+
+  mAvgValue = static_cast<float>(sum / (TileBase::SizeX * TileBase::SizeY));
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 MinMaxPyramid::~MinMaxPyramid() {
-  for (int layer(0); layer < 7; ++layer) {
-    mMinPyramid[layer].clear();
-    mMaxPyramid[layer].clear();
+  if (mArena && mData.size() == sCellCount * 2) {
+    mArena->release(std::move(mData));
   }
-
-  mMinPyramid.clear();
-  mMaxPyramid.clear();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-std::vector<std::vector<float>>& MinMaxPyramid::getMinPyramid() {
-  return mMinPyramid;
+float MinMaxPyramid::getMin(int level, int x, int y) const {
+  return mData[2 * (cLevelOffsets.at(level) + y * getLevelSize(level) + x)];
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-std::vector<std::vector<float>>& MinMaxPyramid::getMaxPyramid() {
-  return mMaxPyramid;
+float MinMaxPyramid::getMax(int level, int x, int y) const {
+  return -mData[2 * (cLevelOffsets.at(level) + y * getLevelSize(level) + x) + 1];
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-float MinMaxPyramid::getMin(std::vector<int> const& quadrants) {
-  return getData(mMinPyramid, quadrants);
+float MinMaxPyramid::getMin(std::vector<int> const& quadrants) const {
+  if (quadrants.empty()) {
+    return mMinValue;
+  }
+
+  return mData[getIndex(quadrants)];
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-float MinMaxPyramid::getMax(std::vector<int> const& quadrants) {
-  return getData(mMaxPyramid, quadrants);
+float MinMaxPyramid::getMax(std::vector<int> const& quadrants) const {
+  if (quadrants.empty()) {
+    return mMaxValue;
+  }
+
+  return -mData[getIndex(quadrants) + 1];
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-float MinMaxPyramid::getData(
-    std::vector<std::vector<float>>& pyramid, std::vector<int> const& quadrants) {
+std::size_t MinMaxPyramid::getIndex(std::vector<int> const& quadrants) {
   // number of pyramid levels:
-  auto qSize = quadrants.size();
+  int qSize = static_cast<int>(quadrants.size());
   // particular pyramid layer,
   // where min max information of the corresponding tile resolution is stored
-  auto layerId = 7 - qSize;
+  int layerId = sLevels - qSize;
   // pyramid layer address of searched value
   int x(0);
   int y(0);
-  for (size_t i(0); i < qSize; ++i) {
-    int step = int(std::pow(2, qSize - (i + 1)));
+  for (int i(0); i < qSize; ++i) {
+    int step = 1 << (qSize - (i + 1));
     switch (quadrants[i]) {
     case 1:
       x += step;
@@ -172,7 +195,44 @@ float MinMaxPyramid::getData(
     }
   }
 
-  return pyramid[layerId][int(y * std::pow(2, qSize) + x)];
+  return 2 * (cLevelOffsets.at(layerId) + (y << qSize) + x);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+MinMaxPyramidArena::MinMaxPyramidArena(std::size_t capacity)
+    : mCapacity(capacity) {
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<float> MinMaxPyramidArena::acquire() {
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    if (!mFree.empty()) {
+      std::vector<float> data = std::move(mFree.back());
+      mFree.pop_back();
+      return data;
+    }
+  }
+
+  return std::vector<float>(MinMaxPyramid::sCellCount * 2);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void MinMaxPyramidArena::release(std::vector<float>&& data) {
+  std::unique_lock<std::mutex> lock(mMutex);
+  if (mFree.size() < mCapacity) {
+    mFree.push_back(std::move(data));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t MinMaxPyramidArena::getFreeCount() const {
+  std::unique_lock<std::mutex> lock(mMutex);
+  return mFree.size();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -7,7 +7,10 @@
 #ifndef CSP_LOD_BODIES_MINMAXPYRAMID_HPP
 #define CSP_LOD_BODIES_MINMAXPYRAMID_HPP
 
+#include <cstddef>
 #include <limits>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 namespace csp::lodbodies {
@@ -15,13 +18,31 @@ namespace csp::lodbodies {
 template <typename T>
 class Tile;
 
+class MinMaxPyramidArena;
+
 /// The MinMaxPyramid is a data structure for finding lod data in constant time. It's similar
 /// to a quad tree but it contains precomputed min and max values at each level.
+///
+/// Level 0 has 128x128 cells, each covering 2x2 samples of the tile (the cells in the last row and
+/// column cover the last three samples). Each following level halves the resolution down to 2x2
+/// cells. All levels are stored in one contiguous allocation. For each cell, the minimum is
+/// directly followed by the negated maximum; this way, all levels can be built with element-wise
+/// minimum operations only, which the compiler turns into SIMD instructions.
 class MinMaxPyramid {
 
  public:
+  /// The number of levels of the pyramid.
+  static int const sLevels = 7;
+
+  /// The number of cells of all levels together: 128² + 64² + ... + 2².
+  static std::size_t const sCellCount = 21844;
+
   MinMaxPyramid();
-  explicit MinMaxPyramid(Tile<float>* tile);
+
+  /// Builds the pyramid for the given tile. If an arena is given, the memory is taken from it and
+  /// returned to it once the pyramid is destroyed.
+  explicit MinMaxPyramid(
+      Tile<float>* tile, std::shared_ptr<MinMaxPyramidArena> arena = nullptr);
 
   MinMaxPyramid(MinMaxPyramid const& other) = default;
   MinMaxPyramid(MinMaxPyramid&& other)      = default;
@@ -31,8 +52,15 @@ class MinMaxPyramid {
 
   virtual ~MinMaxPyramid();
 
-  std::vector<std::vector<float>>& getMinPyramid();
-  std::vector<std::vector<float>>& getMaxPyramid();
+  /// Returns the number of cells in x and y direction of the given level.
+  static int getLevelSize(int level) {
+    return 128 >> level;
+  }
+
+  /// Returns the minimum / maximum value of the given cell. Level 0 is the finest level, x and y
+  /// must be smaller than getLevelSize(level).
+  float getMin(int level, int x, int y) const;
+  float getMax(int level, int x, int y) const;
 
   /// Returns the minimum value in the given quadrant.
   ///
@@ -54,13 +82,13 @@ class MinMaxPyramid {
   /// 49  50  51  52  53  54  55  56
   /// 57  58  59  60  61  62  63  64
   /// @endcode
-  float getMin(std::vector<int> const& quadrants);
+  float getMin(std::vector<int> const& quadrants) const;
   float getMin() const {
     return mMinValue;
   }
 
   /// Returns the maximum value in the given quadrant.
-  float getMax(std::vector<int> const& quadrants);
+  float getMax(std::vector<int> const& quadrants) const;
   float getMax() const {
     return mMaxValue;
   }
@@ -71,17 +99,51 @@ class MinMaxPyramid {
   }
 
  protected:
-  static float getData(std::vector<std::vector<float>>& pyramid, std::vector<int> const& quadrants);
+  /// Returns the index of the minimum of the cell addressed by the given quadrants in mData. The
+  /// negated maximum is stored right after it.
+  static std::size_t getIndex(std::vector<int> const& quadrants);
 
  private:
-  std::vector<std::vector<float>> mMinPyramid;
-  std::vector<std::vector<float>> mMaxPyramid;
+  std::vector<float>                  mData;
+  std::shared_ptr<MinMaxPyramidArena> mArena;
 
   float mMinValue = std::numeric_limits<float>::max();
   float mMaxValue = std::numeric_limits<float>::lowest();
   float mAvgValue = 0.F;
 };
 
+/// The MinMaxPyramidArena recycles the memory of destroyed MinMaxPyramids. Each TreeManagerBase
+/// owns one and passes it to its TileSource, so that the pyramids of newly loaded tiles reuse the
+/// memory of pruned tiles instead of allocating fresh memory for each tile. All methods are
+/// thread-safe.
+class MinMaxPyramidArena {
+ public:
+  /// At most capacity unused allocations are kept.
+  explicit MinMaxPyramidArena(std::size_t capacity = 64);
+
+  MinMaxPyramidArena(MinMaxPyramidArena const& other) = delete;
+  MinMaxPyramidArena(MinMaxPyramidArena&& other)      = delete;
+
+  MinMaxPyramidArena& operator=(MinMaxPyramidArena const& other) = delete;
+  MinMaxPyramidArena& operator=(MinMaxPyramidArena&& other) = delete;
+
+  ~MinMaxPyramidArena() = default;
+
+  /// Returns memory for MinMaxPyramid::sCellCount cells. The content is undefined.
+  std::vector<float> acquire();
+
+  /// Takes back memory which has been returned by acquire() before.
+  void release(std::vector<float>&& data);
+
+  /// Returns the number of currently unused allocations.
+  std::size_t getFreeCount() const;
+
+ private:
+  mutable std::mutex              mMutex;
+  std::vector<std::vector<float>> mFree;
+  std::size_t                     mCapacity;
+};
+
 } // namespace csp::lodbodies
 
 #endif // CSP_LOD_BODIES_MINMAXPYRAMID_HPP
@@ -7,6 +7,7 @@
 #include "Plugin.hpp"
 
 #include "LodBody.hpp"
+#include "TileSourceLocalRaster.hpp"
 #include "logger.hpp"
 
 #include "../../../src/cs-core/GuiManager.hpp"
@@ -112,10 +113,15 @@ void from_json(nlohmann::json const& j, Plugin::Settings& o) {
   cs::core::Settings::deserialize(j, "enableWireframe", o.mEnableWireframe);
   cs::core::Settings::deserialize(j, "enableTilesDebug", o.mEnableTilesDebug);
   cs::core::Settings::deserialize(j, "enableTilesFreeze", o.mEnableTilesFreeze);
+  cs::core::Settings::deserialize(j, "parallelTraversal", o.mParallelTraversal);
+  cs::core::Settings::deserialize(j, "pipelinedTraversal", o.mPipelinedTraversal);
+  cs::core::Settings::deserialize(j, "multiDrawIndirect", o.mMultiDrawIndirect);
   cs::core::Settings::deserialize(j, "maxGPUTilesColor", o.mMaxGPUTilesColor);
   cs::core::Settings::deserialize(j, "maxGPUTilesGray", o.mMaxGPUTilesGray);
   cs::core::Settings::deserialize(j, "maxGPUTilesDEM", o.mMaxGPUTilesDEM);
   cs::core::Settings::deserialize(j, "mapCache", o.mMapCache);
+  cs::core::Settings::deserialize(j, "mapCacheSize", o.mMapCacheSize);
+  cs::core::Settings::deserialize(j, "memoryCacheSize", o.mMemoryCacheSize);
   cs::core::Settings::deserialize(j, "bodies", o.mBodies);
 }
 
@@ -134,10 +140,15 @@ void to_json(nlohmann::json& j, Plugin::Settings const& o) {
   cs::core::Settings::serialize(j, "enableWireframe", o.mEnableWireframe);
   cs::core::Settings::serialize(j, "enableTilesDebug", o.mEnableTilesDebug);
   cs::core::Settings::serialize(j, "enableTilesFreeze", o.mEnableTilesFreeze);
+  cs::core::Settings::serialize(j, "parallelTraversal", o.mParallelTraversal);
+  cs::core::Settings::serialize(j, "pipelinedTraversal", o.mPipelinedTraversal);
+  cs::core::Settings::serialize(j, "multiDrawIndirect", o.mMultiDrawIndirect);
   cs::core::Settings::serialize(j, "maxGPUTilesColor", o.mMaxGPUTilesColor);
   cs::core::Settings::serialize(j, "maxGPUTilesGray", o.mMaxGPUTilesGray);
   cs::core::Settings::serialize(j, "maxGPUTilesDEM", o.mMaxGPUTilesDEM);
   cs::core::Settings::serialize(j, "mapCache", o.mMapCache);
+  cs::core::Settings::serialize(j, "mapCacheSize", o.mMapCacheSize);
+  cs::core::Settings::serialize(j, "memoryCacheSize", o.mMemoryCacheSize);
   cs::core::Settings::serialize(j, "bodies", o.mBodies);
 }
 
@@ -396,6 +407,20 @@ void Plugin::init() {
     }
   });
 
+  mPluginSettings->mMapCacheSize.connect([this](uint32_t val) {
+    for (auto&& body : mLodBodies) {
+      auto src =
+          std::dynamic_pointer_cast<TileSourceWebMapService>(body.second->getDEMtileSource());
+      if (src) {
+        src->setCacheSize(static_cast<uint64_t>(val) * 1024 * 1024);
+      }
+      src = std::dynamic_pointer_cast<TileSourceWebMapService>(body.second->getIMGtileSource());
+      if (src) {
+        src->setCacheSize(static_cast<uint64_t>(val) * 1024 * 1024);
+      }
+    }
+  });
+
   onLoad();
 
   logger().info("Loading done.");
@@ -562,6 +587,29 @@ Plugin::Settings::Body& Plugin::getBodySettings(std::shared_ptr<LodBody> const&
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+std::shared_ptr<TileSource> Plugin::createTileSource(Settings::Dataset const& dataset) const {
+  std::string const fileScheme = "file://";
+
+  if (dataset.mURL.rfind(fileScheme, 0) == 0) {
+    auto source = std::make_shared<TileSourceLocalRaster>();
+    source->setFile(dataset.mURL.substr(fileScheme.size()));
+    source->setMaxLevel(dataset.mMaxLevel);
+    source->setDataType(dataset.mFormat);
+    return source;
+  }
+
+  auto source = std::make_shared<TileSourceWebMapService>();
+  source->setCacheDirectory(mPluginSettings->mMapCache.get());
+  source->setCacheSize(static_cast<uint64_t>(mPluginSettings->mMapCacheSize.get()) * 1024 * 1024);
+  source->setMaxLevel(dataset.mMaxLevel);
+  source->setLayers(dataset.mLayers);
+  source->setUrl(dataset.mURL);
+  source->setDataType(dataset.mFormat);
+  return source;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void Plugin::setImageSource(std::shared_ptr<LodBody> const& body, std::string const& name) const {
   auto& settings             = getBodySettings(body);
   settings.mActiveImgDataset = name;
@@ -578,14 +626,7 @@ void Plugin::setImageSource(std::shared_ptr<LodBody> const& body, std::string co
       dataset = settings.mImgDatasets.begin();
     }
 
-    auto source = std::make_shared<TileSourceWebMapService>();
-    source->setCacheDirectory(mPluginSettings->mMapCache.get());
-    source->setMaxLevel(dataset->second.mMaxLevel);
-    source->setLayers(dataset->second.mLayers);
-    source->setUrl(dataset->second.mURL);
-    source->setDataType(dataset->second.mFormat);
-
-    body->setIMGtileSource(source);
+    body->setIMGtileSource(createTileSource(dataset->second));
 
     mGuiManager->getGui()->callJavascript(
         "CosmoScout.lodBodies.setMapDataCopyright", dataset->second.mCopyright);
@@ -608,14 +649,7 @@ void Plugin::setElevationSource(
 
   settings.mActiveDemDataset = name;
 
-  auto source = std::make_shared<TileSourceWebMapService>();
-  source->setCacheDirectory(mPluginSettings->mMapCache.get());
-  source->setMaxLevel(dataset->second.mMaxLevel);
-  source->setLayers(dataset->second.mLayers);
-  source->setUrl(dataset->second.mURL);
-  source->setDataType(dataset->second.mFormat);
-
-  body->setDEMtileSource(source);
+  body->setDEMtileSource(createTileSource(dataset->second));
 
   mGuiManager->getGui()->callJavascript(
       "CosmoScout.lodBodies.setElevationDataCopyright", dataset->second.mCopyright);
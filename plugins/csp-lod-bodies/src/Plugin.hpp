@@ -83,6 +83,18 @@ class Plugin : public cs::core::PluginBase {
     /// be updated anymore.
     cs::utils::DefaultProperty<bool> mEnableTilesFreeze{false};
 
+    /// If set to true, the tile quad trees of the twelve base patches are traversed in parallel.
+    cs::utils::DefaultProperty<bool> mParallelTraversal{false};
+
+    /// If set to true, the tiles for the next frame are selected on a background thread while the
+    /// current frame is being drawn. This adds one frame of latency to level-of-detail changes and
+    /// to frustum culling. It has no effect while shadows are enabled.
+    cs::utils::DefaultProperty<bool> mPipelinedTraversal{false};
+
+    /// If set to true, all tiles of a body are drawn with a single glMultiDrawElementsIndirect.
+    /// Else, each tile is drawn separately. This requires OpenGL 4.3.
+    cs::utils::DefaultProperty<bool> mMultiDrawIndirect{true};
+
     /// The maximum allowed colored tiles.
     cs::utils::DefaultProperty<uint32_t> mMaxGPUTilesColor{512};
 
@@ -95,6 +107,14 @@ class Plugin : public cs::core::PluginBase {
     /// Path to the map cache folder, can be absolute or relative to the cosmoscout executable.
     cs::utils::DefaultProperty<std::string> mMapCache{"map-cache"};
 
+    /// The maximum size of the map cache of each data set in megabytes. If a data set exceeds this
+    /// size, the least recently used tiles are removed.
+    cs::utils::DefaultProperty<uint32_t> mMapCacheSize{4096};
+
+    /// The maximum size of the compressed tiles of each data set in megabytes which are kept in
+    /// memory after they have been removed from the tile quad trees. Zero disables this cache.
+    cs::utils::DefaultProperty<uint32_t> mMemoryCacheSize{256};
+
     /// A single data set containing either elevation or image data.
     struct Dataset {
       std::string  mURL;        ///< The URL of the mapserver including the "SERVICE=wms" parameter.
@@ -124,6 +144,11 @@ class Plugin : public cs::core::PluginBase {
   void onLoad();
 
   Settings::Body& getBodySettings(std::shared_ptr<LodBody> const& body) const;
+
+  /// Creates a TileSourceLocalRaster if the URL of the data set starts with "file://", else a
+  /// TileSourceWebMapService is created.
+  std::shared_ptr<TileSource> createTileSource(Settings::Dataset const& dataset) const;
+
   void setImageSource(std::shared_ptr<LodBody> const& body, std::string const& name) const;
   void setElevationSource(std::shared_ptr<LodBody> const& body, std::string const& name) const;
 
@@ -6,6 +6,7 @@
 
 #include "RenderData.hpp"
 
+#include "RenderDataLRU.hpp"
 #include "TileNode.hpp"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -15,7 +16,11 @@ namespace csp::lodbodies {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 /* virtual */
-RenderData::~RenderData() = default;
+RenderData::~RenderData() {
+  if (mLru) {
+    mLru->remove(this);
+  }
+}
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -105,6 +110,10 @@ int RenderData::getLastFrame() const {
 
 void RenderData::setLastFrame(int frame) {
   mLastFrame = frame;
+
+  if (mLru) {
+    mLru->moveToFront(this);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
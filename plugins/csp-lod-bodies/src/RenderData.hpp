@@ -15,6 +15,8 @@
 
 namespace csp::lodbodies {
 
+class RenderDataLRU;
+
 /// The base class for all render data of a single TileNode.
 class RenderData : private boost::noncopyable {
  public:
@@ -35,9 +37,13 @@ class RenderData : private boost::noncopyable {
   int  getTexLayer() const;
   void setTexLayer(int layer);
 
-  int  getLastFrame() const;
+  int getLastFrame() const;
+
+  /// Marks the data as used in the given frame. If the data is linked into a RenderDataLRU, it is
+  /// moved to the front of that list. Therefore, frame should be the current frame number.
   void setLastFrame(int frame);
-  int  getAge(int frame) const;
+
+  int getAge(int frame) const;
 
   BoundingBox<double> const& getBounds() const;
   void                       setBounds(BoundingBox<double> const& tb);
@@ -50,9 +56,15 @@ class RenderData : private boost::noncopyable {
   bool                mHasBounds{};
 
  private:
+  friend class RenderDataLRU;
+
   TileNode* mNode{};
   int       mTexLayer{};
   int       mLastFrame{};
+
+  RenderDataLRU* mLru{};
+  RenderData*    mLruPrev{};
+  RenderData*    mLruNext{};
 };
 
 } // namespace csp::lodbodies
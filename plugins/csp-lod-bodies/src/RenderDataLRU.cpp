@@ -0,0 +1,157 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "RenderDataLRU.hpp"
+
+#include "RenderData.hpp"
+
+#include <cassert>
+
+namespace csp::lodbodies {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+RenderDataLRU::~RenderDataLRU() {
+  clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void RenderDataLRU::pushFront(RenderData* rdata) {
+  assert(rdata->mLru == nullptr);
+
+  rdata->mLru     = this;
+  rdata->mLruPrev = nullptr;
+  rdata->mLruNext = mFront;
+
+  if (mFront) {
+    mFront->mLruPrev = rdata;
+  } else {
+    mBack = rdata;
+  }
+
+  mFront = rdata;
+  ++mSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void RenderDataLRU::pushBack(RenderData* rdata) {
+  assert(rdata->mLru == nullptr);
+
+  rdata->mLru     = this;
+  rdata->mLruPrev = mBack;
+  rdata->mLruNext = nullptr;
+
+  if (mBack) {
+    mBack->mLruNext = rdata;
+  } else {
+    mFront = rdata;
+  }
+
+  mBack = rdata;
+  ++mSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void RenderDataLRU::insertBefore(RenderData* next, RenderData* rdata) {
+  assert(next->mLru == this);
+  assert(rdata->mLru == nullptr);
+
+  if (next == mFront) {
+    pushFront(rdata);
+    return;
+  }
+
+  rdata->mLru     = this;
+  rdata->mLruPrev = next->mLruPrev;
+  rdata->mLruNext = next;
+
+  next->mLruPrev->mLruNext = rdata;
+  next->mLruPrev           = rdata;
+  ++mSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void RenderDataLRU::moveToFront(RenderData* rdata) {
+  if (rdata != mFront) {
+    remove(rdata);
+    pushFront(rdata);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void RenderDataLRU::remove(RenderData* rdata) {
+  assert(rdata->mLru == this);
+
+  if (rdata->mLruPrev) {
+    rdata->mLruPrev->mLruNext = rdata->mLruNext;
+  } else {
+    mFront = rdata->mLruNext;
+  }
+
+  if (rdata->mLruNext) {
+    rdata->mLruNext->mLruPrev = rdata->mLruPrev;
+  } else {
+    mBack = rdata->mLruPrev;
+  }
+
+  rdata->mLru     = nullptr;
+  rdata->mLruPrev = nullptr;
+  rdata->mLruNext = nullptr;
+  --mSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void RenderDataLRU::clear() {
+  while (mFront) {
+    remove(mFront);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+RenderData* RenderDataLRU::front() const {
+  return mFront;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+RenderData* RenderDataLRU::back() const {
+  return mBack;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+RenderData* RenderDataLRU::newer(RenderData const* rdata) {
+  return rdata->mLruPrev;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+RenderData* RenderDataLRU::older(RenderData const* rdata) {
+  return rdata->mLruNext;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t RenderDataLRU::size() const {
+  return mSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool RenderDataLRU::empty() const {
+  return mSize == 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::lodbodies
@@ -0,0 +1,79 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_LOD_BODIES_RENDERDATALRU_HPP
+#define CSP_LOD_BODIES_RENDERDATALRU_HPP
+
+#include <cstddef>
+
+namespace csp::lodbodies {
+
+class RenderData;
+
+/// An intrusive doubly-linked list of RenderData which is ordered by the frame in which the data
+/// was last used: The most recently used data is at the front, the least recently used data at the
+/// back. The links are stored in the RenderData itself, so no memory is allocated by the list.
+///
+/// Whenever RenderData::setLastFrame() is called for linked data, it is moved to the front of the
+/// list in constant time. As long as frame numbers passed to setLastFrame() do not decrease, the
+/// list stays sorted without ever sorting it explicitly. Data is automatically removed from the
+/// list when it is destroyed. The list does not own the data.
+class RenderDataLRU {
+ public:
+  RenderDataLRU() = default;
+
+  RenderDataLRU(RenderDataLRU const& other) = delete;
+  RenderDataLRU(RenderDataLRU&& other)      = delete;
+
+  RenderDataLRU& operator=(RenderDataLRU const& other) = delete;
+  RenderDataLRU& operator=(RenderDataLRU&& other) = delete;
+
+  ~RenderDataLRU();
+
+  /// Links rdata as most recently used data. rdata must not be linked into any list.
+  void pushFront(RenderData* rdata);
+
+  /// Links rdata as least recently used data. rdata must not be linked into any list.
+  void pushBack(RenderData* rdata);
+
+  /// Links rdata right in front of next, which must be linked into this list. This can be used to
+  /// insert data which has the same last frame as next without breaking the ordering of the list.
+  /// rdata must not be linked into any list.
+  void insertBefore(RenderData* next, RenderData* rdata);
+
+  /// Moves rdata, which must be linked into this list, to the front.
+  void moveToFront(RenderData* rdata);
+
+  /// Unlinks rdata, which must be linked into this list.
+  void remove(RenderData* rdata);
+
+  /// Unlinks all data.
+  void clear();
+
+  /// Returns the most recently used data or nullptr if the list is empty.
+  RenderData* front() const;
+
+  /// Returns the least recently used data or nullptr if the list is empty.
+  RenderData* back() const;
+
+  /// Returns the data which was used directly after rdata or nullptr if rdata is the front.
+  static RenderData* newer(RenderData const* rdata);
+
+  /// Returns the data which was used directly before rdata or nullptr if rdata is the back.
+  static RenderData* older(RenderData const* rdata);
+
+  std::size_t size() const;
+  bool        empty() const;
+
+ private:
+  RenderData* mFront{};
+  RenderData* mBack{};
+  std::size_t mSize{};
+};
+
+} // namespace csp::lodbodies
+
+#endif // CSP_LOD_BODIES_RENDERDATALRU_HPP
@@ -11,10 +11,36 @@
 #include <VistaOGLExt/VistaGLSLShader.h>
 #include <VistaOGLExt/VistaShaderRegistry.h>
 
+#include <string>
 #include <utility>
 
 namespace csp::lodbodies {
 
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Raises the GLSL version of the given source to 4.3 and defines VP_MULTI_DRAW, which makes the
+// terrain shader uniforms and functions read the tile parameters from a shader storage buffer.
+std::string enableMultiDraw(std::string source) {
+  std::string const directive = "#version 430\n#define VP_MULTI_DRAW\n";
+
+  // The version directive has to stay the first statement.
+  std::size_t begin = source.find("#version");
+  if (begin == std::string::npos) {
+    return directive + source;
+  }
+
+  std::size_t end = source.find('\n', begin);
+  source.replace(begin, end == std::string::npos ? end : end + 1 - begin, directive);
+
+  return source;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 TerrainShader::TerrainShader(std::string vertexSource, std::string fragmentSource)
@@ -41,6 +67,21 @@ void TerrainShader::release() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void TerrainShader::setMultiDraw(bool enable) {
+  if (mMultiDraw != enable) {
+    mMultiDraw   = enable;
+    mShaderDirty = true;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TerrainShader::getMultiDraw() const {
+  return mMultiDraw;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void TerrainShader::compile() {
   VistaShaderRegistry& reg = VistaShaderRegistry::GetInstance();
 
@@ -55,8 +96,15 @@ void TerrainShader::compile() {
       reg.RetrieveShader("VistaPlanetTerrainShaderUniforms.glsl"));
 
   mShader = VistaGLSLShader();
-  mShader.InitVertexShaderFromString(mVertexSource);
-  mShader.InitFragmentShaderFromString(mFragmentSource);
+
+  if (mMultiDraw) {
+    mShader.InitVertexShaderFromString(enableMultiDraw(mVertexSource));
+    mShader.InitFragmentShaderFromString(enableMultiDraw(mFragmentSource));
+  } else {
+    mShader.InitVertexShaderFromString(mVertexSource);
+    mShader.InitFragmentShaderFromString(mFragmentSource);
+  }
+
   mShader.Link();
 }
 
@@ -0,0 +1,245 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "TileDecoder.hpp"
+
+#include "logger.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <tiffio.h>
+
+namespace csp::lodbodies {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// These are used by libtiff to read TIFF files from memory.
+struct TiffMemoryFile {
+  char const* mData;
+  toff_t      mSize;
+  toff_t      mPosition;
+};
+
+tsize_t tiffRead(thandle_t handle, tdata_t buffer, tsize_t size) {
+  auto*  file  = static_cast<TiffMemoryFile*>(handle);
+  toff_t count = std::min(
+      static_cast<toff_t>(size), file->mSize - std::min(file->mPosition, file->mSize));
+
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  std::memcpy(buffer, file->mData + file->mPosition, count);
+  file->mPosition += count;
+
+  return static_cast<tsize_t>(count);
+}
+
+tsize_t tiffWrite(thandle_t /*handle*/, tdata_t /*buffer*/, tsize_t /*size*/) {
+  return 0;
+}
+
+toff_t tiffSeek(thandle_t handle, toff_t offset, int whence) {
+  auto* file = static_cast<TiffMemoryFile*>(handle);
+
+  if (whence == SEEK_SET) {
+    file->mPosition = offset;
+  } else if (whence == SEEK_CUR) {
+    file->mPosition += offset;
+  } else if (whence == SEEK_END) {
+    file->mPosition = file->mSize + offset;
+  }
+
+  return file->mPosition;
+}
+
+int tiffClose(thandle_t /*handle*/) {
+  return 0;
+}
+
+toff_t tiffSize(thandle_t handle) {
+  return static_cast<TiffMemoryFile*>(handle)->mSize;
+}
+
+int tiffMap(thandle_t handle, tdata_t* base, toff_t* size) {
+  auto* file = static_cast<TiffMemoryFile*>(handle);
+  // libtiff only reads from the mapping as the file is opened in read-only mode.
+  *base = const_cast<char*>(file->mData); // NOLINT(cppcoreguidelines-pro-type-const-cast)
+  *size = file->mSize;
+  return 1;
+}
+
+void tiffUnmap(thandle_t /*handle*/, tdata_t /*base*/, toff_t /*size*/) {
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Copies the pixels of row y which are selected by which from source to target. Both point to the
+// beginning of the row.
+template <typename T>
+void copyRow(T const* source, T* target, int y, CopyPixels which) {
+  int const width = TileBase::SizeX;
+
+  if (which == CopyPixels::eAll) {
+    std::memcpy(target, source, width * sizeof(T));
+  } else if (which == CopyPixels::eAboveDiagonal) {
+    int count = width - y - 1;
+
+    if (count > 0) {
+      std::memcpy(target, source, count * sizeof(T));
+    }
+  } else if (which == CopyPixels::eBelowDiagonal) {
+    int offset = width - y;
+    int count  = y;
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    std::memcpy(target + offset, source + offset, count * sizeof(T));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool decodeTiff(char const* data, size_t size, float* target, CopyPixels which) {
+  TIFFSetWarningHandler(nullptr);
+
+  TiffMemoryFile file{data, size, 0};
+  auto* tiff = TIFFClientOpen("tile", "r", &file, &tiffRead, &tiffWrite, &tiffSeek, &tiffClose,
+      &tiffSize, &tiffMap, &tiffUnmap);
+
+  if (!tiff) {
+    logger().error("Failed to decode tile: Cannot open TIFF data with libtiff!");
+    return false;
+  }
+
+  uint32_t width{};
+  uint32_t height{};
+  uint32_t rowsPerStrip{};
+  uint16_t bitsPerSample{};
+  uint16_t samplesPerPixel{};
+  TIFFGetField(tiff, TIFFTAG_IMAGEWIDTH, &width);
+  TIFFGetField(tiff, TIFFTAG_IMAGELENGTH, &height);
+  TIFFGetFieldDefaulted(tiff, TIFFTAG_ROWSPERSTRIP, &rowsPerStrip);
+  TIFFGetFieldDefaulted(tiff, TIFFTAG_BITSPERSAMPLE, &bitsPerSample);
+  TIFFGetFieldDefaulted(tiff, TIFFTAG_SAMPLESPERPIXEL, &samplesPerPixel);
+
+  if (width != TileBase::SizeX || height != TileBase::SizeY || bitsPerSample != 32 ||
+      samplesPerPixel != 1 || TIFFIsTiled(tiff)) {
+    logger().error("Failed to decode tile: Expected a striped single-channel 32 bit TIFF image "
+                   "with {}x{} pixels but got {} bit, {} channels and {}x{} pixels!",
+        TileBase::SizeX, TileBase::SizeY, bitsPerSample, samplesPerPixel, width, height);
+    TIFFClose(tiff);
+    return false;
+  }
+
+  rowsPerStrip = std::clamp(rowsPerStrip, 1U, height);
+
+  // If all pixels are required, the strips are decoded directly into the tile. Else each strip is
+  // decoded to a temporary buffer first.
+  std::vector<float> buffer;
+  if (which != CopyPixels::eAll) {
+    buffer.resize(static_cast<size_t>(rowsPerStrip) * width);
+  }
+
+  bool success = true;
+
+  for (uint32_t firstRow = 0; firstRow < height && success; firstRow += rowsPerStrip) {
+    uint32_t rows  = std::min(rowsPerStrip, height - firstRow);
+    tstrip_t strip = TIFFComputeStrip(tiff, firstRow, 0);
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    float* stripTarget = which == CopyPixels::eAll ? target + firstRow * width : buffer.data();
+
+    auto bytes = static_cast<tmsize_t>(rows * width * sizeof(float));
+    success    = TIFFReadEncodedStrip(tiff, strip, stripTarget, bytes) >= 0;
+
+    if (success && which != CopyPixels::eAll) {
+      for (uint32_t row = 0; row < rows; ++row) {
+        int y = static_cast<int>(firstRow + row);
+
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        copyRow(buffer.data() + row * width, target + y * width, y, which);
+      }
+    }
+  }
+
+  TIFFClose(tiff);
+
+  if (!success) {
+    logger().error("Failed to decode tile: Cannot read TIFF data with libtiff!");
+  }
+
+  return success;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+bool decodePng(char const* data, size_t size, T* target, CopyPixels which) {
+  int const channels = sizeof(T);
+
+  int   width{};
+  int   height{};
+  int   bpp{};
+  auto* pixels = reinterpret_cast<T*>(stbi_load_from_memory(reinterpret_cast<stbi_uc const*>(data),
+      static_cast<int>(size), &width, &height, &bpp, channels));
+
+  if (!pixels) {
+    logger().error("Failed to decode tile: {}!", stbi_failure_reason());
+    return false;
+  }
+
+  if (width != TileBase::SizeX || height != TileBase::SizeY) {
+    logger().error("Failed to decode tile: Expected an image with {}x{} pixels but got {}x{}!",
+        TileBase::SizeX, TileBase::SizeY, width, height);
+    stbi_image_free(pixels);
+    return false;
+  }
+
+  // stbi cannot decode to an external buffer, so there is one copy involved.
+  if (which == CopyPixels::eAll) {
+    std::memcpy(target, pixels, sizeof(T) * width * height);
+  } else {
+    for (int y = 0; y < height; ++y) {
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+      copyRow(pixels + y * width, target + y * width, y, which);
+    }
+  }
+
+  stbi_image_free(pixels);
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+bool decodeTile(char const* data, size_t size, Tile<T>& tile, CopyPixels which) {
+  if constexpr (std::is_same_v<T, float>) {
+    return decodeTiff(data, size, tile.data().data(), which);
+  } else {
+    return decodePng(data, size, tile.data().data(), which);
+  }
+}
+
+template bool decodeTile(char const*, size_t, Tile<float>&, CopyPixels);
+template bool decodeTile(char const*, size_t, Tile<glm::uint8>&, CopyPixels);
+template bool decodeTile(char const*, size_t, Tile<glm::u8vec3>&, CopyPixels);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::lodbodies
@@ -0,0 +1,30 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_LOD_BODIES_TILEDECODER_HPP
+#define CSP_LOD_BODIES_TILEDECODER_HPP
+
+#include "Tile.hpp"
+
+#include <cstddef>
+
+namespace csp::lodbodies {
+
+/// Determines which pixels of a decoded image are written to a tile. Patches on the diagonal of
+/// base patch 4 are composed of the upper left and the lower right triangles of two images.
+enum class CopyPixels { eAll, eAboveDiagonal, eBelowDiagonal };
+
+/// Decodes an image as delivered by a web map service directly into the storage of the given tile.
+/// Elevation tiles (Tile<float>) are expected to be single-channel 32 bit float TIFF images, all
+/// other tiles are expected to be PNG images with a matching number of channels. The image must
+/// have a resolution of TileBase::SizeX x TileBase::SizeY pixels. The data is read from memory,
+/// no temporary files are involved. Returns false and logs an error if the data cannot be decoded.
+template <typename T>
+bool decodeTile(char const* data, size_t size, Tile<T>& tile, CopyPixels which = CopyPixels::eAll);
+
+} // namespace csp::lodbodies
+
+#endif // CSP_LOD_BODIES_TILEDECODER_HPP
@@ -0,0 +1,714 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "TileDiskCache.hpp"
+
+#include "logger.hpp"
+
+#include "../../../src/cs-utils/filesystem.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <boost/interprocess/sync/scoped_lock.hpp>
+#include <boost/interprocess/sync/sharable_lock.hpp>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+namespace csp::lodbodies {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Increment this whenever the layout of the index file changes. Caches with a different version
+// are discarded.
+uint32_t const cacheVersion = 1;
+
+std::array<char, 8> const cacheMagic = {'C', 'S', 'T', 'C', 'A', 'C', 'H', 'E'};
+
+// Number of slots of a new index file. This has to be a power of two.
+uint64_t const initialCapacity = 1 << 16;
+
+// The index is grown once it is filled more than this.
+double const maxLoadFactor = 0.7;
+
+// Tiles are re-appended to the newest segment on eviction, if they have been used within the last
+// (tileCount * hotFraction) accesses.
+double const hotFraction = 0.25;
+
+// Size of newly created segment files. The size of existing caches is stored in their index. This
+// is also the granularity of evictions.
+uint64_t const segmentSize = 64 * 1024 * 1024;
+
+uint64_t const defaultMaxSize = 4ULL * 1024 * 1024 * 1024;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// This is the splitmix64 finalizer. It distributes the tile keys evenly across the table.
+uint64_t hashKey(uint64_t key) {
+  key = (key ^ (key >> 30U)) * 0xbf58476d1ce4e5b9ULL;
+  key = (key ^ (key >> 27U)) * 0x94d049bb133111ebULL;
+  return key ^ (key >> 31U);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void createFile(std::string const& path, uint64_t size) {
+  { std::ofstream file(path, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc); }
+  boost::filesystem::resize_file(path, size);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The first bytes of the index file.
+struct TileDiskCache::IndexHeader {
+  std::array<char, 8>   mMagic{};
+  uint32_t              mVersion{};
+  uint32_t              mFirstSegment{};
+  uint32_t              mLastSegment{};
+  uint32_t              mPadding{};
+  uint64_t              mSegmentSize{};
+  uint64_t              mLastSegmentSize{}; ///< Number of bytes used in the last segment.
+  uint64_t              mCapacity{};        ///< Number of slots, always a power of two.
+  uint64_t              mCount{};           ///< Number of occupied slots.
+  std::atomic<uint64_t> mAccessCounter{};
+};
+
+// The index header is followed by mCapacity of these slots. A slot with mSize == 0 is empty.
+struct TileDiskCache::IndexSlot {
+  uint64_t              mKey;
+  uint64_t              mOffset;
+  uint32_t              mSegment;
+  uint32_t              mSize;
+  std::atomic<uint64_t> mLastUse;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+    "The index of the TileDiskCache requires lock-free 64 bit atomics.");
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<TileDiskCache> TileDiskCache::get(
+    std::string const& directory, std::string const& name) {
+  static std::mutex                                                   mutex;
+  static std::unordered_map<std::string, std::weak_ptr<TileDiskCache>> caches;
+
+  std::unique_lock<std::mutex> lock(mutex);
+
+  auto  path  = directory + "/" + name;
+  auto& entry = caches[path];
+  auto  cache = entry.lock();
+
+  if (!cache) {
+    bool isNew = !boost::filesystem::exists(path + ".index");
+
+    cache = std::make_shared<TileDiskCache>(directory, name);
+    entry = cache;
+
+    if (isNew) {
+      cache->importDirectory(directory);
+    }
+  }
+
+  return cache;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileDiskCache::TileDiskCache(std::string directory, std::string name, bool readOnly)
+    : mDirectory(std::move(directory))
+    , mName(std::move(name))
+    , mMaxSize(defaultMaxSize)
+    , mReadOnly(readOnly) {
+
+  auto directoryPath(boost::filesystem::absolute(boost::filesystem::path(mDirectory)));
+  if (!boost::filesystem::exists(directoryPath)) {
+    cs::utils::filesystem::createDirectoryRecursively(
+        directoryPath, boost::filesystem::perms::all_all);
+  }
+
+  // The cache files must not be modified by multiple processes at the same time. The first process
+  // keeps the .lock file locked, all others only read from the cache. The .index-lock file is
+  // locked exclusively by the writing process while it modifies the files and shared by the
+  // reading processes while they read a tile.
+  auto lockPath      = mDirectory + "/" + mName + ".lock";
+  auto indexLockPath = mDirectory + "/" + mName + ".index-lock";
+
+  for (auto const& path : {lockPath, indexLockPath}) {
+    if (!boost::filesystem::exists(path)) {
+      createFile(path, 0);
+    }
+  }
+
+  mIndexLock = boost::interprocess::file_lock(indexLockPath.c_str());
+
+  if (!mReadOnly) {
+    mLock     = boost::interprocess::file_lock(lockPath.c_str());
+    mReadOnly = !mLock.try_lock();
+
+    if (mReadOnly) {
+      logger().info("Tile cache '{}/{}' is written by another process. It will be used read-only.",
+          mDirectory, mName);
+    }
+  }
+
+  if (mReadOnly) {
+    return;
+  }
+
+  boost::interprocess::scoped_lock<boost::interprocess::file_lock> fileLock(mIndexLock);
+
+  openIndex(initialCapacity, false);
+
+  for (uint32_t i = header().mFirstSegment; i <= header().mLastSegment; ++i) {
+    openSegment(i, false);
+  }
+
+  mWriter = std::make_unique<cs::utils::ThreadPool>(1);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileDiskCache::~TileDiskCache() {
+  // This waits for all pending writes to be finished before the files are closed.
+  mWriter.reset();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint64_t TileDiskCache::makeKey(int level, int x, int y) {
+  // x and y are smaller than 5 * 2^level, so 29 bits are sufficient up to level 26.
+  return (static_cast<uint64_t>(level) << 58U) | (static_cast<uint64_t>(x) << 29U) |
+         static_cast<uint64_t>(y);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TileDiskCache::isReadOnly() const {
+  return mReadOnly;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TileDiskCache::load(uint64_t key, std::vector<char>& data) const {
+  if (mReadOnly) {
+    return loadShared(key, data);
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(mPendingWritesMutex);
+
+    auto pending = mPendingWrites.find(key);
+    if (pending != mPendingWrites.end()) {
+      data = *pending->second;
+      return true;
+    }
+  }
+
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+
+  IndexSlot* slot = findSlot(key);
+
+  if (slot->mSize == 0) {
+    return false;
+  }
+
+  auto segment = mSegments.find(slot->mSegment);
+  if (segment == mSegments.end() || slot->mOffset + slot->mSize > header().mSegmentSize) {
+    return false;
+  }
+
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  auto const* begin = static_cast<char const*>(segment->second->mRegion.get_address()) +
+                      slot->mOffset;
+
+  data.resize(slot->mSize);
+  std::memcpy(data.data(), begin, slot->mSize);
+
+  slot->mLastUse = ++header().mAccessCounter;
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileDiskCache::store(uint64_t key, std::vector<char> const& data) {
+  if (data.empty() || mReadOnly) {
+    return;
+  }
+
+  std::unique_lock<std::shared_mutex>                              lock(mMutex);
+  boost::interprocess::scoped_lock<boost::interprocess::file_lock> fileLock(mIndexLock);
+
+  uint32_t segment{};
+  uint64_t offset{};
+
+  if (!append(data.data(), static_cast<uint32_t>(data.size()), segment, offset)) {
+    return;
+  }
+
+  IndexSlot* slot = findSlot(key);
+
+  if (slot->mSize == 0) {
+    if (static_cast<double>(header().mCount + 1) >
+        static_cast<double>(header().mCapacity) * maxLoadFactor) {
+      rehash(header().mCapacity * 2);
+      slot = findSlot(key);
+    }
+
+    ++header().mCount;
+  }
+
+  slot->mKey     = key;
+  slot->mSegment = segment;
+  slot->mOffset  = offset;
+  slot->mSize    = static_cast<uint32_t>(data.size());
+  slot->mLastUse = ++header().mAccessCounter;
+
+  evict();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileDiskCache::storeAsync(uint64_t key, std::vector<char> data) {
+  if (data.empty() || mReadOnly) {
+    return;
+  }
+
+  auto pending = std::make_shared<std::vector<char> const>(std::move(data));
+
+  {
+    std::unique_lock<std::mutex> lock(mPendingWritesMutex);
+    mPendingWrites[key] = pending;
+  }
+
+  mWriter->enqueue([this, key, pending]() {
+    // If the tile has been stored again in the meantime, only the newest data is written.
+    {
+      std::unique_lock<std::mutex> lock(mPendingWritesMutex);
+      auto                         it = mPendingWrites.find(key);
+      if (it == mPendingWrites.end() || it->second != pending) {
+        return;
+      }
+    }
+
+    store(key, *pending);
+
+    // The pending data is removed only after it has been written, this way load() always finds it
+    // in either place.
+    std::unique_lock<std::mutex> lock(mPendingWritesMutex);
+    auto                         it = mPendingWrites.find(key);
+    if (it != mPendingWrites.end() && it->second == pending) {
+      mPendingWrites.erase(it);
+    }
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileDiskCache::setMaxSize(uint64_t bytes) {
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  mMaxSize = bytes;
+
+  if (!mReadOnly) {
+    boost::interprocess::scoped_lock<boost::interprocess::file_lock> fileLock(mIndexLock);
+    evict();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint64_t TileDiskCache::getMaxSize() const {
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+  return mMaxSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint64_t TileDiskCache::getTileCount() const {
+  if (mReadOnly) {
+    std::unique_lock<std::shared_mutex>                                lock(mMutex);
+    boost::interprocess::sharable_lock<boost::interprocess::file_lock> fileLock(mIndexLock);
+
+    std::ifstream index(getIndexPath(), std::ifstream::binary);
+    IndexHeader   h;
+    return readHeader(index, h) ? h.mCount : 0;
+  }
+
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+  return header().mCount;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileDiskCache::importDirectory(std::string const& directory) {
+  if (mReadOnly || !boost::filesystem::is_directory(directory)) {
+    return;
+  }
+
+  auto isNumber = [](std::string const& s) {
+    return !s.empty() &&
+           std::all_of(s.begin(), s.end(), [](char c) { return c >= '0' && c <= '9'; });
+  };
+
+  uint64_t          count = 0;
+  std::vector<char> data;
+
+  for (auto const& levelDir : boost::filesystem::directory_iterator(directory)) {
+    auto level = levelDir.path().filename().string();
+    if (!isNumber(level) || !boost::filesystem::is_directory(levelDir.path())) {
+      continue;
+    }
+
+    if (count == 0) {
+      logger().info("Importing tile cache directory '{}'...", directory);
+    }
+
+    for (auto const& xDir : boost::filesystem::directory_iterator(levelDir.path())) {
+      auto x = xDir.path().filename().string();
+      if (!isNumber(x) || !boost::filesystem::is_directory(xDir.path())) {
+        continue;
+      }
+
+      for (auto const& file : boost::filesystem::directory_iterator(xDir.path())) {
+        auto y = file.path().stem().string();
+        if (!isNumber(y) || file.path().extension().string() != "." + mName) {
+          continue;
+        }
+
+        std::ifstream in(file.path().string(), std::ifstream::binary);
+        data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        in.close();
+
+        store(makeKey(std::stoi(level), std::stoi(x), std::stoi(y)), data);
+        boost::filesystem::remove(file.path());
+        ++count;
+      }
+
+      if (boost::filesystem::is_empty(xDir.path())) {
+        boost::filesystem::remove(xDir.path());
+      }
+    }
+
+    if (boost::filesystem::is_empty(levelDir.path())) {
+      boost::filesystem::remove(levelDir.path());
+    }
+  }
+
+  if (count > 0) {
+    logger().info("Imported {} tiles.", count);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string TileDiskCache::getIndexPath() const {
+  return mDirectory + "/" + mName + ".index";
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string TileDiskCache::getSegmentPath(uint32_t segment) const {
+  return mDirectory + "/" + mName + ".segment-" + std::to_string(segment);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileDiskCache::openIndex(uint64_t capacity, bool reset) {
+  namespace bip = boost::interprocess;
+
+  auto path = getIndexPath();
+
+  if (!reset && boost::filesystem::exists(path)) {
+    try {
+      mIndexFile   = bip::file_mapping(path.c_str(), bip::read_write);
+      mIndexRegion = bip::mapped_region(mIndexFile, bip::read_write);
+
+      auto const& h = header();
+
+      bool valid = mIndexRegion.get_size() >= sizeof(IndexHeader) && h.mMagic == cacheMagic &&
+                   h.mVersion == cacheVersion &&
+                   mIndexRegion.get_size() ==
+                       sizeof(IndexHeader) + h.mCapacity * sizeof(IndexSlot) &&
+                   h.mFirstSegment <= h.mLastSegment;
+
+      for (uint32_t i = h.mFirstSegment; valid && i <= h.mLastSegment; ++i) {
+        valid = boost::filesystem::exists(getSegmentPath(i));
+      }
+
+      if (valid) {
+        return;
+      }
+
+      logger().warn("Discarding tile cache '{}': The index is corrupt or outdated!", path);
+    } catch (std::exception const& e) {
+      logger().warn("Discarding tile cache '{}': {}!", path, e.what());
+    }
+  }
+
+  // Create a new, empty index. All existing segments are removed.
+  bip::mapped_region().swap(mIndexRegion);
+  bip::file_mapping().swap(mIndexFile);
+  mSegments.clear();
+
+  for (auto const& file : boost::filesystem::directory_iterator(mDirectory)) {
+    if (file.path().filename().string().rfind(mName + ".segment-", 0) == 0) {
+      boost::filesystem::remove(file.path());
+    }
+  }
+
+  createFile(path, sizeof(IndexHeader) + capacity * sizeof(IndexSlot));
+
+  mIndexFile   = bip::file_mapping(path.c_str(), bip::read_write);
+  mIndexRegion = bip::mapped_region(mIndexFile, bip::read_write);
+
+  auto& h = *new (mIndexRegion.get_address()) IndexHeader();
+
+  h.mMagic       = cacheMagic;
+  h.mVersion     = cacheVersion;
+  h.mCapacity    = capacity;
+  h.mSegmentSize = segmentSize;
+
+  createFile(getSegmentPath(0), h.mSegmentSize);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileDiskCache::openSegment(uint32_t segment, bool create) {
+  namespace bip = boost::interprocess;
+
+  auto path = getSegmentPath(segment);
+
+  if (create) {
+    createFile(path, header().mSegmentSize);
+  }
+
+  auto s     = std::make_unique<Segment>();
+  s->mFile   = bip::file_mapping(path.c_str(), bip::read_write);
+  s->mRegion = bip::mapped_region(s->mFile, bip::read_write);
+
+  mSegments[segment] = std::move(s);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileDiskCache::IndexHeader& TileDiskCache::header() const {
+  return *static_cast<IndexHeader*>(mIndexRegion.get_address());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileDiskCache::IndexSlot* TileDiskCache::slots() const {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  return reinterpret_cast<IndexSlot*>(static_cast<char*>(mIndexRegion.get_address()) +
+                                      sizeof(IndexHeader));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileDiskCache::IndexSlot* TileDiskCache::findSlot(uint64_t key) const {
+  uint64_t mask = header().mCapacity - 1;
+  uint64_t i    = hashKey(key) & mask;
+
+  // The load factor is limited, so there always is an empty slot.
+  while (true) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    IndexSlot* slot = slots() + i;
+    if (slot->mSize == 0 || slot->mKey == key) {
+      return slot;
+    }
+    i = (i + 1) & mask;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TileDiskCache::readHeader(std::ifstream& index, IndexHeader& result) const {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  if (!index.read(reinterpret_cast<char*>(&result), sizeof(IndexHeader))) {
+    return false;
+  }
+
+  return result.mMagic == cacheMagic && result.mVersion == cacheVersion &&
+         result.mCapacity > 0 && (result.mCapacity & (result.mCapacity - 1)) == 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TileDiskCache::loadShared(uint64_t key, std::vector<char>& data) const {
+  // File locks are held per process, so the lookups of multiple threads are serialized. Else the
+  // first thread would release the shared lock while the others are still reading.
+  std::unique_lock<std::shared_mutex>                                lock(mMutex);
+  boost::interprocess::sharable_lock<boost::interprocess::file_lock> fileLock(mIndexLock);
+
+  std::ifstream index(getIndexPath(), std::ifstream::binary);
+  IndexHeader   h;
+
+  if (!readHeader(index, h)) {
+    return false;
+  }
+
+  uint64_t  mask = h.mCapacity - 1;
+  uint64_t  i    = hashKey(key) & mask;
+  IndexSlot slot{};
+
+  for (uint64_t probes = 0; probes < h.mCapacity; ++probes) {
+    index.seekg(static_cast<std::streamoff>(sizeof(IndexHeader) + i * sizeof(IndexSlot)));
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    if (!index.read(reinterpret_cast<char*>(&slot), sizeof(IndexSlot)) || slot.mSize == 0) {
+      return false;
+    }
+
+    if (slot.mKey == key) {
+      if (slot.mSegment < h.mFirstSegment || slot.mSegment > h.mLastSegment ||
+          slot.mOffset + slot.mSize > h.mSegmentSize) {
+        return false;
+      }
+
+      std::ifstream segment(getSegmentPath(slot.mSegment), std::ifstream::binary);
+      segment.seekg(static_cast<std::streamoff>(slot.mOffset));
+
+      data.resize(slot.mSize);
+      return static_cast<bool>(segment.read(data.data(), slot.mSize));
+    }
+
+    i = (i + 1) & mask;
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileDiskCache::rehash(uint64_t capacity) {
+  namespace bip = boost::interprocess;
+
+  struct Entry {
+    uint64_t mKey;
+    uint64_t mOffset;
+    uint32_t mSegment;
+    uint32_t mSize;
+    uint64_t mLastUse;
+  };
+
+  std::vector<Entry> entries;
+  entries.reserve(header().mCount);
+
+  for (uint64_t i = 0; i < header().mCapacity; ++i) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    IndexSlot const& slot = slots()[i];
+    if (slot.mSize > 0 && slot.mSegment >= header().mFirstSegment) {
+      entries.push_back({slot.mKey, slot.mOffset, slot.mSegment, slot.mSize, slot.mLastUse});
+    }
+  }
+
+  if (capacity != header().mCapacity) {
+    bip::mapped_region().swap(mIndexRegion);
+    bip::file_mapping().swap(mIndexFile);
+
+    boost::filesystem::resize_file(
+        getIndexPath(), sizeof(IndexHeader) + capacity * sizeof(IndexSlot));
+
+    mIndexFile   = bip::file_mapping(getIndexPath().c_str(), bip::read_write);
+    mIndexRegion = bip::mapped_region(mIndexFile, bip::read_write);
+
+    header().mCapacity = capacity;
+  }
+
+  std::memset(static_cast<void*>(slots()), 0, capacity * sizeof(IndexSlot));
+
+  for (auto const& entry : entries) {
+    IndexSlot* slot = findSlot(entry.mKey);
+    slot->mKey      = entry.mKey;
+    slot->mOffset   = entry.mOffset;
+    slot->mSegment  = entry.mSegment;
+    slot->mSize     = entry.mSize;
+    slot->mLastUse  = entry.mLastUse;
+  }
+
+  header().mCount = entries.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TileDiskCache::append(char const* data, uint32_t size, uint32_t& segment, uint64_t& offset) {
+  auto& h = header();
+
+  if (size > h.mSegmentSize) {
+    return false;
+  }
+
+  if (h.mLastSegmentSize + size > h.mSegmentSize) {
+    openSegment(h.mLastSegment + 1, true);
+    ++h.mLastSegment;
+    h.mLastSegmentSize = 0;
+  }
+
+  segment = h.mLastSegment;
+  offset  = h.mLastSegmentSize;
+
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  std::memcpy(static_cast<char*>(mSegments[segment]->mRegion.get_address()) + offset, data, size);
+  h.mLastSegmentSize += size;
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileDiskCache::evict() {
+  auto& h = header();
+
+  auto totalSize = [&h]() {
+    return (h.mLastSegment - h.mFirstSegment) * h.mSegmentSize + h.mLastSegmentSize;
+  };
+
+  while (totalSize() > mMaxSize && h.mFirstSegment < h.mLastSegment) {
+    uint32_t victim     = h.mFirstSegment;
+    auto     victimData = static_cast<char const*>(mSegments[victim]->mRegion.get_address());
+
+    ++h.mFirstSegment;
+
+    // Keep recently used tiles by moving them to the newest segment.
+    uint64_t now       = h.mAccessCounter;
+    auto     hotWindow = static_cast<uint64_t>(static_cast<double>(h.mCount) * hotFraction);
+
+    for (uint64_t i = 0; i < h.mCapacity; ++i) {
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+      IndexSlot& slot = slots()[i];
+      if (slot.mSize > 0 && slot.mSegment == victim && now - slot.mLastUse < hotWindow) {
+        uint32_t segment{};
+        uint64_t offset{};
+
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        if (append(victimData + slot.mOffset, slot.mSize, segment, offset)) {
+          slot.mSegment = segment;
+          slot.mOffset  = offset;
+        }
+      }
+    }
+
+    // Drop all remaining entries of the victim.
+    rehash(h.mCapacity);
+
+    mSegments.erase(victim);
+    boost::filesystem::remove(getSegmentPath(victim));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::lodbodies
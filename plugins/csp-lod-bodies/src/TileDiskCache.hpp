@@ -0,0 +1,158 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_LOD_BODIES_TILEDISKCACHE_HPP
+#define CSP_LOD_BODIES_TILEDISKCACHE_HPP
+
+#include "../../../src/cs-utils/ThreadPool.hpp"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/sync/file_lock.hpp>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace csp::lodbodies {
+
+/// A persistent cache for the encoded data of map tiles (e.g. the TIFF or PNG files downloaded
+/// from a web map service). Instead of storing each tile in a separate file, the data is appended
+/// to a few large segment files. An open-addressing hash table in a memory-mapped index file maps
+/// the tile keys to their location in the segments, which are memory-mapped as well. Hence a cache
+/// hit requires neither a stat call nor a file to be opened.
+///
+/// Once the total size of the segments exceeds the configured maximum, the oldest segment is
+/// evicted. Tiles of this segment which have been accessed recently are re-appended to the newest
+/// segment, all others are dropped. This approximates a least-recently-used eviction strategy.
+///
+/// Only one process at a time can write to the cache. If it is opened by another process which
+/// writes to it already, the cache is opened read-only instead: Tiles are read from the files
+/// without mapping them and new tiles are not stored. Modifications of the writing process are
+/// guarded by an exclusive lock on a lock file, so that they are never seen half-done by readers.
+///
+/// All methods are thread-safe. Lookups of multiple threads can be performed concurrently, unless
+/// the cache is read-only.
+class TileDiskCache {
+ public:
+  /// Returns the cache stored in the given directory with the given name. Instances are shared
+  /// between all callers using the same directory and name. If the directory contains files of the
+  /// form <level>/<x>/<y>.<name> which have been written by previous versions of CosmoScout VR,
+  /// they are imported into the cache and removed once the cache is created for the first time.
+  /// This throws a std::runtime_error if the cache cannot be opened.
+  static std::shared_ptr<TileDiskCache> get(std::string const& directory, std::string const& name);
+
+  /// Opens or creates the cache. Usually you should use TileDiskCache::get() instead. The cache is
+  /// opened read-only if readOnly is true or if another process writes to it already.
+  TileDiskCache(std::string directory, std::string name, bool readOnly = false);
+
+  TileDiskCache(TileDiskCache const& other) = delete;
+  TileDiskCache(TileDiskCache&& other)      = delete;
+
+  TileDiskCache& operator=(TileDiskCache const& other) = delete;
+  TileDiskCache& operator=(TileDiskCache&& other) = delete;
+
+  ~TileDiskCache();
+
+  /// Computes the key which is used to identify the tile at the given position.
+  static uint64_t makeKey(int level, int x, int y);
+
+  /// Returns true if this process cannot write to the cache.
+  bool isReadOnly() const;
+
+  /// Copies the data of the tile with the given key to data. Returns false if the tile is not
+  /// cached.
+  bool load(uint64_t key, std::vector<char>& data) const;
+
+  /// Stores the given tile data. If there is already data for the given key, it will be replaced.
+  /// This does nothing if the cache is read-only.
+  void store(uint64_t key, std::vector<char> const& data);
+
+  /// Like store(), but the data is written by a background thread so that the caller does not have
+  /// to wait for the disk. Until then, load() returns the data from memory.
+  void storeAsync(uint64_t key, std::vector<char> data);
+
+  /// The maximum accumulated size of all segment files in bytes. If the cache already is larger,
+  /// the oldest segments are evicted immediately. The default is 4 GiB.
+  void     setMaxSize(uint64_t bytes);
+  uint64_t getMaxSize() const;
+
+  /// Returns the number of cached tiles.
+  uint64_t getTileCount() const;
+
+  /// Imports all files of the form <level>/<x>/<y>.<name> in the given directory and removes them
+  /// afterwards. This is done automatically by TileDiskCache::get(). This does nothing if the
+  /// cache is read-only.
+  void importDirectory(std::string const& directory);
+
+ private:
+  struct IndexHeader;
+  struct IndexSlot;
+
+  struct Segment {
+    boost::interprocess::file_mapping  mFile;
+    boost::interprocess::mapped_region mRegion;
+  };
+
+  std::string getIndexPath() const;
+  std::string getSegmentPath(uint32_t segment) const;
+
+  /// Maps the index file with the given capacity (in slots). If reset is true or the existing file
+  /// is corrupt, an empty index is created and all segments are removed.
+  void openIndex(uint64_t capacity, bool reset);
+  void openSegment(uint32_t segment, bool create);
+
+  IndexHeader& header() const;
+  IndexSlot*   slots() const;
+
+  /// Returns the slot containing the given key or the empty slot where it should be inserted.
+  IndexSlot* findSlot(uint64_t key) const;
+
+  /// Reads the index header from the file. This is used by read-only caches, which do not map the
+  /// index. Returns false if the index does not exist or is invalid.
+  bool readHeader(std::ifstream& index, IndexHeader& result) const;
+
+  /// Like load(), but the tile is read directly from the files. This is used by read-only caches.
+  bool loadShared(uint64_t key, std::vector<char>& data) const;
+
+  /// Rebuilds the hash table with the given capacity, dropping all entries referencing segments
+  /// older than the first segment.
+  void rehash(uint64_t capacity);
+
+  /// Appends data to the newest segment, starting a new segment if required. Returns false if the
+  /// data is larger than a segment.
+  bool append(char const* data, uint32_t size, uint32_t& segment, uint64_t& offset);
+
+  /// Evicts the oldest segments until the cache is smaller than mMaxSize.
+  void evict();
+
+  std::string mDirectory;
+  std::string mName;
+  uint64_t    mMaxSize;
+  bool        mReadOnly;
+
+  boost::interprocess::file_lock         mLock;
+  mutable boost::interprocess::file_lock mIndexLock;
+
+  boost::interprocess::file_mapping  mIndexFile;
+  boost::interprocess::mapped_region mIndexRegion;
+
+  std::map<uint32_t, std::unique_ptr<Segment>> mSegments;
+
+  mutable std::shared_mutex mMutex;
+
+  mutable std::mutex                                                     mPendingWritesMutex;
+  std::unordered_map<uint64_t, std::shared_ptr<std::vector<char> const>> mPendingWrites;
+  std::unique_ptr<cs::utils::ThreadPool>                                 mWriter;
+};
+
+} // namespace csp::lodbodies
+
+#endif // CSP_LOD_BODIES_TILEDISKCACHE_HPP
@@ -0,0 +1,202 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_LOD_BODIES_TILEIDMAP_HPP
+#define CSP_LOD_BODIES_TILEIDMAP_HPP
+
+#include "TileId.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace csp::lodbodies {
+
+/// A hash map from TileId to values of type T which uses open addressing with linear probing. All
+/// entries are stored in a single array, so a lookup usually touches only one cache line and
+/// inserting or erasing entries does not allocate memory unless the map has to grow. Erasing uses
+/// backward shifting, so there are no tombstones which would slow down subsequent lookups.
+///
+/// Invalid TileIds (see isValid()) are used to mark empty slots and can therefore not be used as
+/// keys. Pointers returned by find() are invalidated by any subsequent insert() or erase().
+template <typename T>
+class TileIdMap {
+ public:
+  TileIdMap() = default;
+
+  /// Returns a pointer to the value associated with tileId or nullptr if there is none.
+  T const* find(TileId const& tileId) const;
+  T*       find(TileId const& tileId);
+
+  /// Associates value with tileId. Returns false if there is already a value associated with
+  /// tileId, in this case the map is not modified.
+  bool insert(TileId const& tileId, T const& value);
+
+  /// Removes the value associated with tileId. Returns false if there is none.
+  bool erase(TileId const& tileId);
+
+  /// Removes all values, the allocated memory is kept.
+  void clear();
+
+  /// Makes sure that count values can be stored without growing the map.
+  void reserve(std::size_t count);
+
+  std::size_t size() const;
+  bool        empty() const;
+
+ private:
+  struct Slot {
+    TileId mTileId;
+    T      mValue{};
+  };
+
+  static std::size_t hash(TileId const& tileId);
+
+  /// Returns the index of the slot containing tileId or of the empty slot where it would have to be
+  /// inserted.
+  std::size_t findSlot(TileId const& tileId) const;
+
+  void rehash(std::size_t capacity);
+
+  std::vector<Slot> mSlots;
+  std::size_t       mSize = 0;
+};
+
+template <typename T>
+T const* TileIdMap<T>::find(TileId const& tileId) const {
+  if (mSize == 0) {
+    return nullptr;
+  }
+
+  Slot const& slot = mSlots[findSlot(tileId)];
+  return isValid(slot.mTileId) ? &slot.mValue : nullptr;
+}
+
+template <typename T>
+T* TileIdMap<T>::find(TileId const& tileId) {
+  return const_cast<T*>(static_cast<TileIdMap const*>(this)->find(tileId)); // NOLINT
+}
+
+template <typename T>
+bool TileIdMap<T>::insert(TileId const& tileId, T const& value) {
+  // Keep the load factor below 3/4, linear probing degrades quickly beyond that.
+  if ((mSize + 1) * 4 > mSlots.size() * 3) {
+    rehash(std::max<std::size_t>(16, mSlots.size() * 2));
+  }
+
+  Slot& slot = mSlots[findSlot(tileId)];
+
+  if (isValid(slot.mTileId)) {
+    return false;
+  }
+
+  slot.mTileId = tileId;
+  slot.mValue  = value;
+  ++mSize;
+
+  return true;
+}
+
+template <typename T>
+bool TileIdMap<T>::erase(TileId const& tileId) {
+  if (mSize == 0) {
+    return false;
+  }
+
+  std::size_t mask = mSlots.size() - 1;
+  std::size_t hole = findSlot(tileId);
+
+  if (!isValid(mSlots[hole].mTileId)) {
+    return false;
+  }
+
+  // Move following entries of the same probe sequence back into the hole, so that no lookup ends
+  // prematurely at an empty slot.
+  for (std::size_t i = (hole + 1) & mask; isValid(mSlots[i].mTileId); i = (i + 1) & mask) {
+    std::size_t home = hash(mSlots[i].mTileId) & mask;
+
+    // The entry may only be moved if its home slot is not in the (cyclic) range (hole, i].
+    if (((i - home) & mask) >= ((i - hole) & mask)) {
+      mSlots[hole] = mSlots[i];
+      hole         = i;
+    }
+  }
+
+  mSlots[hole] = Slot();
+  --mSize;
+
+  return true;
+}
+
+template <typename T>
+void TileIdMap<T>::clear() {
+  for (auto& slot : mSlots) {
+    slot = Slot();
+  }
+
+  mSize = 0;
+}
+
+template <typename T>
+void TileIdMap<T>::reserve(std::size_t count) {
+  std::size_t capacity = 16;
+  while (count * 4 > capacity * 3) {
+    capacity *= 2;
+  }
+
+  if (capacity > mSlots.size()) {
+    rehash(capacity);
+  }
+}
+
+template <typename T>
+std::size_t TileIdMap<T>::size() const {
+  return mSize;
+}
+
+template <typename T>
+bool TileIdMap<T>::empty() const {
+  return mSize == 0;
+}
+
+template <typename T>
+std::size_t TileIdMap<T>::hash(TileId const& tileId) {
+  // Patch indices of neighbouring tiles differ only in their lowest bits, so they are mixed with
+  // the finalizer of splitmix64 in order to spread them over the whole table.
+  auto key = static_cast<uint64_t>(tileId.patchIdx()) << 6U;
+  key      = key ^ static_cast<uint64_t>(tileId.level());
+  key      = (key ^ (key >> 30U)) * 0xbf58476d1ce4e5b9ULL;
+  key      = (key ^ (key >> 27U)) * 0x94d049bb133111ebULL;
+  return static_cast<std::size_t>(key ^ (key >> 31U));
+}
+
+template <typename T>
+std::size_t TileIdMap<T>::findSlot(TileId const& tileId) const {
+  std::size_t mask = mSlots.size() - 1;
+  std::size_t i    = hash(tileId) & mask;
+
+  while (isValid(mSlots[i].mTileId) && !(mSlots[i].mTileId == tileId)) {
+    i = (i + 1) & mask;
+  }
+
+  return i;
+}
+
+template <typename T>
+void TileIdMap<T>::rehash(std::size_t capacity) {
+  std::vector<Slot> slots(capacity);
+  std::swap(slots, mSlots);
+
+  for (auto const& slot : slots) {
+    if (isValid(slot.mTileId)) {
+      mSlots[findSlot(slot.mTileId)] = slot;
+    }
+  }
+}
+
+} // namespace csp::lodbodies
+
+#endif // CSP_LOD_BODIES_TILEIDMAP_HPP
@@ -0,0 +1,156 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "TileLayerAllocator.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace csp::lodbodies {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileLayerAllocator::TileLayerAllocator(int pageSize, int maxLayerCount)
+    : mPageSize(pageSize)
+    , mMaxLayerCount(maxLayerCount) {
+  assert(pageSize > 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int TileLayerAllocator::allocate() {
+  if (mFree.empty()) {
+    int capacity =
+        std::min(mMaxLayerCount, roundToPages(std::max(mCapacity + 1, mCapacity * 3 / 2)));
+
+    if (capacity <= mCapacity) {
+      return -1;
+    }
+
+    for (int layer = mCapacity; layer < capacity; ++layer) {
+      mFree.insert(mFree.end(), layer);
+    }
+
+    mCapacity = capacity;
+  }
+
+  int layer = *mFree.begin();
+  mFree.erase(mFree.begin());
+  mUsed.insert(layer);
+
+  return layer;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileLayerAllocator::release(int layer) {
+  [[maybe_unused]] std::size_t erased = mUsed.erase(layer);
+  assert(erased == 1);
+
+  mFree.insert(layer);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<TileLayerAllocator::Move> TileLayerAllocator::compact(int maxMoves) {
+  std::vector<Move> moves;
+
+  // Compacting is only worth it if the storage can be shrunk afterwards.
+  int const required = roundToPages(static_cast<int>(mUsed.size()));
+
+  if (mCapacity - required < 2 * mPageSize) {
+    return moves;
+  }
+
+  // There are at least as many free layers below the required capacity as there are used layers
+  // beyond it, so the lowest free layer is always a valid target.
+  while (static_cast<int>(moves.size()) < maxMoves && !mUsed.empty() &&
+         *mUsed.rbegin() >= required) {
+    Move move{*mUsed.rbegin(), *mFree.begin()};
+
+    mUsed.erase(move.mFrom);
+    mFree.erase(mFree.begin());
+    mUsed.insert(move.mTo);
+    mFree.insert(move.mFrom);
+
+    moves.push_back(move);
+  }
+
+  return moves;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TileLayerAllocator::shrink() {
+  int const end      = mUsed.empty() ? 0 : *mUsed.rbegin() + 1;
+  int const capacity = std::min(mMaxLayerCount, roundToPages(end) + mPageSize);
+
+  if (mCapacity - roundToPages(end) < 2 * mPageSize || capacity >= mCapacity) {
+    return false;
+  }
+
+  mFree.erase(mFree.lower_bound(capacity), mFree.end());
+  mCapacity = capacity;
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TileLayerAllocator::setMaxLayerCount(int maxLayerCount) {
+  if (!mUsed.empty() && *mUsed.rbegin() >= maxLayerCount) {
+    return false;
+  }
+
+  mMaxLayerCount = maxLayerCount;
+
+  if (mCapacity > maxLayerCount) {
+    mFree.erase(mFree.lower_bound(maxLayerCount), mFree.end());
+    mCapacity = maxLayerCount;
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int TileLayerAllocator::getMaxLayerCount() const {
+  return mMaxLayerCount;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int TileLayerAllocator::getPageSize() const {
+  return mPageSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int TileLayerAllocator::getCapacity() const {
+  return mCapacity;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int TileLayerAllocator::getUsedCount() const {
+  return static_cast<int>(mUsed.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TileLayerAllocator::isUsed(int layer) const {
+  return mUsed.count(layer) > 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int TileLayerAllocator::roundToPages(int layerCount) const {
+  return (layerCount + mPageSize - 1) / mPageSize * mPageSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::lodbodies
@@ -0,0 +1,78 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_LOD_BODIES_TILELAYERALLOCATOR_HPP
+#define CSP_LOD_BODIES_TILELAYERALLOCATOR_HPP
+
+#include <set>
+#include <vector>
+
+namespace csp::lodbodies {
+
+/// Manages the layers of a TileTextureArray on the CPU. The capacity grows and shrinks in pages of
+/// a fixed number of layers, so that the GPU storage follows the working set.
+///
+/// Free layers are handed out lowest first. This keeps the used layers at the beginning of the
+/// storage, so that pages at its end become empty when fewer tiles are needed. If the remaining
+/// used layers are scattered, compact() moves the highest of them into free layers further down.
+/// Once at least two pages at the end are unused, shrink() releases all but one of them. This
+/// hysteresis prevents the storage from being resized back and forth.
+class TileLayerAllocator {
+ public:
+  /// A layer which has to be copied in the GPU storage. The source layer is free afterwards.
+  struct Move {
+    int mFrom;
+    int mTo;
+  };
+
+  /// The capacity is always a multiple of pageSize, except when it is limited by maxLayerCount.
+  /// Initially, the capacity is zero.
+  TileLayerAllocator(int pageSize, int maxLayerCount);
+
+  /// Returns the lowest free layer. If there is none, the capacity is increased by half of its
+  /// current size but at least by one page. Returns -1 if the capacity cannot grow any further.
+  int allocate();
+
+  /// Marks the given layer as free.
+  void release(int layer);
+
+  /// Plans up to maxMoves layer copies which move used layers from the end of the storage into
+  /// free layers further down. The allocator treats the moves as done, so the caller has to apply
+  /// all of them before the storage is shrunk.
+  std::vector<Move> compact(int maxMoves);
+
+  /// Reduces the capacity if there are at least two unused pages at the end of the storage. One
+  /// page is kept as headroom for new allocations. Returns true if the capacity has been reduced.
+  bool shrink();
+
+  /// Limits the capacity. The limit can only be lowered if no layer at or beyond the new limit is
+  /// in use. Returns false otherwise.
+  bool setMaxLayerCount(int maxLayerCount);
+  int  getMaxLayerCount() const;
+
+  int getPageSize() const;
+  int getCapacity() const;
+  int getUsedCount() const;
+
+  /// Returns true if the given layer has been returned by allocate() or by a move of compact() and
+  /// has not been released since.
+  bool isUsed(int layer) const;
+
+ private:
+  /// Rounds the given number of layers up to whole pages.
+  int roundToPages(int layerCount) const;
+
+  int mPageSize;
+  int mMaxLayerCount;
+  int mCapacity = 0;
+
+  std::set<int> mFree;
+  std::set<int> mUsed;
+};
+
+} // namespace csp::lodbodies
+
+#endif // CSP_LOD_BODIES_TILELAYERALLOCATOR_HPP
@@ -0,0 +1,516 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "TileMemoryCache.hpp"
+
+#include "MinMaxPyramid.hpp"
+#include "Tile.hpp"
+#include "TileNode.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+
+namespace csp::lodbodies {
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The residuals are bit-packed in blocks of this many values. Each block starts with a byte
+// containing the bit width of its values.
+int const cBlockSize = 32;
+
+int const cSampleCount = TileBase::SizeX * TileBase::SizeY;
+
+// Returns the size of the uncompressed data of a tile.
+uint64_t getRawSize(TileDataType dataType) {
+  switch (dataType) {
+  case TileDataType::eFloat32:
+    return cSampleCount * sizeof(float);
+  case TileDataType::eU8Vec3:
+    return cSampleCount * sizeof(glm::u8vec3);
+  default:
+    return cSampleCount * sizeof(glm::uint8);
+  }
+}
+
+// Elevation samples are mapped to unsigned integers which have the same order as the floats. This
+// way, neighbouring samples with similar heights have similar integers, also across zero.
+uint32_t floatToOrdered(float value) {
+  uint32_t bits{};
+  std::memcpy(&bits, &value, sizeof(bits));
+  return (bits & 0x80000000U) != 0 ? ~bits : bits | 0x80000000U;
+}
+
+float orderedToFloat(uint32_t ordered) {
+  uint32_t bits  = (ordered & 0x80000000U) != 0 ? ordered & 0x7FFFFFFFU : ~ordered;
+  float    value = 0.F;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Predicts a sample from its left, upper and upper-left neighbours. All arithmetic wraps around, so
+// the prediction is exact to reverse. The samples of the channel are stride elements apart.
+template <typename T>
+uint32_t predict(T const* samples, int stride, int x, int y) {
+  auto at = [&](int i, int j) {
+    return static_cast<uint32_t>(samples[(i + j * TileBase::SizeX) * stride]);
+  };
+
+  if (y == 0) {
+    return x == 0 ? 0 : at(x - 1, 0);
+  }
+
+  if (x == 0) {
+    return at(0, y - 1);
+  }
+
+  return at(x - 1, y) + at(x, y - 1) - at(x - 1, y - 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Appends one channel of a tile to data. The channel has samples of the given number of bits.
+template <typename T>
+void encodeChannel(T const* samples, int stride, std::vector<uint8_t>& data) {
+  uint32_t const bits = sizeof(T) * 8;
+  uint32_t const mask = bits == 32 ? 0xFFFFFFFFU : (1U << bits) - 1U;
+
+  std::array<uint32_t, cBlockSize> block{};
+  int                              count = 0;
+
+  auto flush = [&]() {
+    uint32_t all = 0;
+    for (int i = 0; i < count; ++i) {
+      all |= block.at(i);
+    }
+
+    uint32_t width = 0;
+    while (width < 32 && (all >> width) != 0) {
+      ++width;
+    }
+
+    data.push_back(static_cast<uint8_t>(width));
+
+    uint64_t buffer = 0;
+    uint32_t filled = 0;
+
+    for (int i = 0; i < count; ++i) {
+      buffer |= static_cast<uint64_t>(block.at(i)) << filled;
+      filled += width;
+
+      while (filled >= 8) {
+        data.push_back(static_cast<uint8_t>(buffer));
+        buffer >>= 8;
+        filled -= 8;
+      }
+    }
+
+    if (filled > 0) {
+      data.push_back(static_cast<uint8_t>(buffer));
+    }
+
+    count = 0;
+  };
+
+  for (int y = 0; y < TileBase::SizeY; ++y) {
+    for (int x = 0; x < TileBase::SizeX; ++x) {
+      uint32_t value    = samples[(x + y * TileBase::SizeX) * stride];
+      uint32_t residual = (value - predict(samples, stride, x, y)) & mask;
+
+      // Zigzag encoding maps small negative residuals to small positive numbers.
+      block.at(count++) = ((residual << 1U) ^ (0U - (residual >> (bits - 1)))) & mask;
+
+      if (count == cBlockSize) {
+        flush();
+      }
+    }
+  }
+
+  if (count > 0) {
+    flush();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Reads one channel written by encodeChannel() starting at the given position of data. Returns
+// false if the data is too short.
+template <typename T>
+bool decodeChannel(
+    std::vector<uint8_t> const& data, std::size_t& position, T* samples, int stride) {
+  uint32_t const bits = sizeof(T) * 8;
+  uint32_t const mask = bits == 32 ? 0xFFFFFFFFU : (1U << bits) - 1U;
+
+  std::array<uint32_t, cBlockSize> block{};
+  int                              available = 0;
+  int                              next      = 0;
+  int                              remaining = cSampleCount;
+
+  auto fill = [&]() {
+    if (position >= data.size()) {
+      return false;
+    }
+
+    uint32_t width = data[position++];
+    available      = std::min(remaining, cBlockSize);
+    next           = 0;
+
+    if (width > 32 || position + (available * width + 7) / 8 > data.size()) {
+      return false;
+    }
+
+    uint64_t buffer    = 0;
+    uint32_t filled    = 0;
+    uint64_t valueMask = (1ULL << width) - 1U;
+
+    for (int i = 0; i < available; ++i) {
+      while (filled < width) {
+        buffer |= static_cast<uint64_t>(data[position++]) << filled;
+        filled += 8;
+      }
+
+      block.at(i) = static_cast<uint32_t>(buffer & valueMask);
+      buffer >>= width;
+      filled -= width;
+    }
+
+    remaining -= available;
+    return true;
+  };
+
+  for (int y = 0; y < TileBase::SizeY; ++y) {
+    for (int x = 0; x < TileBase::SizeX; ++x) {
+      if (next == available && !fill()) {
+        return false;
+      }
+
+      uint32_t zigzag   = block.at(next++);
+      uint32_t residual = ((zigzag >> 1U) ^ (0U - (zigzag & 1U))) & mask;
+
+      samples[(x + y * TileBase::SizeX) * stride] =
+          static_cast<T>((predict(samples, stride, x, y) + residual) & mask);
+    }
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double millisecondsSince(std::chrono::high_resolution_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+      std::chrono::high_resolution_clock::now() - start)
+      .count();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileMemoryCache::TileMemoryCache(std::shared_ptr<MinMaxPyramidArena> pyramidArena)
+    : mPyramidArena(std::move(pyramidArena)) {
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileMemoryCache::~TileMemoryCache() {
+  // The tasks access the members, so they have to be finished first.
+  std::unique_lock<std::mutex> lock(mTaskMutex);
+  mTasksDone.wait(lock, [this]() { return mTaskCount == 0; });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileMemoryCache::setMaxSize(uint64_t bytes) {
+  std::unique_lock<std::mutex> lock(mMutex);
+  mMaxSize = bytes;
+  evict();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint64_t TileMemoryCache::getMaxSize() const {
+  std::unique_lock<std::mutex> lock(mMutex);
+  return mMaxSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileMemoryCache::store(TileBase const& tile, int childMaxLevel) {
+  uint64_t generation{};
+
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    if (mMaxSize == 0 || find(tile.getTileId())) {
+      return;
+    }
+
+    generation = mGeneration;
+  }
+
+  auto start = std::chrono::high_resolution_clock::now();
+  auto data  = std::make_shared<std::vector<uint8_t> const>(compress(tile));
+  auto time  = millisecondsSince(start);
+
+  std::unique_lock<std::mutex> lock(mMutex);
+  mStatistics.mEncodeTime += time;
+
+  // The cache has been cleared in the meantime or the tile has been stored by another thread.
+  if (generation != mGeneration || mEntries.count(tile.getTileId()) > 0) {
+    return;
+  }
+
+  mLru.push_front(tile.getTileId());
+  mEntries.emplace(
+      tile.getTileId(), Entry{tile.getDataType(), childMaxLevel, data, mLru.begin()});
+
+  mStatistics.mSize += data->size();
+  mStatistics.mRawSize += getRawSize(tile.getDataType());
+
+  evict();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileMemoryCache::storeAsync(std::unique_ptr<TileBase> tile, int childMaxLevel) {
+  if (getMaxSize() == 0) {
+    return;
+  }
+
+  // The tile is destroyed together with the task on the worker thread.
+  std::shared_ptr<TileBase const> shared(std::move(tile));
+  enqueue([this, shared, childMaxLevel]() { store(*shared, childMaxLevel); },
+      cs::utils::TaskHandle());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileNode* TileMemoryCache::load(TileId const& tileId) {
+  Entry entry{};
+
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    if (mMaxSize == 0) {
+      return nullptr;
+    }
+
+    Entry* cached = find(tileId);
+    if (!cached) {
+      ++mStatistics.mMisses;
+      return nullptr;
+    }
+
+    ++mStatistics.mHits;
+    entry = *cached;
+  }
+
+  return createNode(tileId, entry);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TileMemoryCache::loadAsync(TileId const& tileId, std::function<void(TileNode*)> callback,
+    cs::utils::TaskHandle const& handle) {
+  Entry entry{};
+
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    if (mMaxSize == 0) {
+      return false;
+    }
+
+    Entry* cached = find(tileId);
+    if (!cached) {
+      ++mStatistics.mMisses;
+      return false;
+    }
+
+    ++mStatistics.mHits;
+    entry = *cached;
+  }
+
+  enqueue(
+      [this, tileId, entry, callback = std::move(callback)]() {
+        callback(createNode(tileId, entry));
+      },
+      handle);
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileMemoryCache::reprioritizeRequests() {
+  cs::utils::getSharedThreadPool().reprioritize();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileMemoryCache::clear() {
+  std::unique_lock<std::mutex> lock(mMutex);
+  mEntries.clear();
+  mLru.clear();
+  mStatistics.mSize    = 0;
+  mStatistics.mRawSize = 0;
+  ++mGeneration;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileMemoryCache::Statistics TileMemoryCache::getStatistics() const {
+  std::unique_lock<std::mutex> lock(mMutex);
+  Statistics statistics = mStatistics;
+  statistics.mTileCount = mEntries.size();
+  return statistics;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<uint8_t> TileMemoryCache::compress(TileBase const& tile) {
+  std::vector<uint8_t> data;
+
+  if (tile.getDataType() == TileDataType::eFloat32) {
+    auto const& samples = static_cast<Tile<float> const&>(tile).data();
+
+    std::vector<uint32_t> ordered(samples.size());
+    for (std::size_t i = 0; i < samples.size(); ++i) {
+      ordered[i] = floatToOrdered(samples[i]);
+    }
+
+    encodeChannel(ordered.data(), 1, data);
+  } else {
+    int const channels = tile.getDataType() == TileDataType::eU8Vec3 ? 3 : 1;
+    auto      bytes    = static_cast<uint8_t const*>(tile.getDataPtr());
+
+    for (int c = 0; c < channels; ++c) {
+      encodeChannel(bytes + c, channels, data);
+    }
+  }
+
+  return data;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::unique_ptr<TileBase> TileMemoryCache::decompress(
+    std::vector<uint8_t> const& data, TileDataType dataType, TileId const& tileId) {
+  std::size_t position = 0;
+
+  if (dataType == TileDataType::eFloat32) {
+    auto tile = std::make_unique<Tile<float>>(tileId.level(), tileId.patchIdx());
+
+    std::vector<uint32_t> ordered(cSampleCount);
+    if (!decodeChannel(data, position, ordered.data(), 1)) {
+      return nullptr;
+    }
+
+    for (std::size_t i = 0; i < ordered.size(); ++i) {
+      tile->data()[i] = orderedToFloat(ordered[i]);
+    }
+
+    return tile;
+  }
+
+  auto decode = [&](auto tile, int channels) -> std::unique_ptr<TileBase> {
+    auto* bytes = reinterpret_cast<uint8_t*>(tile->data().data());
+
+    for (int c = 0; c < channels; ++c) {
+      if (!decodeChannel(data, position, bytes + c, channels)) {
+        return nullptr;
+      }
+    }
+
+    return tile;
+  };
+
+  if (dataType == TileDataType::eU8Vec3) {
+    return decode(std::make_unique<Tile<glm::u8vec3>>(tileId.level(), tileId.patchIdx()), 3);
+  }
+
+  return decode(std::make_unique<Tile<glm::uint8>>(tileId.level(), tileId.patchIdx()), 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileMemoryCache::Entry* TileMemoryCache::find(TileId const& tileId) {
+  auto it = mEntries.find(tileId);
+  if (it == mEntries.end()) {
+    return nullptr;
+  }
+
+  mLru.splice(mLru.begin(), mLru, it->second.mLruPosition);
+  return &it->second;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileNode* TileMemoryCache::createNode(TileId const& tileId, Entry const& entry) {
+  auto start = std::chrono::high_resolution_clock::now();
+  auto tile  = decompress(*entry.mData, entry.mDataType, tileId);
+
+  if (!tile) {
+    return nullptr;
+  }
+
+  if (entry.mDataType == TileDataType::eFloat32) {
+    auto* demTile = static_cast<Tile<float>*>(tile.get());
+    demTile->setMinMaxPyramid(std::make_unique<MinMaxPyramid>(demTile, mPyramidArena));
+  }
+
+  auto time = millisecondsSince(start);
+
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mStatistics.mDecodeTime += time;
+  }
+
+  // NOLINTNEXTLINE(cppcoreguidelines-owning-memory): The TreeManagerBase takes the ownership.
+  return new TileNode(std::move(tile), entry.mChildMaxLevel);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileMemoryCache::evict() {
+  while (mStatistics.mSize > mMaxSize && !mLru.empty()) {
+    auto it = mEntries.find(mLru.back());
+    mStatistics.mSize -= it->second.mData->size();
+    mStatistics.mRawSize -= getRawSize(it->second.mDataType);
+    mEntries.erase(it);
+    mLru.pop_back();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileMemoryCache::enqueue(
+    std::function<void()> task, cs::utils::TaskHandle const& handle) {
+  {
+    std::unique_lock<std::mutex> lock(mTaskMutex);
+    ++mTaskCount;
+  }
+
+  // The guard is destroyed together with the task, no matter whether it has been executed or
+  // dropped by the thread pool.
+  std::shared_ptr<void> guard(nullptr, [this](void* /*unused*/) {
+    std::unique_lock<std::mutex> lock(mTaskMutex);
+    --mTaskCount;
+    mTasksDone.notify_all();
+  });
+
+  cs::utils::getSharedThreadPool().enqueue(
+      [task = std::move(task), guard = std::move(guard)]() { task(); }, handle);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::lodbodies
@@ -0,0 +1,149 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_LOD_BODIES_TILEMEMORYCACHE_HPP
+#define CSP_LOD_BODIES_TILEMEMORYCACHE_HPP
+
+#include "TileDataType.hpp"
+#include "TileId.hpp"
+
+#include "../../../src/cs-utils/ThreadPool.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace csp::lodbodies {
+
+class MinMaxPyramidArena;
+class TileBase;
+class TileNode;
+
+/// The TileMemoryCache sits between the TileQuadTree and the TileSource of a TreeManagerBase. Tiles
+/// which are pruned from the tree are compressed on a background thread and kept in memory up to a
+/// configurable size. If such a tile is requested again, it is decompressed on a background thread
+/// instead of being loaded from the TileSource. Once the configured size is exceeded, the least
+/// recently used tiles are dropped. The background threads are those of
+/// cs::utils::getSharedThreadPool().
+///
+/// The compression is lossless. Each channel of a tile is predicted from its left, upper and
+/// upper-left neighbours. Elevation samples are mapped to integers first, so that the order of the
+/// floats is preserved. The prediction residuals are zigzag-encoded and bit-packed in blocks of 32
+/// values, each block using the smallest bit width which can represent all of its values.
+///
+/// All methods are thread-safe.
+class TileMemoryCache {
+ public:
+  /// Counters for monitoring the efficiency of the cache.
+  struct Statistics {
+    uint64_t mHits       = 0;   ///< The number of requested tiles which were found in the cache.
+    uint64_t mMisses     = 0;   ///< The number of requested tiles which were not in the cache.
+    uint64_t mTileCount  = 0;   ///< The number of currently cached tiles.
+    uint64_t mSize       = 0;   ///< The compressed size of all cached tiles in bytes.
+    uint64_t mRawSize    = 0;   ///< The uncompressed size of all cached tiles in bytes.
+    double   mEncodeTime = 0.0; ///< The accumulated time spent compressing tiles in milliseconds.
+    double   mDecodeTime = 0.0; ///< The accumulated time spent decompressing tiles in milliseconds.
+  };
+
+  /// The MinMaxPyramids of decompressed elevation tiles are created from the given arena. It may be
+  /// nullptr.
+  explicit TileMemoryCache(std::shared_ptr<MinMaxPyramidArena> pyramidArena);
+
+  TileMemoryCache(TileMemoryCache const& other) = delete;
+  TileMemoryCache(TileMemoryCache&& other)      = delete;
+
+  TileMemoryCache& operator=(TileMemoryCache const& other) = delete;
+  TileMemoryCache& operator=(TileMemoryCache&& other) = delete;
+
+  /// Waits for all background tasks of this cache.
+  ~TileMemoryCache();
+
+  /// The maximum accumulated size of all compressed tiles in bytes. If the cache already is larger,
+  /// the least recently used tiles are dropped immediately. If set to zero, nothing is cached. The
+  /// default is zero.
+  void     setMaxSize(uint64_t bytes);
+  uint64_t getMaxSize() const;
+
+  /// Compresses the given tile and adds it to the cache. If the tile is cached already, it is only
+  /// marked as recently used. The childMaxLevel is restored when the tile is loaded again.
+  void store(TileBase const& tile, int childMaxLevel);
+
+  /// Like store(), but the tile is compressed and destroyed on a background thread.
+  void storeAsync(std::unique_ptr<TileBase> tile, int childMaxLevel);
+
+  /// Returns a new node with the decompressed tile or nullptr if the tile is not cached.
+  TileNode* load(TileId const& tileId);
+
+  /// If the tile is cached, it is decompressed on a background thread and the callback is invoked
+  /// with a new node from there. The given TaskHandle can be used to change the priority of the
+  /// request or to cancel it while it is still pending. Returns false if the tile is not cached;
+  /// the callback is not invoked in this case.
+  bool loadAsync(TileId const& tileId, std::function<void(TileNode*)> callback,
+      cs::utils::TaskHandle const& handle);
+
+  /// Applies priority changes made to the TaskHandles of pending loadAsync() requests.
+  void reprioritizeRequests();
+
+  /// Removes all tiles. Tiles which are currently compressed in the background are dropped as
+  /// well. The statistics are not reset.
+  void clear();
+
+  /// Returns the current counters.
+  Statistics getStatistics() const;
+
+  /// Compresses the data of the given tile.
+  static std::vector<uint8_t> compress(TileBase const& tile);
+
+  /// Creates a tile from the data returned by compress(). No MinMaxPyramid is created for the tile.
+  /// Returns nullptr if the data is invalid.
+  static std::unique_ptr<TileBase> decompress(
+      std::vector<uint8_t> const& data, TileDataType dataType, TileId const& tileId);
+
+ private:
+  struct Entry {
+    TileDataType                                mDataType;
+    int                                         mChildMaxLevel;
+    std::shared_ptr<std::vector<uint8_t> const> mData;
+    std::list<TileId>::iterator                 mLruPosition;
+  };
+
+  /// Returns the entry for the given tile and marks it as recently used. This requires mMutex to
+  /// be locked. Returns nullptr if the tile is not cached.
+  Entry* find(TileId const& tileId);
+
+  /// Decompresses the given entry and creates a node for it.
+  TileNode* createNode(TileId const& tileId, Entry const& entry);
+
+  /// Drops the least recently used tiles until the cache is smaller than mMaxSize. This requires
+  /// mMutex to be locked.
+  void evict();
+
+  /// Runs the given task on the shared thread pool. It is counted in mTaskCount until it has
+  /// finished or has been dropped because the handle was cancelled.
+  void enqueue(std::function<void()> task, cs::utils::TaskHandle const& handle);
+
+  std::shared_ptr<MinMaxPyramidArena> mPyramidArena;
+
+  mutable std::mutex                mMutex;
+  std::unordered_map<TileId, Entry> mEntries;
+  std::list<TileId>                 mLru;
+  uint64_t                          mMaxSize    = 0;
+  uint64_t                          mGeneration = 0;
+  Statistics                        mStatistics;
+
+  std::mutex              mTaskMutex;
+  std::condition_variable mTasksDone;
+  uint32_t                mTaskCount = 0;
+};
+
+} // namespace csp::lodbodies
+
+#endif // CSP_LOD_BODIES_TILEMEMORYCACHE_HPP
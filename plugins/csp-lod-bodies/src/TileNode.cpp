@@ -6,10 +6,47 @@
 
 #include "TileNode.hpp"
 
+#include <boost/pool/singleton_pool.hpp>
+#include <cassert>
+#include <new>
+
 namespace csp::lodbodies {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+// The default mutex of boost::singleton_pool makes this safe to use from the
+// loader threads of the tile sources.
+struct TileNodePoolTag {};
+using TileNodePool = boost::singleton_pool<TileNodePoolTag, sizeof(TileNode)>;
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void* TileNode::operator new([[maybe_unused]] std::size_t size) {
+  assert(size == sizeof(TileNode));
+
+  void* ptr = TileNodePool::malloc();
+
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+
+  return ptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileNode::operator delete(void* ptr) {
+  if (ptr) {
+    TileNodePool::free(ptr);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 TileNode::TileNode()
     : mTile()
     , mParent(nullptr)
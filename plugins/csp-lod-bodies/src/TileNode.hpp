@@ -15,6 +15,9 @@ namespace csp::lodbodies {
 
 /// Node in a quad tree of tiles. It stores pointers to its four child nodes (if present), the
 /// parent TileNode (unless it is a root node) and to the tile of data associated with this node.
+///
+/// Nodes are created by the tile sources and destroyed by the TreeManagerBase at a high rate, so
+/// they are allocated from a thread-safe pool instead of the general-purpose heap.
 class TileNode {
  private:
   BOOST_MOVABLE_BUT_NOT_COPYABLE(TileNode)
@@ -24,6 +27,9 @@ class TileNode {
   explicit TileNode(TileBase* tile, int childMaxLevel = -1);
   explicit TileNode(std::unique_ptr<TileBase>&& tile, int childMaxLevel = -1);
 
+  static void* operator new(std::size_t size);
+  static void  operator delete(void* ptr);
+
   // move constructor -- disabled: triggers a bug with gcc 4.3?
   //     TileNode(BOOST_RV_REF(TileNode) source);
 
@@ -18,6 +18,12 @@ TileNode* TileQuadTree::getRoot(int idx) const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+TileNode* TileQuadTree::releaseRoot(int idx) {
+  return mRoots.at(idx).release();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void TileQuadTree::setRoot(int idx, TileNode* root) {
   mRoots.at(idx).reset(root);
 }
@@ -54,27 +60,26 @@ bool insertNode(TileQuadTree* tree, TileNode* node) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-bool removeNode(TileQuadTree* tree, TileNode* node) {
-  bool      result = false;
-  TileNode* parent = node->getParent();
+TileNode* releaseNode(TileQuadTree* tree, TileNode* node) {
+  TileNode* parent   = node->getParent();
+  int       childIdx = HEALPix::getChildIdx(node->getTileId());
 
   // node must either have a parent or be a root of the tree (otherwise node
   // is not in tree or the data structure is corrupt).
   if (parent) {
-    int childIdx = HEALPix::getChildIdx(node->getTileId());
     assert(parent->getChild(childIdx) == node);
+    return parent->releaseChild(childIdx);
+  }
 
-    parent->setChild(childIdx, nullptr);
-    result = true;
-  } else {
-    int childIdx = HEALPix::getChildIdx(node->getTileId());
-    assert(tree->getRoot(childIdx) == node);
+  assert(tree->getRoot(childIdx) == node);
+  return tree->releaseRoot(childIdx);
+}
 
-    tree->setRoot(childIdx, nullptr);
-    result = true;
-  }
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-  return result;
+bool removeNode(TileQuadTree* tree, TileNode* node) {
+  std::unique_ptr<TileNode> released(releaseNode(tree, node));
+  return released != nullptr;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -35,6 +35,10 @@ class TileQuadTree {
 /// not all parents of node are currently in tree.
 bool insertNode(TileQuadTree* tree, TileNode* node);
 
+/// Removes node from tree and returns it together with its children. Ownership of the node is
+/// passed to the caller. Returns nullptr if node does not have a valid parent and is not a root.
+TileNode* releaseNode(TileQuadTree* tree, TileNode* node);
+
 /// Removes node from tree and returns true if it succeeded, false otherwise. If true is returned
 /// the object pointed to by node does NOT exist any longer. Removal can fail if node does not have
 /// a valid parent and is not a root.
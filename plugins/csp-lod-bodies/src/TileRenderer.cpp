@@ -14,6 +14,7 @@
 #include "TreeManagerBase.hpp"
 
 #include "../../../src/cs-graphics/Shadows.hpp"
+#include "../../../src/cs-utils/ThreadPool.hpp"
 #include "../../../src/cs-utils/convert.hpp"
 
 #include <VistaBase/VistaStreamUtils.h>
@@ -23,7 +24,9 @@
 #include <VistaOGLExt/VistaTexture.h>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/io.hpp>
+#include <algorithm>
 #include <memory>
+#include <numeric>
 
 namespace csp::lodbodies {
 
@@ -38,6 +41,17 @@ GLint const  texUnitIMG     = 1;
 
 GLint const texUnitShadow = 2;
 
+// The binding point of the shader storage buffer with the tile parameters and the attribute
+// location of the tile index for multi-draw indirect rendering.
+GLuint const tileBufferBinding  = 0;
+GLuint const tileIndexAttribute = 1;
+
+// The number of tiles whose parameters are computed by one task for multi-draw indirect rendering.
+std::size_t const tileChunkSize = 128;
+
+// The initial number of entries in the buffer with the tile indices.
+std::size_t const minTileIndexCount = 1024;
+
 GLsizeiptr const SizeX = TileBase::SizeX; // NOLINT(cppcoreguidelines-interfaces-global-init)
 GLsizeiptr const SizeY = TileBase::SizeY; // NOLINT(cppcoreguidelines-interfaces-global-init)
 // number of vertices that make up a patch
@@ -289,6 +303,24 @@ glm::ivec4 calcEdgeOffset(RenderDataDEM* rdDEM) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// Multi-draw indirect rendering requires OpenGL 4.3 and a vertex shader which can access a shader
+// storage buffer. Some implementations support 4.3 but no storage buffers in vertex shaders.
+bool isMultiDrawIndirectSupported() {
+  static bool const supported = []() {
+    if (!GLEW_VERSION_4_3) {
+      return false;
+    }
+
+    GLint maxBlocks = 0;
+    glGetIntegerv(GL_MAX_VERTEX_SHADER_STORAGE_BLOCKS, &maxBlocks);
+    return maxBlocks > 0;
+  }();
+
+  return supported;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 } // namespace
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -296,6 +328,8 @@ glm::ivec4 calcEdgeOffset(RenderDataDEM* rdDEM) {
 std::unique_ptr<VistaBufferObject>      TileRenderer::mVboTerrain;
 std::unique_ptr<VistaBufferObject>      TileRenderer::mIboTerrain;
 std::unique_ptr<VistaVertexArrayObject> TileRenderer::mVaoTerrain;
+std::unique_ptr<VistaBufferObject>      TileRenderer::mVboTileIndices;
+std::size_t                             TileRenderer::mTileIndexCount = 0;
 std::unique_ptr<VistaBufferObject>      TileRenderer::mVboBounds;
 std::unique_ptr<VistaBufferObject>      TileRenderer::mIboBounds;
 std::unique_ptr<VistaVertexArrayObject> TileRenderer::mVaoBounds;
@@ -316,7 +350,8 @@ TileRenderer::TileRenderer(
     , mEnableDrawTiles(true)
     , mEnableDrawBounds(false)
     , mEnableWireframe(false)
-    , mEnableFaceCulling(true) {
+    , mEnableFaceCulling(true)
+    , mEnableMultiDrawIndirect(true) {
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -383,6 +418,7 @@ void TileRenderer::preRenderTiles(cs::graphics::ShadowMap* shadowMap) {
   }
 
   mVaoTerrain->Bind();
+  mProgTerrain->setMultiDraw(useMultiDrawIndirect());
   mProgTerrain->bind();
   VistaGLSLShader& shader = mProgTerrain->mShader;
 
@@ -427,24 +463,11 @@ void TileRenderer::preRenderTiles(cs::graphics::ShadowMap* shadowMap) {
 
 void TileRenderer::renderTiles(
     std::vector<RenderData*> const& renderDEM, std::vector<RenderData*> const& renderIMG) {
-  VistaGLSLShader& shader = mProgTerrain->mShader;
-
-  // query uniform locations once and store in locs
-  UniformLocs locs{};
-  locs.demAverageHeight = shader.GetUniformLocation("VP_demAverageHeight");
-  locs.tileOffsetScale  = shader.GetUniformLocation("VP_tileOffsetScale");
-  locs.demOffsetScale   = shader.GetUniformLocation("VP_demOffsetScale");
-  locs.imgOffsetScale   = shader.GetUniformLocation("VP_imgOffsetScale");
-  locs.edgeDelta        = shader.GetUniformLocation("VP_edgeDelta");
-  locs.edgeLayerDEM     = shader.GetUniformLocation("VP_edgeLayerDEM");
-  locs.edgeOffset       = shader.GetUniformLocation("VP_edgeOffset");
-  locs.f1f2             = shader.GetUniformLocation("VP_f1f2");
-  locs.layerDEM         = shader.GetUniformLocation("VP_layerDEM");
-  locs.layerIMG         = shader.GetUniformLocation("VP_layerIMG");
-
   int missingDEM = 0;
   int missingIMG = 0;
 
+  mTiles.clear();
+
   // iterate over both std::vector<RenderData*>s together
   for (size_t i(0); i < renderDEM.size(); ++i) {
     // get data associated with nodes
@@ -466,8 +489,38 @@ void TileRenderer::renderTiles(
       continue;
     }
 
-    // render
-    renderTile(rdDEM, rdIMG, locs);
+    mTiles.emplace_back(rdDEM, rdIMG);
+  }
+
+  // The normals are transformed with the inverse transpose of the modelview matrix.
+  glm::dmat4 matNormal = glm::transpose(glm::inverse(mMatVM));
+
+  if (useMultiDrawIndirect()) {
+    renderTilesIndirect(matNormal);
+  } else {
+    VistaGLSLShader& shader = mProgTerrain->mShader;
+
+    // query uniform locations once and store in locs
+    UniformLocs locs{};
+    locs.demAverageHeight = shader.GetUniformLocation("VP_demAverageHeight");
+    locs.tileOffsetScale  = shader.GetUniformLocation("VP_tileOffsetScale");
+    locs.demOffsetScale   = shader.GetUniformLocation("VP_demOffsetScale");
+    locs.imgOffsetScale   = shader.GetUniformLocation("VP_imgOffsetScale");
+    locs.edgeDelta        = shader.GetUniformLocation("VP_edgeDelta");
+    locs.edgeLayerDEM     = shader.GetUniformLocation("VP_edgeLayerDEM");
+    locs.edgeOffset       = shader.GetUniformLocation("VP_edgeOffset");
+    locs.f1f2             = shader.GetUniformLocation("VP_f1f2");
+    locs.layerDEM         = shader.GetUniformLocation("VP_layerDEM");
+    locs.layerIMG         = shader.GetUniformLocation("VP_layerIMG");
+    locs.corners          = shader.GetUniformLocation("VP_corners");
+    locs.normals          = shader.GetUniformLocation("VP_normals");
+
+    TileData data{};
+
+    for (auto const& [rdDEM, rdIMG] : mTiles) {
+      GLuint idxCount = calcTileData(rdDEM, rdIMG, matNormal, data);
+      renderTile(data, idxCount, locs);
+    }
   }
 
   if (missingDEM || missingIMG) {
@@ -492,10 +545,80 @@ void TileRenderer::renderTiles(
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void TileRenderer::renderTile(RenderDataDEM* rdDEM, RenderDataImg* rdIMG, UniformLocs const& locs) {
-  VistaGLSLShader& shader   = mProgTerrain->mShader;
-  TileId const&    idDEM    = rdDEM->getTileId();
-  GLuint           idxCount = NumIndices;
+void TileRenderer::renderTile(TileData const& data, GLuint idxCount, UniformLocs const& locs) {
+  VistaGLSLShader& shader = mProgTerrain->mShader;
+
+  // update uniforms
+  shader.SetUniform(locs.demAverageHeight, data.mDemAverageHeight);
+  shader.SetUniform(locs.tileOffsetScale, 3, 1, glm::value_ptr(data.mTileOffsetScale));
+  shader.SetUniform(locs.demOffsetScale, 3, 1, glm::value_ptr(data.mDemOffsetScale));
+  shader.SetUniform(locs.imgOffsetScale, 3, 1, glm::value_ptr(data.mImgOffsetScale));
+  shader.SetUniform(locs.layerIMG, data.mLayerIMG);
+  shader.SetUniform(locs.layerDEM, data.mLayerDEM);
+  shader.SetUniform(locs.edgeDelta, 4, 1, glm::value_ptr(data.mEdgeDelta));
+  shader.SetUniform(locs.edgeLayerDEM, 4, 1, glm::value_ptr(data.mEdgeLayerDEM));
+  shader.SetUniform(locs.edgeOffset, 4, 1, glm::value_ptr(data.mEdgeOffset));
+  shader.SetUniform(locs.f1f2, 2, 1, glm::value_ptr(data.mF1F2));
+
+  glUniform4fv(locs.corners, 4, glm::value_ptr(data.mCorners[0]));
+  glUniform4fv(locs.normals, 4, glm::value_ptr(data.mNormals[0]));
+
+  // draw tile
+  glDrawElements(GL_TRIANGLES, idxCount, GL_UNSIGNED_INT, nullptr);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileRenderer::renderTilesIndirect(glm::dmat4 const& matNormal) {
+  if (mTiles.empty()) {
+    return;
+  }
+
+  mTileData.resize(mTiles.size());
+  mDrawCommands.resize(mTiles.size());
+
+  // Each tile is drawn as a single instance. The base instance selects the tile index from the
+  // instanced attribute, which is then used by the shader to access the tile's parameters.
+  cs::utils::parallelFor(
+      mTiles.size(),
+      [this, &matNormal](std::size_t i) {
+        GLuint idxCount = calcTileData(mTiles[i].first, mTiles[i].second, matNormal, mTileData[i]);
+        mDrawCommands[i] = {idxCount, 1, 0, 0, static_cast<GLuint>(i)};
+      },
+      tileChunkSize);
+
+  reserveTileIndices(mTiles.size());
+
+  if (!mTileBuffer) {
+    mTileBuffer    = std::make_unique<VistaBufferObject>();
+    mCommandBuffer = std::make_unique<VistaBufferObject>();
+  }
+
+  // The buffers are re-specified each time, so that the driver does not have to wait until
+  // previous draw calls which use them have finished.
+  mTileBuffer->Bind(GL_SHADER_STORAGE_BUFFER);
+  mTileBuffer->BufferData(static_cast<GLsizeiptr>(mTileData.size() * sizeof(TileData)),
+      mTileData.data(), GL_STREAM_DRAW);
+  mTileBuffer->Release();
+
+  mCommandBuffer->Bind(GL_DRAW_INDIRECT_BUFFER);
+  mCommandBuffer->BufferData(static_cast<GLsizeiptr>(mDrawCommands.size() * sizeof(DrawCommand)),
+      mDrawCommands.data(), GL_STREAM_DRAW);
+
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, tileBufferBinding, mTileBuffer->GetId());
+  glMultiDrawElementsIndirect(
+      GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(mDrawCommands.size()), 0);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, tileBufferBinding, 0);
+
+  mCommandBuffer->Release();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+GLuint TileRenderer::calcTileData(RenderDataDEM* rdDEM, RenderDataImg* rdIMG,
+    glm::dmat4 const& matNormal, TileData& data) const {
+  TileId const& idDEM    = rdDEM->getTileId();
+  GLuint        idxCount = NumIndices;
 
   std::array<glm::dvec2, 4> cornersLngLat{};
 
@@ -516,50 +639,38 @@ void TileRenderer::renderTile(RenderDataDEM* rdDEM, RenderDataImg* rdIMG, Unifor
   }
 
   auto  baseXY        = HEALPix::getBaseXY(idDEM);
-  auto  tileOS        = glm::ivec3(baseXY.y, baseXY.z, HEALPix::getNSide(idDEM));
-  auto  edgeDelta     = calcEdgeDelta(rdDEM);
-  auto  edgeLayerDEM  = calcEdgeLayerDEM(rdDEM);
-  auto  edgeOffset    = calcEdgeOffset(rdDEM);
-  auto  patchF1F2     = glm::ivec2(HEALPix::getF1(idDEM), HEALPix::getF2(idDEM));
   float averageHeight = rdDEM->getNode()->getTile()->getMinMaxPyramid()->getAverage();
 
-  // update uniforms
-  shader.SetUniform(locs.demAverageHeight, averageHeight);
-  shader.SetUniform(locs.tileOffsetScale, 3, 1, glm::value_ptr(tileOS));
-  shader.SetUniform(locs.demOffsetScale, 3, 1, glm::value_ptr(demOS));
-  shader.SetUniform(locs.imgOffsetScale, 3, 1, glm::value_ptr(imgOS));
-  shader.SetUniform(locs.layerIMG, rdIMG ? rdIMG->getTexLayer() : 0);
-  shader.SetUniform(locs.layerDEM, rdDEM->getTexLayer());
-  shader.SetUniform(locs.edgeDelta, 4, 1, glm::value_ptr(edgeDelta));
-  shader.SetUniform(locs.edgeLayerDEM, 4, 1, glm::value_ptr(edgeLayerDEM));
-  shader.SetUniform(locs.edgeOffset, 4, 1, glm::value_ptr(edgeOffset));
-  shader.SetUniform(locs.f1f2, 2, 1, glm::value_ptr(patchF1F2));
+  data.mTileOffsetScale  = glm::ivec4(baseXY.y, baseXY.z, HEALPix::getNSide(idDEM), 0);
+  data.mDemOffsetScale   = glm::ivec4(demOS, 0);
+  data.mImgOffsetScale   = glm::ivec4(imgOS, 0);
+  data.mEdgeDelta        = calcEdgeDelta(rdDEM);
+  data.mEdgeLayerDEM     = calcEdgeLayerDEM(rdDEM);
+  data.mEdgeOffset       = calcEdgeOffset(rdDEM);
+  data.mF1F2             = glm::ivec2(HEALPix::getF1(idDEM), HEALPix::getF2(idDEM));
+  data.mLayerDEM         = rdDEM->getTexLayer();
+  data.mLayerIMG         = rdIMG ? rdIMG->getTexLayer() : 0;
+  data.mDemAverageHeight = averageHeight;
 
   // order of components: N, W, S, E
-  std::array<glm::dvec3, 4> corners{};
-  std::array<glm::dvec3, 4> normals{};
-  std::array<glm::fvec3, 4> cornersViewSpace{};
-  std::array<glm::fvec3, 4> normalsViewSpace{};
-
-  glm::dmat4 matNormal = glm::transpose(glm::inverse(mMatVM));
-
   for (int i(0); i < 4; ++i) {
-    corners.at(i) = cs::utils::convert::toCartesian(cornersLngLat.at(i), mParams->mEquatorialRadius,
-        mParams->mPolarRadius, averageHeight * static_cast<float>(mParams->mHeightScale));
-    cornersViewSpace.at(i) = glm::fvec3(mMatVM * glm::dvec4(corners.at(i), 1.0));
+    glm::dvec3 corner = cs::utils::convert::toCartesian(cornersLngLat.at(i),
+        mParams->mEquatorialRadius, mParams->mPolarRadius,
+        averageHeight * static_cast<float>(mParams->mHeightScale));
+    data.mCorners.at(i) = glm::vec4(mMatVM * glm::dvec4(corner, 1.0));
 
-    normals.at(i) = cs::utils::convert::lngLatToNormal(
+    glm::dvec3 normal = cs::utils::convert::lngLatToNormal(
         cornersLngLat.at(i), mParams->mEquatorialRadius, mParams->mPolarRadius);
-    normalsViewSpace.at(i) = glm::fvec3(matNormal * glm::dvec4(normals.at(i), 0.0));
+    data.mNormals.at(i) = glm::vec4(matNormal * glm::dvec4(normal, 0.0));
   }
 
-  glUniform3fv(glGetUniformLocation(shader.GetProgram(), "VP_corners"), 9,
-      glm::value_ptr(cornersViewSpace[0]));
-  glUniform3fv(glGetUniformLocation(shader.GetProgram(), "VP_normals"), 4,
-      glm::value_ptr(normalsViewSpace[0]));
+  return idxCount;
+}
 
-  // draw tile
-  glDrawElements(GL_TRIANGLES, idxCount, GL_UNSIGNED_INT, nullptr);
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TileRenderer::useMultiDrawIndirect() const {
+  return mEnableMultiDrawIndirect && isMultiDrawIndirectSupported();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -660,8 +771,13 @@ void TileRenderer::init() const {
       mIboTerrain = makeIBOTerrain();
     }
 
+    if (!mVboTileIndices && isMultiDrawIndirectSupported()) {
+      mVboTileIndices = std::make_unique<VistaBufferObject>();
+      reserveTileIndices(minTileIndexCount);
+    }
+
     if (!mVaoTerrain) {
-      mVaoTerrain = makeVAOTerrain(mVboTerrain.get(), mIboTerrain.get());
+      mVaoTerrain = makeVAOTerrain(mVboTerrain.get(), mIboTerrain.get(), mVboTileIndices.get());
     }
   }
 
@@ -736,13 +852,23 @@ std::unique_ptr<VistaBufferObject> TileRenderer::makeIBOTerrain() {
   return result;
 }
 
-// Sets up the VertexArrayObject for rendering a Tile
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Sets up the VertexArrayObject for rendering a Tile. The tile indices are optional, they are only
+// required for multi-draw indirect rendering.
 std::unique_ptr<VistaVertexArrayObject> TileRenderer::makeVAOTerrain(
-    VistaBufferObject* vbo, VistaBufferObject* ibo) {
+    VistaBufferObject* vbo, VistaBufferObject* ibo, VistaBufferObject* tileIndices) {
   auto result = std::make_unique<VistaVertexArrayObject>();
   result->Bind();
   result->EnableAttributeArray(0);
   result->SpecifyAttributeArrayInteger(0, 2, GL_UNSIGNED_SHORT, 0, 0, vbo);
+
+  if (tileIndices) {
+    result->EnableAttributeArray(tileIndexAttribute);
+    result->SpecifyAttributeArrayInteger(tileIndexAttribute, 1, GL_INT, 0, 0, tileIndices);
+    glVertexAttribDivisor(tileIndexAttribute, 1);
+  }
+
   result->SpecifyIndexBufferObject(ibo, GL_UNSIGNED_INT);
   result->Release();
 
@@ -751,6 +877,25 @@ std::unique_ptr<VistaVertexArrayObject> TileRenderer::makeVAOTerrain(
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void TileRenderer::reserveTileIndices(std::size_t count) {
+  if (count <= mTileIndexCount) {
+    return;
+  }
+
+  // The buffer object stays the same, so the VertexArrayObject does not need to be updated.
+  mTileIndexCount = std::max(count, 2 * mTileIndexCount);
+
+  std::vector<GLint> indices(mTileIndexCount);
+  std::iota(indices.begin(), indices.end(), 0);
+
+  mVboTileIndices->BindAsVertexDataBuffer();
+  mVboTileIndices->BufferData(
+      static_cast<GLsizeiptr>(indices.size() * sizeof(GLint)), indices.data(), GL_STATIC_DRAW);
+  mVboTileIndices->Release();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 std::unique_ptr<VistaBufferObject> TileRenderer::makeVBOBounds() {
   auto             result = std::make_unique<VistaBufferObject>();
   GLsizeiptr const size   = 8 * sizeof(GLubyte);
@@ -945,4 +1090,16 @@ bool TileRenderer::getFaceCulling() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void TileRenderer::setMultiDrawIndirect(bool enable) {
+  mEnableMultiDrawIndirect = enable;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TileRenderer::getMultiDrawIndirect() const {
+  return mEnableMultiDrawIndirect;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 } // namespace csp::lodbodies
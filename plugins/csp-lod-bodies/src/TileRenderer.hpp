@@ -13,7 +13,10 @@
 #include <VistaOGLExt/VistaBufferObject.h>
 #include <VistaOGLExt/VistaGLSLShader.h>
 #include <VistaOGLExt/VistaVertexArrayObject.h>
+#include <array>
 #include <boost/noncopyable.hpp>
+#include <memory>
+#include <utility>
 #include <vector>
 
 namespace cs::graphics {
@@ -59,6 +62,10 @@ class TileRenderer : private boost::noncopyable {
   /// | uniform | sampler2DArray | VP_TexIMG            |             |
   /// | in      | ivec2          | vtxPosition          |             |
   /// @endcode
+  ///
+  /// If multi-draw indirect rendering is used, the shader is compiled with VP_MULTI_DRAW defined.
+  /// Its vertex shader then has to call VP_forwardTileIndex() so that the fragment shader can access
+  /// the parameters of the current tile.
   void setTerrainShader(TerrainShader* shader);
 
   /// Returns the currently set shader for rendering terrain tiles.
@@ -88,6 +95,14 @@ class TileRenderer : private boost::noncopyable {
   void setFaceCulling(bool enable);
   bool getFaceCulling() const;
 
+  /// If enabled, the parameters of all tiles are computed in parallel and written to a shader
+  /// storage buffer. All tiles are then drawn with a single glMultiDrawElementsIndirect. Else, the
+  /// parameters are uploaded as uniforms and each tile is drawn separately. The latter is always
+  /// used if OpenGL 4.3 is not available or if vertex shaders cannot access shader storage buffers.
+  /// This is enabled by default.
+  void setMultiDrawIndirect(bool enable);
+  bool getMultiDrawIndirect() const;
+
  private:
   struct UniformLocs {
     GLint demAverageHeight;
@@ -100,14 +115,56 @@ class TileRenderer : private boost::noncopyable {
     GLint f1f2;
     GLint layerDEM;
     GLint layerIMG;
+    GLint corners;
+    GLint normals;
+  };
+
+  /// The parameters of a single tile. For multi-draw indirect rendering, these are stored in a
+  /// shader storage buffer, so the layout has to match VP_TileData (std430) in
+  /// VistaPlanetTerrainShaderUniforms.glsl. The corners and normals are given in view space in the
+  /// order N, W, S, E.
+  struct TileData {
+    std::array<glm::vec4, 4> mCorners;
+    std::array<glm::vec4, 4> mNormals;
+    glm::ivec4               mTileOffsetScale;
+    glm::ivec4               mDemOffsetScale;
+    glm::ivec4               mImgOffsetScale;
+    glm::ivec4               mEdgeDelta;
+    glm::ivec4               mEdgeLayerDEM;
+    glm::ivec4               mEdgeOffset;
+    glm::ivec2               mF1F2;
+    GLint                    mLayerDEM;
+    GLint                    mLayerIMG;
+    float                    mDemAverageHeight;
+    std::array<float, 3>     mPadding;
+  };
+
+  static_assert(sizeof(TileData) == 256, "TileData does not match the std430 layout.");
+
+  /// The layout of the commands in a GL_DRAW_INDIRECT_BUFFER.
+  struct DrawCommand {
+    GLuint mCount;
+    GLuint mInstanceCount;
+    GLuint mFirstIndex;
+    GLint  mBaseVertex;
+    GLuint mBaseInstance;
   };
 
   void preRenderTiles(cs::graphics::ShadowMap* shadowMap);
   void renderTiles(
       std::vector<RenderData*> const& renderDEM, std::vector<RenderData*> const& renderIMG);
-  void renderTile(RenderDataDEM* rdDEM, RenderDataImg* rdIMG, UniformLocs const& locs);
+  void renderTile(TileData const& data, GLuint idxCount, UniformLocs const& locs);
+  void renderTilesIndirect(glm::dmat4 const& matNormal);
   void postRenderTiles(cs::graphics::ShadowMap* shadowMap);
 
+  /// Computes the parameters of the given tile and returns the number of indices to draw. This is
+  /// called concurrently for multi-draw indirect rendering.
+  GLuint calcTileData(RenderDataDEM* rdDEM, RenderDataImg* rdIMG, glm::dmat4 const& matNormal,
+      TileData& data) const;
+
+  /// Returns true if multi-draw indirect rendering is enabled and supported.
+  bool useMultiDrawIndirect() const;
+
   void preRenderBounds();
   void renderBounds(std::vector<RenderData*> const& reqDEM, std::vector<RenderData*> const& reqIMG);
   static void postRenderBounds();
@@ -116,7 +173,11 @@ class TileRenderer : private boost::noncopyable {
   static std::unique_ptr<VistaBufferObject>      makeVBOTerrain();
   static std::unique_ptr<VistaBufferObject>      makeIBOTerrain();
   static std::unique_ptr<VistaVertexArrayObject> makeVAOTerrain(
-      VistaBufferObject* vbo, VistaBufferObject* ibo);
+      VistaBufferObject* vbo, VistaBufferObject* ibo, VistaBufferObject* tileIndices);
+
+  /// Makes sure that the buffer with the tile indices of the instanced attribute used for
+  /// multi-draw indirect rendering contains at least count entries.
+  static void reserveTileIndices(std::size_t count);
 
   static std::unique_ptr<VistaBufferObject>      makeVBOBounds();
   static std::unique_ptr<VistaBufferObject>      makeIBOBounds();
@@ -134,8 +195,17 @@ class TileRenderer : private boost::noncopyable {
   static std::unique_ptr<VistaBufferObject>      mVboTerrain;
   static std::unique_ptr<VistaBufferObject>      mIboTerrain;
   static std::unique_ptr<VistaVertexArrayObject> mVaoTerrain;
+  static std::unique_ptr<VistaBufferObject>      mVboTileIndices;
+  static std::size_t                             mTileIndexCount;
   TerrainShader*                                 mProgTerrain;
 
+  // Per-frame data of the tiles which are drawn. The vectors are kept to avoid reallocations.
+  std::vector<std::pair<RenderDataDEM*, RenderDataImg*>> mTiles;
+  std::vector<TileData>                                  mTileData;
+  std::vector<DrawCommand>                               mDrawCommands;
+  std::unique_ptr<VistaBufferObject>                     mTileBuffer;
+  std::unique_ptr<VistaBufferObject>                     mCommandBuffer;
+
   static std::unique_ptr<VistaBufferObject>      mVboBounds;
   static std::unique_ptr<VistaBufferObject>      mIboBounds;
   static std::unique_ptr<VistaVertexArrayObject> mVaoBounds;
@@ -146,6 +216,7 @@ class TileRenderer : private boost::noncopyable {
   bool mEnableDrawBounds;
   bool mEnableWireframe;
   bool mEnableFaceCulling;
+  bool mEnableMultiDrawIndirect;
 };
 
 } // namespace csp::lodbodies
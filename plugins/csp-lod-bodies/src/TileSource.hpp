@@ -10,9 +10,14 @@
 #include "TileDataType.hpp"
 #include "TileId.hpp"
 
+#include "../../../src/cs-utils/ThreadPool.hpp"
+
+#include <memory>
+
 namespace csp::lodbodies {
 
 class TileNode;
+class MinMaxPyramidArena;
 
 /// Base class/interface for sources of tile data. Defines interfaces for synchronous (blocking) and
 /// asynchronous (non-blocking) loading of tiles, optionally allocating objects as needed or reusing
@@ -54,8 +59,15 @@ class TileSource {
   /// Loads a node with given level and patchIdx asynchronously (i.e. the call returns immediately).
   /// Optionally the node to store data in is passed as node - it must own a Tile of correct type or
   /// not own a tile at all (in which case a new one is allocated). If node is a nullptr a new node
-  /// is allocated. Once the node is loaded the given OnLoadCallack is invoked.
-  virtual void loadTileAsync(int level, glm::int64 patchIdx, OnLoadCallback cb) = 0;
+  /// is allocated. Once the node is loaded the given OnLoadCallack is invoked. The given TaskHandle
+  /// can be used to change the priority of the request or to cancel it while it is still pending.
+  /// The callback is not invoked for cancelled requests.
+  virtual void loadTileAsync(int level, glm::int64 patchIdx, OnLoadCallback cb,
+      cs::utils::TaskHandle const& handle) = 0;
+
+  /// Applies priority changes made to the TaskHandles of pending requests and drops cancelled
+  /// requests. This should be called once each frame after the handles have been modified.
+  virtual void reprioritizeRequests() = 0;
 
   /// Returns the number of currently active async requests.
   virtual int getPendingRequests() = 0;
@@ -63,6 +75,19 @@ class TileSource {
   /// Derived classes should check whether the given TileSource has the same type and members. This
   /// is used to prevent redundant tile source reloading.
   virtual bool isSame(TileSource const* other) const = 0;
+
+  /// The MinMaxPyramids of loaded elevation tiles should take their memory from this arena. It is
+  /// set by the TreeManagerBase which uses this source and may be nullptr.
+  void setMinMaxPyramidArena(std::shared_ptr<MinMaxPyramidArena> arena) {
+    mMinMaxPyramidArena = std::move(arena);
+  }
+
+  std::shared_ptr<MinMaxPyramidArena> const& getMinMaxPyramidArena() const {
+    return mMinMaxPyramidArena;
+  }
+
+ private:
+  std::shared_ptr<MinMaxPyramidArena> mMinMaxPyramidArena;
 };
 
 } // namespace csp::lodbodies
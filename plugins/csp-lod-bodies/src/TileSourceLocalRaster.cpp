@@ -0,0 +1,648 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "TileSourceLocalRaster.hpp"
+
+#include "HEALPix.hpp"
+#include "MinMaxPyramid.hpp"
+#include "TileNode.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <glm/gtc/constants.hpp>
+#include <limits>
+#include <mutex>
+#include <type_traits>
+
+#include <tiffio.h>
+
+namespace csp::lodbodies {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// These GeoTIFF tags are not known to libtiff, so they have to be registered before a file is
+// opened. Only the first two are read, the others are registered so that libtiff does not warn
+// about unknown tags when opening typical GeoTIFF files.
+uint32_t const tagModelPixelScale = 33550;
+uint32_t const tagModelTiepoint   = 33922;
+uint32_t const tagModelTransform  = 34264;
+uint32_t const tagGeoKeyDirectory = 34735;
+uint32_t const tagGeoDoubleParams = 34736;
+uint32_t const tagGeoAsciiParams  = 34737;
+uint32_t const tagGdalMetadata    = 42112;
+uint32_t const tagGdalNoData      = 42113;
+
+TIFFExtendProc gParentTagExtender = nullptr;
+
+void extendTags(TIFF* tiff) {
+  auto field = [](uint32_t tag, TIFFDataType type, bool passCount, char const* name) {
+    return TIFFFieldInfo{tag, TIFF_VARIABLE, TIFF_VARIABLE, type, FIELD_CUSTOM, 1, passCount,
+        const_cast<char*>(name)}; // NOLINT(cppcoreguidelines-pro-type-const-cast)
+  };
+
+  static std::array<TIFFFieldInfo, 8> fields = {{
+      field(tagModelPixelScale, TIFF_DOUBLE, true, "ModelPixelScaleTag"),
+      field(tagModelTiepoint, TIFF_DOUBLE, true, "ModelTiepointTag"),
+      field(tagModelTransform, TIFF_DOUBLE, true, "ModelTransformationTag"),
+      field(tagGeoKeyDirectory, TIFF_SHORT, true, "GeoKeyDirectoryTag"),
+      field(tagGeoDoubleParams, TIFF_DOUBLE, true, "GeoDoubleParamsTag"),
+      field(tagGeoAsciiParams, TIFF_ASCII, false, "GeoAsciiParamsTag"),
+      field(tagGdalMetadata, TIFF_ASCII, false, "GDALMetadata"),
+      field(tagGdalNoData, TIFF_ASCII, false, "GDALNoData"),
+  }};
+
+  TIFFMergeFieldInfo(tiff, fields.data(), static_cast<uint32_t>(fields.size()));
+
+  if (gParentTagExtender) {
+    gParentTagExtender(tiff);
+  }
+}
+
+void registerGeoTiffTags() {
+  static std::once_flag flag;
+  std::call_once(flag, [] { gParentTagExtender = TIFFSetTagExtender(&extendTags); });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The approximate edge length of a base patch in degrees. Each base patch covers a twelfth of the
+// sphere.
+double const baseEdgeLength = glm::degrees(std::sqrt(4.0 * glm::pi<double>() / 12.0));
+
+// The number of decoded blocks (strips or tiles of the TIFF file) kept by each Raster.
+size_t const blockCacheSize = 16;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+T convert(glm::vec3 const& value);
+
+template <>
+float convert(glm::vec3 const& value) {
+  return value.x;
+}
+
+template <>
+glm::uint8 convert(glm::vec3 const& value) {
+  return static_cast<glm::uint8>(std::clamp(std::round(value.x), 0.F, 255.F));
+}
+
+template <>
+glm::u8vec3 convert(glm::vec3 const& value) {
+  return glm::u8vec3(glm::clamp(glm::round(value), glm::vec3(0.F), glm::vec3(255.F)));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// A handle to an opened raster file. It caches some decoded blocks of the currently selected
+/// overview. This is not thread-safe, each thread has to use its own instance.
+class TileSourceLocalRaster::Raster {
+ public:
+  explicit Raster(std::string file);
+
+  Raster(Raster const& other) = delete;
+  Raster(Raster&& other)      = delete;
+
+  Raster& operator=(Raster const& other) = delete;
+  Raster& operator=(Raster&& other) = delete;
+
+  ~Raster();
+
+  std::string const& getFile() const {
+    return mFile;
+  }
+
+  /// Selects the coarsest overview whose pixels are at most as large as the given size in degrees.
+  /// If there is none, the full-resolution image is selected.
+  void selectOverview(double pixelSize);
+
+  /// Bilinearly interpolates the raster at the given position in degrees. Images with less than
+  /// three channels return the value of the first channel in all components. Returns false if the
+  /// position is outside of the raster or if the data cannot be read.
+  bool sample(double lng, double lat, glm::vec3& value);
+
+ private:
+  struct Overview {
+    tdir_t   mDirectory;
+    uint32_t mWidth;
+    uint32_t mHeight;
+  };
+
+  struct Block {
+    uint32_t             mIndex   = std::numeric_limits<uint32_t>::max();
+    uint64_t             mLastUse = 0;
+    std::vector<uint8_t> mData;
+  };
+
+  /// Returns the decoded block with the given index in the current overview or nullptr if it
+  /// cannot be read.
+  uint8_t const* getBlock(uint32_t index);
+
+  /// Reads the given pixel of the current overview. x and y must be inside of the overview.
+  bool getPixel(uint32_t x, uint32_t y, glm::vec3& value);
+
+  float getSample(uint8_t const* data, size_t index) const;
+
+  std::string mFile;
+  TIFF*       mTiff = nullptr;
+
+  // Properties shared by all overviews.
+  uint16_t mChannels{};
+  uint16_t mBitsPerSample{};
+  uint16_t mSampleFormat{};
+
+  // The covered area in degrees. If the raster covers all longitudes, the samples wrap around.
+  double mMinLng  = -180.0;
+  double mMaxLat  = 90.0;
+  double mSizeLng = 360.0;
+  double mSizeLat = 180.0;
+  bool   mWrapLng = true;
+
+  // Properties of the current overview.
+  std::vector<Overview> mOverviews;
+  size_t                mOverview = 0;
+  bool                  mTiled{};
+  uint32_t              mBlockWidth{};
+  uint32_t              mBlockHeight{};
+  uint32_t              mBlocksPerRow{};
+
+  std::array<Block, blockCacheSize> mBlocks;
+  uint64_t                          mAccessCounter = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileSourceLocalRaster::Raster::Raster(std::string file)
+    : mFile(std::move(file)) {
+
+  registerGeoTiffTags();
+
+  mTiff = TIFFOpen(mFile.c_str(), "r");
+  if (!mTiff) {
+    throw std::runtime_error("Cannot open '" + mFile + "' with libtiff");
+  }
+
+  uint16_t planarConfig{};
+  TIFFGetFieldDefaulted(mTiff, TIFFTAG_SAMPLESPERPIXEL, &mChannels);
+  TIFFGetFieldDefaulted(mTiff, TIFFTAG_BITSPERSAMPLE, &mBitsPerSample);
+  TIFFGetFieldDefaulted(mTiff, TIFFTAG_SAMPLEFORMAT, &mSampleFormat);
+  TIFFGetFieldDefaulted(mTiff, TIFFTAG_PLANARCONFIG, &planarConfig);
+
+  bool isInt     = mSampleFormat == SAMPLEFORMAT_UINT || mSampleFormat == SAMPLEFORMAT_INT;
+  bool isFloat   = mSampleFormat == SAMPLEFORMAT_IEEEFP;
+  bool supported = (isInt && (mBitsPerSample == 8 || mBitsPerSample == 16)) ||
+                   ((isInt || isFloat) && mBitsPerSample == 32) ||
+                   (isFloat && mBitsPerSample == 64);
+
+  if (!supported || (mChannels > 1 && planarConfig != PLANARCONFIG_CONTIG)) {
+    TIFFClose(mTiff);
+    throw std::runtime_error("The sample format of '" + mFile + "' is not supported");
+  }
+
+  // Read the georeferencing. Only the first tie point is considered.
+  uint16_t count{};
+  double*  scale{};
+  double*  tiepoint{};
+
+  if (TIFFGetField(mTiff, tagModelPixelScale, &count, &scale) && count >= 2 &&
+      TIFFGetField(mTiff, tagModelTiepoint, &count, &tiepoint) && count >= 6) {
+    uint32_t width{};
+    uint32_t height{};
+    TIFFGetField(mTiff, TIFFTAG_IMAGEWIDTH, &width);
+    TIFFGetField(mTiff, TIFFTAG_IMAGELENGTH, &height);
+
+    // The tie point maps the raster position (i, j, k) to the model position (x, y, z).
+    std::array<double, 2> pixelSize{};
+    std::array<double, 6> point{};
+    std::memcpy(pixelSize.data(), scale, sizeof(pixelSize));
+    std::memcpy(point.data(), tiepoint, sizeof(point));
+
+    mMinLng  = point[3] - point[0] * pixelSize[0];
+    mMaxLat  = point[4] + point[1] * pixelSize[1];
+    mSizeLng = width * pixelSize[0];
+    mSizeLat = height * pixelSize[1];
+    mWrapLng = mSizeLng >= 360.0 - 0.5 * pixelSize[0];
+  }
+
+  // Collect the full-resolution image and all overviews with the same layout. Masks and other
+  // sub-images are ignored.
+  do {
+    uint32_t subfileType{};
+    uint16_t channels{};
+    uint16_t bitsPerSample{};
+    TIFFGetFieldDefaulted(mTiff, TIFFTAG_SUBFILETYPE, &subfileType);
+    TIFFGetFieldDefaulted(mTiff, TIFFTAG_SAMPLESPERPIXEL, &channels);
+    TIFFGetFieldDefaulted(mTiff, TIFFTAG_BITSPERSAMPLE, &bitsPerSample);
+
+    bool isOverview = mOverviews.empty() || subfileType == FILETYPE_REDUCEDIMAGE;
+
+    if (isOverview && channels == mChannels && bitsPerSample == mBitsPerSample) {
+      Overview overview{TIFFCurrentDirectory(mTiff), 0, 0};
+      TIFFGetField(mTiff, TIFFTAG_IMAGEWIDTH, &overview.mWidth);
+      TIFFGetField(mTiff, TIFFTAG_IMAGELENGTH, &overview.mHeight);
+      mOverviews.push_back(overview);
+    }
+  } while (TIFFReadDirectory(mTiff));
+
+  std::sort(mOverviews.begin(), mOverviews.end(),
+      [](Overview const& a, Overview const& b) { return a.mWidth > b.mWidth; });
+
+  // This makes sure that the first overview is actually selected.
+  mOverview = mOverviews.size();
+  selectOverview(0.0);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileSourceLocalRaster::Raster::~Raster() {
+  TIFFClose(mTiff);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileSourceLocalRaster::Raster::selectOverview(double pixelSize) {
+  size_t overview = 0;
+
+  for (size_t i = mOverviews.size() - 1; i > 0; --i) {
+    if (mSizeLng / mOverviews[i].mWidth <= pixelSize) {
+      overview = i;
+      break;
+    }
+  }
+
+  if (overview == mOverview) {
+    return;
+  }
+
+  mOverview = overview;
+  TIFFSetDirectory(mTiff, mOverviews[mOverview].mDirectory);
+
+  mTiled = TIFFIsTiled(mTiff);
+
+  if (mTiled) {
+    TIFFGetField(mTiff, TIFFTAG_TILEWIDTH, &mBlockWidth);
+    TIFFGetField(mTiff, TIFFTAG_TILELENGTH, &mBlockHeight);
+  } else {
+    mBlockWidth = mOverviews[mOverview].mWidth;
+    TIFFGetFieldDefaulted(mTiff, TIFFTAG_ROWSPERSTRIP, &mBlockHeight);
+    mBlockHeight = std::clamp(mBlockHeight, 1U, mOverviews[mOverview].mHeight);
+  }
+
+  mBlocksPerRow = (mOverviews[mOverview].mWidth + mBlockWidth - 1) / mBlockWidth;
+
+  for (auto& block : mBlocks) {
+    block.mIndex = std::numeric_limits<uint32_t>::max();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TileSourceLocalRaster::Raster::sample(double lng, double lat, glm::vec3& value) {
+  auto const& overview = mOverviews[mOverview];
+
+  // Bring the longitude to the range covered by the raster.
+  lng = mMinLng + std::fmod(std::fmod(lng - mMinLng, 360.0) + 360.0, 360.0);
+
+  double x = (lng - mMinLng) / mSizeLng * overview.mWidth - 0.5;
+  double y = (mMaxLat - lat) / mSizeLat * overview.mHeight - 0.5;
+
+  if (y < -0.5 || y > overview.mHeight - 0.5) {
+    return false;
+  }
+
+  if (!mWrapLng && (x < -0.5 || x > overview.mWidth - 0.5)) {
+    return false;
+  }
+
+  auto   width  = static_cast<int64_t>(overview.mWidth);
+  auto   height = static_cast<int64_t>(overview.mHeight);
+  double x0     = std::floor(x);
+  double y0     = std::floor(y);
+  auto   fx     = static_cast<float>(x - x0);
+  auto   fy     = static_cast<float>(y - y0);
+
+  // Pixels outside of the raster are either wrapped around or clamped to the edge.
+  auto getX = [this, width](int64_t x) {
+    return static_cast<uint32_t>(
+        mWrapLng ? (x % width + width) % width : std::clamp<int64_t>(x, 0, width - 1));
+  };
+
+  auto getY = [height](int64_t y) {
+    return static_cast<uint32_t>(std::clamp<int64_t>(y, 0, height - 1));
+  };
+
+  std::array<glm::vec3, 4> values{};
+  auto                     ix = static_cast<int64_t>(x0);
+  auto                     iy = static_cast<int64_t>(y0);
+
+  if (!getPixel(getX(ix), getY(iy), values[0]) || !getPixel(getX(ix + 1), getY(iy), values[1]) ||
+      !getPixel(getX(ix), getY(iy + 1), values[2]) ||
+      !getPixel(getX(ix + 1), getY(iy + 1), values[3])) {
+    return false;
+  }
+
+  value = glm::mix(glm::mix(values[0], values[1], fx), glm::mix(values[2], values[3], fx), fy);
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint8_t const* TileSourceLocalRaster::Raster::getBlock(uint32_t index) {
+  ++mAccessCounter;
+
+  auto* oldest = &mBlocks[0];
+
+  for (auto& block : mBlocks) {
+    if (block.mIndex == index) {
+      block.mLastUse = mAccessCounter;
+      return block.mData.data();
+    }
+
+    if (block.mLastUse < oldest->mLastUse) {
+      oldest = &block;
+    }
+  }
+
+  // The block is not cached, replace the least recently used one.
+  oldest->mIndex   = std::numeric_limits<uint32_t>::max();
+  oldest->mLastUse = mAccessCounter;
+
+  tmsize_t size = mTiled ? TIFFTileSize(mTiff) : TIFFStripSize(mTiff);
+  oldest->mData.resize(static_cast<size_t>(size));
+
+  tmsize_t read = mTiled ? TIFFReadEncodedTile(mTiff, index, oldest->mData.data(), size)
+                         : TIFFReadEncodedStrip(mTiff, index, oldest->mData.data(), size);
+
+  if (read < 0) {
+    logger().warn("Failed to read block {} of '{}'!", index, mFile);
+    return nullptr;
+  }
+
+  oldest->mIndex = index;
+
+  return oldest->mData.data();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TileSourceLocalRaster::Raster::getPixel(uint32_t x, uint32_t y, glm::vec3& value) {
+  uint32_t    index = (y / mBlockHeight) * mBlocksPerRow + x / mBlockWidth;
+  auto const* block = getBlock(index);
+
+  if (!block) {
+    return false;
+  }
+
+  size_t pixel = static_cast<size_t>(y % mBlockHeight) * mBlockWidth + x % mBlockWidth;
+  pixel *= mChannels;
+
+  if (mChannels >= 3) {
+    value = glm::vec3(
+        getSample(block, pixel), getSample(block, pixel + 1), getSample(block, pixel + 2));
+  } else {
+    value = glm::vec3(getSample(block, pixel));
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+float TileSourceLocalRaster::Raster::getSample(uint8_t const* data, size_t index) const {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  auto const* sample = data + index * (mBitsPerSample / 8);
+
+  auto read = [sample](auto value) {
+    std::memcpy(&value, sample, sizeof(value));
+    return static_cast<float>(value);
+  };
+
+  bool isSigned = mSampleFormat == SAMPLEFORMAT_INT;
+  bool isFloat  = mSampleFormat == SAMPLEFORMAT_IEEEFP;
+
+  switch (mBitsPerSample) {
+  case 8:
+    return isSigned ? read(int8_t{}) : read(uint8_t{});
+  case 16:
+    return isSigned ? read(int16_t{}) : read(uint16_t{});
+  case 32:
+    return isFloat ? read(float{}) : isSigned ? read(int32_t{}) : read(uint32_t{});
+  default:
+    return read(double{});
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileSourceLocalRaster::TileSourceLocalRaster() = default;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileSourceLocalRaster::~TileSourceLocalRaster() {
+  // The pending requests access the members, so they have to be finished first.
+  std::unique_lock<std::mutex> lock(mRequestsMutex);
+  mRequestsDone.wait(lock, [this]() { return mRequestCount == 0; });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/* virtual */ TileNode* TileSourceLocalRaster::loadTile(int level, glm::int64 patchIdx) {
+  if (mFormat != TileDataType::eFloat32 && mFormat != TileDataType::eUInt8 &&
+      mFormat != TileDataType::eU8Vec3) {
+    throw std::domain_error(fmt::format("Unsupported format: {}!", mFormat));
+  }
+
+  std::unique_ptr<Raster> raster;
+
+  try {
+    raster = acquireRaster();
+  } catch (std::exception const& e) {
+    logger().error("Tile loading failed: {}", e.what());
+    return nullptr;
+  }
+
+  TileNode* node = nullptr;
+
+  if (mFormat == TileDataType::eFloat32) {
+    node = loadImpl<float>(*raster, level, patchIdx);
+  } else if (mFormat == TileDataType::eUInt8) {
+    node = loadImpl<glm::uint8>(*raster, level, patchIdx);
+  } else {
+    node = loadImpl<glm::u8vec3>(*raster, level, patchIdx);
+  }
+
+  releaseRaster(std::move(raster));
+
+  return node;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/* virtual */ void TileSourceLocalRaster::loadTileAsync(
+    int level, glm::int64 patchIdx, OnLoadCallback cb, cs::utils::TaskHandle const& handle) {
+  {
+    std::unique_lock<std::mutex> lock(mRequestsMutex);
+    ++mRequestCount;
+  }
+
+  // The guard is destroyed together with the request, no matter whether it has been executed or
+  // dropped by the thread pool.
+  std::shared_ptr<void> guard(nullptr, [this](void* /*unused*/) {
+    std::unique_lock<std::mutex> lock(mRequestsMutex);
+    --mRequestCount;
+    mRequestsDone.notify_all();
+  });
+
+  cs::utils::getSharedThreadPool().enqueue(
+      [this, level, patchIdx, cb = std::move(cb), guard = std::move(guard)]() {
+        auto* n = loadTile(level, patchIdx);
+        cb(this, level, patchIdx, n);
+      },
+      handle);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/* virtual */ void TileSourceLocalRaster::reprioritizeRequests() {
+  cs::utils::getSharedThreadPool().reprioritize();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int TileSourceLocalRaster::getPendingRequests() {
+  std::unique_lock<std::mutex> lock(mRequestsMutex);
+  return mRequestCount;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileSourceLocalRaster::setMaxLevel(uint32_t maxLevel) {
+  mMaxLevel = maxLevel;
+}
+
+uint32_t TileSourceLocalRaster::getMaxLevel() const {
+  return mMaxLevel;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileSourceLocalRaster::setFile(std::string const& file) {
+  std::unique_lock<std::mutex> lock(mRastersMutex);
+  mFile = file;
+  mRasters.clear();
+}
+
+std::string const& TileSourceLocalRaster::getFile() const {
+  return mFile;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileSourceLocalRaster::setDataType(TileDataType type) {
+  mFormat = type;
+}
+
+TileDataType TileSourceLocalRaster::getDataType() const {
+  return mFormat;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TileSourceLocalRaster::isSame(TileSource const* other) const {
+  auto const* casted = dynamic_cast<TileSourceLocalRaster const*>(other);
+
+  return casted != nullptr && mFile == casted->mFile && mFormat == casted->mFormat &&
+         mMaxLevel == casted->mMaxLevel;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::unique_ptr<TileSourceLocalRaster::Raster> TileSourceLocalRaster::acquireRaster() {
+  std::string file;
+
+  {
+    std::unique_lock<std::mutex> lock(mRastersMutex);
+
+    if (!mRasters.empty()) {
+      auto raster = std::move(mRasters.back());
+      mRasters.pop_back();
+      return raster;
+    }
+
+    file = mFile;
+  }
+
+  // Opening the file is done without holding the lock.
+  return std::make_unique<Raster>(file);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileSourceLocalRaster::releaseRaster(std::unique_ptr<Raster>&& raster) {
+  std::unique_lock<std::mutex> lock(mRastersMutex);
+
+  // The file may have changed in the meantime.
+  if (raster->getFile() == mFile) {
+    mRasters.push_back(std::move(raster));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+TileNode* TileSourceLocalRaster::loadImpl(Raster& raster, int level, glm::int64 patchIdx) const {
+  auto* node = new TileNode(); // NOLINT(cppcoreguidelines-owning-memory): TODO this is bad!
+
+  node->setTile(std::make_unique<Tile<T>>(level, patchIdx));
+  node->setChildMaxLevel(std::min(static_cast<uint32_t>(level) + 1, mMaxLevel));
+
+  auto*        tile   = static_cast<Tile<T>*>(node->getTile());
+  TileId       tileId(level, patchIdx);
+  glm::i64vec3 baseXY = HEALPix::getBaseXY(tileId);
+  auto         nSide  = static_cast<double>(HEALPix::getNSide(tileId));
+  auto         base   = static_cast<int>(baseXY.x);
+
+  // The texels of the tile are placed at the corners of a regular grid in the HEALPix base patch.
+  // Row y and column x of the tile correspond to the relative base patch coordinates (x, y).
+  double const step = 1.0 / (TileBase::SizeX - 1);
+
+  raster.selectOverview(baseEdgeLength * step / nSide);
+
+  for (int y = 0; y < TileBase::SizeY; ++y) {
+    for (int x = 0; x < TileBase::SizeX; ++x) {
+      glm::dvec2 lngLat = HEALPix::convertBaseXY2LngLat(
+          base, (baseXY.y + x * step) / nSide, (baseXY.z + y * step) / nSide);
+
+      glm::vec3 value(0.F);
+      raster.sample(glm::degrees(lngLat.x), glm::degrees(lngLat.y), value);
+
+      tile->data()[y * TileBase::SizeX + x] = convert<T>(value);
+    }
+  }
+
+  if constexpr (std::is_same_v<T, float>) {
+    // The MinMaxPyramid is required to deduce height information for the image tiles.
+    tile->setMinMaxPyramid(std::make_unique<MinMaxPyramid>(tile, getMinMaxPyramidArena()));
+  }
+
+  return node;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::lodbodies
@@ -0,0 +1,101 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_LOD_BODIES_TILESOURCELOCALRASTER_HPP
+#define CSP_LOD_BODIES_TILESOURCELOCALRASTER_HPP
+
+#include "../../../src/cs-utils/ThreadPool.hpp"
+#include "Tile.hpp"
+#include "TileSource.hpp"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace csp::lodbodies {
+
+/// The data of the tiles is read from a local raster file, no map server is required. This can be
+/// a Cloud-Optimized GeoTIFF or any other striped or tiled TIFF file. If the file contains
+/// overviews (reduced-resolution sub-images), they are used for the coarser tiles. The file is
+/// memory-mapped by libtiff.
+///
+/// The raster has to be in geographic coordinates, that is longitude and latitude in degrees (e.g.
+/// EPSG:4326). The covered area is read from the GeoTIFF tags ModelPixelScale and ModelTiepoint; if
+/// these are missing, the raster is assumed to cover the entire globe. Each tile is reprojected
+/// and bilinearly resampled to the HEALPix layout of the tiles. Multiple tiles are loaded in
+/// parallel on the threads of cs::utils::getSharedThreadPool(), each thread uses its own handle to
+/// the file.
+///
+/// Elevation data sets (TileDataType::eFloat32) should have one channel with 8, 16 or 32 bit
+/// integer or 32 bit floating point samples. Image data sets should have one channel
+/// (TileDataType::eUInt8) or three or more channels (TileDataType::eU8Vec3) with 8 bit samples.
+class TileSourceLocalRaster : public TileSource {
+ public:
+  TileSourceLocalRaster();
+
+  TileSourceLocalRaster(TileSourceLocalRaster const& other) = delete;
+  TileSourceLocalRaster(TileSourceLocalRaster&& other)      = delete;
+
+  TileSourceLocalRaster& operator=(TileSourceLocalRaster const& other) = delete;
+  TileSourceLocalRaster& operator=(TileSourceLocalRaster&& other) = delete;
+
+  ~TileSourceLocalRaster() override;
+
+  void init() override {
+  }
+
+  void fini() override {
+  }
+
+  TileNode* loadTile(int level, glm::int64 patchIdx) override;
+
+  void loadTileAsync(int level, glm::int64 patchIdx, OnLoadCallback cb,
+      cs::utils::TaskHandle const& handle) override;
+  void reprioritizeRequests() override;
+  int  getPendingRequests() override;
+
+  void     setMaxLevel(uint32_t maxLevel);
+  uint32_t getMaxLevel() const;
+
+  /// The path to the TIFF file.
+  void               setFile(std::string const& file);
+  std::string const& getFile() const;
+
+  void         setDataType(TileDataType type);
+  TileDataType getDataType() const override;
+
+  bool isSame(TileSource const* other) const override;
+
+ private:
+  class Raster;
+
+  /// Returns a handle to the raster file which is not used by any other thread. If there is none,
+  /// the file is opened again. This throws a std::runtime_error if the file cannot be opened.
+  std::unique_ptr<Raster> acquireRaster();
+  void                    releaseRaster(std::unique_ptr<Raster>&& raster);
+
+  template <typename T>
+  TileNode* loadImpl(Raster& raster, int level, glm::int64 patchIdx) const;
+
+  std::string  mFile;
+  TileDataType mFormat   = TileDataType::eU8Vec3;
+  uint32_t     mMaxLevel = 10;
+
+  std::mutex                           mRastersMutex;
+  std::vector<std::unique_ptr<Raster>> mRasters;
+
+  // The number of requests on the shared thread pool which have neither finished nor been dropped
+  // because their handle was cancelled. The destructor waits until this is zero.
+  std::mutex              mRequestsMutex;
+  std::condition_variable mRequestsDone;
+  int                     mRequestCount = 0;
+};
+
+} // namespace csp::lodbodies
+
+#endif // CSP_LOD_BODIES_TILESOURCELOCALRASTER_HPP
@@ -7,26 +7,20 @@
 #include "TileSourceWebMapService.hpp"
 
 #include "HEALPix.hpp"
+#include "TileDecoder.hpp"
 #include "TileNode.hpp"
 #include "logger.hpp"
 
-#include "../../../src/cs-utils/filesystem.hpp"
+#include "../../../src/cs-utils/TraceRecorder.hpp"
 
-#include <boost/filesystem.hpp>
+#include <algorithm>
 #include <curlpp/Easy.hpp>
 #include <curlpp/Info.hpp>
 #include <curlpp/Infos.hpp>
 #include <curlpp/Options.hpp>
 #include <curlpp/cURLpp.hpp>
-#include <fstream>
 #include <sstream>
 
-#define STB_IMAGE_IMPLEMENTATION
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#include <stb_image.h>
-
-#include <tiffio.h>
-
 namespace csp::lodbodies {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -35,93 +29,21 @@ namespace {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-enum class CopyPixels { eAll, eAboveDiagonal, eBelowDiagonal };
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
 template <typename T>
 bool loadImpl(
     TileSourceWebMapService* source, TileNode* node, int level, int x, int y, CopyPixels which) {
-  auto        tile = static_cast<Tile<T>*>(node->getTile());
-  std::string cacheFile;
+  auto              tile = static_cast<Tile<T>*>(node->getTile());
+  std::vector<char> tileData;
 
   try {
-    cacheFile = source->loadData(level, x, y);
+    tileData = source->loadData(level, x, y);
   } catch (std::exception const& e) {
     logger().error("Tile loading failed: {}", e.what());
     return false;
   }
 
-  if (tile->getDataType() == TileDataType::eFloat32) {
-    TIFFSetWarningHandler(nullptr);
-    auto* data = TIFFOpen(cacheFile.c_str(), "r");
-    if (!data) {
-      logger().error("Tile loading failed: Cannot open '{}' with libtiff!", cacheFile);
-      return false;
-    }
-
-    int imagelength{};
-    TIFFGetField(data, TIFFTAG_IMAGELENGTH, &imagelength);
-    for (int y = 0; y < imagelength; y++) {
-      if (which == CopyPixels::eAll) {
-        TIFFReadScanline(data, &tile->data()[257 * y], y);
-      } else if (which == CopyPixels::eAboveDiagonal) {
-        std::array<float, 257> tmp{};
-        TIFFReadScanline(data, tmp.data(), y);
-        int offset = 257 * y;
-        int count  = 257 - y - 1;
-
-        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-        std::memcpy(tile->data().data() + offset, tmp.data(), count * sizeof(float));
-      } else if (which == CopyPixels::eBelowDiagonal) {
-        std::array<float, 257> tmp{};
-        TIFFReadScanline(data, tmp.data(), y);
-        int offset = 257 * y + (257 - y);
-        int count  = y;
-
-        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-        std::memcpy(tile->data().data() + offset, tmp.data() + 257 - y, count * sizeof(float));
-      }
-    }
-    TIFFClose(data);
-  } else {
-    int width{};
-    int height{};
-    int bpp{};
-    int channels = tile->getDataType() == TileDataType::eU8Vec3 ? 3 : 1;
-
-    auto* data =
-        reinterpret_cast<T*>(stbi_load(cacheFile.c_str(), &width, &height, &bpp, channels));
-
-    if (!data) {
-      logger().error("Tile loading failed: Cannot open '{}' with stbi!", cacheFile);
-      return false;
-    }
-
-    if (which == CopyPixels::eAll) {
-      std::memcpy(tile->data().data(), data, channels * width * height);
-    } else if (which == CopyPixels::eAboveDiagonal) {
-      for (int y = 0; y < height; ++y) {
-        int offset = width * y;
-        int count  = channels * (width - y - 1);
-
-        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-        std::memcpy(tile->data().data() + offset, data + offset, count);
-      }
-    } else if (which == CopyPixels::eBelowDiagonal) {
-      for (int y = 0; y < height; ++y) {
-        int offset = width * y + (width - y);
-        int count  = channels * y;
-
-        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-        std::memcpy(tile->data().data() + offset, data + offset, count);
-      }
-    }
-
-    stbi_image_free(data);
-  }
-
-  return true;
+  CS_TRACE_ZONE("TileSourceWebMapService::decodeTile");
+  return decodeTile(tileData.data(), tileData.size(), *tile, which);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -218,7 +140,8 @@ TileNode* loadImpl(TileSourceWebMapService* source, uint32_t level, glm::int64 p
     // The MinMaxPyramid is later needed to deduce height information from this
     // coarser level DEM tile to deeper level IMG tiles
     auto* demTile = reinterpret_cast<Tile<float>*>(tile);
-    demTile->setMinMaxPyramid(std::make_unique<MinMaxPyramid>(demTile));
+    demTile->setMinMaxPyramid(
+        std::make_unique<MinMaxPyramid>(demTile, source->getMinMaxPyramidArena()));
   }
 
   return node;
@@ -230,10 +153,6 @@ TileNode* loadImpl(TileSourceWebMapService* source, uint32_t level, glm::int64 p
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-std::mutex TileSourceWebMapService::mTileSystemMutex;
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
 TileSourceWebMapService::TileSourceWebMapService()
     : mThreadPool(32) {
 }
@@ -283,27 +202,28 @@ bool TileSourceWebMapService::getXY(int level, glm::int64 patchIdx, int& x, int&
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-std::string TileSourceWebMapService::loadData(int level, int x, int y) {
+std::vector<char> TileSourceWebMapService::loadData(int level, int x, int y) {
+  CS_TRACE_ZONE("TileSourceWebMapService::loadData");
 
   std::string format;
-  std::string type;
 
   if (mFormat == TileDataType::eFloat32) {
     format = "tiffGray";
-    type   = "tiff";
   } else if (mFormat == TileDataType::eU8Vec3) {
     format = "pngRGB";
-    type   = "png";
   } else {
     format = "pngGray";
-    type   = "png";
   }
 
-  std::stringstream cacheDir;
-  cacheDir << mCache << "/" << mLayers << "/" << level << "/" << x;
+  std::vector<char> data;
+  auto              cache = getDiskCache();
+  uint64_t          key   = TileDiskCache::makeKey(level, x, y);
+
+  // the tile is already there, we can return it
+  if (cache && cache->load(key, data)) {
+    return data;
+  }
 
-  std::stringstream cacheFile(cacheDir.str());
-  cacheFile << cacheDir.str() << "/" << y << "." << type;
   std::stringstream url;
 
   double size = 1.0 / (1 << level);
@@ -313,81 +233,78 @@ std::string TileSourceWebMapService::loadData(int level, int x, int y) {
       << "&bbox=" << x * size << "," << y * size << "," << x * size + size << "," << y * size + size
       << "&width=257&height=257&srs=EPSG:900914&format=" << format;
 
-  auto cacheFilePath(boost::filesystem::path(cacheFile.str()));
-
-  // the file is already there, we can return it
-  if (boost::filesystem::exists(cacheFilePath) &&
-      boost::filesystem::file_size(cacheFile.str()) > 0) {
-    return cacheFile.str();
-  }
+  curlpp::Easy request;
+  request.setOpt(curlpp::options::Url(url.str()));
+  request.setOpt(curlpp::options::NoSignal(true));
+  request.setOpt(curlpp::options::WriteFunction([&data](char* ptr, size_t size, size_t nmemb) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    data.insert(data.end(), ptr, ptr + size * nmemb);
+    return size * nmemb;
+  }));
 
-  // the file is corrupt not available
   {
-    std::unique_lock<std::mutex> lock(mTileSystemMutex);
+    CS_TRACE_ZONE("TileSourceWebMapService::download");
+    request.perform();
+  }
 
-    if (boost::filesystem::exists(cacheFilePath) &&
-        boost::filesystem::file_size(cacheFile.str()) == 0) {
-      boost::filesystem::remove(cacheFilePath);
-    }
+  if (curlpp::Info<CURLINFO_CONTENT_TYPE, std::string>::get(request).substr(0, 11) ==
+      "application") {
+    throw std::runtime_error(std::string(data.begin(), data.end()));
+  }
 
-    auto cacheDirPath(boost::filesystem::absolute(boost::filesystem::path(cacheDir.str())));
-    if (!(boost::filesystem::exists(cacheDirPath))) {
-      try {
-        cs::utils::filesystem::createDirectoryRecursively(
-            cacheDirPath, boost::filesystem::perms::all_all);
-      } catch (std::exception& e) {
-        logger().error("Failed to create cache directory: {}", e.what());
-      }
-    }
+  if (cache) {
+    cache->storeAsync(key, data);
   }
 
-  bool fail = false;
-  {
-    std::ofstream out;
-    out.open(cacheFile.str(), std::ofstream::out | std::ofstream::binary);
+  return data;
+}
 
-    if (!out) {
-      logger().error(
-          "Failed to download tile data: Cannot open '{}' for writing!", cacheFile.str());
-    }
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-    curlpp::Easy request;
-    request.setOpt(curlpp::options::Url(url.str()));
-    request.setOpt(curlpp::options::WriteStream(&out));
-    request.setOpt(curlpp::options::NoSignal(true));
+std::shared_ptr<TileDiskCache> TileSourceWebMapService::getDiskCache() {
+  std::unique_lock<std::mutex> lock(mDiskCacheMutex);
 
-    request.perform();
+  if (!mDiskCache && !mDiskCacheFailed) {
+    std::string type = mFormat == TileDataType::eFloat32 ? "tiff" : "png";
 
-    fail = curlpp::Info<CURLINFO_CONTENT_TYPE, std::string>::get(request).substr(0, 11) ==
-           "application";
+    try {
+      mDiskCache = TileDiskCache::get(mCache + "/" + mLayers, type);
+      mDiskCache->setMaxSize(mCacheSize);
+    } catch (std::exception const& e) {
+      logger().warn("Failed to open tile cache '{}/{}': {}. Tiles will not be cached!", mCache,
+          mLayers, e.what());
+      mDiskCacheFailed = true;
+    }
   }
 
-  if (fail) {
-    std::ifstream     in(cacheFile.str());
-    std::stringstream sstr;
-    sstr << in.rdbuf();
-
-    std::remove(cacheFile.str().c_str());
-    throw std::runtime_error(sstr.str());
-  }
+  return mDiskCache;
+}
 
-  boost::filesystem::perms filePerms =
-      boost::filesystem::perms::owner_read | boost::filesystem::perms::owner_write |
-      boost::filesystem::perms::group_read | boost::filesystem::perms::group_write |
-      boost::filesystem::perms::others_read | boost::filesystem::perms::others_write;
-  boost::filesystem::permissions(cacheFilePath, filePerms);
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-  return cacheFile.str();
+void TileSourceWebMapService::resetDiskCache() {
+  std::unique_lock<std::mutex> lock(mDiskCacheMutex);
+  mDiskCache.reset();
+  mDiskCacheFailed = false;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 /* virtual */ void TileSourceWebMapService::loadTileAsync(
-    int level, glm::int64 patchIdx, OnLoadCallback cb) {
-  mThreadPool.enqueue([=]() {
-    auto* n = loadTile(level, patchIdx);
-    cb(this, level, patchIdx, n);
-  });
+    int level, glm::int64 patchIdx, OnLoadCallback cb, cs::utils::TaskHandle const& handle) {
+  mThreadPool.enqueue(
+      [=]() {
+        CS_TRACE_ZONE("TileSourceWebMapService::loadTileAsync");
+        auto* n = loadTile(level, patchIdx);
+        cb(this, level, patchIdx, n);
+      },
+      handle);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/* virtual */ void TileSourceWebMapService::reprioritizeRequests() {
+  mThreadPool.reprioritize();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -409,6 +326,7 @@ uint32_t TileSourceWebMapService::getMaxLevel() const {
 
 void TileSourceWebMapService::setCacheDirectory(std::string const& cacheDirectory) {
   mCache = cacheDirectory;
+  resetDiskCache();
 }
 
 std::string const& TileSourceWebMapService::getCacheDirectory() const {
@@ -417,8 +335,25 @@ std::string const& TileSourceWebMapService::getCacheDirectory() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void TileSourceWebMapService::setCacheSize(uint64_t bytes) {
+  std::unique_lock<std::mutex> lock(mDiskCacheMutex);
+  mCacheSize = bytes;
+
+  if (mDiskCache) {
+    mDiskCache->setMaxSize(mCacheSize);
+  }
+}
+
+uint64_t TileSourceWebMapService::getCacheSize() const {
+  std::unique_lock<std::mutex> lock(mDiskCacheMutex);
+  return mCacheSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void TileSourceWebMapService::setLayers(std::string const& layers) {
   mLayers = layers;
+  resetDiskCache();
 }
 
 std::string const& TileSourceWebMapService::getLayers() const {
@@ -439,6 +374,7 @@ std::string const& TileSourceWebMapService::getUrl() const {
 
 void TileSourceWebMapService::setDataType(TileDataType type) {
   mFormat = type;
+  resetDiskCache();
 }
 
 TileDataType TileSourceWebMapService::getDataType() const {
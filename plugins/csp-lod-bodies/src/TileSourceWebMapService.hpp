@@ -9,10 +9,14 @@
 
 #include "../../../src/cs-utils/ThreadPool.hpp"
 #include "Tile.hpp"
+#include "TileDiskCache.hpp"
 #include "TileSource.hpp"
 
 #include <cstdio>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 namespace csp::lodbodies {
 
@@ -37,7 +41,9 @@ class TileSourceWebMapService : public TileSource {
 
   TileNode* loadTile(int level, glm::int64 patchIdx) override;
 
-  void loadTileAsync(int level, glm::int64 patchIdx, OnLoadCallback cb) override;
+  void loadTileAsync(int level, glm::int64 patchIdx, OnLoadCallback cb,
+      cs::utils::TaskHandle const& handle) override;
+  void reprioritizeRequests() override;
   int  getPendingRequests() override;
 
   void     setMaxLevel(uint32_t maxLevel);
@@ -46,6 +52,10 @@ class TileSourceWebMapService : public TileSource {
   void               setCacheDirectory(std::string const& cacheDirectory);
   std::string const& getCacheDirectory() const;
 
+  /// The maximum size of the local cache of this data set in bytes.
+  void     setCacheSize(uint64_t bytes);
+  uint64_t getCacheSize() const;
+
   void               setLayers(std::string const& layers);
   std::string const& getLayers() const;
 
@@ -58,19 +68,28 @@ class TileSourceWebMapService : public TileSource {
   bool isSame(TileSource const* other) const override;
 
   /// These can be used to pre-populate the local cache, returns true if the tile is on the diagonal
-  /// of base patch 4 (the one which is cut in two halves).
-  static bool getXY(int level, glm::int64 patchIdx, int& x, int& y);
-  std::string loadData(int level, int x, int y);
+  /// of base patch 4 (the one which is cut in two halves). loadData() returns the encoded tile
+  /// (a TIFF or PNG file). It is read from the local cache or downloaded and stored in the cache.
+  static bool       getXY(int level, glm::int64 patchIdx, int& x, int& y);
+  std::vector<char> loadData(int level, int x, int y);
 
  private:
-  static std::mutex mTileSystemMutex;
+  /// Lazily opens the cache for the current cache directory, layers and data type. Returns nullptr
+  /// if the cache cannot be opened; tiles will be downloaded each time in this case.
+  std::shared_ptr<TileDiskCache> getDiskCache();
+  void                           resetDiskCache();
 
   cs::utils::ThreadPool mThreadPool;
   std::string           mUrl;
   std::string           mCache = "cache/img";
   std::string           mLayers;
-  TileDataType          mFormat   = TileDataType::eU8Vec3;
-  uint32_t              mMaxLevel = 10;
+  TileDataType          mFormat    = TileDataType::eU8Vec3;
+  uint32_t              mMaxLevel  = 10;
+  uint64_t              mCacheSize = uint64_t{4096} << 20U;
+
+  mutable std::mutex             mDiskCacheMutex;
+  std::shared_ptr<TileDiskCache> mDiskCache;
+  bool                           mDiskCacheFailed = false;
 };
 } // namespace csp::lodbodies
 
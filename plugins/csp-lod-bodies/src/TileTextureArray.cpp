@@ -11,12 +11,19 @@
 
 #include <VistaBase/VistaStreamUtils.h>
 
+#include <algorithm>
+
 namespace csp::lodbodies {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 namespace {
 
+// The number of layers by which the texture grows or shrinks at least.
+int const cPageSize = 64;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 // functions to obtain texture internal/external format and type
 // from TileDataType value
 GLenum getInternalFormat(TileDataType dataType) {
@@ -78,11 +85,12 @@ GLenum getType(TileDataType dataType) {
 TileTextureArray::TileTextureArray(TileDataType dataType, int maxLayerCount)
     : boost::noncopyable()
     , mTexId(0U)
-    , mIformat()
-    , mFormat()
-    , mType()
+    , mTexLayerCount(0)
+    , mIformat(getInternalFormat(dataType))
+    , mFormat(getFormat(dataType))
+    , mType(getType(dataType))
     , mDataType(dataType)
-    , mNumLayers(maxLayerCount) {
+    , mAllocator(cPageSize, maxLayerCount) {
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -123,35 +131,29 @@ void TileTextureArray::releaseGPU(RenderData* rdata) {
 
 void TileTextureArray::processQueue(int maxItems) {
   if (mUploadQueue.empty()) {
+    // Frames without uploads are used to give back memory which is not needed anymore.
+    compact(maxItems);
     return;
   }
 
   preUpload();
 
-  std::size_t upload = std::min<std::size_t>(maxItems, mUploadQueue.size());
-
-  if (mFreeLayers.size() < upload) {
-    // XXX TODO This is bad for performance and visuals, since *all* tiles
-    // must be (re)-uploaded to the larger texture
-    vstr::warnp() << "[TileTextureArray::processQueue]"
-                  << " Pre-allocated GPU storage exhausted!"
-                  << " [" << getUsedLayerCount() << " | " << getTotalLayerCount() << "]"
-                  << std::endl;
-  }
-
   int count = 0;
 
   while (!mUploadQueue.empty() && count < maxItems) {
-    if (mFreeLayers.empty()) {
-      break;
-    }
-
     RenderData* rdata = mUploadQueue.back();
 
     // rdata could be NULL if a tile is removed before it is ever
     // uploaded to the GPU, c.f. releaseGPU
     if (rdata != nullptr) {
-      allocateLayer(rdata);
+      if (!allocateLayer(rdata)) {
+        vstr::warnp() << "[TileTextureArray::processQueue]"
+                      << " Maximum GPU storage exhausted!"
+                      << " [" << getUsedLayerCount() << " | " << getTotalLayerCount() << "]"
+                      << std::endl;
+        break;
+      }
+
       ++count;
     }
 
@@ -163,9 +165,9 @@ void TileTextureArray::processQueue(int maxItems) {
   if (count > 0) {
 #if !defined(NDEBUG) && !defined(VISTAPLANET_NO_VERBOSE)
     vstr::outi() << "[TileTextureArray::processQueue]"
-                 << " uploaded/pending/used/free layers " << count << " / " << mUploadQueue.size()
-                 << " / " << (mNumLayers - mFreeLayers.size()) << " / " << mFreeLayers.size()
-                 << std::endl;
+                 << " uploaded/pending/used/total layers " << count << " / "
+                 << mUploadQueue.size() << " / " << getUsedLayerCount() << " / "
+                 << getTotalLayerCount() << std::endl;
 #endif
   }
 }
@@ -179,36 +181,31 @@ unsigned int TileTextureArray::getTextureId() const {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 std::size_t TileTextureArray::getTotalLayerCount() const {
-  return mNumLayers;
+  return mAllocator.getCapacity();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 std::size_t TileTextureArray::getUsedLayerCount() const {
-  return mNumLayers - mFreeLayers.size();
+  return mAllocator.getUsedCount();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void TileTextureArray::allocateTexture(TileDataType dataType) {
-  if (mTexId > 0U) {
-    return;
-  }
+void TileTextureArray::resizeTexture(GLint layerCount) {
+  GLuint const oldTexId      = mTexId;
+  GLint const  oldLayerCount = mTexLayerCount;
 
-  // allocate a 2D array texture for storing tile data of type dataType
+  // allocate a 2D array texture for storing tile data of type mDataType
 
   glGenTextures(1, &mTexId);
 
   GLsizei const level  = 0;
   GLsizei const width  = TileBase::SizeX;
   GLsizei const height = TileBase::SizeY;
-  GLsizei const depth  = mNumLayers;
+  GLsizei const depth  = layerCount;
   GLint const   border = 0;
 
-  mIformat = getInternalFormat(dataType);
-  mFormat  = getFormat(dataType);
-  mType    = getType(dataType);
-
   glBindTexture(GL_TEXTURE_2D_ARRAY, mTexId);
   glTexImage3D(
       GL_TEXTURE_2D_ARRAY, level, mIformat, width, height, depth, border, mFormat, mType, nullptr);
@@ -219,14 +216,35 @@ void TileTextureArray::allocateTexture(TileDataType dataType) {
   glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
   glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-  glBindTexture(GL_TEXTURE_2D_ARRAY, 0U);
-
-  // all layers of newly allocated texture are available for use
-  mFreeLayers.reserve(mNumLayers);
+  mTexLayerCount = layerCount;
+  mLayerData.resize(layerCount, nullptr);
+
+  // Keep the tiles which are already on the GPU. If possible, they are copied on the GPU, else
+  // they are uploaded again. The allocator ensures that no used layer is dropped.
+  GLint const copyCount = std::min(oldLayerCount, layerCount);
+
+  if (oldTexId > 0U && copyCount > 0) {
+    if (GLEW_ARB_copy_image) {
+      glCopyImageSubData(oldTexId, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, mTexId,
+          GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, width, height, copyCount);
+    } else {
+      for (GLint layer = 0; layer < copyCount; ++layer) {
+        if (mLayerData.at(layer)) {
+          uploadLayer(mLayerData.at(layer), layer);
+        }
+      }
+    }
+  }
 
-  for (int i = 0; i < mNumLayers; ++i) {
-    mFreeLayers.push_back(mNumLayers - i - 1);
+  if (oldTexId > 0U) {
+    glDeleteTextures(1, &oldTexId);
   }
+
+#if !defined(NDEBUG) && !defined(VISTAPLANET_NO_VERBOSE)
+  vstr::outi() << "[TileTextureArray::resizeTexture]"
+               << " resized from " << oldLayerCount << " to " << layerCount << " layers"
+               << std::endl;
+#endif
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -237,24 +255,60 @@ void TileTextureArray::releaseTexture() {
   }
 
   glDeleteTextures(1, &mTexId);
-  mTexId = 0U;
-  mFreeLayers.clear();
+  mTexId         = 0U;
+  mTexLayerCount = 0;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 // Uploads tile data from the node associated with @a rdata to the GPU.
 // @note May only be called after a call to @c preUpload.
-void TileTextureArray::allocateLayer(RenderData* rdata) {
-  assert(!mFreeLayers.empty());
+bool TileTextureArray::allocateLayer(RenderData* rdata) {
   assert(rdata->getTexLayer() < 0);
 
+  int layer = mAllocator.allocate();
+
+  if (layer < 0) {
+    return false;
+  }
+
+  if (mAllocator.getCapacity() > mTexLayerCount) {
+    resizeTexture(mAllocator.getCapacity());
+  }
+
+  uploadLayer(rdata, layer);
+
+  mLayerData.at(layer) = rdata;
+  rdata->setTexLayer(layer);
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileTextureArray::releaseLayer(RenderData* rdata) {
+  GLint layer = rdata->getTexLayer();
+  assert(layer >= 0);
+
+  // only release layers which have been allocated for rdata by this array -
+  // the texture layer of rdata may have been set elsewhere (e.g. by tree
+  // managers which do not upload to the GPU at all)
+  if (mAllocator.isUsed(layer) && mLayerData.at(layer) == rdata) {
+    mAllocator.release(layer);
+    mLayerData.at(layer) = nullptr;
+  }
+
+  // record that rdata is not currently on the GPU (i.e. set the texture
+  // layer to an invalid value)
+  rdata->setTexLayer(-1);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileTextureArray::uploadLayer(RenderData* rdata, GLint layer) {
   TileNode* node = rdata->getNode();
   TileBase* tile = node->getTile();
 
-  int layer = mFreeLayers.back();
-  mFreeLayers.pop_back();
-
   GLint const   level   = 0;
   GLint const   xoffset = 0;
   GLint const   yoffset = 0;
@@ -265,25 +319,64 @@ void TileTextureArray::allocateLayer(RenderData* rdata) {
 
   glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, xoffset, yoffset, layer, width, height, depth,
       mFormat, mType, data);
+}
 
-  rdata->setTexLayer(layer);
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TileTextureArray::moveLayer(TileLayerAllocator::Move const& move) {
+  RenderData* rdata = mLayerData.at(move.mFrom);
+
+  if (GLEW_ARB_copy_image) {
+    glCopyImageSubData(mTexId, GL_TEXTURE_2D_ARRAY, 0, 0, 0, move.mFrom, mTexId,
+        GL_TEXTURE_2D_ARRAY, 0, 0, 0, move.mTo, TileBase::SizeX, TileBase::SizeY, 1);
+  } else {
+    uploadLayer(rdata, move.mTo);
+  }
+
+  mLayerData.at(move.mTo)   = rdata;
+  mLayerData.at(move.mFrom) = nullptr;
+  rdata->setTexLayer(move.mTo);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void TileTextureArray::releaseLayer(RenderData* rdata) {
-  assert(rdata->getTexLayer() >= 0);
+void TileTextureArray::compact(int maxMoves) {
+  if (mTexId == 0U) {
+    return;
+  }
 
-  // simply mark the layer as available and record that rdata is not
-  // currently on the GPU (i.e. set the texture layer to an invalid value)
-  mFreeLayers.push_back(rdata->getTexLayer());
-  rdata->setTexLayer(-1);
+  // The moves have to be applied before the texture is shrunk.
+  auto moves  = mAllocator.compact(maxMoves);
+  bool shrink = mAllocator.shrink();
+
+  if (moves.empty() && !shrink) {
+    return;
+  }
+
+  preUpload();
+
+  for (auto const& move : moves) {
+    moveLayer(move);
+  }
+
+  if (shrink) {
+    resizeTexture(mAllocator.getCapacity());
+  }
+
+  postUpload();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void TileTextureArray::preUpload() {
-  allocateTexture(mDataType);
+  // The number of layers supported by the implementation can only be queried once there is a
+  // current context.
+  if (mTexId == 0U) {
+    GLint maxLayers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+    mAllocator.setMaxLayerCount(std::min(mAllocator.getMaxLayerCount(), maxLayers));
+  }
+
   glBindTexture(GL_TEXTURE_2D_ARRAY, mTexId);
 }
 
@@ -8,6 +8,7 @@
 #define CSP_LOD_BODIES_TILETEXTUREARRAY_HPP
 
 #include "TileDataType.hpp"
+#include "TileLayerAllocator.hpp"
 
 #include <GL/glew.h>
 #include <array>
@@ -25,12 +26,17 @@ class TreeManagerBase;
 /// requests.
 ///
 /// Tile data is stored in a 2D array texture (GL_TEXTURE_2D_ARRAY) with width and height matching
-/// those of a single tile and as many layers as there are tiles that can be kept on the GPU at
-/// once. If more tiles are needed on the GPU the array texture must be resized (which requires all
-/// tiles to be re-uploaded), this should be avoided to prevent the tile resolution to drop
-/// dramatically while only low resolution tiles are on the GPU.
+/// those of a single tile. The layers are managed by a TileLayerAllocator, so the number of layers
+/// grows and shrinks in pages with the number of tiles which are needed on the GPU. When the
+/// texture grows, the existing layers are copied on the GPU to the new texture. Therefore, the
+/// layers of all tiles stay valid and no tile has to be uploaded again. When fewer tiles are
+/// needed, the tiles in the last layers are moved to free layers further down in frames without
+/// pending uploads. Once the last pages are unused, the texture is shrunk. The layer of each tile
+/// is stored in its RenderData; moving a tile updates it accordingly.
 class TileTextureArray : private boost::noncopyable {
  public:
+  /// The texture never grows beyond maxLayerCount layers. It is not allocated before the first
+  /// tile is uploaded.
   explicit TileTextureArray(TileDataType dataType, int maxLayerCount);
 
   TileTextureArray(TileTextureArray const& other) = delete;
@@ -47,37 +53,47 @@ class TileTextureArray : private boost::noncopyable {
   /// Release GPU resources allocated for the tile associated with rdata.
   void releaseGPU(RenderData* rdata);
 
-  /// Process up to maxItems upload requests.
+  /// Process up to maxItems upload requests. If there are no upload requests, up to maxItems layers
+  /// are moved in order to shrink the texture.
   void processQueue(int maxItems);
 
   /// Returns the OpenGL id of the texture used to store tiles on the GPU. This is an internal
   /// interface for TileRenderer.
   unsigned int getTextureId() const;
 
-  /// Gets Total Layer Count
+  /// Gets the number of layers of the texture.
   std::size_t getTotalLayerCount() const;
 
   /// Gets Used Layer Count
   std::size_t getUsedLayerCount() const;
 
  private:
-  void allocateTexture(TileDataType dataType);
+  /// Replaces the texture by one with the given number of layers. The content of the layers which
+  /// exist in both textures is copied.
+  void resizeTexture(GLint layerCount);
   void releaseTexture();
 
-  void allocateLayer(RenderData* rdata);
+  /// Returns false if there is no free layer and the texture cannot grow any further.
+  bool allocateLayer(RenderData* rdata);
   void releaseLayer(RenderData* rdata);
+  void uploadLayer(RenderData* rdata, GLint layer);
+  void moveLayer(TileLayerAllocator::Move const& move);
+
+  /// Moves up to maxMoves layers and shrinks the texture if possible.
+  void compact(int maxMoves);
 
   void        preUpload();
   static void postUpload();
 
   GLuint       mTexId;
+  GLint        mTexLayerCount;
   GLenum       mIformat;
   GLenum       mFormat;
   GLenum       mType;
   TileDataType mDataType;
 
-  const GLint        mNumLayers;
-  std::vector<GLint> mFreeLayers;
+  TileLayerAllocator       mAllocator;
+  std::vector<RenderData*> mLayerData;
 
   std::vector<RenderData*> mUploadQueue;
 };
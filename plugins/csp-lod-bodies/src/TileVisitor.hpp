@@ -34,6 +34,7 @@ class TileNode;
 ///
 /// @code{.cpp}
 /// preTraverse()
+/// visitRoots()
 ///   preVisitRoot()        // root 0
 ///     preVisit()          // root 0 - child 0
 ///     postVisit()         // root 0 - child 0
@@ -53,6 +54,9 @@ class TileNode;
 /// the preVisit / preVisitRoot callbacks, but the postVisit / postVisitRoot ones will not see
 /// correct values!
 ///
+/// By default visitRoots visits one root after another. DerivedT may reimplement it in order to
+/// visit the roots in a different way, e.g. concurrently, by calling visitRoot(int) for each root.
+///
 /// If the "callback" functions (pre/postTraverse, pre/postVisit) are protected or private in
 /// DerivedT make TileVisitor a friend class so that it can call these functions.
 template <typename DerivedT>
@@ -91,6 +95,9 @@ class TileVisitor {
   DerivedType&       self();
   DerivedType const& self() const;
 
+  /// Visits the root node with index rootIdx and all its descendants.
+  void visitRoot(int rootIdx);
+
   void visitRoot(TileNode* rootDEM, TileNode* rootIMG, TileId tileId);
   void visitLevel(TileNode* nodeDEM, TileNode* nodeIMG, TileId tileId);
 
@@ -104,6 +111,10 @@ class TileVisitor {
   /// nothing.
   virtual void postTraverse();
 
+  /// Called after preTraverse if that returned true. Reimplement in the derived class, the
+  /// default visits all root nodes one after another.
+  virtual void visitRoots();
+
   /// Called for each root node visited, before visiting any children. Returns if any
   /// children
   /// should be visited (true) or skipped (false).
@@ -153,13 +164,7 @@ TileVisitor<DerivedT>::TileVisitor(TileQuadTree* treeDEM, TileQuadTree* treeIMG)
 template <typename DerivedT>
 void TileVisitor<DerivedT>::visit() {
   if (self().preTraverse()) {
-    for (int i = 0; i < TileQuadTree::sNumRoots; ++i) {
-      TileNode* rootDEM = mTreeDEM->getRoot(i);
-      TileNode* rootIMG = mTreeIMG ? mTreeIMG->getRoot(i) : nullptr;
-
-      // if (i==7)
-      visitRoot(rootDEM, rootIMG, TileId(0, i));
-    }
+    self().visitRoots();
   }
 
   self().postTraverse();
@@ -220,6 +225,14 @@ typename TileVisitor<DerivedT>::DerivedType const& TileVisitor<DerivedT>::self()
   return *static_cast<DerivedType const*>(this);
 }
 
+template <typename DerivedT>
+void TileVisitor<DerivedT>::visitRoot(int rootIdx) {
+  TileNode* rootDEM = mTreeDEM->getRoot(rootIdx);
+  TileNode* rootIMG = mTreeIMG ? mTreeIMG->getRoot(rootIdx) : nullptr;
+
+  visitRoot(rootDEM, rootIMG, TileId(0, rootIdx));
+}
+
 template <typename DerivedT>
 void TileVisitor<DerivedT>::visitRoot(TileNode* rootDEM, TileNode* rootIMG, TileId tileId) {
   // check that nodes have expected level - if this triggers the trees are
@@ -307,6 +320,13 @@ void TileVisitor<DerivedT>::postTraverse() {
   // default impl - empty
 }
 
+template <typename DerivedT>
+void TileVisitor<DerivedT>::visitRoots() {
+  for (int i = 0; i < TileQuadTree::sNumRoots; ++i) {
+    visitRoot(i);
+  }
+}
+
 template <typename DerivedT>
 bool TileVisitor<DerivedT>::preVisitRoot(TileId const& /*tileId*/) {
   // default impl - do not visit children
@@ -14,7 +14,7 @@ namespace csp::lodbodies {
 
 template <>
 /* virtual */ RenderData* TreeManager<RenderDataDEM>::allocateRenderData(TileNode* node) {
-  RenderDataDEM* rdata = mPool.construct();
+  RenderDataDEM* rdata = construct();
 
   // init rdata
   rdata->setNode(node);
@@ -12,13 +12,18 @@
 #include "TreeManagerBase.hpp"
 
 #include <boost/cast.hpp>
-#include <boost/pool/object_pool.hpp>
+#include <boost/pool/pool.hpp>
+
+#include <new>
 
 namespace csp::lodbodies {
 
 /// Implements management of a TileQuadTree with associated data of type RDataT (which must be
 /// derived from RenderData). Almost all functionality is implemented in the base class
 /// TreeManagerBase, only allocation and release of the associated data for a node is managed here.
+///
+/// The data is allocated from a pool. Unlike boost::object_pool, whose destroy() has to search the
+/// ordered free list, returning data to a plain boost::pool takes constant time.
 template <typename RDataT>
 class TreeManager : public TreeManagerBase {
  public:
@@ -37,7 +42,10 @@ class TreeManager : public TreeManagerBase {
   RenderData* allocateRenderData(TileNode* node) override;
   void        releaseRenderData(RenderData* rdata) override;
 
-  boost::object_pool<RDataT> mPool;
+  /// Constructs a new RDataT in memory taken from mPool.
+  RDataT* construct();
+
+  boost::pool<> mPool;
 };
 
 template <>
@@ -48,16 +56,35 @@ template <typename RDataT>
 TreeManager<RDataT>::TreeManager(
     PlanetParameters const& params, std::shared_ptr<GLResources> const& glResources)
     : TreeManagerBase(params, glResources)
-    , mPool() {
+    , mPool(sizeof(RDataT)) {
 }
 
 template <typename RDataT>
 /* virtual */
-TreeManager<RDataT>::~TreeManager() = default;
+TreeManager<RDataT>::~TreeManager() {
+  // mPool does not know which of its chunks are in use, so the remaining data
+  // has to be destroyed here.
+  while (!mLru.empty()) {
+    releaseRenderData(mLru.back());
+  }
+
+  mRdMap.clear();
+}
+
+template <typename RDataT>
+RDataT* TreeManager<RDataT>::construct() {
+  void* memory = mPool.malloc();
+
+  if (!memory) {
+    throw std::bad_alloc();
+  }
+
+  return new (memory) RDataT();
+}
 
 template <typename RDataT>
 /* virtual */ RenderData* TreeManager<RDataT>::allocateRenderData(TileNode* node) {
-  RDataT* rdata = mPool.construct();
+  RDataT* rdata = construct();
 
   rdata->setNode(node);
   rdata->setLastFrame(0);
@@ -69,7 +96,8 @@ template <typename RDataT>
 /* virtual */ void TreeManager<RDataT>::releaseRenderData(RenderData* rdata) {
   RDataT* rd = boost::polymorphic_downcast<RDataT*>(rdata);
 
-  mPool.destroy(rd);
+  rd->~RDataT();
+  mPool.free(rd);
 }
 
 } // namespace csp::lodbodies
@@ -13,6 +13,7 @@
 
 #include <VistaBase/VistaStreamUtils.h>
 
+#include <algorithm>
 #include <utility>
 
 namespace csp::lodbodies {
@@ -34,6 +35,10 @@ int const maxNodeAge = 10;
 // is kept around
 int const maxUnmergedAge = 500;
 
+// number of frames a pending request is kept in the queue of the tile
+// source without being requested again
+int const maxRequestAge = 10;
+
 // number of nodes to pre-allocate data structures
 std::size_t const preAllocNodeCount = 500;
 
@@ -46,41 +51,13 @@ std::size_t const preAllocIONodeCount = 200;
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-// Function object to compare RDMapValue objects by their age.
-struct TreeManagerBase::AgeLess {
-  explicit AgeLess(int frame);
-
-  bool operator()(RDMapValue const* lhs, RDMapValue const* rhs) const;
-
-  int mFrame;
-};
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
 /* explicit */
-TreeManagerBase::AgeLess::AgeLess(int frame)
+TreeManagerBase::PendingTile::PendingTile(int frame)
     : mFrame(frame) {
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-bool TreeManagerBase::AgeLess::operator()(RDMapValue const* lhs, RDMapValue const* rhs) const {
-  // sort by age (frames since last use), in case of a tie use
-  // tile level - this ensure that child nodes are always sorted
-  // after parent nodes
-
-  int ageLHS = lhs->second->getAge(mFrame);
-  int ageRHS = rhs->second->getAge(mFrame);
-
-  if (ageLHS == ageRHS) {
-    return lhs->first.level() < rhs->first.level();
-  }
-
-  return ageLHS < ageRHS;
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
 /* explicit */
 TreeManagerBase::NodeAge::NodeAge(TileNode* node, int frame)
     : mNode(node)
@@ -94,11 +71,13 @@ TreeManagerBase::TreeManagerBase(
     PlanetParameters const& params, std::shared_ptr<GLResources> glResources)
     : mParams(&params)
     , mGlMgr(std::move(glResources))
+    , mPyramidArena(std::make_shared<MinMaxPyramidArena>())
     , mSrc()
     , mFrameCount(0)
-    , mAsyncLoading(true) {
+    , mAsyncLoading(true)
+    , mMemoryCache(mPyramidArena) {
   mRdMap.reserve(preAllocNodeCount);
-  mAgeStore.reserve(preAllocNodeCount);
+  mPruneNodes.reserve(preAllocNodeCount);
 
   mUnmergedNodes.reserve(preAllocIONodeCount);
   mLoadedNodes.reserve(preAllocIONodeCount);
@@ -115,7 +94,12 @@ void TreeManagerBase::setSource(TileSource* src) {
   // remove all existing nodes
   std::unique_lock<std::mutex> lck(mLoadedMtx);
   clear();
+  mMemoryCache.clear();
   mSrc = src;
+
+  if (mSrc) {
+    mSrc->setMinMaxPyramidArena(mPyramidArena);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -128,9 +112,9 @@ TileSource* TreeManagerBase::getSource() const {
 
 void TreeManagerBase::request(std::vector<TileId> const& tileIds) {
   // for each requested tile, check if it is already in the mPendingTiles
-  // set (those are tiles that have already been requesed from the tile
-  // source), otherwise put the tile in mPendingTiles and ask the source to
-  // load the tile.
+  // map (those are tiles that have already been requesed from the tile
+  // source). If so, just update the priority of the request. Otherwise put
+  // the tile in mPendingTiles and ask the source to load the tile.
   // In the case of async loading, register @c onNodeLoaded as the callback
   // that the source invokes when the tile is ready.
   std::unique_lock<std::mutex> lck(mLoadedMtx);
@@ -139,19 +123,42 @@ void TreeManagerBase::request(std::vector<TileId> const& tileIds) {
   auto iEnd = tileIds.end();
 
   for (; iIt != iEnd; ++iIt) {
-    if (mPendingTiles.count(*iIt) == 0) {
-      mPendingTiles.insert(*iIt);
+    // Recently requested tiles are loaded first, coarse levels before fine levels.
+    double priority = mFrameCount * 100.0 - iIt->level();
+    auto   pIt      = mPendingTiles.find(*iIt);
+
+    if (pIt != mPendingTiles.end()) {
+      pIt->second.mFrame = mFrameCount;
+      pIt->second.mHandle.setPriority(priority);
+    } else {
+      PendingTile& pending = mPendingTiles.emplace(*iIt, PendingTile(mFrameCount)).first->second;
+      pending.mHandle.setPriority(priority);
 
       if (mAsyncLoading) {
+        // Tiles which have been pruned recently are restored from the memory cache.
+        if (mMemoryCache.loadAsync(
+                *iIt,
+                [this, source = mSrc, level = iIt->level(), patchIdx = iIt->patchIdx()](
+                    TileNode* node) { onNodeLoaded(source, level, patchIdx, node); },
+                pending.mHandle)) {
+          continue;
+        }
+
 #if (BOOST_VERSION / 100) % 1000 < 60
         mSrc->loadTileAsync(iIt->level(), iIt->patchIdx(),
-            std::bind(&TreeManagerBase::onNodeLoaded, this, _1, _2, _3, _4));
+            std::bind(&TreeManagerBase::onNodeLoaded, this, _1, _2, _3, _4), pending.mHandle);
 #else
         mSrc->loadTileAsync(iIt->level(), iIt->patchIdx(),
-            [this](auto a, auto b, auto c, auto d) { onNodeLoaded(a, b, c, d); });
+            [this](auto a, auto b, auto c, auto d) { onNodeLoaded(a, b, c, d); },
+            pending.mHandle);
 #endif
       } else {
-        TileNode* node = mSrc->loadTile(iIt->level(), iIt->patchIdx());
+        TileNode* node = mMemoryCache.load(*iIt);
+
+        if (!node) {
+          node = mSrc->loadTile(iIt->level(), iIt->patchIdx());
+        }
+
         onNodeLoaded(mSrc, iIt->level(), iIt->patchIdx(), node);
       }
     }
@@ -161,6 +168,9 @@ void TreeManagerBase::request(std::vector<TileId> const& tileIds) {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void TreeManagerBase::update() {
+  // drop requests for tiles which are not needed anymore
+  cancelStaleRequests();
+
   // remove unused nodes - do this before the merge to free up resources
   // that can then be consumed by newly loaded ones.
   prune();
@@ -175,18 +185,18 @@ void TreeManagerBase::update() {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void TreeManagerBase::clear() {
+  for (auto const& pending : mPendingTiles) {
+    pending.second.mHandle.cancel();
+  }
+
   mPendingTiles.clear();
   mLoadedNodes.clear();
 
-  auto rdIt  = mRdMap.begin();
-  auto rdEnd = mRdMap.end();
-
-  for (; rdIt != rdEnd; ++rdIt) {
-    releaseResources(rdIt->second);
+  while (!mLru.empty()) {
+    releaseResources(mLru.back());
   }
 
   mRdMap.clear();
-  mAgeStore.clear();
 
   for (int i = 0; i < TileQuadTree::sNumRoots; ++i) {
     mTree.setRoot(i, nullptr);
@@ -208,27 +218,15 @@ RenderData* TreeManagerBase::findRData(TileNode const* node) {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 RenderData const* TreeManagerBase::findRData(TileId const& tileId) const {
-  RenderData const* result = nullptr;
-  auto              rdIt   = mRdMap.find(tileId);
-
-  if (rdIt != mRdMap.end()) {
-    result = rdIt->second;
-  }
-
-  return result;
+  RenderData* const* rdata = mRdMap.find(tileId);
+  return rdata ? *rdata : nullptr;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 RenderData* TreeManagerBase::findRData(TileId const& tileId) {
-  RenderData* result = nullptr;
-  auto        rdIt   = mRdMap.find(tileId);
-
-  if (rdIt != mRdMap.end()) {
-    result = rdIt->second;
-  }
-
-  return result;
+  RenderData** rdata = mRdMap.find(tileId);
+  return rdata ? *rdata : nullptr;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -245,19 +243,37 @@ std::size_t TreeManagerBase::getNodeCountGPU() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+TileMemoryCache& TreeManagerBase::getMemoryCache() {
+  return mMemoryCache;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TileMemoryCache const& TreeManagerBase::getMemoryCache() const {
+  return mMemoryCache;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void TreeManagerBase::onNodeLoaded(
     TileSource* source, int level, glm::int64 patchIdx, TileNode* node) {
   std::unique_lock<std::mutex> lck(mLoadedMtx);
-  if (node && source == mSrc) {
+  auto                         pIt = mPendingTiles.find(TileId(level, patchIdx));
+
+  if (node && source == mSrc && pIt != mPendingTiles.end() && !pIt->second.mLoaded) {
     // Only add node to list of loaded nodes, actual insertion into the
     // quad-tree is done in merge().
     // This ensures that the tree is not modified at unpredictable moments
     // in time (for example while a traversal is in progress).
 
     mLoadedNodes.push_back(node);
+    pIt->second.mLoaded = true;
   } else {
-    // source has changed or loading failed, discard node
-    mPendingTiles.erase(TileId(level, patchIdx));
+    // source has changed, the request has been cancelled, the tile has been
+    // loaded twice or loading failed - discard node
+    if (pIt != mPendingTiles.end() && !pIt->second.mLoaded) {
+      mPendingTiles.erase(pIt);
+    }
     delete node; // NOLINT(cppcoreguidelines-owning-memory): TODO where does it get created?
   }
 }
@@ -265,66 +281,121 @@ void TreeManagerBase::onNodeLoaded(
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void TreeManagerBase::onNodeInserted(TileNode* node) {
-  RenderData* rdata = allocateRenderData(node);
+  RenderData* rdata  = allocateRenderData(node);
+  RenderData* rdataP = nullptr;
 
   if (node->getParent()) {
-    RenderData* rdataP = findRData(node->getParent());
+    rdataP = findRData(node->getParent());
     assert(rdataP != nullptr);
 
     rdata->setLastFrame(rdataP->getLastFrame());
   }
 
-  auto res = mRdMap.insert(RDMapValue(node->getTileId(), rdata));
-  assert(res.second);
+  [[maybe_unused]] bool inserted = mRdMap.insert(node->getTileId(), rdata);
+  assert(inserted);
 
   getTileTextureArray().allocateGPU(rdata);
-  mAgeStore.push_back(&(*res.first));
+
+  // the new node was last used in the same frame as its parent, so inserting
+  // it right in front of the parent keeps mLru sorted. Root nodes have never
+  // been used and are therefore the oldest ones.
+  if (rdataP) {
+    mLru.insertBefore(rdataP, rdata);
+  } else {
+    mLru.pushBack(rdata);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TreeManagerBase::removePendingTile(TileId const& tileId) {
+  std::unique_lock<std::mutex> lck(mLoadedMtx);
+  mPendingTiles.erase(tileId);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void TreeManagerBase::releaseResources(RenderData* rdata) {
+  mLru.remove(rdata);
   getTileTextureArray().releaseGPU(rdata);
   releaseRenderData(rdata);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void TreeManagerBase::cancelStaleRequests() {
+  {
+    std::unique_lock<std::mutex> lck(mLoadedMtx);
+
+    for (auto pIt = mPendingTiles.begin(); pIt != mPendingTiles.end();) {
+      // Tiles which are already loaded but not yet merged are kept, they are
+      // handled in merge().
+      if (!pIt->second.mLoaded && (mFrameCount - pIt->second.mFrame) > maxRequestAge) {
+        pIt->second.mHandle.cancel();
+        pIt = mPendingTiles.erase(pIt);
+      } else {
+        ++pIt;
+      }
+    }
+  }
+
+  if (mSrc) {
+    mSrc->reprioritizeRequests();
+  }
+
+  mMemoryCache.reprioritizeRequests();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void TreeManagerBase::prune() {
-  // sort by age, oldest nodes at the back
-  std::sort(mAgeStore.begin(), mAgeStore.end(), AgeLess(mFrameCount));
-  int count = 0;
+  // mLru is sorted by the frame in which nodes were last used, so all nodes
+  // that are too old are at its back - stop at the first node that is still
+  // in use. Root nodes are never removed.
+  mPruneNodes.clear();
 
-  while (!mAgeStore.empty()) {
-    RDMapValue* value = mAgeStore.back();
+  RenderData* oldest = mLru.back();
 
-    // remove unnused nodes, but never root nodes
-    if (value->second->getAge(mFrameCount) > maxNodeAge && value->first.level() > 0) {
-      TileNode* node = value->second->getNode();
+  while (oldest && oldest->getAge(mFrameCount) > maxNodeAge) {
+    if (oldest->getLevel() > 0) {
+      mPruneNodes.push_back(oldest);
+    }
 
-      releaseResources(value->second);
+    oldest = RenderDataLRU::newer(oldest);
+  }
 
-      if (!removeNode(&mTree, node)) {
-        vstr::errp() << "[TreeManagerBase::prune] [" << mName << "] Failed to remove node "
-                     << value->first << " @ " << node << "!" << std::endl;
-      }
+  // removing a node from the tree deletes its children as well, so child
+  // nodes have to be removed before their parents
+  std::sort(mPruneNodes.begin(), mPruneNodes.end(),
+      [](RenderData const* lhs, RenderData const* rhs) {
+        return lhs->getLevel() > rhs->getLevel();
+      });
 
-      // remove entries for node from internal data structures
-      mRdMap.erase(value->first);
-      mAgeStore.pop_back();
-      ++count;
+  for (RenderData* rdata : mPruneNodes) {
+    TileNode* node   = rdata->getNode();
+    TileId    tileId = node->getTileId();
+
+    releaseResources(rdata);
+
+    std::unique_ptr<TileNode> removed(releaseNode(&mTree, node));
+
+    if (removed) {
+      // The tile is compressed and kept in memory in case it is requested again.
+      mMemoryCache.storeAsync(
+          std::unique_ptr<TileBase>(removed->releaseTile()), removed->getChildMaxLevel());
     } else {
-      // The node at the back of mAgeStore can not be removed - stop
-      // The sorting of mAgeStore ensures that there is no node that
-      // could be removed beyond this point.
-      break;
+      vstr::errp() << "[TreeManagerBase::prune] [" << mName << "] Failed to remove node " << tileId
+                   << " @ " << node << "!" << std::endl;
     }
+
+    // remove entry for node from internal data structures
+    mRdMap.erase(tileId);
   }
 
-  if (count > 0) {
+  if (!mPruneNodes.empty()) {
 #if !defined(NDEBUG) && !defined(VISTAPLANET_NO_VERBOSE)
-    vstr::outi() << "[TreeManagerBase::prune] [" << mName << "] nodes removed/kept " << count
-                 << " / " << mRdMap.size() << std::endl;
+    vstr::outi() << "[TreeManagerBase::prune] [" << mName << "] nodes removed/kept "
+                 << mPruneNodes.size() << " / " << mRdMap.size() << std::endl;
 #endif
   }
 }
@@ -350,7 +421,7 @@ void TreeManagerBase::merge() {
     assert(node->getTile() != nullptr);
 
     if (insertNode(&mTree, node)) {
-      mPendingTiles.erase(node->getTileId());
+      removePendingTile(node->getTileId());
       onNodeInserted(node);
 
       ++merged;
@@ -372,13 +443,13 @@ void TreeManagerBase::merge() {
     if (insertNode(&mTree, node)) {
       // insert succeeded, remove from pending and unmerged and
       // associate render data with node
-      mPendingTiles.erase(node->getTileId());
+      removePendingTile(node->getTileId());
       mUnmergedNodes.erase(mUnmergedNodes.begin() + i);
 
       onNodeInserted(node);
     } else if ((mFrameCount - mUnmergedNodes[i].mFrame) > maxUnmergedAge) {
       // node is waiting for too long to be merged - discard it
-      mPendingTiles.erase(node->getTileId());
+      removePendingTile(node->getTileId());
       mUnmergedNodes.erase(mUnmergedNodes.begin() + i);
 
       delete node; // NOLINT(cppcoreguidelines-owning-memory): TODO where does it get created?
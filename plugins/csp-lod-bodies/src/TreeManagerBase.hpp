@@ -7,15 +7,20 @@
 #ifndef CSP_LOD_BODIES_TREEMANAGERBASE_HPP
 #define CSP_LOD_BODIES_TREEMANAGERBASE_HPP
 
+#include "MinMaxPyramid.hpp"
+#include "RenderDataLRU.hpp"
 #include "TileId.hpp"
+#include "TileIdMap.hpp"
+#include "TileMemoryCache.hpp"
 #include "TileQuadTree.hpp"
 
+#include "../../../src/cs-utils/ThreadPool.hpp"
+
 #include <boost/cast.hpp>
 #include <boost/noncopyable.hpp>
 #include <mutex>
 #include <string>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
 namespace csp::lodbodies {
@@ -38,11 +43,15 @@ class TileTextureArray;
 /// time it was used - other classes mark nodes as used (e.g. LODVisitor when testing visibility of
 /// a node).
 ///
-/// In order to quickly find "old" nodes a vector of pointers (AgeStore) to the entries of the
-/// RenderDataMap is used (this is possible because unordered_map guarantees that pointers to values
-/// do not change, even when rehashing occurs). The AgeStore is sorted so that the oldest nodes are
-/// at the back and those are removed if their age exceeds a certain threshold (see
-/// TreeManagerBase::prune).
+/// In order to quickly find "old" nodes, all RenderData are linked into an intrusive list
+/// (RenderDataLRU) which is kept sorted by the frame in which the data was last used. Whenever a
+/// node is marked as used, its data is moved to the front of the list in constant time. Therefore,
+/// the oldest nodes are always at the back of the list and those are removed if their age exceeds
+/// a certain threshold (see TreeManagerBase::prune). The RenderData is looked up by TileId in an
+/// open-addressing hash map (TileIdMap).
+///
+/// Pruned tiles are not discarded right away: They are kept compressed in a TileMemoryCache, so that
+/// they can be restored without asking the TileSource again when they are requested later on.
 class TreeManagerBase : private boost::noncopyable {
  public:
   explicit TreeManagerBase(
@@ -56,7 +65,8 @@ class TreeManagerBase : private boost::noncopyable {
 
   virtual ~TreeManagerBase() = 0;
 
-  /// Set tile source src to use.
+  /// Set tile source src to use. The source will create the MinMaxPyramids of its tiles from the
+  /// memory arena of this.
   void setSource(TileSource* src);
 
   /// Returns currently used tile source.
@@ -73,11 +83,14 @@ class TreeManagerBase : private boost::noncopyable {
   std::string const& getName() const;
 
   /// Request data tiles with indices tileIds to be loaded and queued to be merged into the quad
-  /// tree (with a subsequent call to update).
+  /// tree (with a subsequent call to update). Tiles which are requested in the current frame are
+  /// loaded before tiles which were requested in previous frames; coarser tiles are loaded before
+  /// finer tiles.
   void request(std::vector<TileId> const& tileIds);
 
   /// Update the TileQuadTree managed by this with the tiles that have been loaded from the
-  /// TileSource since the last call to update.
+  /// TileSource since the last call to update. Pending requests which have not been repeated for a
+  /// number of frames are cancelled.
   void update();
 
   /// Removes all nodes from the tree and frees data associated with them.
@@ -132,11 +145,21 @@ class TreeManagerBase : private boost::noncopyable {
   /// Returns the number of nodes uploaded to the GPU.
   std::size_t getNodeCountGPU() const;
 
- protected:
-  using RDMapValue = std::unordered_map<TileId, RenderData*>::value_type;
-  using AgeStore   = std::vector<RDMapValue*>;
+  /// Returns the cache which keeps pruned tiles in a compressed form. Its size is zero by default,
+  /// which disables it.
+  TileMemoryCache&       getMemoryCache();
+  TileMemoryCache const& getMemoryCache() const;
 
-  struct AgeLess;
+ protected:
+  /// Tracks a tile which has been requested from the TileSource but has not been merged into the
+  /// tree yet. mFrame is the last frame in which the tile has been requested.
+  struct PendingTile {
+    explicit PendingTile(int frame);
+
+    cs::utils::TaskHandle mHandle;
+    int                   mFrame;
+    bool                  mLoaded = false;
+  };
 
   /// Tracks a node and the frame it was loaded in - for nodes that can not immediately be merged.
   struct NodeAge {
@@ -153,6 +176,10 @@ class TreeManagerBase : private boost::noncopyable {
   /// TileQuadTree.
   void onNodeInserted(TileNode* node);
 
+  /// Helper function to remove a tile from mPendingTiles once its node has been merged or
+  /// discarded. This may be called without holding mLoadedMtx.
+  void removePendingTile(TileId const& tileId);
+
   /// Helper function to free resources associated with rdata.
   void releaseResources(RenderData* rdata);
 
@@ -162,9 +189,13 @@ class TreeManagerBase : private boost::noncopyable {
   /// Releases the data associated with a node, which was previously returned by allocateRenderData.
   virtual void releaseRenderData(RenderData* rdata) = 0;
 
+  /// Cancels requests which have not been repeated for a number of frames and passes the updated
+  /// priorities of all other requests to the TileSource.
+  void cancelStaleRequests();
+
   /// Remove nodes from the managed TileQuadTree that have not been used for a number of frames.
-  /// Sort tiles by age (frames since last use, see TreeManagerBase::AgeLess for details) and
-  /// removes those considered too "old".
+  /// The nodes considered too "old" are taken from the back of mLru, so only the removed nodes have
+  /// to be visited.
   void prune();
 
   /// Merge nodes loaded since the last merge into the managed TileQuadTree. It is possible that a
@@ -175,16 +206,18 @@ class TreeManagerBase : private boost::noncopyable {
   /// tree it is deleted (see TreeManagerBase::mergeUnmerged).
   void merge();
 
-  PlanetParameters const*                 mParams;
-  std::shared_ptr<GLResources>            mGlMgr;
-  std::unordered_map<TileId, RenderData*> mRdMap;
-  AgeStore                                mAgeStore;
+  PlanetParameters const*             mParams;
+  std::shared_ptr<GLResources>        mGlMgr;
+  std::shared_ptr<MinMaxPyramidArena> mPyramidArena;
+  TileIdMap<RenderData*>              mRdMap;
+  RenderDataLRU                       mLru;
+  std::vector<RenderData*>            mPruneNodes;
 
   TileQuadTree mTree;
   TileSource*  mSrc;
 
-  std::unordered_set<TileId> mPendingTiles;
-  std::vector<NodeAge>       mUnmergedNodes;
+  std::unordered_map<TileId, PendingTile> mPendingTiles;
+  std::vector<NodeAge>                    mUnmergedNodes;
 
   std::mutex             mLoadedMtx;
   std::vector<TileNode*> mLoadedNodes;
@@ -192,6 +225,10 @@ class TreeManagerBase : private boost::noncopyable {
   std::string mName;
   int         mFrameCount;
   bool        mAsyncLoading;
+
+  // This is declared last, so that its pending tasks are finished before any other member is
+  // destroyed.
+  TileMemoryCache mMemoryCache;
 };
 
 template <typename RDataT>
@@ -40,7 +40,8 @@ VistaPlanet::VistaPlanet(std::shared_ptr<GLResources> const& glResources)
     , mSumLoadTiles(0)
     , mMaxDrawTiles(0)
     , mMaxLoadTiles(0)
-    , mFlags(0) {
+    , mFlags(0)
+    , mPipelinedTraversal(false) {
   mTreeMgrDEM.setName("DEM");
   mTreeMgrIMG.setName("IMG");
 }
@@ -49,6 +50,8 @@ VistaPlanet::VistaPlanet(std::shared_ptr<GLResources> const& glResources)
 
 /* virtual */
 VistaPlanet::~VistaPlanet() {
+  mLodVisitor.wait();
+
   // clear tree managers
   mTreeMgrDEM.clear();
   mTreeMgrIMG.clear();
@@ -70,6 +73,10 @@ VistaPlanet::~VistaPlanet() {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 /* virtual */ void VistaPlanet::doShadows() {
+  // The shadow pass selects its tiles synchronously. As it has to wait for a pipelined traversal
+  // first, the trees will be traversed synchronously in doFrame() as well. Hence pipelining has no
+  // effect while shadows are enabled.
+  mLodVisitor.wait();
   mLodVisitor.visit();
 
   // get matrices and viewport
@@ -141,6 +148,8 @@ void VistaPlanet::setDEMSource(TileSource* srcDEM) {
     return;
   }
 
+  mLodVisitor.wait();
+
   // shut down old source
   if (mSrcDEM) {
     mSrcDEM->fini();
@@ -176,6 +185,8 @@ void VistaPlanet::setIMGSource(TileSource* srcIMG) {
     return;
   }
 
+  mLodVisitor.wait();
+
   // shut down old source
   if (mSrcIMG) {
     mSrcIMG->fini();
@@ -216,23 +227,41 @@ void VistaPlanet::doFrame() {
   glm::fmat4x4 matP     = getProjectionMatrix();
   glm::ivec4   viewport = getViewport();
 
+  // if the traversal is pipelined, the tiles for this frame have been
+  // selected in the background since the end of the previous frame - unless
+  // somebody else (e.g. a height query loading tiles) has waited for it in
+  // the meantime, then the trees may have changed and are traversed again
+  bool pipelined = mPipelinedTraversal && mLodVisitor.hasPendingTraversal();
+  mLodVisitor.wait();
+
   // collect/print statistics
   updateStatistics(frameCount);
 
-  // update bounding boxes
-  updateTileBounds();
+  if (!pipelined) {
+    // update bounding boxes
+    updateTileBounds();
 
-  // integrate newly loaded tiles/remove unused tiles
-  updateTileTrees(frameCount);
+    // integrate newly loaded tiles/remove unused tiles
+    updateTileTrees(frameCount);
 
-  // determine tiles to draw and load
-  traverseTileTrees(frameCount, matVM, matP, viewport);
+    // determine tiles to draw and load
+    traverseTileTrees(frameCount, matVM, matP, viewport, false);
+  }
 
   // pass requests to load tiles to TreeManagers
   processLoadRequests();
 
   // render
   renderTiles(frameCount, matVM, matP, mShadowMap);
+
+  // the trees must not be modified between the traversal and rendering, as
+  // unused tiles are removed - so update them now and select the tiles for
+  // the next frame while this one is being drawn
+  if (mPipelinedTraversal) {
+    updateTileBounds();
+    updateTileTrees(frameCount);
+    traverseTileTrees(frameCount, matVM, matP, viewport, true);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -269,6 +298,21 @@ void VistaPlanet::updateStatistics(int frameCount) {
     }
 
     vstr::out() << std::endl;
+
+    for (auto const* treeMgr : {static_cast<TreeManagerBase const*>(&mTreeMgrDEM),
+             static_cast<TreeManagerBase const*>(&mTreeMgrIMG)}) {
+      auto   statistics = treeMgr->getMemoryCache().getStatistics();
+      double requests   = static_cast<double>(statistics.mHits + statistics.mMisses);
+
+      if (statistics.mTileCount > 0) {
+        vstr::outi() << "[VistaPlanet::Do] [" << treeMgr->getName() << "] memory cache tiles ["
+                     << statistics.mTileCount << "] size [" << (statistics.mSize >> 20U)
+                     << " / " << (statistics.mRawSize >> 20U) << " MB] hit rate ["
+                     << std::setprecision(2) << (requests > 0 ? statistics.mHits / requests : 0.0)
+                     << "] decode time [" << std::setprecision(4) << statistics.mDecodeTime
+                     << " ms]" << std::setprecision(6) << std::endl;
+      }
+    }
 #endif
 
     mSumFrameClock = 0.0;
@@ -307,8 +351,8 @@ void VistaPlanet::updateTileTrees(int frameCount) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void VistaPlanet::traverseTileTrees(
-    int frameCount, glm::dmat4 const& matVM, glm::fmat4x4 const& matP, glm::ivec4 const& viewport) {
+void VistaPlanet::traverseTileTrees(int frameCount, glm::dmat4 const& matVM,
+    glm::fmat4x4 const& matP, glm::ivec4 const& viewport, bool async) {
   // update per-frame information of LODVisitor
   mLodVisitor.setFrameCount(frameCount);
   mLodVisitor.setModelview(matVM);
@@ -317,7 +361,11 @@ void VistaPlanet::traverseTileTrees(
 
   // traverse quad trees and determine nodes to render and load
   // respectively
-  mLodVisitor.visit();
+  if (async) {
+    mLodVisitor.visitAsync();
+  } else {
+    mLodVisitor.visit();
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -391,6 +439,7 @@ glm::ivec4 VistaPlanet::getViewport() {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void VistaPlanet::setEquatorialRadius(float radius) {
+  mLodVisitor.wait();
   mParams.mEquatorialRadius = radius;
 
   mFlags |= sFlagTileBoundsInvalid;
@@ -405,6 +454,7 @@ double VistaPlanet::getEquatorialRadius() const {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void VistaPlanet::setPolarRadius(float radius) {
+  mLodVisitor.wait();
   mParams.mPolarRadius = radius;
 
   mFlags |= sFlagTileBoundsInvalid;
@@ -419,6 +469,7 @@ double VistaPlanet::getPolarRadius() const {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void VistaPlanet::setHeightScale(float scale) {
+  mLodVisitor.wait();
   mParams.mHeightScale = scale;
 
   mFlags |= sFlagTileBoundsInvalid;
@@ -433,6 +484,7 @@ double VistaPlanet::getHeightScale() const {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void VistaPlanet::setLODFactor(float lodFactor) {
+  mLodVisitor.wait();
   mParams.mLodFactor = lodFactor;
 }
 
@@ -445,6 +497,7 @@ double VistaPlanet::getLODFactor() const {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void VistaPlanet::setMinLevel(int minLevel) {
+  mLodVisitor.wait();
   mParams.mMinLevel = minLevel;
 }
 
@@ -456,6 +509,44 @@ int VistaPlanet::getMinLevel() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void VistaPlanet::setParallelTraversal(bool enable) {
+  mLodVisitor.setParallel(enable);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool VistaPlanet::getParallelTraversal() const {
+  return mLodVisitor.getParallel();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void VistaPlanet::setMemoryCacheSize(uint64_t bytes) {
+  mTreeMgrDEM.getMemoryCache().setMaxSize(bytes);
+  mTreeMgrIMG.getMemoryCache().setMaxSize(bytes);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint64_t VistaPlanet::getMemoryCacheSize() const {
+  return mTreeMgrDEM.getMemoryCache().getMaxSize();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void VistaPlanet::setPipelinedTraversal(bool enable) {
+  mLodVisitor.wait();
+  mPipelinedTraversal = enable;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool VistaPlanet::getPipelinedTraversal() const {
+  return mPipelinedTraversal;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 TileRenderer& VistaPlanet::getTileRenderer() {
   return mRenderer;
 }
@@ -106,6 +106,29 @@ class VistaPlanet : public IVistaOpenGLDraw, public cs::graphics::ShadowCaster {
   void setMinLevel(int minLevel);
   int  getMinLevel() const;
 
+  /// If enabled, the tile quad trees of the base patches are traversed in parallel. See
+  /// LODVisitor::setParallel() for details.
+  void setParallelTraversal(bool enable);
+  bool getParallelTraversal() const;
+
+  /// If enabled, the tiles for the next frame are selected on a background thread while the
+  /// current frame is being drawn. For this, the tile quad trees are updated and the traversal is
+  /// started right after the tiles have been rendered. This takes the traversal off the render
+  /// thread at the cost of one frame of latency for level-of-detail changes: The tiles are culled
+  /// against the view frustum of the previous frame, so during fast camera rotations, tiles at the
+  /// edges of the screen may be missing for one frame.
+  /// This has no effect while shadows are enabled. The shadow pass waits for the background
+  /// traversal and selects the tiles again synchronously, so the trees are traversed synchronously
+  /// in doFrame() as well.
+  void setPipelinedTraversal(bool enable);
+  bool getPipelinedTraversal() const;
+
+  /// Sets the maximum size in bytes of the compressed tiles which are kept in memory after they
+  /// have been pruned from the tile quad trees. This applies to elevation and image data
+  /// separately. Zero disables the caching.
+  void     setMemoryCacheSize(uint64_t bytes);
+  uint64_t getMemoryCacheSize() const;
+
   /// Returns the TileRenderer instance used to render this VistaPlanet.
   TileRenderer&       getTileRenderer();
   TileRenderer const& getTileRenderer() const;
@@ -120,7 +143,7 @@ class VistaPlanet : public IVistaOpenGLDraw, public cs::graphics::ShadowCaster {
   void updateTileBounds();
   void updateTileTrees(int frameCount);
   void traverseTileTrees(int frameCount, glm::dmat4 const& matVM, glm::fmat4x4 const& matP,
-      glm::ivec4 const& viewport);
+      glm::ivec4 const& viewport, bool async);
   void processLoadRequests();
   void renderTiles(int frameCount, glm::dmat4 const& matVM, glm::fmat4x4 const& matP,
       cs::graphics::ShadowMap* shadowMap);
@@ -154,6 +177,7 @@ class VistaPlanet : public IVistaOpenGLDraw, public cs::graphics::ShadowCaster {
   std::size_t mMaxLoadTiles;
 
   glm::uint8 mFlags;
+  bool       mPipelinedTraversal;
 };
 } // namespace csp::lodbodies
 #endif // CSP_LOD_BODIES_VISTAPLANET_HPP
@@ -17,8 +17,401 @@
 
 #include <glm/gtx/quaternion.hpp>
 
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <unordered_map>
+
 namespace csp::lodbodies::utils {
 
+namespace {
+
+// A height query which has been transformed into the coordinates of the currently visited tile.
+struct HeightQuery {
+  glm::dvec2  mRelative; // Relative Coordinates in the tile, x and y are in [0, 1].
+  std::size_t mIndex;    // Index of the query in lngLats and heights.
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Bilinearly interpolates the heights of the given queries in the given tile data. The queries are
+// processed in small batches with separate loops for the texel coordinates, the gathering of the
+// texels and the interpolation. None of these loops contains a branch, so that the compiler can
+// vectorize the arithmetic. Queries on the far edges of the tile are interpolated within the last
+// row or column of texels instead of reading beyond the tile.
+template <typename T>
+void interpolateHeights(T const* data, HeightQuery const* begin, HeightQuery const* end,
+    std::vector<double>& heights) {
+  int const sizeX = TileBase::SizeX;
+  int const sizeY = TileBase::SizeY;
+
+  std::size_t const batchSize = 16;
+
+  std::array<int, batchSize>    index{};
+  std::array<double, batchSize> uP{};
+  std::array<double, batchSize> vP{};
+  std::array<double, batchSize> h{};
+  std::array<double, batchSize> hP1{};
+  std::array<double, batchSize> hP2{};
+  std::array<double, batchSize> hPP{};
+
+  auto total = static_cast<std::size_t>(end - begin);
+
+  for (std::size_t first = 0; first < total; first += batchSize) {
+    std::size_t count   = std::min(batchSize, total - first);
+    auto const* queries = begin + first; // NOLINT(cppcoreguidelines-pro-bounds-*)
+
+    // Figure out flip, just like getHeight() does.
+    for (std::size_t i = 0; i < count; ++i) {
+      double u = queries[i].mRelative.y * (sizeX - 1); // NOLINT(cppcoreguidelines-pro-bounds-*)
+      double v = queries[i].mRelative.x * (sizeY - 1); // NOLINT(cppcoreguidelines-pro-bounds-*)
+
+      int uB = std::min(static_cast<int>(u), sizeX - 2);
+      int vB = std::min(static_cast<int>(v), sizeY - 2);
+
+      uP[i]    = u - uB;
+      vP[i]    = v - vB;
+      index[i] = vB + sizeY * uB;
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+      h[i]   = data[index[i]];             // NOLINT(cppcoreguidelines-pro-bounds-*)
+      hP1[i] = data[index[i] + sizeY];     // NOLINT(cppcoreguidelines-pro-bounds-*)
+      hP2[i] = data[index[i] + 1];         // NOLINT(cppcoreguidelines-pro-bounds-*)
+      hPP[i] = data[index[i] + sizeY + 1]; // NOLINT(cppcoreguidelines-pro-bounds-*)
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+      double interpol1 = (1.0 - uP[i]) * h[i] + uP[i] * hP1[i];
+      double interpol2 = (1.0 - uP[i]) * hP2[i] + uP[i] * hPP[i];
+      h[i]             = (1.0 - vP[i]) * interpol1 + vP[i] * interpol2;
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+      heights[queries[i].mIndex] = h[i]; // NOLINT(cppcoreguidelines-pro-bounds-*)
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void interpolateHeights(TileNode const* node, HeightQuery const* begin, HeightQuery const* end,
+    std::vector<double>& heights) {
+  if (node->getTileDataType() == TileDataType::eFloat32) {
+    interpolateHeights(node->getTile()->getTypedPtr<float>(), begin, end, heights);
+  } else {
+    interpolateHeights(node->getTile()->getTypedPtr<unsigned char>(), begin, end, heights);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Distributes the given queries to the children of node and interpolates all queries which can not
+// be refined any further in node itself. The queries are reordered in the process.
+void sampleNode(TileNode const* node, HeightSamplePrecision precision, HeightQuery* begin,
+    HeightQuery* end, std::vector<double>& heights, std::vector<TileId>* missingTiles) {
+
+  // Go down tree only if not coarse precision
+  if (isLeaf(*node) || precision == HeightSamplePrecision::eCoarse) {
+    interpolateHeights(node, begin, end, heights);
+    return;
+  }
+
+  // Sort the queries by quadrant, this gives the same child indices as getHeight().
+  auto* upperEnd = std::partition(begin, end, [](auto const& q) { return q.mRelative.y < 0.5; });
+  std::array<HeightQuery*, 5> bounds{begin,
+      std::partition(begin, upperEnd, [](auto const& q) { return q.mRelative.x < 0.5; }), upperEnd,
+      std::partition(upperEnd, end, [](auto const& q) { return q.mRelative.x < 0.5; }), end};
+
+  for (int childIndex = 0; childIndex < 4; ++childIndex) {
+    HeightQuery* first = bounds.at(childIndex);
+    HeightQuery* last  = bounds.at(childIndex + 1);
+
+    if (first == last) {
+      continue;
+    }
+
+    TileNode const* child = node->getChild(childIndex);
+
+    // Child is unavailable, use the coordinates in the parent.
+    if (child == nullptr) {
+      if (missingTiles) {
+        missingTiles->push_back(HEALPix::getChildTileId(node->getTileId(), childIndex));
+      }
+
+      interpolateHeights(node, first, last, heights);
+      continue;
+    }
+
+    glm::dvec2 offset(0.5 * (childIndex % 2), 0.5 * (childIndex / 2));
+
+    for (auto* q = first; q != last; ++q) { // NOLINT(cppcoreguidelines-pro-bounds-*)
+      q->mRelative = (q->mRelative - offset) * 2.0;
+    }
+
+    sampleNode(child, precision, first, last, heights, missingTiles);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Intersects a ray with the height field of one tile by traversing the MinMaxPyramid of the tile.
+// The cells of the pyramid are addressed by their level and their (x, y) index. Level 0 is the
+// finest level of the pyramid with 2x2 texels per cell, level 7 is the entire tile.
+class TileIntersection {
+ public:
+  TileIntersection(Tile<float> const& tile, double radiusE, double radiusP, double heightScale,
+      glm::dvec3 const& origin, glm::dvec3 const& direction)
+      : mTile(tile)
+      , mPyramid(*tile.getMinMaxPyramid())
+      , mRadiusE(radiusE)
+      , mRadiusP(radiusP)
+      , mHeightScale(heightScale)
+      , mOrigin(origin)
+      , mDirection(direction)
+      , mBasePatch(HEALPix::getBasePatch(tile.getTileId()))
+      , mOffsetScale(HEALPix::getPatchOffsetScale(tile.getTileId())) {
+    mVertices.reserve(256);
+  }
+
+  // Returns the distance to the closest intersection or std::numeric_limits<double>::max() if the
+  // ray misses the tile.
+  double intersect() {
+    double closest = std::numeric_limits<double>::max();
+
+    std::vector<Cell> stack;
+    stack.reserve(4 * sRootLevel);
+
+    Cell root{sRootLevel, 0, 0, 0.0};
+    if (intersectBounds(root)) {
+      stack.push_back(root);
+    }
+
+    while (!stack.empty()) {
+      Cell cell = stack.back();
+      stack.pop_back();
+
+      // Another cell has been hit in front of this one.
+      if (cell.mDistance >= closest) {
+        continue;
+      }
+
+      if (cell.mLevel == 0) {
+        closest = std::min(closest, intersectTexels(cell));
+        continue;
+      }
+
+      // Push the children which are hit by the ray so that the closest one is visited first.
+      std::array<Cell, 4> children{};
+      std::size_t         count = 0;
+
+      for (int i = 0; i < 4; ++i) {
+        Cell child{cell.mLevel - 1, 2 * cell.mX + i % 2, 2 * cell.mY + i / 2, 0.0};
+        if (intersectBounds(child) && child.mDistance < closest) {
+          children.at(count++) = child;
+        }
+      }
+
+      std::sort(children.begin(), children.begin() + count,
+          [](Cell const& a, Cell const& b) { return a.mDistance > b.mDistance; });
+      stack.insert(stack.end(), children.begin(), children.begin() + count);
+    }
+
+    return closest;
+  }
+
+ private:
+  // The level of the cell which covers the entire tile.
+  static int const sRootLevel = 7;
+
+  struct Cell {
+    int    mLevel;
+    int    mX;
+    int    mY;
+    double mDistance; // Distance along the ray to the bounding box of the cell.
+  };
+
+  struct Vertex {
+    glm::dvec3 mSurface; // Position on the ellipsoid.
+    glm::dvec3 mNormal;  // Normal of the ellipsoid.
+  };
+
+  // Returns the texel at the given position, x and y are in [0, 256].
+  double getHeight(int x, int y) const {
+    return mHeightScale * mTile.data()[x + TileBase::SizeX * y];
+  }
+
+  // Returns the point on the ellipsoid below the texel at the given position, x and y are in
+  // [0, 256]. As neighbouring cells share their outer points, the results are cached.
+  Vertex const& getVertex(int x, int y) {
+    auto it = mVertices.find(x + TileBase::SizeX * y);
+
+    if (it != mVertices.end()) {
+      return it->second;
+    }
+
+    double     cells  = TileBase::SizeX - 1;
+    glm::dvec2 lngLat = HEALPix::convertBaseXY2LngLat(mBasePatch,
+        mOffsetScale.x + mOffsetScale.z * x / cells, mOffsetScale.y + mOffsetScale.z * y / cells);
+
+    Vertex vertex;
+    vertex.mSurface = cs::utils::convert::toCartesian(lngLat, mRadiusE, mRadiusP);
+
+    // Same as cs::utils::convert::lngLatToNormal(), but without computing the position again.
+    glm::dvec3 radiiSquared(mRadiusE * mRadiusE, mRadiusP * mRadiusP, mRadiusE * mRadiusE);
+    vertex.mNormal = glm::normalize(vertex.mSurface / radiiSquared);
+
+    return mVertices.emplace(x + TileBase::SizeX * y, vertex).first->second;
+  }
+
+  // Computes the bounding box of the given cell in the same way as calcTileBounds() does for
+  // entire tiles: The corners, the edge centers and the center of the cell are placed at the
+  // minimum and maximum height of the cell. As the surface between these points is curved, the box
+  // is enlarged by the height of a circle segment spanning the diagonal of the cell. Returns false
+  // if the ray misses the box, else cell.mDistance is set to the entry distance.
+  bool intersectBounds(Cell& cell) {
+    double minHeight = mPyramid.getMin();
+    double maxHeight = mPyramid.getMax();
+
+    // The texels of a cell are only stored in the pyramid cell itself, the texels on its far edges
+    // are part of the neighbouring cells.
+    if (cell.mLevel < sRootLevel) {
+      int size = MinMaxPyramid::getLevelSize(cell.mLevel);
+      int x1   = std::min(cell.mX + 1, size - 1);
+      int y1   = std::min(cell.mY + 1, size - 1);
+
+      minHeight = std::numeric_limits<double>::max();
+      maxHeight = std::numeric_limits<double>::lowest();
+
+      for (int y = cell.mY; y <= y1; ++y) {
+        for (int x = cell.mX; x <= x1; ++x) {
+          minHeight = std::min(minHeight, static_cast<double>(mPyramid.getMin(cell.mLevel, x, y)));
+          maxHeight = std::max(maxHeight, static_cast<double>(mPyramid.getMax(cell.mLevel, x, y)));
+        }
+      }
+    }
+
+    minHeight *= mHeightScale;
+    maxHeight *= mHeightScale;
+
+    int texels = 2 << cell.mLevel;
+    int x0     = cell.mX * texels;
+    int y0     = cell.mY * texels;
+
+    glm::dvec3 bbMin(std::numeric_limits<double>::max());
+    glm::dvec3 bbMax(std::numeric_limits<double>::lowest());
+
+    for (int y = y0; y <= y0 + texels; y += texels / 2) {
+      for (int x = x0; x <= x0 + texels; x += texels / 2) {
+        Vertex const& vertex = getVertex(x, y);
+        glm::dvec3    pMin   = vertex.mSurface + minHeight * vertex.mNormal;
+        glm::dvec3    pMax   = vertex.mSurface + maxHeight * vertex.mNormal;
+
+        bbMin = glm::min(bbMin, glm::min(pMin, pMax));
+        bbMax = glm::max(bbMax, glm::max(pMin, pMax));
+      }
+    }
+
+    // Within the finest cells, the surface is made of triangles between the texels which are
+    // entirely contained in the box.
+    if (cell.mLevel > 0) {
+      double diagonal = glm::length(getVertex(x0 + texels, y0 + texels).mSurface -
+                                    getVertex(x0, y0).mSurface);
+      bbMin -= diagonal * diagonal / (8.0 * std::min(mRadiusE, mRadiusP));
+      bbMax += diagonal * diagonal / (8.0 * std::min(mRadiusE, mRadiusP));
+    }
+
+    double maxDistance{};
+    return BoundingBox<double>(bbMin, bbMax)
+        .GetIntersectionDistance(mOrigin, mDirection, true, cell.mDistance, maxDistance);
+  }
+
+  // Intersects the ray with the two triangles of each of the 2x2 texel quads of the given cell of
+  // the finest level. Returns the distance to the closest intersection or
+  // std::numeric_limits<double>::max().
+  double intersectTexels(Cell const& cell) {
+    std::array<glm::dvec3, 9> points{};
+    std::array<glm::dvec3, 9> normals{};
+
+    for (int y = 0; y < 3; ++y) {
+      for (int x = 0; x < 3; ++x) {
+        int           texelX = 2 * cell.mX + x;
+        int           texelY = 2 * cell.mY + y;
+        Vertex const& vertex = getVertex(texelX, texelY);
+
+        points.at(x + 3 * y)  = vertex.mSurface + getHeight(texelX, texelY) * vertex.mNormal;
+        normals.at(x + 3 * y) = vertex.mNormal;
+      }
+    }
+
+    double closest = std::numeric_limits<double>::max();
+
+    for (int y = 0; y < 2; ++y) {
+      for (int x = 0; x < 2; ++x) {
+        int i = x + 3 * y;
+
+        // The quads are split along the diagonal from their first to their last texel.
+        closest = std::min(closest, intersectTriangle(points.at(i), points.at(i + 1),
+                                        points.at(i + 4), normals.at(i)));
+        closest = std::min(closest, intersectTriangle(points.at(i), points.at(i + 4),
+                                        points.at(i + 3), normals.at(i)));
+      }
+    }
+
+    return closest;
+  }
+
+  // Moeller-Trumbore ray-triangle intersection. Triangles are only hit from the side the given up
+  // vector points to. Returns the distance to the intersection or
+  // std::numeric_limits<double>::max().
+  double intersectTriangle(
+      glm::dvec3 const& a, glm::dvec3 const& b, glm::dvec3 const& c, glm::dvec3 const& up) const {
+    double const miss = std::numeric_limits<double>::max();
+
+    glm::dvec3 edge1 = b - a;
+    glm::dvec3 edge2 = c - a;
+
+    // Ignore rays which approach the surface from below.
+    glm::dvec3 normal = glm::cross(edge1, edge2);
+    if (glm::dot(normal, up) * glm::dot(normal, mDirection) >= 0.0) {
+      return miss;
+    }
+
+    glm::dvec3 p   = glm::cross(mDirection, edge2);
+    double     det = glm::dot(edge1, p);
+    glm::dvec3 s   = mOrigin - a;
+    double     u   = glm::dot(s, p) / det;
+
+    if (u < 0.0 || u > 1.0) {
+      return miss;
+    }
+
+    glm::dvec3 q = glm::cross(s, edge1);
+    double     v = glm::dot(mDirection, q) / det;
+
+    if (v < 0.0 || u + v > 1.0) {
+      return miss;
+    }
+
+    double distance = glm::dot(edge2, q) / det;
+    return distance >= 0.0 ? distance : miss;
+  }
+
+  Tile<float> const&   mTile;
+  MinMaxPyramid&       mPyramid;
+  double               mRadiusE;
+  double               mRadiusP;
+  double               mHeightScale;
+  glm::dvec3           mOrigin;
+  glm::dvec3           mDirection;
+  int                  mBasePatch;
+  glm::dvec3           mOffsetScale;
+
+  std::unordered_map<int, Vertex> mVertices;
+};
+
+} // namespace
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 double getHeight(
@@ -97,6 +490,10 @@ double getHeight(
 
     // Child is unavailable and precision is "Fine"
     if (child == nullptr && precision == HeightSamplePrecision::eFine) {
+      // The traversal for the next frame may still be running in the background. It marks the nodes
+      // as used, so the trees must not be modified before it has finished.
+      planet->getLODVisitor().wait();
+
       std::vector<TileId> requested;
 
       requested.push_back(HEALPix::getChildTileId(parent->getTileId(), childIndex));
@@ -170,6 +567,74 @@ double getHeight(
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void getHeights(VistaPlanet const* planet, HeightSamplePrecision precision,
+    std::vector<glm::dvec2> const& lngLats, std::vector<double>& heights) {
+  TreeManagerBase* treeMgr = planet->getTileRenderer().getTreeManagerDEM();
+
+  // Check if TreeManagerDEM and its tree are ok
+  if (treeMgr == nullptr || treeMgr->getTree() == nullptr) {
+    heights.assign(lngLats.size(), 0.0);
+    return;
+  }
+
+  if (precision != HeightSamplePrecision::eFine) {
+    getHeights(*treeMgr->getTree(), precision, lngLats, heights);
+    return;
+  }
+
+  // See getHeight() above, requesting tiles must not overlap a pending background traversal.
+  planet->getLODVisitor().wait();
+
+  std::vector<TileId> missingTiles;
+  getHeights(*treeMgr->getTree(), precision, lngLats, heights, &missingTiles);
+
+  if (!missingTiles.empty()) {
+    treeMgr->request(missingTiles);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void getHeights(TileQuadTree const& tree, HeightSamplePrecision precision,
+    std::vector<glm::dvec2> const& lngLats, std::vector<double>& heights,
+    std::vector<TileId>* missingTiles) {
+  heights.assign(lngLats.size(), 0.0);
+
+  // Sort the queries by base patch with a counting sort.
+  std::vector<int>                                     rootIndices(lngLats.size());
+  std::array<std::size_t, TileQuadTree::sNumRoots + 1> offsets{};
+
+  for (std::size_t i = 0; i < lngLats.size(); ++i) {
+    rootIndices[i] = HEALPix::convertLngLat2Base(lngLats[i]);
+    ++offsets.at(rootIndices[i] + 1);
+  }
+
+  for (int i = 0; i < TileQuadTree::sNumRoots; ++i) {
+    offsets.at(i + 1) += offsets.at(i);
+  }
+
+  std::vector<HeightQuery> queries(lngLats.size());
+  auto                     cursors = offsets;
+
+  for (std::size_t i = 0; i < lngLats.size(); ++i) {
+    glm::dvec2 relative = HEALPix::convertBaseLngLat2XY(rootIndices[i], lngLats[i]);
+    queries[cursors.at(rootIndices[i])++] = {glm::clamp(relative, 0.0, 1.0), i};
+  }
+
+  for (int i = 0; i < TileQuadTree::sNumRoots; ++i) {
+    TileNode const* root = tree.getRoot(i);
+
+    // Heights of queries without a root stay zero.
+    if (root != nullptr && offsets.at(i) != offsets.at(i + 1)) {
+      sampleNode(root, precision, queries.data() + offsets.at(i), // NOLINT(*-pointer-arithmetic)
+          queries.data() + offsets.at(i + 1), heights,            // NOLINT(*-pointer-arithmetic)
+          missingTiles);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 bool intersectTileBounds(TileNode const* tileNode, VistaPlanet const* planet,
     glm::dvec4 const& origin, glm::dvec4 const& direction, double& minDist, double& maxDist) {
   TileBase* tile   = tileNode->getTile();
@@ -191,6 +656,28 @@ bool intersectTileBounds(TileNode const* tileNode, VistaPlanet const* planet,
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+bool intersectTile(TileNode const* tileNode, double radiusE, double radiusP, double heightScale,
+    glm::dvec3 const& origin, glm::dvec3 const& direction, double& distance) {
+  // The MinMaxPyramid is only created for float tiles.
+  if (tileNode->getTileDataType() != TileDataType::eFloat32 ||
+      tileNode->getTile()->getMinMaxPyramid() == nullptr) {
+    return false;
+  }
+
+  auto const&      tile = dynamic_cast<Tile<float> const&>(*tileNode->getTile());
+  TileIntersection intersection(tile, radiusE, radiusP, heightScale, origin, direction);
+  double           closest = intersection.intersect();
+
+  if (closest == std::numeric_limits<double>::max()) {
+    return false;
+  }
+
+  distance = closest;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 bool intersectPlanet(
     VistaPlanet const* planet, glm::dvec3 rayOrigin, glm::dvec3 rayDir, glm::dvec3& pos) {
   // Check if TreeManagerDEM is ok
@@ -206,10 +693,6 @@ bool intersectPlanet(
   // Initialize Result to Zero
   pos = glm::dvec3(0);
 
-  // Tile sizes
-  int sizeX = TileBase::SizeX;
-  int sizeY = TileBase::SizeY;
-
   // Planet transform -> Inverse -> so we are in planet space
   glm::dmat4 planet_transform = planet->getWorldTransform();
   glm::dmat4 planet_transformnv;
@@ -245,8 +728,12 @@ bool intersectPlanet(
   TileNode* parent = nullptr;
   TileNode* child  = nullptr;
 
+  // The bounds of neighbouring tiles overlap, so the first intersection is not necessarily the
+  // closest one. Tiles are processed until the next one starts behind the closest intersection.
+  double closest = std::numeric_limits<double>::max();
+
   // Process intersected tile patch priority queue:
-  while (!intersected_tiles.empty()) {
+  while (!intersected_tiles.empty() && intersected_tiles.begin()->first < closest) {
     parent = intersected_tiles.begin()->second;
     intersected_tiles.erase(intersected_tiles.begin());
 
@@ -254,145 +741,12 @@ bool intersectPlanet(
       return false;
     }
 
-    // Sample height field of cut leaf node
+    // Intersect height field of cut leaf node
     if (!isRefined(*parent)) {
-      // Get entry and exit point again:
-      double min_dist{};
-      double max_dist{};
-      intersectTileBounds(parent, planet, origin, direction, min_dist, max_dist);
-
-      // Prevent entry being behind the camera:
-      min_dist             = std::max(0.0, min_dist);
-      glm::dvec4 entry     = origin + direction * min_dist;
-      glm::dvec4 exit      = origin + direction * max_dist;
-      auto       sampleDir = (exit - entry).xyz();
-      glm::dvec3 lastSampleCartesian{};
-      glm::dvec3 sampleCartesian{};
-      glm::dvec3 lastSampleLngLatHeight{};
-      glm::dvec3 sampleLngLatHeight{};
-      double     height(0.0);
-      double     lastHeight(0.0);
-      bool       first_sample(true);
-
-      // Estimate number of sampling steps
-      //        -------------------- BboxMax
-      //        |        /\        |
-      //        |   255 /  \       |
-      //        |     /      \     |
-      //        |   /          \   |
-      //        | /     Tile     \ |
-      //        | \               /|
-      //        |   \            / |
-      //        |     \        /   |
-      //        |  255 \      /    |
-      //        |        \   /     |
-      //        |         \/       |
-      // BboxMin--------------------
-      TileBase* tile   = parent->getTile();
-      auto      tileId = tile->getTileId();
-      auto*     rdDEM  = planet->getTileRenderer().getTreeManagerDEM()->find<RenderDataDEM>(tileId);
-      auto      tile_bounds = rdDEM->getBounds();
-
-      auto max_tile_samplings = sqrt((255.0 * 255.0) + (255.0 * 255.0));
-      auto max_bbox_samplings = sqrt(
-          (max_tile_samplings * max_tile_samplings) + (max_tile_samplings * max_tile_samplings));
-
-      auto step_factor =
-          glm::length(sampleDir) / glm::length(tile_bounds.getMax() - tile_bounds.getMin());
-      auto step_nr = step_factor * max_bbox_samplings;
-
-      // Sample between entry and exit:
-      for (int step(0); step <= static_cast<int>(step_nr); ++step) {
-        lastSampleCartesian    = sampleCartesian;
-        lastSampleLngLatHeight = sampleLngLatHeight;
-        lastHeight             = height;
-
-        // Sample along ray and then convert to polar:
-        sampleCartesian = glm::dvec3(entry[0], entry[1], entry[2]) +
-                          glm::dvec3((step / step_nr) * sampleDir[0],
-                              (step / step_nr) * sampleDir[1], (step / step_nr) * sampleDir[2]);
-
-        sampleLngLatHeight = cs::utils::convert::toLngLatHeight(
-            sampleCartesian, planet->getEquatorialRadius(), planet->getPolarRadius());
-
-        // Calc correct HPix coordinate for child patch in relation to base batch
-        int        base   = HEALPix::getBasePatch(parent->getTileId());
-        auto       scale  = HEALPix::getPatchOffsetScale(parent->getTileId());
-        glm::dvec2 HPixPt = HEALPix::convertBaseLngLat2XY(base, sampleLngLatHeight.xy());
-        HPixPt            = (HPixPt - glm::dvec2(scale[0], scale[1])) / scale[2];
-
-        /* Figure out flip */
-        std::swap(HPixPt.x, HPixPt.y);
-
-        // Calc coords in texture space
-        double u = HPixPt.x * (sizeX - 1);
-        double v = HPixPt.y * (sizeY - 1);
-
-        int uB = static_cast<int>(u);
-        int vB = static_cast<int>(v);
-
-        double uP = u - uB;
-        double vP = v - vB;
-
-        double hP1{};
-        double hP2{};
-        double hPP{};
-        if (uB >= sizeX - 1 || uB < 0) {
-          continue;
-        }
-        if (vB >= sizeY - 1 || vB < 0) {
-          continue;
-        }
-
-        // Access height data
-        if (parent->getTileDataType() == TileDataType::eFloat32) {
-          const auto* ptr = parent->getTile()->getTypedPtr<float>();
-          // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-          height = ptr[vB + sizeY * uB];
-          // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-          hP1 = ptr[vB + sizeY * (uB + 1)];
-          // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-          hP2 = ptr[vB + 1 + sizeY * uB];
-          // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-          hPP = ptr[vB + 1 + sizeY * (uB + 1)];
-        } else {
-          const auto* ptr = parent->getTile()->getTypedPtr<unsigned char>();
-          // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-          height = ptr[vB + sizeY * uB];
-          // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-          hP1 = ptr[vB + sizeY * (uB + 1)];
-          // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-          hP2 = ptr[vB + 1 + sizeY * uB];
-          // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-          hPP = ptr[vB + 1 + sizeY * (uB + 1)];
-        }
-
-        double interpol1 = (1.0 - uP) * height + uP * hP1;
-        double interpol2 = (1.0 - uP) * hP2 + uP * hPP;
-        height           = (1.0 - vP) * interpol1 + vP * interpol2;
-        height *= planet->getHeightScale();
-
-        // Detect hit as soon as a sample point below the surface is found
-        if (sampleLngLatHeight.z < height) {
-          // Ignore sampling, which already starts below a patch due to exaggeration
-          if (first_sample) {
-            break;
-          }
-
-          double lastWeight = lastSampleLngLatHeight.z - lastHeight;
-          double curWeight  = height - sampleLngLatHeight.z;
-
-          double sum = lastWeight + curWeight;
-
-          lastWeight /= sum;
-          curWeight /= sum;
-
-          pos = lastSampleCartesian * (1.0 - lastWeight) + sampleCartesian * (1.0 - curWeight);
-
-          // FOUND VALID INTERSECTION!!!
-          return true;
-        }
-        first_sample = false;
+      double distance{};
+      if (intersectTile(parent, planet->getEquatorialRadius(), planet->getPolarRadius(),
+              planet->getHeightScale(), origin.xyz(), direction.xyz(), distance)) {
+        closest = std::min(closest, distance);
       }
     }
     // Parent is not a leaf in cut -> push intersected children into queue:
@@ -414,7 +768,14 @@ bool intersectPlanet(
       }
     }
   }
-  return false;
+
+  if (closest == std::numeric_limits<double>::max()) {
+    return false;
+  }
+
+  // FOUND VALID INTERSECTION!!!
+  pos = origin.xyz() + direction.xyz() * closest;
+  return true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -11,6 +11,7 @@
 #include <cmath>          // C++ Math
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
+#include <vector>
 
 class VistaTransformNode;
 class VistaOpenGLNode;
@@ -19,6 +20,8 @@ namespace csp::lodbodies {
 
 class VistaPlanet;
 class TileNode;
+class TileQuadTree;
+class TileId;
 
 /// Defines the Sample Precision
 enum class HeightSamplePrecision {
@@ -37,8 +40,44 @@ namespace utils {
 double getHeight(
     VistaPlanet const* planet, HeightSamplePrecision precision, glm::dvec2 const& lngLat);
 
+/// Retrieve the Planets Height at many lat / long positions at once. heights is resized to the
+/// size of lngLats and heights[i] receives the height at lngLats[i]. Instead of walking the tree
+/// from the root for every single position, the positions are sorted by base patch and quadrant,
+/// so that every tile is visited only once and all positions within a tile are interpolated in one
+/// go. For HeightSamplePrecision::eFine, all missing tiles are requested with a single call and
+/// the currently loaded tiles are used until they become available.
+/// @param planet    VistaPlanet to get the Heights from
+/// @param precision Defines the Height Sample Precision
+/// @param lngLats   Positions in the same format as for getHeight()
+/// @param heights   Receives the Heights at the given positions
+void getHeights(VistaPlanet const* planet, HeightSamplePrecision precision,
+    std::vector<glm::dvec2> const& lngLats, std::vector<double>& heights);
+
+/// Same as getHeights() above, but samples the given elevation tree directly. If missingTiles is
+/// given, the ids of all tiles which would be required for a finer sample but are not part of the
+/// tree are appended to it.
+void getHeights(TileQuadTree const& tree, HeightSamplePrecision precision,
+    std::vector<glm::dvec2> const& lngLats, std::vector<double>& heights,
+    std::vector<TileId>* missingTiles = nullptr);
+
+/// Intersects a ray with the height field of a single elevation tile. The tile has to contain float
+/// data and a MinMaxPyramid. The pyramid is traversed front to back, all cells whose bounding box
+/// is missed by the ray or lies behind the closest intersection found so far are skipped. Within
+/// the cells of the finest pyramid level, each quad of texels is intersected as two triangles. Hits
+/// on the back side of the surface are ignored. The ray parameters must be given in the planet
+/// coordinate system and the direction must be normalized.
+/// @param tileNode    Elevation tile to be intersected
+/// @param radiusE     Equatorial radius of the planet
+/// @param radiusP     Polar radius of the planet
+/// @param heightScale Scale factor for the heights stored in the tile
+/// @param origin      Ray position in planet space
+/// @param direction   Ray direction in planet space
+/// @param distance    Receives the distance to the closest intersection along the ray
+bool intersectTile(TileNode const* tileNode, double radiusE, double radiusP, double heightScale,
+    glm::dvec3 const& origin, glm::dvec3 const& direction, double& distance);
+
 /// Intersects a ray with the height field of a VistaPlanet. The Ray is defined by a position
-/// and orientation.
+/// and orientation. The leaf tiles along the ray are intersected with intersectTile().
 /// @param planet VistaPlanet to be intersected
 /// @param rayPos Ray position in world space
 /// @param rayDir Ray direction in world space
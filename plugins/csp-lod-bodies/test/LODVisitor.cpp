@@ -0,0 +1,292 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "../src/LODVisitor.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+#include "../src/PlanetParameters.hpp"
+#include "../src/RenderDataDEM.hpp"
+#include "../src/Tile.hpp"
+#include "../src/TileBounds.hpp"
+#include "../src/TileNode.hpp"
+#include "../src/TileSource.hpp"
+#include "../src/TileTextureArray.hpp"
+#include "../src/TreeManagerBase.hpp"
+#include "../src/logger.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+namespace csp::lodbodies {
+
+namespace {
+
+// The deepest level of the tile quad trees.
+int const maxLevel = 16;
+
+// A tile without any samples. Only the root tiles of the elevation tree need samples, as the
+// LODVisitor uses their MinMaxPyramids for horizon culling. All other tiles are only represented by
+// their bounds.
+class EmptyTile : public TileBase {
+ public:
+  EmptyTile(int level, glm::int64 patchIdx)
+      : TileBase(level, patchIdx) {
+  }
+
+  std::type_info const& getTypeId() const override {
+    return typeid(float);
+  }
+
+  TileDataType getDataType() const override {
+    return TileDataType::eFloat32;
+  }
+
+  void const* getDataPtr() const override {
+    return nullptr;
+  }
+};
+
+// A TileSource which is never asked for any tiles, it only provides the data type of the tiles.
+class NullTileSource : public TileSource {
+ public:
+  void init() override {
+  }
+
+  void fini() override {
+  }
+
+  TileDataType getDataType() const override {
+    return TileDataType::eFloat32;
+  }
+
+  TileNode* loadTile(int /*level*/, glm::int64 /*patchIdx*/) override {
+    return nullptr;
+  }
+
+  void loadTileAsync(int /*level*/, glm::int64 /*patchIdx*/, OnLoadCallback /*cb*/,
+      cs::utils::TaskHandle const& /*handle*/) override {
+  }
+
+  void reprioritizeRequests() override {
+  }
+
+  int getPendingRequests() override {
+    return 0;
+  }
+
+  bool isSame(TileSource const* other) const override {
+    return other == this;
+  }
+};
+
+// A TreeManagerBase which inserts requested tiles immediately and pretends that they have been
+// uploaded to the GPU. This allows driving the LODVisitor without an OpenGL context.
+class HeadlessTreeManager : public TreeManagerBase {
+ public:
+  HeadlessTreeManager(PlanetParameters const& params, TileSource* source)
+      : TreeManagerBase(params, std::make_shared<GLResources>(0, 0, 0)) {
+    setSource(source);
+
+    for (int i = 0; i < TileQuadTree::sNumRoots; ++i) {
+      auto tile = std::make_unique<Tile<float>>(0, i);
+      tile->setMinMaxPyramid(std::make_unique<MinMaxPyramid>(tile.get()));
+      insert(new TileNode(std::move(tile), maxLevel)); // NOLINT(cppcoreguidelines-owning-memory)
+    }
+  }
+
+  HeadlessTreeManager(HeadlessTreeManager const& other) = delete;
+  HeadlessTreeManager(HeadlessTreeManager&& other)      = delete;
+
+  HeadlessTreeManager& operator=(HeadlessTreeManager const& other) = delete;
+  HeadlessTreeManager& operator=(HeadlessTreeManager&& other) = delete;
+
+  ~HeadlessTreeManager() override {
+    clear();
+  }
+
+  // Removes unused tiles and inserts the given ones, just like update() does for loaded tiles.
+  void updateTree(std::vector<TileId> const& tileIds) {
+    prune();
+
+    for (auto const& tileId : tileIds) {
+      insert(new TileNode( // NOLINT(cppcoreguidelines-owning-memory)
+          std::make_unique<EmptyTile>(tileId.level(), tileId.patchIdx()), maxLevel));
+    }
+  }
+
+ protected:
+  RenderData* allocateRenderData(TileNode* node) override {
+    auto* rdata = new RenderDataDEM(node); // NOLINT(cppcoreguidelines-owning-memory)
+    rdata->setLastFrame(0);
+    rdata->setBounds(calcTileBounds(-500.0, 3000.0, node->getLevel(), node->getPatchIdx(),
+        mParams->mEquatorialRadius, mParams->mPolarRadius, mParams->mHeightScale));
+    return rdata;
+  }
+
+  void releaseRenderData(RenderData* rdata) override {
+    delete rdata; // NOLINT(cppcoreguidelines-owning-memory)
+  }
+
+ private:
+  void insert(TileNode* node) {
+    REQUIRE(insertNode(&mTree, node));
+    onNodeInserted(node);
+    findRData(node)->setTexLayer(0);
+  }
+};
+
+// Returns a point on the unit sphere.
+glm::dvec3 toCartesian(double lng, double lat) {
+  return glm::dvec3(std::cos(lat) * std::sin(lng), std::sin(lat), std::cos(lat) * std::cos(lng));
+}
+
+// Records the modelview matrices of an observer which approaches the planet from a distance of ten
+// radii, descends to an altitude of a few hundred meters and then flies along the surface.
+std::vector<glm::dmat4> recordCameraPath(int frames, double radius) {
+  std::vector<glm::dmat4> path;
+
+  for (int frame = 0; frame < frames; ++frame) {
+    double t        = 1.0 * frame / (frames - 1);
+    double altitude = radius * std::pow(10.0, 1.0 - 5.0 * std::min(1.0, 2.0 * t));
+    double lng      = 0.5 * t;
+    double lat      = 0.3 * std::sin(2.0 * t);
+
+    glm::dvec3 position = (radius + altitude) * toCartesian(lng, lat);
+    glm::dvec3 target   = radius * toCartesian(lng + 0.05, lat);
+
+    path.push_back(glm::lookAt(position, target, glm::dvec3(0.0, 1.0, 0.0)));
+  }
+
+  return path;
+}
+
+enum class Mode { eSerial, eParallel, eAsync };
+
+// The tiles selected by the LODVisitor in one frame.
+struct Selection {
+  std::vector<TileId> mLoadDEM;
+  std::vector<TileId> mRenderDEM;
+  std::size_t         mNodeCount{};
+};
+
+// Drives a LODVisitor along the given camera path. Requested tiles are available in the following
+// frame. Returns the tiles selected in each frame and the total time spent in the traversals.
+std::pair<std::vector<Selection>, double> drive(std::vector<glm::dmat4> const& path, Mode mode) {
+  PlanetParameters params;
+  params.mEquatorialRadius = 6378137.0;
+  params.mPolarRadius      = 6356752.0;
+  params.mLodFactor        = 15.0;
+
+  NullTileSource      source;
+  HeadlessTreeManager treeMgr(params, &source);
+  LODVisitor          visitor(params, &treeMgr);
+
+  visitor.setParallel(mode != Mode::eSerial);
+  visitor.setViewport(glm::ivec4(0, 0, 1920, 1080));
+  visitor.setProjection(glm::perspective(glm::radians(60.0), 16.0 / 9.0, 1.0, 1e9));
+
+  std::vector<Selection> selections(path.size());
+  double                 milliseconds = 0.0;
+
+  for (int frame = 0; frame < static_cast<int>(path.size()); ++frame) {
+    treeMgr.setFrameCount(frame);
+    treeMgr.updateTree(frame > 0 ? selections[frame - 1].mLoadDEM : std::vector<TileId>());
+
+    visitor.setFrameCount(frame);
+    visitor.setModelview(path[frame]);
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    if (mode == Mode::eAsync) {
+      visitor.visitAsync();
+      visitor.wait();
+    } else {
+      visitor.visit();
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    milliseconds += std::chrono::duration<double, std::milli>(end - start).count();
+
+    Selection& selection = selections[frame];
+    selection.mLoadDEM   = visitor.getLoadDEM();
+    selection.mNodeCount = treeMgr.getNodeCount();
+
+    // Reset the render data like the TileRenderer does after drawing.
+    for (auto* rd : visitor.getRenderDEM()) {
+      selection.mRenderDEM.push_back(rd->getNode()->getTileId());
+
+      auto* rdDEM = dynamic_cast<RenderDataDEM*>(rd);
+      rdDEM->resetEdgeDeltas();
+      rdDEM->resetEdgeRData();
+      rdDEM->clearFlags();
+    }
+  }
+
+  return {selections, milliseconds};
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("csp::lodbodies::LODVisitor") {
+  auto path = recordCameraPath(200, 6378137.0);
+
+  auto [serial, serialTime] = drive(path, Mode::eSerial);
+
+  // Make sure that the camera path actually requires some refinement.
+  REQUIRE_GT(serial.back().mRenderDEM.size(), TileQuadTree::sNumRoots);
+
+  SUBCASE("Parallel traversals select the same tiles as serial traversals") {
+    auto [parallel, parallelTime] = drive(path, Mode::eParallel);
+
+    for (std::size_t i = 0; i < path.size(); ++i) {
+      CHECK_EQ(parallel[i].mLoadDEM, serial[i].mLoadDEM);
+      CHECK_EQ(parallel[i].mRenderDEM, serial[i].mRenderDEM);
+      CHECK_EQ(parallel[i].mNodeCount, serial[i].mNodeCount);
+    }
+  }
+
+  SUBCASE("Asynchronous traversals select the same tiles as serial traversals") {
+    auto [asynchronous, asynchronousTime] = drive(path, Mode::eAsync);
+
+    for (std::size_t i = 0; i < path.size(); ++i) {
+      CHECK_EQ(asynchronous[i].mLoadDEM, serial[i].mLoadDEM);
+      CHECK_EQ(asynchronous[i].mRenderDEM, serial[i].mRenderDEM);
+      CHECK_EQ(asynchronous[i].mNodeCount, serial[i].mNodeCount);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("[benchmark] csp::lodbodies::LODVisitor traversal") {
+  auto path = recordCameraPath(2000, 6378137.0);
+
+  auto [serial, serialTime]     = drive(path, Mode::eSerial);
+  auto [parallel, parallelTime] = drive(path, Mode::eParallel);
+
+  std::size_t renderedTiles = 0;
+  std::size_t maxNodeCount  = 0;
+
+  for (std::size_t i = 0; i < path.size(); ++i) {
+    CHECK_EQ(parallel[i].mRenderDEM, serial[i].mRenderDEM);
+
+    renderedTiles += serial[i].mRenderDEM.size();
+    maxNodeCount = std::max(maxNodeCount, serial[i].mNodeCount);
+  }
+
+  logger().info("Traversed {} frames with {:.1f} rendered tiles on average and up to {} resident "
+                "tiles: {:.3f} ms per frame serial, {:.3f} ms per frame parallel.",
+      path.size(), 1.0 * renderedTiles / path.size(), maxNodeCount, serialTime / path.size(),
+      parallelTime / path.size());
+}
+
+} // namespace csp::lodbodies
@@ -0,0 +1,188 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "../src/MinMaxPyramid.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+#include "../src/Tile.hpp"
+#include "../src/logger.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace csp::lodbodies {
+
+namespace {
+
+// Creates a tile with random heights between -1000 and 9000.
+std::unique_ptr<Tile<float>> createTile(std::mt19937& generator) {
+  std::uniform_real_distribution<float> distribution(-1000.F, 9000.F);
+
+  auto tile = std::make_unique<Tile<float>>(0, 0);
+  for (float& sample : tile->data()) {
+    sample = distribution(generator);
+  }
+
+  return tile;
+}
+
+// Computes the minimum and maximum of the samples covered by the given cell by brute force. The
+// cells in the last row and column also cover the last sample.
+std::pair<float, float> getCellRange(Tile<float> const& tile, int level, int x, int y) {
+  int const samples = 2 << level;
+  int const size    = MinMaxPyramid::getLevelSize(level);
+
+  int const x1 = x == size - 1 ? TileBase::SizeX : (x + 1) * samples;
+  int const y1 = y == size - 1 ? TileBase::SizeY : (y + 1) * samples;
+
+  std::pair<float, float> range(
+      std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest());
+
+  for (int j = y * samples; j < y1; ++j) {
+    for (int i = x * samples; i < x1; ++i) {
+      float sample = tile.data().at(i + TileBase::SizeX * j);
+      range.first  = std::min(range.first, sample);
+      range.second = std::max(range.second, sample);
+    }
+  }
+
+  return range;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("csp::lodbodies::MinMaxPyramid") {
+  std::mt19937  generator(42);
+  auto          tile = createTile(generator);
+  MinMaxPyramid pyramid(tile.get());
+
+  SUBCASE("Each cell contains the minimum and maximum of the samples it covers") {
+    for (int level = 0; level < MinMaxPyramid::sLevels; ++level) {
+      int const size = MinMaxPyramid::getLevelSize(level);
+
+      for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+          auto range = getCellRange(*tile, level, x, y);
+          REQUIRE(pyramid.getMin(level, x, y) == range.first);
+          REQUIRE(pyramid.getMax(level, x, y) == range.second);
+        }
+      }
+    }
+  }
+
+  SUBCASE("The quadrants select a cell of the corresponding level") {
+    CHECK(pyramid.getMin({1, 1, 1}) == pyramid.getMin(4, 7, 0));
+    CHECK(pyramid.getMax({1, 1, 1}) == pyramid.getMax(4, 7, 0));
+    CHECK(pyramid.getMin({0, 1, 2}) == pyramid.getMin(4, 2, 1));
+    CHECK(pyramid.getMax({0, 1, 2}) == pyramid.getMax(4, 2, 1));
+    CHECK(pyramid.getMin({3}) == pyramid.getMin(6, 1, 1));
+    CHECK(pyramid.getMax({3, 3, 3, 3, 3, 3, 3}) == pyramid.getMax(0, 127, 127));
+    CHECK(pyramid.getMin({}) == pyramid.getMin());
+    CHECK(pyramid.getMax({}) == pyramid.getMax());
+  }
+
+  SUBCASE("The range and the average of the entire tile are computed") {
+    auto [minSample, maxSample] = std::minmax_element(tile->data().begin(), tile->data().end());
+
+    double sum = 0.0;
+    for (float sample : tile->data()) {
+      sum += sample;
+    }
+
+    CHECK(pyramid.getMin() == *minSample);
+    CHECK(pyramid.getMax() == *maxSample);
+    CHECK(pyramid.getAverage() ==
+          doctest::Approx(sum / (TileBase::SizeX * TileBase::SizeY)).epsilon(1e-6));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("csp::lodbodies::MinMaxPyramidArena") {
+  std::mt19937 generator(42);
+  auto         tile  = createTile(generator);
+  auto         arena = std::make_shared<MinMaxPyramidArena>(2);
+
+  auto first  = std::make_unique<MinMaxPyramid>(tile.get(), arena);
+  auto second = std::make_unique<MinMaxPyramid>(tile.get(), arena);
+  auto third  = std::make_unique<MinMaxPyramid>(tile.get(), arena);
+  CHECK(arena->getFreeCount() == 0);
+
+  first.reset();
+  second.reset();
+  CHECK(arena->getFreeCount() == 2);
+
+  // The arena does not keep more than its capacity.
+  third.reset();
+  CHECK(arena->getFreeCount() == 2);
+
+  // Pyramids built from recycled memory are not affected by the previous content.
+  auto other    = createTile(generator);
+  auto recycled = std::make_unique<MinMaxPyramid>(other.get(), arena);
+  CHECK(arena->getFreeCount() == 1);
+  CHECK(recycled->getMin(0, 3, 5) == getCellRange(*other, 0, 3, 5).first);
+  CHECK(recycled->getMax(2, 31, 31) == getCellRange(*other, 2, 31, 31).second);
+
+  // Moved-from pyramids do not return anything to the arena.
+  auto moved = std::make_unique<MinMaxPyramid>(std::move(*recycled));
+  recycled.reset();
+  CHECK(arena->getFreeCount() == 1);
+  moved.reset();
+  CHECK(arena->getFreeCount() == 2);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The pyramids are built like a TreeManagerBase receives elevation tiles: Many tiles are loaded
+// while older ones are pruned, so that only a limited number of pyramids is alive at any time.
+TEST_CASE("[benchmark] csp::lodbodies::MinMaxPyramid") {
+  std::mt19937 generator(42);
+
+  std::vector<std::unique_ptr<Tile<float>>> tiles;
+  for (int i = 0; i < 16; ++i) {
+    tiles.push_back(createTile(generator));
+  }
+
+  int const         tileCount  = 4096;
+  std::size_t const aliveCount = 256;
+
+  auto measure = [&](std::shared_ptr<MinMaxPyramidArena> const& arena) {
+    std::deque<std::unique_ptr<MinMaxPyramid>> alive;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (int i = 0; i < tileCount; ++i) {
+      alive.push_back(std::make_unique<MinMaxPyramid>(tiles[i % tiles.size()].get(), arena));
+
+      if (alive.size() > aliveCount) {
+        alive.pop_front();
+      }
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / tileCount;
+  };
+
+  double withoutArena = measure(nullptr);
+  double withArena    = measure(std::make_shared<MinMaxPyramidArena>());
+
+  std::size_t bytes = sizeof(MinMaxPyramid) + MinMaxPyramid::sCellCount * 2 * sizeof(float);
+
+  logger().info("Built {} MinMaxPyramids: {:.1f} us per tile without arena, {:.1f} us per tile "
+                "with arena, {} bytes per tile in a single allocation.",
+      tileCount, withoutArena, withArena, bytes);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::lodbodies
@@ -0,0 +1,317 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "../src/RenderDataLRU.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+#include "../src/HEALPix.hpp"
+#include "../src/RenderData.hpp"
+#include "../src/TileIdMap.hpp"
+#include "../src/logger.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
+namespace csp::lodbodies {
+
+namespace {
+
+// RenderData which knows its TileId without a TileNode.
+class TestRenderData : public RenderData {
+ public:
+  explicit TestRenderData(TileId const& tileId)
+      : mTileId(tileId) {
+  }
+
+  TileId mTileId;
+};
+
+// Returns the content of the list from the most recently used to the least recently used data.
+std::vector<RenderData*> toVector(RenderDataLRU const& lru) {
+  std::vector<RenderData*> result;
+  for (RenderData* rdata = lru.front(); rdata; rdata = RenderDataLRU::older(rdata)) {
+    result.push_back(rdata);
+  }
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The TileIds which are visited by the LODVisitor in each frame of the trace.
+using AccessTrace = std::vector<std::vector<TileId>>;
+
+// Records the tiles visited by a LOD traversal while the observer flies in circles above one of the
+// base patches. Tiles are refined when they are close to the observer, parents are visited before
+// their children, just like the LODVisitor does.
+AccessTrace recordTrace(int frames, int maxLevel) {
+  AccessTrace trace(frames);
+
+  for (int frame = 0; frame < frames; ++frame) {
+    double angle  = frame * 0.02;
+    double focusX = 0.5 + 0.3 * std::cos(angle);
+    double focusY = 0.5 + 0.3 * std::sin(angle);
+
+    auto visit = [&](auto&& self, TileId const& tileId, double x, double y, double size) -> void {
+      trace[frame].push_back(tileId);
+
+      double dx = x + 0.5 * size - focusX;
+      double dy = y + 0.5 * size - focusY;
+
+      if (tileId.level() < maxLevel && std::sqrt(dx * dx + dy * dy) < 3.0 * size) {
+        for (int i = 0; i < 4; ++i) {
+          self(self, HEALPix::getChildTileId(tileId, i), x + (i % 2) * 0.5 * size,
+              y + (i / 2) * 0.5 * size, 0.5 * size);
+        }
+      }
+    };
+
+    for (int root = 0; root < 12; ++root) {
+      // The observer is only above base patch 4, the other roots are visited but not refined.
+      visit(visit, TileId(0, root), root == 4 ? 0.0 : 10.0, 0.0, 1.0);
+    }
+  }
+
+  return trace;
+}
+
+// The bookkeeping used by the TreeManagerBase before: RenderData is stored in a std::unordered_map
+// and a vector of pointers to the map entries is sorted by age whenever nodes are pruned.
+class AgeStoreBookkeeping {
+ public:
+  RenderData* find(TileId const& tileId) {
+    auto it = mMap.find(tileId);
+    return it == mMap.end() ? nullptr : it->second;
+  }
+
+  void insert(TileId const& tileId, RenderData* rdata) {
+    mAgeStore.push_back(&(*mMap.emplace(tileId, rdata).first));
+  }
+
+  std::size_t prune(int frame, int maxAge) {
+    std::sort(mAgeStore.begin(), mAgeStore.end(), [frame](MapValue* lhs, MapValue* rhs) {
+      int ageLHS = lhs->second->getAge(frame);
+      int ageRHS = rhs->second->getAge(frame);
+      return ageLHS == ageRHS ? lhs->first.level() < rhs->first.level() : ageLHS < ageRHS;
+    });
+
+    std::size_t count = 0;
+
+    while (!mAgeStore.empty() && mAgeStore.back()->second->getAge(frame) > maxAge &&
+           mAgeStore.back()->first.level() > 0) {
+      TileId tileId = mAgeStore.back()->first;
+      delete mAgeStore.back()->second; // NOLINT(cppcoreguidelines-owning-memory)
+      mMap.erase(tileId);
+      mAgeStore.pop_back();
+      ++count;
+    }
+
+    return count;
+  }
+
+  std::size_t size() const {
+    return mMap.size();
+  }
+
+  void clear() {
+    for (auto& value : mMap) {
+      delete value.second; // NOLINT(cppcoreguidelines-owning-memory)
+    }
+    mMap.clear();
+    mAgeStore.clear();
+  }
+
+ private:
+  using MapValue = std::unordered_map<TileId, RenderData*>::value_type;
+
+  std::unordered_map<TileId, RenderData*> mMap;
+  std::vector<MapValue*>                  mAgeStore;
+};
+
+// The bookkeeping used by the TreeManagerBase now: RenderData is stored in a TileIdMap and linked
+// into a RenderDataLRU, so only the pruned nodes have to be visited.
+class LRUBookkeeping {
+ public:
+  RenderData* find(TileId const& tileId) {
+    RenderData** rdata = mMap.find(tileId);
+    return rdata ? *rdata : nullptr;
+  }
+
+  void insert(TileId const& tileId, RenderData* rdata) {
+    mMap.insert(tileId, rdata);
+    mLru.pushFront(rdata);
+  }
+
+  std::size_t prune(int frame, int maxAge) {
+    mPruneNodes.clear();
+
+    auto* oldest = static_cast<TestRenderData*>(mLru.back());
+
+    while (oldest && oldest->getAge(frame) > maxAge) {
+      if (oldest->mTileId.level() > 0) {
+        mPruneNodes.push_back(oldest);
+      }
+
+      oldest = static_cast<TestRenderData*>(RenderDataLRU::newer(oldest));
+    }
+
+    std::sort(mPruneNodes.begin(), mPruneNodes.end(),
+        [](TestRenderData* lhs, TestRenderData* rhs) {
+          return lhs->mTileId.level() > rhs->mTileId.level();
+        });
+
+    for (TestRenderData* rdata : mPruneNodes) {
+      mMap.erase(rdata->mTileId);
+      delete rdata; // NOLINT(cppcoreguidelines-owning-memory)
+    }
+
+    return mPruneNodes.size();
+  }
+
+  std::size_t size() const {
+    return mMap.size();
+  }
+
+  void clear() {
+    while (!mLru.empty()) {
+      delete mLru.back(); // NOLINT(cppcoreguidelines-owning-memory)
+    }
+    mMap.clear();
+  }
+
+ private:
+  TileIdMap<RenderData*>       mMap;
+  RenderDataLRU                mLru;
+  std::vector<TestRenderData*> mPruneNodes;
+};
+
+// Replays the trace and returns the number of pruned nodes and the maximum number of resident
+// nodes.
+template <typename Bookkeeping>
+std::pair<std::size_t, std::size_t> replay(AccessTrace const& trace, Bookkeeping& bookkeeping) {
+  std::size_t pruned      = 0;
+  std::size_t maxResident = 0;
+
+  for (int frame = 0; frame < static_cast<int>(trace.size()); ++frame) {
+    for (auto const& tileId : trace[frame]) {
+      RenderData* rdata = bookkeeping.find(tileId);
+
+      if (!rdata) {
+        rdata = new TestRenderData(tileId); // NOLINT(cppcoreguidelines-owning-memory)
+        rdata->setLastFrame(frame);
+        bookkeeping.insert(tileId, rdata);
+      }
+
+      rdata->setLastFrame(frame);
+    }
+
+    maxResident = std::max(maxResident, bookkeeping.size());
+    pruned += bookkeeping.prune(frame, 10);
+  }
+
+  bookkeeping.clear();
+
+  return {pruned, maxResident};
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("csp::lodbodies::RenderDataLRU") {
+  RenderDataLRU  lru;
+  TestRenderData a(TileId(0, 0));
+  TestRenderData b(TileId(0, 1));
+  TestRenderData c(TileId(0, 2));
+
+  SUBCASE("Data can be inserted at both ends and in between") {
+    lru.pushFront(&a);
+    lru.pushBack(&b);
+    lru.insertBefore(&b, &c);
+    CHECK_EQ(toVector(lru), (std::vector<RenderData*>{&a, &c, &b}));
+    CHECK_EQ(lru.size(), 3);
+    CHECK_EQ(lru.front(), &a);
+    CHECK_EQ(lru.back(), &b);
+    CHECK_EQ(RenderDataLRU::newer(&b), &c);
+    CHECK_EQ(RenderDataLRU::older(&b), nullptr);
+  }
+
+  SUBCASE("Used data is moved to the front") {
+    lru.pushFront(&a);
+    lru.pushFront(&b);
+    lru.pushFront(&c);
+    CHECK_EQ(toVector(lru), (std::vector<RenderData*>{&c, &b, &a}));
+
+    a.setLastFrame(1);
+    CHECK_EQ(toVector(lru), (std::vector<RenderData*>{&a, &c, &b}));
+
+    b.setLastFrame(2);
+    CHECK_EQ(toVector(lru), (std::vector<RenderData*>{&b, &a, &c}));
+    CHECK_EQ(lru.back(), &c);
+  }
+
+  SUBCASE("Data can be removed") {
+    lru.pushFront(&a);
+    lru.pushFront(&b);
+    lru.pushFront(&c);
+    lru.remove(&b);
+    CHECK_EQ(toVector(lru), (std::vector<RenderData*>{&c, &a}));
+
+    // Unlinked data is not moved.
+    b.setLastFrame(3);
+    CHECK_EQ(toVector(lru), (std::vector<RenderData*>{&c, &a}));
+
+    {
+      TestRenderData d(TileId(0, 3));
+      lru.pushFront(&d);
+      CHECK_EQ(lru.size(), 3);
+    }
+
+    // Destroyed data is unlinked automatically.
+    CHECK_EQ(toVector(lru), (std::vector<RenderData*>{&c, &a}));
+
+    lru.clear();
+    CHECK(lru.empty());
+    CHECK_EQ(lru.front(), nullptr);
+    CHECK_EQ(lru.back(), nullptr);
+  }
+
+  lru.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("[benchmark] csp::lodbodies::TreeManagerBase node bookkeeping") {
+  auto trace = recordTrace(1000, 18);
+
+  std::size_t accesses = 0;
+  for (auto const& frame : trace) {
+    accesses += frame.size();
+  }
+
+  auto measure = [&trace](auto& bookkeeping) {
+    auto start  = std::chrono::high_resolution_clock::now();
+    auto result = replay(trace, bookkeeping);
+    auto end    = std::chrono::high_resolution_clock::now();
+    return std::make_pair(result, std::chrono::duration<double, std::milli>(end - start).count());
+  };
+
+  AgeStoreBookkeeping ageStore;
+  LRUBookkeeping      lru;
+
+  auto [ageStoreResult, ageStoreTime] = measure(ageStore);
+  auto [lruResult, lruTime]           = measure(lru);
+
+  // Both implementations have to remove the same nodes.
+  CHECK_EQ(ageStoreResult, lruResult);
+
+  logger().info("Replayed {} frames with {} node accesses, {} pruned nodes and up to {} resident "
+                "nodes: {:.1f} ms with sorted age store, {:.1f} ms with intrusive LRU.",
+      trace.size(), accesses, lruResult.first, lruResult.second, ageStoreTime, lruTime);
+}
+
+} // namespace csp::lodbodies
@@ -0,0 +1,243 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "../src/TileDecoder.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+#include "../src/logger.hpp"
+
+#include <array>
+#include <boost/filesystem.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+
+#define STB_IMAGE_WRITE_STATIC
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image.h>
+#include <stb_image_write.h>
+
+#include <tiffio.h>
+
+namespace csp::lodbodies {
+
+namespace {
+
+std::vector<char> readFile(std::string const& fileName) {
+  std::ifstream file(fileName, std::ifstream::binary);
+  return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// Creates a single-channel float TIFF image with the given size where each pixel contains its
+// index.
+std::vector<char> createTiff(std::string const& fileName, int width, int height) {
+  auto* tiff = TIFFOpen(fileName.c_str(), "w");
+  TIFFSetField(tiff, TIFFTAG_IMAGEWIDTH, width);
+  TIFFSetField(tiff, TIFFTAG_IMAGELENGTH, height);
+  TIFFSetField(tiff, TIFFTAG_SAMPLESPERPIXEL, 1);
+  TIFFSetField(tiff, TIFFTAG_BITSPERSAMPLE, 32);
+  TIFFSetField(tiff, TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_IEEEFP);
+  TIFFSetField(tiff, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
+  TIFFSetField(tiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+  TIFFSetField(tiff, TIFFTAG_ROWSPERSTRIP, 16);
+
+  std::vector<float> row(width);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      row[x] = static_cast<float>(y * width + x);
+    }
+    TIFFWriteScanline(tiff, row.data(), y);
+  }
+
+  TIFFClose(tiff);
+
+  return readFile(fileName);
+}
+
+// Creates a RGB PNG image with the given size where the pixels contain a pattern derived from
+// their position.
+std::vector<char> createPng(int width, int height) {
+  std::vector<glm::u8vec3> pixels(width * height);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      pixels[y * width + x] = glm::u8vec3(x % 256, y % 256, (x + y) % 256);
+    }
+  }
+
+  std::vector<char> data;
+  stbi_write_png_to_func(
+      [](void* context, void* chunk, int size) {
+        auto* result = static_cast<std::vector<char>*>(context);
+        auto* begin  = static_cast<char*>(chunk);
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        result->insert(result->end(), begin, begin + size);
+      },
+      &data, width, height, 3, pixels.data(), width * 3);
+
+  return data;
+}
+
+// This is how tiles were decoded before: The data was written to a file which was then opened with
+// libtiff or stbi. TIFF scanlines were decoded one by one.
+bool decodeFromFile(std::vector<char> const& data, std::string const& fileName, bool isTiff) {
+  {
+    std::ofstream file(fileName, std::ofstream::binary);
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+  }
+
+  if (isTiff) {
+    auto  tile = std::make_unique<Tile<float>>(0, 0);
+    auto* tiff = TIFFOpen(fileName.c_str(), "r");
+    if (!tiff) {
+      return false;
+    }
+    for (int y = 0; y < TileBase::SizeY; ++y) {
+      std::array<float, TileBase::SizeX> tmp{};
+      TIFFReadScanline(tiff, tmp.data(), y);
+      std::memcpy(&tile->data()[TileBase::SizeX * y], tmp.data(), sizeof(tmp));
+    }
+    TIFFClose(tiff);
+    return true;
+  }
+
+  auto  tile = std::make_unique<Tile<glm::u8vec3>>(0, 0);
+  int   width{};
+  int   height{};
+  int   bpp{};
+  auto* pixels = stbi_load(fileName.c_str(), &width, &height, &bpp, 3);
+  if (!pixels) {
+    return false;
+  }
+  std::memcpy(tile->data().data(), pixels, 3 * width * height);
+  stbi_image_free(pixels);
+  return true;
+}
+
+} // namespace
+
+TEST_CASE("csp::lodbodies::decodeTile") {
+  auto fileName = (boost::filesystem::temp_directory_path() /
+                   boost::filesystem::unique_path("csp-lod-bodies-%%%%-%%%%.tiff"))
+                      .string();
+
+  auto tiff = createTiff(fileName, TileBase::SizeX, TileBase::SizeY);
+  auto png  = createPng(TileBase::SizeX, TileBase::SizeY);
+
+  SUBCASE("All pixels of a TIFF image are decoded") {
+    auto tile = std::make_unique<Tile<float>>(0, 0);
+    CHECK(decodeTile(tiff.data(), tiff.size(), *tile));
+    CHECK_EQ(tile->data()[0], 0.F);
+    CHECK_EQ(tile->data()[1000], 1000.F);
+    CHECK_EQ(tile->data().back(), static_cast<float>(TileBase::SizeX * TileBase::SizeY - 1));
+  }
+
+  SUBCASE("Only the selected half of a TIFF image is decoded") {
+    auto tile = std::make_unique<Tile<float>>(0, 0);
+    tile->data().fill(-1.F);
+    CHECK(decodeTile(tiff.data(), tiff.size(), *tile, CopyPixels::eAboveDiagonal));
+
+    // Row 1 is written up to column SizeX - 3, the rest is left untouched.
+    int last = 2 * TileBase::SizeX - 1;
+    CHECK_EQ(tile->data()[last - 2], static_cast<float>(last - 2));
+    CHECK_EQ(tile->data()[last - 1], -1.F);
+    CHECK_EQ(tile->data()[last], -1.F);
+
+    CHECK(decodeTile(tiff.data(), tiff.size(), *tile, CopyPixels::eBelowDiagonal));
+    CHECK_EQ(tile->data()[last - 1], -1.F);
+    CHECK_EQ(tile->data()[last], static_cast<float>(last));
+  }
+
+  SUBCASE("All pixels of a PNG image are decoded") {
+    auto tile = std::make_unique<Tile<glm::u8vec3>>(0, 0);
+    CHECK(decodeTile(png.data(), png.size(), *tile));
+    CHECK_EQ(tile->data()[TileBase::SizeX * 3 + 2], glm::u8vec3(2, 3, 5));
+  }
+
+  SUBCASE("Images with a wrong size are rejected") {
+    auto smallTiff = createTiff(fileName, 16, 16);
+    auto smallPng  = createPng(16, 16);
+
+    auto demTile = std::make_unique<Tile<float>>(0, 0);
+    auto imgTile = std::make_unique<Tile<glm::u8vec3>>(0, 0);
+    CHECK_FALSE(decodeTile(smallTiff.data(), smallTiff.size(), *demTile));
+    CHECK_FALSE(decodeTile(smallPng.data(), smallPng.size(), *imgTile));
+  }
+
+  SUBCASE("Invalid data is rejected") {
+    std::vector<char> garbage(1000, 'x');
+    auto              demTile = std::make_unique<Tile<float>>(0, 0);
+    auto              imgTile = std::make_unique<Tile<glm::uint8>>(0, 0);
+    CHECK_FALSE(decodeTile(garbage.data(), garbage.size(), *demTile));
+    CHECK_FALSE(decodeTile(garbage.data(), garbage.size(), *imgTile));
+  }
+
+  boost::filesystem::remove(fileName);
+}
+
+// Set the environment variable CSP_LOD_BODIES_SAMPLE_TILES to a directory containing *.tiff and
+// *.png tiles (for example a map cache directory of an older version of CosmoScout VR) in order to
+// run this benchmark with real data. Else synthetic tiles are used.
+TEST_CASE("[benchmark] csp::lodbodies::decodeTile throughput") {
+  auto directory = boost::filesystem::temp_directory_path() /
+                   boost::filesystem::unique_path("csp-lod-bodies-%%%%-%%%%");
+  boost::filesystem::create_directories(directory);
+
+  std::vector<std::vector<char>> tiffs;
+  std::vector<std::vector<char>> pngs;
+
+  char const* samples = std::getenv("CSP_LOD_BODIES_SAMPLE_TILES");
+  if (samples) {
+    for (auto const& entry : boost::filesystem::recursive_directory_iterator(samples)) {
+      if (entry.path().extension() == ".tiff") {
+        tiffs.push_back(readFile(entry.path().string()));
+      } else if (entry.path().extension() == ".png") {
+        pngs.push_back(readFile(entry.path().string()));
+      }
+    }
+  } else {
+    tiffs.resize(100, createTiff((directory / "sample.tiff").string(), 257, 257));
+    pngs.resize(100, createPng(257, 257));
+  }
+
+  auto measure = [](std::vector<std::vector<char>> const& tiles, auto&& decode) {
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < tiles.size(); ++i) {
+      CHECK(decode(tiles[i], i));
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return tiles.size() / std::chrono::duration<double>(end - start).count();
+  };
+
+  auto fromFile = [&directory](bool isTiff) {
+    return [&directory, isTiff](std::vector<char> const& data, size_t i) {
+      auto fileName = (directory / (std::to_string(i) + (isTiff ? ".tiff" : ".png"))).string();
+      return decodeFromFile(data, fileName, isTiff);
+    };
+  };
+
+  double tiffFile   = measure(tiffs, fromFile(true));
+  double tiffMemory = measure(tiffs, [](std::vector<char> const& data, size_t /*i*/) {
+    auto tile = std::make_unique<Tile<float>>(0, 0);
+    return decodeTile(data.data(), data.size(), *tile);
+  });
+
+  double pngFile   = measure(pngs, fromFile(false));
+  double pngMemory = measure(pngs, [](std::vector<char> const& data, size_t /*i*/) {
+    auto tile = std::make_unique<Tile<glm::u8vec3>>(0, 0);
+    return decodeTile(data.data(), data.size(), *tile);
+  });
+
+  logger().info("Decoded {} TIFF tiles: {:.0f} tiles/s via file, {:.0f} tiles/s from memory.",
+      tiffs.size(), tiffFile, tiffMemory);
+  logger().info("Decoded {} PNG tiles: {:.0f} tiles/s via file, {:.0f} tiles/s from memory.",
+      pngs.size(), pngFile, pngMemory);
+
+  boost::filesystem::remove_all(directory);
+}
+
+} // namespace csp::lodbodies
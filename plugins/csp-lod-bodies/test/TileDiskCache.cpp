@@ -0,0 +1,116 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "../src/TileDiskCache.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+
+#include <boost/filesystem.hpp>
+#include <fstream>
+
+namespace csp::lodbodies {
+
+TEST_CASE("csp::lodbodies::TileDiskCache") {
+  auto directory = boost::filesystem::temp_directory_path() /
+                   boost::filesystem::unique_path("csp-lod-bodies-%%%%-%%%%");
+
+  // A tile as it was stored by previous versions.
+  boost::filesystem::create_directories(directory / "3" / "5");
+  {
+    std::ofstream file((directory / "3" / "5" / "7.png").string(), std::ofstream::binary);
+    file << "legacy";
+  }
+
+  {
+    auto cache = TileDiskCache::get(directory.string(), "png");
+
+    std::vector<char> data;
+    CHECK(cache->load(TileDiskCache::makeKey(3, 5, 7), data));
+    CHECK_EQ(std::string(data.begin(), data.end()), "legacy");
+    CHECK_FALSE(boost::filesystem::exists(directory / "3"));
+
+    CHECK_FALSE(cache->load(TileDiskCache::makeKey(3, 7, 5), data));
+
+    std::vector<char> tile(1000, 'a');
+    cache->store(TileDiskCache::makeKey(3, 7, 5), tile);
+    tile.assign(500, 'b');
+    cache->store(TileDiskCache::makeKey(3, 7, 5), tile);
+
+    CHECK(cache->load(TileDiskCache::makeKey(3, 7, 5), data));
+    CHECK_EQ(data, tile);
+    CHECK_EQ(cache->getTileCount(), 2);
+
+    // Asynchronously stored tiles are available immediately.
+    cache->storeAsync(TileDiskCache::makeKey(4, 1, 2), std::vector<char>(100, 'c'));
+    CHECK(cache->load(TileDiskCache::makeKey(4, 1, 2), data));
+    CHECK_EQ(data, std::vector<char>(100, 'c'));
+
+    // Instances are shared.
+    CHECK_EQ(cache, TileDiskCache::get(directory.string(), "png"));
+  }
+
+  // The data is still there once the cache is reopened.
+  {
+    auto cache = TileDiskCache::get(directory.string(), "png");
+
+    std::vector<char> data;
+    CHECK(cache->load(TileDiskCache::makeKey(3, 7, 5), data));
+    CHECK_EQ(data, std::vector<char>(500, 'b'));
+    CHECK(cache->load(TileDiskCache::makeKey(4, 1, 2), data));
+    CHECK_EQ(data, std::vector<char>(100, 'c'));
+    CHECK_EQ(cache->getTileCount(), 3);
+  }
+
+  // Other processes can read from the cache while it is written.
+  {
+    auto          cache = TileDiskCache::get(directory.string(), "png");
+    TileDiskCache reader(directory.string(), "png", true);
+
+    CHECK(reader.isReadOnly());
+    CHECK_FALSE(cache->isReadOnly());
+
+    std::vector<char> data;
+    CHECK(reader.load(TileDiskCache::makeKey(3, 7, 5), data));
+    CHECK_EQ(data, std::vector<char>(500, 'b'));
+    CHECK_EQ(reader.getTileCount(), 3);
+
+    // Tiles stored by the writer are visible to the reader right away.
+    cache->store(TileDiskCache::makeKey(5, 1, 1), std::vector<char>(10, 'd'));
+    CHECK(reader.load(TileDiskCache::makeKey(5, 1, 1), data));
+    CHECK_EQ(data, std::vector<char>(10, 'd'));
+
+    // The reader does not modify the cache.
+    reader.store(TileDiskCache::makeKey(5, 2, 2), std::vector<char>(10, 'e'));
+    reader.storeAsync(TileDiskCache::makeKey(5, 2, 2), std::vector<char>(10, 'e'));
+    CHECK_FALSE(reader.load(TileDiskCache::makeKey(5, 2, 2), data));
+    CHECK_FALSE(cache->load(TileDiskCache::makeKey(5, 2, 2), data));
+    CHECK_EQ(cache->getTileCount(), 4);
+  }
+
+  // Old tiles are evicted once the cache grows too large, recently used ones are kept.
+  {
+    auto cache = TileDiskCache::get(directory.string(), "png");
+    cache->setMaxSize(40 * 1024 * 1024);
+
+    std::vector<char> data;
+    std::vector<char> tile(200000);
+
+    for (int i = 0; i < 1000; ++i) {
+      tile[0] = static_cast<char>(i);
+      cache->store(TileDiskCache::makeKey(10, i, i), tile);
+      cache->load(TileDiskCache::makeKey(10, 0, 0), data);
+    }
+
+    CHECK_LT(cache->getTileCount(), 1000);
+    CHECK(cache->load(TileDiskCache::makeKey(10, 0, 0), data));
+    CHECK(cache->load(TileDiskCache::makeKey(10, 999, 999), data));
+    CHECK_EQ(data[0], static_cast<char>(999));
+    CHECK_FALSE(cache->load(TileDiskCache::makeKey(10, 1, 1), data));
+  }
+
+  boost::filesystem::remove_all(directory);
+}
+
+} // namespace csp::lodbodies
@@ -0,0 +1,68 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "../src/TileIdMap.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+
+#include <random>
+#include <unordered_map>
+
+namespace csp::lodbodies {
+
+TEST_CASE("csp::lodbodies::TileIdMap") {
+  TileIdMap<int> map;
+
+  SUBCASE("Values can be inserted, found and erased") {
+    CHECK(map.empty());
+    CHECK_EQ(map.find(TileId(0, 0)), nullptr);
+
+    CHECK(map.insert(TileId(0, 0), 1));
+    CHECK(map.insert(TileId(1, 0), 2));
+    CHECK_FALSE(map.insert(TileId(0, 0), 3));
+    CHECK_EQ(map.size(), 2);
+
+    REQUIRE(map.find(TileId(0, 0)));
+    CHECK_EQ(*map.find(TileId(0, 0)), 1);
+    CHECK_EQ(*map.find(TileId(1, 0)), 2);
+    CHECK_EQ(map.find(TileId(1, 1)), nullptr);
+
+    CHECK(map.erase(TileId(0, 0)));
+    CHECK_FALSE(map.erase(TileId(0, 0)));
+    CHECK_EQ(map.find(TileId(0, 0)), nullptr);
+    CHECK_EQ(*map.find(TileId(1, 0)), 2);
+    CHECK_EQ(map.size(), 1);
+
+    map.clear();
+    CHECK(map.empty());
+    CHECK_EQ(map.find(TileId(1, 0)), nullptr);
+  }
+
+  SUBCASE("Random operations give the same results as std::unordered_map") {
+    std::unordered_map<TileId, int> reference;
+    std::mt19937                    generator(42);
+    std::uniform_int_distribution   levelDist(0, 3);
+    std::uniform_int_distribution   patchDist(0, 12 * 64 - 1);
+
+    for (int i = 0; i < 100000; ++i) {
+      TileId tileId(levelDist(generator), patchDist(generator));
+
+      if (i % 3 == 0) {
+        CHECK_EQ(map.erase(tileId), reference.erase(tileId) > 0);
+      } else {
+        CHECK_EQ(map.insert(tileId, i), reference.emplace(tileId, i).second);
+      }
+    }
+
+    CHECK_EQ(map.size(), reference.size());
+
+    for (auto const& [tileId, value] : reference) {
+      REQUIRE(map.find(tileId));
+      CHECK_EQ(*map.find(tileId), value);
+    }
+  }
+}
+
+} // namespace csp::lodbodies
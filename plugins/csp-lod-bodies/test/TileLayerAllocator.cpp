@@ -0,0 +1,317 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "../src/TileLayerAllocator.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace csp::lodbodies {
+
+namespace {
+
+// Simulates the GPU storage: Each layer contains the id of the tile stored in it or -1. This is
+// used to check that moves and resizes never lose or duplicate a tile.
+class Storage {
+ public:
+  explicit Storage(TileLayerAllocator& allocator)
+      : mAllocator(allocator) {
+  }
+
+  // Returns false if the allocator is exhausted.
+  bool add(int tile) {
+    int layer = mAllocator.allocate();
+    if (layer < 0) {
+      return false;
+    }
+
+    resize();
+    REQUIRE(mLayers.at(layer) == -1);
+    mLayers.at(layer) = tile;
+    mTiles.push_back(layer);
+    return true;
+  }
+
+  void remove(std::size_t index) {
+    int layer = mTiles.at(index);
+    mAllocator.release(layer);
+    mLayers.at(layer) = -1;
+    mTiles.erase(mTiles.begin() + static_cast<std::ptrdiff_t>(index));
+  }
+
+  std::vector<TileLayerAllocator::Move> move(int maxMoves) {
+    auto moves = mAllocator.compact(maxMoves);
+
+    for (auto const& move : moves) {
+      REQUIRE(mLayers.at(move.mFrom) != -1);
+      REQUIRE(mLayers.at(move.mTo) == -1);
+
+      std::replace(mTiles.begin(), mTiles.end(), move.mFrom, move.mTo);
+      std::swap(mLayers.at(move.mFrom), mLayers.at(move.mTo));
+    }
+
+    return moves;
+  }
+
+  bool shrink() {
+    bool shrunk = mAllocator.shrink();
+    resize();
+    return shrunk;
+  }
+
+  // Does what the TileTextureArray does in each frame without uploads.
+  void compact(int maxMoves) {
+    move(maxMoves);
+    shrink();
+  }
+
+  // Checks that the allocator and the simulated storage agree.
+  void check() const {
+    REQUIRE(mAllocator.getCapacity() <= mAllocator.getMaxLayerCount());
+    REQUIRE(mAllocator.getUsedCount() == static_cast<int>(mTiles.size()));
+
+    int used = 0;
+    for (int layer = 0; layer < mAllocator.getCapacity(); ++layer) {
+      REQUIRE(mAllocator.isUsed(layer) == (mLayers.at(layer) != -1));
+      used += mLayers.at(layer) != -1 ? 1 : 0;
+    }
+
+    REQUIRE(used == mAllocator.getUsedCount());
+  }
+
+  std::size_t size() const {
+    return mTiles.size();
+  }
+
+ private:
+  // Follows the capacity of the allocator. Dropped layers must not contain a tile.
+  void resize() {
+    for (std::size_t layer = mAllocator.getCapacity(); layer < mLayers.size(); ++layer) {
+      REQUIRE(mLayers.at(layer) == -1);
+    }
+
+    mLayers.resize(mAllocator.getCapacity(), -1);
+  }
+
+  TileLayerAllocator& mAllocator;
+  std::vector<int>    mLayers;
+  std::vector<int>    mTiles;
+};
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("csp::lodbodies::TileLayerAllocator") {
+  TileLayerAllocator allocator(8, 100);
+
+  SUBCASE("Nothing is allocated initially") {
+    CHECK(allocator.getCapacity() == 0);
+    CHECK(allocator.getUsedCount() == 0);
+    CHECK(allocator.compact(10).empty());
+    CHECK_FALSE(allocator.shrink());
+  }
+
+  SUBCASE("The capacity grows in pages") {
+    CHECK(allocator.allocate() == 0);
+    CHECK(allocator.getCapacity() == 8);
+
+    for (int i = 1; i < 8; ++i) {
+      CHECK(allocator.allocate() == i);
+    }
+    CHECK(allocator.getCapacity() == 8);
+
+    CHECK(allocator.allocate() == 8);
+    CHECK(allocator.getCapacity() == 16);
+  }
+
+  SUBCASE("The capacity grows geometrically") {
+    for (int i = 0; i < 33; ++i) {
+      allocator.allocate();
+    }
+
+    // 8 -> 16 -> 24 -> 40.
+    CHECK(allocator.getCapacity() == 40);
+  }
+
+  SUBCASE("The capacity does not exceed the maximum") {
+    for (int i = 0; i < 100; ++i) {
+      REQUIRE(allocator.allocate() == i);
+    }
+
+    CHECK(allocator.getCapacity() == 100);
+    CHECK(allocator.allocate() == -1);
+
+    allocator.release(42);
+    CHECK(allocator.allocate() == 42);
+  }
+
+  SUBCASE("Released layers are reused lowest first") {
+    for (int i = 0; i < 20; ++i) {
+      allocator.allocate();
+    }
+
+    allocator.release(13);
+    allocator.release(5);
+    allocator.release(17);
+
+    CHECK(allocator.allocate() == 5);
+    CHECK(allocator.allocate() == 13);
+    CHECK(allocator.allocate() == 17);
+    CHECK(allocator.allocate() == 20);
+  }
+
+  SUBCASE("The maximum can only be lowered below unused layers") {
+    for (int i = 0; i < 20; ++i) {
+      allocator.allocate();
+    }
+
+    CHECK(allocator.getCapacity() == 24);
+    CHECK_FALSE(allocator.setMaxLayerCount(19));
+    CHECK(allocator.setMaxLayerCount(20));
+    CHECK(allocator.getCapacity() == 20);
+    CHECK(allocator.allocate() == -1);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("csp::lodbodies::TileLayerAllocator::compact") {
+  TileLayerAllocator allocator(8, 1000);
+  Storage            storage(allocator);
+
+  SUBCASE("Empty pages at the end are released") {
+    for (int i = 0; i < 40; ++i) {
+      storage.add(i);
+    }
+    CHECK(allocator.getCapacity() == 40);
+
+    // Keep the first 10 tiles. One page is kept as headroom.
+    while (storage.size() > 10) {
+      storage.remove(storage.size() - 1);
+    }
+
+    CHECK(storage.move(100).empty());
+    CHECK(storage.shrink());
+    CHECK(allocator.getCapacity() == 24);
+    CHECK_FALSE(storage.shrink());
+  }
+
+  SUBCASE("A single unused page is kept") {
+    for (int i = 0; i < 24; ++i) {
+      storage.add(i);
+    }
+    for (int i = 0; i < 8; ++i) {
+      storage.remove(storage.size() - 1);
+    }
+
+    CHECK(storage.move(100).empty());
+    CHECK_FALSE(storage.shrink());
+    CHECK(allocator.getCapacity() == 24);
+  }
+
+  SUBCASE("Scattered layers are moved down") {
+    for (int i = 0; i < 64; ++i) {
+      storage.add(i);
+    }
+
+    // Keep every fourth tile, so that all pages are still in use.
+    for (std::size_t i = storage.size(); i-- > 0;) {
+      if (i % 4 != 0) {
+        storage.remove(i);
+      }
+    }
+
+    CHECK_FALSE(storage.shrink());
+
+    // 16 tiles fit into two pages, the tiles in the six pages beyond have to be moved.
+    auto moves = storage.move(100);
+    CHECK(moves.size() == 12);
+    for (auto const& move : moves) {
+      CHECK(move.mFrom >= 16);
+      CHECK(move.mTo < 16);
+    }
+
+    CHECK(storage.shrink());
+    CHECK(allocator.getCapacity() == 24);
+  }
+
+  SUBCASE("The number of moves is limited") {
+    for (int i = 0; i < 64; ++i) {
+      storage.add(i);
+    }
+    for (std::size_t i = storage.size(); i-- > 0;) {
+      if (i % 4 != 0) {
+        storage.remove(i);
+      }
+    }
+
+    int frames = 0;
+    while (allocator.getCapacity() > 24) {
+      storage.compact(5);
+      storage.check();
+      ++frames;
+    }
+
+    CHECK(frames == 3);
+  }
+
+  storage.check();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("csp::lodbodies::TileLayerAllocator churn") {
+  std::mt19937 generator(42);
+
+  TileLayerAllocator allocator(16, 512);
+  Storage            storage(allocator);
+  int                nextTile = 0;
+
+  // The working set grows and shrinks repeatedly while tiles are replaced continuously, similar
+  // to a camera moving towards and away from a planet.
+  for (int cycle = 0; cycle < 10; ++cycle) {
+    std::size_t const peak = std::uniform_int_distribution<std::size_t>(100, 500)(generator);
+
+    while (storage.size() < peak) {
+      REQUIRE(storage.add(nextTile++));
+
+      if (std::uniform_int_distribution<int>(0, 2)(generator) == 0) {
+        storage.remove(std::uniform_int_distribution<std::size_t>(0, storage.size() - 1)(generator));
+      }
+    }
+
+    // The storage never grows much beyond the working set.
+    CHECK(allocator.getCapacity() <= std::max<int>(16, static_cast<int>(peak) * 3 / 2 + 16));
+    storage.check();
+
+    std::size_t const low = std::uniform_int_distribution<std::size_t>(0, 50)(generator);
+
+    while (storage.size() > low) {
+      storage.remove(std::uniform_int_distribution<std::size_t>(0, storage.size() - 1)(generator));
+      storage.compact(4);
+
+      if (std::uniform_int_distribution<int>(0, 3)(generator) == 0) {
+        REQUIRE(storage.add(nextTile++));
+      }
+    }
+
+    // Once the remaining tiles are compacted, the storage shrinks to the working set.
+    for (int frame = 0; frame < 200; ++frame) {
+      storage.compact(4);
+    }
+
+    int const pages = (static_cast<int>(low) + 15) / 16;
+    CHECK(allocator.getCapacity() == std::min(512, (pages + 1) * 16));
+    storage.check();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::lodbodies
@@ -0,0 +1,294 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "../src/TileMemoryCache.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+#include "../src/MinMaxPyramid.hpp"
+#include "../src/Tile.hpp"
+#include "../src/TileNode.hpp"
+#include "../src/logger.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <future>
+#include <limits>
+#include <memory>
+#include <random>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace csp::lodbodies {
+
+namespace {
+
+// Creates an elevation tile with smooth terrain similar to real data sets. The heights are rounded
+// to centimeters, as this is roughly the precision of typical elevation data.
+std::unique_ptr<Tile<float>> createSmoothTile(int level, glm::int64 patchIdx) {
+  auto tile = std::make_unique<Tile<float>>(level, patchIdx);
+
+  for (int y = 0; y < TileBase::SizeY; ++y) {
+    for (int x = 0; x < TileBase::SizeX; ++x) {
+      float height = 2000.F * std::sin(0.02F * static_cast<float>(x + patchIdx)) *
+                         std::cos(0.03F * static_cast<float>(y)) -
+                     150.F;
+      tile->data().at(x + y * TileBase::SizeX) = std::round(height * 100.F) / 100.F;
+    }
+  }
+
+  return tile;
+}
+
+// Creates a tile of the given type with random samples.
+template <typename T>
+std::unique_ptr<Tile<T>> createRandomTile(std::mt19937& generator) {
+  std::uniform_int_distribution<int> distribution(0, 255);
+
+  auto tile = std::make_unique<Tile<T>>(3, 42);
+
+  if constexpr (std::is_same_v<T, float>) {
+    std::uniform_real_distribution<float> heights(-11000.F, 9000.F);
+    for (float& sample : tile->data()) {
+      sample = heights(generator);
+    }
+    tile->data().front() = -0.F;
+    tile->data().back()  = std::numeric_limits<float>::lowest();
+  } else if constexpr (std::is_same_v<T, glm::u8vec3>) {
+    for (auto& sample : tile->data()) {
+      sample.r = static_cast<glm::uint8>(distribution(generator));
+      sample.g = static_cast<glm::uint8>(distribution(generator));
+      sample.b = static_cast<glm::uint8>(distribution(generator));
+    }
+  } else {
+    for (auto& sample : tile->data()) {
+      sample = static_cast<T>(distribution(generator));
+    }
+  }
+
+  return tile;
+}
+
+// Compresses and decompresses the tile and checks that the result is bitwise identical.
+template <typename T>
+void checkRoundtrip(Tile<T> const& tile) {
+  auto data     = TileMemoryCache::compress(tile);
+  auto restored = TileMemoryCache::decompress(data, tile.getDataType(), tile.getTileId());
+
+  REQUIRE(restored != nullptr);
+  REQUIRE(restored->getDataType() == tile.getDataType());
+  CHECK(restored->getTileId() == tile.getTileId());
+  CHECK(std::memcmp(restored->getDataPtr(), tile.getDataPtr(),
+            TileBase::SizeX * TileBase::SizeY * sizeof(T)) == 0);
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("csp::lodbodies::TileMemoryCache::compress") {
+  std::mt19937 generator(42);
+
+  SUBCASE("Random tiles of all data types are restored exactly") {
+    checkRoundtrip(*createRandomTile<float>(generator));
+    checkRoundtrip(*createRandomTile<glm::u8vec3>(generator));
+    checkRoundtrip(*createRandomTile<glm::uint8>(generator));
+  }
+
+  SUBCASE("Smooth elevation data is restored exactly and compresses well") {
+    auto tile = createSmoothTile(5, 1234);
+    checkRoundtrip(*tile);
+
+    auto data = TileMemoryCache::compress(*tile);
+    CHECK(data.size() < TileBase::SizeX * TileBase::SizeY * sizeof(float) * 3 / 4);
+  }
+
+  SUBCASE("Constant tiles are tiny") {
+    Tile<glm::uint8> tile(0, 0);
+    std::fill(tile.data().begin(), tile.data().end(), glm::uint8(17));
+
+    checkRoundtrip(tile);
+    CHECK(TileMemoryCache::compress(tile).size() < 2 * TileBase::SizeX * TileBase::SizeY / 32);
+  }
+
+  SUBCASE("Truncated data is rejected") {
+    auto tile = createSmoothTile(5, 1234);
+    auto data = TileMemoryCache::compress(*tile);
+    data.resize(data.size() / 2);
+
+    CHECK(TileMemoryCache::decompress(data, TileDataType::eFloat32, tile->getTileId()) == nullptr);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("csp::lodbodies::TileMemoryCache") {
+  auto            arena = std::make_shared<MinMaxPyramidArena>();
+  TileMemoryCache cache(arena);
+
+  SUBCASE("Nothing is cached by default") {
+    cache.store(*createSmoothTile(2, 0), -1);
+    CHECK(cache.load(TileId(2, 0)) == nullptr);
+    CHECK(cache.getStatistics().mTileCount == 0);
+  }
+
+  cache.setMaxSize(1024 * 1024);
+
+  SUBCASE("Stored tiles can be loaded again") {
+    auto tile = createSmoothTile(2, 7);
+    cache.store(*tile, 4);
+
+    CHECK(cache.load(TileId(2, 8)) == nullptr);
+
+    std::unique_ptr<TileNode> node(cache.load(TileId(2, 7)));
+    REQUIRE(node != nullptr);
+    CHECK(node->getTileId() == TileId(2, 7));
+    CHECK(node->getChildMaxLevel() == 4);
+
+    // Elevation tiles get a MinMaxPyramid.
+    REQUIRE(node->getTile()->getMinMaxPyramid() != nullptr);
+    CHECK(node->getTile()->getMinMaxPyramid()->getMax() == MinMaxPyramid(tile.get()).getMax());
+
+    auto statistics = cache.getStatistics();
+    CHECK(statistics.mHits == 1);
+    CHECK(statistics.mMisses == 1);
+    CHECK(statistics.mTileCount == 1);
+    CHECK(statistics.mRawSize == TileBase::SizeX * TileBase::SizeY * sizeof(float));
+    CHECK(statistics.mSize < statistics.mRawSize);
+  }
+
+  SUBCASE("The least recently used tiles are dropped first") {
+    uint64_t tileSize = TileMemoryCache::compress(*createSmoothTile(1, 0)).size();
+    cache.setMaxSize(tileSize * 3 + tileSize / 2);
+
+    cache.store(*createSmoothTile(1, 0), -1);
+    cache.store(*createSmoothTile(1, 0), -1);
+    cache.store(*createSmoothTile(1, 1), -1);
+    cache.store(*createSmoothTile(1, 2), -1);
+    CHECK(cache.getStatistics().mTileCount == 3);
+
+    // Storing an existing tile again marks it as recently used.
+    cache.store(*createSmoothTile(1, 0), -1);
+    cache.store(*createSmoothTile(1, 3), -1);
+
+    CHECK(cache.getStatistics().mTileCount == 3);
+    CHECK(cache.getStatistics().mSize <= cache.getMaxSize());
+    CHECK(std::unique_ptr<TileNode>(cache.load(TileId(1, 0))) != nullptr);
+    CHECK(std::unique_ptr<TileNode>(cache.load(TileId(1, 1))) == nullptr);
+
+    cache.setMaxSize(tileSize);
+    CHECK(cache.getStatistics().mTileCount == 1);
+    CHECK(std::unique_ptr<TileNode>(cache.load(TileId(1, 0))) != nullptr);
+  }
+
+  SUBCASE("Clearing removes all tiles") {
+    cache.store(*createSmoothTile(1, 0), -1);
+    cache.clear();
+
+    CHECK(cache.load(TileId(1, 0)) == nullptr);
+    CHECK(cache.getStatistics().mTileCount == 0);
+    CHECK(cache.getStatistics().mSize == 0);
+    CHECK(cache.getStatistics().mRawSize == 0);
+  }
+
+  SUBCASE("Tiles are stored and loaded asynchronously") {
+    cache.storeAsync(createSmoothTile(3, 5), 3);
+
+    // Wait until the tile has been compressed by the workers.
+    auto start = std::chrono::steady_clock::now();
+    while (cache.getStatistics().mTileCount == 0 &&
+           std::chrono::steady_clock::now() - start < std::chrono::seconds(10)) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    std::promise<TileNode*> promise;
+    auto                    future = promise.get_future();
+
+    CHECK_FALSE(cache.loadAsync(
+        TileId(3, 6), [](TileNode* /*node*/) {}, cs::utils::TaskHandle()));
+    REQUIRE(cache.loadAsync(
+        TileId(3, 5), [&promise](TileNode* node) { promise.set_value(node); },
+        cs::utils::TaskHandle()));
+
+    std::unique_ptr<TileNode> node(future.get());
+    REQUIRE(node != nullptr);
+    CHECK(node->getTileId() == TileId(3, 5));
+    CHECK(node->getChildMaxLevel() == 3);
+  }
+
+  SUBCASE("Cancelled requests are dropped") {
+    std::atomic<bool> called{false};
+
+    {
+      TileMemoryCache other(nullptr);
+      other.setMaxSize(1024 * 1024);
+      other.store(*createSmoothTile(3, 5), 3);
+
+      cs::utils::TaskHandle handle;
+      handle.cancel();
+
+      REQUIRE(other.loadAsync(
+          TileId(3, 5), [&called](TileNode* /*node*/) { called = true; }, handle));
+      cs::utils::getSharedThreadPool().reprioritize();
+
+      // The destructor has to return although the request is never executed.
+    }
+
+    CHECK_FALSE(called);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("[benchmark] csp::lodbodies::TileMemoryCache") {
+  std::mt19937 generator(42);
+  int const    tileCount = 64;
+
+  auto measure = [&](std::vector<std::unique_ptr<TileBase>> const& tiles, char const* name) {
+    uint64_t rawSize        = 0;
+    uint64_t compressedSize = 0;
+    double   encodeTime     = 0.0;
+    double   decodeTime     = 0.0;
+
+    for (auto const& tile : tiles) {
+      auto start = std::chrono::high_resolution_clock::now();
+      auto data  = TileMemoryCache::compress(*tile);
+      auto mid   = std::chrono::high_resolution_clock::now();
+      auto copy  = TileMemoryCache::decompress(data, tile->getDataType(), tile->getTileId());
+      auto end   = std::chrono::high_resolution_clock::now();
+
+      REQUIRE(copy != nullptr);
+
+      bool isFloat = tile->getDataType() == TileDataType::eFloat32;
+      rawSize += TileBase::SizeX * TileBase::SizeY * (isFloat ? sizeof(float) : sizeof(glm::u8vec3));
+      compressedSize += data.size();
+      encodeTime += std::chrono::duration<double, std::milli>(mid - start).count();
+      decodeTime += std::chrono::duration<double, std::milli>(end - mid).count();
+    }
+
+    logger().info("Compressed {} {} tiles to {:.1f}% of their size: {:.3f} ms encoding, {:.3f} ms "
+                  "decoding per tile.",
+        tiles.size(), name, 100.0 * compressedSize / rawSize, encodeTime / tiles.size(),
+        decodeTime / tiles.size());
+  };
+
+  std::vector<std::unique_ptr<TileBase>> smooth;
+  std::vector<std::unique_ptr<TileBase>> random;
+
+  for (int i = 0; i < tileCount; ++i) {
+    smooth.push_back(createSmoothTile(8, i * 100));
+    random.push_back(createRandomTile<glm::u8vec3>(generator));
+  }
+
+  measure(smooth, "smooth elevation");
+  measure(random, "random color");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::lodbodies
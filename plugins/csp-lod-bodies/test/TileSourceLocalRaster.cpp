@@ -0,0 +1,190 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "../src/TileSourceLocalRaster.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+#include "../src/HEALPix.hpp"
+#include "../src/TileNode.hpp"
+
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include <cmath>
+#include <future>
+#include <memory>
+#include <vector>
+
+#include <tiffio.h>
+
+namespace csp::lodbodies {
+
+namespace {
+
+// Writes a global single-channel float raster with 0.5 degree resolution where each pixel contains
+// ten times its latitude. The raster is stored in strips and has no georeferencing.
+void createElevationRaster(std::string const& fileName) {
+  uint32_t const width  = 720;
+  uint32_t const height = 360;
+
+  auto* tiff = TIFFOpen(fileName.c_str(), "w");
+  TIFFSetField(tiff, TIFFTAG_IMAGEWIDTH, width);
+  TIFFSetField(tiff, TIFFTAG_IMAGELENGTH, height);
+  TIFFSetField(tiff, TIFFTAG_SAMPLESPERPIXEL, 1);
+  TIFFSetField(tiff, TIFFTAG_BITSPERSAMPLE, 32);
+  TIFFSetField(tiff, TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_IEEEFP);
+  TIFFSetField(tiff, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
+  TIFFSetField(tiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+  TIFFSetField(tiff, TIFFTAG_ROWSPERSTRIP, 8);
+
+  std::vector<float> row(width);
+  for (uint32_t y = 0; y < height; ++y) {
+    float lat = 90.F - (static_cast<float>(y) + 0.5F) * 0.5F;
+    std::fill(row.begin(), row.end(), lat * 10.F);
+    TIFFWriteScanline(tiff, row.data(), y);
+  }
+
+  TIFFClose(tiff);
+}
+
+// Writes a tiled single-channel 8 bit image with the given resolution and value.
+void writeTiledImage(TIFF* tiff, uint32_t width, uint32_t height, uint8_t value, bool overview) {
+  uint32_t const tileSize = 256;
+
+  TIFFSetField(tiff, TIFFTAG_SUBFILETYPE, overview ? FILETYPE_REDUCEDIMAGE : 0);
+  TIFFSetField(tiff, TIFFTAG_IMAGEWIDTH, width);
+  TIFFSetField(tiff, TIFFTAG_IMAGELENGTH, height);
+  TIFFSetField(tiff, TIFFTAG_SAMPLESPERPIXEL, 1);
+  TIFFSetField(tiff, TIFFTAG_BITSPERSAMPLE, 8);
+  TIFFSetField(tiff, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
+  TIFFSetField(tiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+  TIFFSetField(tiff, TIFFTAG_TILEWIDTH, tileSize);
+  TIFFSetField(tiff, TIFFTAG_TILELENGTH, tileSize);
+
+  std::vector<uint8_t> tile(tileSize * tileSize, value);
+  for (uint32_t y = 0; y < height; y += tileSize) {
+    for (uint32_t x = 0; x < width; x += tileSize) {
+      TIFFWriteTile(tiff, tile.data(), x, y, 0, 0);
+    }
+  }
+
+  TIFFWriteDirectory(tiff);
+}
+
+// Writes a global tiled image with 0.1 degree resolution and an overview with 0.2 degree
+// resolution. All pixels of the full-resolution image have the value 100, all pixels of the
+// overview have the value 200.
+void createImageRaster(std::string const& fileName) {
+  auto* tiff = TIFFOpen(fileName.c_str(), "w");
+  writeTiledImage(tiff, 3600, 1800, 100, false);
+  writeTiledImage(tiff, 1800, 900, 200, true);
+  TIFFClose(tiff);
+}
+
+} // namespace
+
+TEST_CASE("csp::lodbodies::TileSourceLocalRaster") {
+  auto directory = boost::filesystem::temp_directory_path() /
+                   boost::filesystem::unique_path("csp-lod-bodies-%%%%-%%%%");
+  boost::filesystem::create_directories(directory);
+
+  auto demFile = (directory / "dem.tiff").string();
+  auto imgFile = (directory / "img.tiff").string();
+  createElevationRaster(demFile);
+  createImageRaster(imgFile);
+
+  SUBCASE("Elevation tiles are resampled from the raster") {
+    TileSourceLocalRaster source;
+    source.setFile(demFile);
+    source.setDataType(TileDataType::eFloat32);
+
+    // The first child of the equatorial base patch 4.
+    TileId                    tileId(1, 16);
+    std::unique_ptr<TileNode> node(source.loadTile(tileId.level(), tileId.patchIdx()));
+    REQUIRE(node);
+    CHECK_EQ(node->getTile()->getTileId(), tileId);
+    CHECK(node->getTile()->getMinMaxPyramid());
+
+    auto const*  tile   = static_cast<Tile<float> const*>(node->getTile());
+    glm::i64vec3 baseXY = HEALPix::getBaseXY(tileId);
+    auto         nSide  = static_cast<double>(HEALPix::getNSide(tileId));
+
+    // The raster is linear in latitude, so the bilinear interpolation should be exact.
+    float maxError = 0.F;
+    for (int y = 0; y < TileBase::SizeY; ++y) {
+      for (int x = 0; x < TileBase::SizeX; ++x) {
+        auto lngLat = HEALPix::convertBaseXY2LngLat(static_cast<int>(baseXY.x),
+            (baseXY.y + x / 256.0) / nSide, (baseXY.z + y / 256.0) / nSide);
+        auto expected = static_cast<float>(glm::degrees(lngLat.y) * 10.0);
+        auto actual   = tile->data()[y * TileBase::SizeX + x];
+        maxError      = std::max(maxError, std::abs(actual - expected));
+      }
+    }
+
+    CHECK_LT(maxError, 0.01F);
+  }
+
+  SUBCASE("The warning handler of libtiff is not changed") {
+    TIFFErrorHandler previous = TIFFSetWarningHandler(nullptr);
+    TIFFSetWarningHandler(previous);
+
+    TileSourceLocalRaster source;
+    source.setFile(demFile);
+    source.setDataType(TileDataType::eFloat32);
+
+    std::unique_ptr<TileNode> node(source.loadTile(1, 16));
+    REQUIRE(node);
+    CHECK_EQ(TIFFSetWarningHandler(previous), previous);
+  }
+
+  SUBCASE("Overviews are used for coarse tiles") {
+    TileSourceLocalRaster source;
+    source.setFile(imgFile);
+    source.setDataType(TileDataType::eUInt8);
+
+    std::unique_ptr<TileNode> coarse(source.loadTile(0, 4));
+    std::unique_ptr<TileNode> fine(source.loadTile(1, 16));
+    REQUIRE(coarse);
+    REQUIRE(fine);
+
+    auto const* coarseTile = static_cast<Tile<glm::uint8> const*>(coarse->getTile());
+    auto const* fineTile   = static_cast<Tile<glm::uint8> const*>(fine->getTile());
+
+    CHECK_EQ(coarseTile->data()[0], 200);
+    CHECK_EQ(coarseTile->data()[TileBase::SizeX * TileBase::SizeY / 2], 200);
+    CHECK_EQ(fineTile->data()[0], 100);
+    CHECK_EQ(fineTile->data()[TileBase::SizeX * TileBase::SizeY / 2], 100);
+  }
+
+  SUBCASE("Tiles can be loaded asynchronously") {
+    TileSourceLocalRaster source;
+    source.setFile(imgFile);
+    source.setDataType(TileDataType::eU8Vec3);
+
+    std::promise<TileNode*> promise;
+    source.loadTileAsync(
+        0, 0,
+        [&promise](TileSource* /*source*/, int /*level*/, glm::int64 /*patchIdx*/,
+            TileNode* node) { promise.set_value(node); },
+        cs::utils::TaskHandle());
+
+    std::unique_ptr<TileNode> node(promise.get_future().get());
+    REQUIRE(node);
+
+    auto const* tile = static_cast<Tile<glm::u8vec3> const*>(node->getTile());
+    CHECK_EQ(tile->data()[0], glm::u8vec3(200));
+  }
+
+  SUBCASE("Missing files are reported") {
+    TileSourceLocalRaster source;
+    source.setFile((directory / "missing.tiff").string());
+    source.setDataType(TileDataType::eFloat32);
+
+    CHECK_EQ(source.loadTile(0, 0), nullptr);
+  }
+
+  boost::filesystem::remove_all(directory);
+}
+
+} // namespace csp::lodbodies
@@ -0,0 +1,512 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "../src/utils.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+#include "../../../src/cs-utils/convert.hpp"
+#include "../src/HEALPix.hpp"
+#include "../src/Tile.hpp"
+#include "../src/TileBounds.hpp"
+#include "../src/TileQuadTree.hpp"
+#include "../src/logger.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace csp::lodbodies {
+
+namespace {
+
+// The deepest level of the test tree.
+int const maxLevel = 3;
+
+// This base patch is refined down to maxLevel, all others only have their root tile.
+int const refinedRoot = 4;
+
+// This base patch has no root tile at all.
+int const missingRoot = 7;
+
+// The height of a tile at the given position in its base patch. It depends linearly on the
+// position, so bilinear interpolation reproduces it exactly, and it encodes the level of the tile,
+// so that the tests can check which tile has been sampled.
+double heightAt(int level, glm::dvec2 const& basePosition) {
+  return 1000.0 * level + 100.0 * basePosition.x + 10.0 * basePosition.y;
+}
+
+// Returns whether the given child of the given tile is part of the test tree. Some children are
+// left out, so that the samplers have to fall back to coarser tiles.
+bool hasChild(TileId const& tileId, int childIdx) {
+  return HEALPix::getRootIdx(tileId) == refinedRoot && tileId.level() < maxLevel &&
+         (tileId.patchIdx() + childIdx) % 3 != 0;
+}
+
+// Creates a node (and its children) which covers the square of the given size at the given offset
+// in its base patch.
+TileNode* createNode(TileId const& tileId, glm::dvec2 const& offset, double size) {
+  auto tile = std::make_unique<Tile<float>>(tileId.level(), tileId.patchIdx());
+
+  // The first texel index runs along the x axis of the base patch, the second along its y axis.
+  for (int y = 0; y < TileBase::SizeX; ++y) {
+    for (int x = 0; x < TileBase::SizeY; ++x) {
+      glm::dvec2 position(offset.x + size * x / (TileBase::SizeY - 1),
+          offset.y + size * y / (TileBase::SizeX - 1));
+      tile->data().at(x + TileBase::SizeY * y) =
+          static_cast<float>(heightAt(tileId.level(), position));
+    }
+  }
+
+  auto* node = new TileNode(std::move(tile), maxLevel); // NOLINT(cppcoreguidelines-owning-memory)
+
+  for (int childIdx = 0; childIdx < 4; ++childIdx) {
+    if (hasChild(tileId, childIdx)) {
+      glm::dvec2 childOffset = offset + 0.5 * size * glm::dvec2(childIdx % 2, childIdx / 2);
+      node->setChild(childIdx,
+          createNode(HEALPix::getChildTileId(tileId, childIdx), childOffset, 0.5 * size));
+    }
+  }
+
+  return node;
+}
+
+// Creates the test tree.
+std::unique_ptr<TileQuadTree> createTree() {
+  auto tree = std::make_unique<TileQuadTree>();
+
+  for (int i = 0; i < TileQuadTree::sNumRoots; ++i) {
+    if (i != missingRoot) {
+      tree->setRoot(i, createNode(TileId(0, i), glm::dvec2(0.0), 1.0));
+    }
+  }
+
+  return tree;
+}
+
+// Computes the expected height by looking for the deepest tile of the test tree which contains the
+// given position.
+double expectedHeight(glm::dvec2 const& lngLat, HeightSamplePrecision precision) {
+  int        root     = HEALPix::convertLngLat2Base(lngLat);
+  glm::dvec2 position = HEALPix::convertBaseLngLat2XY(root, lngLat);
+
+  if (root == missingRoot) {
+    return 0.0;
+  }
+
+  TileId     tileId(0, root);
+  glm::dvec2 offset(0.0);
+  double     size = 1.0;
+
+  while (precision != HeightSamplePrecision::eCoarse) {
+    int childIdx = (position.x >= offset.x + 0.5 * size ? 1 : 0) +
+                   (position.y >= offset.y + 0.5 * size ? 2 : 0);
+
+    if (!hasChild(tileId, childIdx)) {
+      break;
+    }
+
+    tileId = HEALPix::getChildTileId(tileId, childIdx);
+    offset += 0.5 * size * glm::dvec2(childIdx % 2, childIdx / 2);
+    size *= 0.5;
+  }
+
+  return heightAt(tileId.level(), position);
+}
+
+// Returns random positions on the whole planet, every second one lies within the refined base
+// patch.
+std::vector<glm::dvec2> createPositions(std::size_t count) {
+  std::mt19937                     generator(42);
+  std::uniform_real_distribution<> lngDist(-glm::pi<double>(), glm::pi<double>());
+  std::uniform_real_distribution<> latDist(-0.5 * glm::pi<double>(), 0.5 * glm::pi<double>());
+  std::uniform_real_distribution<> xyDist(0.0, 1.0);
+
+  std::vector<glm::dvec2> positions(count);
+
+  for (std::size_t i = 0; i < count; ++i) {
+    if (i % 2 == 0) {
+      positions[i] = glm::dvec2(lngDist(generator), latDist(generator));
+    } else {
+      positions[i] =
+          HEALPix::convertBaseXY2LngLat(refinedRoot, xyDist(generator), xyDist(generator));
+    }
+  }
+
+  return positions;
+}
+
+// The radius of the spherical planet which is used for the intersection tests.
+double const radius = 6371000.0;
+
+// The heights of the elevation tile are exaggerated by this factor.
+double const heightScale = 2.0;
+
+// The elevation tile which is used for the intersection tests. Its texels are about 400 meters
+// apart.
+TileId getDEMTileId() {
+  return TileId(6, HEALPix::getLevel(6).getPatchIdx(glm::i64vec3(refinedRoot, 20, 30)));
+}
+
+// The height of the texel (x, y) of the elevation tile. It is the sum of a function of x and a
+// function of y, so the triangles between the texels coincide with the bilinear interpolation.
+double texelHeight(int x, int y) {
+  return 500.0 * std::sin(x / 20.0) + 300.0 * std::cos(y / 13.0);
+}
+
+// Bilinearly interpolates the heights of the elevation tile at the given texel coordinates.
+double terrainHeight(glm::dvec2 const& texel) {
+  int        x = std::min(static_cast<int>(texel.x), TileBase::SizeX - 2);
+  int        y = std::min(static_cast<int>(texel.y), TileBase::SizeY - 2);
+  glm::dvec2 f = texel - glm::dvec2(x, y);
+
+  return (1.0 - f.y) * ((1.0 - f.x) * texelHeight(x, y) + f.x * texelHeight(x + 1, y)) +
+         f.y * ((1.0 - f.x) * texelHeight(x, y + 1) + f.x * texelHeight(x + 1, y + 1));
+}
+
+// Creates the elevation tile including its MinMaxPyramid.
+std::unique_ptr<TileNode> createDEMNode() {
+  TileId tileId = getDEMTileId();
+  auto   tile   = std::make_unique<Tile<float>>(tileId.level(), tileId.patchIdx());
+
+  for (int y = 0; y < TileBase::SizeY; ++y) {
+    for (int x = 0; x < TileBase::SizeX; ++x) {
+      tile->data().at(x + TileBase::SizeX * y) = static_cast<float>(texelHeight(x, y));
+    }
+  }
+
+  tile->setMinMaxPyramid(std::make_unique<MinMaxPyramid>(tile.get()));
+
+  return std::make_unique<TileNode>(std::move(tile));
+}
+
+// Converts texel coordinates of the elevation tile to geodetic coordinates.
+glm::dvec2 texelToLngLat(glm::dvec2 const& texel) {
+  glm::dvec3 offsetScale = HEALPix::getPatchOffsetScale(getDEMTileId());
+  glm::dvec2 xy = glm::dvec2(offsetScale.x, offsetScale.y) + offsetScale.z * texel / 256.0;
+  return HEALPix::convertBaseXY2LngLat(refinedRoot, xy.x, xy.y);
+}
+
+// Converts geodetic coordinates to texel coordinates of the elevation tile.
+glm::dvec2 lngLatToTexel(glm::dvec2 const& lngLat) {
+  glm::dvec3 offsetScale = HEALPix::getPatchOffsetScale(getDEMTileId());
+  glm::dvec2 xy          = HEALPix::convertBaseLngLat2XY(refinedRoot, lngLat);
+  return (xy - glm::dvec2(offsetScale.x, offsetScale.y)) / offsetScale.z * 256.0;
+}
+
+// Returns the point on the terrain at the given texel coordinates.
+glm::dvec3 getTerrainPoint(glm::dvec2 const& texel, double radiusE, double radiusP) {
+  return cs::utils::convert::toCartesian(
+      texelToLngLat(texel), radiusE, radiusP, heightScale * terrainHeight(texel));
+}
+
+// This is how utils::intersectPlanet() used to intersect a single tile: The ray is sampled in
+// constant steps between its entry and exit point of the tile bounds and the intersection is
+// interpolated between the last two samples above and below the terrain. It is used as a
+// reference by the benchmark.
+bool rayMarchTile(TileNode const* node, double radiusE, double radiusP, glm::dvec3 const& origin,
+    glm::dvec3 const& direction, double& distance) {
+  auto bounds = calcTileBounds(*node->getTile(), radiusE, radiusP, heightScale);
+
+  double minDist{};
+  double maxDist{};
+  if (!bounds.GetIntersectionDistance(origin, direction, true, minDist, maxDist)) {
+    return false;
+  }
+
+  minDist = std::max(0.0, minDist);
+
+  double maxTileSamplings = std::sqrt((255.0 * 255.0) + (255.0 * 255.0));
+  double maxBoxSamplings  = std::sqrt(2.0 * maxTileSamplings * maxTileSamplings);
+  double steps            = (maxDist - minDist) / glm::length(bounds.getMax() - bounds.getMin()) *
+                 maxBoxSamplings;
+
+  auto const& data = dynamic_cast<Tile<float> const&>(*node->getTile()).data();
+  auto        at   = [&data](int x, int y) { return data.at(x + TileBase::SizeX * y); };
+
+  double lastDistance = 0.0;
+  double lastAltitude = 0.0;
+
+  for (int step = 0; step <= static_cast<int>(steps); ++step) {
+    double     sampleDistance = minDist + (maxDist - minDist) * step / steps;
+    glm::dvec3 lngLatHeight   = cs::utils::convert::toLngLatHeight(
+        origin + sampleDistance * direction, radiusE, radiusP);
+    glm::dvec2 texel = lngLatToTexel(lngLatHeight.xy());
+
+    int x = static_cast<int>(texel.x);
+    int y = static_cast<int>(texel.y);
+
+    if (x < 0 || x >= TileBase::SizeX - 1 || y < 0 || y >= TileBase::SizeY - 1) {
+      continue;
+    }
+
+    glm::dvec2 f      = texel - glm::dvec2(x, y);
+    double     height = (1.0 - f.y) * ((1.0 - f.x) * at(x, y) + f.x * at(x + 1, y)) +
+                    f.y * ((1.0 - f.x) * at(x, y + 1) + f.x * at(x + 1, y + 1));
+
+    double altitude = lngLatHeight.z - heightScale * height;
+
+    if (altitude < 0.0) {
+      if (step == 0) {
+        return false;
+      }
+
+      distance = lastDistance + (sampleDistance - lastDistance) * lastAltitude /
+                                    (lastAltitude - altitude);
+      return true;
+    }
+
+    lastDistance = sampleDistance;
+    lastAltitude = altitude;
+  }
+
+  return false;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("csp::lodbodies::utils::getHeights") {
+  auto tree      = createTree();
+  auto positions = createPositions(10000);
+
+  std::vector<double> heights;
+
+  SUBCASE("Coarse samples use the root tiles only") {
+    utils::getHeights(*tree, HeightSamplePrecision::eCoarse, positions, heights);
+
+    REQUIRE_EQ(heights.size(), positions.size());
+    for (std::size_t i = 0; i < positions.size(); ++i) {
+      double expected = expectedHeight(positions[i], HeightSamplePrecision::eCoarse);
+      CHECK_EQ(heights[i], doctest::Approx(expected));
+    }
+  }
+
+  SUBCASE("Actual samples use the deepest available tiles") {
+    utils::getHeights(*tree, HeightSamplePrecision::eActual, positions, heights);
+
+    REQUIRE_EQ(heights.size(), positions.size());
+    for (std::size_t i = 0; i < positions.size(); ++i) {
+      double expected = expectedHeight(positions[i], HeightSamplePrecision::eActual);
+      CHECK_EQ(heights[i], doctest::Approx(expected));
+    }
+  }
+
+  SUBCASE("Missing tiles are reported once for fine samples") {
+    std::vector<TileId> missingTiles;
+    utils::getHeights(*tree, HeightSamplePrecision::eFine, positions, heights, &missingTiles);
+
+    REQUIRE_FALSE(missingTiles.empty());
+
+    for (auto const& tileId : missingTiles) {
+      int childIdx = HEALPix::getChildIdxAtLevel(tileId, tileId.level());
+      CHECK_FALSE(hasChild(HEALPix::getParentTileId(tileId), childIdx));
+    }
+
+    std::sort(missingTiles.begin(), missingTiles.end(), [](TileId const& lhs, TileId const& rhs) {
+      return lhs.level() == rhs.level() ? lhs.patchIdx() < rhs.patchIdx()
+                                        : lhs.level() < rhs.level();
+    });
+    CHECK(std::unique(missingTiles.begin(), missingTiles.end()) == missingTiles.end());
+  }
+
+  SUBCASE("Batches of any size give the same results") {
+    utils::getHeights(*tree, HeightSamplePrecision::eActual, positions, heights);
+
+    std::vector<double> single;
+    for (std::size_t i = 0; i < 100; ++i) {
+      utils::getHeights(*tree, HeightSamplePrecision::eActual, {positions[i]}, single);
+      REQUIRE_EQ(single.size(), 1);
+      CHECK_EQ(single[0], heights[i]);
+    }
+
+    utils::getHeights(*tree, HeightSamplePrecision::eActual, {}, heights);
+    CHECK(heights.empty());
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("[benchmark] csp::lodbodies::utils::getHeights") {
+  auto tree = createTree();
+
+  // A dense grid of samples within the refined base patch, like the measurement tools create it.
+  int const               gridSize = 512;
+  std::vector<glm::dvec2> positions;
+
+  for (int y = 0; y < gridSize; ++y) {
+    for (int x = 0; x < gridSize; ++x) {
+      positions.push_back(HEALPix::convertBaseXY2LngLat(
+          refinedRoot, 0.2 + 0.5 * x / gridSize, 0.3 + 0.5 * y / gridSize));
+    }
+  }
+
+  std::vector<double> batched;
+  std::vector<double> single(positions.size());
+  std::vector<double> result;
+
+  auto start = std::chrono::high_resolution_clock::now();
+
+  for (std::size_t i = 0; i < positions.size(); ++i) {
+    utils::getHeights(*tree, HeightSamplePrecision::eActual, {positions[i]}, result);
+    single[i] = result[0];
+  }
+
+  auto middle = std::chrono::high_resolution_clock::now();
+
+  utils::getHeights(*tree, HeightSamplePrecision::eActual, positions, batched);
+
+  auto end = std::chrono::high_resolution_clock::now();
+
+  CHECK_EQ(batched, single);
+
+  logger().info("Sampled {} heights: {:.1f} ms with one query per call, {:.1f} ms batched.",
+      positions.size(), std::chrono::duration<double, std::milli>(middle - start).count(),
+      std::chrono::duration<double, std::milli>(end - middle).count());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("csp::lodbodies::utils::intersectTile") {
+  auto node = createDEMNode();
+
+  std::mt19937                     generator(42);
+  std::uniform_real_distribution<> texelDist(8.0, 248.0);
+  std::uniform_real_distribution<> tiltDist(-0.5, 0.5);
+
+  double distance{};
+
+  SUBCASE("Vertical rays hit the terrain right below them") {
+    for (int i = 0; i < 1000; ++i) {
+      glm::dvec2 texel(texelDist(generator), texelDist(generator));
+      glm::dvec3 normal = cs::utils::convert::lngLatToNormal(texelToLngLat(texel), radius, radius);
+      glm::dvec3 origin = getTerrainPoint(texel, radius, radius) + 10000.0 * normal;
+
+      REQUIRE(utils::intersectTile(
+          node.get(), radius, radius, heightScale, origin, -normal, distance));
+      CHECK_EQ(distance, doctest::Approx(10000.0).epsilon(1e-5));
+    }
+  }
+
+  SUBCASE("Oblique rays hit the terrain surface") {
+    for (int i = 0; i < 1000; ++i) {
+      glm::dvec2 texel(texelDist(generator), texelDist(generator));
+      glm::dvec3 normal = cs::utils::convert::lngLatToNormal(texelToLngLat(texel), radius, radius);
+      glm::dvec3 target = getTerrainPoint(texel, radius, radius);
+      glm::dvec3 direction =
+          glm::normalize(-normal + glm::dvec3(tiltDist(generator), tiltDist(generator),
+                                       tiltDist(generator)));
+      glm::dvec3 origin = target - 20000.0 * direction;
+
+      REQUIRE(utils::intersectTile(
+          node.get(), radius, radius, heightScale, origin, direction, distance));
+
+      // The ray may hit a hill in front of the target.
+      CHECK_LE(distance, 20000.0 + 0.1);
+
+      glm::dvec3 hit = cs::utils::convert::toLngLatHeight(origin + distance * direction, radius,
+          radius);
+      CHECK_LT(std::abs(hit.z - heightScale * terrainHeight(lngLatToTexel(hit.xy()))), 0.1);
+    }
+  }
+
+  SUBCASE("Rays which miss the terrain are not intersected") {
+    glm::dvec2 texel(128.0, 128.0);
+    glm::dvec3 normal  = cs::utils::convert::lngLatToNormal(texelToLngLat(texel), radius, radius);
+    glm::dvec3 tangent = glm::normalize(glm::cross(normal, glm::dvec3(0.0, 1.0, 0.0)));
+    glm::dvec3 center  = getTerrainPoint(texel, radius, radius);
+
+    // Pointing away from the terrain.
+    CHECK_FALSE(utils::intersectTile(
+        node.get(), radius, radius, heightScale, center + 1000.0 * normal, normal, distance));
+
+    // Passing the tile slightly above its highest point.
+    glm::dvec3 origin = cs::utils::convert::toCartesian(
+        texelToLngLat(texel), radius, radius, heightScale * 800.0 + 10.0);
+    CHECK_FALSE(utils::intersectTile(node.get(), radius, radius, heightScale,
+        origin - 100000.0 * tangent, tangent, distance));
+
+    // Leaving the terrain from below.
+    CHECK_FALSE(utils::intersectTile(
+        node.get(), radius, radius, heightScale, center - 100.0 * normal, normal, distance));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("[benchmark] csp::lodbodies::utils::intersectTile") {
+  auto node = createDEMNode();
+
+  double const radiusE = 6378137.0;
+  double const radiusP = 6356752.314245;
+
+  // Most rays point down at the terrain from far above, like the mouse ray usually does. Every
+  // tenth ray grazes the terrain.
+  int const               count = 10000;
+  std::vector<glm::dvec3> origins;
+  std::vector<glm::dvec3> directions;
+
+  std::mt19937                     generator(42);
+  std::uniform_real_distribution<> texelDist(8.0, 248.0);
+  std::uniform_real_distribution<> distanceDist(20000.0, 200000.0);
+  std::uniform_real_distribution<> tiltDist(-0.5, 0.5);
+
+  for (int i = 0; i < count; ++i) {
+    glm::dvec2 texel(texelDist(generator), texelDist(generator));
+    glm::dvec3 normal = cs::utils::convert::lngLatToNormal(texelToLngLat(texel), radiusE, radiusP);
+    glm::dvec3 target = getTerrainPoint(texel, radiusE, radiusP);
+    glm::dvec3 tilt(tiltDist(generator), tiltDist(generator), tiltDist(generator));
+
+    if (i % 10 == 0) {
+      directions.push_back(glm::normalize(tilt - glm::dot(tilt, normal) * normal - 0.05 * normal));
+    } else {
+      directions.push_back(glm::normalize(-normal + tilt));
+    }
+
+    origins.push_back(target - distanceDist(generator) * directions.back());
+  }
+
+  std::vector<double> marched(count, -1.0);
+  std::vector<double> traversed(count, -1.0);
+
+  auto start = std::chrono::high_resolution_clock::now();
+
+  for (int i = 0; i < count; ++i) {
+    rayMarchTile(node.get(), radiusE, radiusP, origins[i], directions[i], marched[i]);
+  }
+
+  auto middle = std::chrono::high_resolution_clock::now();
+
+  for (int i = 0; i < count; ++i) {
+    utils::intersectTile(
+        node.get(), radiusE, radiusP, heightScale, origins[i], directions[i], traversed[i]);
+  }
+
+  auto end = std::chrono::high_resolution_clock::now();
+
+  int    marchedHits   = 0;
+  int    traversedHits = 0;
+  double maxDifference = 0.0;
+
+  for (int i = 0; i < count; ++i) {
+    marchedHits += marched[i] >= 0.0 ? 1 : 0;
+    traversedHits += traversed[i] >= 0.0 ? 1 : 0;
+
+    if (marched[i] >= 0.0 && traversed[i] >= 0.0) {
+      maxDifference = std::max(maxDifference, std::abs(marched[i] - traversed[i]));
+    }
+  }
+
+  logger().info("Intersected {} rays: {:.1f} ms ({} hits) with the ray march, {:.1f} ms ({} hits) "
+                "with the MinMaxPyramid, the maximum difference is {:.2f} m.",
+      count, std::chrono::duration<double, std::milli>(middle - start).count(), marchedHits,
+      std::chrono::duration<double, std::milli>(end - middle).count(), traversedHits,
+      maxDifference);
+}
+
+} // namespace csp::lodbodies
@@ -265,18 +265,26 @@ void DipStrikeTool::calculateDipAndStrike() {
     averagePosition += mark->getAnchor()->getAnchorPosition() / static_cast<double>(mPoints.size());
   }
 
+  // LongLat coordinates of the points without height
+  std::vector<glm::dvec2> lngLats;
+  for (auto const& mark : mPoints) {
+    glm::dvec3 pos = glm::normalize(mark->getAnchor()->getAnchorPosition()) * radii[0];
+    lngLats.push_back(cs::utils::convert::toLngLatHeight(pos, radii[0], radii[0]).xy());
+  }
+
+  // Heights of the points, all of them are sampled at once
+  std::vector<double> heights(lngLats.size(), 0.0);
+  if (body) {
+    body->getHeights(lngLats, heights);
+  }
+
   // corrected average position (works for every height scale)
   // average position of the coordinates without height exaggeration
   glm::dvec3 averagePositionNorm(0.0);
-  for (auto const& mark : mPoints) {
-    // Cartesian coordinate without height
-    glm::dvec3 pos = glm::normalize(mark->getAnchor()->getAnchorPosition()) * radii[0];
-    // LongLat coordinate
-    glm::dvec3 l = cs::utils::convert::toLngLatHeight(pos, radii[0], radii[0]);
-    // Height of the point
-    double h = body ? body->getHeight(l.xy()) : 0.0;
+  for (std::size_t i = 0; i < lngLats.size(); ++i) {
     // Cartesian coordinate with height
-    glm::dvec3 posNorm = cs::utils::convert::toCartesian(l, radii[0], radii[0], h);
+    glm::dvec3 posNorm =
+        cs::utils::convert::toCartesian(lngLats[i], radii[0], radii[0], heights[i]);
 
     averagePositionNorm += posNorm / static_cast<double>(mPoints.size());
   }
@@ -303,11 +311,9 @@ void DipStrikeTool::calculateDipAndStrike() {
   mSize                 = 0;
   mOffset               = 0.F;
 
-  for (auto const& p : mPoints) {
-    glm::dvec3 pos     = glm::normalize(p->getAnchor()->getAnchorPosition()) * radii[0];
-    glm::dvec3 l       = cs::utils::convert::toLngLatHeight(pos, radii[0], radii[0]);
-    double     h       = body ? body->getHeight(l.xy()) : 0.0;
-    glm::dvec3 posNorm = cs::utils::convert::toCartesian(l, radii[0], radii[0], h);
+  for (std::size_t i = 0; i < lngLats.size(); ++i) {
+    glm::dvec3 posNorm =
+        cs::utils::convert::toCartesian(lngLats[i], radii[0], radii[0], heights[i]);
 
     glm::dvec3 realtivePosition = posNorm - averagePositionNorm;
 
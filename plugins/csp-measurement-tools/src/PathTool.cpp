@@ -174,32 +174,47 @@ void PathTool::setNumSamples(int const& numSamples) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-glm::dvec4 PathTool::getInterpolatedPosBetweenTwoMarks(cs::core::tools::DeletableMark const& l0,
-    cs::core::tools::DeletableMark const& l1, double value, double const& scale) {
+std::vector<glm::dvec4> PathTool::getInterpolatedPosBetweenTwoMarks(
+    cs::core::tools::DeletableMark const& l0, cs::core::tools::DeletableMark const& l1,
+    double const& scale) {
 
   glm::dvec3 radii = cs::core::SolarSystem::getRadii(getCenterName());
 
   auto body = mSolarSystem->getBody(getCenterName());
 
   if (!body) {
-    return glm::dvec4(0.0);
+    return std::vector<glm::dvec4>(mNumSamples, glm::dvec4(0.0));
   }
 
   // Calculate the position for the new segment anchor
-  double h0 = body->getHeight(l0.pLngLat.get()) * scale;
-  double h1 = body->getHeight(l1.pLngLat.get()) * scale;
+  std::vector<glm::dvec2> lngLats{l0.pLngLat.get(), l1.pLngLat.get()};
+  std::vector<double>     heights;
+  body->getHeights(lngLats, heights);
+
+  double h0 = heights[0] * scale;
+  double h1 = heights[1] * scale;
 
   // Get cartesian coordinates for interpolation
   glm::dvec3 p0 = cs::utils::convert::toCartesian(l0.pLngLat.get(), radii[0], radii[0], h0);
   glm::dvec3 p1 = cs::utils::convert::toCartesian(l1.pLngLat.get(), radii[0], radii[0], h1);
-  glm::dvec3 interpolatedPos = p0 + (value * (p1 - p0));
 
-  // Calc final position
-  glm::dvec2 ll     = cs::utils::convert::toLngLatHeight(interpolatedPos, radii[0], radii[0]).xy();
-  double     height = body->getHeight(ll) * scale;
-  glm::dvec3 pos    = cs::utils::convert::toCartesian(ll, radii[0], radii[0], height);
+  lngLats.resize(mNumSamples);
+  for (int i = 0; i < mNumSamples; ++i) {
+    glm::dvec3 interpolatedPos = p0 + ((i / static_cast<double>(mNumSamples)) * (p1 - p0));
+    lngLats[i] = cs::utils::convert::toLngLatHeight(interpolatedPos, radii[0], radii[0]).xy();
+  }
+
+  body->getHeights(lngLats, heights);
+
+  // Calc final positions
+  std::vector<glm::dvec4> positions(mNumSamples);
+  for (int i = 0; i < mNumSamples; ++i) {
+    double     height = heights[i] * scale;
+    glm::dvec3 pos    = cs::utils::convert::toCartesian(lngLats[i], radii[0], radii[0], height);
+    positions[i]      = glm::dvec4(pos, height);
+  }
 
-  return glm::dvec4(pos, height);
+  return positions;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -263,17 +278,18 @@ void PathTool::updateLineVertices() {
 
   while (currMark != mPoints.end()) {
     // generate X points for each line segment
+    std::vector<glm::dvec4> positions =
+        getInterpolatedPosBetweenTwoMarks(**lastMark, **currMark, h_scale);
+
+    // coordinates normalized by height scale; to count distance correctly
+    std::vector<glm::dvec4> positionsNorm =
+        h_scale != 1 ? getInterpolatedPosBetweenTwoMarks(**lastMark, **currMark, 1) : positions;
+
     for (int vertex_id = 0; vertex_id < mNumSamples; vertex_id++) {
-      glm::dvec4 pos = getInterpolatedPosBetweenTwoMarks(
-          **lastMark, **currMark, (vertex_id / static_cast<double>(mNumSamples)), h_scale);
+      glm::dvec4 const& pos = positions[vertex_id];
       mSampledPositions.push_back(pos.xyz());
 
-      // coordinate normalized by height scale; to count distance correctly
-      glm::dvec4 posNorm = pos;
-      if (h_scale != 1) {
-        posNorm = getInterpolatedPosBetweenTwoMarks(
-            **lastMark, **currMark, (vertex_id / static_cast<double>(mNumSamples)), 1);
-      }
+      glm::dvec4 const& posNorm = positionsNorm[vertex_id];
 
       if (distance < 0) {
         distance = 0;
@@ -69,10 +69,12 @@ class PathTool : public IVistaOpenGLDraw, public cs::core::tools::MultiPointTool
  private:
   void updateLineVertices();
 
-  /// Returns the interpolated position in cartesian coordinates. The fourth component is height
-  /// above the surface.
-  glm::dvec4 getInterpolatedPosBetweenTwoMarks(cs::core::tools::DeletableMark const& l0,
-      cs::core::tools::DeletableMark const& l1, double value, double const& scale);
+  /// Returns mNumSamples positions which are interpolated between the two marks in cartesian
+  /// coordinates. The fourth component is height above the surface. The heights of all positions
+  /// are sampled at once.
+  std::vector<glm::dvec4> getInterpolatedPosBetweenTwoMarks(
+      cs::core::tools::DeletableMark const& l0, cs::core::tools::DeletableMark const& l1,
+      double const& scale);
 
   /// These are called by the base class MultiPointTool.
   void onPointMoved() override;
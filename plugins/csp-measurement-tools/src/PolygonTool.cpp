@@ -659,76 +659,102 @@ bool PolygonTool::checkSleekness(int count) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void PolygonTool::displayMesh(Edge2 const& edge, double mdist, glm::dvec3 const& e,
-    glm::dvec3 const& n, glm::dvec3 const& r, double scale, double& h1, double& h2) {
-  // Cartesian coordinates without height
-  glm::dvec3 p1 =
-      glm::normalize(mMiddlePoint + mdist * edge.first.mX * e + mdist * edge.first.mY * n) * r[0];
-  glm::dvec3 p2 =
-      glm::normalize(mMiddlePoint + mdist * edge.second.mX * e + mdist * edge.second.mY * n) * r[0];
-
-  // LongLat coordinates
-  glm::dvec3 l1 = cs::utils::convert::toLngLatHeight(p1, r[0], r[0]);
-  glm::dvec3 l2 = cs::utils::convert::toLngLatHeight(p2, r[0], r[0]);
+void PolygonTool::displayMesh(std::vector<Edge2> const& edges, double mdist, glm::dvec3 const& e,
+    glm::dvec3 const& n, glm::dvec3 const& r, double scale, std::vector<double>& heights) {
+  // LongLat coordinates of both ends of all edges, their heights are sampled at once
+  std::vector<glm::dvec3> lngLatHeights;
+  std::vector<glm::dvec2> lngLats;
+  lngLatHeights.reserve(2 * edges.size());
+  lngLats.reserve(2 * edges.size());
+
+  for (auto const& edge : edges) {
+    for (Site const& si : {edge.first, edge.second}) {
+      // Cartesian coordinates without height
+      glm::dvec3 p = glm::normalize(mMiddlePoint + mdist * si.mX * e + mdist * si.mY * n) * r[0];
+      lngLatHeights.push_back(cs::utils::convert::toLngLatHeight(p, r[0], r[0]));
+      lngLats.push_back(lngLatHeights.back().xy());
+    }
+  }
 
   // Heights of the points
-  h1 = mSolarSystem->pActiveBody.get()->getHeight(l1.xy());
-  h2 = mSolarSystem->pActiveBody.get()->getHeight(l2.xy());
-
-  // Cartesian coordinates with height
-  glm::dvec3 r1 = cs::utils::convert::toCartesian(l1, r[0], r[0], h1 * scale);
-  glm::dvec3 r2 = cs::utils::convert::toCartesian(l2, r[0], r[0], h2 * scale);
+  mSolarSystem->pActiveBody.get()->getHeights(lngLats, heights);
 
   // Emplaces back points in Cartesian (on planet surface) for display
-  mTriangulation.emplace_back(r1);
-  mTriangulation.emplace_back(r2);
+  for (std::size_t i = 0; i < lngLatHeights.size(); i++) {
+    mTriangulation.emplace_back(
+        cs::utils::convert::toCartesian(lngLatHeights[i], r[0], r[0], heights[i] * scale));
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void PolygonTool::refineMesh(Edge2 const& edge, double mdist, glm::dvec3 const& e,
-    glm::dvec3 const& n, glm::dvec3 const& r, int count, double h1, double h2, bool& fine) {
+void PolygonTool::refineMesh(std::vector<Edge2> const& edges, double mdist, glm::dvec3 const& e,
+    glm::dvec3 const& n, glm::dvec3 const& r, int count, std::vector<double> const& heights,
+    bool& fine) {
 
-  // Middle point of the edge on voronoi plane
-  glm::dvec2 avgPoint2 =
-      glm::dvec2((edge.first.mX + edge.second.mX) / 2, (edge.first.mY + edge.second.mY) / 2);
-  // Middle point on planet´s surface
-  glm::dvec3 pAvg =
-      glm::normalize(mMiddlePoint + mdist * avgPoint2.x * e + mdist * avgPoint2.y * n) * r[0];
+  // Each edge is sampled at its middle point and at the points which divide it into three, four
+  // and five sections. The heights of all samples are queried at once, even though some of them
+  // are not needed if points are added to the mesh early on.
+  int const samplesPerEdge = 10;
+
+  std::vector<glm::dvec2> samples;
+  std::vector<glm::dvec2> lngLats;
+  samples.reserve(samplesPerEdge * edges.size());
+  lngLats.reserve(samplesPerEdge * edges.size());
+
+  auto addSample = [&](glm::dvec2 const& point) {
+    glm::dvec3 p =
+        glm::normalize(mMiddlePoint + mdist * point.x * e + mdist * point.y * n) * r[0];
+    samples.push_back(point);
+    lngLats.push_back(cs::utils::convert::toLngLatHeight(p, r[0], r[0]).xy());
+  };
+
+  for (auto const& edge : edges) {
+    // Middle point of the edge on voronoi plane
+    addSample(
+        glm::dvec2((edge.first.mX + edge.second.mX) / 2, (edge.first.mY + edge.second.mY) / 2));
 
-  // Heights of the points over see level
-  double hAvg = mSolarSystem->pActiveBody.get()->getHeight(
-      cs::utils::convert::toLngLatHeight(pAvg, r[0], r[0]).xy());
-
-  // Checks height of the middle point
-  if ((hAvg / ((h1 + h2) / 2) > mHeightDiff) || (((h1 + h2) / 2) / hAvg > mHeightDiff)) {
-    mCornersFine[count].emplace_back(
-        avgPoint2.x, avgPoint2.y, static_cast<uint16_t>(mCornersFine[count].size()));
-    fine = false;
-  }
-  // Checks height of other points between the two Sites
-  else {
     // Trisecting points, etc.
     for (int j = 3; j < 6; j++) {
-      // Checks "level" only if no points were emplaced back form the previous cycle
-      if (fine) {
-        for (int i = 1; i < j; i++) {
-          // Point
-          glm::dvec2 avgPoint3 = glm::dvec2((i * edge.first.mX + (j - i) * edge.second.mX) / j,
-              (i * edge.first.mY + (j - i) * edge.second.mY) / j);
-          // Cartesian coordinate of the point
-          glm::dvec3 cAvg3 =
-              glm::normalize(mMiddlePoint + mdist * avgPoint3.x * e + mdist * avgPoint3.y * n) *
-              r[0];
-          // Height of the point
-          double heAvg3 = mSolarSystem->pActiveBody.get()->getHeight(
-              cs::utils::convert::toLngLatHeight(cAvg3, r[0], r[0]).xy());
-
-          if ((heAvg3 / ((i * h1 + (j - i) * h2) / j) > mHeightDiff) ||
-              (((i * h1 + (j - i) * h2) / j) / heAvg3 > mHeightDiff)) {
-            mCornersFine[count].emplace_back(
-                avgPoint3.x, avgPoint3.y, static_cast<uint16_t>(mCornersFine[count].size()));
-            fine = false;
+      for (int i = 1; i < j; i++) {
+        addSample(glm::dvec2((i * edge.first.mX + (j - i) * edge.second.mX) / j,
+            (i * edge.first.mY + (j - i) * edge.second.mY) / j));
+      }
+    }
+  }
+
+  // Heights of the points over see level
+  std::vector<double> sampleHeights;
+  mSolarSystem->pActiveBody.get()->getHeights(lngLats, sampleHeights);
+
+  for (std::size_t k = 0; k < edges.size(); k++) {
+    double      h1    = heights[2 * k];
+    double      h2    = heights[2 * k + 1];
+    std::size_t first = k * samplesPerEdge;
+
+    // Checks height of the middle point
+    double hAvg = sampleHeights[first];
+    if ((hAvg / ((h1 + h2) / 2) > mHeightDiff) || (((h1 + h2) / 2) / hAvg > mHeightDiff)) {
+      mCornersFine[count].emplace_back(samples[first].x, samples[first].y,
+          static_cast<uint16_t>(mCornersFine[count].size()));
+      fine = false;
+    }
+    // Checks height of other points between the two Sites
+    else {
+      for (int j = 3; j < 6; j++) {
+        // Checks "level" only if no points were emplaced back form the previous cycle
+        if (fine) {
+          for (int i = 1; i < j; i++) {
+            // The samples of the j sections follow those of the j - 1 sections
+            std::size_t sample = first + (j - 1) * (j - 2) / 2 + i - 1;
+            double      heAvg3 = sampleHeights[sample];
+
+            if ((heAvg3 / ((i * h1 + (j - i) * h2) / j) > mHeightDiff) ||
+                (((i * h1 + (j - i) * h2) / j) / heAvg3 > mHeightDiff)) {
+              mCornersFine[count].emplace_back(samples[sample].x, samples[sample].y,
+                  static_cast<uint16_t>(mCornersFine[count].size()));
+              fine = false;
+            }
           }
         }
       }
@@ -741,6 +767,40 @@ void PolygonTool::refineMesh(Edge2 const& edge, double mdist, glm::dvec3 const&
 void PolygonTool::calculateAreaAndVolume(std::vector<Triangle> const& triangles, double mdist,
     glm::dvec3 const& e, glm::dvec3 const& n, glm::dvec3 const& r, double& area, double& pvol,
     double& nvol) {
+  auto body = mSolarSystem->pActiveBody.get();
+
+  // Heights of all triangle corners, they are sampled at once
+  std::vector<glm::dvec2> cornerLngLats;
+  cornerLngLats.reserve(3 * triangles.size());
+  for (const auto& triangle : triangles) {
+    for (Site const& si : {std::get<0>(triangle), std::get<1>(triangle), std::get<2>(triangle)}) {
+      glm::dvec3 p = glm::normalize(mMiddlePoint + mdist * si.mX * e + mdist * si.mY * n) * r[0];
+      cornerLngLats.push_back(cs::utils::convert::toLngLatHeight(p, r[0], r[0]).xy());
+    }
+  }
+
+  std::vector<double> cornerHeights;
+  body->getHeights(cornerLngLats, cornerHeights);
+
+  // Samples of an edge to find the intersection point between edge and plane
+  std::vector<glm::dvec3> edgePoints;
+  std::vector<glm::dvec2> edgeLngLats;
+  std::vector<double>     edgeHeights;
+
+  // Samples the points and heights on the edge from pA to pB, all heights are sampled at once
+  auto sampleEdge = [&](glm::dvec3 const& pA, glm::dvec3 const& pB, int res) {
+    edgePoints.resize(res);
+    edgeLngLats.resize(res);
+    for (int i = 0; i < res; i++) {
+      double frac    = static_cast<double>(i) / res;
+      edgePoints[i]  = glm::normalize((1 - frac) * pA + frac * pB) * r[0];
+      edgeLngLats[i] = cs::utils::convert::toLngLatHeight(edgePoints[i], r[0], r[0]).xy();
+    }
+    body->getHeights(edgeLngLats, edgeHeights);
+  };
+
+  std::size_t corner = 0;
+
   // Counts area and volume in every triangle
   for (const auto& triangle : triangles) {
     // ------------------------------------------ AREA ------------------------------------------
@@ -760,9 +820,9 @@ void PolygonTool::calculateAreaAndVolume(std::vector<Triangle> const& triangles,
     glm::dvec3 l3 = cs::utils::convert::toLngLatHeight(p3, r[0], r[0]);
 
     // Heights of the points
-    double h1 = mSolarSystem->pActiveBody.get()->getHeight(l1.xy());
-    double h2 = mSolarSystem->pActiveBody.get()->getHeight(l2.xy());
-    double h3 = mSolarSystem->pActiveBody.get()->getHeight(l3.xy());
+    double h1 = cornerHeights[corner++];
+    double h2 = cornerHeights[corner++];
+    double h3 = cornerHeights[corner++];
 
     // Cartesian coordinates with height
     glm::dvec3 r1 = cs::utils::convert::toCartesian(l1, r[0], r[0], h1);
@@ -809,7 +869,6 @@ void PolygonTool::calculateAreaAndVolume(std::vector<Triangle> const& triangles,
       auto   pM3    = glm::dvec3(0.0);
       auto   pM     = glm::dvec3(0.0);
       auto   pMOld  = glm::dvec3(0.0);
-      auto   lM     = glm::dvec3(0.0);
       double hM     = 0;
       double hlM    = 0;
       double hlMOld = 0;
@@ -818,23 +877,20 @@ void PolygonTool::calculateAreaAndVolume(std::vector<Triangle> const& triangles,
       bool   b3     = false;
 
       // Resolution of edge sampling
-      int    res  = 32;
-      double frac = 0;
+      int res = 32;
 
       // If the two points are on the other side of the plane
       if ((hl1 > 0) != (hl2 > 0)) {
         // Samples of edge to find the intersection point between edge and plane
         // (Does not consider multiple intersection points (f.eg.: mountains in triangle)
         // They have been mostly eliminated with triangulation
+        sampleEdge(p1, p2, res);
+
         for (int i = 0; i < res; i++) {
-          frac = static_cast<double>(i) / res;
           // Point coordinate without height
-          pM = glm::normalize((1 - frac) * p1 + frac * p2) * r[0];
-
-          // LongLat
-          lM = cs::utils::convert::toLngLatHeight(pM, r[0], r[0]);
+          pM = edgePoints[i];
           // Height
-          hM = mSolarSystem->pActiveBody.get()->getHeight(lM.xy());
+          hM = edgeHeights[i];
           // Height over least square plane
           hlM = hM - (glm::dot(mNormal2, mMiddlePoint2) / glm::dot(mNormal2, pM) - 1) *
                          glm::length(mMiddlePoint2);
@@ -854,12 +910,12 @@ void PolygonTool::calculateAreaAndVolume(std::vector<Triangle> const& triangles,
       }
 
       if ((hl1 > 0) != (hl3 > 0)) {
+        sampleEdge(p1, p3, res);
+
         for (int i = 0; i < res; i++) {
-          frac = static_cast<double>(i) / res;
-          pM   = glm::normalize((1 - frac) * p1 + frac * p3) * r[0];
-          lM   = cs::utils::convert::toLngLatHeight(pM, r[0], r[0]);
-          hM   = mSolarSystem->pActiveBody.get()->getHeight(lM.xy());
-          hlM  = hM - (glm::dot(mNormal2, mMiddlePoint2) / glm::dot(mNormal2, pM) - 1) *
+          pM  = edgePoints[i];
+          hM  = edgeHeights[i];
+          hlM = hM - (glm::dot(mNormal2, mMiddlePoint2) / glm::dot(mNormal2, pM) - 1) *
                          glm::length(mMiddlePoint2);
           if ((hl1 > 0) != (hlM > 0)) {
             pM2 = pMOld - (pM - pMOld) * hlMOld / (hlM - hlMOld);
@@ -873,12 +929,12 @@ void PolygonTool::calculateAreaAndVolume(std::vector<Triangle> const& triangles,
       }
 
       if ((hl2 > 0) != (hl3 > 0)) {
+        sampleEdge(p2, p3, res);
+
         for (int i = 0; i < res; i++) {
-          frac = static_cast<double>(i) / res;
-          pM   = glm::normalize((1 - frac) * p2 + frac * p3) * r[0];
-          lM   = cs::utils::convert::toLngLatHeight(pM, r[0], r[0]);
-          hM   = mSolarSystem->pActiveBody.get()->getHeight(lM.xy());
-          hlM  = hM - (glm::dot(mNormal2, mMiddlePoint2) / glm::dot(mNormal2, pM) - 1) *
+          pM  = edgePoints[i];
+          hM  = edgeHeights[i];
+          hlM = hM - (glm::dot(mNormal2, mMiddlePoint2) / glm::dot(mNormal2, pM) - 1) *
                          glm::length(mMiddlePoint2);
           if ((hl2 > 0) != (hlM > 0)) {
             pM3 = pMOld - (pM - pMOld) * hlMOld / (hlM - hlMOld);
@@ -1110,16 +1166,23 @@ void PolygonTool::updateCalculation() {
     averagePosition += mark->getAnchor()->getAnchorPosition() / static_cast<double>(mPoints.size());
   }
 
-  // Corrected average position (works for every height scale)
-  glm::dvec3 averagePositionNorm(0.0);
+  // LongLat coordinates of the points
+  std::vector<glm::dvec2> lngLats;
   for (auto const& mark : mPoints) {
     glm::dvec3 pos = glm::normalize(mark->getAnchor()->getAnchorPosition()) * radii[0];
-    // LongLat coordinate
-    glm::dvec3 l = cs::utils::convert::toLngLatHeight(pos, radii[0], radii[0]);
-    // Height of the point
-    double h = mSolarSystem->pActiveBody.get()->getHeight(l.xy());
+    lngLats.push_back(cs::utils::convert::toLngLatHeight(pos, radii[0], radii[0]).xy());
+  }
+
+  // Heights of the points, all of them are sampled at once
+  std::vector<double> heights;
+  mSolarSystem->pActiveBody.get()->getHeights(lngLats, heights);
+
+  // Corrected average position (works for every height scale)
+  glm::dvec3 averagePositionNorm(0.0);
+  for (std::size_t i = 0; i < lngLats.size(); ++i) {
     // Cartesian coordinate with height
-    glm::dvec3 posNorm = cs::utils::convert::toCartesian(l, radii[0], radii[0], h);
+    glm::dvec3 posNorm =
+        cs::utils::convert::toCartesian(lngLats[i], radii[0], radii[0], heights[i]);
 
     averagePositionNorm += posNorm / static_cast<double>(mPoints.size());
   }
@@ -1176,11 +1239,9 @@ void PolygonTool::updateCalculation() {
   mNormal2 = glm::normalize(averagePositionNorm);
   mOffset  = 0.F;
 
-  for (auto const& p : mPoints) {
-    glm::dvec3 pos     = glm::normalize(p->getAnchor()->getAnchorPosition()) * radii[0];
-    glm::dvec3 l       = cs::utils::convert::toLngLatHeight(pos, radii[0], radii[0]);
-    double     h       = mSolarSystem->pActiveBody.get()->getHeight(l.xy());
-    glm::dvec3 posNorm = cs::utils::convert::toCartesian(l, radii[0], radii[0], h);
+  for (std::size_t i = 0; i < lngLats.size(); ++i) {
+    glm::dvec3 posNorm =
+        cs::utils::convert::toCartesian(lngLats[i], radii[0], radii[0], heights[i]);
 
     glm::dvec3 realtivePosition = posNorm - averagePositionNorm;
 
@@ -1302,19 +1363,17 @@ void PolygonTool::updateCalculation() {
         voronoiRefine.parse(mCornersFine[triangleCount]);
 
         // No need for checkPoint, all of the edges are inside the triangle and the polygon
-        for (auto const& s : voronoiRefine.getTriangulation()) {
-          double h1{};
-          double h2{};
-
-          // Calculates mesh coordinates on planet's surface and saves these coordinates for display
-          displayMesh(s, maxDist, east, north, radii, h_scale, h1, h2);
-
-          // If not too many points are addded in checkSleekness and it is not the the last attempt
-          // than refines the mesh based on edge length and height differences
-          if ((!refine) && (pointCount < mMaxPoints) && (attempt < mMaxAttempt)) {
-            refineMesh(
-                s, maxDist, east, north, radii, static_cast<int32_t>(triangleCount), h1, h2, fine);
-          }
+        auto const&         edges = voronoiRefine.getTriangulation();
+        std::vector<double> heights;
+
+        // Calculates mesh coordinates on planet's surface and saves these coordinates for display
+        displayMesh(edges, maxDist, east, north, radii, h_scale, heights);
+
+        // If not too many points are addded in checkSleekness and it is not the the last attempt
+        // than refines the mesh based on edge length and height differences
+        if ((!refine) && (pointCount < mMaxPoints) && (attempt < mMaxAttempt)) {
+          refineMesh(edges, maxDist, east, north, radii, static_cast<int32_t>(triangleCount),
+              heights, fine);
         }
 
         std::vector<Triangle> trianglesRefined = voronoiRefine.getTriangles();
@@ -92,12 +92,15 @@ class PolygonTool : public IVistaOpenGLDraw, public cs::core::tools::MultiPointT
   /// If a triangle is too sleek, divides it
   /// Returns true if a lot of new points are added
   bool checkSleekness(int count);
-  /// Draws the Delaunay-mesh on the planet's surface
-  void displayMesh(Edge2 const& edge, double mdist, glm::dvec3 const& e, glm::dvec3 const& n,
-      glm::dvec3 const& r, double scale, double& h1, double& h2);
+  /// Draws the edges of the Delaunay-mesh on the planet's surface
+  /// The heights of both ends of each edge are stored in heights
+  void displayMesh(std::vector<Edge2> const& edges, double mdist, glm::dvec3 const& e,
+      glm::dvec3 const& n, glm::dvec3 const& r, double scale, std::vector<double>& heights);
   /// Refines mesh based on edge length and terrain
-  void refineMesh(Edge2 const& edge, double mdist, glm::dvec3 const& e, glm::dvec3 const& n,
-      glm::dvec3 const& r, int count, double h1, double h2, bool& fine);
+  /// heights are the heights of the edge ends as returned by displayMesh
+  void refineMesh(std::vector<Edge2> const& edges, double mdist, glm::dvec3 const& e,
+      glm::dvec3 const& n, glm::dvec3 const& r, int count, std::vector<double> const& heights,
+      bool& fine);
   /// Calculates triangle areas and prism volumes
   void calculateAreaAndVolume(std::vector<Triangle> const& triangles, double mdist,
       glm::dvec3 const& e, glm::dvec3 const& n, glm::dvec3 const& r, double& area, double& pvol,
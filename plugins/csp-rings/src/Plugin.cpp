@@ -6,6 +6,7 @@
 
 #include "Plugin.hpp"
 
+#include "../../../src/cs-core/GraphicsEngine.hpp"
 #include "../../../src/cs-core/Settings.hpp"
 #include "../../../src/cs-core/SolarSystem.hpp"
 #include "../../../src/cs-utils/logger.hpp"
@@ -127,8 +128,9 @@ void Plugin::onLoad() {
 
     auto [tStartExistence, tEndExistence] = anchor->second.getExistence();
 
-    auto ring = std::make_shared<Ring>(mAllSettings, mSolarSystem, anchor->second.mCenter,
-        anchor->second.mFrame, tStartExistence, tEndExistence);
+    auto ring = std::make_shared<Ring>(mAllSettings, mSolarSystem,
+        mGraphicsEngine->getTextureLoader(), anchor->second.mCenter, anchor->second.mFrame,
+        tStartExistence, tEndExistence);
 
     ring->configure(settings.second);
 
@@ -8,7 +8,6 @@
 
 #include "../../../src/cs-core/Settings.hpp"
 #include "../../../src/cs-core/SolarSystem.hpp"
-#include "../../../src/cs-graphics/TextureLoader.hpp"
 #include "../../../src/cs-utils/FrameTimings.hpp"
 #include "../../../src/cs-utils/utils.hpp"
 
@@ -88,11 +87,14 @@ void main()
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 Ring::Ring(std::shared_ptr<cs::core::Settings> settings,
-    std::shared_ptr<cs::core::SolarSystem> solarSystem, std::string const& sCenterName,
-    std::string const& sFrameName, double tStartExistence, double tEndExistence)
+    std::shared_ptr<cs::core::SolarSystem>            solarSystem,
+    std::shared_ptr<cs::graphics::AsyncTextureLoader> textureLoader,
+    std::string const& sCenterName, std::string const& sFrameName, double tStartExistence,
+    double tEndExistence)
     : cs::scene::CelestialObject(sCenterName, sFrameName, tStartExistence, tEndExistence)
     , mSettings(std::move(settings))
-    , mSolarSystem(std::move(solarSystem)) {
+    , mSolarSystem(std::move(solarSystem))
+    , mTextureLoader(std::move(textureLoader)) {
 
   // The geometry is a grid strip around the center of the SPICE frame.
   std::vector<glm::vec2> vertices(GRID_RESOLUTION * 2);
@@ -135,7 +137,7 @@ Ring::~Ring() {
 
 void Ring::configure(Plugin::Settings::Ring const& settings) {
   if (mRingSettings.mTexture != settings.mTexture) {
-    mTexture = cs::graphics::TextureLoader::loadFromFile(settings.mTexture);
+    mTexture = mTextureLoader->loadFromFile(settings.mTexture);
   }
   mRingSettings = settings;
 }
@@ -149,7 +151,8 @@ void Ring::setSun(std::shared_ptr<const cs::scene::CelestialObject> const& sun)
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 bool Ring::Do() {
-  if (!getIsInExistence()) {
+  // A placeholder texture would make the ring opaque, so it is not drawn until it has been loaded.
+  if (!getIsInExistence() || !mTexture->isReady()) {
     return true;
   }
 
@@ -194,7 +197,7 @@ bool Ring::Do() {
 
   mShader.SetUniform(mShader.GetUniformLocation("uSunIlluminance"), sunIlluminance);
 
-  mTexture->Bind(GL_TEXTURE0);
+  mTexture->get()->Bind(GL_TEXTURE0);
 
   glEnable(GL_BLEND);
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -205,7 +208,7 @@ bool Ring::Do() {
   mSphereVAO.Release();
 
   // Clean up.
-  mTexture->Unbind(GL_TEXTURE0);
+  mTexture->get()->Unbind(GL_TEXTURE0);
 
   glDisable(GL_BLEND);
   mShader.Release();
@@ -9,6 +9,7 @@
 
 #include "Plugin.hpp"
 
+#include "../../../src/cs-graphics/AsyncTextureLoader.hpp"
 #include "../../../src/cs-scene/CelestialObject.hpp"
 
 #include <VistaKernel/GraphicsManager/VistaOpenGLDraw.h>
@@ -30,9 +31,11 @@ namespace csp::rings {
 /// planet's center respectively.
 class Ring : public cs::scene::CelestialObject, public IVistaOpenGLDraw {
  public:
-  Ring(std::shared_ptr<cs::core::Settings>   settings,
-      std::shared_ptr<cs::core::SolarSystem> solarSystem, std::string const& sCenterName,
-      std::string const& sFrameName, double tStartExistence, double tEndExistence);
+  Ring(std::shared_ptr<cs::core::Settings>              settings,
+      std::shared_ptr<cs::core::SolarSystem>            solarSystem,
+      std::shared_ptr<cs::graphics::AsyncTextureLoader> textureLoader,
+      std::string const& sCenterName, std::string const& sFrameName, double tStartExistence,
+      double tEndExistence);
 
   Ring(Ring const& other) = delete;
   Ring(Ring&& other)      = default;
@@ -54,15 +57,16 @@ class Ring : public cs::scene::CelestialObject, public IVistaOpenGLDraw {
  private:
   std::shared_ptr<cs::core::Settings>               mSettings;
   std::shared_ptr<cs::core::SolarSystem>            mSolarSystem;
+  std::shared_ptr<cs::graphics::AsyncTextureLoader> mTextureLoader;
   std::shared_ptr<const cs::scene::CelestialObject> mSun;
 
   std::unique_ptr<VistaOpenGLNode> mGLNode;
 
-  Plugin::Settings::Ring        mRingSettings;
-  std::unique_ptr<VistaTexture> mTexture;
-  VistaGLSLShader               mShader;
-  VistaVertexArrayObject        mSphereVAO;
-  VistaBufferObject             mSphereVBO;
+  Plugin::Settings::Ring                                           mRingSettings;
+  std::shared_ptr<cs::graphics::AsyncTextureLoader::Texture const> mTexture;
+  VistaGLSLShader                                                  mShader;
+  VistaVertexArrayObject                                           mSphereVAO;
+  VistaBufferObject                                                mSphereVBO;
 
   static const char* SPHERE_VERT;
   static const char* SPHERE_FRAG;
@@ -6,6 +6,7 @@
 
 #include "Plugin.hpp"
 
+#include "../../../src/cs-core/GraphicsEngine.hpp"
 #include "../../../src/cs-core/GuiManager.hpp"
 #include "../../../src/cs-core/SolarSystem.hpp"
 #include "../../../src/cs-gui/GuiItem.hpp"
@@ -94,7 +95,8 @@ void Plugin::init() {
 
           if (ext == ".tab") {
             std::string sName  = file.substr(0, file.length() - 5);
-            auto        sharad = std::make_shared<Sharad>(mAllSettings, "MARS", "IAU_Mars",
+            auto        sharad = std::make_shared<Sharad>(mAllSettings,
+                mGraphicsEngine->getTextureLoader(), "MARS", "IAU_Mars",
                 filePath + sName + "_tiff.tif", filePath + sName + "_geom.tab");
             mSolarSystem->registerAnchor(sharad);
 
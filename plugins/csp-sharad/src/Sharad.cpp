@@ -7,7 +7,6 @@
 #include "Sharad.hpp"
 
 #include "../../../src/cs-core/SolarSystem.hpp"
-#include "../../../src/cs-graphics/TextureLoader.hpp"
 #include "../../../src/cs-scene/CelestialObserver.hpp"
 #include "../../../src/cs-utils/FrameTimings.hpp"
 #include "../../../src/cs-utils/convert.hpp"
@@ -137,11 +136,13 @@ struct ProfileRadarData {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-Sharad::Sharad(std::shared_ptr<cs::core::Settings> settings, std::string const& sCenterName,
-    std::string const& sFrameName, std::string const& sTiffFile, std::string const& sTabFile)
+Sharad::Sharad(std::shared_ptr<cs::core::Settings> settings,
+    std::shared_ptr<cs::graphics::AsyncTextureLoader> const& textureLoader,
+    std::string const& sCenterName, std::string const& sFrameName, std::string const& sTiffFile,
+    std::string const& sTabFile)
     : cs::scene::CelestialObject(sCenterName, sFrameName, 0, 0)
     , mSettings(std::move(settings))
-    , mTexture(cs::graphics::TextureLoader::loadFromFile(sTiffFile)) {
+    , mTexture(textureLoader->loadFromFile(sTiffFile)) {
   // arbitray date in future
   mEndExistence = cs::utils::convert::time::toSpice("2040-01-01T00:00:00.000Z");
 
@@ -283,7 +284,7 @@ void Sharad::update(double tTime, cs::scene::CelestialObserver const& oObs) {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 bool Sharad::Do() {
-  if (getIsInExistence()) {
+  if (getIsInExistence() && mTexture->isReady()) {
     cs::utils::FrameTimings::ScopedTimer timer("Sharad");
 
     mShader.Bind();
@@ -315,7 +316,7 @@ bool Sharad::Do() {
     mShader.SetUniform(
         mShader.GetUniformLocation("uFarClip"), cs::utils::getCurrentFarClipDistance());
 
-    mTexture->Bind(GL_TEXTURE0);
+    mTexture->get()->Bind(GL_TEXTURE0);
     mDepthBuffer->Bind(GL_TEXTURE1);
 
     glPushAttrib(GL_ENABLE_BIT | GL_DEPTH_BUFFER_BIT);
@@ -332,7 +333,7 @@ bool Sharad::Do() {
     mVAO.Release();
 
     // clean up ----------------------------------------------------------------
-    mTexture->Unbind(GL_TEXTURE0);
+    mTexture->get()->Unbind(GL_TEXTURE0);
 
     glPopAttrib();
 
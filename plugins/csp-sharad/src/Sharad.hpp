@@ -8,6 +8,7 @@
 #define CSP_SHARAD_HPP
 
 #include "../../../src/cs-core/Settings.hpp"
+#include "../../../src/cs-graphics/AsyncTextureLoader.hpp"
 #include "../../../src/cs-scene/CelestialObject.hpp"
 
 #include <VistaKernel/GraphicsManager/VistaOpenGLDraw.h>
@@ -22,11 +23,14 @@ class VistaTexture;
 
 namespace csp::sharad {
 
-/// Renders a single SHARAD image.
+/// Renders a single SHARAD image. The image is loaded in the background with the given loader; it
+/// is not drawn until it has been uploaded.
 class Sharad : public cs::scene::CelestialObject, public IVistaOpenGLDraw {
  public:
-  Sharad(std::shared_ptr<cs::core::Settings> settings, std::string const& sCenterName,
-      std::string const& sFrameName, std::string const& sTiffFile, std::string const& sTabFile);
+  Sharad(std::shared_ptr<cs::core::Settings>                   settings,
+      std::shared_ptr<cs::graphics::AsyncTextureLoader> const& textureLoader,
+      std::string const& sCenterName, std::string const& sFrameName, std::string const& sTiffFile,
+      std::string const& sTabFile);
 
   Sharad(Sharad const& other) = delete;
   Sharad(Sharad&& other)      = delete;
@@ -60,8 +64,8 @@ class Sharad : public cs::scene::CelestialObject, public IVistaOpenGLDraw {
   static std::unique_ptr<VistaOpenGLNode>     mPreCallbackNode;
   static int                                  mInstanceCount;
 
-  std::shared_ptr<cs::core::Settings> mSettings;
-  std::unique_ptr<VistaTexture>       mTexture;
+  std::shared_ptr<cs::core::Settings>                              mSettings;
+  std::shared_ptr<cs::graphics::AsyncTextureLoader::Texture const> mTexture;
 
   VistaGLSLShader        mShader;
   VistaVertexArrayObject mVAO;
@@ -6,6 +6,7 @@
 
 #include "Plugin.hpp"
 
+#include "../../../src/cs-core/GraphicsEngine.hpp"
 #include "../../../src/cs-core/InputManager.hpp"
 #include "../../../src/cs-core/Settings.hpp"
 #include "../../../src/cs-core/SolarSystem.hpp"
@@ -127,7 +128,8 @@ void Plugin::onLoad() {
     auto [tStartExistence, tEndExistence] = anchor->second.getExistence();
 
     auto simpleBody = std::make_shared<SimpleBody>(mAllSettings, mSolarSystem,
-        anchor->second.mCenter, anchor->second.mFrame, tStartExistence, tEndExistence);
+        mGraphicsEngine->getTextureLoader(), anchor->second.mCenter, anchor->second.mFrame,
+        tStartExistence, tEndExistence);
 
     simpleBody->configure(settings.second);
     simpleBody->setSun(mSolarSystem->getSun());
@@ -8,7 +8,6 @@
 
 #include "../../../src/cs-core/Settings.hpp"
 #include "../../../src/cs-core/SolarSystem.hpp"
-#include "../../../src/cs-graphics/TextureLoader.hpp"
 #include "../../../src/cs-utils/FrameTimings.hpp"
 #include "../../../src/cs-utils/utils.hpp"
 
@@ -119,11 +118,14 @@ void main()
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 SimpleBody::SimpleBody(std::shared_ptr<cs::core::Settings> settings,
-    std::shared_ptr<cs::core::SolarSystem> solarSystem, std::string const& sCenterName,
-    std::string const& sFrameName, double tStartExistence, double tEndExistence)
+    std::shared_ptr<cs::core::SolarSystem>            solarSystem,
+    std::shared_ptr<cs::graphics::AsyncTextureLoader> textureLoader,
+    std::string const& sCenterName, std::string const& sFrameName, double tStartExistence,
+    double tEndExistence)
     : cs::scene::CelestialBody(sCenterName, sFrameName, tStartExistence, tEndExistence)
     , mSettings(std::move(settings))
     , mSolarSystem(std::move(solarSystem))
+    , mTextureLoader(std::move(textureLoader))
     , mRadii(cs::core::SolarSystem::getRadii(sCenterName)) {
   pVisibleRadius = mRadii[0];
 
@@ -194,7 +196,7 @@ SimpleBody::~SimpleBody() {
 
 void SimpleBody::configure(Plugin::Settings::SimpleBody const& settings) {
   if (mSimpleBodySettings.mTexture != settings.mTexture) {
-    mTexture = cs::graphics::TextureLoader::loadFromFile(settings.mTexture);
+    mTexture = mTextureLoader->loadFromFile(settings.mTexture);
   }
   mSimpleBodySettings = settings;
 }
@@ -324,7 +326,9 @@ bool SimpleBody::Do() {
   mShader.SetUniform(
       mShader.GetUniformLocation("uFarClip"), cs::utils::getCurrentFarClipDistance());
 
-  mTexture->Bind(GL_TEXTURE0);
+  // Until the texture has been loaded, this is a gray placeholder.
+  VistaTexture* texture = mTexture->get();
+  texture->Bind(GL_TEXTURE0);
 
   // Draw.
   mSphereVAO.Bind();
@@ -333,7 +337,7 @@ bool SimpleBody::Do() {
   mSphereVAO.Release();
 
   // Clean up.
-  mTexture->Unbind(GL_TEXTURE0);
+  texture->Unbind(GL_TEXTURE0);
   mShader.Release();
 
   return true;
@@ -14,6 +14,7 @@
 #include <VistaOGLExt/VistaTexture.h>
 #include <VistaOGLExt/VistaVertexArrayObject.h>
 
+#include "../../../src/cs-graphics/AsyncTextureLoader.hpp"
 #include "../../../src/cs-scene/CelestialBody.hpp"
 #include "Plugin.hpp"
 
@@ -28,9 +29,11 @@ namespace csp::simplebodies {
 /// in equirectangular projection.
 class SimpleBody : public cs::scene::CelestialBody, public IVistaOpenGLDraw {
  public:
-  SimpleBody(std::shared_ptr<cs::core::Settings> settings,
-      std::shared_ptr<cs::core::SolarSystem> solarSystem, std::string const& sCenterName,
-      std::string const& sFrameName, double tStartExistence, double tEndExistence);
+  SimpleBody(std::shared_ptr<cs::core::Settings>          settings,
+      std::shared_ptr<cs::core::SolarSystem>            solarSystem,
+      std::shared_ptr<cs::graphics::AsyncTextureLoader> textureLoader,
+      std::string const& sCenterName, std::string const& sFrameName, double tStartExistence,
+      double tEndExistence);
 
   SimpleBody(SimpleBody const& other) = delete;
   SimpleBody(SimpleBody&& other)      = default;
@@ -62,16 +65,17 @@ class SimpleBody : public cs::scene::CelestialBody, public IVistaOpenGLDraw {
  private:
   std::shared_ptr<cs::core::Settings>               mSettings;
   std::shared_ptr<cs::core::SolarSystem>            mSolarSystem;
+  std::shared_ptr<cs::graphics::AsyncTextureLoader> mTextureLoader;
   std::shared_ptr<const cs::scene::CelestialObject> mSun;
 
   std::unique_ptr<VistaOpenGLNode> mGLNode;
 
-  Plugin::Settings::SimpleBody  mSimpleBodySettings;
-  std::unique_ptr<VistaTexture> mTexture;
-  VistaGLSLShader               mShader;
-  VistaVertexArrayObject        mSphereVAO;
-  VistaBufferObject             mSphereVBO;
-  VistaBufferObject             mSphereIBO;
+  Plugin::Settings::SimpleBody                                     mSimpleBodySettings;
+  std::shared_ptr<cs::graphics::AsyncTextureLoader::Texture const> mTexture;
+  VistaGLSLShader                                                  mShader;
+  VistaVertexArrayObject                                           mSphereVAO;
+  VistaBufferObject                                                mSphereVBO;
+  VistaBufferObject                                                mSphereIBO;
 
   glm::dvec3 mRadii;
 
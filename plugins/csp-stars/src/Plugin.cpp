@@ -82,7 +82,7 @@ void Plugin::init() {
       [this]() { mAllSettings->mPlugins["csp-stars"] = mPluginSettings; });
 
   // Create the Stars object based on the settings.
-  mStars = std::make_unique<Stars>();
+  mStars = std::make_unique<Stars>(mGraphicsEngine->getTextureLoader());
 
   // Add the stars to the scenegraph.
   mStarsTransform = std::make_shared<cs::scene::CelestialAnchorNode>(
@@ -0,0 +1,542 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "StarCatalog.hpp"
+
+#include "logger.hpp"
+
+#include "../../../src/cs-utils/ThreadPool.hpp"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <VistaBase/VistaColor.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <glm/gtc/constants.hpp>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+
+namespace csp::stars {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The first bytes of each binary catalog file.
+const std::array<char, 8> MAGIC{'C', 'S', 'S', 'T', 'A', 'R', 'S', '\0'};
+
+// All attribute arrays start at a multiple of this many bytes.
+const std::size_t ALIGNMENT = 16;
+
+struct Header {
+  std::array<char, 8>          mMagic;
+  std::uint32_t                mVersion;
+  std::uint32_t                mCatalogs;
+  std::uint64_t                mStarCount;
+  std::array<std::uint64_t, 4> mOffsets;
+};
+
+// spectral colors from B-V index -0.4 to 2.0 in steps of 0.05
+// values from  http://www.vendian.org/mncharity/dir3/starcolor/details.html
+// NOLINTNEXTLINE(cert-err58-cpp)
+const std::array sSpectralColors = {VistaColor(0x9bb2ff), VistaColor(0x9eb5ff),
+    VistaColor(0xa3b9ff), VistaColor(0xaabfff), VistaColor(0xb2c5ff), VistaColor(0xbbccff),
+    VistaColor(0xc4d2ff), VistaColor(0xccd8ff), VistaColor(0xd3ddff), VistaColor(0xdae2ff),
+    VistaColor(0xdfe5ff), VistaColor(0xe4e9ff), VistaColor(0xe9ecff), VistaColor(0xeeefff),
+    VistaColor(0xf3f2ff), VistaColor(0xf8f6ff), VistaColor(0xfef9ff), VistaColor(0xfff9fb),
+    VistaColor(0xfff7f5), VistaColor(0xfff5ef), VistaColor(0xfff3ea), VistaColor(0xfff1e5),
+    VistaColor(0xffefe0), VistaColor(0xffeddb), VistaColor(0xffebd6), VistaColor(0xffe8ce),
+    VistaColor(0xffe6ca), VistaColor(0xffe5c6), VistaColor(0xffe3c3), VistaColor(0xffe2bf),
+    VistaColor(0xffe0bb), VistaColor(0xffdfb8), VistaColor(0xffddb4), VistaColor(0xffdbb0),
+    VistaColor(0xffdaad), VistaColor(0xffd8a9), VistaColor(0xffd6a5), VistaColor(0xffd29c),
+    VistaColor(0xffd096), VistaColor(0xffcc8f), VistaColor(0xffc885), VistaColor(0xffc178),
+    VistaColor(0xffb765), VistaColor(0xffa94b), VistaColor(0xff9523), VistaColor(0xff7b00),
+    VistaColor(0xff5200)};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t align(std::size_t offset) {
+  return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+// Parses a number from a single column of a catalog line. This is much faster than using a
+// std::istringstream but accepts the same input: Leading white space is skipped and everything
+// after the number is ignored. A column without a number is an error.
+template <typename T>
+bool fromString(std::vector<std::string_view> const& items, int column, T& out) {
+  if (column < 0 || column >= static_cast<int>(items.size())) {
+    return false;
+  }
+
+  auto const& item = items[column];
+
+  // The catalog data is null-terminated, so the conversion stops at the latest there. It might
+  // however skip white space at the end of a line and parse a number from the next line.
+  char* end = nullptr;
+
+  if constexpr (std::is_floating_point_v<T>) {
+    out = std::strtof(item.data(), &end);
+  } else {
+    out = static_cast<T>(std::strtol(item.data(), &end, 10));
+  }
+
+  return end != item.data() && end <= item.data() + item.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// A read-only memory mapping of an entire file.
+class StarCatalog::MappedFile {
+ public:
+  explicit MappedFile(std::string const& fileName) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+    if (file == INVALID_HANDLE_VALUE) {
+      return;
+    }
+
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+      HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+      if (mapping) {
+        mData = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        mSize = static_cast<std::size_t>(size.QuadPart);
+
+        // The view keeps the mapping alive.
+        CloseHandle(mapping);
+      }
+    }
+
+    CloseHandle(file);
+#else
+    int file = open(fileName.c_str(), O_RDONLY); // NOLINT(cppcoreguidelines-pro-type-vararg)
+
+    if (file < 0) {
+      return;
+    }
+
+    struct stat info {};
+    if (fstat(file, &info) == 0 && info.st_size > 0) {
+      void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+
+      if (data != MAP_FAILED) { // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+        mData = data;
+        mSize = static_cast<std::size_t>(info.st_size);
+      }
+    }
+
+    // The mapping stays valid after the file has been closed.
+    close(file);
+#endif
+  }
+
+  MappedFile(MappedFile const& other) = delete;
+  MappedFile(MappedFile&& other)      = delete;
+
+  MappedFile& operator=(MappedFile const& other) = delete;
+  MappedFile& operator=(MappedFile&& other) = delete;
+
+  ~MappedFile() {
+    if (mData) {
+#ifdef _WIN32
+      UnmapViewOfFile(mData);
+#else
+      munmap(mData, mSize);
+#endif
+    }
+  }
+
+  void const* getData() const {
+    return mData;
+  }
+
+  std::size_t getSize() const {
+    return mSize;
+  }
+
+ private:
+  void*       mData = nullptr;
+  std::size_t mSize = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const std::array<std::array<int, StarCatalog::NUM_COLUMNS>, StarCatalog::NUM_CATALOGS>
+    StarCatalog::cColumnMapping{
+        std::array{34, 32, 11, 8, 9, 31}, // CatalogType::eHipparcos
+        std::array{34, 32, 11, 8, 9, 31}, // CatalogType::eTycho
+        std::array{19, 17, -1, 2, 3, 23}  // CatalogType::eTycho2
+    };
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Increase this if the binary format changed and is incompatible now. This will force a reload.
+const std::uint32_t StarCatalog::cVersion = 1;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::unique_ptr<StarCatalog> StarCatalog::fromText(
+    std::map<CatalogType, std::string> const& catalogs) {
+  std::vector<Star> stars;
+
+  bool loadHipparcos = catalogs.find(CatalogType::eHipparcos) != catalogs.end();
+
+  auto it = catalogs.find(CatalogType::eHipparcos);
+  if (it != catalogs.end()) {
+    readTextCatalog(it->first, it->second, false, stars);
+  }
+
+  it = catalogs.find(CatalogType::eTycho);
+  if (it != catalogs.end()) {
+    readTextCatalog(it->first, it->second, loadHipparcos, stars);
+  }
+
+  it = catalogs.find(CatalogType::eTycho2);
+  if (it != catalogs.end()) {
+    // do not load tycho and tycho 2
+    if (catalogs.find(CatalogType::eTycho) == catalogs.end()) {
+      readTextCatalog(it->first, it->second, loadHipparcos, stars);
+    } else {
+      logger().warn("Failed to load Tycho2 catalog: Tycho already loaded!");
+    }
+  }
+
+  return create(stars, getCatalogMask(catalogs));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::unique_ptr<StarCatalog> StarCatalog::load(
+    std::string const& fileName, std::map<CatalogType, std::string> const& catalogs) {
+  // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+  std::unique_ptr<StarCatalog> catalog(new StarCatalog());
+
+  catalog->mFile = std::make_unique<MappedFile>(fileName);
+
+  if (!catalog->init(catalog->mFile->getData(), catalog->mFile->getSize())) {
+    return nullptr;
+  }
+
+  if (catalog->mCatalogs != getCatalogMask(catalogs)) {
+    logger().info("Ignoring star cache '{}': It has been created from other catalogs.", fileName);
+    return nullptr;
+  }
+
+  logger().info("Mapped {} stars from '{}'.", catalog->mStarCount, fileName);
+
+  return catalog;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+StarCatalog::~StarCatalog() = default;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool StarCatalog::save(std::string const& fileName) const {
+  std::ofstream file(fileName, std::ios::out | std::ios::binary);
+
+  if (!file.is_open()) {
+    logger().error(
+        "Failed to write binary star data: Cannot open file '{}' for writing!", fileName);
+    return false;
+  }
+
+  logger().info("Writing {} stars ({} bytes) into '{}'.", mStarCount, mDataSize, fileName);
+
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  file.write(reinterpret_cast<char const*>(mData), static_cast<std::streamsize>(mDataSize));
+
+  return file.good();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t StarCatalog::getStarCount() const {
+  return mStarCount;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void const* StarCatalog::getData() const {
+  return mData;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t StarCatalog::getDataSize() const {
+  return mDataSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t StarCatalog::getOffset(Attribute attribute) const {
+  return mOffsets.at(cs::utils::enumCast(attribute));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int StarCatalog::getComponents(Attribute attribute) {
+  static const std::array<int, NUM_ATTRIBUTES> components{2, 1, 3, 1};
+  return components.at(cs::utils::enumCast(attribute));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+float const* StarCatalog::getAttribute(Attribute attribute) const {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast, cppcoreguidelines-pro-bounds-*)
+  return reinterpret_cast<float const*>(mData + getOffset(attribute));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool StarCatalog::init(void const* data, std::size_t size) {
+  if (!data || size < sizeof(Header)) {
+    return false;
+  }
+
+  Header header{};
+  std::memcpy(&header, data, sizeof(Header));
+
+  if (header.mMagic != MAGIC || header.mVersion != cVersion) {
+    return false;
+  }
+
+  for (std::size_t i = 0; i < NUM_ATTRIBUTES; ++i) {
+    std::uint64_t arraySize =
+        header.mStarCount * getComponents(static_cast<Attribute>(i)) * sizeof(float);
+
+    if (header.mOffsets.at(i) % ALIGNMENT != 0 || header.mOffsets.at(i) > size ||
+        arraySize > size - header.mOffsets.at(i)) {
+      return false;
+    }
+
+    mOffsets.at(i) = static_cast<std::size_t>(header.mOffsets.at(i));
+  }
+
+  mData      = static_cast<std::uint8_t const*>(data);
+  mDataSize  = size;
+  mStarCount = static_cast<std::size_t>(header.mStarCount);
+  mCatalogs  = header.mCatalogs;
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool StarCatalog::readTextCatalog(CatalogType type, std::string const& fileName,
+    bool skipHipparcosStars, std::vector<Star>& stars) {
+  logger().info("Reading star catalog '{}'.", fileName);
+
+  std::ifstream file(fileName, std::ios::in | std::ios::binary | std::ios::ate);
+
+  if (!file.is_open()) {
+    logger().error("Failed to load stars: Cannot open catalog file '{}'!", fileName);
+    return false;
+  }
+
+  // Read the entire file at once, this is much faster than reading it line by line.
+  std::string content(static_cast<std::size_t>(file.tellg()), '\0');
+  file.seekg(0, std::ios::beg);
+  file.read(content.data(), static_cast<std::streamsize>(content.size()));
+  file.close();
+
+  // Split the file into chunks of complete lines which are parsed in parallel. There are some more
+  // chunks than threads, so that all threads are busy until the end.
+  std::size_t threads   = std::max(1U, std::thread::hardware_concurrency());
+  std::size_t chunkSize = content.size() / (threads * 4) + 1;
+
+  cs::utils::ThreadPool                        pool(threads);
+  std::vector<std::future<std::vector<Star>>> chunks;
+
+  for (std::size_t begin = 0; begin < content.size();) {
+    std::size_t end = content.find('\n', std::min(begin + chunkSize, content.size()));
+    end             = (end == std::string::npos) ? content.size() : end + 1;
+
+    chunks.emplace_back(pool.enqueue([&content, begin, end, type, skipHipparcosStars]() {
+      return parseLines(content.data() + begin, content.data() + end, type, skipHipparcosStars);
+    }));
+
+    begin = end;
+  }
+
+  std::size_t count = stars.size();
+
+  for (auto& chunk : chunks) {
+    auto chunkStars = chunk.get();
+    stars.insert(stars.end(), chunkStars.begin(), chunkStars.end());
+  }
+
+  logger().info("Read a total of {} stars.", stars.size() - count);
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<StarCatalog::Star> StarCatalog::parseLines(
+    char const* begin, char const* end, CatalogType type, bool skipHipparcosStars) {
+  std::vector<Star>             stars;
+  std::vector<std::string_view> items;
+
+  auto const& columns = cColumnMapping.at(cs::utils::enumCast(type));
+  auto        column  = [&columns](CatalogColumn c) { return columns.at(cs::utils::enumCast(c)); };
+
+  while (begin < end) {
+    char const* lineEnd = std::find(begin, end, '\n');
+
+    // separate complete items consisting of "val0|val1|...|valN|" into vector of value strings
+    items.clear();
+    char const* item = begin;
+
+    for (char const* c = begin; c != lineEnd; ++c) { // NOLINT(cppcoreguidelines-pro-bounds-*)
+      if (*c == '|') {
+        items.emplace_back(item, c - item);
+        item = c + 1; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+      }
+    }
+
+    if (item != lineEnd) {
+      items.emplace_back(item, lineEnd - item);
+    }
+
+    begin = lineEnd == end ? end : lineEnd + 1; // NOLINT(cppcoreguidelines-pro-bounds-*)
+
+    // expecting Hipparcos or Tycho-1 catalog and more than 12 columns
+    if (items.size() <= 12) {
+      continue;
+    }
+
+    // skip if part of hipparcos catalogue
+    int hipparcosNumber{};
+    if (skipHipparcosStars && fromString(items, column(CatalogColumn::eHipp), hipparcosNumber)) {
+      continue;
+    }
+
+    Star star{};
+    if (!fromString(items, column(CatalogColumn::eVmag), star.mVMagnitude) ||
+        !fromString(items, column(CatalogColumn::eBmag), star.mBMagnitude) ||
+        !fromString(items, column(CatalogColumn::eRect), star.mAscension) ||
+        !fromString(items, column(CatalogColumn::eDecl), star.mDeclination)) {
+      continue;
+    }
+
+    if (!fromString(items, column(CatalogColumn::ePara), star.mParallax)) {
+      star.mParallax = 0.F;
+    }
+
+    star.mAscension   = (360.F + 90.F - star.mAscension) / 180.F * glm::pi<float>();
+    star.mDeclination = star.mDeclination / 180.F * glm::pi<float>();
+
+    stars.emplace_back(star);
+  }
+
+  return stars;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::unique_ptr<StarCatalog> StarCatalog::create(
+    std::vector<Star> const& stars, std::uint32_t catalogs) {
+  Header header{};
+  header.mMagic     = MAGIC;
+  header.mVersion   = cVersion;
+  header.mCatalogs  = catalogs;
+  header.mStarCount = stars.size();
+
+  std::size_t size = align(sizeof(Header));
+  for (std::size_t i = 0; i < NUM_ATTRIBUTES; ++i) {
+    header.mOffsets.at(i) = size;
+    size = align(size + stars.size() * getComponents(static_cast<Attribute>(i)) * sizeof(float));
+  }
+
+  std::vector<float> positions(2 * stars.size());
+  std::vector<float> distances(stars.size());
+  std::vector<float> colors(3 * stars.size());
+  std::vector<float> magnitudes(stars.size());
+
+  for (std::size_t i = 0; i < stars.size(); ++i) {
+    Star const& star = stars[i];
+
+    // use B and V magnitude to retrieve the according color
+    const float minIdx(-0.4F);
+    const float maxIdx(2.0F);
+    const float step(0.05F);
+    float       bvIndex = std::min(maxIdx, std::max(minIdx, star.mBMagnitude - star.mVMagnitude));
+    float       normalizedIndex = (bvIndex - minIdx) / (maxIdx - minIdx) / step + 0.5F;
+    VistaColor  color           = sSpectralColors.at(static_cast<int>(normalizedIndex));
+
+    // distance in parsec --- some have parallax of zero; assume a
+    // large distance in those cases
+    float fDist = 100000.F;
+
+    if (star.mParallax > 0.F) {
+      fDist = 1000.F / star.mParallax;
+    }
+
+    positions[2 * i]     = star.mDeclination;
+    positions[2 * i + 1] = star.mAscension;
+    distances[i]         = fDist;
+    colors[3 * i]        = color.GetRed();
+    colors[3 * i + 1]    = color.GetGreen();
+    colors[3 * i + 2]    = color.GetBlue();
+    magnitudes[i]        = star.mVMagnitude - 5.F * std::log10(fDist / 10.F);
+  }
+
+  // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+  std::unique_ptr<StarCatalog> catalog(new StarCatalog());
+
+  catalog->mBuffer.resize(size);
+  std::memcpy(catalog->mBuffer.data(), &header, sizeof(Header));
+  catalog->init(catalog->mBuffer.data(), catalog->mBuffer.size());
+
+  auto copy = [&catalog](Attribute attribute, std::vector<float> const& values) {
+    std::memcpy(catalog->mBuffer.data() + catalog->getOffset(attribute), values.data(),
+        values.size() * sizeof(float));
+  };
+
+  copy(Attribute::ePosition, positions);
+  copy(Attribute::eDistance, distances);
+  copy(Attribute::eColor, colors);
+  copy(Attribute::eMagnitude, magnitudes);
+
+  return catalog;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::uint32_t StarCatalog::getCatalogMask(std::map<CatalogType, std::string> const& catalogs) {
+  std::uint32_t mask = 0;
+  for (auto const& catalog : catalogs) {
+    mask |= 1U << cs::utils::enumCast(catalog.first);
+  }
+  return mask;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::stars
@@ -0,0 +1,149 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_STARS_STAR_CATALOG_HPP
+#define CSP_STARS_STAR_CATALOG_HPP
+
+#include "../../../src/cs-utils/utils.hpp"
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace csp::stars {
+
+/// The StarCatalog contains the vertex data of all stars which are drawn by the Stars class. The
+/// data is stored as a structure of arrays: There is one tightly packed array of floats for each
+/// vertex attribute. The in-memory layout is exactly the layout of the binary cache file, so a
+/// cache file is simply memory-mapped and can be uploaded to a vertex buffer object as a whole,
+/// without any parsing or copying.
+///
+/// The binary file starts with a header containing a magic number, the format version, the
+/// catalogs the stars were loaded from, the number of stars and the offset of each attribute array
+/// in bytes. All values are stored in the native byte order.
+class StarCatalog {
+ public:
+  /// The supported catalog Types.
+  /// Hipparcos and Tycho can be obtained from:
+  ///    http://cdsarc.u-strasbg.fr/viz-bin/Cat?cat=I%2F239
+  /// Tycho2 can be obtained from:
+  ///    http://cdsarc.u-strasbg.fr/cgi-bin/myqcat3?I/259/
+  enum class CatalogType { eHipparcos = 0, eTycho, eTycho2, eCount };
+
+  /// The required columns of each catalog. The position of each column in each catalog is
+  /// configured with the static member cColumnMapping at the bottom of this file.
+  enum class CatalogColumn {
+    eVmag = 0, ///< visual magnitude
+    eBmag,     ///< blue magnitude
+    ePara,     ///< trigonometric parallax
+    eRect,     ///< rectascension
+    eDecl,     ///< declination
+    eHipp,     ///< hipparcos number
+    eCount
+  };
+
+  /// The vertex attributes of the stars.
+  enum class Attribute {
+    ePosition = 0, ///< declination and ascension in radians (2 floats)
+    eDistance,     ///< distance in parsec (1 float)
+    eColor,        ///< linear RGB color derived from the B-V index (3 floats)
+    eMagnitude,    ///< absolute magnitude (1 float)
+    eCount
+  };
+
+  /// Increase this if the binary format changed and is incompatible now. This will force a reload
+  /// from the text catalogs.
+  static const std::uint32_t cVersion;
+
+  /// Parses the given text catalogs. Hipparcos and any of Tycho or Tycho2 can be loaded together,
+  /// stars which are in both catalogs will be loaded from Hipparcos. Each catalog is split into
+  /// chunks of lines which are parsed in parallel.
+  static std::unique_ptr<StarCatalog> fromText(std::map<CatalogType, std::string> const& catalogs);
+
+  /// Memory-maps the given binary file. Returns nullptr if the file does not exist, has an
+  /// incompatible version or has been created from other catalogs.
+  static std::unique_ptr<StarCatalog> load(
+      std::string const& fileName, std::map<CatalogType, std::string> const& catalogs);
+
+  StarCatalog(StarCatalog const& other) = delete;
+  StarCatalog(StarCatalog&& other)      = delete;
+
+  StarCatalog& operator=(StarCatalog const& other) = delete;
+  StarCatalog& operator=(StarCatalog&& other) = delete;
+
+  ~StarCatalog();
+
+  /// Writes the catalog to the given file, it can be loaded again with load(). Returns false if
+  /// the file could not be written.
+  bool save(std::string const& fileName) const;
+
+  std::size_t getStarCount() const;
+
+  /// The entire catalog including the file header. This is what should be uploaded to the GPU.
+  void const* getData() const;
+  std::size_t getDataSize() const;
+
+  /// The offset of the given attribute array relative to getData() in bytes.
+  std::size_t getOffset(Attribute attribute) const;
+
+  /// The number of floats per star of the given attribute.
+  static int getComponents(Attribute attribute);
+
+  /// Returns a pointer to the first value of the given attribute array.
+  float const* getAttribute(Attribute attribute) const;
+
+ private:
+  class MappedFile;
+
+  /// Data structure of one record from a star catalog.
+  struct Star {
+    float mVMagnitude;
+    float mBMagnitude;
+    float mAscension;
+    float mDeclination;
+    float mParallax;
+  };
+
+  static constexpr std::size_t NUM_CATALOGS   = cs::utils::enumCast(CatalogType::eCount);
+  static constexpr std::size_t NUM_COLUMNS    = cs::utils::enumCast(CatalogColumn::eCount);
+  static constexpr std::size_t NUM_ATTRIBUTES = cs::utils::enumCast(Attribute::eCount);
+
+  StarCatalog() = default;
+
+  // Reads the header of the given data and checks whether the attribute arrays are within the
+  // data. Returns false if the data is not a valid catalog of the current version.
+  bool init(void const* data, std::size_t size);
+
+  static bool readTextCatalog(CatalogType type, std::string const& fileName,
+      bool skipHipparcosStars, std::vector<Star>& stars);
+
+  static std::vector<Star> parseLines(
+      char const* begin, char const* end, CatalogType type, bool skipHipparcosStars);
+
+  // Computes the vertex attributes of the given stars.
+  static std::unique_ptr<StarCatalog> create(
+      std::vector<Star> const& stars, std::uint32_t catalogs);
+
+  static std::uint32_t getCatalogMask(std::map<CatalogType, std::string> const& catalogs);
+
+  std::vector<std::uint8_t>   mBuffer;
+  std::unique_ptr<MappedFile> mFile;
+
+  std::uint8_t const*                     mData{};
+  std::size_t                             mDataSize{};
+  std::size_t                             mStarCount{};
+  std::uint32_t                           mCatalogs{};
+  std::array<std::size_t, NUM_ATTRIBUTES> mOffsets{};
+
+  static const std::array<std::array<int, NUM_COLUMNS>, NUM_CATALOGS> cColumnMapping;
+};
+
+} // namespace csp::stars
+
+#endif // CSP_STARS_STAR_CATALOG_HPP
@@ -8,14 +8,10 @@
 
 #include "logger.hpp"
 
-#include "../../../src/cs-graphics/TextureLoader.hpp"
-
 #ifdef _WIN32
 #include <Windows.h>
 #endif
 
-#include <VistaInterProcComm/Connections/VistaByteBufferDeSerializer.h>
-#include <VistaInterProcComm/Connections/VistaByteBufferSerializer.h>
 #include <VistaKernel/GraphicsManager/VistaGeometryFactory.h>
 #include <VistaKernel/GraphicsManager/VistaOpenGLNode.h>
 #include <VistaKernel/GraphicsManager/VistaSceneGraph.h>
@@ -27,58 +23,16 @@
 #include <VistaTools/tinyXML/tinyxml.h>
 
 #include <array>
-#include <fstream>
+#include <utility>
 
 namespace csp::stars {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-namespace {
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
-template <typename T>
-bool fromString(std::string const& v, T& out) {
-  std::istringstream iss(v);
-  iss >> out;
-  return (iss.rdstate() & std::stringstream::failbit) == 0;
+Stars::Stars(std::shared_ptr<cs::graphics::AsyncTextureLoader> textureLoader)
+    : mTextureLoader(std::move(textureLoader)) {
 }
 
-// spectral colors from B-V index -0.4 to 2.0 in steps of 0.05
-// values from  http://www.vendian.org/mncharity/dir3/starcolor/details.html
-// NOLINTNEXTLINE(cert-err58-cpp)
-const std::array sSpectralColors = {VistaColor(0x9bb2ff), VistaColor(0x9eb5ff),
-    VistaColor(0xa3b9ff), VistaColor(0xaabfff), VistaColor(0xb2c5ff), VistaColor(0xbbccff),
-    VistaColor(0xc4d2ff), VistaColor(0xccd8ff), VistaColor(0xd3ddff), VistaColor(0xdae2ff),
-    VistaColor(0xdfe5ff), VistaColor(0xe4e9ff), VistaColor(0xe9ecff), VistaColor(0xeeefff),
-    VistaColor(0xf3f2ff), VistaColor(0xf8f6ff), VistaColor(0xfef9ff), VistaColor(0xfff9fb),
-    VistaColor(0xfff7f5), VistaColor(0xfff5ef), VistaColor(0xfff3ea), VistaColor(0xfff1e5),
-    VistaColor(0xffefe0), VistaColor(0xffeddb), VistaColor(0xffebd6), VistaColor(0xffe8ce),
-    VistaColor(0xffe6ca), VistaColor(0xffe5c6), VistaColor(0xffe3c3), VistaColor(0xffe2bf),
-    VistaColor(0xffe0bb), VistaColor(0xffdfb8), VistaColor(0xffddb4), VistaColor(0xffdbb0),
-    VistaColor(0xffdaad), VistaColor(0xffd8a9), VistaColor(0xffd6a5), VistaColor(0xffd29c),
-    VistaColor(0xffd096), VistaColor(0xffcc8f), VistaColor(0xffc885), VistaColor(0xffc178),
-    VistaColor(0xffb765), VistaColor(0xffa94b), VistaColor(0xff9523), VistaColor(0xff7b00),
-    VistaColor(0xff5200)};
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
-} // namespace
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
-const std::array<std::array<int, Stars::NUM_COLUMNS>, Stars::NUM_CATALOGS> Stars::cColumnMapping{
-    std::array{34, 32, 11, 8, 9, 31}, // CatalogType::eHipparcos
-    std::array{34, 32, 11, 8, 9, 31}, // CatalogType::eTycho
-    std::array{19, 17, -1, 2, 3, 23}  // CatalogType::eTycho2
-};
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
-// Increase this if the cache format changed and is incompatible now. This will
-// force a reload.
-const int Stars::cCacheVersion = 3;
-
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void Stars::setCatalogs(std::map<Stars::CatalogType, std::string> catalogs) {
@@ -86,42 +40,21 @@ void Stars::setCatalogs(std::map<Stars::CatalogType, std::string> catalogs) {
 
     mCatalogs = std::move(catalogs);
 
-    // Clear stars first.
-    mStars.clear();
-
     // Read star catalogs.
-    if (!readStarCache(mCacheFile)) {
-      std::map<CatalogType, std::string>::const_iterator it;
+    auto catalog = StarCatalog::load(mCacheFile, mCatalogs);
 
-      it = mCatalogs.find(CatalogType::eHipparcos);
-      if (it != mCatalogs.end()) {
-        readStarsFromCatalog(it->first, it->second);
-      }
-
-      it = mCatalogs.find(CatalogType::eTycho);
-      if (it != mCatalogs.end()) {
-        readStarsFromCatalog(it->first, it->second);
-      }
-
-      it = mCatalogs.find(CatalogType::eTycho2);
-      if (it != mCatalogs.end()) {
-        // do not load tycho and tycho 2
-        if (mCatalogs.find(CatalogType::eTycho) == mCatalogs.end()) {
-          readStarsFromCatalog(it->first, it->second);
-        } else {
-          logger().warn("Failed to load Tycho2 catalog: Tycho already loaded!");
-        }
-      }
+    if (!catalog) {
+      catalog = StarCatalog::fromText(mCatalogs);
 
-      if (!mStars.empty()) {
-        writeStarCache(mCacheFile);
+      if (catalog->getStarCount() > 0) {
+        catalog->save(mCacheFile);
       } else {
         logger().warn("Loaded no stars! Stars will not work properly.");
       }
     }
 
-    // Create buffers,
-    buildStarVAO();
+    // Create buffers. The catalog is not needed anymore afterwards.
+    buildStarVAO(*catalog);
     buildBackgroundVAO();
   }
 }
@@ -254,7 +187,7 @@ void Stars::setStarTexture(std::string const& filename) {
     if (filename.empty()) {
       mStarTexture.reset();
     } else {
-      mStarTexture = cs::graphics::TextureLoader::loadFromFile(filename);
+      mStarTexture = mTextureLoader->loadFromFile(filename);
     }
   }
 }
@@ -267,7 +200,7 @@ void Stars::setCelestialGridTexture(std::string const& filename) {
     if (filename.empty()) {
       mCelestialGridTexture.reset();
     } else {
-      mCelestialGridTexture = cs::graphics::TextureLoader::loadFromFile(filename);
+      mCelestialGridTexture = mTextureLoader->loadFromFile(filename);
     }
   }
 }
@@ -280,7 +213,7 @@ void Stars::setStarFiguresTexture(std::string const& filename) {
     if (filename.empty()) {
       mStarFiguresTexture.reset();
     } else {
-      mStarFiguresTexture = cs::graphics::TextureLoader::loadFromFile(filename);
+      mStarFiguresTexture = mTextureLoader->loadFromFile(filename);
     }
   }
 }
@@ -342,9 +275,15 @@ bool Stars::Do() {
     mShaderDirty = false;
   }
 
+  // The skydome images are blended additively, so the placeholder of a texture which is still being
+  // loaded would brighten the entire sky.
+  bool drawCelestialGrid =
+      mCelestialGridTexture && mCelestialGridTexture->isReady() && mBackgroundColor1[3] != 0.F;
+  bool drawStarFigures =
+      mStarFiguresTexture && mStarFiguresTexture->isReady() && mBackgroundColor2[3] != 0.F;
+
   // draw background
-  if ((mCelestialGridTexture && mBackgroundColor1[3] != 0.F) ||
-      (mStarFiguresTexture && mBackgroundColor2[3] != 0.F)) {
+  if (drawCelestialGrid || drawStarFigures) {
     mBackgroundVAO.Bind();
     mBackgroundShader.Bind();
     mBackgroundShader.SetUniform(mBackgroundShader.GetUniformLocation("iTexture"), 0);
@@ -372,28 +311,36 @@ bool Stars::Do() {
     loc = mBackgroundShader.GetUniformLocation("uInvMV");
     glUniformMatrix4fv(loc, 1, GL_FALSE, matInverseMV.GetData());
 
-    if (mCelestialGridTexture && mBackgroundColor1[3] != 0.F) {
+    if (drawCelestialGrid) {
       mBackgroundShader.SetUniform(mBackgroundShader.GetUniformLocation("cColor"),
           mBackgroundColor1[0], mBackgroundColor1[1], mBackgroundColor1[2],
           mBackgroundColor1[3] * backgroundIntensity);
-      mCelestialGridTexture->Bind(GL_TEXTURE0);
+      mCelestialGridTexture->get()->Bind(GL_TEXTURE0);
       glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-      mCelestialGridTexture->Unbind(GL_TEXTURE0);
+      mCelestialGridTexture->get()->Unbind(GL_TEXTURE0);
     }
 
-    if (mStarFiguresTexture && mBackgroundColor2[3] != 0.F) {
+    if (drawStarFigures) {
       mBackgroundShader.SetUniform(mBackgroundShader.GetUniformLocation("cColor"),
           mBackgroundColor2[0], mBackgroundColor2[1], mBackgroundColor2[2],
           mBackgroundColor2[3] * backgroundIntensity);
-      mStarFiguresTexture->Bind(GL_TEXTURE0);
+      mStarFiguresTexture->get()->Bind(GL_TEXTURE0);
       glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-      mStarFiguresTexture->Unbind(GL_TEXTURE0);
+      mStarFiguresTexture->get()->Unbind(GL_TEXTURE0);
     }
 
     mBackgroundShader.Release();
     mBackgroundVAO.Release();
   }
 
+  // In sprite mode, the stars are drawn with the star texture. They are skipped until it has been
+  // loaded, as its placeholder would turn them into squares.
+  if (mDrawMode == DrawMode::eSprite && !mStarTexture->isReady()) {
+    glDepthMask(GL_TRUE);
+    glPopAttrib();
+    return true;
+  }
+
   // draw stars
   mStarVAO.Bind();
   mStarShader.Bind();
@@ -416,7 +363,7 @@ bool Stars::Do() {
   mStarShader.SetUniform(mStarShader.GetUniformLocation("uResolution"),
       static_cast<float>(viewport.at(2)), static_cast<float>(viewport.at(3)));
 
-  mStarTexture->Bind(GL_TEXTURE0);
+  mStarTexture->get()->Bind(GL_TEXTURE0);
   mStarShader.SetUniform(mStarShader.GetUniformLocation("uStarTexture"), 0);
   mStarShader.SetUniform(mStarShader.GetUniformLocation("uMinMagnitude"), mMinMagnitude);
   mStarShader.SetUniform(mStarShader.GetUniformLocation("uMaxMagnitude"), mMaxMagnitude);
@@ -439,9 +386,9 @@ bool Stars::Do() {
   loc = mStarShader.GetUniformLocation("uInvP");
   glUniformMatrix4fv(loc, 1, GL_FALSE, matInverseP.GetData());
 
-  glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(mStars.size()));
+  glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(mStarCount));
 
-  mStarTexture->Unbind(GL_TEXTURE0);
+  mStarTexture->get()->Unbind(GL_TEXTURE0);
 
   mStarShader.Release();
   mStarVAO.Release();
@@ -467,276 +414,25 @@ bool Stars::GetBoundingBox(VistaBoundingBox& oBoundingBox) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-bool Stars::readStarsFromCatalog(CatalogType type, std::string const& filename) {
-  bool success = false;
-  logger().info("Reading star catalog '{}'.", filename);
-
-  std::ifstream file;
-
-  try {
-    file.open(filename.c_str(), std::ifstream::in);
-  } catch (std::exception& e) {
-    logger().error("Failed to open catalog file '{}': {}", filename, e.what());
-  }
-
-  if (file.is_open()) {
-    int  lineCount = 0;
-    bool loadHipparcos(mCatalogs.find(CatalogType::eHipparcos) != mCatalogs.end());
-
-    // read line by line
-    while (!file.eof()) {
-      // get line
-      ++lineCount;
-      std::string line;
-      getline(file, line);
-
-      // parse line:
-      // separate complete items consisting of "val0|val1|...|valN|" into vector of value
-      // strings
-      std::stringstream        stream(line);
-      std::string              item;
-      std::vector<std::string> items;
-
-      while (getline(stream, item, '|')) {
-        items.emplace_back(item);
-      }
-
-      // convert value strings to int/double/float and save in star data structure
-      // expecting Hipparcos or Tycho-1 catalog and more than 12 columns
-      if (items.size() > 12) {
-        // skip if part of hipparcos catalogue
-        int tmp{};
-        if (type != CatalogType::eHipparcos && loadHipparcos &&
-            fromString<int>(items[cColumnMapping.at(cs::utils::enumCast(type))
-                                      .at(cs::utils::enumCast(CatalogColumn::eHipp))],
-                tmp)) {
-          continue;
-        }
-
-        // store star data
-        bool successStoreData(true);
-
-        Star star{};
-        successStoreData &= fromString<float>(
-            items[cColumnMapping.at(
-                cs::utils::enumCast(type))[cs::utils::enumCast(CatalogColumn::eVmag)]],
-            star.mVMagnitude);
-        successStoreData &= fromString<float>(
-            items[cColumnMapping.at(
-                cs::utils::enumCast(type))[cs::utils::enumCast(CatalogColumn::eBmag)]],
-            star.mBMagnitude);
-        successStoreData &= fromString<float>(
-            items[cColumnMapping.at(
-                cs::utils::enumCast(type))[cs::utils::enumCast(CatalogColumn::eRect)]],
-            star.mAscension);
-        successStoreData &= fromString<float>(
-            items[cColumnMapping.at(
-                cs::utils::enumCast(type))[cs::utils::enumCast(CatalogColumn::eDecl)]],
-            star.mDeclination);
-
-        if (cColumnMapping.at(
-                cs::utils::enumCast(type))[cs::utils::enumCast(CatalogColumn::ePara)] > 0) {
-          if (!fromString<float>(items[cColumnMapping.at(cs::utils::enumCast(type))
-                                           .at(cs::utils::enumCast(CatalogColumn::ePara))],
-                  star.mParallax)) {
-            star.mParallax = 0;
-          }
-        } else {
-          star.mParallax = 0;
-        }
-
-        if (successStoreData) {
-          star.mAscension   = (360.F + 90.F - star.mAscension) / 180.F * Vista::Pi;
-          star.mDeclination = star.mDeclination / 180.F * Vista::Pi;
-
-          mStars.emplace_back(star);
-        }
-      }
-
-      // print progress status
-      if (mStars.size() % 10000 == 0) {
-        logger().info("Read {} stars so far...", mStars.size());
-      }
-    }
-    file.close();
-    success = true;
-
-    logger().info("Read a total of {} stars.", mStars.size());
-  } else {
-    logger().error("Failed to load stars: Cannot open catalog file '{}'!", filename);
-  }
-
-  return success;
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
-void Stars::writeStarCache(const std::string& sCacheFile) const {
-  VistaType::uint32 catalogs = 0;
-  for (auto const& mCatalog : mCatalogs) {
-    catalogs += static_cast<uint32_t>(std::pow(2, static_cast<int>(mCatalog.first)));
-  }
-
-  VistaByteBufferSerializer serializer;
-  serializer.WriteInt32(
-      static_cast<VistaType::uint32>(cCacheVersion)); // cache format version number
-  serializer.WriteInt32(catalogs);                    // cache format version number
-  serializer.WriteInt32(static_cast<VistaType::uint32>(
-      mStars.size())); // write number of stars to front of byte stream
-
-  for (const auto& mStar : mStars) {
-    // serialize star data into byte stream
-    serializer.WriteFloat32(mStar.mVMagnitude);
-    serializer.WriteFloat32(mStar.mBMagnitude);
-    serializer.WriteFloat32(mStar.mAscension);
-    serializer.WriteFloat32(mStar.mDeclination);
-    serializer.WriteFloat32(mStar.mParallax);
-  }
-
-  // open file
-  std::ofstream file;
-  file.open(sCacheFile.c_str(), std::ios::out | std::ios::binary);
-  if (file.is_open()) {
-    // write serialized star data
-    logger().info("Writing {} stars ({} bytes) into '{}'.", mStars.size(),
-        serializer.GetBufferSize(), sCacheFile);
-
-    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-    file.write(reinterpret_cast<const char*>(serializer.GetBuffer()), serializer.GetBufferSize());
-    file.close();
-  } else {
-    logger().error(
-        "Failed to write binary star data: Cannot open file '{}' for writing!", sCacheFile);
-  }
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
-bool Stars::readStarCache(const std::string& sCacheFile) {
-  bool success = false;
-
-  // open file
-  std::ifstream file;
-  file.open(sCacheFile.c_str(),
-      std::ios::in | std::ios::binary | std::ios::ate); // ate = set read pointer to end
-  if (file.is_open()) {
-
-    // read binary data from file
-    int                          size = static_cast<int>(file.tellg());
-    std::vector<VistaType::byte> data(size);
-
-    // set read pointer to the beginning of file stream
-    file.seekg(0, std::ios::beg);
-
-    // read file stream into char array 'data'
-    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-    file.read(reinterpret_cast<char*>(&data[0]), size);
-    file.close();
-
-    // de-serialize byte stream
-    VistaType::uint32 cacheVersion = 0;
-    VistaType::uint32 catalogs     = 0;
-    VistaType::uint32 numStars     = 0;
-
-    VistaByteBufferDeSerializer deserializer;
-    deserializer.SetBuffer(&data[0], size); // prepare for de-serialization
-    deserializer.ReadInt32(cacheVersion);   // read cache format version number
-    deserializer.ReadInt32(catalogs);       // read which catalogs were loaded
-    deserializer.ReadInt32(numStars);       // read number of stars from front of byte stream
-
-    if (cacheVersion != cCacheVersion) {
-      return false;
-    }
-
-    VistaType::uint32 catalogsToLoad = 0;
-    for (const auto& mCatalog : mCatalogs) {
-      catalogsToLoad += static_cast<uint32_t>(std::pow(2, static_cast<int>(mCatalog.first)));
-    }
-
-    if (catalogs != catalogsToLoad) {
-      return false;
-    }
-
-    for (unsigned int num = 0; num < numStars; ++num) {
-      Star star{};
-      deserializer.ReadFloat32(star.mVMagnitude);
-      deserializer.ReadFloat32(star.mBMagnitude);
-      deserializer.ReadFloat32(star.mAscension);
-      deserializer.ReadFloat32(star.mDeclination);
-      deserializer.ReadFloat32(star.mParallax);
-
-      mStars.emplace_back(star);
-
-      // print progress status
-      if (mStars.size() % 100000 == 0) {
-        logger().info("Read {} stars so far...", mStars.size());
-      }
-    }
-
-    success = true;
-
-    logger().info("Read a total of {} stars.", mStars.size());
-  }
+void Stars::buildStarVAO(StarCatalog const& catalog) {
+  mStarCount = catalog.getStarCount();
 
-  return success;
-}
+  // The catalog already has the layout of the vertex buffer, so it is uploaded as a whole.
+  mStarVBO.Bind(GL_ARRAY_BUFFER);
+  mStarVBO.BufferData(catalog.getDataSize(), catalog.getData(), GL_STATIC_DRAW);
+  mStarVBO.Release();
 
-////////////////////////////////////////////////////////////////////////////////////////////////////
+  // star positions, star distances, color and magnitude
+  std::array attributes{StarCatalog::Attribute::ePosition, StarCatalog::Attribute::eDistance,
+      StarCatalog::Attribute::eColor, StarCatalog::Attribute::eMagnitude};
 
-void Stars::buildStarVAO() {
-  int                c(0);
-  const int          iElementCount(7);
-  std::vector<float> data(iElementCount * mStars.size());
-
-  for (auto it = mStars.begin(); it != mStars.end(); ++it, c += iElementCount) {
-    // use B and V magnitude to retrieve the according color
-    const float minIdx(-0.4F);
-    const float maxIdx(2.0F);
-    const float step(0.05F);
-    float       bvIndex = std::min(maxIdx, std::max(minIdx, it->mBMagnitude - it->mVMagnitude));
-    float       normalizedIndex = (bvIndex - minIdx) / (maxIdx - minIdx) / step + 0.5F;
-    VistaColor  color           = sSpectralColors.at(static_cast<int>(normalizedIndex));
-
-    // distance in parsec --- some have parallax of zero; assume a
-    // large distance in those cases
-    float fDist = 100000.F;
-
-    if (it->mParallax > 0.F) {
-      fDist = 1000.F / it->mParallax;
-    }
+  for (std::size_t i = 0; i < attributes.size(); ++i) {
+    int components = StarCatalog::getComponents(attributes.at(i));
 
-    data[c]     = it->mDeclination;
-    data[c + 1] = it->mAscension;
-    data[c + 2] = fDist;
-    data[c + 3] = color.GetRed();
-    data[c + 4] = color.GetGreen();
-    data[c + 5] = color.GetBlue();
-    data[c + 6] = it->mVMagnitude - 5.F * std::log10(fDist / 10.F);
+    mStarVAO.EnableAttributeArray(static_cast<GLuint>(i));
+    mStarVAO.SpecifyAttributeArrayFloat(static_cast<GLuint>(i), components, GL_FLOAT, GL_FALSE,
+        components * sizeof(float), catalog.getOffset(attributes.at(i)), &mStarVBO);
   }
-
-  mStarVBO.Bind(GL_ARRAY_BUFFER);
-  mStarVBO.BufferData(iElementCount * mStars.size() * sizeof(float), data.data(), GL_STATIC_DRAW);
-  mStarVBO.Release();
-
-  // star positions
-  mStarVAO.EnableAttributeArray(0);
-  mStarVAO.SpecifyAttributeArrayFloat(
-      0, 2, GL_FLOAT, GL_FALSE, iElementCount * sizeof(float), 0, &mStarVBO);
-
-  // star distances
-  mStarVAO.EnableAttributeArray(1);
-  mStarVAO.SpecifyAttributeArrayFloat(
-      1, 1, GL_FLOAT, GL_FALSE, iElementCount * sizeof(float), 2 * sizeof(float), &mStarVBO);
-
-  // color
-  mStarVAO.EnableAttributeArray(2);
-  mStarVAO.SpecifyAttributeArrayFloat(
-      2, 3, GL_FLOAT, GL_FALSE, iElementCount * sizeof(float), 3 * sizeof(float), &mStarVBO);
-
-  // magnitude
-  mStarVAO.EnableAttributeArray(3);
-  mStarVAO.SpecifyAttributeArrayFloat(
-      3, 1, GL_FLOAT, GL_FALSE, iElementCount * sizeof(float), 6 * sizeof(float), &mStarVBO);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
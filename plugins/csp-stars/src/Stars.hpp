@@ -14,7 +14,9 @@
 #include <VistaOGLExt/VistaTexture.h>
 #include <VistaOGLExt/VistaVertexArrayObject.h>
 
+#include "../../../src/cs-graphics/AsyncTextureLoader.hpp"
 #include "../../../src/cs-utils/utils.hpp"
+#include "StarCatalog.hpp"
 
 #include <map>
 #include <memory>
@@ -28,32 +30,20 @@ namespace csp::stars {
 /// information such as a constellations or grid lines.
 class Stars : public IVistaOpenGLDraw {
  public:
-  /// The supported catalog Types.
-  /// Hipparcos and Tycho can be obtained from:
-  ///    http://cdsarc.u-strasbg.fr/viz-bin/Cat?cat=I%2F239
-  /// Tycho2 can be obtained from:
-  ///    http://cdsarc.u-strasbg.fr/cgi-bin/myqcat3?I/259/
-  enum class CatalogType { eHipparcos = 0, eTycho, eTycho2, eCount };
-
-  /// The required columns of each catalog. The position of each column in each catalog is
-  /// configured with the static member COLUMN_MAPPING at the bottom of this file.
-  enum class CatalogColumn {
-    eVmag = 0, ///< visual magnitude
-    eBmag,     ///< blue magnitude
-    ePara,     ///< trigonometric parallax
-    eRect,     ///< rectascension
-    eDecl,     ///< declination
-    eHipp,     ///< hipparcos number
-    eCount
-  };
+  /// The supported catalog Types, see StarCatalog::CatalogType.
+  using CatalogType = StarCatalog::CatalogType;
 
   enum class DrawMode { ePoint, eSmoothPoint, eDisc, eSmoothDisc, eSprite };
 
+  /// The textures are loaded in the background with the given loader. The skydome images, and the
+  /// stars in DrawMode::eSprite, are not drawn until their textures have been uploaded.
+  explicit Stars(std::shared_ptr<cs::graphics::AsyncTextureLoader> textureLoader);
+
   /// It is possible to load multiple catalogs, currently Hipparcos and any of Tycho or Tycho2 can
   /// be loaded together. Stars which are in both catalogs will be loaded from Hipparcos. Once
   /// loaded, the stars will be written to a binary cache file. Subsequent instantiations of this
-  /// class with the same call to setCatalogs() will use the stars from the cache file rather from
-  /// the catalogs.
+  /// class with the same call to setCatalogs() will memory-map the cache file rather than parsing
+  /// the catalogs, see StarCatalog.
   void setCatalogs(std::map<CatalogType, std::string> catalogs);
   std::map<CatalogType, std::string> const& getCatalogs() const;
 
@@ -115,36 +105,19 @@ class Stars : public IVistaOpenGLDraw {
   bool GetBoundingBox(VistaBoundingBox& oBoundingBox) override;
 
  private:
-  /// Data structure of one record from star catalog.
-  struct Star {
-    float mVMagnitude;
-    float mBMagnitude;
-    float mAscension;
-    float mDeclination;
-    float mParallax;
-  };
-
-  /// Reads star data from binary file.
-  bool readStarsFromCatalog(CatalogType type, std::string const& filename);
-
-  /// Writes internal star data read from catalog into a binary file.
-  void writeStarCache(const std::string& cacheFile) const;
-
-  /// Reads star data from binary file.
-  bool readStarCache(const std::string& cacheFile);
-
-  /// Build vertex array objects from given star list.
-  void buildStarVAO();
+  /// Uploads the vertex data of the given catalog to the GPU.
+  void buildStarVAO(StarCatalog const& catalog);
   void buildBackgroundVAO();
 
-  std::unique_ptr<VistaTexture> mStarTexture;
-  std::string                   mStarTextureFile;
+  std::shared_ptr<cs::graphics::AsyncTextureLoader>                mTextureLoader;
+  std::shared_ptr<cs::graphics::AsyncTextureLoader::Texture const> mStarTexture;
+  std::string                                                      mStarTextureFile;
 
-  std::unique_ptr<VistaTexture> mCelestialGridTexture;
-  std::string                   mCelestialGridTextureFile;
+  std::shared_ptr<cs::graphics::AsyncTextureLoader::Texture const> mCelestialGridTexture;
+  std::string                                                      mCelestialGridTextureFile;
 
-  std::unique_ptr<VistaTexture> mStarFiguresTexture;
-  std::string                   mStarFiguresTextureFile;
+  std::shared_ptr<cs::graphics::AsyncTextureLoader::Texture const> mStarFiguresTexture;
+  std::string                                                      mStarFiguresTextureFile;
 
   std::string mCacheFile = "star_cache.dat";
 
@@ -157,7 +130,7 @@ class Stars : public IVistaOpenGLDraw {
   VistaVertexArrayObject mBackgroundVAO;
   VistaBufferObject      mBackgroundVBO;
 
-  std::vector<Star>                  mStars;
+  std::size_t                        mStarCount = 0;
   std::map<CatalogType, std::string> mCatalogs;
 
   DrawMode mDrawMode = DrawMode::eSmoothDisc;
@@ -169,13 +142,6 @@ class Stars : public IVistaOpenGLDraw {
   float mMaxMagnitude           = 15.F;
   float mLuminanceMultiplicator = 1.F;
 
-  static const int cCacheVersion;
-
-  static constexpr size_t NUM_CATALOGS = cs::utils::enumCast(CatalogType::eCount);
-  static constexpr size_t NUM_COLUMNS  = cs::utils::enumCast(CatalogColumn::eCount);
-
-  static const std::array<std::array<int, NUM_COLUMNS>, NUM_CATALOGS> cColumnMapping;
-
   static const char* cStarsSnippets;
   static const char* cStarsVertOnePixel;
   static const char* cStarsFragOnePixel;
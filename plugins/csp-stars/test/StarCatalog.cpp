@@ -0,0 +1,371 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "../src/StarCatalog.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+#include "../src/logger.hpp"
+
+#include <VistaInterProcComm/Connections/VistaByteBufferDeSerializer.h>
+#include <VistaInterProcComm/Connections/VistaByteBufferSerializer.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <glm/gtc/constants.hpp>
+#include <map>
+#include <sstream>
+
+namespace csp::stars {
+
+namespace {
+
+using CatalogType = StarCatalog::CatalogType;
+using Attribute   = StarCatalog::Attribute;
+
+char const* const HIPPARCOS_FILE = "./testHipparcos.dat";
+char const* const TYCHO2_FILE    = "./testTycho2.dat";
+char const* const CACHE_FILE     = "./testStarCache.dat";
+
+// Every tenth star of the synthetic Tycho2 catalog is also part of the Hipparcos catalog.
+int const HIPPARCOS_INTERVAL = 10;
+
+// Writes a catalog with count lines. Each line consists of columns separated by '|', the given
+// function fills the columns of each line.
+void writeCatalog(std::string const& fileName, int count, int columns,
+    std::function<void(int, std::vector<std::string>&)> const& fillLine) {
+  std::ofstream file(fileName);
+
+  for (int i = 0; i < count; ++i) {
+    std::vector<std::string> items(columns);
+    fillLine(i, items);
+
+    for (auto const& item : items) {
+      file << item << '|';
+    }
+    file << '\n';
+  }
+}
+
+// The synthetic stars have deterministic values which depend on their index only.
+float getAscension(int i) {
+  return static_cast<float>(i % 3600) * 0.1F;
+}
+
+float getDeclination(int i) {
+  return static_cast<float>(i % 1800) * 0.1F - 90.F;
+}
+
+float getMagnitude(int i) {
+  return static_cast<float>(i % 150) * 0.1F;
+}
+
+// Writes a catalog in the format of the Hipparcos catalog.
+void writeHipparcos(int count) {
+  writeCatalog(HIPPARCOS_FILE, count, 78, [](int i, std::vector<std::string>& items) {
+    items[8]  = std::to_string(getAscension(i));
+    items[9]  = std::to_string(getDeclination(i));
+    items[11] = std::to_string(1.0F + static_cast<float>(i % 100));
+    items[32] = std::to_string(getMagnitude(i) + 0.5F);
+    items[34] = std::to_string(getMagnitude(i));
+  });
+}
+
+// Writes a catalog in the format of the Tycho2 catalog. Some lines are malformed, they have no
+// visual magnitude or too few columns.
+void writeTycho2(int count) {
+  writeCatalog(TYCHO2_FILE, count, 32, [](int i, std::vector<std::string>& items) {
+    if (i % 1000 == 999) {
+      items.resize(5);
+    }
+
+    items[2] = "  " + std::to_string(getAscension(i));
+    items[3] = std::to_string(getDeclination(i));
+
+    if (items.size() > 19 && i % 1000 != 500) {
+      items[17] = std::to_string(getMagnitude(i) + 1.F);
+      items[19] = std::to_string(getMagnitude(i));
+    }
+
+    if (items.size() > 23 && i % HIPPARCOS_INTERVAL == 0) {
+      items[23] = std::to_string(i);
+    }
+  });
+}
+
+// Returns whether the star with the given index of the synthetic Tycho2 catalog is valid.
+bool isValidTycho2(int i) {
+  return i % 1000 != 999 && i % 1000 != 500;
+}
+
+// This is how Stars parsed the Tycho2 catalog before the StarCatalog was introduced. It is only
+// used as a baseline for the benchmark below.
+std::vector<std::array<float, 5>> legacyReadTycho2(std::string const& fileName) {
+  auto fromString = [](std::string const& v, float& out) {
+    std::istringstream iss(v);
+    iss >> out;
+    return (iss.rdstate() & std::stringstream::failbit) == 0;
+  };
+
+  std::vector<std::array<float, 5>> stars;
+  std::ifstream                     file(fileName);
+
+  while (!file.eof()) {
+    std::string line;
+    getline(file, line);
+
+    std::stringstream        stream(line);
+    std::string              item;
+    std::vector<std::string> items;
+
+    while (getline(stream, item, '|')) {
+      items.emplace_back(item);
+    }
+
+    if (items.size() > 23) {
+      std::array<float, 5> star{};
+      if (fromString(items[19], star[0]) && fromString(items[17], star[1]) &&
+          fromString(items[2], star[2]) && fromString(items[3], star[3])) {
+        star[2] = (360.F + 90.F - star[2]) / 180.F * glm::pi<float>();
+        star[3] = star[3] / 180.F * glm::pi<float>();
+        stars.emplace_back(star);
+      }
+    }
+  }
+
+  return stars;
+}
+
+// This is how Stars wrote its binary cache before the StarCatalog was introduced.
+void legacyWriteCache(std::string const& fileName, std::vector<std::array<float, 5>> const& stars) {
+  VistaByteBufferSerializer serializer;
+  serializer.WriteInt32(static_cast<VistaType::uint32>(3));
+  serializer.WriteInt32(static_cast<VistaType::uint32>(4));
+  serializer.WriteInt32(static_cast<VistaType::uint32>(stars.size()));
+
+  for (auto const& star : stars) {
+    for (float value : star) {
+      serializer.WriteFloat32(value);
+    }
+  }
+
+  std::ofstream file(fileName, std::ios::out | std::ios::binary);
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  file.write(reinterpret_cast<const char*>(serializer.GetBuffer()), serializer.GetBufferSize());
+}
+
+// This is how Stars read its binary cache and created its vertex data before the StarCatalog was
+// introduced. The color lookup is omitted.
+std::vector<float> legacyReadCache(std::string const& fileName) {
+  std::ifstream file(fileName, std::ios::in | std::ios::binary | std::ios::ate);
+
+  int                          size = static_cast<int>(file.tellg());
+  std::vector<VistaType::byte> data(size);
+  file.seekg(0, std::ios::beg);
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  file.read(reinterpret_cast<char*>(&data[0]), size);
+
+  VistaType::uint32 cacheVersion = 0;
+  VistaType::uint32 catalogs     = 0;
+  VistaType::uint32 numStars     = 0;
+
+  VistaByteBufferDeSerializer deserializer;
+  deserializer.SetBuffer(&data[0], size);
+  deserializer.ReadInt32(cacheVersion);
+  deserializer.ReadInt32(catalogs);
+  deserializer.ReadInt32(numStars);
+
+  std::vector<std::array<float, 5>> stars;
+  for (unsigned int num = 0; num < numStars; ++num) {
+    std::array<float, 5> star{};
+    for (float& value : star) {
+      deserializer.ReadFloat32(value);
+    }
+    stars.emplace_back(star);
+  }
+
+  std::vector<float> vertices;
+  for (auto const& star : stars) {
+    float dist = star[4] > 0.F ? 1000.F / star[4] : 100000.F;
+    vertices.insert(vertices.end(), {star[3], star[2], dist, 1.F, 1.F, 1.F,
+                                        star[0] - 5.F * std::log10(dist / 10.F)});
+  }
+
+  return vertices;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("csp::stars::StarCatalog") {
+  std::size_t const hipparcosCount = 1000;
+  int const         tycho2Count    = 20000;
+
+  writeHipparcos(static_cast<int>(hipparcosCount));
+  writeTycho2(tycho2Count);
+
+  // The number of valid stars in the Tycho2 catalog and how many of them are not in Hipparcos.
+  std::size_t validTycho2Count = 0;
+  std::size_t tycho2OnlyCount  = 0;
+
+  for (int i = 0; i < tycho2Count; ++i) {
+    if (isValidTycho2(i)) {
+      ++validTycho2Count;
+      tycho2OnlyCount += (i % HIPPARCOS_INTERVAL == 0) ? 0 : 1;
+    }
+  }
+
+  SUBCASE("Text catalogs are parsed correctly") {
+    auto catalog = StarCatalog::fromText({{CatalogType::eTycho2, TYCHO2_FILE}});
+
+    REQUIRE_EQ(catalog->getStarCount(), validTycho2Count);
+
+    auto const* positions  = catalog->getAttribute(Attribute::ePosition);
+    auto const* distances  = catalog->getAttribute(Attribute::eDistance);
+    auto const* magnitudes = catalog->getAttribute(Attribute::eMagnitude);
+
+    // The stars are in the order of the catalog.
+    std::size_t star = 0;
+    for (int i = 0; i < tycho2Count; ++i) {
+      if (!isValidTycho2(i)) {
+        continue;
+      }
+
+      float ascension   = (450.F - getAscension(i)) / 180.F * glm::pi<float>();
+      float declination = getDeclination(i) / 180.F * glm::pi<float>();
+
+      // The Tycho2 catalog contains no parallaxes, so all stars are far away.
+      CHECK_EQ(positions[2 * star], doctest::Approx(declination));
+      CHECK_EQ(positions[2 * star + 1], doctest::Approx(ascension));
+      CHECK_EQ(distances[star], 100000.F);
+      CHECK_EQ(magnitudes[star], doctest::Approx(getMagnitude(i) - 20.F));
+
+      ++star;
+    }
+  }
+
+  SUBCASE("Stars of the Hipparcos catalog are not loaded twice") {
+    auto catalog = StarCatalog::fromText(
+        {{CatalogType::eHipparcos, HIPPARCOS_FILE}, {CatalogType::eTycho2, TYCHO2_FILE}});
+
+    REQUIRE_EQ(catalog->getStarCount(), hipparcosCount + tycho2OnlyCount);
+
+    // Hipparcos stars come first, they have a parallax.
+    auto const* distances = catalog->getAttribute(Attribute::eDistance);
+    CHECK_EQ(distances[0], doctest::Approx(1000.F));
+    CHECK_EQ(distances[1], doctest::Approx(500.F));
+  }
+
+  SUBCASE("Tycho and Tycho2 are not loaded together") {
+    auto catalog = StarCatalog::fromText(
+        {{CatalogType::eTycho, HIPPARCOS_FILE}, {CatalogType::eTycho2, TYCHO2_FILE}});
+
+    CHECK_EQ(catalog->getStarCount(), hipparcosCount);
+  }
+
+  SUBCASE("Binary catalogs contain the same data as the text catalogs") {
+    std::map<CatalogType, std::string> catalogs{
+        {CatalogType::eHipparcos, HIPPARCOS_FILE}, {CatalogType::eTycho2, TYCHO2_FILE}};
+
+    auto catalog = StarCatalog::fromText(catalogs);
+    REQUIRE(catalog->save(CACHE_FILE));
+
+    auto loaded = StarCatalog::load(CACHE_FILE, catalogs);
+    REQUIRE(loaded);
+
+    CHECK_EQ(loaded->getStarCount(), catalog->getStarCount());
+    REQUIRE_EQ(loaded->getDataSize(), catalog->getDataSize());
+    CHECK_EQ(std::memcmp(loaded->getData(), catalog->getData(), catalog->getDataSize()), 0);
+
+    for (int i = 0; i < 4; ++i) {
+      auto attribute = static_cast<Attribute>(i);
+      CHECK_EQ(loaded->getOffset(attribute), catalog->getOffset(attribute));
+      CHECK_EQ(loaded->getOffset(attribute) % sizeof(float), 0);
+    }
+  }
+
+  SUBCASE("Incompatible binary catalogs are rejected") {
+    auto catalog = StarCatalog::fromText({{CatalogType::eTycho2, TYCHO2_FILE}});
+    REQUIRE(catalog->save(CACHE_FILE));
+
+    CHECK_FALSE(StarCatalog::load(CACHE_FILE, {{CatalogType::eHipparcos, HIPPARCOS_FILE}}));
+    CHECK_FALSE(StarCatalog::load("./nonExistingStarCache.dat", {}));
+
+    // A truncated file is rejected as well.
+    {
+      std::ofstream file(CACHE_FILE, std::ios::out | std::ios::binary);
+      file.write(static_cast<char const*>(catalog->getData()),
+          static_cast<std::streamsize>(catalog->getDataSize() / 2));
+    }
+
+    CHECK_FALSE(StarCatalog::load(CACHE_FILE, {{CatalogType::eTycho2, TYCHO2_FILE}}));
+  }
+
+  std::remove(HIPPARCOS_FILE);
+  std::remove(TYCHO2_FILE);
+  std::remove(CACHE_FILE);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("[benchmark] csp::stars::StarCatalog loading") {
+  // Tycho2 contains about 2.5 million stars.
+  int const tycho2Count = 2500000;
+
+  writeTycho2(tycho2Count);
+
+  std::map<CatalogType, std::string> catalogs{{CatalogType::eTycho2, TYCHO2_FILE}};
+  std::string const                  legacyCacheFile = "./testLegacyStarCache.dat";
+
+  using Clock = std::chrono::high_resolution_clock;
+
+  auto milliseconds = [](Clock::time_point start, Clock::time_point end) {
+    return std::chrono::duration<double, std::milli>(end - start).count();
+  };
+
+  // The previous text parser and cache.
+  auto start       = Clock::now();
+  auto legacyStars = legacyReadTycho2(TYCHO2_FILE);
+  auto legacyText  = Clock::now();
+
+  legacyWriteCache(legacyCacheFile, legacyStars);
+
+  auto legacyCacheStart = Clock::now();
+  auto legacyVertices   = legacyReadCache(legacyCacheFile);
+  auto legacyCache      = Clock::now();
+
+  // The StarCatalog.
+  auto text = StarCatalog::fromText(catalogs);
+  text->save(CACHE_FILE);
+
+  auto binaryStart = Clock::now();
+  auto binary      = StarCatalog::load(CACHE_FILE, catalogs);
+
+  // Copy the data once, like it is done when it is uploaded to the GPU. This makes sure that all
+  // pages of the file are actually read.
+  std::vector<std::uint8_t> upload(binary->getDataSize());
+  std::memcpy(upload.data(), binary->getData(), upload.size());
+
+  auto binaryEnd = Clock::now();
+
+  CHECK_EQ(legacyStars.size(), binary->getStarCount());
+  CHECK_EQ(legacyVertices.size(), 7 * binary->getStarCount());
+
+  logger().info("Loaded {} stars: {:.1f} ms from text, {:.1f} ms from the previous cache; "
+                "{:.1f} ms from text with the StarCatalog, {:.1f} ms from the binary catalog.",
+      binary->getStarCount(), milliseconds(start, legacyText),
+      milliseconds(legacyCacheStart, legacyCache), milliseconds(legacyCache, binaryStart),
+      milliseconds(binaryStart, binaryEnd));
+
+  std::remove(TYCHO2_FILE);
+  std::remove(CACHE_FILE);
+  std::remove(legacyCacheFile.c_str());
+}
+
+} // namespace csp::stars
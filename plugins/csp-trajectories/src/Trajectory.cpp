@@ -18,6 +18,13 @@
 
 namespace csp::trajectories {
 
+namespace {
+
+// The number of trajectory samples which are approximated by one segment of the ephemeris.
+double const SAMPLES_PER_SEGMENT = 64.0;
+
+} // namespace
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 Trajectory::Trajectory(std::shared_ptr<Plugin::Settings> pluginSettings, std::string sTargetCenter,
@@ -85,26 +92,51 @@ void Trajectory::update(double tTime, cs::scene::CelestialObserver const& oObs)
         completeRecalculation = true;
       }
 
+      if (!mEphemeris) {
+        mEphemeris = std::make_unique<cs::scene::ChebyshevEphemeris>(
+            getCenterName(), getFrameName(), mTargetCenter, mTargetFrame);
+      }
+
+      // Each segment of the ephemeris covers many samples. Only the segments at both ends of the
+      // trajectory have to be fitted when the simulation time advances.
+      mEphemeris->setSegmentLength(dSampleLength * SAMPLES_PER_SEGMENT);
+      mEphemeris->prune(
+          glm::clamp(tTime - dLengthSeconds - dSampleLength, mStartExistence, mEndExistence),
+          glm::clamp(tTime + dSampleLength, mStartExistence, mEndExistence));
+
+      // The ephemeris computes positions relative to our center and frame. This applies the
+      // additional transformation of this CelestialAnchor.
+      auto toAnchorSpace = [this](glm::dvec4 const& sample) {
+        glm::dvec3 pos = (sample.xyz() - getAnchorPosition()) / getAnchorScale();
+        return glm::dvec4(glm::inverse(getAnchorRotation()) * pos, sample.w);
+      };
+
+      std::vector<double>     times;
+      std::vector<glm::dvec4> samples;
+
+      // The range of points in the ring buffer which have to be uploaded to the GPU.
+      int firstChanged = mStartIndex;
+
       if (mLastUpdateTime < tTime) {
         if (completeRecalculation) {
           mLastSampleTime = tTime - dLengthSeconds - dSampleLength;
           mStartIndex     = 0;
+          firstChanged    = 0;
         }
 
         while (mLastSampleTime < tTime) {
           mLastSampleTime += dSampleLength;
+          times.push_back(glm::clamp(mLastSampleTime, mStartExistence, mEndExistence));
+        }
 
-          try {
-            double     tSampleTime = glm::clamp(mLastSampleTime, mStartExistence, mEndExistence);
-            glm::dvec3 pos         = getRelativePosition(tSampleTime, target);
-            mPoints[mStartIndex]   = glm::dvec4(pos.x, pos.y, pos.z, tSampleTime);
+        // Samples for which no data is available are skipped.
+        mEphemeris->sample(times, samples);
 
-            pVisibleRadius = std::max(glm::length(pos), pVisibleRadius.get());
+        for (auto const& sample : samples) {
+          mPoints[mStartIndex] = toAnchorSpace(sample);
+          pVisibleRadius = std::max(glm::length(mPoints[mStartIndex].xyz()), pVisibleRadius.get());
 
-            mStartIndex = (mStartIndex + 1) % static_cast<int>(pSamples.get());
-          } catch (...) {
-            // data might be unavailable
-          }
+          mStartIndex = (mStartIndex + 1) % static_cast<int>(pSamples.get());
         }
       } else {
         if (completeRecalculation) {
@@ -114,23 +146,30 @@ void Trajectory::update(double tTime, cs::scene::CelestialObserver const& oObs)
 
         while (mLastSampleTime - dSampleLength > tTime) {
           mLastSampleTime -= dSampleLength;
+          times.push_back(
+              glm::clamp(mLastSampleTime - dLengthSeconds, mStartExistence, mEndExistence));
+        }
+
+        // Samples for which no data is available are skipped.
+        mEphemeris->sample(times, samples);
 
-          try {
-            double tSampleTime =
-                glm::clamp(mLastSampleTime - dLengthSeconds, mStartExistence, mEndExistence);
-            glm::dvec3 pos = getRelativePosition(tSampleTime, target);
-            mPoints[(mStartIndex - 1 + pSamples.get()) % pSamples.get()] =
-                glm::dvec4(pos.x, pos.y, pos.z, tSampleTime);
-
-            mStartIndex = (mStartIndex - 1 + static_cast<int>(pSamples.get())) %
-                          static_cast<int>(pSamples.get());
-            pVisibleRadius = std::max(glm::length(pos), pVisibleRadius.get());
-          } catch (...) {
-            // data might be unavailable
-          }
+        for (auto const& sample : samples) {
+          mStartIndex = (mStartIndex - 1 + static_cast<int>(pSamples.get())) %
+                        static_cast<int>(pSamples.get());
+
+          mPoints[mStartIndex] = toAnchorSpace(sample);
+          pVisibleRadius = std::max(glm::length(mPoints[mStartIndex].xyz()), pVisibleRadius.get());
         }
+
+        firstChanged = mStartIndex;
       }
 
+      // The trajectory has to be uploaded even if it is not visible, as only changed points are
+      // written.
+      mTrajectory.uploadPoints(mPoints, firstChanged,
+          completeRecalculation ? static_cast<int>(mPoints.size())
+                                : static_cast<int>(samples.size()));
+
       mLastUpdateTime = tTime;
 
       if (completeRecalculation) {
@@ -142,7 +181,7 @@ void Trajectory::update(double tTime, cs::scene::CelestialObserver const& oObs)
 
     if (pVisible.get()) {
       glm::dvec3 tip = getRelativePosition(tTime, target);
-      mTrajectory.upload(matWorldTransform, tTime, mPoints, tip, mStartIndex);
+      mTrajectory.update(matWorldTransform, tTime, tip, mStartIndex);
     }
   }
 }
@@ -152,6 +191,7 @@ void Trajectory::update(double tTime, cs::scene::CelestialObserver const& oObs)
 void Trajectory::setTargetCenterName(std::string const& sCenterName) {
   if (mTargetCenter != sCenterName) {
     mPoints.clear();
+    mEphemeris.reset();
     mTargetCenter = sCenterName;
   }
 }
@@ -161,6 +201,7 @@ void Trajectory::setTargetCenterName(std::string const& sCenterName) {
 void Trajectory::setTargetFrameName(std::string const& sFrameName) {
   if (mTargetFrame != sFrameName) {
     mPoints.clear();
+    mEphemeris.reset();
     mTargetFrame = sFrameName;
   }
 }
@@ -182,6 +223,7 @@ std::string const& Trajectory::getTargetFrameName() const {
 void Trajectory::setCenterName(std::string const& sCenterName) {
   if (sCenterName != getCenterName()) {
     mPoints.clear();
+    mEphemeris.reset();
   }
   cs::scene::CelestialObject::setCenterName(sCenterName);
 }
@@ -191,6 +233,7 @@ void Trajectory::setCenterName(std::string const& sCenterName) {
 void Trajectory::setFrameName(std::string const& sFrameName) {
   if (sFrameName != getFrameName()) {
     mPoints.clear();
+    mEphemeris.reset();
   }
   cs::scene::CelestialObject::setFrameName(sFrameName);
 }
@@ -10,6 +10,7 @@
 #include "Plugin.hpp"
 
 #include "../../../src/cs-scene/CelestialObject.hpp"
+#include "../../../src/cs-scene/ChebyshevEphemeris.hpp"
 #include "../../../src/cs-scene/Trajectory.hpp"
 
 #include <VistaBase/VistaColor.h>
@@ -62,7 +63,8 @@ class Trajectory : public cs::scene::CelestialObject, public IVistaOpenGLDraw {
   std::shared_ptr<Plugin::Settings> mPluginSettings;
   cs::scene::Trajectory             mTrajectory;
 
-  std::unique_ptr<VistaOpenGLNode> mGLNode;
+  std::unique_ptr<VistaOpenGLNode>               mGLNode;
+  std::unique_ptr<cs::scene::ChebyshevEphemeris> mEphemeris;
 
   std::string             mTargetCenter;
   std::string             mTargetFrame;
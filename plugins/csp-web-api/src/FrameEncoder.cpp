@@ -0,0 +1,201 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "FrameEncoder.hpp"
+
+#include <array>
+#include <cstring>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+namespace csp::webapi {
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Appends the data written by stb_image_write to a std::vector<std::byte> which is given through
+// the context pointer.
+void appendToVector(void* context, void* data, int len) {
+  auto* vector   = static_cast<std::vector<std::byte>*>(context);
+  auto* charData = static_cast<std::byte*>(data);
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  vector->insert(vector->end(), charData, charData + len);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Encodes the given top-to-bottom RGB pixels according to the QOI specification version 1.0, see
+// https://qoiformat.org/qoi-specification.pdf. As all pixels are opaque, QOI_OP_RGBA is never
+// needed.
+std::vector<std::byte> encodeQOI(
+    std::vector<std::byte> const& pixels, int32_t width, int32_t height) {
+  uint8_t const opIndex = 0x00;
+  uint8_t const opDiff  = 0x40;
+  uint8_t const opLuma  = 0x80;
+  uint8_t const opRun   = 0xc0;
+  uint8_t const opRGB   = 0xfe;
+
+  std::vector<std::byte> result;
+
+  // The worst case is one QOI_OP_RGB per pixel.
+  result.reserve(14 + pixels.size() / 3 * 4 + 8);
+
+  auto push = [&result](uint32_t value) { result.push_back(static_cast<std::byte>(value)); };
+
+  auto pushBigEndian = [&push](uint32_t value) {
+    push(value >> 24U);
+    push(value >> 16U);
+    push(value >> 8U);
+    push(value);
+  };
+
+  // The header: magic bytes, size, three channels and the sRGB color space.
+  push('q');
+  push('o');
+  push('i');
+  push('f');
+  pushBigEndian(static_cast<uint32_t>(width));
+  pushBigEndian(static_cast<uint32_t>(height));
+  push(3);
+  push(0);
+
+  // The index stores RGBA values. It is initialized with zeros, so a black opaque pixel is not
+  // found in the index unless it has been stored there.
+  std::array<std::array<uint8_t, 4>, 64> index{};
+  std::array<uint8_t, 4>                 prev{0, 0, 0, 255};
+  uint32_t                               run = 0;
+
+  std::size_t count = static_cast<std::size_t>(width) * static_cast<std::size_t>(height);
+
+  for (std::size_t i = 0; i < count; ++i) {
+    std::array<uint8_t, 4> pixel{static_cast<uint8_t>(pixels[i * 3]),
+        static_cast<uint8_t>(pixels[i * 3 + 1]), static_cast<uint8_t>(pixels[i * 3 + 2]), 255};
+
+    if (pixel == prev) {
+      ++run;
+
+      if (run == 62 || i == count - 1) {
+        push(opRun | (run - 1));
+        run = 0;
+      }
+
+      continue;
+    }
+
+    if (run > 0) {
+      push(opRun | (run - 1));
+      run = 0;
+    }
+
+    uint32_t hash = (pixel[0] * 3U + pixel[1] * 5U + pixel[2] * 7U + pixel[3] * 11U) % 64U;
+
+    if (index.at(hash) == pixel) {
+      push(opIndex | hash);
+    } else {
+      index.at(hash) = pixel;
+
+      // The differences wrap around, as required by the specification.
+      auto dr = static_cast<int8_t>(pixel[0] - prev[0]);
+      auto dg = static_cast<int8_t>(pixel[1] - prev[1]);
+      auto db = static_cast<int8_t>(pixel[2] - prev[2]);
+
+      int32_t drdg = dr - dg;
+      int32_t dbdg = db - dg;
+
+      if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+        push(opDiff | static_cast<uint32_t>((dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+      } else if (dg >= -32 && dg <= 31 && drdg >= -8 && drdg <= 7 && dbdg >= -8 && dbdg <= 7) {
+        push(opLuma | static_cast<uint32_t>(dg + 32));
+        push(static_cast<uint32_t>((drdg + 8) << 4 | (dbdg + 8)));
+      } else {
+        push(opRGB);
+        push(pixel[0]);
+        push(pixel[1]);
+        push(pixel[2]);
+      }
+    }
+
+    prev = pixel;
+  }
+
+  // The end marker.
+  for (int i = 0; i < 7; ++i) {
+    push(0);
+  }
+  push(1);
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::optional<FrameFormat> getFrameFormat(std::string const& name) {
+  if (name == "png") {
+    return FrameFormat::ePNG;
+  }
+
+  if (name == "qoi") {
+    return FrameFormat::eQOI;
+  }
+
+  if (name == "raw") {
+    return FrameFormat::eRaw;
+  }
+
+  return std::nullopt;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+char const* getMimeType(FrameFormat format) {
+  switch (format) {
+  case FrameFormat::ePNG:
+    return "image/png";
+  case FrameFormat::eQOI:
+    return "image/qoi";
+  default:
+    return "application/octet-stream";
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<std::byte> encodeFrame(
+    std::vector<std::byte> const& pixels, int32_t width, int32_t height, FrameFormat format) {
+
+  // First, flip the image vertically. stbi_flip_vertically_on_write() cannot be used for this, as
+  // it modifies a global flag and frames are encoded on multiple threads.
+  std::size_t            rowSize = static_cast<std::size_t>(width) * 3;
+  std::vector<std::byte> flipped(pixels.size());
+
+  for (int32_t y = 0; y < height; ++y) {
+    std::memcpy(&flipped[y * rowSize], &pixels[(height - y - 1) * rowSize], rowSize);
+  }
+
+  if (format == FrameFormat::eRaw) {
+    return flipped;
+  }
+
+  if (format == FrameFormat::eQOI) {
+    return encodeQOI(flipped, width, height);
+  }
+
+  std::vector<std::byte> result;
+  stbi_write_png_to_func(&appendToVector, &result, width, height, 3, flipped.data(),
+      static_cast<int>(rowSize));
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace csp::webapi
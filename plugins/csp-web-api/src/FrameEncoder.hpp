@@ -0,0 +1,40 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CSP_WEB_API_FRAME_ENCODER_HPP
+#define CSP_WEB_API_FRAME_ENCODER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace csp::webapi {
+
+/// The image formats which can be used for the frames of a /capture-sequence request.
+enum class FrameFormat {
+  ePNG, ///< Compressed with stb_image_write. This is small but slow to encode.
+  eQOI, ///< The "Quite OK Image Format". Much faster to encode than PNG, but larger.
+  eRaw  ///< Uncompressed RGB pixels, row by row from top to bottom.
+};
+
+/// Returns the format with the given name ("png", "qoi" or "raw") or std::nullopt if the name is
+/// unknown.
+std::optional<FrameFormat> getFrameFormat(std::string const& name);
+
+/// Returns the MIME type which should be used when sending frames of the given format.
+char const* getMimeType(FrameFormat format);
+
+/// Encodes an RGB image with three bytes per pixel. The rows of the given pixels are expected from
+/// bottom to top, as returned by glReadPixels(); the encoded image is stored from top to bottom.
+/// This function is thread-safe, so it can be called from multiple worker threads at once.
+std::vector<std::byte> encodeFrame(
+    std::vector<std::byte> const& pixels, int32_t width, int32_t height, FrameFormat format);
+
+} // namespace csp::webapi
+
+#endif // CSP_WEB_API_FRAME_ENCODER_HPP
@@ -9,9 +9,12 @@
 #include "../../../src/cs-core/GuiManager.hpp"
 #include "../../../src/cs-core/Settings.hpp"
 #include "../../../src/cs-core/SolarSystem.hpp"
+#include "../../../src/cs-core/TimeControl.hpp"
 #include "../../../src/cs-scene/CelestialObserver.hpp"
+#include "../../../src/cs-utils/TraceRecorder.hpp"
 #include "../../../src/cs-utils/logger.hpp"
 #include "../../../src/cs-utils/utils.hpp"
+#include "FrameEncoder.hpp"
 #include "logger.hpp"
 
 #include <CivetServer.h>
@@ -24,11 +27,9 @@
 #include <VistaKernel/VistaSystem.h>
 #include <curlpp/cURLpp.hpp>
 #include <sstream>
+#include <thread>
 #include <tiffio.h>
 #include <tiffio.hxx>
-
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#include <stb_image_write.h>
 #include <utility>
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -49,17 +50,6 @@ namespace {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-// Converts a void* to a std::vector<std::byte> (which is given through a void* as well). So this is
-// pretty unsafe, but I think it's the only way to make stb_image write to a std::vector<std::byte>.
-void pngWriteToVector(void* context, void* data, int len) {
-  auto* vector   = static_cast<std::vector<std::byte>*>(context);
-  auto* charData = static_cast<std::byte*>(data);
-  // NOLINTNEXTLINE (cppcoreguidelines-pro-bounds-pointer-arithmetic)
-  *vector = std::vector<std::byte>(charData, charData + len);
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
 // A simple wrapper class which basically allows registering of lambdas as endpoint handlers for
 // our CivetServer. This one handles GET requests.
 class GetHandler : public CivetHandler {
@@ -247,6 +237,133 @@ void Plugin::init() {
     mg_write(conn, mCapture.data(), mCapture.size());
   }));
 
+  // The /capture-sequence endpoint captures many consecutive frames and streams them to the client
+  // as parts of a multipart response with chunked transfer encoding. The pixels are read
+  // asynchronously and encoded on worker threads, see Plugin::updateCaptureSequence(). At most
+  // "queue" frames are read or encoded at any time; if the client cannot keep up, the capture of
+  // the next frame is postponed. Each part contains the index of the frame and the simulation time
+  // at which it was captured, so gaps can be detected.
+  mHandlers.emplace("/capture-sequence", std::make_unique<GetHandler>([this](mg_connection* conn) {
+    SequenceRequest request;
+    request.mDelay     = std::clamp(getParam<int32_t>(conn, "delay", 50), 1, 200);
+    request.mWidth     = std::clamp(getParam<int32_t>(conn, "width", 800), 10, 2000);
+    request.mHeight    = std::clamp(getParam<int32_t>(conn, "height", 600), 10, 2000);
+    request.mFrames    = std::max(getParam<int32_t>(conn, "frames", 100), 1);
+    request.mQueueSize = std::clamp(getParam<int32_t>(conn, "queue", 8), 1, 64);
+    request.mGui       = getParam<std::string>(conn, "gui", "false") == "true";
+
+    auto format = getFrameFormat(getParam<std::string>(conn, "format", "png"));
+
+    if (!format) {
+      mg_send_http_error(conn, 400, "Unknown format! Use png, qoi or raw.");
+      return;
+    }
+
+    request.mFormat = format.value();
+
+    {
+      std::lock_guard<std::mutex> lock(mSequenceMutex);
+
+      if (mSequenceActive || mSequenceRequest) {
+        mg_send_http_error(conn, 409, "Another sequence is currently captured.");
+        return;
+      }
+
+      // This tells the main thread that a sequence has been requested.
+      mSequenceRequest   = request;
+      mSequenceFinished  = false;
+      mSequenceCancelled = false;
+    }
+
+    // A negative length enables chunked transfer encoding.
+    mg_send_http_ok(conn, "multipart/x-mixed-replace; boundary=frame", -1);
+
+    while (true) {
+      SequenceFrame frame;
+
+      {
+        std::unique_lock<std::mutex> lock(mSequenceMutex);
+        mSequenceChanged.wait(
+            lock, [this] { return !mSequenceFrames.empty() || mSequenceFinished; });
+
+        if (mSequenceFrames.empty()) {
+          break;
+        }
+
+        frame = std::move(mSequenceFrames.front());
+        mSequenceFrames.pop_front();
+      }
+
+      // If the frame is not encoded yet, we wait here. The main thread never waits for the encoder.
+      auto data = frame.mData.get();
+
+      std::string header = fmt::format("--frame\r\nContent-Type: {}\r\nContent-Length: {}\r\n"
+                                       "X-Frame-Index: {}\r\nX-Simulation-Time: {}\r\n"
+                                       "X-Width: {}\r\nX-Height: {}\r\n\r\n",
+          getMimeType(request.mFormat), data.size(), frame.mIndex, frame.mSimulationTime,
+          frame.mWidth, frame.mHeight);
+
+      std::string const footer = "\r\n";
+
+      // If sending fails, the client has closed the connection. The main thread will stop capturing
+      // then.
+      if (mg_send_chunk(conn, header.data(), static_cast<unsigned>(header.size())) < 0 ||
+          mg_send_chunk(conn, reinterpret_cast<char const*>(data.data()), // NOLINT
+              static_cast<unsigned>(data.size())) < 0 ||
+          mg_send_chunk(conn, footer.data(), static_cast<unsigned>(footer.size())) < 0) {
+
+        logger().warn("Failed to send frame {} of '/capture-sequence' request. Cancelling.",
+            frame.mIndex);
+
+        std::unique_lock<std::mutex> lock(mSequenceMutex);
+        mSequenceCancelled = true;
+        mSequenceChanged.wait(lock, [this] { return mSequenceFinished; });
+        mSequenceFrames.clear();
+        return;
+      }
+    }
+
+    std::string const end = "--frame--\r\n";
+    mg_send_chunk(conn, end.data(), static_cast<unsigned>(end.size()));
+    mg_send_chunk(conn, "", 0);
+  }));
+
+  // The /trace endpoint returns a trace in the Chrome trace event format which can be opened with
+  // chrome://tracing or https://ui.perfetto.dev. If "first" is given, the already recorded frames
+  // from "first" to "last" are returned. Else, the next "frames" frames are recorded; if tracing
+  // is disabled, it is enabled for these frames only. See cs::utils::TraceRecorder for details.
+  mHandlers.emplace("/trace", std::make_unique<GetHandler>([this](mg_connection* conn) {
+    uint64_t first = getParam<uint64_t>(conn, "first", 0);
+    uint64_t last  = getParam<uint64_t>(conn, "last", cs::utils::TraceRecorder::getLastFrame());
+
+    if (first == 0) {
+      auto request     = std::make_shared<TraceRequest>();
+      request->mFrames = std::clamp(getParam<int32_t>(conn, "frames", 100), 1, 10000);
+
+      // The frames are recorded in Plugin::update() further below. Concurrent requests are
+      // recorded one after another.
+      {
+        std::unique_lock<std::mutex> lock(mTraceMutex);
+        if (!mTraceStopped) {
+          mTraceRequests.push_back(request);
+          mTraceDone.wait(lock, [&request] { return request->mDone; });
+        }
+      }
+
+      if (!request->mActive) {
+        mg_send_http_error(conn, 503, "The plugin is being unloaded.");
+        return;
+      }
+
+      first = request->mFirstFrame;
+      last  = request->mLastFrame;
+    }
+
+    std::string response = cs::utils::TraceRecorder::exportChromeTrace(first, last);
+    mg_send_http_ok(conn, "application/json", response.length());
+    mg_write(conn, response.data(), response.length());
+  }));
+
   // All POST requests received on /run-js are stored in a queue. They are executed in the main
   // thread in the Plugin::update() method further below.
   mHandlers.emplace("/run-js", std::make_unique<PostHandler>([this](mg_connection* conn) {
@@ -258,6 +375,10 @@ void Plugin::init() {
     mg_write(conn, response.data(), response.length());
   }));
 
+  // The frames of /capture-sequence requests are encoded in parallel.
+  uint32_t encoderThreads = std::max(std::thread::hardware_concurrency() / 2, 1U);
+  mSequenceEncoder        = std::make_unique<cs::utils::ThreadPool>(encoderThreads);
+
   mOnLoadConnection = mAllSettings->onLoad().connect([this]() { mReloadRequired = true; });
   mOnSaveConnection = mAllSettings->onSave().connect(
       [this]() { mAllSettings->mPlugins["csp-web-api"] = mPluginSettings; });
@@ -277,8 +398,37 @@ void Plugin::deInit() {
   mAllSettings->onSave().disconnect(mOnSaveConnection);
   cs::utils::onLogMessage().disconnect(mOnLogMessageConnection);
 
+  // Make sure that the server thread does not wait for further frames of a /capture-sequence
+  // request, else quitting the server would block forever.
+  {
+    std::lock_guard<std::mutex> lock(mSequenceMutex);
+    mSequenceRequest.reset();
+    finishCaptureSequence();
+  }
+
+  // The /trace request which is currently recorded returns what has been recorded so far. All
+  // other pending and future requests fail.
+  {
+    std::lock_guard<std::mutex> lock(mTraceMutex);
+    for (auto const& request : mTraceRequests) {
+      if (request->mActive) {
+        if (mTraceDisable) {
+          cs::utils::TraceRecorder::setEnabled(false);
+        }
+        request->mLastFrame =
+            std::min(request->mLastFrame, cs::utils::TraceRecorder::getLastFrame());
+      }
+      request->mDone = true;
+    }
+    mTraceRequests.clear();
+    mTraceStopped = true;
+    mTraceDone.notify_all();
+  }
+
   quitServer();
 
+  mSequenceEncoder.reset();
+
   logger().info("Unloading done.");
 }
 
@@ -313,6 +463,33 @@ void Plugin::update() {
     }
   }
 
+  // Start or finish a pending /trace request. The current frame is only partially recorded if
+  // tracing has just been enabled, so the trace starts with the next frame.
+  {
+    std::lock_guard<std::mutex> lock(mTraceMutex);
+    if (!mTraceRequests.empty()) {
+      auto& request = *mTraceRequests.front();
+
+      if (!request.mActive) {
+        logger().debug("Executing '/trace' request.");
+        mTraceDisable       = !cs::utils::TraceRecorder::isEnabled();
+        request.mFirstFrame = cs::utils::TraceRecorder::getLastFrame() + 2;
+        request.mLastFrame  = request.mFirstFrame + static_cast<uint64_t>(request.mFrames) - 1;
+        request.mActive     = true;
+        cs::utils::TraceRecorder::setEnabled(true);
+      }
+
+      if (cs::utils::TraceRecorder::getLastFrame() >= request.mLastFrame) {
+        if (mTraceDisable) {
+          cs::utils::TraceRecorder::setEnabled(false);
+        }
+        request.mDone = true;
+        mTraceRequests.pop_front();
+        mTraceDone.notify_all();
+      }
+    }
+  }
+
   // Execute any pending /load request.
   {
     std::lock_guard<std::mutex> lock(mLoadMutex);
@@ -402,13 +579,11 @@ void Plugin::update() {
       } else {
         // Writing pngs is simpler.
         std::vector<std::byte> capture(mCaptureWidth * mCaptureHeight * 3);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
         glReadPixels(0, 0, mCaptureWidth, mCaptureHeight, GL_RGB, GL_UNSIGNED_BYTE, &capture[0]);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
 
-        // We encode the png data in the main thread as this is not thread-safe.
-        stbi_flip_vertically_on_write(1);
-        stbi_write_png_to_func(&pngWriteToVector, &mCapture, mCaptureWidth, mCaptureHeight, 3,
-            capture.data(), mCaptureWidth * 3);
-        stbi_flip_vertically_on_write(0);
+        mCapture = encodeFrame(capture, mCaptureWidth, mCaptureHeight, FrameFormat::ePNG);
       }
 
       mCaptureAtFrame = 0;
@@ -416,6 +591,12 @@ void Plugin::update() {
     }
   }
 
+  // Read and encode the frames of a /capture-sequence request.
+  {
+    std::lock_guard<std::mutex> lock(mSequenceMutex);
+    updateCaptureSequence();
+  }
+
   // In this plugin, we cannot call this directly when the onLoad signal of the settings is fired,
   // since reloading can cause our server to be restarted. And as reloading can be triggered from a
   // /load request, this could lead to a deadlock.
@@ -426,6 +607,144 @@ void Plugin::update() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void Plugin::updateCaptureSequence() {
+
+  // If a sequence has been requested, we first resize the window to the given size. Then we wait
+  // mSequence.mDelay frames until we start capturing.
+  if (mSequenceRequest) {
+    mSequence = mSequenceRequest.value();
+    mSequenceRequest.reset();
+
+    logger().debug("Starting '/capture-sequence' request: resolution = {}x{}, frames = {}, show "
+                   "gui = {}",
+        mSequence.mWidth, mSequence.mHeight, mSequence.mFrames, mSequence.mGui);
+
+    auto* window = GetVistaSystem()->GetDisplayManager()->GetWindows().begin()->second;
+    window->GetWindowProperties()->SetSize(mSequence.mWidth, mSequence.mHeight);
+    mSequenceStartFrame = GetVistaSystem()->GetFrameLoop()->GetFrameCount() + mSequence.mDelay;
+    mAllSettings->pEnableUserInterface = mSequence.mGui;
+    mSequenceCaptured                  = 0;
+    mSequenceActive                    = true;
+  }
+
+  if (!mSequenceActive) {
+    return;
+  }
+
+  // The client has closed the connection.
+  if (mSequenceCancelled) {
+    finishCaptureSequence();
+    return;
+  }
+
+  auto bufferSize = static_cast<GLsizeiptr>(mSequence.mWidth) * mSequence.mHeight * 3;
+
+  // Pass all finished readbacks to the encoder. They are checked in the order in which they were
+  // issued, so that the frames are sent in the correct order.
+  while (!mSequenceReadbacks.empty()) {
+    auto& readback = mSequenceReadbacks.front();
+
+    if (glClientWaitSync(readback.mFence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+      break;
+    }
+
+    glDeleteSync(readback.mFence);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.mBuffer);
+    auto const* data = static_cast<std::byte const*>(
+        glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bufferSize, GL_MAP_READ_BIT));
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    std::vector<std::byte> pixels(data, data + bufferSize);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    mSequenceBuffers.push_back(readback.mBuffer);
+
+    SequenceFrame frame;
+    frame.mIndex          = readback.mIndex;
+    frame.mSimulationTime = readback.mSimulationTime;
+    frame.mWidth          = mSequence.mWidth;
+    frame.mHeight         = mSequence.mHeight;
+    frame.mData           = mSequenceEncoder->enqueue(
+        [pixels = std::move(pixels), width = mSequence.mWidth, height = mSequence.mHeight,
+            format = mSequence.mFormat]() { return encodeFrame(pixels, width, height, format); });
+
+    mSequenceFrames.push_back(std::move(frame));
+    mSequenceReadbacks.pop_front();
+    mSequenceChanged.notify_one();
+  }
+
+  // Start reading the pixels of the current frame. If too many frames are still being read,
+  // encoded or sent, this is postponed to one of the next frames.
+  auto queued = static_cast<int32_t>(mSequenceReadbacks.size() + mSequenceFrames.size());
+
+  if (mSequenceCaptured < mSequence.mFrames && queued < mSequence.mQueueSize &&
+      GetVistaSystem()->GetFrameLoop()->GetFrameCount() >= mSequenceStartFrame) {
+
+    // The actual window size may differ from the requested one. It must not change during the
+    // sequence, as all pixel buffer objects have the same size.
+    if (mSequenceCaptured == 0) {
+      auto* window = GetVistaSystem()->GetDisplayManager()->GetWindows().begin()->second;
+      window->GetWindowProperties()->GetSize(mSequence.mWidth, mSequence.mHeight);
+      bufferSize = static_cast<GLsizeiptr>(mSequence.mWidth) * mSequence.mHeight * 3;
+    }
+
+    SequenceReadback readback;
+    readback.mIndex          = mSequenceCaptured;
+    readback.mSimulationTime = mTimeControl->pSimulationTime.get();
+
+    if (mSequenceBuffers.empty()) {
+      glGenBuffers(1, &readback.mBuffer);
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.mBuffer);
+      glBufferData(GL_PIXEL_PACK_BUFFER, bufferSize, nullptr, GL_STREAM_READ);
+    } else {
+      readback.mBuffer = mSequenceBuffers.back();
+      mSequenceBuffers.pop_back();
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.mBuffer);
+    }
+
+    // With a pixel pack buffer bound, glReadPixels() returns immediately. The rows are tightly
+    // packed, so that widths which are not a multiple of four work as well.
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, mSequence.mWidth, mSequence.mHeight, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    readback.mFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    mSequenceReadbacks.push_back(readback);
+    ++mSequenceCaptured;
+  }
+
+  if (mSequenceCaptured == mSequence.mFrames && mSequenceReadbacks.empty()) {
+    logger().debug("Finished '/capture-sequence' request.");
+    finishCaptureSequence();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Plugin::finishCaptureSequence() {
+  for (auto& readback : mSequenceReadbacks) {
+    glDeleteSync(readback.mFence);
+    glDeleteBuffers(1, &readback.mBuffer);
+  }
+
+  if (!mSequenceBuffers.empty()) {
+    glDeleteBuffers(static_cast<GLsizei>(mSequenceBuffers.size()), mSequenceBuffers.data());
+  }
+
+  mSequenceReadbacks.clear();
+  mSequenceBuffers.clear();
+
+  // The server thread sends all remaining frames and then finishes the response.
+  mSequenceActive   = false;
+  mSequenceFinished = true;
+  mSequenceChanged.notify_all();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void Plugin::startServer(uint16_t port) {
 
   // First quit the server as it may be running already.
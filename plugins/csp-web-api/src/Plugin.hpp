@@ -9,10 +9,15 @@
 
 #include "../../../src/cs-core/PluginBase.hpp"
 #include "../../../src/cs-utils/DefaultProperty.hpp"
+#include "../../../src/cs-utils/ThreadPool.hpp"
+#include "FrameEncoder.hpp"
 
+#include <GL/glew.h>
 #include <condition_variable>
 #include <cstddef>
 #include <deque>
+#include <future>
+#include <memory>
 #include <optional>
 #include <queue>
 #include <unordered_map>
@@ -46,6 +51,50 @@ class Plugin : public cs::core::PluginBase {
   void startServer(uint16_t port);
   void quitServer();
 
+  /// These are called by update() in order to process /capture-sequence requests. Both require
+  /// mSequenceMutex to be locked.
+  void updateCaptureSequence();
+  void finishCaptureSequence();
+
+  /// The parameters of a /capture-sequence request.
+  struct SequenceRequest {
+    int32_t     mWidth     = 0;
+    int32_t     mHeight    = 0;
+    int32_t     mDelay     = 0;
+    int32_t     mFrames    = 0;
+    int32_t     mQueueSize = 0;
+    bool        mGui       = false;
+    FrameFormat mFormat    = FrameFormat::ePNG;
+  };
+
+  /// A frame of a /capture-sequence request whose pixels are currently read into a pixel buffer
+  /// object.
+  struct SequenceReadback {
+    GLuint  mBuffer         = 0;
+    GLsync  mFence          = nullptr;
+    int32_t mIndex          = 0;
+    double  mSimulationTime = 0.0;
+  };
+
+  /// A frame of a /capture-sequence request which is encoded or waiting to be sent.
+  struct SequenceFrame {
+    std::future<std::vector<std::byte>> mData;
+    int32_t                             mIndex          = 0;
+    double                              mSimulationTime = 0.0;
+    int32_t                             mWidth          = 0;
+    int32_t                             mHeight         = 0;
+  };
+
+  /// A /trace request. It is created by the server thread which waits until mDone is set. The
+  /// requests are recorded one after another by the main thread.
+  struct TraceRequest {
+    int32_t  mFrames     = 0;
+    uint64_t mFirstFrame = 0;
+    uint64_t mLastFrame  = 0;
+    bool     mActive     = false;
+    bool     mDone       = false;
+  };
+
   Settings                                                       mPluginSettings;
   std::unique_ptr<CivetServer>                                   mServer;
   std::unordered_map<std::string, std::unique_ptr<CivetHandler>> mHandlers;
@@ -62,6 +111,24 @@ class Plugin : public cs::core::PluginBase {
   int32_t                 mCaptureAtFrame   = 0;
   std::vector<std::byte>  mCapture;
 
+  // Members for the /capture-sequence endpoint. The pixels of each frame are read asynchronously
+  // into a pixel buffer object on the main thread. Once this is done, they are encoded by
+  // mSequenceEncoder and the resulting future is appended to mSequenceFrames. The server thread
+  // sends the frames to the client in the order of mSequenceFrames.
+  std::mutex                             mSequenceMutex;
+  std::condition_variable                mSequenceChanged;
+  std::optional<SequenceRequest>         mSequenceRequest;
+  SequenceRequest                        mSequence;
+  bool                                   mSequenceActive     = false;
+  bool                                   mSequenceFinished   = false;
+  bool                                   mSequenceCancelled  = false;
+  int32_t                                mSequenceStartFrame = 0;
+  int32_t                                mSequenceCaptured   = 0;
+  std::deque<SequenceReadback>           mSequenceReadbacks;
+  std::vector<GLuint>                    mSequenceBuffers;
+  std::deque<SequenceFrame>              mSequenceFrames;
+  std::unique_ptr<cs::utils::ThreadPool> mSequenceEncoder;
+
   // Members for the /log endpoint
   std::mutex              mLogMutex;
   std::deque<std::string> mLogMessages;
@@ -76,6 +143,13 @@ class Plugin : public cs::core::PluginBase {
   std::mutex  mLoadMutex;
   std::string mLoadSettings;
 
+  // Members for the /trace endpoint
+  std::mutex                                mTraceMutex;
+  std::condition_variable                   mTraceDone;
+  std::deque<std::shared_ptr<TraceRequest>> mTraceRequests;
+  bool                                      mTraceDisable = false;
+  bool                                      mTraceStopped = false;
+
   // Members for the /run-js endpoint
   std::mutex              mJavaScriptCallsMutex;
   std::queue<std::string> mJavaScriptCalls;
@@ -0,0 +1,210 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "../src/FrameEncoder.hpp"
+#include "../../../src/cs-utils/doctest.hpp"
+#include "../src/logger.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <random>
+
+#define STB_IMAGE_STATIC
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+namespace csp::webapi {
+
+namespace {
+
+// Creates an RGB test image with smooth gradients, flat areas and some noise, so that all QOI
+// operations are used.
+std::vector<std::byte> createImage(int32_t width, int32_t height) {
+  std::mt19937                    generator(42);
+  std::uniform_int_distribution<> noise(0, 255);
+
+  std::vector<std::byte> pixels(static_cast<std::size_t>(width) * height * 3);
+
+  for (int32_t y = 0; y < height; ++y) {
+    for (int32_t x = 0; x < width; ++x) {
+      std::size_t i = (static_cast<std::size_t>(y) * width + x) * 3;
+
+      if (x < width / 3) {
+        pixels[i]     = static_cast<std::byte>(x);
+        pixels[i + 1] = static_cast<std::byte>(y);
+        pixels[i + 2] = static_cast<std::byte>(x + y);
+      } else if (x < 2 * width / 3) {
+        // There are black pixels which do not follow other black pixels as well.
+        pixels[i]     = static_cast<std::byte>(y < height / 2 ? 0 : 200);
+        pixels[i + 1] = static_cast<std::byte>(y < height / 2 ? 0 : 20);
+        pixels[i + 2] = static_cast<std::byte>(y < height / 2 ? 0 : 30);
+      } else {
+        pixels[i]     = static_cast<std::byte>(noise(generator));
+        pixels[i + 1] = static_cast<std::byte>(noise(generator));
+        pixels[i + 2] = static_cast<std::byte>(noise(generator));
+      }
+    }
+  }
+
+  return pixels;
+}
+
+// Returns the given bottom-to-top image from top to bottom.
+std::vector<std::byte> flip(std::vector<std::byte> const& pixels, int32_t width, int32_t height) {
+  std::size_t            rowSize = static_cast<std::size_t>(width) * 3;
+  std::vector<std::byte> result;
+
+  for (int32_t y = height - 1; y >= 0; --y) {
+    auto row = pixels.begin() + static_cast<std::ptrdiff_t>(y * rowSize);
+    result.insert(result.end(), row, row + static_cast<std::ptrdiff_t>(rowSize));
+  }
+
+  return result;
+}
+
+// A straightforward QOI decoder for RGB images, following the specification.
+std::vector<std::byte> decodeQOI(std::vector<std::byte> const& data, int32_t& width,
+    int32_t& height) {
+  auto byte = [&data](std::size_t i) { return static_cast<uint32_t>(data.at(i)); };
+
+  REQUIRE_EQ(byte(0), 'q');
+  REQUIRE_EQ(byte(1), 'o');
+  REQUIRE_EQ(byte(2), 'i');
+  REQUIRE_EQ(byte(3), 'f');
+  REQUIRE_EQ(byte(12), 3U);
+
+  width  = static_cast<int32_t>(byte(4) << 24U | byte(5) << 16U | byte(6) << 8U | byte(7));
+  height = static_cast<int32_t>(byte(8) << 24U | byte(9) << 16U | byte(10) << 8U | byte(11));
+
+  std::vector<std::byte>                  pixels;
+  std::array<std::array<uint32_t, 4>, 64> index{};
+  std::array<uint32_t, 4>                 pixel{0, 0, 0, 255};
+
+  std::size_t pos   = 14;
+  std::size_t count = static_cast<std::size_t>(width) * height;
+
+  while (pixels.size() < count * 3) {
+    uint32_t op  = byte(pos++);
+    uint32_t run = 1;
+
+    if (op == 0xfe) {
+      pixel = {byte(pos), byte(pos + 1), byte(pos + 2), pixel[3]};
+      pos += 3;
+    } else if ((op & 0xc0U) == 0x00) {
+      pixel = index.at(op);
+    } else if ((op & 0xc0U) == 0x40) {
+      pixel[0] = (pixel[0] + ((op >> 4U) & 3U) - 2) & 0xffU;
+      pixel[1] = (pixel[1] + ((op >> 2U) & 3U) - 2) & 0xffU;
+      pixel[2] = (pixel[2] + (op & 3U) - 2) & 0xffU;
+    } else if ((op & 0xc0U) == 0x80) {
+      uint32_t next = byte(pos++);
+      uint32_t dg   = (op & 0x3fU) - 32;
+      pixel[0]      = (pixel[0] + dg + ((next >> 4U) & 0xfU) - 8) & 0xffU;
+      pixel[1]      = (pixel[1] + dg) & 0xffU;
+      pixel[2]      = (pixel[2] + dg + (next & 0xfU) - 8) & 0xffU;
+    } else {
+      run = (op & 0x3fU) + 1;
+    }
+
+    index.at((pixel[0] * 3 + pixel[1] * 5 + pixel[2] * 7 + pixel[3] * 11) % 64) = pixel;
+
+    // A wrong alpha value would show that the index was used incorrectly.
+    CHECK_EQ(pixel[3], 255U);
+
+    for (uint32_t i = 0; i < run; ++i) {
+      for (int c = 0; c < 3; ++c) {
+        pixels.push_back(static_cast<std::byte>(pixel.at(c)));
+      }
+    }
+  }
+
+  // The end marker.
+  for (int i = 0; i < 7; ++i) {
+    CHECK_EQ(byte(pos + i), 0U);
+  }
+  CHECK_EQ(byte(pos + 7), 1U);
+
+  return pixels;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("csp::webapi::encodeFrame") {
+  // The width is not a multiple of four on purpose.
+  int32_t const width  = 123;
+  int32_t const height = 77;
+
+  auto pixels   = createImage(width, height);
+  auto expected = flip(pixels, width, height);
+
+  SUBCASE("Raw frames are flipped") {
+    CHECK(encodeFrame(pixels, width, height, FrameFormat::eRaw) == expected);
+  }
+
+  SUBCASE("QOI frames are lossless") {
+    auto data = encodeFrame(pixels, width, height, FrameFormat::eQOI);
+
+    int32_t decodedWidth  = 0;
+    int32_t decodedHeight = 0;
+    auto    decoded       = decodeQOI(data, decodedWidth, decodedHeight);
+
+    CHECK_EQ(decodedWidth, width);
+    CHECK_EQ(decodedHeight, height);
+    CHECK(decoded == expected);
+
+    // Flat areas have to be compressed.
+    CHECK_LT(data.size(), pixels.size());
+  }
+
+  SUBCASE("PNG frames are lossless") {
+    auto data = encodeFrame(pixels, width, height, FrameFormat::ePNG);
+
+    int   decodedWidth    = 0;
+    int   decodedHeight   = 0;
+    int   decodedChannels = 0;
+    auto* decoded = stbi_load_from_memory(reinterpret_cast<stbi_uc const*>(data.data()), // NOLINT
+        static_cast<int>(data.size()), &decodedWidth, &decodedHeight, &decodedChannels, 3);
+
+    REQUIRE(decoded != nullptr);
+    CHECK_EQ(decodedWidth, width);
+    CHECK_EQ(decodedHeight, height);
+    CHECK_EQ(std::memcmp(decoded, expected.data(), expected.size()), 0);
+
+    stbi_image_free(decoded);
+  }
+
+  SUBCASE("Format names are parsed") {
+    CHECK_EQ(getFrameFormat("png"), FrameFormat::ePNG);
+    CHECK_EQ(getFrameFormat("qoi"), FrameFormat::eQOI);
+    CHECK_EQ(getFrameFormat("raw"), FrameFormat::eRaw);
+    CHECK_FALSE(getFrameFormat("jpg"));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("[benchmark] csp::webapi::encodeFrame") {
+  int32_t const width  = 1920;
+  int32_t const height = 1080;
+
+  auto pixels = createImage(width, height);
+
+  for (auto format : {FrameFormat::ePNG, FrameFormat::eQOI, FrameFormat::eRaw}) {
+    auto start = std::chrono::high_resolution_clock::now();
+    auto data  = encodeFrame(pixels, width, height, format);
+    auto end   = std::chrono::high_resolution_clock::now();
+
+    logger().info("Encoded {}x{} frame as {}: {:.1f} ms, {} bytes.", width, height,
+        getMimeType(format), std::chrono::duration<double, std::milli>(end - start).count(),
+        data.size());
+  }
+}
+
+} // namespace csp::webapi
@@ -61,13 +61,23 @@ class StatisticsApi extends IApi {
     }
   }
 
+  /**
+   * Counter values of the last frame
+   *
+   * @type {Object}
+   * @private
+   */
+  _counters = {};
+
   /**
    *
    * @param data {string}
    * @param frameRate {number}
+   * @param counters {string}
    */
-  setData(data, frameRate) {
-    this._data = JSON.parse(data);
+  setData(data, frameRate, counters = '{}') {
+    this._data     = JSON.parse(data);
+    this._counters = JSON.parse(counters);
 
     // first set all times to zero
     this._resetTimes();
@@ -151,6 +161,10 @@ class StatisticsApi extends IApi {
 
     item.innerHTML = `<div class="label"><strong>FPS: ${frameRate.toFixed(2)}</strong></div>`;
 
+    Object.keys(this._counters).sort().forEach((key) => {
+      item.innerHTML += `<div class="label">${key}: ${this._counters[key]}</div>`;
+    });
+
     container.appendChild(item.content);
 
     for (let i = 0; i < maxEntries; ++i) {
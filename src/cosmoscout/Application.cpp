@@ -14,8 +14,10 @@
 #include "../cs-core/Settings.hpp"
 #include "../cs-core/SolarSystem.hpp"
 #include "../cs-core/TimeControl.hpp"
+#include "../cs-graphics/AsyncTextureLoader.hpp"
 #include "../cs-graphics/MouseRay.hpp"
 #include "../cs-utils/Downloader.hpp"
+#include "../cs-utils/TraceRecorder.hpp"
 #include "../cs-utils/convert.hpp"
 #include "../cs-utils/filesystem.hpp"
 #include "../cs-utils/logger.hpp"
@@ -35,6 +37,7 @@
 #include <VistaKernel/GraphicsManager/VistaTransformNode.h>
 #include <VistaKernel/VistaSystem.h>
 #include <VistaOGLExt/VistaShaderRegistry.h>
+#include <algorithm>
 #include <curlpp/cURLpp.hpp>
 #include <memory>
 
@@ -507,6 +510,13 @@ void Application::FrameUpdate() {
     }
   }
 
+  // Upload textures which have been loaded in the background. This is done also while the plugins
+  // are loaded, as these usually request their textures during initialization.
+  {
+    cs::utils::FrameTimings::ScopedTimer timer("Texture Upload");
+    mGraphicsEngine->getTextureLoader()->update();
+  }
+
   // Update the user interface.
   {
     cs::utils::FrameTimings::ScopedTimer timer("User Interface");
@@ -1168,6 +1178,28 @@ void Application::registerGuiCallbacks() {
     mGuiManager->setCheckboxValue("graphics.setEnableTimerQueries", enable);
   });
 
+  // Enables or disables the recording of a trace. See cs::utils::TraceRecorder for details.
+  mGuiManager->getGui()->registerCallback("graphics.setEnableTracing",
+      "Enables or disables the recording of a trace which can be viewed with chrome://tracing.",
+      std::function([](bool enable) { cs::utils::TraceRecorder::setEnabled(enable); }));
+
+  // Saves the most recently recorded frames of the trace.
+  mGuiManager->getGui()->registerCallback("graphics.saveTrace",
+      "Saves the given number of most recently recorded frames of the trace to the given file. If "
+      "the number is omitted, 100 frames are saved.",
+      std::function([](std::string&& file, std::optional<double> frameCount) {
+        auto     count = static_cast<uint64_t>(std::max(1.0, frameCount.value_or(100.0)));
+        uint64_t last  = cs::utils::TraceRecorder::getLastFrame();
+        uint64_t first = last >= count ? last - count + 1 : 0;
+
+        try {
+          cs::utils::TraceRecorder::save(file, first, last);
+          logger().info("Saved frames {} to {} of the trace to '{}'.", first, last, file);
+        } catch (std::exception const& e) {
+          logger().warn("Failed to save trace to '{}': {}", file, e.what());
+        }
+      }));
+
   // Enables or disables vertical synchronization.
   mGuiManager->getGui()->registerCallback("graphics.setEnableVsync",
       "Enables or disables vertical synchronization.",
@@ -1561,6 +1593,8 @@ void Application::unregisterGuiCallbacks() {
   mGuiManager->getGui()->unregisterCallback("graphics.setEnableShadowFreeze");
   mGuiManager->getGui()->unregisterCallback("graphics.setEnableShadows");
   mGuiManager->getGui()->unregisterCallback("graphics.setEnableTimerQueries");
+  mGuiManager->getGui()->unregisterCallback("graphics.setEnableTracing");
+  mGuiManager->getGui()->unregisterCallback("graphics.saveTrace");
   mGuiManager->getGui()->unregisterCallback("graphics.setEnableVsync");
   mGuiManager->getGui()->unregisterCallback("graphics.setLightingQuality");
   mGuiManager->getGui()->unregisterCallback("graphics.setShadowmapBias");
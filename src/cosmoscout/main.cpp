@@ -16,6 +16,7 @@
 #include "Application.hpp"
 #include "cs-version.hpp"
 #include "logger.hpp"
+#include "textureComparison.hpp"
 
 #include <VistaKernel/VistaSystem.h>
 #include <spdlog/sinks/sink.h>
@@ -50,6 +51,7 @@ int main(int argc, char** argv) {
   bool        runTests       = false;
   bool        printHelp      = false;
   bool        printVistaHelp = false;
+  std::string compareTexture;
 
   // First configure all possible command line options.
   cs::utils::CommandLine args("Welcome to CosmoScout VR! Here are the available options:");
@@ -57,6 +59,8 @@ int main(int argc, char** argv) {
       "JSON file containing settings (default: " + settingsFile + ")");
   args.addArgument({"-h", "--help"}, &printHelp, "Print this help.");
   args.addArgument({"-v", "--vistahelp"}, &printVistaHelp, "Print help for vista options.");
+  args.addArgument({"--compare-texture"}, &compareTexture,
+      "Compare loading the given image file with and without texture compression.");
 
 #ifndef DOCTEST_CONFIG_DISABLE
   args.addArgument({"-t", "--run-tests"}, &runTests, "Runs all unit tests.");
@@ -112,6 +116,11 @@ int main(int argc, char** argv) {
   settings->pLogLevelScreen.connectAndTouch(
       [](auto level) { cs::utils::getLoggerSignalSink()->set_level(level); });
 
+  // When a texture was given for comparison, we compare its loading variants and exit.
+  if (!compareTexture.empty()) {
+    return compareTextureCompression(compareTexture, settings->mGraphics.pTextureCache.get());
+  }
+
   // Print a nifty welcome message!
   logger().info("Welcome to CosmoScout VR v" + CS_PROJECT_VERSION + "!");
 
@@ -0,0 +1,141 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "textureComparison.hpp"
+
+#include "../cs-graphics/TextureCompressor.hpp"
+#include "../cs-utils/filesystem.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double millisecondsSince(std::chrono::high_resolution_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+      std::chrono::high_resolution_clock::now() - start)
+      .count();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double toMegabytes(std::size_t bytes) {
+  return static_cast<double>(bytes) / 1024.0 / 1024.0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string getFormatName(gli::format format) {
+  switch (format) {
+  case gli::FORMAT_R_ATI1N_UNORM_BLOCK8:
+    return "BC4";
+  case gli::FORMAT_RG_ATI2N_UNORM_BLOCK16:
+    return "BC5";
+  case gli::FORMAT_RGB_DXT1_UNORM_BLOCK8:
+    return "BC1";
+  case gli::FORMAT_RGBA_DXT5_UNORM_BLOCK16:
+    return "BC3";
+  default:
+    return "unknown";
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The uncompressed textures are stored as RGBA with eight bits per channel and a full mipmap chain.
+std::size_t getUncompressedSize(uint32_t width, uint32_t height) {
+  std::size_t size = 0;
+
+  while (true) {
+    size += static_cast<std::size_t>(width) * height * 4;
+
+    if (width == 1 && height == 1) {
+      return size;
+    }
+
+    width  = std::max(1U, width / 2);
+    height = std::max(1U, height / 2);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The peak signal-to-noise ratio of all channels of the original image.
+double getPSNR(
+    cs::graphics::TextureLoader::Image const& original, gli::texture2d const& compressed) {
+  auto decompressed = cs::graphics::TextureCompressor::decompress(compressed);
+
+  double      sum   = 0.0;
+  std::size_t count = static_cast<std::size_t>(original.mWidth) * original.mHeight;
+
+  for (std::size_t i = 0; i < count; ++i) {
+    for (uint32_t c = 0; c < original.mChannels; ++c) {
+      double d = original.mPixels[i * original.mChannels + c] - decompressed.mPixels[i * 4 + c];
+      sum += d * d;
+    }
+  }
+
+  double mse = sum / static_cast<double>(count * original.mChannels);
+  return mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : INFINITY;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int compareTextureCompression(std::string const& fileName, std::string const& cacheDirectory) {
+  using cs::graphics::TextureCompressor;
+
+  // Without compression, the file is decoded on each start.
+  auto start = std::chrono::high_resolution_clock::now();
+
+  cs::graphics::TextureLoader::Image image;
+  if (!cs::graphics::TextureLoader::decodeFile(fileName, image)) {
+    return 1;
+  }
+
+  double decodeTime = millisecondsSince(start);
+
+  // With compression, the decoded image is compressed and stored on the first start.
+  start        = std::chrono::high_resolution_clock::now();
+  auto texture = TextureCompressor::compress(image);
+
+  double compressTime = millisecondsSince(start);
+
+  std::string cacheFile = cacheDirectory + "/" + TextureCompressor::getCacheFileName(fileName);
+  cs::utils::filesystem::createDirectoryRecursively(cacheDirectory);
+
+  if (!gli::save_dds(texture, cacheFile)) {
+    logger().error("Failed to write compressed texture '{}'!", cacheFile);
+    return 1;
+  }
+
+  // On all subsequent starts, the compressed texture is loaded from the cache.
+  start       = std::chrono::high_resolution_clock::now();
+  auto cached = TextureCompressor::loadCached(fileName, cacheDirectory);
+
+  double loadTime = millisecondsSince(start);
+
+  logger().info("Texture '{}' ({}x{} pixels, {} channels):", fileName, image.mWidth,
+      image.mHeight, image.mChannels);
+  logger().info("  Uncompressed: Decoding took {:.1f} ms, the texture needs {:.1f} MB.", decodeTime,
+      toMegabytes(getUncompressedSize(image.mWidth, image.mHeight)));
+  logger().info("  Compressed:   Compressing took {:.1f} ms, loading from the cache took "
+                "{:.1f} ms, the texture needs {:.1f} MB.",
+      compressTime, loadTime, toMegabytes(cached.size()));
+  logger().info("  Format: {}, PSNR: {:.1f} dB", getFormatName(texture.format()),
+      getPSNR(image, texture));
+
+  return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
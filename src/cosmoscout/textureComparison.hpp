@@ -0,0 +1,19 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CS_TEXTURE_COMPARISON_HPP
+#define CS_TEXTURE_COMPARISON_HPP
+
+#include <string>
+
+/// Loads the given image file once without and once with block compression, like the texture
+/// loader of the GraphicsEngine does it depending on the settings. The loading times, the required
+/// video memory and the compression error are logged. The compressed texture is stored in the given
+/// cache directory. This does not need an OpenGL context, so the upload times are not included.
+/// Returns zero on success.
+int compareTextureCompression(std::string const& fileName, std::string const& cacheDirectory);
+
+#endif // CS_TEXTURE_COMPARISON_HPP
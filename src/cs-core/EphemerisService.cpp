@@ -0,0 +1,242 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "EphemerisService.hpp"
+
+#include "../cs-utils/utils.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cspice/SpiceUsr.h>
+#include <mutex>
+
+namespace cs::core {
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Evaluates a single state with SPICE. The mutex is locked for each state individually, so that
+// other threads which call SPICE are not blocked for the duration of a whole batch.
+EphemerisService::State evaluate(std::string const& target, std::string const& observer,
+    std::string const& frame, double tTime) {
+  EphemerisService::State result;
+
+  std::array<double, 6> state{};
+  double                timeOfLight{};
+
+  std::lock_guard lock(utils::getSpiceMutex());
+  spkezr_c(target.c_str(), tTime, frame.c_str(), "NONE", observer.c_str(), state.data(),
+      &timeOfLight);
+
+  if (failed_c()) {
+    reset_c();
+    return result;
+  }
+
+  // Convert to our axis convention, see CelestialAnchor::getRelativePosition().
+  result.mPosition = glm::dvec3(state[1], state[2], state[0]) * 1000.0;
+  result.mVelocity = glm::dvec3(state[4], state[5], state[3]) * 1000.0;
+  result.mValid    = true;
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool EphemerisService::Samples::covers(double tTime) const {
+  if (mCount == 1) {
+    return tTime == mStart;
+  }
+
+  double u = (tTime - mStart) / mStep;
+  return u >= 0.0 && u <= mCount - 1.0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+EphemerisService::EphemerisService() = default;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+EphemerisService::~EphemerisService() = default;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::future<std::vector<EphemerisService::State>> EphemerisService::query(
+    std::vector<Query> queries) {
+  return mWorker.enqueue(
+      [queries = std::move(queries)]() {
+        std::vector<State> states(queries.size());
+
+        for (std::size_t i = 0; i < queries.size(); ++i) {
+          auto const& q = queries[i];
+          states[i]     = evaluate(q.mTarget, q.mObserver, q.mFrame, q.mTime);
+        }
+
+        return states;
+      },
+      mQueryHandle);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint64_t EphemerisService::addPrefetch(
+    std::string target, std::string observer, std::string frame) {
+  uint64_t id = ++mLastPrefetchId;
+  mPrefetches.emplace(id, Prefetch{std::move(target), std::move(observer), std::move(frame)});
+  ++mPrefetchVersion;
+  return id;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void EphemerisService::removePrefetch(uint64_t id) {
+  if (mPrefetches.erase(id) > 0) {
+    ++mPrefetchVersion;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void EphemerisService::setPrefetchFrames(uint32_t frames) {
+  mPrefetchFrames = std::max(frames, 1U);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t EphemerisService::getPrefetchFrames() const {
+  return mPrefetchFrames;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void EphemerisService::update(double tTime, double timeSpeed, double frameTime) {
+
+  // There is at most one prefetch batch in flight.
+  if (mPendingPrefetch.valid()) {
+    if (mPendingPrefetch.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+      return;
+    }
+
+    mPendingPrefetch.get();
+  }
+
+  if (mPrefetches.empty()) {
+    std::atomic_store(&mSamples, std::shared_ptr<Samples const>());
+    return;
+  }
+
+  double step    = timeSpeed * frameTime;
+  auto   samples = std::atomic_load(&mSamples);
+
+  // The current samples can be used further if they cover the current frame and at least half of
+  // the upcoming frames. If the time speed was increased, the samples may be too far apart for an
+  // accurate interpolation, so they are replaced as well.
+  if (samples && samples->mVersion == mPrefetchVersion && samples->covers(tTime)) {
+    if (step == 0.0) {
+      return;
+    }
+
+    if (samples->covers(tTime + 0.5 * mPrefetchFrames * step) && samples->mCount > 1 &&
+        std::abs(samples->mStep) <= 2.0 * std::abs(step)) {
+      return;
+    }
+  }
+
+  // If the time is paused, a single sample is sufficient.
+  uint32_t count = step == 0.0 ? 1 : mPrefetchFrames + 1;
+
+  std::vector<std::pair<uint64_t, Prefetch>> prefetches(mPrefetches.begin(), mPrefetches.end());
+
+  mPendingPrefetch = mWorker.enqueue([this, prefetches = std::move(prefetches), tTime, step, count,
+                                         version = mPrefetchVersion]() {
+    auto result      = std::make_shared<Samples>();
+    result->mStart   = tTime;
+    result->mStep    = step;
+    result->mCount   = count;
+    result->mVersion = version;
+
+    for (auto const& [id, prefetch] : prefetches) {
+      auto& states = result->mStates[id];
+      states.resize(count);
+
+      for (uint32_t i = 0; i < count; ++i) {
+        states[i] =
+            evaluate(prefetch.mTarget, prefetch.mObserver, prefetch.mFrame, tTime + i * step);
+      }
+    }
+
+    std::atomic_store(&mSamples, std::shared_ptr<Samples const>(std::move(result)));
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool EphemerisService::getPrefetchedState(uint64_t id, double tTime, State& state) const {
+  auto samples = std::atomic_load(&mSamples);
+
+  if (!samples || !samples->covers(tTime)) {
+    return false;
+  }
+
+  auto it = samples->mStates.find(id);
+
+  if (it == samples->mStates.end()) {
+    return false;
+  }
+
+  auto const& states = it->second;
+
+  if (samples->mCount == 1) {
+    if (!states[0].mValid) {
+      return false;
+    }
+
+    state = states[0];
+    return true;
+  }
+
+  double u = (tTime - samples->mStart) / samples->mStep;
+  auto   i = std::min(static_cast<uint32_t>(u), samples->mCount - 2);
+
+  State const& s0 = states[i];
+  State const& s1 = states[i + 1];
+
+  if (!s0.mValid || !s1.mValid) {
+    return false;
+  }
+
+  // Cubic Hermite interpolation between the two samples. The velocities are scaled by the step
+  // size, as the spline is parameterized over [0, 1].
+  double h  = samples->mStep;
+  double s  = u - i;
+  double s2 = s * s;
+  double s3 = s2 * s;
+
+  state.mPosition = (2.0 * s3 - 3.0 * s2 + 1.0) * s0.mPosition +
+                    (s3 - 2.0 * s2 + s) * h * s0.mVelocity + (-2.0 * s3 + 3.0 * s2) * s1.mPosition +
+                    (s3 - s2) * h * s1.mVelocity;
+
+  state.mVelocity =
+      ((6.0 * s2 - 6.0 * s) * s0.mPosition + (3.0 * s2 - 4.0 * s + 1.0) * h * s0.mVelocity +
+          (-6.0 * s2 + 6.0 * s) * s1.mPosition + (3.0 * s2 - 2.0 * s) * h * s1.mVelocity) /
+      h;
+
+  state.mValid = true;
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::core
@@ -0,0 +1,133 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CS_CORE_EPHEMERIS_SERVICE_HPP
+#define CS_CORE_EPHEMERIS_SERVICE_HPP
+
+#include "cs_core_export.hpp"
+
+#include "../cs-utils/ThreadPool.hpp"
+
+#include <future>
+#include <glm/glm.hpp>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cs::core {
+
+/// The EphemerisService evaluates SPICE on a single worker thread, so that code which needs many
+/// states (trajectories, labels, satellites, ...) does not have to block the frame. Requests are
+/// batched: a list of queries is evaluated in one go and the result is delivered via a std::future.
+///
+/// Additionally, target / observer / frame combinations can be registered for prefetching. Once
+/// per frame, update() is called with the current simulation time and time speed. The states of
+/// all registered combinations are then computed in advance for the next frames, so that
+/// getPrefetchedState() can answer queries for these frames without waiting for SPICE.
+///
+/// As CSPICE is not re-entrant, the worker locks cs::utils::getSpiceMutex() for each individual
+/// query. Code which calls SPICE directly has to lock this mutex as well. The service must only be
+/// used while SPICE is initialized, the SolarSystem takes care of this.
+class CS_CORE_EXPORT EphemerisService {
+ public:
+  /// The state of mTarget relative to mObserver in the reference frame mFrame at mTime.
+  struct Query {
+    std::string mTarget;
+    std::string mObserver;
+    std::string mFrame;
+    double      mTime = 0.0;
+  };
+
+  /// Position (in meters) and velocity (in meters per second) use the same axis convention as the
+  /// CelestialAnchor. If SPICE has no data for a query, mValid is false.
+  struct State {
+    glm::dvec3 mPosition{0.0};
+    glm::dvec3 mVelocity{0.0};
+    bool       mValid = false;
+  };
+
+  EphemerisService();
+
+  EphemerisService(EphemerisService const& other) = delete;
+  EphemerisService(EphemerisService&& other)      = delete;
+
+  EphemerisService& operator=(EphemerisService const& other) = delete;
+  EphemerisService& operator=(EphemerisService&& other) = delete;
+
+  /// Waits for all pending requests to be finished.
+  ~EphemerisService();
+
+  /// Evaluates all given queries on the worker thread. The resulting vector contains one state for
+  /// each query, in the same order. Requests are processed before pending prefetches. This method
+  /// is thread-safe.
+  std::future<std::vector<State>> query(std::vector<Query> queries);
+
+  /// Registers a target / observer / frame combination for prefetching. The returned id can be
+  /// used to retrieve the states with getPrefetchedState() and to remove it again.
+  uint64_t addPrefetch(std::string target, std::string observer, std::string frame);
+  void     removePrefetch(uint64_t id);
+
+  /// The number of upcoming frames for which the states are computed in advance. A new batch is
+  /// requested once less than half of these frames are covered. The default is 32.
+  void     setPrefetchFrames(uint32_t frames);
+  uint32_t getPrefetchFrames() const;
+
+  /// This should be called once each frame. The next frames are assumed to be at
+  /// tTime + i * timeSpeed * frameTime. If the prefetched states do not cover enough of these
+  /// frames (for example because the time speed changed or the user jumped in time), a new batch
+  /// is requested from the worker.
+  /// @param tTime     The current simulation time.
+  /// @param timeSpeed The ratio of simulation time to real time, see TimeControl::pTimeSpeed.
+  /// @param frameTime The real time in seconds between two frames.
+  void update(double tTime, double timeSpeed, double frameTime);
+
+  /// Returns the state of a registered prefetch at the given time. The state is interpolated from
+  /// the two neighboring samples with a cubic Hermite spline. This never blocks; if the time is not
+  /// covered by the prefetched samples (yet), false is returned and the state is not modified. This
+  /// method is thread-safe.
+  bool getPrefetchedState(uint64_t id, double tTime, State& state) const;
+
+ private:
+  struct Prefetch {
+    std::string mTarget;
+    std::string mObserver;
+    std::string mFrame;
+  };
+
+  /// The states of all prefetches at the times mStart + i * mStep with i in [0, mCount). Once it
+  /// has been published, this is never modified again.
+  struct Samples {
+    double                                           mStart   = 0.0;
+    double                                           mStep    = 0.0;
+    uint32_t                                         mCount   = 0;
+    uint64_t                                         mVersion = 0;
+    std::unordered_map<uint64_t, std::vector<State>> mStates;
+
+    /// Returns true if tTime lies within the sampled time interval.
+    bool covers(double tTime) const;
+  };
+
+  std::map<uint64_t, Prefetch> mPrefetches;
+  uint64_t                     mLastPrefetchId  = 0;
+  uint64_t                     mPrefetchVersion = 0;
+  uint32_t                     mPrefetchFrames  = 32;
+  std::future<void>            mPendingPrefetch;
+
+  // This must only be accessed with std::atomic_load and std::atomic_store.
+  std::shared_ptr<Samples const> mSamples;
+
+  // Requests have a higher priority than prefetches.
+  utils::TaskHandle mQueryHandle{1.0};
+
+  // This has to be the last member, as it waits for pending tasks which access the members above.
+  utils::ThreadPool mWorker{1};
+};
+
+} // namespace cs::core
+
+#endif // CS_CORE_EPHEMERIS_SERVICE_HPP
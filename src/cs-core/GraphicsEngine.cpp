@@ -6,6 +6,7 @@
 
 #include "GraphicsEngine.hpp"
 
+#include "../cs-graphics/AsyncTextureLoader.hpp"
 #include "../cs-graphics/ClearHDRBufferNode.hpp"
 #include "../cs-graphics/ToneMappingNode.hpp"
 #include "../cs-utils/utils.hpp"
@@ -86,6 +87,19 @@ GraphicsEngine::GraphicsEngine(std::shared_ptr<core::Settings> settings)
 
   mHDRBuffer = std::make_shared<graphics::HDRBuffer>(multiSamples);
 
+  // Plugins load their textures with this during initialization.
+  mTextureLoader = std::make_shared<graphics::AsyncTextureLoader>();
+
+  mSettings->mGraphics.pEnableTextureCompression.connectAndTouch([this](bool enable) {
+    mTextureLoader->setCompressionCache(enable ? mSettings->mGraphics.pTextureCache.get() : "");
+  });
+
+  mSettings->mGraphics.pTextureCache.connect([this](std::string const& directory) {
+    if (mSettings->mGraphics.pEnableTextureCompression.get()) {
+      mTextureLoader->setCompressionCache(directory);
+    }
+  });
+
   // Create a node which clears the HDRBuffer at the beginning of a frame (this will be enabled only
   // if HDR rendering is enabled).
   mClearNode        = std::make_shared<graphics::ClearHDRBufferNode>(mHDRBuffer);
@@ -212,6 +226,12 @@ std::shared_ptr<graphics::HDRBuffer> GraphicsEngine::getHDRBuffer() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+std::shared_ptr<graphics::AsyncTextureLoader> GraphicsEngine::getTextureLoader() const {
+  return mTextureLoader;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 bool glDebugOnlyErrors = true;
 
 void GLAPIENTRY oglMessageCallback(GLenum /*source*/, GLenum type, GLuint /*id*/, GLenum severity,
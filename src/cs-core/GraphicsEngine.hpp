@@ -16,6 +16,7 @@
 #include <memory>
 
 namespace cs::graphics {
+class AsyncTextureLoader;
 class ClearHDRBufferNode;
 class ToneMappingNode;
 } // namespace cs::graphics
@@ -51,6 +52,10 @@ class CS_CORE_EXPORT GraphicsEngine {
   std::shared_ptr<graphics::ShadowMap> getShadowMap() const;
   std::shared_ptr<graphics::HDRBuffer> getHDRBuffer() const;
 
+  /// Plugins should use this to load textures in the background. The application takes care of
+  /// uploading the loaded textures each frame.
+  std::shared_ptr<graphics::AsyncTextureLoader> getTextureLoader() const;
+
   static void enableGLDebug(bool onlyErrors = true);
   static void disableGLDebug();
 
@@ -62,6 +67,7 @@ class CS_CORE_EXPORT GraphicsEngine {
   std::shared_ptr<graphics::HDRBuffer>          mHDRBuffer;
   std::shared_ptr<graphics::ClearHDRBufferNode> mClearNode;
   std::shared_ptr<graphics::ToneMappingNode>    mToneMappingNode;
+  std::shared_ptr<graphics::AsyncTextureLoader> mTextureLoader;
 };
 
 } // namespace cs::core
@@ -419,8 +419,18 @@ void GuiManager::update() {
       json = "{}";
     }
 
-    mStatistics->callJavascript(
-        "CosmoScout.statistics.setData", json, GetVistaSystem()->GetFrameLoop()->GetFrameRate());
+    std::string counters("{");
+    for (auto const& [name, value] : mFrameTimings->getCounters()) {
+      counters += "\"" + name + "\":" + std::to_string(value) + ",";
+    }
+    counters.back() = '}';
+
+    if (counters.length() <= 1) {
+      counters = "{}";
+    }
+
+    mStatistics->callJavascript("CosmoScout.statistics.setData", json,
+        GetVistaSystem()->GetFrameLoop()->GetFrameRate(), counters);
   }
 
   // Update all entities of the Chromium Embedded Framework.
@@ -210,6 +210,8 @@ void from_json(nlohmann::json const& j, Settings::Graphics& o) {
   Settings::deserialize(j, "ambientBrightness", o.pAmbientBrightness);
   Settings::deserialize(j, "enableAutoGlow", o.pEnableAutoGlow);
   Settings::deserialize(j, "glowIntensity", o.pGlowIntensity);
+  Settings::deserialize(j, "enableTextureCompression", o.pEnableTextureCompression);
+  Settings::deserialize(j, "textureCache", o.pTextureCache);
 }
 
 void to_json(nlohmann::json& j, Settings::Graphics const& o) {
@@ -238,6 +240,8 @@ void to_json(nlohmann::json& j, Settings::Graphics const& o) {
   Settings::serialize(j, "ambientBrightness", o.pAmbientBrightness);
   Settings::serialize(j, "enableAutoGlow", o.pEnableAutoGlow);
   Settings::serialize(j, "glowIntensity", o.pGlowIntensity);
+  Settings::serialize(j, "enableTextureCompression", o.pEnableTextureCompression);
+  Settings::serialize(j, "textureCache", o.pTextureCache);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
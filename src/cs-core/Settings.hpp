@@ -404,6 +404,14 @@ class CS_CORE_EXPORT Settings {
 
     /// The amount of artifical glare. Has no effect if HDR rendering is disabled.
     utils::DefaultProperty<float> pGlowIntensity{0.5F};
+
+    /// If set to true, textures which are loaded with the texture loader of the GraphicsEngine are
+    /// block-compressed when they are loaded for the first time. This reduces their video memory
+    /// usage and the loading time of subsequent starts, at the cost of some image quality.
+    utils::DefaultProperty<bool> pEnableTextureCompression{false};
+
+    /// The directory where the compressed textures are stored.
+    utils::DefaultProperty<std::string> pTextureCache{"texture-cache"};
   };
 
   Graphics mGraphics;
@@ -8,9 +8,12 @@
 
 #include "SolarSystem.hpp"
 
+#include "../cs-scene/ChebyshevEphemeris.hpp"
+#include "../cs-scene/EphemerisTable.hpp"
 #include "../cs-utils/FrameTimings.hpp"
 #include "../cs-utils/convert.hpp"
 #include "../cs-utils/utils.hpp"
+#include "EphemerisService.hpp"
 #include "GraphicsEngine.hpp"
 #include "Settings.hpp"
 #include "TimeControl.hpp"
@@ -163,12 +166,31 @@ std::shared_ptr<scene::CelestialBody> SolarSystem::getBody(std::string const& sC
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+std::shared_ptr<EphemerisService> const& SolarSystem::getEphemerisService() const {
+  return mEphemerisService;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void SolarSystem::update() {
   double simulationTime(mTimeControl->pSimulationTime.get());
   double realTime(
       utils::convert::time::toSpice(boost::posix_time::microsec_clock::universal_time()));
   mObserver.updateMovementAnimation(realTime);
 
+  // Let the EphemerisService compute the states for the upcoming frames in the background.
+  if (mEphemerisService) {
+    double frameTime = mLastRealTime > 0.0 ? std::max(realTime - mLastRealTime, 0.0) : 0.0;
+    mEphemerisService->update(simulationTime, mTimeControl->pTimeSpeed.get(), frameTime);
+  }
+
+  mLastRealTime = realTime;
+
+  // Evaluate the positions of all centers and the orientations of all frames which are used by our
+  // anchors in one go. Afterwards, anchors can compute their relative positions for this frame
+  // without calling SPICE.
+  scene::EphemerisTable::update(simulationTime);
+
   mSun->update(simulationTime, mObserver);
   for (auto const& object : mAnchors) {
     object->update(simulationTime, mObserver);
@@ -455,6 +477,8 @@ void SolarSystem::flyObserverTo(
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void SolarSystem::printFrames() {
+  std::lock_guard lock(utils::getSpiceMutex());
+
   SPICEINT_CELL(ids, 1000); // NOLINT: Creates a c-array.
   bltfrm_c(SPICE_FRMTYP_ALL, &ids);
 
@@ -490,6 +514,7 @@ void SolarSystem::printFrames() {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void SolarSystem::init(std::string const& sSpiceMetaFile) {
+  std::lock_guard lock(utils::getSpiceMutex());
 
   std::string actionReturn = "RETURN";
   // Continue execution on errors.
@@ -510,7 +535,8 @@ void SolarSystem::init(std::string const& sSpiceMetaFile) {
     throw std::runtime_error(msg.data());
   }
 
-  mIsInitialized = true;
+  mEphemerisService = std::make_shared<EphemerisService>();
+  mIsInitialized    = true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -522,6 +548,10 @@ bool SolarSystem::getIsInitialized() const {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void SolarSystem::deinit() {
+  // Wait for all pending requests before the kernels are unloaded.
+  mEphemerisService.reset();
+
+  std::lock_guard lock(utils::getSpiceMutex());
   kclear_c();
   mIsInitialized = false;
 }
@@ -611,6 +641,8 @@ void SolarSystem::turnToObserver(scene::CelestialAnchor& anchor,
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 glm::dvec3 SolarSystem::getRadii(std::string const& sCenterName) {
+  std::lock_guard lock(utils::getSpiceMutex());
+
   // get target id code
   SpiceInt     id{};
   SpiceBoolean found{};
@@ -644,17 +676,16 @@ std::vector<glm::dvec4> SolarSystem::calculateTrajectory(std::string const& sCen
 
   double dLength(dEndTime - dStartTime);
 
-  scene::CelestialAnchor obs(sCenterName, sFrameName);
-  scene::CelestialAnchor body(sTargetName, sFrameName);
-
+  std::vector<double> vTimes(std::max(iSamples, 0));
   for (int i(0); i < iSamples; ++i) {
-    double dTime = dLength / iSamples * i;
-    try {
-      glm::dvec3 pos = obs.getRelativePosition(dTime + dStartTime, body);
-      vPoints.emplace_back(glm::dvec4(pos.x, pos.y, pos.z, dTime + dStartTime));
-    } catch (...) {}
+    vTimes[i] = dStartTime + dLength / iSamples * i;
   }
 
+  // Samples for which no data is available are skipped.
+  scene::ChebyshevEphemeris ephemeris(sCenterName, sFrameName, sTargetName, sFrameName);
+  ephemeris.setSegmentLength(std::max(dLength / std::max(iSamples, 1) * 64.0, 1.0));
+  ephemeris.sample(vTimes, vPoints);
+
   return vPoints;
 }
 
@@ -27,6 +27,7 @@ namespace cs::core {
 class Settings;
 class TimeControl;
 class GraphicsEngine;
+class EphemerisService;
 
 /// The solar system is responsible for managing all CelestialBodies, the Sun and the observer.
 /// It functions as an interface to access these above mentioned objects from nearly anywhere in
@@ -100,6 +101,11 @@ class CS_CORE_EXPORT SolarSystem {
   std::set<std::shared_ptr<scene::CelestialBody>> const& getBodies() const;
   std::shared_ptr<scene::CelestialBody>                  getBody(std::string const& sCenter) const;
 
+  /// The EphemerisService can be used to evaluate SPICE without blocking the main thread. It is
+  /// created by init() and destroyed by deinit(); before and after, this returns nullptr. Its
+  /// prefetches are updated by update() according to the current time speed.
+  std::shared_ptr<EphemerisService> const& getEphemerisService() const;
+
   /// Updates all CelestialAnchors, the Sun and the CelestialObservers animations.
   void update();
 
@@ -216,6 +222,7 @@ class CS_CORE_EXPORT SolarSystem {
   std::shared_ptr<utils::FrameTimings>              mFrameTimings;
   std::shared_ptr<GraphicsEngine>                   mGraphicsEngine;
   std::shared_ptr<TimeControl>                      mTimeControl;
+  std::shared_ptr<EphemerisService>                 mEphemerisService;
   scene::CelestialObserver                          mObserver;
   std::shared_ptr<scene::CelestialObject>           mSun;
   std::set<std::shared_ptr<scene::CelestialAnchor>> mAnchors;
@@ -232,6 +239,10 @@ class CS_CORE_EXPORT SolarSystem {
   // These are used for measuring the observer speed.
   glm::dvec3                                     mLastPosition = glm::dvec3(0.0);
   std::chrono::high_resolution_clock::time_point mLastTime;
+
+  // The real time of the last call to update(). This is used for the prefetching of the
+  // EphemerisService.
+  double mLastRealTime = 0.0;
 };
 
 } // namespace cs::core
@@ -0,0 +1,410 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "AsyncTextureLoader.hpp"
+
+#include "../cs-utils/utils.hpp"
+#include "logger.hpp"
+
+#include <GL/glew.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <utility>
+
+namespace cs::graphics {
+
+namespace {
+
+// The default of the maximum number of bytes uploaded each frame.
+const std::size_t DEFAULT_UPLOAD_BUDGET = 16 * 1024 * 1024;
+
+// Decoded images are kept for reuse as long as they take less memory than this in total.
+const std::size_t MAX_POOLED_BYTES = 256 * 1024 * 1024;
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+AsyncTextureLoader::Texture::Texture(
+    std::string fileName, std::shared_ptr<VistaTexture> placeholder)
+    : mFileName(std::move(fileName))
+    , mPlaceholder(std::move(placeholder)) {
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+VistaTexture* AsyncTextureLoader::Texture::get() const {
+  if (mTexture) {
+    return mTexture.get();
+  }
+
+  return mPlaceholder.get();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool AsyncTextureLoader::Texture::isReady() const {
+  return mTexture != nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool AsyncTextureLoader::Texture::hasFailed() const {
+  return mFailed;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string const& AsyncTextureLoader::Texture::getFileName() const {
+  return mFileName;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+AsyncTextureLoader::AsyncTextureLoader(std::size_t threads)
+    : mPlaceholder(std::make_shared<VistaTexture>(GL_TEXTURE_2D))
+    , mUploadBudget(DEFAULT_UPLOAD_BUDGET)
+    , mWorkers(threads) {
+
+  std::array<uint8_t, 4> gray{128, 128, 128, 255};
+  mPlaceholder->UploadTexture(1, 1, gray.data(), false);
+
+  glGenBuffers(static_cast<GLsizei>(mPixelBuffers.size()), mPixelBuffers.data());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+AsyncTextureLoader::~AsyncTextureLoader() {
+  for (auto const& job : mJobs) {
+    job.mTask.cancel();
+  }
+
+  glDeleteBuffers(static_cast<GLsizei>(mPixelBuffers.size()), mPixelBuffers.data());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<AsyncTextureLoader::Texture const> AsyncTextureLoader::loadFromFile(
+    std::string const& fileName) {
+
+  auto handle = std::make_shared<Texture>(fileName, mPlaceholder);
+
+  Job& job    = mJobs.emplace_back();
+  job.mHandle = handle;
+
+  // TGA files are loaded by Vista, this requires the OpenGL context.
+  if (utils::endsWith(fileName, ".tga")) {
+    job.mLoadWithVista = true;
+    return handle;
+  }
+
+  job.mFuture = mWorkers.enqueue(
+      [this, fileName, cacheDirectory = mCompressionCache]() {
+        Decoded result;
+
+        if (!cacheDirectory.empty()) {
+          result.mCompressed = TextureCompressor::loadCached(fileName, cacheDirectory);
+          return result;
+        }
+
+        result.mImage = acquireImage();
+
+        if (!TextureLoader::decodeFile(fileName, *result.mImage)) {
+          releaseImage(std::move(result.mImage));
+        }
+
+        return result;
+      },
+      job.mTask);
+
+  return handle;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void AsyncTextureLoader::setCompressionCache(std::string directory) {
+  mCompressionCache = std::move(directory);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string const& AsyncTextureLoader::getCompressionCache() const {
+  return mCompressionCache;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void AsyncTextureLoader::setUploadBudget(std::size_t bytesPerFrame) {
+  mUploadBudget = bytesPerFrame;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t AsyncTextureLoader::getUploadBudget() const {
+  return mUploadBudget;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void AsyncTextureLoader::update() {
+  std::size_t budget = std::max<std::size_t>(mUploadBudget, 1);
+
+  // The textures are uploaded in the order in which they have been requested. Textures which are
+  // still being decoded are skipped.
+  auto job = mJobs.begin();
+  while (job != mJobs.end() && budget > 0) {
+    auto handle = job->mHandle.lock();
+
+    // Nobody is interested in this texture anymore.
+    if (!handle) {
+      job->mTask.cancel();
+
+      if (job->mDecoded && job->mDecoded->mImage) {
+        releaseImage(std::move(job->mDecoded->mImage));
+      }
+
+      job = mJobs.erase(job);
+      continue;
+    }
+
+    if (job->mLoadWithVista) {
+      handle->mTexture = TextureLoader::loadFromFile(handle->mFileName);
+      handle->mFailed  = !handle->mTexture;
+
+      // We do not know how large the texture is, so it uses up the entire budget.
+      budget = 0;
+      job    = mJobs.erase(job);
+      continue;
+    }
+
+    if (!job->mDecoded) {
+      if (job->mFuture.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        ++job;
+        continue;
+      }
+
+      try {
+        job->mDecoded = job->mFuture.get();
+      } catch (std::exception const& e) {
+        logger().error("Failed to load '{}': {}", handle->mFileName, e.what());
+      }
+
+      if (!job->mDecoded || (!job->mDecoded->mImage && job->mDecoded->mCompressed.empty())) {
+        handle->mFailed = true;
+        job             = mJobs.erase(job);
+        continue;
+      }
+    }
+
+    if (job->mDecoded->mImage) {
+      budget -= std::min(budget, upload(*job, budget));
+    } else {
+      budget -= std::min(budget, uploadCompressed(*job, budget));
+    }
+
+    if (!job->mUploaded) {
+      ++job;
+      continue;
+    }
+
+    handle->mTexture = std::move(job->mTexture);
+
+    if (job->mDecoded->mImage) {
+      releaseImage(std::move(job->mDecoded->mImage));
+    }
+
+    job = mJobs.erase(job);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void AsyncTextureLoader::finish() {
+  while (!mJobs.empty()) {
+    update();
+
+    // Give the workers some time to decode the next image.
+    if (!mJobs.empty()) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t AsyncTextureLoader::getPendingCount() const {
+  return mJobs.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t AsyncTextureLoader::upload(Job& job, std::size_t budget) {
+  auto const& image   = *job.mDecoded->mImage;
+  auto        width   = static_cast<GLsizei>(image.mWidth);
+  auto        format  = static_cast<GLenum>(image.getPixelFormat());
+  std::size_t rowSize = static_cast<std::size_t>(image.mWidth) * image.mChannels;
+
+  // Allocate the storage of the texture once. It is filled over the following frames.
+  if (!job.mTexture) {
+    job.mTexture = std::make_unique<VistaTexture>(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, job.mTexture->GetId());
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, static_cast<GLsizei>(image.mHeight), 0, format,
+        GL_UNSIGNED_BYTE, nullptr);
+  } else {
+    glBindTexture(GL_TEXTURE_2D, job.mTexture->GetId());
+  }
+
+  auto rows = static_cast<uint32_t>(std::clamp<std::size_t>(
+      budget / std::max<std::size_t>(rowSize, 1), 1, image.mHeight - job.mUploadedRows));
+  std::size_t bytes = rows * rowSize;
+
+  if (fillPixelBuffer(image.mPixels.data() + job.mUploadedRows * rowSize, bytes)) {
+    // The rows of the decoded images are tightly packed.
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, static_cast<GLint>(job.mUploadedRows), width,
+        static_cast<GLsizei>(rows), format, GL_UNSIGNED_BYTE, nullptr);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  } else {
+    logger().warn("Failed to map pixel buffer for uploading '{}'!", job.mHandle.lock()->mFileName);
+  }
+
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+  job.mUploadedRows += rows;
+  job.mUploaded = job.mUploadedRows == image.mHeight;
+
+  // This is what VistaTexture::UploadTexture() does as well.
+  if (job.mUploaded) {
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  }
+
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  return bytes;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t AsyncTextureLoader::uploadCompressed(Job& job, std::size_t budget) {
+  auto const& texture = job.mDecoded->mCompressed;
+  auto        levels  = static_cast<GLsizei>(texture.levels());
+
+  gli::gl GL(gli::gl::PROFILE_GL33);
+  auto    format = GL.translate(texture.format(), texture.swizzles());
+
+  // Allocate the storage of all levels once. They are filled over the following frames.
+  if (!job.mTexture) {
+    job.mTexture = std::make_unique<VistaTexture>(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, job.mTexture->GetId());
+    glTexStorage2D(GL_TEXTURE_2D, levels, format.Internal, texture.extent().x, texture.extent().y);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+  } else {
+    glBindTexture(GL_TEXTURE_2D, job.mTexture->GetId());
+  }
+
+  // Each level consists of rows of blocks with four rows of texels each.
+  auto        extent    = texture.extent(job.mUploadedLevels);
+  auto        blockRows = static_cast<uint32_t>((extent.y + 3) / 4);
+  std::size_t rowSize   = texture.size(job.mUploadedLevels) / blockRows;
+
+  auto rows = static_cast<uint32_t>(
+      std::clamp<std::size_t>(budget / rowSize, 1, blockRows - job.mUploadedRows));
+  std::size_t bytes = rows * rowSize;
+
+  auto const* data = static_cast<uint8_t const*>(texture.data(0, 0, job.mUploadedLevels));
+
+  if (fillPixelBuffer(data + job.mUploadedRows * rowSize, bytes)) {
+    auto y      = static_cast<GLint>(job.mUploadedRows * 4);
+    auto height = std::min<GLsizei>(static_cast<GLsizei>(rows * 4), extent.y - y);
+    glCompressedTexSubImage2D(GL_TEXTURE_2D, static_cast<GLint>(job.mUploadedLevels), 0, y,
+        extent.x, height, format.Internal, static_cast<GLsizei>(bytes), nullptr);
+  } else {
+    logger().warn("Failed to map pixel buffer for uploading '{}'!", job.mHandle.lock()->mFileName);
+  }
+
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+  job.mUploadedRows += rows;
+
+  if (job.mUploadedRows == blockRows) {
+    job.mUploadedRows = 0;
+    ++job.mUploadedLevels;
+  }
+
+  job.mUploaded = job.mUploadedLevels == texture.levels();
+
+  if (job.mUploaded) {
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  }
+
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  return bytes;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool AsyncTextureLoader::fillPixelBuffer(uint8_t const* data, std::size_t bytes) {
+
+  // The previous storage of the buffer is orphaned, so that we do not have to wait until the GPU
+  // has finished reading it.
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mPixelBuffers.at(mNextPixelBuffer));
+  mNextPixelBuffer = (mNextPixelBuffer + 1) % mPixelBuffers.size();
+
+  glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(bytes), nullptr, GL_STREAM_DRAW);
+  void* target = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(bytes),
+      GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+
+  if (!target) {
+    return false;
+  }
+
+  std::memcpy(target, data, bytes);
+  glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::unique_ptr<TextureLoader::Image> AsyncTextureLoader::acquireImage() {
+  std::lock_guard lock(mImagePoolMutex);
+
+  if (mImagePool.empty()) {
+    return std::make_unique<TextureLoader::Image>();
+  }
+
+  auto image = std::move(mImagePool.back());
+  mImagePool.pop_back();
+  return image;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void AsyncTextureLoader::releaseImage(std::unique_ptr<TextureLoader::Image>&& image) {
+  std::lock_guard lock(mImagePoolMutex);
+
+  std::size_t pooledBytes = image->mPixels.capacity();
+  for (auto const& pooled : mImagePool) {
+    pooledBytes += pooled->mPixels.capacity();
+  }
+
+  if (pooledBytes <= MAX_POOLED_BYTES) {
+    mImagePool.push_back(std::move(image));
+  }
+
+  image.reset();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::graphics
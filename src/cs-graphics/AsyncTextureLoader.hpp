@@ -0,0 +1,168 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CS_GRAPHICS_ASYNC_TEXTURE_LOADER_HPP
+#define CS_GRAPHICS_ASYNC_TEXTURE_LOADER_HPP
+
+#include "cs_graphics_export.hpp"
+
+#include "../cs-utils/ThreadPool.hpp"
+#include "TextureCompressor.hpp"
+#include "TextureLoader.hpp"
+
+#include <VistaOGLExt/VistaTexture.h>
+#include <array>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace cs::graphics {
+
+/// The AsyncTextureLoader loads textures in the background. Image files are decoded on worker
+/// threads into pooled staging memory. Once per frame, update() has to be called on the thread
+/// which owns the OpenGL context; it uploads the decoded images via pixel buffer objects. In order
+/// to avoid frame drops, only a limited number of bytes is uploaded each frame, so a large texture
+/// may be uploaded over several frames.
+///
+/// loadFromFile() returns immediately. The returned handle provides a placeholder texture until
+/// the real texture has been uploaded completely. The GraphicsEngine has one instance of this
+/// class which is updated by the application; plugins should use this instance.
+///
+/// Optionally, the textures can be block-compressed with the TextureCompressor. See
+/// setCompressionCache() for details.
+class CS_GRAPHICS_EXPORT AsyncTextureLoader {
+ public:
+  /// The handle to a texture which is loaded in the background.
+  class CS_GRAPHICS_EXPORT Texture {
+   public:
+    explicit Texture(std::string fileName, std::shared_ptr<VistaTexture> placeholder);
+
+    /// Returns the loaded texture once it has been uploaded completely. Before this, and if the
+    /// texture could not be loaded, a placeholder of one gray pixel is returned. The returned
+    /// pointer may change once, so it should be queried whenever the texture is used.
+    VistaTexture* get() const;
+
+    /// Returns true once get() returns the loaded texture.
+    bool isReady() const;
+
+    /// Returns true if the file could not be loaded.
+    bool hasFailed() const;
+
+    std::string const& getFileName() const;
+
+   private:
+    friend class AsyncTextureLoader;
+
+    std::string                   mFileName;
+    std::shared_ptr<VistaTexture> mPlaceholder;
+    std::unique_ptr<VistaTexture> mTexture;
+    bool                          mFailed = false;
+  };
+
+  /// Creates a loader which decodes images on the given number of worker threads. This has to be
+  /// called on the thread which owns the OpenGL context.
+  explicit AsyncTextureLoader(std::size_t threads = 2);
+
+  AsyncTextureLoader(AsyncTextureLoader const& other) = delete;
+  AsyncTextureLoader(AsyncTextureLoader&& other)      = delete;
+
+  AsyncTextureLoader& operator=(AsyncTextureLoader const& other) = delete;
+  AsyncTextureLoader& operator=(AsyncTextureLoader&& other) = delete;
+
+  /// Cancels all pending decode tasks and waits for the running ones. Textures which have not been
+  /// uploaded yet will keep their placeholder.
+  ~AsyncTextureLoader();
+
+  /// Starts loading the given file and returns immediately. See TextureLoader::decodeFile() for the
+  /// supported formats; TGA files are loaded with TextureLoader::loadFromFile() during update().
+  /// If the returned handle is destroyed before the texture has been uploaded, loading is aborted.
+  std::shared_ptr<Texture const> loadFromFile(std::string const& fileName);
+
+  /// If set to a directory, images are block-compressed when they are loaded for the first time and
+  /// the results are stored in this directory. Subsequent loads of the same images read the
+  /// compressed textures from there, which is much faster than decoding the original files. The
+  /// compressed textures also need much less video memory. An empty string disables compression;
+  /// this is the default. Changes only affect textures which are requested afterwards.
+  void               setCompressionCache(std::string directory);
+  std::string const& getCompressionCache() const;
+
+  /// The maximum number of bytes which are uploaded by update(). At least one row of an image is
+  /// uploaded each frame. The default is 16 MB.
+  void        setUploadBudget(std::size_t bytesPerFrame);
+  std::size_t getUploadBudget() const;
+
+  /// Uploads decoded images to the GPU. This should be called once each frame on the thread which
+  /// owns the OpenGL context.
+  void update();
+
+  /// Calls update() until all textures have been loaded. This blocks the calling thread and is
+  /// meant for situations where the textures are required immediately, e.g. for tests.
+  void finish();
+
+  /// Returns the number of textures which have not been uploaded yet.
+  std::size_t getPendingCount() const;
+
+ private:
+  /// The result of a decode task. Depending on the compression cache, either the image or the
+  /// compressed texture is set. If both are empty, the file could not be loaded.
+  struct Decoded {
+    std::unique_ptr<TextureLoader::Image> mImage;
+    gli::texture2d                        mCompressed;
+  };
+
+  struct Job {
+    std::weak_ptr<Texture>        mHandle;
+    utils::TaskHandle             mTask;
+    bool                          mLoadWithVista = false;
+    std::future<Decoded>          mFuture;
+    std::optional<Decoded>        mDecoded;
+    std::unique_ptr<VistaTexture> mTexture;
+    bool                          mUploaded = false;
+
+    /// The upload progress. For compressed textures, the rows are counted in blocks.
+    uint32_t mUploadedLevels = 0;
+    uint32_t mUploadedRows   = 0;
+  };
+
+  /// Uploads the next rows of the given job, at least one and at most as many as fit into the given
+  /// budget. Returns the number of uploaded bytes.
+  std::size_t upload(Job& job, std::size_t budget);
+  std::size_t uploadCompressed(Job& job, std::size_t budget);
+
+  /// Copies the given data into the next pixel buffer object which is left bound to
+  /// GL_PIXEL_UNPACK_BUFFER. Returns false if the buffer could not be mapped.
+  bool fillPixelBuffer(uint8_t const* data, std::size_t bytes);
+
+  std::unique_ptr<TextureLoader::Image> acquireImage();
+  void releaseImage(std::unique_ptr<TextureLoader::Image>&& image);
+
+  /// The pixel buffer objects are used round-robin so that an upload does not have to wait for the
+  /// previous one.
+  static const std::size_t PIXEL_BUFFER_COUNT = 3;
+
+  std::shared_ptr<VistaTexture>            mPlaceholder;
+  std::array<uint32_t, PIXEL_BUFFER_COUNT> mPixelBuffers{};
+  std::size_t                              mNextPixelBuffer = 0;
+  std::size_t                              mUploadBudget;
+  std::string                              mCompressionCache;
+  std::list<Job>                           mJobs;
+
+  /// Decoded images are kept for reuse once they have been uploaded, up to a limited amount of
+  /// memory. This is accessed by the worker threads.
+  std::mutex                                         mImagePoolMutex;
+  std::vector<std::unique_ptr<TextureLoader::Image>> mImagePool;
+
+  /// This is declared last so that it is destroyed first, as the tasks access the image pool.
+  utils::ThreadPool mWorkers;
+};
+
+} // namespace cs::graphics
+
+#endif // CS_GRAPHICS_ASYNC_TEXTURE_LOADER_HPP
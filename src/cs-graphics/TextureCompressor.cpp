@@ -0,0 +1,549 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "TextureCompressor.hpp"
+
+#include "../cs-utils/ThreadPool.hpp"
+#include "../cs-utils/filesystem.hpp"
+#include "../cs-utils/utils.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <array>
+#include <boost/filesystem.hpp>
+#include <cstdlib>
+#include <fstream>
+#include <glm/glm.hpp>
+#include <limits>
+#include <spdlog/fmt/fmt.h>
+#include <stdexcept>
+#include <vector>
+
+namespace cs::graphics {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const uint32_t TextureCompressor::cVersion = 1;
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// All supported formats consist of blocks of 4x4 texels.
+const uint32_t BLOCK_SIZE = 4;
+
+// The texels of one block, row by row. Unused channels are zero.
+using Block = std::array<std::array<uint8_t, 4>, 16>;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool isOpaque(TextureLoader::Image const& image) {
+  if (image.mChannels != 4) {
+    return true;
+  }
+
+  for (std::size_t i = 3; i < image.mPixels.size(); i += 4) {
+    if (image.mPixels[i] != 255) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+gli::format getFormat(TextureLoader::Image const& image) {
+  switch (image.mChannels) {
+  case 1:
+    return gli::FORMAT_R_ATI1N_UNORM_BLOCK8;
+  case 2:
+    return gli::FORMAT_RG_ATI2N_UNORM_BLOCK16;
+  default:
+    return isOpaque(image) ? gli::FORMAT_RGB_DXT1_UNORM_BLOCK8
+                           : gli::FORMAT_RGBA_DXT5_UNORM_BLOCK16;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Halves the size of the given image with a box filter. Odd rows and columns are merged into their
+// neighbors.
+void downsample(TextureLoader::Image const& source, TextureLoader::Image& target) {
+  target.mWidth    = std::max(1U, source.mWidth / 2);
+  target.mHeight   = std::max(1U, source.mHeight / 2);
+  target.mChannels = source.mChannels;
+  target.mPixels.resize(
+      static_cast<std::size_t>(target.mWidth) * target.mHeight * target.mChannels);
+
+  utils::parallelFor(target.mHeight, [&](uint32_t y) {
+    uint32_t y0 = std::min(y * 2, source.mHeight - 1);
+    uint32_t y1 = std::min(y * 2 + 1, source.mHeight - 1);
+
+    for (uint32_t x = 0; x < target.mWidth; ++x) {
+      uint32_t x0 = std::min(x * 2, source.mWidth - 1);
+      uint32_t x1 = std::min(x * 2 + 1, source.mWidth - 1);
+
+      for (uint32_t c = 0; c < source.mChannels; ++c) {
+        auto get = [&](uint32_t sx, uint32_t sy) {
+          std::size_t texel = static_cast<std::size_t>(sy) * source.mWidth + sx;
+          return static_cast<uint32_t>(source.mPixels[texel * source.mChannels + c]);
+        };
+
+        target.mPixels[(static_cast<std::size_t>(y) * target.mWidth + x) * target.mChannels + c] =
+            static_cast<uint8_t>((get(x0, y0) + get(x1, y0) + get(x0, y1) + get(x1, y1) + 2) / 4);
+      }
+    }
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Reads the texels of the given block. Texels outside of the image are clamped to its edges.
+Block fetchBlock(TextureLoader::Image const& image, uint32_t blockX, uint32_t blockY) {
+  Block block{};
+
+  for (uint32_t y = 0; y < BLOCK_SIZE; ++y) {
+    uint32_t py = std::min(blockY * BLOCK_SIZE + y, image.mHeight - 1);
+
+    for (uint32_t x = 0; x < BLOCK_SIZE; ++x) {
+      uint32_t    px    = std::min(blockX * BLOCK_SIZE + x, image.mWidth - 1);
+      std::size_t texel = (static_cast<std::size_t>(py) * image.mWidth + px) * image.mChannels;
+
+      for (uint32_t c = 0; c < image.mChannels; ++c) {
+        block.at(y * BLOCK_SIZE + x).at(c) = image.mPixels[texel + c];
+      }
+    }
+  }
+
+  return block;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint16_t toRGB565(glm::vec3 const& color) {
+  glm::vec3 c = glm::clamp(color, 0.F, 255.F);
+  auto      r = static_cast<uint16_t>(c.x * 31.F / 255.F + 0.5F);
+  auto      g = static_cast<uint16_t>(c.y * 63.F / 255.F + 0.5F);
+  auto      b = static_cast<uint16_t>(c.z * 31.F / 255.F + 0.5F);
+  return static_cast<uint16_t>((r << 11U) | (g << 5U) | b);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::ivec3 fromRGB565(uint16_t color) {
+  int r = (color >> 11U) & 31U;
+  int g = (color >> 5U) & 63U;
+  int b = color & 31U;
+  return {(r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2)};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The four colors of a BC1 block. If the first endpoint is not larger than the second, the block
+// has only three colors and the fourth is black.
+std::array<glm::ivec3, 4> getBC1Palette(uint16_t e0, uint16_t e1) {
+  std::array<glm::ivec3, 4> palette{fromRGB565(e0), fromRGB565(e1)};
+
+  if (e0 > e1) {
+    palette[2] = (palette[0] * 2 + palette[1]) / 3;
+    palette[3] = (palette[0] + palette[1] * 2) / 3;
+  } else {
+    palette[2] = (palette[0] + palette[1]) / 2;
+    palette[3] = glm::ivec3(0);
+  }
+
+  return palette;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The endpoints are chosen along the principal axis of the block's colors. They are moved inwards a
+// bit, as the extreme colors are usually outliers.
+void encodeBC1(Block const& block, uint8_t* target) {
+  glm::vec3 mean(0.F);
+  for (auto const& texel : block) {
+    mean += glm::vec3(texel[0], texel[1], texel[2]);
+  }
+  mean /= 16.F;
+
+  glm::mat3 covariance(0.F);
+  for (auto const& texel : block) {
+    glm::vec3 d = glm::vec3(texel[0], texel[1], texel[2]) - mean;
+    covariance += glm::outerProduct(d, d);
+  }
+
+  // A few steps of power iteration are sufficient to find the principal axis.
+  glm::vec3 axis(1.F);
+  for (int i = 0; i < 4; ++i) {
+    glm::vec3 next = covariance * axis;
+    float     len  = glm::length(next);
+    if (len < 1e-6F) {
+      break;
+    }
+    axis = next / len;
+  }
+
+  float minT = 0.F;
+  float maxT = 0.F;
+  for (auto const& texel : block) {
+    float t = glm::dot(glm::vec3(texel[0], texel[1], texel[2]) - mean, axis);
+    minT    = std::min(minT, t);
+    maxT    = std::max(maxT, t);
+  }
+
+  glm::vec3 inset = axis * (maxT - minT) / 32.F;
+  uint16_t  e0    = toRGB565(mean + axis * maxT - inset);
+  uint16_t  e1    = toRGB565(mean + axis * minT + inset);
+
+  // The first endpoint has to be the larger one in order to get four colors.
+  if (e0 < e1) {
+    std::swap(e0, e1);
+  }
+
+  uint32_t indices = 0;
+
+  if (e0 != e1) {
+    auto palette = getBC1Palette(e0, e1);
+
+    for (std::size_t i = 0; i < block.size(); ++i) {
+      glm::ivec3 color(block[i][0], block[i][1], block[i][2]);
+      uint32_t   best     = 0;
+      int        bestDist = std::numeric_limits<int>::max();
+
+      for (uint32_t p = 0; p < 4; ++p) {
+        glm::ivec3 d    = color - palette.at(p);
+        int        dist = d.x * d.x + d.y * d.y + d.z * d.z;
+        if (dist < bestDist) {
+          best     = p;
+          bestDist = dist;
+        }
+      }
+
+      indices |= best << (2 * i);
+    }
+  }
+
+  target[0] = static_cast<uint8_t>(e0 & 0xFFU);
+  target[1] = static_cast<uint8_t>(e0 >> 8U);
+  target[2] = static_cast<uint8_t>(e1 & 0xFFU);
+  target[3] = static_cast<uint8_t>(e1 >> 8U);
+
+  for (int i = 0; i < 4; ++i) {
+    target[4 + i] = static_cast<uint8_t>(indices >> (8 * i));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void decodeBC1(uint8_t const* source, Block& block, bool forceFourColors) {
+  auto e0 = static_cast<uint16_t>(source[0] | (source[1] << 8U));
+  auto e1 = static_cast<uint16_t>(source[2] | (source[3] << 8U));
+
+  auto palette = getBC1Palette(e0, e1);
+  if (forceFourColors && e0 <= e1) {
+    palette[2] = (palette[0] * 2 + palette[1]) / 3;
+    palette[3] = (palette[0] + palette[1] * 2) / 3;
+  }
+
+  for (std::size_t i = 0; i < block.size(); ++i) {
+    uint32_t index = (source[4 + i / 4] >> (2 * (i % 4))) & 3U;
+    block[i][0]    = static_cast<uint8_t>(palette.at(index).x);
+    block[i][1]    = static_cast<uint8_t>(palette.at(index).y);
+    block[i][2]    = static_cast<uint8_t>(palette.at(index).z);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The eight values of a BC4 block. The encoder always uses the mode where the first endpoint is the
+// larger one.
+std::array<int, 8> getBC4Palette(int e0, int e1) {
+  std::array<int, 8> palette{e0, e1};
+
+  if (e0 > e1) {
+    for (int i = 2; i < 8; ++i) {
+      palette.at(i) = ((8 - i) * e0 + (i - 1) * e1) / 7;
+    }
+  } else {
+    for (int i = 2; i < 6; ++i) {
+      palette.at(i) = ((6 - i) * e0 + (i - 1) * e1) / 5;
+    }
+    palette[6] = 0;
+    palette[7] = 255;
+  }
+
+  return palette;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void encodeBC4(Block const& block, uint32_t channel, uint8_t* target) {
+  int e0 = 0;
+  int e1 = 255;
+
+  for (auto const& texel : block) {
+    e0 = std::max<int>(e0, texel.at(channel));
+    e1 = std::min<int>(e1, texel.at(channel));
+  }
+
+  uint64_t indices = 0;
+
+  if (e0 != e1) {
+    auto palette = getBC4Palette(e0, e1);
+
+    for (std::size_t i = 0; i < block.size(); ++i) {
+      uint64_t best     = 0;
+      int      bestDist = 256;
+
+      for (uint32_t p = 0; p < 8; ++p) {
+        int dist = std::abs(block[i].at(channel) - palette.at(p));
+        if (dist < bestDist) {
+          best     = p;
+          bestDist = dist;
+        }
+      }
+
+      indices |= best << (3 * i);
+    }
+  }
+
+  target[0] = static_cast<uint8_t>(e0);
+  target[1] = static_cast<uint8_t>(e1);
+
+  for (int i = 0; i < 6; ++i) {
+    target[2 + i] = static_cast<uint8_t>(indices >> (8 * i));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void decodeBC4(uint8_t const* source, uint32_t channel, Block& block) {
+  auto palette = getBC4Palette(source[0], source[1]);
+
+  uint64_t indices = 0;
+  for (int i = 0; i < 6; ++i) {
+    indices |= static_cast<uint64_t>(source[2 + i]) << (8 * i);
+  }
+
+  for (std::size_t i = 0; i < block.size(); ++i) {
+    block[i].at(channel) = static_cast<uint8_t>(palette.at((indices >> (3 * i)) & 7U));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t getBlockBytes(gli::format format) {
+  if (format == gli::FORMAT_R_ATI1N_UNORM_BLOCK8 || format == gli::FORMAT_RGB_DXT1_UNORM_BLOCK8) {
+    return 8;
+  }
+
+  return 16;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void encodeBlock(Block const& block, gli::format format, uint8_t* target) {
+  switch (format) {
+  case gli::FORMAT_R_ATI1N_UNORM_BLOCK8:
+    encodeBC4(block, 0, target);
+    break;
+  case gli::FORMAT_RG_ATI2N_UNORM_BLOCK16:
+    encodeBC4(block, 0, target);
+    encodeBC4(block, 1, target + 8);
+    break;
+  case gli::FORMAT_RGB_DXT1_UNORM_BLOCK8:
+    encodeBC1(block, target);
+    break;
+  default:
+    encodeBC4(block, 3, target);
+    encodeBC1(block, target + 8);
+    break;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void decodeBlock(uint8_t const* source, gli::format format, Block& block) {
+  for (auto& texel : block) {
+    texel = {0, 0, 0, 255};
+  }
+
+  switch (format) {
+  case gli::FORMAT_R_ATI1N_UNORM_BLOCK8:
+    decodeBC4(source, 0, block);
+    break;
+  case gli::FORMAT_RG_ATI2N_UNORM_BLOCK16:
+    decodeBC4(source, 0, block);
+    decodeBC4(source + 8, 1, block);
+    break;
+  case gli::FORMAT_RGB_DXT1_UNORM_BLOCK8:
+    decodeBC1(source, block, false);
+    break;
+  default:
+    decodeBC4(source, 3, block);
+    decodeBC1(source + 8, block, true);
+    break;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+gli::texture2d TextureCompressor::compress(TextureLoader::Image const& image) {
+  auto           format = getFormat(image);
+  gli::texture2d texture(
+      format, gli::extent2d(static_cast<int>(image.mWidth), static_cast<int>(image.mHeight)));
+
+  // Each level is computed from the previous one. The given image is used for the first level, so
+  // only the smaller levels have to be stored.
+  TextureLoader::Image const* current = &image;
+  TextureLoader::Image        previous;
+  TextureLoader::Image        next;
+
+  for (std::size_t level = 0; level < texture.levels(); ++level) {
+    if (level > 0) {
+      downsample(*current, next);
+      std::swap(previous, next);
+      current = &previous;
+    }
+
+    uint32_t    blocksX    = (current->mWidth + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    uint32_t    blocksY    = (current->mHeight + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    std::size_t blockBytes = getBlockBytes(format);
+    auto*       target     = static_cast<uint8_t*>(texture.data(0, 0, level));
+
+    utils::parallelFor(blocksY, [&](uint32_t y) {
+      for (uint32_t x = 0; x < blocksX; ++x) {
+        encodeBlock(fetchBlock(*current, x, y), format,
+            target + (static_cast<std::size_t>(y) * blocksX + x) * blockBytes);
+      }
+    });
+  }
+
+  return texture;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TextureLoader::Image TextureCompressor::decompress(
+    gli::texture2d const& texture, std::size_t level) {
+  auto extent = texture.extent(level);
+
+  TextureLoader::Image image;
+  image.mWidth    = static_cast<uint32_t>(extent.x);
+  image.mHeight   = static_cast<uint32_t>(extent.y);
+  image.mChannels = 4;
+  image.mPixels.resize(static_cast<std::size_t>(image.mWidth) * image.mHeight * 4);
+
+  uint32_t    blocksX    = (image.mWidth + BLOCK_SIZE - 1) / BLOCK_SIZE;
+  uint32_t    blocksY    = (image.mHeight + BLOCK_SIZE - 1) / BLOCK_SIZE;
+  std::size_t blockBytes = getBlockBytes(texture.format());
+  auto const* source     = static_cast<uint8_t const*>(texture.data(0, 0, level));
+
+  Block block{};
+
+  for (uint32_t by = 0; by < blocksY; ++by) {
+    for (uint32_t bx = 0; bx < blocksX; ++bx) {
+      decodeBlock(source + (static_cast<std::size_t>(by) * blocksX + bx) * blockBytes,
+          texture.format(), block);
+
+      for (uint32_t y = 0; y < BLOCK_SIZE && by * BLOCK_SIZE + y < image.mHeight; ++y) {
+        for (uint32_t x = 0; x < BLOCK_SIZE && bx * BLOCK_SIZE + x < image.mWidth; ++x) {
+          std::size_t texel =
+              (static_cast<std::size_t>(by * BLOCK_SIZE + y) * image.mWidth + bx * BLOCK_SIZE + x) *
+              4;
+          std::copy(block.at(y * BLOCK_SIZE + x).begin(), block.at(y * BLOCK_SIZE + x).end(),
+              image.mPixels.begin() + static_cast<std::ptrdiff_t>(texel));
+        }
+      }
+    }
+  }
+
+  return image;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string TextureCompressor::getCacheFileName(std::string const& fileName) {
+  std::ifstream file(fileName, std::ios::in | std::ios::binary);
+
+  if (!file.is_open()) {
+    return "";
+  }
+
+  // Hash of the version and the file's content.
+  utils::Fnv1aHash hash;
+  hash.add(cVersion);
+
+  std::vector<char> buffer(1024 * 1024);
+
+  while (file) {
+    file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    hash.add(buffer.data(), static_cast<std::size_t>(file.gcount()));
+  }
+
+  return fmt::format("texture-{:016x}.dds", hash.get());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+gli::texture2d TextureCompressor::loadCached(
+    std::string const& fileName, std::string const& cacheDirectory) {
+
+  std::string cacheFile = getCacheFileName(fileName);
+
+  if (!cacheFile.empty()) {
+    cacheFile = cacheDirectory + "/" + cacheFile;
+
+    gli::texture2d texture(gli::load_dds(cacheFile));
+    if (!texture.empty()) {
+      logger().debug("Loaded compressed version of '{}' from '{}'.", fileName, cacheFile);
+      return texture;
+    }
+  }
+
+  TextureLoader::Image image;
+  if (!TextureLoader::decodeFile(fileName, image)) {
+    return {};
+  }
+
+  logger().info("Compressing texture '{}'...", fileName);
+
+  auto texture = compress(image);
+
+  // The file is written under a unique temporary name first and then renamed, so that other
+  // threads or instances never see an incomplete file. If several of them compress the same
+  // texture, each writes its own temporary file and the last rename wins.
+  if (!cacheFile.empty()) {
+    utils::filesystem::createDirectoryRecursively(cacheDirectory);
+
+    std::string tmpFile =
+        cacheFile + "." + boost::filesystem::unique_path("%%%%%%%%%%%%%%%%").string() + ".tmp";
+
+    try {
+      if (!gli::save_dds(texture, tmpFile)) {
+        throw std::runtime_error("Cannot open file for writing.");
+      }
+
+      boost::filesystem::rename(tmpFile, cacheFile);
+    } catch (std::exception const& e) {
+      logger().warn("Failed to write compressed texture '{}': {}", cacheFile, e.what());
+
+      boost::system::error_code error;
+      boost::filesystem::remove(tmpFile, error);
+    }
+  }
+
+  return texture;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::graphics
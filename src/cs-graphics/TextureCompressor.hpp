@@ -0,0 +1,58 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CS_GRAPHICS_TEXTURE_COMPRESSOR_HPP
+#define CS_GRAPHICS_TEXTURE_COMPRESSOR_HPP
+
+#include "cs_graphics_export.hpp"
+
+#include "TextureLoader.hpp"
+
+#include <gli/gli.hpp>
+#include <string>
+
+namespace cs::graphics {
+
+/// The TextureCompressor converts decoded images into block-compressed textures with a full mipmap
+/// chain. These need between an eighth and a quarter of the video memory of uncompressed RGBA
+/// textures and can be uploaded without any further processing. The format depends on the number
+/// of channels of the image:
+///  - One channel:  BC4 (RGTC1)
+///  - Two channels: BC5 (RGTC2)
+///  - Three channels or four channels without transparent pixels: BC1 (DXT1)
+///  - Four channels with transparent pixels: BC3 (DXT5)
+///
+/// Compressing a large image takes a while, so the results are meant to be stored in a cache
+/// directory as DDS files. See loadCached() for details.
+class CS_GRAPHICS_EXPORT TextureCompressor {
+ public:
+  /// Increase this if the encoder changed. This will force all cached textures to be recompressed.
+  static const uint32_t cVersion;
+
+  /// Creates the mipmaps of the given image and encodes all of them. This uses all available CPU
+  /// cores and should be called from a background thread.
+  static gli::texture2d compress(TextureLoader::Image const& image);
+
+  /// Decodes the given level of a texture which has been created by compress(). The result always
+  /// has four channels; missing channels are filled like OpenGL does it when sampling the texture.
+  /// This is rather slow and meant for tests and quality comparisons.
+  static TextureLoader::Image decompress(gli::texture2d const& texture, std::size_t level = 0);
+
+  /// Returns a file name which is unique for the content of the given file and the current
+  /// version. The entire file is read for this, which is still much faster than decoding it.
+  /// Returns an empty string if the file cannot be read.
+  static std::string getCacheFileName(std::string const& fileName);
+
+  /// Returns the compressed version of the given image file. If it is not in the given cache
+  /// directory yet, the file is decoded with TextureLoader::decodeFile(), compressed and stored in
+  /// the cache directory. Any modification of the file leads to a new cache entry. Returns an empty
+  /// texture if the file could not be decoded. This can be called from any thread.
+  static gli::texture2d loadCached(std::string const& fileName, std::string const& cacheDirectory);
+};
+
+} // namespace cs::graphics
+
+#endif // CS_GRAPHICS_TEXTURE_COMPRESSOR_HPP
@@ -22,6 +22,24 @@ namespace cs::graphics {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+uint32_t TextureLoader::Image::getPixelFormat() const {
+  if (mChannels == 1) {
+    return GL_RED;
+  }
+
+  if (mChannels == 2) {
+    return GL_RG;
+  }
+
+  if (mChannels == 3) {
+    return GL_RGB;
+  }
+
+  return GL_RGBA;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 std::unique_ptr<VistaTexture> TextureLoader::loadFromFile(std::string const& sFileName) {
 
   std::string suffix = sFileName.substr(sFileName.rfind('.'));
@@ -32,7 +50,29 @@ std::unique_ptr<VistaTexture> TextureLoader::loadFromFile(std::string const& sFi
     return std::unique_ptr<VistaTexture>(VistaOGLUtils::LoadTextureFromTga(sFileName));
   }
 
+  Image image;
+
+  if (!decodeFile(sFileName, image)) {
+    return nullptr;
+  }
+
   std::unique_ptr<VistaTexture> result = std::make_unique<VistaTexture>(GL_TEXTURE_2D);
+  result->UploadTexture(static_cast<int>(image.mWidth), static_cast<int>(image.mHeight),
+      image.mPixels.data(), true, image.getPixelFormat());
+
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TextureLoader::decodeFile(std::string const& sFileName, Image& image) {
+
+  std::string suffix = sFileName.substr(sFileName.rfind('.'));
+
+  if (suffix == ".tga") {
+    logger().error("Failed to decode '{}': TGA files can only be loaded with Vista!", sFileName);
+    return false;
+  }
 
   if (suffix == ".tiff" || suffix == ".tif") {
     // load with tifflib
@@ -41,7 +81,7 @@ std::unique_ptr<VistaTexture> TextureLoader::loadFromFile(std::string const& sFi
     auto* data = TIFFOpen(sFileName.c_str(), "r");
     if (!data) {
       logger().error("Failed to load '{}' with libtiff!", sFileName);
-      return nullptr;
+      return false;
     }
 
     uint32 width{};
@@ -59,50 +99,48 @@ std::unique_ptr<VistaTexture> TextureLoader::loadFromFile(std::string const& sFi
       logger().error(
           "Failed to load '{}' with libtiff: Only 8 bit per sample are supported right now!",
           sFileName);
-      return nullptr;
+      TIFFClose(data);
+      return false;
     }
 
-    std::vector<char> pixels(width * height * channels);
-
-    for (unsigned y = 0; y < height; y++) {
-      TIFFReadScanline(data, &pixels[width * channels * y], y);
-    }
+    image.mWidth    = width;
+    image.mHeight   = height;
+    image.mChannels = static_cast<uint32_t>(channels);
+    image.mPixels.resize(static_cast<std::size_t>(width) * height * image.mChannels);
 
-    GLenum ePixelFormat = GL_RGBA;
+    std::size_t rowSize = static_cast<std::size_t>(width) * image.mChannels;
 
-    if (channels == 1) {
-      ePixelFormat = GL_RED;
-    } else if (channels == 2) {
-      ePixelFormat = GL_RG;
-    } else if (channels == 3) {
-      ePixelFormat = GL_RGB;
+    for (unsigned y = 0; y < height; y++) {
+      TIFFReadScanline(data, &image.mPixels[rowSize * y], y);
     }
 
-    result->UploadTexture(width, height, pixels.data(), true, ePixelFormat);
-
     TIFFClose(data);
-  } else {
-    // load with stb image
-    logger().debug("Loading Texture '{}' with stbi.", sFileName);
-
-    int width{};
-    int height{};
-    int bpp{};
-    int channels = 4;
+    return true;
+  }
 
-    unsigned char* pixels = stbi_load(sFileName.c_str(), &width, &height, &bpp, channels);
+  // load with stb image
+  logger().debug("Loading Texture '{}' with stbi.", sFileName);
 
-    if (!pixels) {
-      logger().error("Failed to load '{}' with stbi!", sFileName);
-      return nullptr;
-    }
+  int width{};
+  int height{};
+  int bpp{};
+  int channels = 4;
 
-    result->UploadTexture(width, height, pixels);
+  unsigned char* pixels = stbi_load(sFileName.c_str(), &width, &height, &bpp, channels);
 
-    stbi_image_free(pixels);
+  if (!pixels) {
+    logger().error("Failed to load '{}' with stbi!", sFileName);
+    return false;
   }
 
-  return result;
+  image.mWidth    = static_cast<uint32_t>(width);
+  image.mHeight   = static_cast<uint32_t>(height);
+  image.mChannels = static_cast<uint32_t>(channels);
+  image.mPixels.assign(pixels, pixels + static_cast<std::size_t>(width) * height * channels);
+
+  stbi_image_free(pixels);
+
+  return true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -10,15 +10,35 @@
 #include "cs_graphics_export.hpp"
 
 #include <VistaOGLExt/VistaTexture.h>
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace cs::graphics {
-/// For loading VistaTextures.
+/// For loading VistaTextures. See also AsyncTextureLoader for loading textures in the background.
 class CS_GRAPHICS_EXPORT TextureLoader {
  public:
+  /// The pixels of a decoded image file with eight bits per channel. The first row is the top row
+  /// of the image.
+  struct Image {
+    uint32_t             mWidth    = 0;
+    uint32_t             mHeight   = 0;
+    uint32_t             mChannels = 0;
+    std::vector<uint8_t> mPixels;
+
+    /// The format of mPixels as expected by glTexImage2D(), for example GL_RGB.
+    uint32_t getPixelFormat() const;
+  };
+
   /// Loads a VistaTexture from the given file.
   static std::unique_ptr<VistaTexture> loadFromFile(std::string const& sFileName);
+
+  /// Decodes the given TIFF file or any file supported by stb_image into the given image. The
+  /// memory of image.mPixels is reused if it is large enough. TGA files are not supported, as
+  /// these are loaded with Vista by loadFromFile(). This does not need an OpenGL context and can be
+  /// called from any thread. Returns false if the file could not be decoded.
+  static bool decodeFile(std::string const& sFileName, Image& image);
 };
 
 } // namespace cs::graphics
@@ -0,0 +1,193 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "JavaScriptBatch.hpp"
+
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <iterator>
+#include <spdlog/fmt/fmt.h>
+
+namespace cs::gui {
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Each call is wrapped in a try-catch-block, so that the remaining calls of a batch are executed
+// even if one of them throws.
+std::string_view const CALL_PREFIX = "try{";
+std::string_view const CALL_SUFFIX = "}catch(e){console.error(e);}\n";
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Returns true if the last part of the given function name starts with "set" followed by an upper
+// case letter, like "CosmoScout.gui.setSliderValue" or "setText".
+bool isSetter(std::string const& function) {
+  auto        dot  = function.rfind('.');
+  std::size_t name = dot == std::string::npos ? 0 : dot + 1;
+
+  return function.size() > name + 3 && function.compare(name, 3, "set") == 0 &&
+         std::isupper(static_cast<unsigned char>(function[name + 3]));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+void appendNonFinite(std::string& out, T value) {
+  if (std::isnan(value)) {
+    out += "NaN";
+  } else {
+    out += value > 0 ? "Infinity" : "-Infinity";
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool JavaScriptBatch::empty() const {
+  std::lock_guard lock(mMutex);
+  return mCallCount == 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t JavaScriptBatch::getCallCount() const {
+  std::lock_guard lock(mMutex);
+  return mCallCount;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string JavaScriptBatch::flush() {
+  uint32_t callCount{};
+  return flush(callCount);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string JavaScriptBatch::flush(uint32_t& callCount) {
+  std::lock_guard lock(mMutex);
+
+  std::string code;
+  std::swap(code, mCode);
+
+  callCount  = mCallCount;
+  mCallCount = 0;
+  mLastSetterCalls.clear();
+
+  return code;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void JavaScriptBatch::appendBool(std::string& out, bool value) {
+  // This is what utils::toString() has always produced for bools.
+  out += value ? '1' : '0';
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void JavaScriptBatch::appendInteger(std::string& out, int64_t value) {
+  std::array<char, 24> buffer{};
+  auto result = std::to_chars(buffer.data(), buffer.data() + buffer.size(), value);
+  out.append(buffer.data(), result.ptr);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void JavaScriptBatch::appendInteger(std::string& out, uint64_t value) {
+  std::array<char, 24> buffer{};
+  auto result = std::to_chars(buffer.data(), buffer.data() + buffer.size(), value);
+  out.append(buffer.data(), result.ptr);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void JavaScriptBatch::appendFloat(std::string& out, float value) {
+  if (!std::isfinite(value)) {
+    appendNonFinite(out, value);
+    return;
+  }
+
+  fmt::format_to(std::back_inserter(out), "{}", value);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void JavaScriptBatch::appendFloat(std::string& out, double value) {
+  if (!std::isfinite(value)) {
+    appendNonFinite(out, value);
+    return;
+  }
+
+  fmt::format_to(std::back_inserter(out), "{}", value);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void JavaScriptBatch::appendString(std::string& out, std::string_view value) {
+  out.reserve(out.size() + value.size() + 2);
+  out += '"';
+
+  for (char c : value) {
+    switch (c) {
+    case '"':
+      out += "\\\"";
+      break;
+    case '\\':
+      out += "\\\\";
+      break;
+    case '\n':
+      out += "\\n";
+      break;
+    case '\r':
+      out += "\\r";
+      break;
+    default:
+      out += c;
+    }
+  }
+
+  out += '"';
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void JavaScriptBatch::addCall(std::string const& function, std::string const& call) {
+  std::lock_guard lock(mMutex);
+
+  ++mCallCount;
+
+  // Other functions may modify the state which is set by setters, so after calling them, setters
+  // have to be called again even if their arguments did not change.
+  if (!isSetter(function)) {
+    mLastSetterCalls.clear();
+  } else {
+    auto lastCall = mLastSetterCalls.find(function);
+
+    // Drop the call if the previous call of this setter had the same arguments.
+    if (lastCall != mLastSetterCalls.end() &&
+        mCode.compare(lastCall->second.first, lastCall->second.second, call) == 0) {
+      return;
+    }
+
+    mLastSetterCalls[function] = {mCode.size() + CALL_PREFIX.size(), call.size()};
+  }
+
+  mCode += CALL_PREFIX;
+  mCode += call;
+  mCode += CALL_SUFFIX;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::gui
@@ -0,0 +1,120 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CS_GUI_JAVASCRIPT_BATCH_HPP
+#define CS_GUI_JAVASCRIPT_BATCH_HPP
+
+#include "../cs-utils/utils.hpp"
+#include "cs_gui_export.hpp"
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+namespace cs::gui {
+
+/// A JavaScriptBatch collects calls of JavaScript functions and combines them to a single piece of
+/// code. Each WebView uses an instance of this class, so that all calls of one frame can be sent to
+/// the web page at once instead of sending one message for each call.
+/// Calls of setters (functions whose name starts with "set", like "CosmoScout.gui.setSliderValue")
+/// are dropped if they are identical to the previous call of the same setter in this batch and no
+/// other function has been called in between.
+/// All methods may be called from any thread.
+class CS_GUI_EXPORT JavaScriptBatch {
+ public:
+  /// Appends a call of the given function to the batch. See WebView::callJavascript() for the
+  /// supported argument types.
+  template <typename... Args>
+  void add(std::string const& function, Args&&... args) {
+    std::string call(function);
+    call += '(';
+    appendArguments(call, std::forward<Args>(args)...);
+    call += ')';
+    addCall(function, call);
+  }
+
+  /// Returns true if there are no pending calls.
+  bool empty() const;
+
+  /// Returns the number of calls which have been added since the last flush(). This includes calls
+  /// which have been dropped because they were identical to a previous call.
+  uint32_t getCallCount() const;
+
+  /// Returns JavaScript code which executes all pending calls in the order they were added and
+  /// clears the batch. Each call is wrapped in a try-catch-block, so that an exception thrown by
+  /// one function does not prevent the execution of subsequent calls.
+  std::string flush();
+
+  /// Like flush(), but also returns the number of calls which were included in the code, see
+  /// getCallCount().
+  std::string flush(uint32_t& callCount);
+
+  /// Appends the given value to the string in a form which can be used as an argument of a
+  /// JavaScript function. Bools are converted to 1 or 0, numbers are stored with the shortest
+  /// representation which can be parsed back to the same value and strings are quoted and escaped.
+  /// All other types are converted with cs::utils::toString().
+  template <typename T>
+  static void appendValue(std::string& out, T&& value) {
+    using Type = std::decay_t<T>;
+
+    if constexpr (std::is_same_v<Type, bool>) {
+      appendBool(out, value);
+    } else if constexpr (std::is_same_v<Type, char>) {
+      out += value;
+    } else if constexpr (std::is_integral_v<Type> && std::is_signed_v<Type>) {
+      appendInteger(out, static_cast<int64_t>(value));
+    } else if constexpr (std::is_integral_v<Type>) {
+      appendInteger(out, static_cast<uint64_t>(value));
+    } else if constexpr (std::is_same_v<Type, float>) {
+      appendFloat(out, value);
+    } else if constexpr (std::is_floating_point_v<Type>) {
+      appendFloat(out, static_cast<double>(value));
+    } else if constexpr (std::is_same_v<Type, std::string> ||
+                         std::is_same_v<Type, std::string_view> ||
+                         std::is_same_v<Type, char const*> || std::is_same_v<Type, char*>) {
+      appendString(out, value);
+    } else {
+      out += utils::toString(value);
+    }
+  }
+
+  static void appendBool(std::string& out, bool value);
+  static void appendInteger(std::string& out, int64_t value);
+  static void appendInteger(std::string& out, uint64_t value);
+  static void appendFloat(std::string& out, float value);
+  static void appendFloat(std::string& out, double value);
+  static void appendString(std::string& out, std::string_view value);
+
+ private:
+  template <typename T, typename... Args>
+  static void appendArguments(std::string& out, T&& first, Args&&... others) {
+    appendValue(out, std::forward<T>(first));
+    ((out += ',', appendValue(out, std::forward<Args>(others))), ...);
+  }
+
+  static void appendArguments(std::string& /*out*/) {
+  }
+
+  void addCall(std::string const& function, std::string const& call);
+
+  // Calls are added from any thread, for example by log messages which are shown on the user
+  // interface. The arguments are converted before this is locked.
+  mutable std::mutex mMutex;
+
+  std::string mCode;
+  uint32_t    mCallCount = 0;
+
+  // For each setter, this stores the position and length of its last call in mCode.
+  std::unordered_map<std::string, std::pair<std::size_t, std::size_t>> mLastSetterCalls;
+};
+
+} // namespace cs::gui
+
+#endif // CS_GUI_JAVASCRIPT_BATCH_HPP
@@ -6,13 +6,25 @@
 
 #include "WebView.hpp"
 
+#include "../cs-utils/FrameTimings.hpp"
 #include "internal/WebViewClient.hpp"
 
 #include <include/cef_app.h>
+#include <mutex>
 #include <thread>
+#include <unordered_set>
 
 namespace cs::gui {
 
+namespace {
+
+// All existing WebViews. This is used by flushAllJavascript(). WebViews may be created and
+// destroyed on any thread, so all accesses have to lock sWebViewsMutex.
+std::unordered_set<WebView const*> sWebViews;
+std::mutex                         sWebViewsMutex;
+
+} // namespace
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 class DevToolsClient : public CefClient {
@@ -44,11 +56,21 @@ WebView::WebView(const std::string& url, int width, int height, bool allowLocalF
 
   mBrowser =
       CefBrowserHost::CreateBrowserSync(info, mClient, url, browserSettings, nullptr, nullptr);
+
+  std::lock_guard lock(sWebViewsMutex);
+  sWebViews.insert(this);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 WebView::~WebView() {
+  // Pending calls of callJavascript() are not sent anymore. This waits for a concurrent
+  // flushAllJavascript() to finish.
+  {
+    std::lock_guard lock(sWebViewsMutex);
+    sWebViews.erase(this);
+  }
+
   auto host = mBrowser->GetHost();
   while (!host->TryCloseBrowser()) {
     CefDoMessageLoopWork();
@@ -332,27 +354,42 @@ void WebView::injectKeyEvent(KeyEvent const& event) {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void WebView::callJavascriptImpl(
-    std::string const& function, std::vector<std::string> const& args) const {
-  std::string call(function + "( ");
-  for (auto&& s : args) {
-    call += s + ",";
-  }
-  call.back() = ')';
+void WebView::executeJavascript(std::string const& code) const {
+  flushJavascript();
 
   CefRefPtr<CefFrame> frame = mBrowser->GetMainFrame();
-  frame->ExecuteJavaScript(call, frame->GetURL(), 0);
+  frame->ExecuteJavaScript(code, frame->GetURL(), 0);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void WebView::executeJavascript(std::string const& code) const {
+void WebView::flushJavascript() const {
+  uint32_t    callCount{};
+  std::string code = mJavascriptBatch.flush(callCount);
+
+  if (callCount == 0) {
+    return;
+  }
+
+  // All calls are sent with a single message, so we save one message less than there were calls.
+  utils::FrameTimings::count("Saved JavaScript messages", callCount - 1);
+
   CefRefPtr<CefFrame> frame = mBrowser->GetMainFrame();
   frame->ExecuteJavaScript(code, frame->GetURL(), 0);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void WebView::flushAllJavascript() {
+  std::lock_guard lock(sWebViewsMutex);
+
+  for (auto const* webView : sWebViews) {
+    webView->flushJavascript();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void WebView::registerCallback(
     std::string const& name, std::string const& comment, std::function<void()> const& callback) {
   registerJSCallbackImpl(name, comment, {},
@@ -8,6 +8,7 @@
 #define CS_GUI_WEBVIEW_HPP
 
 #include "../cs-utils/utils.hpp"
+#include "JavaScriptBatch.hpp"
 #include "KeyEvent.hpp"
 #include "MouseEvent.hpp"
 #include "logger.hpp"
@@ -49,23 +50,34 @@ class CS_GUI_EXPORT WebView {
   /// The given callback is fired when the active gui element wants to receive keyboard events.
   void setRequestKeyboardFocusCallback(RequestKeyboardFocusCallback const& callback);
 
-  /// Calls an existing Javascript function. You can pass as many arguments as you like. They will
-  /// be converted to std::strings, so on the JavaScript side you will have to convert them back.
+  /// Calls an existing Javascript function. You can pass as many arguments as you like. Bools are
+  /// passed as 1 or 0, numbers and strings are passed as JavaScript numbers and strings.
+  /// The call is not executed immediately. All calls of one frame are collected and sent to the
+  /// web page at once when gui::update() is called. Calls of setters which are identical to the
+  /// previous call of the same setter are dropped, see JavaScriptBatch for details. This may be
+  /// called from any thread.
   ///
   /// @param function The name of the function.
-  /// @param a        The arguments of the function. Each arguments type must be convertible to a
-  ///                 string be either providing a definition for core::utils::toString or by
-  ///                 implementing the operator<<() for that type.
+  /// @param a        The arguments of the function. Types other than bools, numbers and strings
+  ///                 must be convertible to a string be either providing a definition for
+  ///                 core::utils::toString or by implementing the operator<<() for that type.
   template <typename... Args>
   void callJavascript(std::string const& function, Args&&... a) const {
-    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-array-to-pointer-decay)
-    std::vector<std::string> args = {(utils::toString(a))...};
-    callJavascriptImpl(function, args);
+    mJavascriptBatch.add(function, std::forward<Args>(a)...);
   }
 
-  /// Execute Javascript code.
+  /// Execute Javascript code. This is done immediately, all pending calls of callJavascript() are
+  /// executed before.
   void executeJavascript(std::string const& code) const;
 
+  /// Sends all pending calls of callJavascript() to the web page. Usually, there is no need to call
+  /// this, as gui::update() calls flushAllJavascript().
+  void flushJavascript() const;
+
+  /// Sends the pending calls of callJavascript() of all WebViews to their web pages. This is called
+  /// once a frame by gui::update().
+  static void flushAllJavascript();
+
   /// Register a callback which can be called from Javascript with the
   /// "window.callNative('callback_name', ... args ...)" function. Callbacks are also registered as
   /// CosmoScout.callbacks.callback_name(... args ...). For the latter to work, the WebView has to
@@ -233,7 +245,6 @@ class CS_GUI_EXPORT WebView {
         });
   }
 
-  void callJavascriptImpl(std::string const& function, std::vector<std::string> const& args) const;
   void registerJSCallbackImpl(std::string const& name, std::string const& comment,
       std::vector<std::type_index>&&                                   types,
       std::function<void(std::vector<std::optional<JSType>>&&)> const& callback);
@@ -241,6 +252,9 @@ class CS_GUI_EXPORT WebView {
   detail::WebViewClient* mClient;
   CefRefPtr<CefBrowser>  mBrowser;
 
+  // The calls of callJavascript() which have not been sent to the web page yet.
+  mutable JavaScriptBatch mJavascriptBatch;
+
   bool mInteractive = true;
   bool mCanScroll   = true;
 
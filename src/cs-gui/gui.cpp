@@ -6,6 +6,7 @@
 
 #include "gui.hpp"
 
+#include "WebView.hpp"
 #include "internal/WebApp.hpp"
 #include "logger.hpp"
 
@@ -65,6 +66,9 @@ void cleanUp() {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void update() {
+  // Send the JavaScript calls of this frame with one message per WebView.
+  WebView::flushAllJavascript();
+
   CefDoMessageLoopWork();
 }
 
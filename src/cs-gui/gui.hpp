@@ -24,7 +24,8 @@ CS_GUI_EXPORT void init();
 /// Shuts down CEF.
 CS_GUI_EXPORT void cleanUp();
 
-/// Triggers the CEF update function. This should be called once a frame.
+/// Sends all pending JavaScript calls of the WebViews and triggers the CEF update function. This
+/// should be called once a frame.
 CS_GUI_EXPORT void update();
 
 } // namespace cs::gui
@@ -6,6 +6,7 @@
 
 #include "RenderHandler.hpp"
 #include "../../cs-utils/FrameTimings.hpp"
+#include "../../cs-utils/TraceRecorder.hpp"
 #include "../logger.hpp"
 
 #include <GL/glew.h>
@@ -85,6 +86,8 @@ void RenderHandler::GetViewRect(CefRefPtr<CefBrowser> /*browser*/, CefRect& rect
 
 void RenderHandler::OnPaint(CefRefPtr<CefBrowser> /*browser*/, PaintElementType /*type*/,
     RectList const& dirtyRects, const void* b, int width, int height) {
+  CS_TRACE_ZONE("RenderHandler::OnPaint");
+
   DrawEvent event{};
   event.mResized  = width != mLastDrawWidth || height != mLastDrawHeight;
   mLastDrawWidth  = width;
@@ -6,61 +6,20 @@
 
 #include "CelestialAnchor.hpp"
 
+#include "../cs-utils/utils.hpp"
+#include "EphemerisTable.hpp"
+
 #include <VistaKernel/GraphicsManager/VistaNodeBridge.h>
 
 #include <array>
 #include <cspice/SpiceUsr.h>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
-#include <optional>
-#include <unordered_map>
+#include <mutex>
 #include <utility>
 
 namespace cs::scene {
 
-namespace {
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-// A little helper class which stores results of spice calls because these are quite costly. It   //
-// only caches requests for one time step, as soon as the tTime parameter changes, the complete   //
-// cache is invalidated.                                                                          //
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
-template <typename K, typename V>
-class Cache {
- public:
-  std::optional<V> get(double tTime, K const& key) {
-    if (tTime != mLastTime) {
-      return std::nullopt;
-    }
-
-    auto value = mache.find(key);
-
-    if (value == mache.end()) {
-      return std::nullopt;
-    }
-
-    return value->second;
-  }
-
-  void insert(double tTime, K const& key, V const& value) {
-    if (tTime != mLastTime) {
-      mLastTime = tTime;
-      mache.clear();
-    }
-
-    mache.insert(std::make_pair(key, value));
-  }
-
- private:
-  double                   mLastTime = 0;
-  std::unordered_map<K, V> mache;
-};
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
-} // namespace
-
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 CelestialAnchor::CelestialAnchor(std::string sCenterName, std::string sFrameName)
@@ -68,30 +27,26 @@ CelestialAnchor::CelestialAnchor(std::string sCenterName, std::string sFrameName
     , mRotation(1.0, 0.0, 0.0, 0.0)
     , mScale(1.0)
     , mCenterName(std::move(sCenterName))
-    , mFrameName(std::move(sFrameName)) {
+    , mFrameName(std::move(sFrameName))
+    , mCenterId(EphemerisTable::internCenter(mCenterName))
+    , mFrameId(EphemerisTable::internFrame(mFrameName)) {
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 glm::dvec3 CelestialAnchor::getRelativePosition(double tTime, CelestialAnchor const& other) const {
-  glm::dvec3 vOtherPos = other.getAnchorPosition() / 1000.0;
-
-  std::string key(getCenterName() + getFrameName() + other.getCenterName() + other.getFrameName() +
-                  std::to_string(vOtherPos[0]) + std::to_string(vOtherPos[1]) +
-                  std::to_string(vOtherPos[2]));
-
-  static Cache<std::string, glm::dvec3> cache;
-
-  auto cacheValue = cache.get(tTime, key);
-
   glm::dvec3 vRelPos;
 
-  if (cacheValue) {
-    vRelPos = cacheValue.value();
-  } else {
+  // Most queries are for the current simulation time, these are answered by the EphemerisTable.
+  if (!EphemerisTable::getRelativePosition(tTime, mCenterId, mFrameId, other.mCenterId,
+          other.mFrameId, other.getAnchorPosition(), vRelPos)) {
+    glm::dvec3 vOtherPos = other.getAnchorPosition() / 1000.0;
+
     std::array<double, 6> relPos{};
     double                timeOfLight{};
     std::array            otherPos{vOtherPos[2], vOtherPos[0], vOtherPos[1]};
+
+    std::lock_guard lock(utils::getSpiceMutex());
     spkcpt_c(otherPos.data(), other.getCenterName().c_str(), other.getFrameName().c_str(), tTime,
         mFrameName.c_str(), "OBSERVER", "NONE", mCenterName.c_str(), relPos.data(), &timeOfLight);
 
@@ -103,8 +58,6 @@ glm::dvec3 CelestialAnchor::getRelativePosition(double tTime, CelestialAnchor co
     }
 
     vRelPos = glm::dvec3(relPos[1], relPos[2], relPos[0]) * 1000.0;
-
-    cache.insert(tTime, key, vRelPos);
   }
 
   vRelPos = glm::inverse(mRotation) * ((vRelPos - mPosition) / mScale);
@@ -115,18 +68,13 @@ glm::dvec3 CelestialAnchor::getRelativePosition(double tTime, CelestialAnchor co
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 glm::dquat CelestialAnchor::getRelativeRotation(double tTime, CelestialAnchor const& other) const {
-  std::string key(getFrameName() + other.getFrameName());
-
-  static Cache<std::string, glm::dquat> cache;
-
-  auto cacheValue = cache.get(tTime, key);
-
   glm::dquat qRot;
-  if (cacheValue) {
-    qRot = cacheValue.value();
-  } else {
+
+  if (!EphemerisTable::getRelativeRotation(tTime, mFrameId, other.mFrameId, qRot)) {
     // get rotation from self to other
     std::array<double[3], 3> rotMat{}; // NOLINT(modernize-avoid-c-arrays)
+
+    std::lock_guard lock(utils::getSpiceMutex());
     pxform_c(other.getFrameName().c_str(), mFrameName.c_str(), tTime, rotMat.data());
 
     // convert to quaternion
@@ -137,8 +85,6 @@ glm::dquat CelestialAnchor::getRelativeRotation(double tTime, CelestialAnchor co
     raxisa_c(rotMat.data(), axis, &angle);
 
     qRot = glm::angleAxis(angle, glm::dvec3(axis[1], axis[2], axis[0]));
-
-    cache.insert(tTime, key, qRot);
   }
 
   return glm::inverse(mRotation) * qRot * other.mRotation;
@@ -178,6 +124,7 @@ std::string const& CelestialAnchor::getFrameName() const {
 
 void CelestialAnchor::setFrameName(std::string const& sFrameName) {
   mFrameName = sFrameName;
+  mFrameId   = EphemerisTable::internFrame(mFrameName);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -190,6 +137,7 @@ std::string const& CelestialAnchor::getCenterName() const {
 
 void CelestialAnchor::setCenterName(std::string const& sCenterName) {
   mCenterName = sCenterName;
+  mCenterId   = EphemerisTable::internCenter(mCenterName);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
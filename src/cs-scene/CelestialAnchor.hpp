@@ -88,6 +88,11 @@ class CS_SCENE_EXPORT CelestialAnchor {
 
   std::string mCenterName;
   std::string mFrameName;
+
+ private:
+  /// Ids of mCenterName and mFrameName in the EphemerisTable.
+  int mCenterId;
+  int mFrameId;
 };
 
 } // namespace cs::scene
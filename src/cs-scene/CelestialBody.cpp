@@ -17,4 +17,15 @@ CelestialBody::CelestialBody(std::string const& sCenterName, std::string const&
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void CelestialBody::getHeights(
+    std::vector<glm::dvec2> const& lngLats, std::vector<double>& heights) const {
+  heights.resize(lngLats.size());
+
+  for (std::size_t i = 0; i < lngLats.size(); ++i) {
+    heights[i] = getHeight(lngLats[i]);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 } // namespace cs::scene
@@ -10,6 +10,8 @@
 #include "../cs-utils/IntersectableObject.hpp"
 #include "CelestialObject.hpp"
 
+#include <vector>
+
 namespace cs::scene {
 
 /// CelestialBody objects extend the CelestialObject by being intersectable. Every implementation
@@ -24,6 +26,16 @@ class CS_SCENE_EXPORT CelestialBody : public CelestialObject, public utils::Inte
   /// @param lngLat The coordinates on the surface in the Geographic Coordinate System format.
   virtual double getHeight(glm::dvec2 lngLat) const = 0;
 
+  /// The elevation at many points on the surface. heights is resized to the size of lngLats and
+  /// heights[i] receives the elevation at lngLats[i]. The default implementation calls getHeight()
+  /// for each point, bodies which can sample many points at once more efficiently should override
+  /// this.
+  ///
+  /// @param lngLats The coordinates on the surface in the Geographic Coordinate System format.
+  /// @param heights The elevations at the given coordinates.
+  virtual void getHeights(
+      std::vector<glm::dvec2> const& lngLats, std::vector<double>& heights) const;
+
   /// The radii of the Body in meters.
   virtual glm::dvec3 getRadii() const = 0;
 };
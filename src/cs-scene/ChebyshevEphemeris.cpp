@@ -0,0 +1,232 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ChebyshevEphemeris.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/constants.hpp>
+#include <stdexcept>
+
+namespace cs::scene {
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The number of nodes each segment is fitted to.
+int const NODES = ChebyshevEphemeris::sDegree + 1;
+
+// Returns the position of the k-th Chebyshev node in [-1, 1].
+double getNode(int k) {
+  return std::cos(glm::pi<double>() * (k + 0.5) / NODES);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ChebyshevEphemeris::ChebyshevEphemeris(std::string const& observerCenter,
+    std::string const& observerFrame, std::string const& targetCenter,
+    std::string const& targetFrame)
+    : mObserver(observerCenter, observerFrame)
+    , mTarget(targetCenter, targetFrame) {
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double ChebyshevEphemeris::getSegmentLength() const {
+  return mSegmentLength;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ChebyshevEphemeris::setSegmentLength(double seconds) {
+  if (mSegmentLength != seconds) {
+    mSegmentLength = seconds;
+    clear();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double ChebyshevEphemeris::getTolerance() const {
+  return mTolerance;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ChebyshevEphemeris::setTolerance(double tolerance) {
+  if (mTolerance != tolerance) {
+    mTolerance = tolerance;
+    clear();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ChebyshevEphemeris::sample(std::vector<double> const& times, std::vector<glm::dvec4>& points) {
+  points.reserve(points.size() + times.size());
+
+  // Samples are usually sorted by time, so consecutive samples mostly fall into the same segment.
+  Segment const* segment = nullptr;
+
+  for (double tTime : times) {
+    if (!segment || tTime < segment->mStart || tTime > segment->mEnd) {
+      auto const& cell = getCell(static_cast<std::int64_t>(std::floor(tTime / mSegmentLength)));
+      auto        it   = std::lower_bound(cell.begin(), cell.end(), tTime,
+          [](Segment const& s, double t) { return s.mEnd < t; });
+      segment = it == cell.end() ? &cell.back() : &*it;
+    }
+
+    if (segment->mValid) {
+      double x = (2.0 * tTime - segment->mStart - segment->mEnd) /
+                 (segment->mEnd - segment->mStart);
+      points.emplace_back(evaluate(*segment, x), tTime);
+      continue;
+    }
+
+    // Segments which are not entirely covered by the SPICE kernels are not approximated. Samples in
+    // such segments are computed directly, this fails if SPICE has no data at all.
+    try {
+      points.emplace_back(evaluate(tTime), tTime);
+    } catch (std::exception const&) {}
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ChebyshevEphemeris::prune(double tStart, double tEnd) {
+  auto first = static_cast<std::int64_t>(std::floor(tStart / mSegmentLength));
+  auto last  = static_cast<std::int64_t>(std::floor(tEnd / mSegmentLength));
+
+  mCells.erase(mCells.begin(), mCells.lower_bound(first));
+  mCells.erase(mCells.upper_bound(last), mCells.end());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ChebyshevEphemeris::clear() {
+  mCells.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t ChebyshevEphemeris::getSpiceEvaluations() const {
+  return mSpiceEvaluations;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ChebyshevEphemeris::Cell const& ChebyshevEphemeris::getCell(std::int64_t index) {
+  auto it = mCells.find(index);
+
+  if (it == mCells.end()) {
+    it            = mCells.emplace(index, Cell()).first;
+    double tStart = static_cast<double>(index) * mSegmentLength;
+    fit(tStart, tStart + mSegmentLength, 0, it->second);
+  }
+
+  return it->second;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ChebyshevEphemeris::fit(double tStart, double tEnd, int depth, Cell& cell) {
+  Segment segment;
+  segment.mStart = tStart;
+  segment.mEnd   = tEnd;
+
+  double center = 0.5 * (tStart + tEnd);
+  double radius = 0.5 * (tEnd - tStart);
+
+  std::array<glm::dvec3, NODES> values{};
+  int                           validValues = 0;
+
+  for (int k = 0; k < NODES; ++k) {
+    try {
+      values.at(k) = evaluate(center + radius * getNode(k));
+      ++validValues;
+    } catch (std::exception const&) {}
+  }
+
+  // If SPICE has data for a part of the segment only, the segment is split so that as many samples
+  // as possible can be approximated. If there is no data at all, splitting is not worth the effort.
+  if (validValues < NODES) {
+    if (validValues > 0 && depth < sMaxDepth) {
+      fit(tStart, center, depth + 1, cell);
+      fit(center, tEnd, depth + 1, cell);
+    } else {
+      cell.push_back(segment);
+    }
+    return;
+  }
+
+  // Compute the coefficients with the discrete cosine transform of the values at the nodes.
+  for (int j = 0; j < NODES; ++j) {
+    glm::dvec3 sum(0.0);
+    for (int k = 0; k < NODES; ++k) {
+      sum += values.at(k) * std::cos(glm::pi<double>() * j * (k + 0.5) / NODES);
+    }
+    segment.mCoefficients.at(j) = sum * (2.0 / NODES);
+  }
+
+  segment.mCoefficients[0] *= 0.5;
+  segment.mValid = true;
+
+  // Check the approximation half-way between some of the nodes, where the error is largest.
+  double error    = 0.0;
+  double distance = 0.0;
+
+  for (int k : {0, NODES / 2, NODES - 2}) {
+    double x = std::cos(glm::pi<double>() * (k + 1.0) / NODES);
+
+    try {
+      glm::dvec3 exact = evaluate(center + radius * x);
+      error            = std::max(error, glm::length(exact - evaluate(segment, x)));
+      distance         = std::max(distance, glm::length(exact));
+    } catch (std::exception const&) {
+      segment.mValid = false;
+    }
+  }
+
+  if ((!segment.mValid || error > mTolerance * distance) && depth < sMaxDepth) {
+    fit(tStart, center, depth + 1, cell);
+    fit(center, tEnd, depth + 1, cell);
+    return;
+  }
+
+  cell.push_back(segment);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::dvec3 ChebyshevEphemeris::evaluate(double tTime) {
+  ++mSpiceEvaluations;
+  return mObserver.getRelativePosition(tTime, mTarget);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+glm::dvec3 ChebyshevEphemeris::evaluate(Segment const& segment, double x) {
+  // Clenshaw's recurrence.
+  glm::dvec3 b1(0.0);
+  glm::dvec3 b2(0.0);
+
+  for (int j = sDegree; j > 0; --j) {
+    glm::dvec3 b0 = 2.0 * x * b1 - b2 + segment.mCoefficients.at(j);
+    b2            = b1;
+    b1            = b0;
+  }
+
+  return x * b1 - b2 + segment.mCoefficients[0];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::scene
@@ -0,0 +1,101 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CS_SCENE_CHEBYSHEV_EPHEMERIS_HPP
+#define CS_SCENE_CHEBYSHEV_EPHEMERIS_HPP
+
+#include "CelestialAnchor.hpp"
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace cs::scene {
+
+/// The ChebyshevEphemeris approximates the position of a target relative to an observer with
+/// piecewise Chebyshev polynomials. This is much faster than asking SPICE for every single sample
+/// if many positions along the path of the target are required, for example to draw its
+/// trajectory.
+///
+/// The time axis is divided into segments of equal length. Whenever a sample is requested in a
+/// segment which has not been used before, the segment is fitted to sDegree + 1 positions computed
+/// by SPICE. The fit is compared to SPICE at a few further points; if the error is larger than the
+/// tolerance, the segment is split in halves which are fitted individually. Segments which are not
+/// needed anymore can be released with prune(), so if a window of samples moves along the time
+/// axis, only the segments at its edges are fitted.
+class CS_SCENE_EXPORT ChebyshevEphemeris {
+ public:
+  /// The degree of the Chebyshev polynomials.
+  static int const sDegree = 12;
+
+  /// Segments are split at most this many times.
+  static int const sMaxDepth = 6;
+
+  /// The position of the center of targetCenter in targetFrame will be computed relative to the
+  /// coordinate system given by observerCenter and observerFrame, in meters.
+  ChebyshevEphemeris(std::string const& observerCenter, std::string const& observerFrame,
+      std::string const& targetCenter, std::string const& targetFrame);
+
+  /// The length of the segments in seconds. A good value is a few dozen times the distance between
+  /// consecutive samples. Changing this discards all fitted segments.
+  double getSegmentLength() const;
+  void   setSegmentLength(double seconds);
+
+  /// The maximum error of the approximation relative to the distance between target and observer.
+  /// Changing this discards all fitted segments.
+  double getTolerance() const;
+  void   setTolerance(double tolerance);
+
+  /// Appends a point (x, y, z, time) to points for each of the given times. Missing segments are
+  /// fitted on demand. Times at which SPICE has no data for the target are skipped, so points may
+  /// contain less elements than times.
+  void sample(std::vector<double> const& times, std::vector<glm::dvec4>& points);
+
+  /// Releases all segments which are entirely outside of the time interval [tStart, tEnd].
+  void prune(double tStart, double tEnd);
+
+  /// Releases all segments.
+  void clear();
+
+  /// Returns the number of position computations which have been done by SPICE so far. This can be
+  /// used to measure the efficiency of the approximation.
+  std::size_t getSpiceEvaluations() const;
+
+ private:
+  struct Segment {
+    double                              mStart = 0.0;
+    double                              mEnd   = 0.0;
+    bool                                mValid = false;
+    std::array<glm::dvec3, sDegree + 1> mCoefficients{};
+  };
+
+  // All segments which cover the time interval [index * mSegmentLength, (index+1) *
+  // mSegmentLength), sorted by time.
+  using Cell = std::vector<Segment>;
+
+  Cell const& getCell(std::int64_t index);
+
+  // Fits the time interval [tStart, tEnd] and appends the resulting segments to cell.
+  void fit(double tStart, double tEnd, int depth, Cell& cell);
+
+  glm::dvec3 evaluate(double tTime);
+
+  static glm::dvec3 evaluate(Segment const& segment, double x);
+
+  CelestialAnchor mObserver;
+  CelestialAnchor mTarget;
+
+  double      mSegmentLength = 86400.0;
+  double      mTolerance     = 1e-7;
+  std::size_t mSpiceEvaluations{};
+
+  std::map<std::int64_t, Cell> mCells;
+};
+
+} // namespace cs::scene
+
+#endif // CS_SCENE_CHEBYSHEV_EPHEMERIS_HPP
@@ -0,0 +1,201 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "EphemerisTable.hpp"
+
+#include "../cs-utils/utils.hpp"
+
+#include <array>
+#include <cspice/SpiceUsr.h>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace cs::scene {
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The names of all interned centers and frames. The index of a name in the vectors is its id.
+struct Names {
+  std::mutex                           mMutex;
+  std::unordered_map<std::string, int> mCenterIds;
+  std::unordered_map<std::string, int> mFrameIds;
+  std::vector<std::string>             mCenters;
+  std::vector<std::string>             mFrames;
+};
+
+// The ephemeris data for one point in time. Once it has been published, a table is never modified
+// again, so it can be read by any number of threads.
+struct Table {
+  double mTime = 0.0;
+
+  // Positions of the centers relative to the solar system barycenter in J2000, in meters.
+  std::vector<glm::dvec3> mPositions;
+  std::vector<char>       mPositionValid;
+
+  // Rotations from the frames to J2000.
+  std::vector<glm::dmat3> mRotations;
+  std::vector<char>       mRotationValid;
+
+  bool hasPosition(int center) const {
+    return center >= 0 && center < static_cast<int>(mPositionValid.size()) &&
+           mPositionValid[center];
+  }
+
+  bool hasRotation(int frame) const {
+    return frame >= 0 && frame < static_cast<int>(mRotationValid.size()) && mRotationValid[frame];
+  }
+};
+
+Names& getNames() {
+  static Names names;
+  return names;
+}
+
+// This must only be accessed with std::atomic_load and std::atomic_store.
+std::shared_ptr<Table const>& getTable() {
+  static std::shared_ptr<Table const> table;
+  return table;
+}
+
+// Returns the table if it contains data for tTime, else nullptr.
+std::shared_ptr<Table const> getTable(double tTime) {
+  auto table = std::atomic_load(&getTable());
+  return (table && table->mTime == tTime) ? table : nullptr;
+}
+
+int intern(std::string const& name, std::unordered_map<std::string, int>& ids,
+    std::vector<std::string>& names) {
+  auto it = ids.find(name);
+
+  if (it != ids.end()) {
+    return it->second;
+  }
+
+  int id = static_cast<int>(names.size());
+  ids.emplace(name, id);
+  names.push_back(name);
+  return id;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int EphemerisTable::internCenter(std::string const& name) {
+  auto&           names = getNames();
+  std::lock_guard lock(names.mMutex);
+  return intern(name, names.mCenterIds, names.mCenters);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int EphemerisTable::internFrame(std::string const& name) {
+  auto&           names = getNames();
+  std::lock_guard lock(names.mMutex);
+  return intern(name, names.mFrameIds, names.mFrames);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void EphemerisTable::update(double tTime) {
+  auto table   = std::make_shared<Table>();
+  table->mTime = tTime;
+
+  {
+    auto&           names = getNames();
+    std::lock_guard lock(names.mMutex);
+    std::lock_guard spiceLock(utils::getSpiceMutex());
+
+    table->mPositions.resize(names.mCenters.size());
+    table->mPositionValid.resize(names.mCenters.size());
+
+    for (std::size_t i = 0; i < names.mCenters.size(); ++i) {
+      std::array<double, 3> pos{};
+      double                timeOfLight{};
+      spkpos_c(names.mCenters[i].c_str(), tTime, "J2000", "NONE", "SSB", pos.data(), &timeOfLight);
+
+      // Centers without data at this time are not part of the table, queries for them will fall
+      // back to SPICE which reports the error.
+      if (failed_c()) {
+        reset_c();
+        continue;
+      }
+
+      table->mPositions[i]     = glm::dvec3(pos[1], pos[2], pos[0]) * 1000.0;
+      table->mPositionValid[i] = true;
+    }
+
+    table->mRotations.resize(names.mFrames.size());
+    table->mRotationValid.resize(names.mFrames.size());
+
+    for (std::size_t i = 0; i < names.mFrames.size(); ++i) {
+      std::array<double[3], 3> rotMat{}; // NOLINT(modernize-avoid-c-arrays)
+      pxform_c(names.mFrames[i].c_str(), "J2000", tTime, rotMat.data());
+
+      if (failed_c()) {
+        reset_c();
+        continue;
+      }
+
+      // Convert to our axis convention, see CelestialAnchor::getRelativePosition().
+      std::array<int, 3> axis{1, 2, 0};
+      for (int row = 0; row < 3; ++row) {
+        for (int col = 0; col < 3; ++col) {
+          // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+          table->mRotations[i][col][row] = rotMat.at(axis.at(row))[axis.at(col)];
+        }
+      }
+
+      table->mRotationValid[i] = true;
+    }
+  }
+
+  std::atomic_store(&getTable(), std::shared_ptr<Table const>(std::move(table)));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool EphemerisTable::getRelativePosition(double tTime, int center, int frame, int otherCenter,
+    int otherFrame, glm::dvec3 const& offset, glm::dvec3& result) {
+  auto table = getTable(tTime);
+
+  if (!table || !table->hasPosition(center) || !table->hasPosition(otherCenter) ||
+      !table->hasRotation(frame) || !table->hasRotation(otherFrame)) {
+    return false;
+  }
+
+  glm::dvec3 pos = table->mPositions[otherCenter] - table->mPositions[center] +
+                   table->mRotations[otherFrame] * offset;
+
+  result = glm::transpose(table->mRotations[frame]) * pos;
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool EphemerisTable::getRelativeRotation(
+    double tTime, int frame, int otherFrame, glm::dquat& result) {
+  auto table = getTable(tTime);
+
+  if (!table || !table->hasRotation(frame) || !table->hasRotation(otherFrame)) {
+    return false;
+  }
+
+  result = glm::quat_cast(glm::transpose(table->mRotations[frame]) * table->mRotations[otherFrame]);
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::scene
@@ -0,0 +1,56 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CS_SCENE_EPHEMERIS_TABLE_HPP
+#define CS_SCENE_EPHEMERIS_TABLE_HPP
+
+#include "cs_scene_export.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <string>
+
+namespace cs::scene {
+
+/// The EphemerisTable stores the positions of all SPICE centers and the orientations of all SPICE
+/// frames which are used by CelestialAnchors for one point in time. CelestialAnchors refer to their
+/// center and frame by integer ids which are obtained once by interning the SPICE names. The table
+/// is filled in one pass by update(), which is called once a frame by the SolarSystem. Afterwards,
+/// relative positions and rotations at this point in time can be computed without any calls to
+/// SPICE, string operations or memory allocations.
+///
+/// All methods may be called from any thread. Queries for other points in time, or for centers and
+/// frames for which SPICE has no data at this time, return false. The caller then has to ask SPICE
+/// directly.
+class CS_SCENE_EXPORT EphemerisTable {
+ public:
+  EphemerisTable() = delete;
+
+  /// Returns the id of the given SPICE center name. Ids are dense, start at zero and stay valid
+  /// for the entire lifetime of the application. Interning the same name twice yields the same id.
+  static int internCenter(std::string const& name);
+
+  /// Returns the id of the given SPICE frame name, see internCenter().
+  static int internFrame(std::string const& name);
+
+  /// Evaluates the positions of all interned centers and the orientations of all interned frames
+  /// at the given time. Data of previous calls is discarded.
+  static void update(double tTime);
+
+  /// Computes the position of the point at offset in the coordinate system given by otherCenter
+  /// and otherFrame, relative to the coordinate system given by center and frame. All positions are
+  /// in meters. Returns false if the table does not contain the required data for tTime.
+  static bool getRelativePosition(double tTime, int center, int frame, int otherCenter,
+      int otherFrame, glm::dvec3 const& offset, glm::dvec3& result);
+
+  /// Computes the rotation which transforms directions from otherFrame to frame. Returns false if
+  /// the table does not contain the required data for tTime.
+  static bool getRelativeRotation(double tTime, int frame, int otherFrame, glm::dquat& result);
+};
+
+} // namespace cs::scene
+
+#endif // CS_SCENE_EPHEMERIS_TABLE_HPP
@@ -12,22 +12,33 @@
 #include <VistaOGLExt/VistaBufferObject.h>
 #include <VistaOGLExt/VistaGLSLShader.h>
 #include <VistaOGLExt/VistaVertexArrayObject.h>
+
+#include <algorithm>
 #include <array>
+#include <glm/gtc/type_ptr.hpp>
 
 namespace cs::scene {
 
+// The number of ranges of points which are remembered for each region before the entire region is
+// written again, see Trajectory::uploadPoints().
+static const std::size_t MAX_PENDING_RANGES = 8;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 static const char* SHADER_VERT = R"(
 #version 330
 
 // inputs
-layout(location = 0) in vec3 inPosition;
-layout(location = 1) in float inAge;
+layout(location = 0) in vec4 inHigh;
+layout(location = 1) in vec4 inLow;
 
 // uniforms
 uniform mat4 uMatModelView;
 uniform mat4 uMatProjection;
+uniform vec4 uObserverHigh;
+uniform vec4 uObserverLow;
+uniform vec3 uTip;
+uniform float uMaxAge;
 
 // outputs
 out float fAge;
@@ -35,8 +46,17 @@ out vec4 vPosition;
 
 void main()
 {
-    fAge = inAge;
-    vPosition = uMatModelView * vec4(inPosition.xyz, 1);
+    // Position relative to the observer (xyz) and time relative to the current time (w).
+    vec4 relative = (inHigh - uObserverHigh) + (inLow - uObserverLow);
+
+    fAge = -relative.w / uMaxAge;
+
+    if (fAge <= 0.0) {
+      relative.xyz = uTip;
+      fAge = 0.0;
+    }
+
+    vPosition = uMatModelView * vec4(relative.xyz, 1);
     gl_Position = uMatProjection * vPosition;
 
   #if USE_LINEARDEPTHBUFFER
@@ -81,6 +101,15 @@ void main()
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+Trajectory::Vertex Trajectory::toVertex(glm::dvec4 const& point) {
+  Vertex vertex{};
+  vertex.mHigh = glm::vec4(point);
+  vertex.mLow  = glm::vec4(point - glm::dvec4(vertex.mHigh));
+  return vertex;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 Trajectory::Trajectory()
     : mMaxAge(100000.F)
     , mStartColor(1.F, 1.F, 1.F, 1.F)
@@ -91,62 +120,144 @@ Trajectory::Trajectory()
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void Trajectory::upload(glm::dmat4 const& relativeTransform, double dTime,
-    std::vector<glm::dvec4> const& vPoints, glm::dvec3 const& vTip, int startIndex) {
-  if (!vPoints.empty()) {
-    // transform all points to observer centric coordinates
-    std::vector<glm::vec4> points(vPoints.size());
+Trajectory::~Trajectory() {
+  for (auto& region : mRegions) {
+    if (region.mFence) {
+      glDeleteSync(region.mFence);
+    }
+  }
+
+  if (mVertices) {
+    mVBO->Bind(GL_ARRAY_BUFFER);
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+    mVBO->Release();
+  }
+}
 
-    for (size_t i(0); i < vPoints.size(); ++i) {
-      int ringbufferIndex = (static_cast<int>(i) + startIndex) % static_cast<int>(vPoints.size());
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-      glm::dvec4 const& curr = vPoints[ringbufferIndex];
+void Trajectory::uploadPoints(std::vector<glm::dvec4> const& vPoints, int first, int count) {
+  if (vPoints.empty()) {
+    return;
+  }
 
-      glm::dvec4 pos(curr.x, curr.y, curr.z, 1.0);
-      auto       age = static_cast<float>((dTime - curr.w) / mMaxAge);
+  auto size = static_cast<int>(vPoints.size());
 
-      if (curr.w >= dTime) {
-        pos = glm::dvec4(vTip, 1.0);
-        age = 0.F;
-      }
+  if (mPointCount != vPoints.size()) {
+    createBuffers(static_cast<uint32_t>(vPoints.size()));
+    first = 0;
+    count = size;
+  }
+
+  count = std::min(count, size);
 
-      pos = relativeTransform * pos;
+  if (count <= 0) {
+    return;
+  }
+
+  // The current region may still be read by the GPU if it has been drawn since it was written last.
+  // In this case, the points are written to another region instead.
+  if (mRegions.at(mCurrentRegion).mFence) {
+    mCurrentRegion = acquireRegion();
+  }
+
+  // Bring the region up to date with the points which have been written to the other regions in the
+  // meantime. The given ring buffer contains the current values of these points as well.
+  auto& region = mRegions.at(mCurrentRegion);
+
+  for (auto const& [pendingFirst, pendingCount] : region.mPendingRanges) {
+    writePoints(vPoints, mCurrentRegion, pendingFirst, pendingCount);
+  }
+
+  region.mPendingRanges.clear();
+
+  auto range = std::make_pair(static_cast<uint32_t>(first), static_cast<uint32_t>(count));
+  writePoints(vPoints, mCurrentRegion, range.first, range.second);
 
-      points[i] = glm::vec4(pos.x, pos.y, pos.z, age);
+  // All other regions have to be updated once they are used again. If there are many small ranges,
+  // for example because the points are uploaded several times per frame, these are replaced by the
+  // entire ring buffer.
+  for (uint32_t i = 0; i < REGION_COUNT; ++i) {
+    if (i != mCurrentRegion) {
+      auto& pending = mRegions.at(i).mPendingRanges;
+
+      if (pending.size() < MAX_PENDING_RANGES) {
+        pending.push_back(range);
+      } else {
+        pending = {{0U, mPointCount}};
+      }
     }
+  }
+}
 
-    if (mPointCount != vPoints.size()) {
-      mVBO = std::make_unique<VistaBufferObject>();
-      mVAO = std::make_unique<VistaVertexArrayObject>();
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-      mVAO->Bind();
+uint32_t Trajectory::acquireRegion() {
 
-      mVBO->Bind(GL_ARRAY_BUFFER);
-      mVBO->BufferData(points.size() * sizeof(glm::vec4), points.data(), GL_DYNAMIC_DRAW);
+  // Usually, the GPU has long finished drawing the previous frames when the next points are
+  // written, so the next region is available immediately.
+  for (uint32_t i = 1; i < REGION_COUNT; ++i) {
+    uint32_t index  = (mCurrentRegion + i) % REGION_COUNT;
+    auto&    region = mRegions.at(index);
 
-      // positions
-      mVAO->EnableAttributeArray(0);
-      mVAO->SpecifyAttributeArrayFloat(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), 0, mVBO.get());
+    if (!region.mFence) {
+      return index;
+    }
 
-      // ages
-      mVAO->EnableAttributeArray(1);
-      mVAO->SpecifyAttributeArrayFloat(
-          1, 1, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), sizeof(glm::vec3), mVBO.get());
+    GLenum result = glClientWaitSync(region.mFence, 0, 0);
 
-      mVAO->Release();
-      mVBO->Release();
-    } else {
-      mVBO->Bind(GL_ARRAY_BUFFER);
-      mVBO->BufferSubData(0, points.size() * sizeof(glm::vec4), points.data());
-      mVBO->Release();
+    if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED) {
+      glDeleteSync(region.mFence);
+      region.mFence = nullptr;
+      return index;
     }
+  }
 
-    mPointCount = static_cast<int>(vPoints.size());
+  // The GPU is still busy with all other regions, so wait for the next one. As the regions are
+  // used round-robin, this is usually the one which has been drawn first.
+  uint32_t index  = (mCurrentRegion + 1) % REGION_COUNT;
+  auto&    region = mRegions.at(index);
+
+  glClientWaitSync(region.mFence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+  glDeleteSync(region.mFence);
+  region.mFence = nullptr;
+
+  return index;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Trajectory::writePoints(
+    std::vector<glm::dvec4> const& vPoints, uint32_t region, uint32_t first, uint32_t count) {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  Vertex* vertices = mVertices + region * (mPointCount + 1);
+
+  for (uint32_t i = 0; i < count; ++i) {
+    uint32_t index = (first + i) % mPointCount;
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    vertices[index] = toVertex(vPoints[index]);
+  }
+
+  // Repeat the first point after the last one if it has changed.
+  if (first == 0 || first + count > mPointCount) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    vertices[mPointCount] = toVertex(vPoints[0]);
   }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void Trajectory::update(
+    glm::dmat4 const& relativeTransform, double dTime, glm::dvec3 const& vTip, int startIndex) {
+  mRelativeTransform = relativeTransform;
+  mTime              = dTime;
+  mTip               = vTip;
+  mStartIndex        = static_cast<uint32_t>(startIndex);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 bool Trajectory::Do() {
   if (mPointCount > 0 && mVAO) {
     if (mShaderDirty) {
@@ -172,29 +283,52 @@ bool Trajectory::Do() {
         mStartColor[2], mStartColor[3]);
     mShader->SetUniform(mShader->GetUniformLocation("cEndColor"), mEndColor[0], mEndColor[1],
         mEndColor[2], mEndColor[3]);
+    mShader->SetUniform(mShader->GetUniformLocation("uMaxAge"), static_cast<float>(mMaxAge));
 
     // get modelview and projection matrices
     std::array<GLfloat, 16> glMatMV{};
     std::array<GLfloat, 16> glMatP{};
     glGetFloatv(GL_MODELVIEW_MATRIX, glMatMV.data());
     glGetFloatv(GL_PROJECTION_MATRIX, glMatP.data());
-    glUniformMatrix4fv(mShader->GetUniformLocation("uMatModelView"), 1, GL_FALSE, glMatMV.data());
+
+    // The points are transformed relative to the observer, so only the rotation and scale of the
+    // modelview matrix are applied in the shader.
+    glm::dmat4 matModelView = glm::dmat4(glm::make_mat4(glMatMV.data())) * mRelativeTransform;
+    glm::dvec3 observer     = glm::dvec3(glm::inverse(matModelView)[3]);
+    glm::mat4  matRotation  = glm::mat4(glm::mat3(matModelView));
+    glm::vec3  tip          = glm::vec3(mTip - observer);
+    Vertex     reference    = toVertex(glm::dvec4(observer, mTime));
+
+    glUniformMatrix4fv(mShader->GetUniformLocation("uMatModelView"), 1, GL_FALSE,
+        glm::value_ptr(matRotation));
     glUniformMatrix4fv(mShader->GetUniformLocation("uMatProjection"), 1, GL_FALSE, glMatP.data());
+    glUniform4fv(
+        mShader->GetUniformLocation("uObserverHigh"), 1, glm::value_ptr(reference.mHigh));
+    glUniform4fv(mShader->GetUniformLocation("uObserverLow"), 1, glm::value_ptr(reference.mLow));
+    glUniform3fv(mShader->GetUniformLocation("uTip"), 1, glm::value_ptr(tip));
 
     glLineWidth(mWidth);
 
     uint32_t amountNoDepth = mPointCount / 2;
 
     glDepthMask(GL_FALSE);
-    glDrawArrays(GL_LINE_STRIP, 0, amountNoDepth + 1);
+    drawLineStrip(0, amountNoDepth + 1);
     glDepthMask(GL_TRUE);
 
-    glDrawArrays(GL_LINE_STRIP, amountNoDepth, mPointCount - amountNoDepth);
+    drawLineStrip(amountNoDepth, mPointCount - amountNoDepth);
 
     mShader->Release();
     mVAO->Release();
 
     glPopAttrib();
+
+    auto& region = mRegions.at(mCurrentRegion);
+
+    if (region.mFence) {
+      glDeleteSync(region.mFence);
+    }
+
+    region.mFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
   }
 
   return true;
@@ -224,6 +358,73 @@ void Trajectory::createShader() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void Trajectory::createBuffers(uint32_t pointCount) {
+  if (mVertices) {
+    mVBO->Bind(GL_ARRAY_BUFFER);
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+    mVBO->Release();
+  }
+
+  mVBO = std::make_unique<VistaBufferObject>();
+  mVAO = std::make_unique<VistaVertexArrayObject>();
+
+  mVAO->Bind();
+  mVBO->Bind(GL_ARRAY_BUFFER);
+
+  GLsizeiptr bufferSize = REGION_COUNT * (pointCount + 1) * sizeof(Vertex);
+  GLbitfield flags      = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+  glBufferStorage(GL_ARRAY_BUFFER, bufferSize, nullptr, flags);
+  mVertices = static_cast<Vertex*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, bufferSize, flags));
+
+  // high parts
+  mVAO->EnableAttributeArray(0);
+  mVAO->SpecifyAttributeArrayFloat(0, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0, mVBO.get());
+
+  // low parts
+  mVAO->EnableAttributeArray(1);
+  mVAO->SpecifyAttributeArrayFloat(
+      1, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), sizeof(glm::vec4), mVBO.get());
+
+  mVAO->Release();
+  mVBO->Release();
+
+  mPointCount = pointCount;
+
+  // The old buffer is not used anymore, so there is nothing to wait for. The caller writes all
+  // points afterwards, this marks them as pending for the other regions as well.
+  for (auto& region : mRegions) {
+    if (region.mFence) {
+      glDeleteSync(region.mFence);
+      region.mFence = nullptr;
+    }
+
+    region.mPendingRanges.clear();
+  }
+
+  mCurrentRegion = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Trajectory::drawLineStrip(uint32_t first, uint32_t count) const {
+  uint32_t offset = mCurrentRegion * (mPointCount + 1);
+  uint32_t start  = (mStartIndex + first) % mPointCount;
+
+  if (start + count <= mPointCount + 1) {
+    glDrawArrays(GL_LINE_STRIP, static_cast<GLint>(offset + start), static_cast<GLsizei>(count));
+    return;
+  }
+
+  // The strip wraps around the end of the ring buffer. The first part ends with the copy of the
+  // first point, the second part starts with the first point.
+  uint32_t firstPart = mPointCount + 1 - start;
+  glDrawArrays(GL_LINE_STRIP, static_cast<GLint>(offset + start), static_cast<GLsizei>(firstPart));
+  glDrawArrays(GL_LINE_STRIP, static_cast<GLint>(offset),
+      static_cast<GLsizei>(count - firstPart + 1));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 double Trajectory::getMaxAge() const {
   return mMaxAge;
 }
@@ -14,9 +14,11 @@
 #include <VistaOGLExt/VistaGLSLShader.h>
 #include <VistaOGLExt/VistaVertexArrayObject.h>
 
+#include <array>
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include <memory>
+#include <utility>
 #include <vector>
 
 namespace cs::scene {
@@ -29,8 +31,26 @@ namespace cs::scene {
 /// The color of every point is also dependent on the lifetime. It is controlled with the members
 /// startColor and endColor. A young point will have a color closer to the startColor and an old
 /// point, which is close to the maxAge will have a color closer to the endColor.
+///
+/// The points are stored in a ring buffer which is persistently mapped to the GPU. Only points
+/// which have changed have to be written, the transformation to observer centric coordinates and
+/// the computation of the age of the points happen in the vertex shader. The mapped buffer contains
+/// several copies of the ring buffer, so that new points can be written to one of them while the
+/// GPU is still drawing another one.
 class CS_SCENE_EXPORT Trajectory : public IVistaOpenGLDraw {
  public:
+  /// A point of the trajectory as it is stored on the GPU. The position (xyz) and the time (w) of
+  /// the point are both stored as the sum of two floats. The vertex shader subtracts the position
+  /// of the observer and the current time from both parts separately before adding them. This way,
+  /// relative positions and ages retain nearly double precision close to the observer.
+  struct Vertex {
+    glm::vec4 mHigh;
+    glm::vec4 mLow;
+  };
+
+  /// Splits the given point (position and time) into the two parts of a Vertex.
+  static Vertex toVertex(glm::dvec4 const& point);
+
   Trajectory();
 
   Trajectory(Trajectory const& other) = delete;
@@ -39,13 +59,20 @@ class CS_SCENE_EXPORT Trajectory : public IVistaOpenGLDraw {
   Trajectory& operator=(Trajectory const& other) = delete;
   Trajectory& operator=(Trajectory&& other) = delete;
 
-  ~Trajectory() override = default;
+  ~Trajectory() override;
+
+  /// Writes count points of the given ring buffer to the GPU, starting at index first. The range
+  /// wraps around at the end of the ring buffer. If the size of the ring buffer changed since the
+  /// last call, the GPU buffer is recreated and all points are written. Call this whenever points
+  /// have changed, even if the trajectory is not drawn.
+  void uploadPoints(std::vector<glm::dvec4> const& vPoints, int first, int count);
 
-  /// Transforms all points by relativeTransform and uploads them to the GPU. Call this every frame
-  /// in order to show the trajectory with observer centric coordinates. dTime determines the
-  /// current age of all points.
-  void upload(glm::dmat4 const& relativeTransform, double dTime,
-      std::vector<glm::dvec4> const& vPoints, glm::dvec3 const& vTip, int startIndex);
+  /// Sets the transformation from the coordinate system of the points to observer centric
+  /// coordinates. Call this every frame. dTime determines the current age of all points, points
+  /// which are not older than dTime are drawn at vTip. startIndex is the index of the oldest point
+  /// in the ring buffer.
+  void update(
+      glm::dmat4 const& relativeTransform, double dTime, glm::dvec3 const& vTip, int startIndex);
 
   /// The method Do() gets the callback from scene graph during the rendering process.
   /// Renders the trajectory in its current state.
@@ -78,10 +105,52 @@ class CS_SCENE_EXPORT Trajectory : public IVistaOpenGLDraw {
  private:
   void createShader();
 
+  /// Creates a persistently mapped vertex buffer for the given number of points.
+  void createBuffers(uint32_t pointCount);
+
+  /// Returns the index of a region which is not used by the GPU anymore. If the GPU is still busy
+  /// with all other regions, this waits for the next one.
+  uint32_t acquireRegion();
+
+  /// Writes count points of the given ring buffer to the given region, starting at index first.
+  void writePoints(
+      std::vector<glm::dvec4> const& vPoints, uint32_t region, uint32_t first, uint32_t count);
+
+  /// Draws count points as a line strip, starting with the point at index first counted from the
+  /// oldest point.
+  void drawLineStrip(uint32_t first, uint32_t count) const;
+
+  /// One copy of the ring buffer in the mapped vertex buffer.
+  struct Region {
+    /// This is signaled when the GPU has finished drawing the region.
+    GLsync mFence = nullptr;
+
+    /// The ranges of points (first, count) which have been written to other regions since this
+    /// region has been written last. These are written as well once this region is used again.
+    std::vector<std::pair<uint32_t, uint32_t>> mPendingRanges;
+  };
+
+  /// The regions are used round-robin so that an upload does not have to wait for the GPU.
+  static const uint32_t REGION_COUNT = 3;
+
   std::unique_ptr<VistaGLSLShader>        mShader;
   std::unique_ptr<VistaVertexArrayObject> mVAO;
   std::unique_ptr<VistaBufferObject>      mVBO;
 
+  /// The mapped vertex buffer. Each region contains one more vertex than there are points: The
+  /// first point is repeated at the end so that line strips can wrap around the end of the ring
+  /// buffer.
+  Vertex* mVertices = nullptr;
+
+  /// The region which is written by uploadPoints() and drawn by Do().
+  std::array<Region, REGION_COUNT> mRegions;
+  uint32_t                         mCurrentRegion = 0;
+
+  glm::dmat4 mRelativeTransform{1.0};
+  glm::dvec3 mTip{};
+  double     mTime       = 0.0;
+  uint32_t   mStartIndex = 0;
+
   double    mMaxAge;
   glm::vec4 mStartColor;
   glm::vec4 mEndColor;
@@ -7,6 +7,7 @@
 #include "Downloader.hpp"
 
 #include "../cs-utils/filesystem.hpp"
+#include "TraceRecorder.hpp"
 #include "logger.hpp"
 
 namespace cs::utils {
@@ -31,6 +32,7 @@ void Downloader::download(std::string const& url, std::string const& file) {
   // We download to a file with a .part suffix. Once the download is done, we will remove the
   // suffix.
   mThreadPool.enqueue([this, file, url, progressIndex]() {
+    CS_TRACE_ZONE("Downloader::download");
     logger().info("Downloading file '{}'...", file);
 
     filesystem::downloadFile(
@@ -6,6 +6,7 @@
 
 #include "FrameTimings.hpp"
 
+#include "TraceRecorder.hpp"
 #include "logger.hpp"
 
 #include <GL/glew.h>
@@ -20,6 +21,18 @@ namespace {
 int                                            s_iCurrentInstance = 0;
 std::array<std::shared_ptr<TimerQueryPool>, 2> s_pTimerQueryPoolInstances{};
 std::string                                    s_sLastRangeKey{};
+std::unordered_map<std::string, uint64_t>      s_mCounters{};
+std::unordered_map<std::string, uint64_t>      s_mLastCounters{};
+std::thread::id                                s_mainThread{};
+
+// The timer query pools are only used on the thread which created the FrameTimings.
+TimerQueryPool* getCurrentPool() {
+  if (std::this_thread::get_id() != s_mainThread) {
+    return nullptr;
+  }
+
+  return s_pTimerQueryPoolInstances.at(s_iCurrentInstance).get();
+}
 } // namespace
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -27,11 +40,20 @@ std::string                                    s_sLastRangeKey{};
 FrameTimings::ScopedTimer::ScopedTimer(std::string name, QueryMode mode)
     : mName(std::move(name)) {
   FrameTimings::start(mName, mode);
+
+  // Interning requires a lock, so it is only done if the zone is actually recorded.
+  if (TraceRecorder::isEnabled()) {
+    mTraced = TraceRecorder::begin(TraceRecorder::intern(mName), mode != QueryMode::eCPU);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 FrameTimings::ScopedTimer::~ScopedTimer() {
+  if (mTraced) {
+    TraceRecorder::end();
+  }
+
   try {
     FrameTimings::end(mName);
   } catch (...) {}
@@ -40,8 +62,8 @@ FrameTimings::ScopedTimer::~ScopedTimer() {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void FrameTimings::start(std::string const& name, QueryMode mode) {
-  if (s_pTimerQueryPoolInstances.at(s_iCurrentInstance)) {
-    s_pTimerQueryPoolInstances.at(s_iCurrentInstance)->start(name, mode);
+  if (auto* pool = getCurrentPool()) {
+    pool->start(name, mode);
     s_sLastRangeKey = name;
   }
 }
@@ -49,16 +71,24 @@ void FrameTimings::start(std::string const& name, QueryMode mode) {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void FrameTimings::end(std::string const& name) {
-  if (s_pTimerQueryPoolInstances.at(s_iCurrentInstance)) {
-    s_pTimerQueryPoolInstances.at(s_iCurrentInstance)->end(name);
+  if (auto* pool = getCurrentPool()) {
+    pool->end(name);
   }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void FrameTimings::end() {
-  if (s_pTimerQueryPoolInstances.at(s_iCurrentInstance)) {
-    s_pTimerQueryPoolInstances.at(s_iCurrentInstance)->end(s_sLastRangeKey);
+  if (auto* pool = getCurrentPool()) {
+    pool->end(s_sLastRangeKey);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void FrameTimings::count(std::string const& name, uint64_t value) {
+  if (getCurrentPool()) {
+    s_mCounters[name] += value;
   }
 }
 
@@ -91,7 +121,16 @@ FrameTimings::getCalculatedQueryResults() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+std::unordered_map<std::string, uint64_t> const& FrameTimings::getCounters() const {
+  return s_mLastCounters;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 FrameTimings::FrameTimings() {
+  s_mainThread = std::this_thread::get_id();
+  TraceRecorder::setThreadName("Main Thread");
+
   std::size_t const maxNRofTimings = 512;
   pEnableMeasurements.connect([maxNRofTimings](bool enable) {
     if (enable) {
@@ -130,8 +169,13 @@ void FrameTimings::endFullFrameTiming() {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void FrameTimings::update() const {
+  TraceRecorder::endFrame();
+
   s_iCurrentInstance = (s_iCurrentInstance + 1) % 2;
 
+  std::swap(s_mLastCounters, s_mCounters);
+  s_mCounters.clear();
+
   if (!s_pTimerQueryPoolInstances.at(s_iCurrentInstance)) {
     return;
   }
@@ -23,7 +23,8 @@ class TimerQueryPool;
 
 /// Responsible for measuring time. It is possible to measure either or both CPU and GPU time. To
 /// create a time measuring object use ScopedTimer. This class is not thread-safe, so you should
-/// only use it to measure time on the main thread. You should not need to instantiate this class.
+/// only use it to measure time on the main thread; calls from other threads are ignored. You should
+/// not need to instantiate this class.
 /// One instance will be created by the application class and is passed to each and every plugin.
 class CS_UTILS_EXPORT FrameTimings {
  public:
@@ -43,7 +44,9 @@ class CS_UTILS_EXPORT FrameTimings {
 
   /// A ScopedTimer is responsible for measuring time for its entire existence. The timer will
   /// start measuring upon creation and stop measuring on deletion. If multiple timers with the same
-  /// name are created during one frame, their timings will be accumulated.
+  /// name are created during one frame, their timings will be accumulated. If the TraceRecorder is
+  /// enabled, each ScopedTimer is recorded as a zone as well, also on threads other than the main
+  /// thread.
   class CS_UTILS_EXPORT ScopedTimer {
    public:
     /// @param name The name of the measured time.
@@ -60,6 +63,7 @@ class CS_UTILS_EXPORT FrameTimings {
 
    private:
     std::string mName;
+    bool        mTraced = false;
   };
 
   struct CS_UTILS_EXPORT QueryResult {
@@ -91,6 +95,11 @@ class CS_UTILS_EXPORT FrameTimings {
   /// often more easy to use.
   static void end();
 
+  /// Adds the given value to the counter with the given name. Counters are reset each frame, so
+  /// they can be used to count events like draw calls or sent messages. Like the timers, counters
+  /// are only recorded if pEnableMeasurements is true.
+  static void count(std::string const& name, uint64_t value = 1);
+
   /// Starts the time measurement for the current frame. No need to call this manually. The
   /// application is responsible for this.
   void startFullFrameTiming();
@@ -100,6 +109,7 @@ class CS_UTILS_EXPORT FrameTimings {
   void endFullFrameTiming();
 
   /// Updates the frame timings. The application takes care of calling this on the primary instance.
+  /// This also marks the end of the frame for the TraceRecorder.
   void update() const;
 
   /// Once update() has been called, QueryResults most likely are available. However, we will only
@@ -107,6 +117,9 @@ class CS_UTILS_EXPORT FrameTimings {
   /// a few frames longer to get any results from the GPU.
   std::unordered_map<std::string, QueryResult> getCalculatedQueryResults() const;
 
+  /// Returns the values which the counters had at the end of the last frame.
+  std::unordered_map<std::string, uint64_t> const& getCounters() const;
+
  private:
   int                                            mCurrentIndex = 0;
   std::array<std::shared_ptr<TimerQueryPool>, 2> mFullFrameTimerPools;
@@ -6,38 +6,41 @@
 
 #include "ThreadPool.hpp"
 
-#include <iostream>
+#include <algorithm>
+#include <exception>
 
 namespace cs::utils {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-ThreadPool::ThreadPool(size_t threads)
-    : mStop(false) {
-  for (size_t i = 0; i < threads; ++i) {
-    mWorkers.emplace_back([this] {
-      while (true) {
-        std::function<void()> task;
-        {
-          std::unique_lock<std::mutex> lock(mMutex);
+namespace {
 
-          mCondition.wait(lock, [this] { return mStop || !mTasks.empty(); });
+// These are used to push tasks which are enqueued from within a worker thread to the queue of this
+// worker.
+thread_local ThreadPool const* tCurrentPool   = nullptr;
+thread_local size_t            tCurrentWorker = 0;
 
-          if (mStop && mTasks.empty()) {
-            return;
-          }
+} // namespace
 
-          task = std::move(mTasks.top());
-          mTasks.pop();
-          ++mRunningTasks;
-        }
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-        task();
+bool ThreadPool::Entry::operator<(Entry const& other) const {
+  if (mPriority == other.mPriority) {
+    return mSequence < other.mSequence;
+  }
 
-        std::unique_lock<std::mutex> lock(mMutex);
-        --mRunningTasks;
-      }
-    });
+  return mPriority < other.mPriority;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ThreadPool::ThreadPool(size_t threads) {
+  for (size_t i = 0; i < threads; ++i) {
+    mQueues.push_back(std::make_unique<Queue>());
+  }
+
+  for (size_t i = 0; i < threads; ++i) {
+    mWorkers.emplace_back([this, i] { work(i); });
   }
 }
 
@@ -45,7 +48,7 @@ ThreadPool::ThreadPool(size_t threads)
 
 ThreadPool::~ThreadPool() {
   {
-    std::unique_lock<std::mutex> lock(mMutex);
+    std::unique_lock<std::mutex> lock(mSleepMutex);
     mStop = true;
   }
 
@@ -58,4 +61,214 @@ ThreadPool::~ThreadPool() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void ThreadPool::reprioritize() {
+  for (auto& queue : mQueues) {
+    std::unique_lock<std::mutex> lock(queue->mMutex);
+
+    auto& entries = queue->mEntries;
+    auto  end     = std::remove_if(entries.begin(), entries.end(),
+        [](Entry const& e) { return e.mHandle && e.mHandle->mCancelled; });
+
+    mPendingTasks -= static_cast<uint32_t>(std::distance(end, entries.end()));
+    entries.erase(end, entries.end());
+
+    for (auto& entry : entries) {
+      if (entry.mHandle) {
+        entry.mPriority = entry.mHandle->mPriority;
+      }
+    }
+
+    std::make_heap(entries.begin(), entries.end());
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ThreadPool::push(std::unique_ptr<Task>&& task, std::shared_ptr<TaskHandle::State> handle) {
+  if (mStop) {
+    throw std::runtime_error("enqueue on stopped ThreadPool");
+  }
+
+  if (mQueues.empty()) {
+    throw std::runtime_error("enqueue on ThreadPool without threads");
+  }
+
+  Entry entry;
+  entry.mPriority = handle ? handle->mPriority.load() : 0.0;
+  entry.mSequence = mSequence++;
+  entry.mTask     = std::move(task);
+  entry.mHandle   = std::move(handle);
+
+  // The pending counter is incremented before the task is actually pushed. This way it can never
+  // become negative.
+  ++mPendingTasks;
+
+  size_t queueIdx = tCurrentPool == this ? tCurrentWorker : entry.mSequence % mQueues.size();
+
+  {
+    auto&                        queue = *mQueues[queueIdx];
+    std::unique_lock<std::mutex> lock(queue.mMutex);
+    queue.mEntries.push_back(std::move(entry));
+    std::push_heap(queue.mEntries.begin(), queue.mEntries.end());
+  }
+
+  // Workers increment mSleepingWorkers before they check mPendingTasks, we do it the other way
+  // around. Hence, either the worker sees the new task or we see the sleeping worker. Locking the
+  // mutex ensures that the worker has actually started waiting before it gets notified.
+  if (mSleepingWorkers > 0) {
+    { std::unique_lock<std::mutex> lock(mSleepMutex); }
+    mCondition.notify_one();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool ThreadPool::popFrom(Queue& queue, Entry& entry) {
+  std::unique_lock<std::mutex> lock(queue.mMutex);
+
+  while (!queue.mEntries.empty()) {
+    std::pop_heap(queue.mEntries.begin(), queue.mEntries.end());
+    entry = std::move(queue.mEntries.back());
+    queue.mEntries.pop_back();
+
+    if (entry.mHandle && entry.mHandle->mCancelled) {
+      // Dropping the task will set a broken_promise error on its future.
+      entry.mTask.reset();
+      --mPendingTasks;
+      continue;
+    }
+
+    // The running counter is incremented first so that hasFinished() never reports a false
+    // positive.
+    ++mRunningTasks;
+    --mPendingTasks;
+    return true;
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool ThreadPool::pop(size_t worker, Entry& entry) {
+  for (size_t i = 0; i < mQueues.size(); ++i) {
+    if (popFrom(*mQueues[(worker + i) % mQueues.size()], entry)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ThreadPool::work(size_t worker) {
+  tCurrentPool   = this;
+  tCurrentWorker = worker;
+
+  while (true) {
+    Entry entry;
+
+    if (pop(worker, entry)) {
+      entry.mTask->run();
+      entry.mTask.reset();
+      --mRunningTasks;
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(mSleepMutex);
+    ++mSleepingWorkers;
+    mCondition.wait(lock, [this] { return mStop || mPendingTasks > 0; });
+    --mSleepingWorkers;
+
+    if (mStop && mPendingTasks == 0) {
+      return;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ThreadPool& getSharedThreadPool() {
+  static ThreadPool pool(std::max(2U, std::thread::hardware_concurrency()) - 1);
+  return pool;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void parallelFor(
+    std::size_t count, std::function<void(std::size_t)> const& function, std::size_t chunkSize) {
+  chunkSize = std::max<std::size_t>(1, chunkSize);
+
+  std::size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+
+  if (chunkCount == 0) {
+    return;
+  }
+
+  // The chunks are claimed one after another by all participating threads. The state is shared
+  // with the helper tasks, as these may only be started after this call has returned already.
+  struct State {
+    std::atomic<std::size_t> mNextChunk{0};
+    std::mutex               mMutex;
+    std::condition_variable  mCondition;
+    std::size_t              mRunningHelpers = 0;
+    std::exception_ptr       mException;
+  };
+
+  auto state = std::make_shared<State>();
+
+  auto processChunks = [state, &function, count, chunkSize, chunkCount]() {
+    std::size_t chunk = 0;
+
+    while ((chunk = state->mNextChunk++) < chunkCount) {
+      try {
+        std::size_t end = std::min(count, (chunk + 1) * chunkSize);
+        for (std::size_t i = chunk * chunkSize; i < end; ++i) {
+          function(i);
+        }
+      } catch (...) {
+        std::unique_lock<std::mutex> lock(state->mMutex);
+        if (!state->mException) {
+          state->mException = std::current_exception();
+        }
+        state->mNextChunk = chunkCount;
+      }
+    }
+  };
+
+  // Helpers only join if there are chunks left when they are started. Otherwise they return
+  // without accessing the function, which may not exist anymore at that point.
+  auto& pool = getSharedThreadPool();
+
+  for (std::size_t i = 1; i < chunkCount && i <= pool.getWorkerCount(); ++i) {
+    pool.enqueue([state, processChunks, chunkCount]() {
+      {
+        std::unique_lock<std::mutex> lock(state->mMutex);
+        if (state->mNextChunk >= chunkCount) {
+          return;
+        }
+        ++state->mRunningHelpers;
+      }
+
+      processChunks();
+
+      std::unique_lock<std::mutex> lock(state->mMutex);
+      --state->mRunningHelpers;
+      state->mCondition.notify_all();
+    });
+  }
+
+  processChunks();
+
+  std::unique_lock<std::mutex> lock(state->mMutex);
+  state->mCondition.wait(lock, [&state]() { return state->mRunningHelpers == 0; });
+
+  if (state->mException) {
+    std::rethrow_exception(state->mException);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 } // namespace cs::utils
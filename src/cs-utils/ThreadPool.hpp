@@ -9,19 +9,71 @@
 
 #include "cs_utils_export.hpp"
 
+#include <atomic>
 #include <condition_variable>
 #include <functional>
 #include <future>
 #include <memory>
 #include <mutex>
-#include <stack>
 #include <stdexcept>
 #include <thread>
 #include <vector>
 
 namespace cs::utils {
 
-/// This is based on https://github.com/progschj/ThreadPool
+/// A TaskHandle can be passed to ThreadPool::enqueue() in order to change the priority of a task
+/// after it has been enqueued or to cancel it before it is executed. Copies of a handle share the
+/// same state, hence one handle can also be used to control a whole group of tasks.
+class TaskHandle {
+ public:
+  explicit TaskHandle(double priority = 0.0)
+      : mState(std::make_shared<State>(priority)) {
+  }
+
+  /// Tasks with a higher priority are executed first. Changes to the priority of an already
+  /// enqueued task are considered once ThreadPool::reprioritize() is called.
+  void setPriority(double priority) const {
+    mState->mPriority = priority;
+  }
+
+  double getPriority() const {
+    return mState->mPriority;
+  }
+
+  /// Tasks which have been cancelled before they were started are dropped by the ThreadPool. The
+  /// std::future returned by ThreadPool::enqueue() will then throw a std::future_error with
+  /// std::future_errc::broken_promise. Tasks which are already running are not affected.
+  void cancel() const {
+    mState->mCancelled = true;
+  }
+
+  bool isCancelled() const {
+    return mState->mCancelled;
+  }
+
+ private:
+  friend class ThreadPool;
+
+  struct State {
+    explicit State(double priority)
+        : mPriority(priority) {
+    }
+
+    std::atomic<double> mPriority;
+    std::atomic<bool>   mCancelled{false};
+  };
+
+  std::shared_ptr<State> mState;
+};
+
+/// The ThreadPool executes tasks on a fixed number of worker threads. Each worker has its own
+/// task queue, which is ordered by priority; tasks with equal priority are executed in reverse
+/// order of their submission (newest first). Tasks enqueued from a worker thread are put into the
+/// queue of this worker, all others are distributed among the workers in a round-robin fashion.
+/// Idle workers steal the most important task from the queues of the other workers. As there is no
+/// global lock, the order of execution across workers is only approximately sorted by priority.
+///
+/// This was initially based on https://github.com/progschj/ThreadPool
 class CS_UTILS_EXPORT ThreadPool {
  public:
   /// Creates a new ThreadPool with the specified amount of threads.
@@ -33,56 +85,139 @@ class CS_UTILS_EXPORT ThreadPool {
   ThreadPool& operator=(ThreadPool const& other) = delete;
   ThreadPool& operator=(ThreadPool&& other) = delete;
 
+  /// Waits for all pending tasks to be finished.
   virtual ~ThreadPool();
 
-  /// Adds a new work item to the pool.
+  /// Adds a new work item with default priority to the pool. It cannot be cancelled.
   template <class F>
   auto enqueue(F&& f) -> std::future<typename std::invoke_result<F>::type> {
     using return_type = typename std::invoke_result<F>::type;
 
-    auto task = std::make_shared<std::packaged_task<return_type()>>(
-        [Func = std::forward<F>(f)] { return Func(); });
-
-    std::future<return_type> res = task->get_future();
-    {
-      std::unique_lock<std::mutex> lock(mMutex);
+    auto                     task = std::make_unique<TaskImpl<return_type>>(std::forward<F>(f));
+    std::future<return_type> res  = task->mTask.get_future();
+    push(std::move(task), nullptr);
+    return res;
+  }
 
-      if (mStop) {
-        throw std::runtime_error("enqueue on stopped ThreadPool");
-      }
+  /// Adds a new work item to the pool. The given handle can be used to change the priority of the
+  /// task or to cancel it as long as it has not been started.
+  template <class F>
+  auto enqueue(F&& f, TaskHandle const& handle)
+      -> std::future<typename std::invoke_result<F>::type> {
+    using return_type = typename std::invoke_result<F>::type;
 
-      mTasks.emplace([task]() { (*task)(); });
-    }
-    mCondition.notify_one();
+    auto                     task = std::make_unique<TaskImpl<return_type>>(std::forward<F>(f));
+    std::future<return_type> res  = task->mTask.get_future();
+    push(std::move(task), handle.mState);
     return res;
   }
 
+  /// Re-sorts all pending tasks according to the current priorities of their TaskHandles and
+  /// removes cancelled tasks. This is linear in the number of pending tasks, so it should be called
+  /// once after a batch of priority changes, for example once each frame.
+  void reprioritize();
+
   /// Returns the amount of tasks that await execution.
   uint32_t getPendingTaskCount() const {
-    std::unique_lock<std::mutex> lock(mMutex);
-    return static_cast<uint32_t>(mTasks.size());
+    return mPendingTasks;
   }
 
   /// Returns the number of tasks that currently are being executed.
   uint32_t getRunningTaskCount() const {
-    std::unique_lock<std::mutex> lock(mMutex);
     return mRunningTasks;
   }
 
+  /// Returns the number of worker threads.
+  std::size_t getWorkerCount() const {
+    return mWorkers.size();
+  }
+
   /// Retruns true when there are no more tasks running or pending.
   bool hasFinished() const {
     return getPendingTaskCount() + getRunningTaskCount() == 0;
   }
 
  private:
-  std::vector<std::thread>          mWorkers;
-  std::stack<std::function<void()>> mTasks;
-  mutable std::mutex                mMutex;
-  std::condition_variable           mCondition;
-  bool                              mStop;
-  uint32_t                          mRunningTasks = 0;
+  /// Type-erased base class of all tasks. Together with the std::packaged_task this requires just
+  /// two allocations per enqueued task.
+  struct Task {
+    Task() = default;
+
+    Task(Task const& other) = delete;
+    Task(Task&& other)      = delete;
+
+    Task& operator=(Task const& other) = delete;
+    Task& operator=(Task&& other) = delete;
+
+    virtual ~Task()    = default;
+    virtual void run() = 0;
+  };
+
+  template <typename R>
+  struct TaskImpl : public Task {
+    template <typename F>
+    explicit TaskImpl(F&& f)
+        : mTask(std::forward<F>(f)) {
+    }
+
+    void run() override {
+      mTask();
+    }
+
+    std::packaged_task<R()> mTask;
+  };
+
+  /// An entry in the queue of a worker. The priority is cached so that the heap property of the
+  /// queue is not violated when the priority of the TaskHandle is changed concurrently.
+  struct Entry {
+    std::unique_ptr<Task>              mTask;
+    std::shared_ptr<TaskHandle::State> mHandle;
+    double                             mPriority = 0.0;
+    uint64_t                           mSequence = 0;
+
+    bool operator<(Entry const& other) const;
+  };
+
+  /// The queue of a single worker. It is kept as a binary max-heap.
+  struct Queue {
+    std::mutex         mMutex;
+    std::vector<Entry> mEntries;
+  };
+
+  void push(std::unique_ptr<Task>&& task, std::shared_ptr<TaskHandle::State> handle);
+
+  /// Tries to take a task from the worker's own queue; if this is empty, it tries to steal one from
+  /// the other queues. Cancelled tasks are dropped on the way.
+  bool pop(size_t worker, Entry& entry);
+  bool popFrom(Queue& queue, Entry& entry);
+
+  void work(size_t worker);
+
+  std::vector<std::thread>            mWorkers;
+  std::vector<std::unique_ptr<Queue>> mQueues;
+  std::mutex                          mSleepMutex;
+  std::condition_variable             mCondition;
+  std::atomic<bool>                   mStop{false};
+  std::atomic<uint32_t>               mPendingTasks{0};
+  std::atomic<uint32_t>               mRunningTasks{0};
+  std::atomic<uint32_t>               mSleepingWorkers{0};
+  std::atomic<uint64_t>               mSequence{0};
 };
 
+/// Returns a ThreadPool which is shared by everything which wants to spread a computation across
+/// all CPU cores, see parallelFor(). It has one thread less than there are CPU cores, as the
+/// calling thread of parallelFor() takes part in the computation. It is created on first use.
+CS_UTILS_EXPORT ThreadPool& getSharedThreadPool();
+
+/// Calls the given function for each index in [0, count). The indices are processed in chunks of
+/// the given size by the calling thread and by the workers of the shared thread pool. This returns
+/// once all indices have been processed. If the function throws, the remaining chunks are skipped
+/// and the first exception is rethrown once all running chunks are finished.
+/// As the calling thread processes chunks as well, this may be called from any thread, including
+/// the workers of the shared thread pool themselves.
+CS_UTILS_EXPORT void parallelFor(
+    std::size_t count, std::function<void(std::size_t)> const& function, std::size_t chunkSize = 1);
+
 } // namespace cs::utils
 
 #endif // CS_UTILS_THREADPOOL_HPP
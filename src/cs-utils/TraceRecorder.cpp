@@ -0,0 +1,731 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "TraceRecorder.hpp"
+
+#include "logger.hpp"
+
+#include <GL/glew.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_set>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define CS_TRACE_USE_TSC
+#endif
+
+// The buffer of each thread is looked up twice per zone. With the initial-exec model, this is a
+// single load instead of a call to __tls_get_addr. This is possible as this library is never loaded
+// with dlopen().
+#if defined(__GNUC__) && !defined(_WIN32)
+#define CS_TRACE_TLS_MODEL __attribute__((tls_model("initial-exec")))
+#else
+#define CS_TRACE_TLS_MODEL
+#endif
+
+namespace cs::utils {
+
+std::atomic<bool> TraceRecorder::sEnabled{false};
+
+namespace {
+
+// Zones which are nested deeper than this are not recorded.
+uint32_t const cMaxDepth = 64;
+
+// The default number of zones per thread. With 32 bytes per zone, this is 1 MB per thread.
+std::size_t const cDefaultBufferSize = 32768;
+
+// Once more frames or GPU zones have been recorded, the oldest ones are dropped.
+std::size_t const cMaxFrames   = 100000;
+std::size_t const cMaxGPUZones = 65536;
+
+// The buffers of threads which have exited are kept for export until there are more than this.
+std::size_t const cMaxRetiredBuffers = 32;
+
+// GPU timestamps are read back with a latency of this many frames to prevent stalls.
+std::size_t const cGPUFrameCount = 3;
+
+// The track ids of the exported trace. Threads are numbered starting at cFirstThreadTrack.
+uint32_t const cFrameTrack       = 0;
+uint32_t const cGPUTrack         = 1;
+uint32_t const cFirstThreadTrack = 2;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int64_t steadyNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Returns the current time in ticks. On x86, the time stamp counter is read directly as this is
+// several times faster than querying the std::chrono::steady_clock. Modern x86 CPUs have an
+// invariant time stamp counter which runs at a constant rate and is synchronized across all cores.
+// Elsewhere, the ticks are nanoseconds of the steady_clock.
+inline uint64_t now() {
+#ifdef CS_TRACE_USE_TSC
+  return __rdtsc();
+#else
+  return static_cast<uint64_t>(steadyNanos());
+#endif
+}
+
+// Measures the duration of a tick by comparing the ticks and the steady_clock which elapsed since
+// its construction. The longer the application runs, the more precise this gets.
+class Calibration {
+ public:
+  Calibration()
+      : mTicks(now())
+      , mNanos(steadyNanos()) {
+  }
+
+  double getNanosPerTick() const {
+#ifdef CS_TRACE_USE_TSC
+    uint64_t const ticks = now();
+    int64_t const  nanos = steadyNanos();
+
+    if (ticks <= mTicks || nanos <= mNanos) {
+      return 1.0;
+    }
+
+    return static_cast<double>(nanos - mNanos) / static_cast<double>(ticks - mTicks);
+#else
+    return 1.0;
+#endif
+  }
+
+ private:
+  uint64_t mTicks;
+  int64_t  mNanos;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// A completed zone as it is stored in the ring buffer of a thread. All members are atomic, as the
+// slots may be read by an export while they are overwritten. Relaxed accesses are sufficient, the
+// ordering is established by the counters of the ThreadBuffer.
+struct Slot {
+  std::atomic<char const*> mName{nullptr};
+  std::atomic<uint64_t>    mStart{0};
+  std::atomic<uint64_t>    mEnd{0};
+  std::atomic<uint32_t>    mId{0};
+  std::atomic<uint32_t>    mParent{0};
+};
+
+// A plain copy of a Slot.
+struct Event {
+  char const* mName;
+  uint64_t    mStart;
+  uint64_t    mEnd;
+  uint32_t    mId;
+  uint32_t    mParent;
+};
+
+// A zone which has been opened but not yet closed.
+struct OpenZone {
+  char const* mName;
+  uint64_t    mStart;
+  uint32_t    mId;
+  uint32_t    mParent;
+  int32_t     mGPUZone;
+};
+
+// Each thread writes its zones into a ThreadBuffer of its own. The owning thread is the only
+// writer, exports may read the slots concurrently. This works like a sequence lock: The writer
+// first increases mClaimed, then writes the slot and finally increases mWritten. A reader copies
+// the slots up to mWritten and afterwards discards all copies whose slots may have been claimed
+// for overwriting in the meantime.
+struct ThreadBuffer {
+  ThreadBuffer(uint32_t track, std::size_t capacity)
+      : mTrack(track)
+      , mName("Thread " + std::to_string(track - cFirstThreadTrack + 1))
+      , mSlots(std::make_unique<Slot[]>(capacity))
+      , mMask(capacity - 1) {
+  }
+
+  uint32_t    mTrack;
+  std::string mName; // Guarded by the mutex of the Registry.
+
+  std::unique_ptr<Slot[]> mSlots;
+  uint64_t                mMask;
+  std::atomic<uint64_t>   mClaimed{0};
+  std::atomic<uint64_t>   mWritten{0};
+  std::atomic<uint64_t>   mClearedUntil{0};
+  std::atomic<bool>       mRetired{false};
+
+  // These are only accessed by the owning thread.
+  std::array<OpenZone, cMaxDepth> mStack{};
+  uint32_t                        mDepth  = 0;
+  uint32_t                        mNextId = 1;
+};
+
+// A frame as it is shown on the frame track of the trace.
+struct Frame {
+  uint64_t mNumber;
+  uint64_t mStart;
+  uint64_t mEnd;
+};
+
+// The GPU time of a zone converted to ticks of the CPU clock.
+struct GPUEvent {
+  char const* mName;
+  uint64_t    mStart;
+  uint64_t    mEnd;
+  uint64_t    mCPUStart;
+  uint32_t    mTrack;
+  uint32_t    mId;
+};
+
+// Everything which is shared among the threads.
+struct Registry {
+  Calibration mCalibration;
+
+  std::mutex                                 mMutex;
+  std::vector<std::shared_ptr<ThreadBuffer>> mBuffers;
+  uint32_t                                   mNextTrack  = cFirstThreadTrack;
+  std::size_t                                mBufferSize = cDefaultBufferSize;
+  std::deque<Frame>                          mFrames;
+  std::deque<GPUEvent>                       mGPUEvents;
+  uint64_t                                   mFrameCount   = 0;
+  uint64_t                                   mLastFrameEnd = now();
+
+  std::mutex                      mNamesMutex;
+  std::unordered_set<std::string> mNames;
+};
+
+// The registry is never destroyed, as threads may still record zones during shutdown.
+Registry& registry() {
+  static auto* instance = new Registry();
+  return *instance;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// GPU zones are only recorded on the render thread, so these do not need any synchronization.
+struct GPUZone {
+  char const* mName;
+  uint64_t    mCPUStart;
+  uint32_t    mId;
+  GLuint      mBeginQuery;
+  GLuint      mEndQuery;
+};
+
+struct GPUFrame {
+  std::vector<GLuint>  mQueries;
+  std::size_t          mUsedQueries = 0;
+  std::vector<GPUZone> mZones;
+};
+
+struct GPUState {
+  std::array<GPUFrame, cGPUFrameCount> mFrames;
+  std::size_t                          mCurrent = 0;
+};
+
+GPUState& gpuState() {
+  static auto* instance = new GPUState();
+  return *instance;
+}
+
+// Returns a timestamp query of the current frame which has been issued right now.
+GLuint queryTimestamp(GPUFrame& frame) {
+  if (frame.mUsedQueries == frame.mQueries.size()) {
+    std::size_t const count = std::max<std::size_t>(64, frame.mQueries.size());
+    frame.mQueries.resize(frame.mQueries.size() + count);
+    glGenQueries(static_cast<GLsizei>(count), &frame.mQueries[frame.mUsedQueries]);
+  }
+
+  GLuint query = frame.mQueries[frame.mUsedQueries++];
+  glQueryCounter(query, GL_TIMESTAMP);
+  return query;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The buffer of the calling thread. This is a plain pointer so that accessing it is as cheap as
+// possible, the ThreadState below takes care of marking the buffer as retired once the thread
+// exits.
+thread_local ThreadBuffer* tBuffer CS_TRACE_TLS_MODEL = nullptr;
+
+// Set by endFrame().
+thread_local bool tIsRenderThread = false;
+
+struct ThreadState {
+  ThreadState() = default;
+
+  ThreadState(ThreadState const& other) = delete;
+  ThreadState(ThreadState&& other)      = delete;
+
+  ThreadState& operator=(ThreadState const& other) = delete;
+  ThreadState& operator=(ThreadState&& other) = delete;
+
+  ~ThreadState() {
+    if (mBuffer) {
+      mBuffer->mRetired = true;
+    }
+  }
+
+  std::shared_ptr<ThreadBuffer> mBuffer;
+};
+
+thread_local ThreadState tState;
+
+ThreadBuffer* createBuffer() {
+  auto& r = registry();
+
+  std::lock_guard<std::mutex> lock(r.mMutex);
+
+  // Drop the oldest buffers of exited threads.
+  std::size_t retired = std::count_if(
+      r.mBuffers.begin(), r.mBuffers.end(), [](auto const& b) { return b->mRetired.load(); });
+
+  for (auto it = r.mBuffers.begin(); it != r.mBuffers.end() && retired > cMaxRetiredBuffers;) {
+    if ((*it)->mRetired) {
+      it = r.mBuffers.erase(it);
+      --retired;
+    } else {
+      ++it;
+    }
+  }
+
+  tState.mBuffer = std::make_shared<ThreadBuffer>(r.mNextTrack++, r.mBufferSize);
+  r.mBuffers.push_back(tState.mBuffer);
+  tBuffer = tState.mBuffer.get();
+
+  return tBuffer;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Copies all zones of the given buffer which have not been overwritten or cleared.
+std::vector<Event> readEvents(ThreadBuffer const& buffer) {
+  uint64_t const capacity = buffer.mMask + 1;
+  uint64_t const written  = buffer.mWritten.load(std::memory_order_acquire);
+  uint64_t const first =
+      std::max(written > capacity ? written - capacity : 0, buffer.mClearedUntil.load());
+
+  std::vector<Event> events;
+  events.reserve(written > first ? written - first : 0);
+
+  for (uint64_t i = first; i < written; ++i) {
+    Slot const& slot = buffer.mSlots[i & buffer.mMask];
+    events.push_back({slot.mName.load(std::memory_order_relaxed),
+        slot.mStart.load(std::memory_order_relaxed), slot.mEnd.load(std::memory_order_relaxed),
+        slot.mId.load(std::memory_order_relaxed), slot.mParent.load(std::memory_order_relaxed)});
+  }
+
+  // All slots which have been claimed since may contain a mixture of old and new values.
+  std::atomic_thread_fence(std::memory_order_acquire);
+  uint64_t const claimed = buffer.mClaimed.load(std::memory_order_relaxed);
+  uint64_t const valid   = claimed > capacity ? claimed - capacity : 0;
+
+  if (valid > first) {
+    auto const invalid = std::min<uint64_t>(valid - first, events.size());
+    events.erase(events.begin(), events.begin() + static_cast<std::ptrdiff_t>(invalid));
+  }
+
+  return events;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void appendEscaped(std::string& json, char const* text) {
+  json += '"';
+
+  for (char const* c = text; *c != '\0'; ++c) {
+    if (*c == '"' || *c == '\\') {
+      json += '\\';
+      json += *c;
+    } else if (static_cast<unsigned char>(*c) < 0x20) {
+      fmt::format_to(std::back_inserter(json), "\\u{:04x}", static_cast<int>(*c));
+    } else {
+      json += *c;
+    }
+  }
+
+  json += '"';
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TraceRecorder::setEnabled(bool enable) {
+  // Make sure that the calibration starts as early as possible.
+  registry();
+  sEnabled = enable;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TraceRecorder::begin(char const* name, bool gpu) {
+  if (!isEnabled()) {
+    return false;
+  }
+
+  ThreadBuffer* buffer = tBuffer;
+
+  if (!buffer) {
+    buffer = createBuffer();
+  }
+
+  if (buffer->mDepth >= cMaxDepth) {
+    return false;
+  }
+
+  OpenZone& zone = buffer->mStack[buffer->mDepth];
+  zone.mName     = name;
+  zone.mId       = buffer->mNextId++;
+  zone.mParent   = buffer->mDepth > 0 ? buffer->mStack[buffer->mDepth - 1].mId : 0;
+  zone.mGPUZone  = -1;
+
+  if (gpu && tIsRenderThread) {
+    auto& frame   = gpuState().mFrames[gpuState().mCurrent];
+    zone.mGPUZone = static_cast<int32_t>(frame.mZones.size());
+    frame.mZones.push_back({name, 0, zone.mId, queryTimestamp(frame), 0});
+  }
+
+  ++buffer->mDepth;
+
+  // This is done last so that the overhead of this method is not part of the zone.
+  zone.mStart = now();
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TraceRecorder::end() {
+  uint64_t const endTicks = now();
+  ThreadBuffer*  buffer   = tBuffer;
+  OpenZone&      zone     = buffer->mStack[--buffer->mDepth];
+
+  if (zone.mGPUZone >= 0) {
+    // If the zone has been opened in a previous frame, its GPU zone cannot be closed anymore and
+    // will be dropped.
+    auto& zones = gpuState().mFrames[gpuState().mCurrent].mZones;
+    auto  index = static_cast<std::size_t>(zone.mGPUZone);
+
+    if (index < zones.size() && zones[index].mId == zone.mId && zones[index].mEndQuery == 0) {
+      zones[index].mCPUStart = zone.mStart;
+      zones[index].mEndQuery = queryTimestamp(gpuState().mFrames[gpuState().mCurrent]);
+    }
+  }
+
+  uint64_t const index = buffer->mWritten.load(std::memory_order_relaxed);
+  buffer->mClaimed.store(index + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  Slot& slot = buffer->mSlots[index & buffer->mMask];
+  slot.mName.store(zone.mName, std::memory_order_relaxed);
+  slot.mStart.store(zone.mStart, std::memory_order_relaxed);
+  slot.mEnd.store(endTicks, std::memory_order_relaxed);
+  slot.mId.store(zone.mId, std::memory_order_relaxed);
+  slot.mParent.store(zone.mParent, std::memory_order_relaxed);
+
+  buffer->mWritten.store(index + 1, std::memory_order_release);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+char const* TraceRecorder::intern(std::string const& name) {
+  auto& r = registry();
+
+  std::lock_guard<std::mutex> lock(r.mNamesMutex);
+  return r.mNames.insert(name).first->c_str();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TraceRecorder::setThreadName(std::string const& name) {
+  ThreadBuffer* buffer = tBuffer;
+
+  if (!buffer) {
+    buffer = createBuffer();
+  }
+
+  std::lock_guard<std::mutex> lock(registry().mMutex);
+  buffer->mName = name;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint64_t TraceRecorder::endFrame() {
+  uint64_t const ticks = now();
+  auto&          r     = registry();
+  auto&          gpu   = gpuState();
+
+  tIsRenderThread = true;
+
+  // The GPU zones of the frame recorded cGPUFrameCount - 1 frames ago should be available by now.
+  // If they are not, they are dropped in order to not stall the pipeline.
+  gpu.mCurrent   = (gpu.mCurrent + 1) % cGPUFrameCount;
+  GPUFrame& last = gpu.mFrames[gpu.mCurrent];
+
+  std::vector<GPUEvent> gpuEvents;
+
+  if (!last.mZones.empty()) {
+    GLint available = GL_FALSE;
+    glGetQueryObjectiv(last.mQueries[last.mUsedQueries - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+
+    if (available) {
+      // The GPU timestamps are converted to CPU ticks relative to the current time of both clocks.
+      // GL_TIMESTAMP returns the time at which all previous commands have reached the GPU, so the
+      // GPU zones may appear slightly too early.
+      GLint64 gpuNow = 0;
+      glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+      uint64_t const cpuNow       = now();
+      double const   ticksPerNano = 1.0 / r.mCalibration.getNanosPerTick();
+
+      auto toTicks = [&](GLuint query) {
+        GLuint64 timestamp = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &timestamp);
+        double offset = static_cast<double>(gpuNow - static_cast<GLint64>(timestamp));
+        return cpuNow - static_cast<uint64_t>(std::max(0.0, offset * ticksPerNano));
+      };
+
+      for (auto const& zone : last.mZones) {
+        if (zone.mEndQuery != 0) {
+          gpuEvents.push_back({zone.mName, toTicks(zone.mBeginQuery), toTicks(zone.mEndQuery),
+              zone.mCPUStart, tBuffer->mTrack, zone.mId});
+        }
+      }
+    }
+
+    last.mZones.clear();
+    last.mUsedQueries = 0;
+  }
+
+  std::lock_guard<std::mutex> lock(r.mMutex);
+
+  uint64_t const number = ++r.mFrameCount;
+
+  if (isEnabled()) {
+    r.mFrames.push_back({number, r.mLastFrameEnd, ticks});
+
+    if (r.mFrames.size() > cMaxFrames) {
+      r.mFrames.pop_front();
+    }
+  }
+
+  r.mLastFrameEnd = ticks;
+
+  r.mGPUEvents.insert(r.mGPUEvents.end(), gpuEvents.begin(), gpuEvents.end());
+
+  while (r.mGPUEvents.size() > cMaxGPUZones) {
+    r.mGPUEvents.pop_front();
+  }
+
+  return number;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint64_t TraceRecorder::getLastFrame() {
+  auto& r = registry();
+
+  std::lock_guard<std::mutex> lock(r.mMutex);
+  return r.mFrameCount;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint64_t TraceRecorder::getFirstFrame() {
+  auto& r = registry();
+
+  std::lock_guard<std::mutex> lock(r.mMutex);
+  return r.mFrames.empty() ? 0 : r.mFrames.front().mNumber;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string TraceRecorder::exportChromeTrace(uint64_t firstFrame, uint64_t lastFrame) {
+  auto& r = registry();
+
+  std::vector<Frame>                                                 frames;
+  std::vector<GPUEvent>                                              gpuEvents;
+  std::vector<std::pair<std::shared_ptr<ThreadBuffer>, std::string>> buffers;
+
+  {
+    std::lock_guard<std::mutex> lock(r.mMutex);
+
+    for (auto const& frame : r.mFrames) {
+      if (frame.mNumber >= firstFrame && frame.mNumber <= lastFrame) {
+        frames.push_back(frame);
+      }
+    }
+
+    if (!frames.empty()) {
+      for (auto const& event : r.mGPUEvents) {
+        if (event.mEnd >= frames.front().mStart && event.mStart <= frames.back().mEnd) {
+          gpuEvents.push_back(event);
+        }
+      }
+    }
+
+    for (auto const& buffer : r.mBuffers) {
+      buffers.emplace_back(buffer, buffer->mName);
+    }
+  }
+
+  std::string json = R"({"displayTimeUnit":"ms","traceEvents":[)";
+  bool        first = true;
+
+  auto separate = [&]() {
+    if (!first) {
+      json += ",\n";
+    }
+    first = false;
+  };
+
+  auto appendTrackName = [&](uint32_t track, char const* name) {
+    separate();
+    fmt::format_to(std::back_inserter(json),
+        R"({{"ph":"M","pid":1,"tid":{},"name":"thread_name","args":{{"name":)", track);
+    appendEscaped(json, name);
+    json += "}},\n";
+    fmt::format_to(std::back_inserter(json),
+        R"({{"ph":"M","pid":1,"tid":{0},"name":"thread_sort_index","args":{{"sort_index":{0}}}}})",
+        track);
+  };
+
+  if (!frames.empty()) {
+    uint64_t const start         = frames.front().mStart;
+    uint64_t const end           = frames.back().mEnd;
+    double const   microsPerTick = r.mCalibration.getNanosPerTick() / 1000.0;
+
+    // All timestamps are relative to the start of the first frame.
+    auto micros = [&](uint64_t ticks) {
+      return static_cast<double>(static_cast<int64_t>(ticks - start)) * microsPerTick;
+    };
+
+    auto appendZone = [&](uint32_t track, char const* category, char const* name, uint64_t begin,
+                          uint64_t finish) {
+      separate();
+      json += R"({"ph":"X","pid":1,)";
+      fmt::format_to(std::back_inserter(json), R"("tid":{},"cat":"{}","ts":{:.3f},"dur":{:.3f},)",
+          track, category, micros(begin), static_cast<double>(finish - begin) * microsPerTick);
+      json += R"("name":)";
+      appendEscaped(json, name);
+    };
+
+    appendTrackName(cFrameTrack, "Frames");
+
+    for (auto const& frame : frames) {
+      appendZone(cFrameTrack, "frame", ("Frame " + std::to_string(frame.mNumber)).c_str(),
+          frame.mStart, frame.mEnd);
+      json += "}";
+    }
+
+    for (auto const& [buffer, name] : buffers) {
+      auto events = readEvents(*buffer);
+
+      events.erase(std::remove_if(events.begin(), events.end(),
+                       [&](Event const& e) { return e.mEnd < start || e.mStart > end; }),
+          events.end());
+
+      if (events.empty()) {
+        continue;
+      }
+
+      appendTrackName(buffer->mTrack, name.c_str());
+
+      for (auto const& event : events) {
+        appendZone(buffer->mTrack, "cpu", event.mName, event.mStart, event.mEnd);
+        fmt::format_to(std::back_inserter(json), R"(,"args":{{"id":{},"parent":{}}}}})",
+            event.mId, event.mParent);
+      }
+    }
+
+    if (!gpuEvents.empty()) {
+      appendTrackName(cGPUTrack, "GPU");
+    }
+
+    // Each GPU zone is linked to its CPU zone by a flow event.
+    for (auto const& event : gpuEvents) {
+      uint64_t const flow = (static_cast<uint64_t>(event.mTrack) << 32U) | event.mId;
+
+      appendZone(cGPUTrack, "gpu", event.mName, event.mStart, event.mEnd);
+      fmt::format_to(std::back_inserter(json), R"(,"args":{{"id":{}}}}})", event.mId);
+
+      separate();
+      fmt::format_to(std::back_inserter(json),
+          R"({{"ph":"s","pid":1,"tid":{},"cat":"gpu","name":"GPU","id":{},"ts":{:.3f}}})",
+          event.mTrack, flow, micros(event.mCPUStart));
+
+      separate();
+      fmt::format_to(std::back_inserter(json),
+          R"({{"ph":"f","bp":"e","pid":1,"tid":{},"cat":"gpu","name":"GPU","id":{},"ts":{:.3f}}})",
+          cGPUTrack, flow, micros(event.mStart));
+    }
+  }
+
+  json += "]}\n";
+
+  return json;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TraceRecorder::save(std::string const& fileName, uint64_t firstFrame, uint64_t lastFrame) {
+  std::ofstream file(fileName, std::ios::binary);
+
+  if (!file) {
+    throw std::runtime_error("Failed to open file '" + fileName + "' for writing!");
+  }
+
+  file << exportChromeTrace(firstFrame, lastFrame);
+
+  if (!file) {
+    throw std::runtime_error("Failed to write trace to file '" + fileName + "'!");
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TraceRecorder::clear() {
+  auto& r = registry();
+
+  std::lock_guard<std::mutex> lock(r.mMutex);
+
+  for (auto const& buffer : r.mBuffers) {
+    buffer->mClearedUntil = buffer->mWritten.load();
+  }
+
+  r.mFrames.clear();
+  r.mGPUEvents.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TraceRecorder::setBufferSize(std::size_t zoneCount) {
+  std::size_t capacity = 16;
+
+  while (capacity < zoneCount) {
+    capacity *= 2;
+  }
+
+  auto& r = registry();
+
+  std::lock_guard<std::mutex> lock(r.mMutex);
+  r.mBufferSize = capacity;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::utils
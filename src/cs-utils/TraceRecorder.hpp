@@ -0,0 +1,136 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CS_UTILS_TRACE_RECORDER_HPP
+#define CS_UTILS_TRACE_RECORDER_HPP
+
+#include "cs_utils_export.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace cs::utils {
+
+/// The TraceRecorder records nested zones on all threads, so that they can be inspected with
+/// chrome://tracing or https://ui.perfetto.dev. While the FrameTimings only accumulate the time
+/// spent in each ScopedTimer on the main thread, the trace contains every single zone together
+/// with its parent zone and the thread it ran on.
+///
+/// Each thread writes its zones into a ring buffer of its own without any locking. Once this buffer
+/// is full, the oldest zones of the thread are overwritten. Zone names are never copied, they have
+/// to be string literals or strings returned by intern(). Zones on the thread which calls
+/// endFrame() can additionally record GPU timestamps. The GPU duration of these zones is shown on a
+/// separate track of the trace, linked to the CPU zone by an arrow.
+///
+/// Recording is disabled by default. All methods are thread-safe.
+class CS_UTILS_EXPORT TraceRecorder {
+ public:
+  /// A Zone records the time between its creation and its destruction. If recording is disabled
+  /// when the zone is created, nothing is recorded. For zones with a constant name, the
+  /// CS_TRACE_ZONE macro defined below is the easiest way to create one.
+  class Zone {
+   public:
+    /// The name has to stay valid until the application exits, see intern(). If gpu is true and the
+    /// zone is created on the render thread, GPU timestamps are recorded as well.
+    explicit Zone(char const* name, bool gpu = false) {
+      if (isEnabled()) {
+        mActive = begin(name, gpu);
+      }
+    }
+
+    Zone(Zone const& other) = delete;
+    Zone(Zone&& other)      = delete;
+
+    Zone& operator=(Zone const& other) = delete;
+    Zone& operator=(Zone&& other) = delete;
+
+    ~Zone() {
+      if (mActive) {
+        end();
+      }
+    }
+
+   private:
+    bool mActive = false;
+  };
+
+  TraceRecorder() = delete;
+
+  /// Enables or disables the recording globally. Zones which are open when recording gets disabled
+  /// are still recorded once they are closed.
+  static void setEnabled(bool enable);
+  static bool isEnabled() {
+    return sEnabled.load(std::memory_order_relaxed);
+  }
+
+  /// Opens a zone on the calling thread. Returns false if nothing is recorded because recording is
+  /// disabled or because the zones are nested too deeply. end() must only be called if this
+  /// returned true. Usually, you should use a Zone instead.
+  static bool begin(char const* name, bool gpu = false);
+
+  /// Closes the innermost open zone of the calling thread.
+  static void end();
+
+  /// Returns a copy of the given string which stays valid until the application exits. Equal
+  /// strings result in the same pointer. Use this for zone names which are not known at compile
+  /// time. This requires a lock, so the result should be stored if it is needed often.
+  static char const* intern(std::string const& name);
+
+  /// Sets the name of the calling thread's track in the exported trace. By default, threads are
+  /// called "Thread 1", "Thread 2" and so on.
+  static void setThreadName(std::string const& name);
+
+  /// Marks the end of the current frame and returns its number. The first frame has the number
+  /// one. This has to be called once per frame by the render thread; the FrameTimings do this in
+  /// their update(). Available GPU timestamps of previous frames are collected here as well.
+  static uint64_t endFrame();
+
+  /// Returns the number of the most recently completed frame. This is zero before the first call to
+  /// endFrame().
+  static uint64_t getLastFrame();
+
+  /// Returns the number of the oldest frame which is still available for export. Frames are only
+  /// recorded while recording is enabled. This is zero if no frame has been recorded.
+  static uint64_t getFirstFrame();
+
+  /// Returns all zones which overlap the given range of recorded frames as a JSON string in the
+  /// Chrome trace event format. Zones of threads which have recorded many zones since may be
+  /// missing, as they have been overwritten already. Zones which are still open are not included.
+  static std::string exportChromeTrace(uint64_t firstFrame, uint64_t lastFrame);
+
+  /// Writes the result of exportChromeTrace() to the given file. Throws a std::runtime_error if the
+  /// file cannot be written.
+  static void save(std::string const& fileName, uint64_t firstFrame, uint64_t lastFrame);
+
+  /// Drops all recorded zones and frames. Zones which are currently open are still recorded once
+  /// they are closed.
+  static void clear();
+
+  /// The number of zones each thread can store before the oldest are overwritten. This is rounded
+  /// up to the next power of two and only affects threads which record their first zone afterwards.
+  /// The default is 32768.
+  static void setBufferSize(std::size_t zoneCount);
+
+ private:
+  static std::atomic<bool> sEnabled;
+};
+
+} // namespace cs::utils
+
+/// Records a zone with the given name until the end of the enclosing scope. The name has to be a
+/// string literal.
+#define CS_TRACE_ZONE(name) CS_TRACE_ZONE_IMPL(name, false, __LINE__)
+
+/// Like CS_TRACE_ZONE, but also records GPU timestamps if used on the render thread.
+#define CS_TRACE_GPU_ZONE(name) CS_TRACE_ZONE_IMPL(name, true, __LINE__)
+
+#define CS_TRACE_ZONE_IMPL(name, gpu, line) CS_TRACE_ZONE_IMPL2(name, gpu, line)
+#define CS_TRACE_ZONE_IMPL2(name, gpu, line)                                                       \
+  cs::utils::TraceRecorder::Zone csTraceZone##line("" name, gpu)
+
+#endif // CS_UTILS_TRACE_RECORDER_HPP
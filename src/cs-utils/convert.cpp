@@ -7,10 +7,12 @@
 #include "convert.hpp"
 
 #include "logger.hpp"
+#include "utils.hpp"
 
 #include <cmath>
 #include <cspice/SpiceUsr.h>
 #include <glm/gtc/type_ptr.hpp>
+#include <mutex>
 
 namespace cs::utils::convert {
 
@@ -177,7 +179,10 @@ double toSpice(boost::posix_time::ptime const& tIn) {
 
   // Incorporate delta between ET and UTC.
   double ETUTCDelta = 0.0;
-  deltet_c(dTime, "UTC", &ETUTCDelta);
+  {
+    std::lock_guard lock(getSpiceMutex());
+    deltet_c(dTime, "UTC", &ETUTCDelta);
+  }
 
   return dTime + ETUTCDelta;
 }
@@ -231,7 +236,10 @@ boost::posix_time::ptime toPosix(double tIn) {
 
   // Incorporate delta between ET and UTC.
   double ETUTCDelta = 0.0;
-  deltet_c(tIn, "ET", &ETUTCDelta);
+  {
+    std::lock_guard lock(getSpiceMutex());
+    deltet_c(tIn, "ET", &ETUTCDelta);
+  }
 
   return boost::posix_time::ptime(boost::gregorian::date(startYear, 1, 1),
       boost::posix_time::hours(noon) + boost::posix_time::milliseconds(static_cast<int64_t>(
@@ -117,6 +117,24 @@ float getCurrentFarClipDistance() {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+std::recursive_mutex& getSpiceMutex() {
+  static std::recursive_mutex mutex;
+  return mutex;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Fnv1aHash::add(void const* data, std::size_t size) {
+  auto const* bytes = static_cast<uint8_t const*>(data);
+
+  for (std::size_t i = 0; i < size; ++i) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    mHash = (mHash ^ bytes[i]) * 0x100000001b3U;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 #ifdef __linux__
 #define CS_POPEN popen
 #define CS_CLOSE pclose
@@ -10,8 +10,10 @@
 #include "cs_utils_export.hpp"
 
 #include <algorithm>
+#include <cstdint>
 #include <limits>
 #include <map>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <type_traits>
@@ -115,6 +117,35 @@ constexpr typename std::underlying_type<T>::type enumCast(T val) {
 /// Well, does what is says.
 float CS_UTILS_EXPORT getCurrentFarClipDistance();
 
+/// CSPICE is not re-entrant. Whenever SPICE functions are called, this mutex has to be locked, as
+/// other threads (for example the worker of the cs::core::EphemerisService) may use SPICE at the
+/// same time. It is recursive so that code which already holds it can call other functions which
+/// lock it as well.
+CS_UTILS_EXPORT std::recursive_mutex& getSpiceMutex();
+
+/// Computes the 64 bit FNV-1a hash of a sequence of bytes. This is not a cryptographic hash, but it
+/// is fast and does not depend on the standard library implementation, so it can be used to derive
+/// the names of cache files from their content.
+class CS_UTILS_EXPORT Fnv1aHash {
+ public:
+  /// Adds the given bytes to the hash.
+  void add(void const* data, std::size_t size);
+
+  /// Adds the object representation of the given value to the hash.
+  template <typename T>
+  void add(T const& value) {
+    static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be hashed!");
+    add(&value, sizeof(T));
+  }
+
+  uint64_t get() const {
+    return mHash;
+  }
+
+ private:
+  uint64_t mHash = 0xcbf29ce484222325U;
+};
+
 /// Executes a system command and returns the output.
 std::string exec(std::string const& cmd);
 
@@ -0,0 +1,130 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CS_TEST_SYNTHETIC_KERNEL_HPP
+#define CS_TEST_SYNTHETIC_KERNEL_HPP
+
+#include "../src/cs-utils/doctest.hpp"
+#include "../src/cs-utils/utils.hpp"
+
+#include <array>
+#include <cmath>
+#include <cspice/SpiceUsr.h>
+#include <cstdio>
+#include <glm/glm.hpp>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace cs::test {
+
+/// Returns the state (in km and km/s) of a test body at the given time. It is on an inclined orbit
+/// around the Earth with a period of about 1.6 hours. With a non-zero eccentricity, the segments of
+/// an ephemeris have to be split close to the periapsis.
+inline std::array<double, 6> getSyntheticState(double tTime, double eccentricity) {
+  double const semiMajorAxis = 7000.0;
+  double const inclination   = 0.5;
+  double const mu            = 398600.4418;
+
+  double meanMotion  = std::sqrt(mu / (semiMajorAxis * semiMajorAxis * semiMajorAxis));
+  double meanAnomaly = meanMotion * tTime;
+  double eccAnomaly  = meanAnomaly;
+
+  for (int i = 0; i < 20; ++i) {
+    eccAnomaly -= (eccAnomaly - eccentricity * std::sin(eccAnomaly) - meanAnomaly) /
+                  (1.0 - eccentricity * std::cos(eccAnomaly));
+  }
+
+  double semiMinorAxis = semiMajorAxis * std::sqrt(1.0 - eccentricity * eccentricity);
+  double eccAnomalyDot = meanMotion / (1.0 - eccentricity * std::cos(eccAnomaly));
+
+  double x  = semiMajorAxis * (std::cos(eccAnomaly) - eccentricity);
+  double y  = semiMinorAxis * std::sin(eccAnomaly);
+  double vx = -semiMajorAxis * std::sin(eccAnomaly) * eccAnomalyDot;
+  double vy = semiMinorAxis * std::cos(eccAnomaly) * eccAnomalyDot;
+
+  return {x, y * std::cos(inclination), y * std::sin(inclination), vx,
+      vy * std::cos(inclination), vy * std::sin(inclination)};
+}
+
+/// Computes the state of the given body relative to the Earth with a direct call to SPICE. The
+/// results are in meters and meters per second and use the same axis convention as the
+/// CelestialAnchor. Returns false if SPICE has no data for the given time.
+inline bool getSyntheticReference(
+    char const* bodyName, double tTime, glm::dvec3& position, glm::dvec3& velocity) {
+  std::array<double, 6> state{};
+  double                timeOfLight{};
+
+  std::lock_guard lock(utils::getSpiceMutex());
+  spkezr_c(bodyName, tTime, "J2000", "NONE", "EARTH", state.data(), &timeOfLight);
+
+  bool valid = !failed_c();
+  position   = glm::dvec3(state[1], state[2], state[0]) * 1000.0;
+  velocity   = glm::dvec3(state[4], state[5], state[3]) * 1000.0;
+  reset_c();
+
+  return valid;
+}
+
+/// Writes an SPK file with the orbit of a test body as given by getSyntheticState() and loads it.
+/// The orbit is around the Earth unless another center is given. The kernel is unloaded and deleted
+/// again when this object is destroyed.
+class SyntheticKernel {
+ public:
+  SyntheticKernel(char const* fileName, int bodyId, double coverageStart, double coverageEnd,
+      double eccentricity, int centerId = 399)
+      : mFileName(fileName) {
+    std::lock_guard lock(utils::getSpiceMutex());
+
+    std::string actionReturn = "RETURN";
+    erract_c("SET", 0, actionReturn.data());
+
+    std::string actionNull = "NULL";
+    errdev_c("SET", 0, actionNull.data());
+
+    double const step = 60.0;
+    auto         size = static_cast<int>((coverageEnd - coverageStart) / step) + 1;
+
+    std::vector<std::array<double, 6>> states(size);
+    for (int i = 0; i < size; ++i) {
+      states[i] = getSyntheticState(coverageStart + i * step, eccentricity);
+    }
+
+    std::remove(mFileName.c_str());
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast, modernize-avoid-c-arrays)
+    auto const* data = reinterpret_cast<double const(*)[6]>(states.data());
+
+    SpiceInt handle{};
+    spkopn_c(mFileName.c_str(), "synthetic test kernel", 0, &handle);
+    spkw08_c(handle, bodyId, centerId, "J2000", coverageStart, coverageEnd, "synthetic orbit", 7,
+        size, data, coverageStart, step);
+    spkcls_c(handle);
+    furnsh_c(mFileName.c_str());
+
+    REQUIRE_FALSE(failed_c());
+  }
+
+  SyntheticKernel(SyntheticKernel const& other) = delete;
+  SyntheticKernel(SyntheticKernel&& other)      = delete;
+
+  SyntheticKernel& operator=(SyntheticKernel const& other) = delete;
+  SyntheticKernel& operator=(SyntheticKernel&& other) = delete;
+
+  ~SyntheticKernel() {
+    std::lock_guard lock(utils::getSpiceMutex());
+    unload_c(mFileName.c_str());
+    reset_c();
+    std::remove(mFileName.c_str());
+  }
+
+ private:
+  std::string mFileName;
+};
+
+} // namespace cs::test
+
+#endif // CS_TEST_SYNTHETIC_KERNEL_HPP
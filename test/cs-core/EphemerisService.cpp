@@ -0,0 +1,236 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "../../src/cs-core/EphemerisService.hpp"
+#include "../../src/cs-core/logger.hpp"
+#include "../../src/cs-utils/doctest.hpp"
+#include "../SyntheticKernel.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace cs::core {
+
+namespace {
+
+// The SPK file which is written by the tests.
+char const* const KERNEL_FILE = "./testEphemerisService.bsp";
+
+// The synthetic kernel contains a circular orbit of this body around the Earth.
+char const* const BODY_NAME = "-998";
+int const         BODY_ID   = -998;
+
+// The time interval covered by the synthetic kernel.
+double const COVERAGE_START = 0.0;
+double const COVERAGE_END   = 86400.0;
+
+// Writes and loads the synthetic kernel, see test/SyntheticKernel.hpp.
+class SyntheticKernel : public test::SyntheticKernel {
+ public:
+  SyntheticKernel()
+      : test::SyntheticKernel(KERNEL_FILE, BODY_ID, COVERAGE_START, COVERAGE_END, 0.0) {
+  }
+};
+
+// Computes the state of the test body relative to the Earth with a direct call to SPICE. This is
+// what the EphemerisService should return.
+EphemerisService::State getReference(double tTime) {
+  EphemerisService::State result;
+  result.mValid = test::getSyntheticReference(BODY_NAME, tTime, result.mPosition, result.mVelocity);
+  return result;
+}
+
+// Waits until the prefetched state for the given time becomes available. Returns false if this
+// does not happen within a few seconds.
+bool waitForPrefetch(
+    EphemerisService const& service, uint64_t id, double tTime, EphemerisService::State& state) {
+  for (int i = 0; i < 1000; ++i) {
+    if (service.getPrefetchedState(id, tTime, state)) {
+      return true;
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+
+  return false;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("cs::core::EphemerisService") {
+  SyntheticKernel  kernel;
+  EphemerisService service;
+
+  SUBCASE("Batched queries return the same states as SPICE") {
+    std::vector<EphemerisService::Query> queries;
+    for (int i = 0; i < 100; ++i) {
+      queries.push_back({BODY_NAME, "EARTH", "J2000", 500.0 + i * 700.0});
+    }
+
+    // There is no data for this query.
+    queries.push_back({BODY_NAME, "EARTH", "J2000", COVERAGE_END + 1000.0});
+
+    auto states = service.query(queries).get();
+
+    REQUIRE_EQ(states.size(), queries.size());
+
+    for (int i = 0; i < 100; ++i) {
+      auto reference = getReference(queries[i].mTime);
+
+      CHECK(states[i].mValid);
+      CHECK_EQ(states[i].mPosition, reference.mPosition);
+      CHECK_EQ(states[i].mVelocity, reference.mVelocity);
+    }
+
+    CHECK_FALSE(states.back().mValid);
+  }
+
+  SUBCASE("SPICE can be used by other threads while requests are processed") {
+    std::vector<std::future<std::vector<EphemerisService::State>>> futures;
+
+    for (int i = 0; i < 20; ++i) {
+      std::vector<EphemerisService::Query> queries;
+      for (int j = 0; j < 100; ++j) {
+        queries.push_back({BODY_NAME, "EARTH", "J2000", 1000.0 + i * 100.0 + j});
+      }
+      futures.push_back(service.query(queries));
+    }
+
+    // The references are computed on this thread while the worker is busy.
+    for (int i = 0; i < 20; ++i) {
+      auto states = futures[i].get();
+
+      for (int j = 0; j < 100; ++j) {
+        auto reference = getReference(1000.0 + i * 100.0 + j);
+
+        CHECK(states[j].mValid);
+        CHECK_EQ(states[j].mPosition, reference.mPosition);
+      }
+    }
+  }
+
+  SUBCASE("States of upcoming frames are prefetched") {
+    auto id = service.addPrefetch(BODY_NAME, "EARTH", "J2000");
+
+    // Ten seconds of simulation time pass in each frame.
+    double const timeSpeed = 600.0;
+    double const frameTime = 1.0 / 60.0;
+    double const step      = timeSpeed * frameTime;
+
+    EphemerisService::State state;
+
+    double tTime    = 1000.0;
+    double maxError = 0.0;
+
+    for (int frame = 0; frame < 200; ++frame) {
+      service.update(tTime, timeSpeed, frameTime);
+
+      // In the application, the prefetches would usually be ready in time. Here, frames are much
+      // shorter, so we have to wait.
+      REQUIRE(waitForPrefetch(service, id, tTime + 0.5 * step, state));
+
+      // States in between two frames are interpolated as well.
+      for (double offset : {0.0, 0.3, 0.5}) {
+        REQUIRE(service.getPrefetchedState(id, tTime + offset * step, state));
+
+        auto reference = getReference(tTime + offset * step);
+        maxError       = std::max(maxError, glm::length(state.mPosition - reference.mPosition));
+      }
+
+      tTime += step;
+    }
+
+    // The orbit has a radius of 7000 km, the interpolation is accurate to a few millimeters.
+    CHECK_LT(maxError, 0.01);
+
+    // There are no prefetched states for the distant past or unknown ids.
+    CHECK_FALSE(service.getPrefetchedState(id, 0.0, state));
+    CHECK_FALSE(service.getPrefetchedState(id + 1, tTime, state));
+  }
+
+  SUBCASE("A single state is prefetched if the time is paused") {
+    auto id = service.addPrefetch(BODY_NAME, "EARTH", "J2000");
+
+    EphemerisService::State state;
+    service.update(2000.0, 0.0, 1.0 / 60.0);
+
+    REQUIRE(waitForPrefetch(service, id, 2000.0, state));
+    CHECK_EQ(state.mPosition, getReference(2000.0).mPosition);
+    CHECK_FALSE(service.getPrefetchedState(id, 2000.5, state));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("[benchmark] cs::core::EphemerisService") {
+  SyntheticKernel  kernel;
+  EphemerisService service;
+
+  // Many objects whose positions are required in each frame.
+  int const    objects   = 200;
+  int const    frames    = 200;
+  double const timeSpeed = 60.0;
+  double const frameTime = 1.0 / 60.0;
+
+  std::vector<uint64_t> ids;
+  for (int i = 0; i < objects; ++i) {
+    ids.push_back(service.addPrefetch(BODY_NAME, "EARTH", "J2000"));
+  }
+
+  // This is what happens if each object calls SPICE on the main thread.
+  double checksum = 0.0;
+  double tTime    = 1000.0;
+
+  auto start = std::chrono::high_resolution_clock::now();
+
+  for (int frame = 0; frame < frames; ++frame) {
+    for (int i = 0; i < objects; ++i) {
+      checksum += getReference(tTime).mPosition.x;
+    }
+    tTime += timeSpeed * frameTime;
+  }
+
+  auto middle = std::chrono::high_resolution_clock::now();
+
+  // Now the states are prefetched. Only the time spent on the main thread is measured, frames in
+  // which the prefetched states are not ready yet are counted.
+  std::chrono::duration<double, std::milli> mainThread(0.0);
+  int                                       misses = 0;
+
+  tTime = 1000.0;
+
+  for (int frame = 0; frame < frames; ++frame) {
+    auto frameStart = std::chrono::high_resolution_clock::now();
+
+    service.update(tTime, timeSpeed, frameTime);
+
+    EphemerisService::State state;
+    for (auto id : ids) {
+      if (service.getPrefetchedState(id, tTime, state)) {
+        checksum += state.mPosition.x;
+      } else {
+        ++misses;
+      }
+    }
+
+    mainThread += std::chrono::high_resolution_clock::now() - frameStart;
+
+    // Simulate the remaining work of a frame.
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    tTime += timeSpeed * frameTime;
+  }
+
+  logger().info("Evaluated {} objects for {} frames: {:.1f} ms with direct SPICE calls, {:.1f} ms "
+                "on the main thread with prefetching ({} misses, checksum {}).",
+      objects, frames, std::chrono::duration<double, std::milli>(middle - start).count(),
+      mainThread.count(), misses, checksum);
+}
+
+} // namespace cs::core
@@ -0,0 +1,158 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "../../src/cs-graphics/AsyncTextureLoader.hpp"
+#include "../../src/cs-graphics/logger.hpp"
+#include "../../src/cs-utils/TestImageCompare.hpp"
+#include "../../src/cs-utils/doctest.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace cs::graphics {
+
+namespace {
+
+// Writes a binary PPM file which can be decoded by stb_image. The color of each pixel is derived
+// from its position.
+void writeTestImage(std::string const& fileName, uint32_t width, uint32_t height) {
+  std::ofstream file(fileName, std::ios::binary);
+  file << "P6\n" << width << " " << height << "\n255\n";
+
+  std::vector<char> row(static_cast<std::size_t>(width) * 3);
+
+  for (uint32_t y = 0; y < height; ++y) {
+    for (uint32_t x = 0; x < width; ++x) {
+      row[x * 3 + 0] = static_cast<char>(x % 256);
+      row[x * 3 + 1] = static_cast<char>(y % 256);
+      row[x * 3 + 2] = static_cast<char>((x + y) % 256);
+    }
+    file.write(row.data(), static_cast<std::streamsize>(row.size()));
+  }
+}
+
+double millisecondsSince(std::chrono::high_resolution_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+      std::chrono::high_resolution_clock::now() - start)
+      .count();
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("cs::graphics::TextureLoader::decodeFile") {
+  std::string fileName = "test-texture-loader.ppm";
+  writeTestImage(fileName, 300, 200);
+
+  TextureLoader::Image image;
+
+  SUBCASE("Images are decoded to RGBA with the first row at the top") {
+    REQUIRE(TextureLoader::decodeFile(fileName, image));
+    CHECK(image.mWidth == 300);
+    CHECK(image.mHeight == 200);
+    CHECK(image.mChannels == 4);
+    REQUIRE(image.mPixels.size() == 300 * 200 * 4);
+
+    std::size_t pixel = (10 * 300 + 20) * 4;
+    CHECK(image.mPixels[pixel + 0] == 20);
+    CHECK(image.mPixels[pixel + 1] == 10);
+    CHECK(image.mPixels[pixel + 2] == 30);
+    CHECK(image.mPixels[pixel + 3] == 255);
+  }
+
+  SUBCASE("The memory of the image is reused") {
+    REQUIRE(TextureLoader::decodeFile(fileName, image));
+    uint8_t const* pixels = image.mPixels.data();
+
+    REQUIRE(TextureLoader::decodeFile(fileName, image));
+    CHECK(image.mPixels.data() == pixels);
+  }
+
+  SUBCASE("Missing files and TGA files cannot be decoded") {
+    CHECK_FALSE(TextureLoader::decodeFile("does-not-exist.png", image));
+    CHECK_FALSE(TextureLoader::decodeFile("does-not-exist.tga", image));
+  }
+
+  std::remove(fileName.c_str());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The textures are loaded like plugins would load them during initialization. With the
+// TextureLoader, the initialization blocks until all textures have been decoded and uploaded. With
+// the AsyncTextureLoader it returns immediately; the time until all textures have been uploaded is
+// measured as well.
+#ifdef __linux__
+TEST_CASE("[graphical][benchmark] cs::graphics::AsyncTextureLoader") {
+  utils::TestImageCompare imageCompare("async-texture-loader", 1);
+
+  const std::size_t textureCount = 8;
+  const uint32_t    textureSize  = 4096;
+
+  std::vector<std::string> fileNames;
+
+  for (std::size_t i = 0; i < textureCount; ++i) {
+    fileNames.push_back("test-async-texture-loader-" + std::to_string(i) + ".ppm");
+    writeTestImage(fileNames.back(), textureSize, textureSize);
+  }
+
+  {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::vector<std::unique_ptr<VistaTexture>> textures;
+    for (auto const& fileName : fileNames) {
+      textures.push_back(TextureLoader::loadFromFile(fileName));
+      CHECK(textures.back());
+    }
+
+    logger().info("Loading {} textures of {}x{} pixels synchronously took {:.1f} ms.",
+        textureCount, textureSize, textureSize, millisecondsSince(start));
+  }
+
+  {
+    AsyncTextureLoader loader;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::vector<std::shared_ptr<AsyncTextureLoader::Texture const>> textures;
+    for (auto const& fileName : fileNames) {
+      textures.push_back(loader.loadFromFile(fileName));
+    }
+
+    double      initTime = millisecondsSince(start);
+    std::size_t frames   = 0;
+
+    while (loader.getPendingCount() > 0) {
+      loader.update();
+      ++frames;
+    }
+
+    double totalTime = millisecondsSince(start);
+
+    for (auto const& texture : textures) {
+      CHECK(texture->isReady());
+      CHECK_FALSE(texture->hasFailed());
+    }
+
+    logger().info("Loading {} textures of {}x{} pixels asynchronously took {:.1f} ms, they were "
+                  "uploaded after {:.1f} ms in {} updates.",
+        textureCount, textureSize, textureSize, initTime, totalTime, frames);
+  }
+
+  for (auto const& fileName : fileNames) {
+    std::remove(fileName.c_str());
+  }
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::graphics
@@ -0,0 +1,218 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "../../src/cs-graphics/TextureCompressor.hpp"
+#include "../../src/cs-utils/doctest.hpp"
+
+#include <boost/filesystem.hpp>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <string>
+
+namespace cs::graphics {
+
+namespace {
+
+TextureLoader::Image createImage(uint32_t width, uint32_t height, uint32_t channels,
+    std::function<uint8_t(uint32_t, uint32_t, uint32_t)> const& texel) {
+  TextureLoader::Image image;
+  image.mWidth    = width;
+  image.mHeight   = height;
+  image.mChannels = channels;
+
+  for (uint32_t y = 0; y < height; ++y) {
+    for (uint32_t x = 0; x < width; ++x) {
+      for (uint32_t c = 0; c < channels; ++c) {
+        image.mPixels.push_back(texel(x, y, c));
+      }
+    }
+  }
+
+  return image;
+}
+
+// Returns the root mean square error of the given channel. The decompressed image always has four
+// channels.
+double getError(
+    TextureLoader::Image const& original, TextureLoader::Image const& decompressed, uint32_t c) {
+  double sum = 0.0;
+
+  for (std::size_t i = 0; i < static_cast<std::size_t>(original.mWidth) * original.mHeight; ++i) {
+    double d = original.mPixels[i * original.mChannels + c] - decompressed.mPixels[i * 4 + c];
+    sum += d * d;
+  }
+
+  return std::sqrt(sum / (original.mWidth * original.mHeight));
+}
+
+// A smooth color gradient with some variation, similar to a planetary surface texture.
+uint8_t gradient(uint32_t x, uint32_t y, uint32_t c) {
+  double value = 128.0 + 100.0 * std::sin(x * 0.02 + c) * std::cos(y * 0.03 - c);
+  return static_cast<uint8_t>(value);
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("cs::graphics::TextureCompressor::compress") {
+
+  SUBCASE("The format depends on the channels and the transparency of the image") {
+    auto opaque = [](uint32_t /*x*/, uint32_t /*y*/, uint32_t c) {
+      return static_cast<uint8_t>(c == 3 ? 255 : 100);
+    };
+    auto transparent = [](uint32_t x, uint32_t /*y*/, uint32_t c) {
+      return static_cast<uint8_t>(c == 3 && x == 2 ? 254 : 100);
+    };
+
+    CHECK(TextureCompressor::compress(createImage(8, 8, 1, opaque)).format() ==
+          gli::FORMAT_R_ATI1N_UNORM_BLOCK8);
+    CHECK(TextureCompressor::compress(createImage(8, 8, 2, opaque)).format() ==
+          gli::FORMAT_RG_ATI2N_UNORM_BLOCK16);
+    CHECK(TextureCompressor::compress(createImage(8, 8, 3, opaque)).format() ==
+          gli::FORMAT_RGB_DXT1_UNORM_BLOCK8);
+    CHECK(TextureCompressor::compress(createImage(8, 8, 4, opaque)).format() ==
+          gli::FORMAT_RGB_DXT1_UNORM_BLOCK8);
+    CHECK(TextureCompressor::compress(createImage(8, 8, 4, transparent)).format() ==
+          gli::FORMAT_RGBA_DXT5_UNORM_BLOCK16);
+  }
+
+  SUBCASE("All mipmaps are created, also for sizes which are no multiples of the block size") {
+    auto texture = TextureCompressor::compress(createImage(300, 10, 3, gradient));
+    CHECK(texture.levels() == 9);
+    CHECK(texture.extent(0).x == 300);
+    CHECK(texture.extent(0).y == 10);
+    CHECK(texture.extent(8).x == 1);
+    CHECK(texture.extent(8).y == 1);
+
+    // 75 x 3 blocks of 8 bytes each.
+    CHECK(texture.size(0) == 75 * 3 * 8);
+  }
+
+  SUBCASE("Uniform blocks are encoded exactly") {
+    auto red = [](uint32_t /*x*/, uint32_t /*y*/, uint32_t c) {
+      return static_cast<uint8_t>(c == 0 ? 255 : 0);
+    };
+    auto gray = [](uint32_t /*x*/, uint32_t /*y*/, uint32_t /*c*/) {
+      return static_cast<uint8_t>(77);
+    };
+
+    auto rgb = TextureCompressor::decompress(
+        TextureCompressor::compress(createImage(8, 8, 3, red)));
+    CHECK(rgb.mPixels[0] == 255);
+    CHECK(rgb.mPixels[1] == 0);
+    CHECK(rgb.mPixels[2] == 0);
+    CHECK(rgb.mPixels[3] == 255);
+
+    auto r = TextureCompressor::decompress(TextureCompressor::compress(createImage(8, 8, 1, gray)));
+    CHECK(r.mPixels[0] == 77);
+    CHECK(r.mPixels[1] == 0);
+    CHECK(r.mPixels[2] == 0);
+    CHECK(r.mPixels[3] == 255);
+  }
+
+  SUBCASE("Smooth images are encoded with a small error") {
+    for (uint32_t channels = 1; channels <= 4; ++channels) {
+      auto image        = createImage(256, 128, channels, gradient);
+      auto decompressed = TextureCompressor::decompress(TextureCompressor::compress(image));
+
+      REQUIRE(decompressed.mWidth == 256);
+      REQUIRE(decompressed.mHeight == 128);
+
+      // BC4 and BC5 store each channel with eight interpolated values per block, BC1 and BC3 share
+      // four values for all color channels.
+      double maxError = channels < 3 ? 1.0 : 4.0;
+
+      for (uint32_t c = 0; c < channels; ++c) {
+        CHECK(getError(image, decompressed, c) < maxError);
+      }
+    }
+  }
+
+  SUBCASE("Mipmaps are averaged") {
+    auto checkerboard = [](uint32_t x, uint32_t y, uint32_t /*c*/) {
+      return static_cast<uint8_t>((x + y) % 2 == 0 ? 255 : 0);
+    };
+
+    auto texture = TextureCompressor::compress(createImage(16, 16, 1, checkerboard));
+
+    for (std::size_t level = 1; level < texture.levels(); ++level) {
+      auto decompressed = TextureCompressor::decompress(texture, level);
+      CHECK(decompressed.mPixels[0] == 128);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("cs::graphics::TextureCompressor::getCacheFileName") {
+  std::string fileName = "test-texture-compressor.bin";
+
+  auto write = [&fileName](std::string const& content) {
+    std::ofstream file(fileName, std::ios::binary);
+    file << content;
+  };
+
+  write("Some content.");
+  auto first = TextureCompressor::getCacheFileName(fileName);
+
+  write("Some content.");
+  CHECK(TextureCompressor::getCacheFileName(fileName) == first);
+
+  write("Some other content.");
+  CHECK(TextureCompressor::getCacheFileName(fileName) != first);
+
+  std::remove(fileName.c_str());
+  CHECK(TextureCompressor::getCacheFileName(fileName).empty());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("cs::graphics::TextureCompressor::loadCached") {
+  std::string fileName       = "test-texture-compressor.ppm";
+  std::string cacheDirectory = "test-texture-cache";
+
+  // A binary PPM file which can be decoded by stb_image.
+  {
+    std::ofstream file(fileName, std::ios::binary);
+    file << "P6\n64 32\n255\n";
+    for (uint32_t y = 0; y < 32; ++y) {
+      for (uint32_t x = 0; x < 64; ++x) {
+        for (uint32_t c = 0; c < 3; ++c) {
+          file.put(static_cast<char>(gradient(x, y, c)));
+        }
+      }
+    }
+  }
+
+  auto cacheFile = cacheDirectory + "/" + TextureCompressor::getCacheFileName(fileName);
+
+  auto compressed = TextureCompressor::loadCached(fileName, cacheDirectory);
+  REQUIRE_FALSE(compressed.empty());
+  CHECK(compressed.format() == gli::FORMAT_RGB_DXT1_UNORM_BLOCK8);
+  CHECK(boost::filesystem::exists(cacheFile));
+
+  auto cached = TextureCompressor::loadCached(fileName, cacheDirectory);
+  REQUIRE(cached.levels() == compressed.levels());
+  CHECK(std::memcmp(cached.data(0, 0, 0), compressed.data(0, 0, 0), compressed.size(0)) == 0);
+
+  // Replace the cache entry in order to make sure that it is used.
+  gli::save_dds(TextureCompressor::compress(createImage(64, 32, 1, gradient)), cacheFile);
+  CHECK(TextureCompressor::loadCached(fileName, cacheDirectory).format() ==
+        gli::FORMAT_R_ATI1N_UNORM_BLOCK8);
+
+  std::remove(fileName.c_str());
+  boost::filesystem::remove_all(cacheDirectory);
+
+  CHECK(TextureCompressor::loadCached(fileName, cacheDirectory).empty());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::graphics
@@ -0,0 +1,186 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "../../src/cs-gui/JavaScriptBatch.hpp"
+#include "../../src/cs-utils/doctest.hpp"
+
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace cs::gui {
+
+namespace {
+
+// Wraps a call like JavaScriptBatch::flush() does.
+std::string wrap(std::string const& call) {
+  return "try{" + call + "}catch(e){console.error(e);}\n";
+}
+
+template <typename T>
+std::string toJavaScript(T&& value) {
+  std::string result;
+  JavaScriptBatch::appendValue(result, std::forward<T>(value));
+  return result;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("cs::gui::JavaScriptBatch::appendValue") {
+  CHECK_EQ(toJavaScript(true), "1");
+  CHECK_EQ(toJavaScript(false), "0");
+  CHECK_EQ(toJavaScript(-42), "-42");
+  CHECK_EQ(toJavaScript(uint64_t(18446744073709551615U)), "18446744073709551615");
+  CHECK_EQ(toJavaScript(0.5), "0.5");
+  CHECK_EQ(toJavaScript(0.1), "0.1");
+  CHECK_EQ(toJavaScript(0.1F), "0.1");
+  CHECK_EQ(toJavaScript(1e300), "1e+300");
+  CHECK_EQ(toJavaScript(std::numeric_limits<double>::infinity()), "Infinity");
+  CHECK_EQ(toJavaScript(-std::numeric_limits<double>::infinity()), "-Infinity");
+  CHECK_EQ(toJavaScript(std::numeric_limits<double>::quiet_NaN()), "NaN");
+  CHECK_EQ(toJavaScript("foo"), "\"foo\"");
+  CHECK_EQ(toJavaScript(std::string("a\"b\\c\nd\re")), R"("a\"b\\c\nd\re")");
+  CHECK_EQ(toJavaScript(std::string_view("bar")), "\"bar\"");
+
+  // Doubles can be parsed back to the same value.
+  double value = 1.0 / 3.0;
+  CHECK_EQ(std::stod(toJavaScript(value)), value);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("cs::gui::JavaScriptBatch") {
+  JavaScriptBatch batch;
+
+  SUBCASE("An empty batch produces no code") {
+    CHECK(batch.empty());
+    CHECK_EQ(batch.flush(), "");
+  }
+
+  SUBCASE("Calls are combined in order") {
+    batch.add("CosmoScout.update");
+    batch.add("CosmoScout.gui.addHtml", "id", "<div class=\"a\"></div>", false);
+    batch.add("print", 1, 2.5);
+
+    CHECK_EQ(batch.getCallCount(), 3U);
+    CHECK_EQ(batch.flush(),
+        wrap("CosmoScout.update()") +
+            wrap(R"(CosmoScout.gui.addHtml("id","<div class=\"a\"></div>",0))") +
+            wrap("print(1,2.5)"));
+
+    CHECK(batch.empty());
+    CHECK_EQ(batch.getCallCount(), 0U);
+  }
+
+  SUBCASE("Identical setter calls are dropped") {
+    batch.add("setText", "foo");
+    batch.add("setText", "foo");
+    batch.add("CosmoScout.gui.setSliderValue", "slider", 0.5);
+    batch.add("CosmoScout.gui.setSliderValue", "slider", 0.5);
+
+    CHECK_EQ(batch.getCallCount(), 4U);
+    CHECK_EQ(batch.flush(),
+        wrap(R"(setText("foo"))") + wrap(R"(CosmoScout.gui.setSliderValue("slider",0.5))"));
+  }
+
+  SUBCASE("Setter calls with changed arguments are kept") {
+    batch.add("setText", "foo");
+    batch.add("setText", "bar");
+    batch.add("setText", "foo");
+
+    CHECK_EQ(batch.flush(),
+        wrap(R"(setText("foo"))") + wrap(R"(setText("bar"))") + wrap(R"(setText("foo"))"));
+  }
+
+  SUBCASE("Setter calls are kept if other functions are called in between") {
+    batch.add("setText", "foo");
+    batch.add("reset");
+    batch.add("setText", "foo");
+
+    CHECK_EQ(
+        batch.flush(), wrap(R"(setText("foo"))") + wrap("reset()") + wrap(R"(setText("foo"))"));
+  }
+
+  SUBCASE("Other functions are never dropped") {
+    batch.add("settings", 1);
+    batch.add("settings", 1);
+    batch.add("CosmoScout.notifications.print", "title");
+    batch.add("CosmoScout.notifications.print", "title");
+
+    CHECK_EQ(batch.flush(), wrap("settings(1)") + wrap("settings(1)") +
+                                wrap(R"(CosmoScout.notifications.print("title"))") +
+                                wrap(R"(CosmoScout.notifications.print("title"))"));
+  }
+
+  SUBCASE("Setter calls are not compared across batches") {
+    batch.add("setText", "foo");
+    batch.flush();
+    batch.add("setText", "foo");
+
+    CHECK_EQ(batch.flush(), wrap(R"(setText("foo"))"));
+  }
+
+  SUBCASE("Calls can be added from several threads while the batch is flushed") {
+    int const threadCount = 4;
+    int const callCount   = 1000;
+
+    // Like WebView::callJavascript() is used by log messages of worker threads.
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t) {
+      threads.emplace_back([&batch, t]() {
+        for (int i = 0; i < callCount; ++i) {
+          batch.add("print", t, i);
+        }
+      });
+    }
+
+    // Like WebView::flushAllJavascript() is called by the main thread.
+    std::string code;
+    uint32_t    flushedCalls = 0;
+
+    for (int i = 0; i < 100; ++i) {
+      uint32_t count{};
+      code += batch.flush(count);
+      flushedCalls += count;
+    }
+
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    uint32_t count{};
+    code += batch.flush(count);
+    flushedCalls += count;
+
+    CHECK_EQ(flushedCalls, threadCount * callCount);
+
+    // No call is lost or damaged and the calls of each thread are in order.
+    std::vector<int> nextCall(threadCount, 0);
+    std::size_t      start = 0;
+
+    while (start < code.size()) {
+      std::size_t end = code.find('\n', start);
+      REQUIRE(end != std::string::npos);
+
+      std::string line = code.substr(start, end + 1 - start);
+      int         t    = line.at(std::string("try{print(").size()) - '0';
+      REQUIRE((t >= 0 && t < threadCount));
+      CHECK_EQ(line, wrap("print(" + std::to_string(t) + "," + std::to_string(nextCall[t]) + ")"));
+
+      ++nextCall[t];
+      start = end + 1;
+    }
+
+    CHECK_EQ(nextCall, std::vector<int>(threadCount, callCount));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::gui
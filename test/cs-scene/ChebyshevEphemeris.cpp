@@ -0,0 +1,198 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "../../src/cs-scene/ChebyshevEphemeris.hpp"
+#include "../../src/cs-scene/logger.hpp"
+#include "../../src/cs-utils/doctest.hpp"
+#include "../SyntheticKernel.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace cs::scene {
+
+namespace {
+
+// The SPK file which is written by the tests.
+char const* const KERNEL_FILE = "./testChebyshevEphemeris.bsp";
+
+// The synthetic kernel contains the orbit of this body around the Earth.
+char const* const BODY_NAME = "-999";
+int const         BODY_ID   = -999;
+
+// The time interval covered by the synthetic kernel.
+double const COVERAGE_START = 0.0;
+double const COVERAGE_END   = 2.0 * 86400.0;
+
+// Writes and loads the synthetic kernel, see test/SyntheticKernel.hpp. The orbit is eccentric, so
+// that the segments of the ephemeris have to be split close to the periapsis.
+class SyntheticKernel : public test::SyntheticKernel {
+ public:
+  SyntheticKernel()
+      : test::SyntheticKernel(KERNEL_FILE, BODY_ID, COVERAGE_START, COVERAGE_END, 0.2) {
+  }
+};
+
+// Computes the position of the test body relative to the Earth with a direct call to SPICE. The
+// result uses the same axis convention as the CelestialAnchor.
+glm::dvec3 getReference(double tTime) {
+  glm::dvec3 position;
+  glm::dvec3 velocity;
+  REQUIRE(test::getSyntheticReference(BODY_NAME, tTime, position, velocity));
+  return position;
+}
+
+// Returns count evenly spaced sample times in [tStart, tEnd).
+std::vector<double> getTimes(double tStart, double tEnd, int count) {
+  std::vector<double> times(count);
+  for (int i = 0; i < count; ++i) {
+    times[i] = tStart + (tEnd - tStart) * i / count;
+  }
+  return times;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("cs::scene::ChebyshevEphemeris") {
+  SyntheticKernel kernel;
+
+  ChebyshevEphemeris ephemeris("EARTH", "J2000", BODY_NAME, "J2000");
+  ephemeris.setSegmentLength(1800.0);
+
+  std::vector<glm::dvec4> points;
+
+  SUBCASE("The approximation stays within the tolerance") {
+    for (double tolerance : {1e-6, 1e-8, 1e-10}) {
+      ephemeris.setTolerance(tolerance);
+
+      auto times = getTimes(COVERAGE_START + 1000.0, COVERAGE_END - 1000.0, 20000);
+
+      points.clear();
+      ephemeris.sample(times, points);
+
+      REQUIRE_EQ(points.size(), times.size());
+
+      double maxError = 0.0;
+      for (std::size_t i = 0; i < times.size(); ++i) {
+        glm::dvec3 reference = getReference(times[i]);
+
+        CHECK_EQ(points[i].w, times[i]);
+        maxError = std::max(maxError, glm::length(points[i].xyz() - reference) /
+                                          glm::length(reference));
+      }
+
+      // The fit is only checked at a few points per segment, so the actual error may be slightly
+      // larger than the tolerance.
+      CHECK_LT(maxError, 10.0 * tolerance);
+    }
+  }
+
+  SUBCASE("SPICE is called much less often than once per sample") {
+    auto times = getTimes(COVERAGE_START, COVERAGE_END, 20000);
+
+    ephemeris.sample(times, points);
+
+    CHECK_EQ(points.size(), times.size());
+    CHECK_LT(ephemeris.getSpiceEvaluations(), times.size() / 4);
+  }
+
+  SUBCASE("Only the edges of a moving window are fitted") {
+    double const window = 6.0 * 3600.0;
+    double const step   = 600.0;
+
+    ephemeris.sample(getTimes(10000.0, 10000.0 + window, 1000), points);
+
+    std::size_t initial   = ephemeris.getSpiceEvaluations();
+    std::size_t perUpdate = 0;
+
+    for (double tStart = 10000.0 + step; tStart < 50000.0; tStart += step) {
+      std::size_t before = ephemeris.getSpiceEvaluations();
+
+      ephemeris.prune(tStart, tStart + window);
+      ephemeris.sample(getTimes(tStart, tStart + window, 1000), points);
+
+      perUpdate = std::max(perUpdate, ephemeris.getSpiceEvaluations() - before);
+    }
+
+    // The window spans several segments, at most one of them is new in each update.
+    CHECK_LT(perUpdate, initial);
+  }
+
+  SUBCASE("Samples without data are skipped") {
+    std::vector<double> times = {
+        COVERAGE_START - 1000.0, COVERAGE_START + 1000.0, COVERAGE_END - 10.0, COVERAGE_END + 10.0};
+
+    ephemeris.sample(times, points);
+
+    REQUIRE_EQ(points.size(), 2);
+    CHECK_EQ(points[0].w, times[1]);
+    CHECK_EQ(points[1].w, times[2]);
+
+    for (auto const& point : points) {
+      glm::dvec3 reference = getReference(point.w);
+      CHECK_LT(glm::length(point.xyz() - reference), 1e-5 * glm::length(reference));
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("[benchmark] cs::scene::ChebyshevEphemeris") {
+  SyntheticKernel kernel;
+
+  // A trajectory with 10000 samples which moves along by one sample a thousand times.
+  int const    samples = 10000;
+  int const    updates = 1000;
+  double const length  = 86400.0;
+  double const step    = length / samples;
+
+  CelestialAnchor observer("EARTH", "J2000");
+  CelestialAnchor target(BODY_NAME, "J2000");
+
+  ChebyshevEphemeris ephemeris("EARTH", "J2000", BODY_NAME, "J2000");
+  ephemeris.setSegmentLength(64.0 * step);
+
+  std::vector<glm::dvec4> direct;
+  std::vector<glm::dvec4> approximated;
+
+  auto start = std::chrono::high_resolution_clock::now();
+
+  for (int i = 0; i < samples + updates; ++i) {
+    double tTime = COVERAGE_START + 1000.0 + i * step;
+    direct.emplace_back(observer.getRelativePosition(tTime, target), tTime);
+  }
+
+  auto middle = std::chrono::high_resolution_clock::now();
+
+  ephemeris.sample(getTimes(COVERAGE_START + 1000.0, COVERAGE_START + 1000.0 + length, samples),
+      approximated);
+
+  for (int i = samples; i < samples + updates; ++i) {
+    double tTime = COVERAGE_START + 1000.0 + i * step;
+    ephemeris.prune(tTime - length, tTime);
+    ephemeris.sample({tTime}, approximated);
+  }
+
+  auto end = std::chrono::high_resolution_clock::now();
+
+  REQUIRE_EQ(approximated.size(), direct.size());
+
+  double maxError = 0.0;
+  for (std::size_t i = 0; i < direct.size(); ++i) {
+    maxError = std::max(maxError, glm::length(direct[i].xyz() - approximated[i].xyz()));
+  }
+
+  logger().info("Sampled {} positions: {:.1f} ms with SPICE, {:.1f} ms with {} SPICE calls "
+                "approximated, the maximum error is {:.3f} m.",
+      direct.size(), std::chrono::duration<double, std::milli>(middle - start).count(),
+      std::chrono::duration<double, std::milli>(end - middle).count(),
+      ephemeris.getSpiceEvaluations(), maxError);
+}
+
+} // namespace cs::scene
@@ -0,0 +1,131 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "../../src/cs-scene/EphemerisTable.hpp"
+#include "../../src/cs-scene/CelestialAnchor.hpp"
+#include "../../src/cs-utils/doctest.hpp"
+#include "../SyntheticKernel.hpp"
+
+#include <vector>
+
+namespace cs::scene {
+
+namespace {
+
+// The SPK files which are written by the tests.
+char const* const EARTH_KERNEL_FILE = "./testEphemerisTableEarth.bsp";
+char const* const BODY_KERNEL_FILE  = "./testEphemerisTableBody.bsp";
+
+// The table stores all positions relative to the solar system barycenter, so the tests need an
+// orbit of the Earth around it. The test body orbits the Earth.
+char const* const BODY_NAME = "-997";
+int const         BODY_ID   = -997;
+int const         EARTH_ID  = 399;
+int const         SSB_ID    = 0;
+
+// The time interval covered by the synthetic kernels.
+double const COVERAGE_START = 0.0;
+double const COVERAGE_END   = 86400.0;
+
+// Writes and loads both synthetic kernels, see test/SyntheticKernel.hpp.
+class SyntheticKernels {
+ public:
+  SyntheticKernels()
+      : mEarth(EARTH_KERNEL_FILE, EARTH_ID, COVERAGE_START, COVERAGE_END, 0.1, SSB_ID)
+      , mBody(BODY_KERNEL_FILE, BODY_ID, COVERAGE_START, COVERAGE_END, 0.2) {
+  }
+
+ private:
+  test::SyntheticKernel mEarth;
+  test::SyntheticKernel mBody;
+};
+
+// Checks that both rotations transform some directions in the same way.
+void checkRotation(glm::dquat const& rotation, glm::dquat const& reference) {
+  for (auto const& direction : {glm::dvec3(1, 0, 0), glm::dvec3(0, 1, 0), glm::dvec3(0, 0, 1)}) {
+    CHECK_LT(glm::length(rotation * direction - reference * direction), 1e-12);
+  }
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("cs::scene::EphemerisTable") {
+  std::vector<double> times = {1000.0, 20000.0, 50000.0};
+
+  {
+    SyntheticKernels kernels;
+
+    CelestialAnchor observer("EARTH", "J2000");
+    CelestialAnchor target(BODY_NAME, "ECLIPJ2000");
+    target.setAnchorPosition(glm::dvec3(1000.0, -2000.0, 3000.0));
+
+    SUBCASE("Lookups return the same results as SPICE") {
+      for (double tTime : times) {
+        // Queries for times which are not in the table fall back to SPICE.
+        EphemerisTable::update(tTime + 1.0);
+
+        glm::dvec3 spicePosition = observer.getRelativePosition(tTime, target);
+        glm::dquat spiceRotation = observer.getRelativeRotation(tTime, target);
+
+        EphemerisTable::update(tTime);
+
+        glm::dvec3 tablePosition = observer.getRelativePosition(tTime, target);
+        glm::dquat tableRotation = observer.getRelativeRotation(tTime, target);
+
+        CHECK_LT(glm::length(tablePosition - spicePosition), 1e-3);
+        checkRotation(tableRotation, spiceRotation);
+
+        // Without an offset, this is the plain position of the body relative to the Earth.
+        glm::dvec3 position;
+        glm::dvec3 velocity;
+        REQUIRE(test::getSyntheticReference(BODY_NAME, tTime, position, velocity));
+
+        glm::dvec3 result;
+        REQUIRE(EphemerisTable::getRelativePosition(tTime, EphemerisTable::internCenter("EARTH"),
+            EphemerisTable::internFrame("J2000"), EphemerisTable::internCenter(BODY_NAME),
+            EphemerisTable::internFrame("J2000"), glm::dvec3(0.0), result));
+        CHECK_LT(glm::length(result - position), 1e-3);
+      }
+    }
+
+    SUBCASE("Queries for other times or missing data return false") {
+      EphemerisTable::update(times[0]);
+
+      glm::dvec3 position;
+      glm::dquat rotation;
+
+      int earth = EphemerisTable::internCenter("EARTH");
+      int body  = EphemerisTable::internCenter(BODY_NAME);
+      int frame = EphemerisTable::internFrame("J2000");
+
+      CHECK(EphemerisTable::getRelativePosition(
+          times[0], earth, frame, body, frame, glm::dvec3(0.0), position));
+      CHECK_FALSE(EphemerisTable::getRelativePosition(
+          times[1], earth, frame, body, frame, glm::dvec3(0.0), position));
+      CHECK_FALSE(EphemerisTable::getRelativeRotation(times[1], frame, frame, rotation));
+
+      // There is no data for this center at all.
+      int unknown = EphemerisTable::internCenter("-996");
+      EphemerisTable::update(times[0]);
+      CHECK_FALSE(EphemerisTable::getRelativePosition(
+          times[0], earth, frame, unknown, frame, glm::dvec3(0.0), position));
+
+      // The body has no data outside of the coverage of its kernel.
+      EphemerisTable::update(COVERAGE_END + 1000.0);
+      CHECK_FALSE(EphemerisTable::getRelativePosition(
+          COVERAGE_END + 1000.0, earth, frame, body, frame, glm::dvec3(0.0), position));
+    }
+  }
+
+  // Make sure that other tests do not get results from the synthetic kernels.
+  EphemerisTable::update(COVERAGE_START - 1000.0);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::scene
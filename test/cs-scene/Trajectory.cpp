@@ -0,0 +1,135 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "../../src/cs-scene/Trajectory.hpp"
+#include "../../src/cs-scene/logger.hpp"
+#include "../../src/cs-utils/doctest.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+#include <vector>
+
+namespace cs::scene {
+
+namespace {
+
+// Computes the position relative to the observer (xyz) and the time relative to the current time
+// (w) in single precision, just like the vertex shader of the Trajectory does.
+glm::vec4 getRelative(Trajectory::Vertex const& vertex, Trajectory::Vertex const& observer) {
+  return (vertex.mHigh - observer.mHigh) + (vertex.mLow - observer.mLow);
+}
+
+// Returns a random point on an orbit around the Sun together with a time in the 21st century.
+glm::dvec4 getRandomPoint(std::mt19937& generator) {
+  std::uniform_real_distribution<> angleDist(0.0, 2.0 * glm::pi<double>());
+  std::uniform_real_distribution<> timeDist(0.0, 3e9);
+
+  double const radius = 1.5e11;
+  double const angle  = angleDist(generator);
+
+  return glm::dvec4(radius * std::cos(angle), 0.0, radius * std::sin(angle), timeDist(generator));
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("cs::scene::Trajectory::toVertex") {
+  std::mt19937                     generator(42);
+  std::uniform_real_distribution<> offsetDist(-1.0, 1.0);
+
+  // The observer is at different distances from the points and the ages are between a few seconds
+  // and many days.
+  for (double scale : {10.0, 1e4, 1e7}) {
+    for (int i = 0; i < 1000; ++i) {
+      glm::dvec4 point = getRandomPoint(generator);
+      glm::dvec4 observer =
+          point + glm::dvec4(scale * offsetDist(generator), scale * offsetDist(generator),
+                      scale * offsetDist(generator), scale * offsetDist(generator));
+
+      glm::dvec4 expected = point - observer;
+      glm::dvec4 relative(
+          getRelative(Trajectory::toVertex(point), Trajectory::toVertex(observer)));
+
+      // A single float would have an error of several kilometers at this distance from the Sun.
+      CHECK_LT(glm::length(glm::dvec3(relative - expected)),
+          2e-3 + 1e-7 * glm::length(glm::dvec3(expected)));
+      CHECK_LT(std::abs(relative.w - expected.w), 1e-5 + 1e-7 * std::abs(expected.w));
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("[benchmark] cs::scene::Trajectory") {
+  // Many trajectories with many samples each, one new sample is added to each trajectory per frame.
+  int const trajectories = 200;
+  int const samples      = 2000;
+  int const frames       = 100;
+
+  std::mt19937 generator(42);
+
+  std::vector<std::vector<glm::dvec4>> points(trajectories, std::vector<glm::dvec4>(samples));
+  for (auto& trajectory : points) {
+    for (auto& point : trajectory) {
+      point = getRandomPoint(generator);
+    }
+  }
+
+  glm::dmat4 relativeTransform = glm::translate(glm::dmat4(1.0), glm::dvec3(-1.5e11, 0.0, 0.0));
+  glm::dmat4 matModelView      = glm::translate(glm::dmat4(1.0), glm::dvec3(0.0, -1.7, 0.0));
+  double     tTime             = 1.5e9;
+
+  // This is what Trajectory::upload() used to do for each trajectory in each frame: All points are
+  // transformed to observer centric coordinates, their age is computed and the result is stored in
+  // a new vector which is then uploaded as a whole.
+  auto start = std::chrono::high_resolution_clock::now();
+
+  double checksum = 0.0;
+
+  for (int frame = 0; frame < frames; ++frame) {
+    for (int t = 0; t < trajectories; ++t) {
+      std::vector<glm::vec4> transformed(samples);
+
+      for (int i = 0; i < samples; ++i) {
+        glm::dvec4 const& curr = points[t][(i + frame) % samples];
+        glm::dvec4        pos  = relativeTransform * glm::dvec4(curr.x, curr.y, curr.z, 1.0);
+        transformed[i] = glm::vec4(pos.x, pos.y, pos.z, static_cast<float>(tTime - curr.w));
+      }
+
+      checksum += transformed[frame].w;
+    }
+  }
+
+  auto middle = std::chrono::high_resolution_clock::now();
+
+  // Now, only the new point is written to the mapped buffer and the uniforms are computed once per
+  // trajectory and frame.
+  std::vector<std::vector<Trajectory::Vertex>> vertices(
+      trajectories, std::vector<Trajectory::Vertex>(samples + 1));
+
+  for (int frame = 0; frame < frames; ++frame) {
+    for (int t = 0; t < trajectories; ++t) {
+      int index           = frame % samples;
+      vertices[t][index]  = Trajectory::toVertex(points[t][index]);
+      glm::dvec3 observer = glm::dvec3(glm::inverse(matModelView * relativeTransform)[3]);
+
+      checksum += Trajectory::toVertex(glm::dvec4(observer, tTime)).mHigh.w;
+    }
+  }
+
+  auto end = std::chrono::high_resolution_clock::now();
+
+  logger().info("Updated {} trajectories with {} samples for {} frames: {:.1f} ms transforming all "
+                "points, {:.1f} ms writing only new points (checksum {}).",
+      trajectories, samples, frames,
+      std::chrono::duration<double, std::milli>(middle - start).count(),
+      std::chrono::duration<double, std::milli>(end - middle).count(), checksum);
+}
+
+} // namespace cs::scene
@@ -0,0 +1,211 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "../../src/cs-utils/ThreadPool.hpp"
+#include "../../src/cs-utils/doctest.hpp"
+#include "../../src/cs-utils/logger.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <stack>
+#include <stdexcept>
+#include <vector>
+
+namespace cs::utils {
+
+namespace {
+
+// This is the ThreadPool as it was before tasks got priorities. It is only used as a baseline for
+// the benchmark below.
+class LegacyThreadPool {
+ public:
+  explicit LegacyThreadPool(size_t threads) {
+    for (size_t i = 0; i < threads; ++i) {
+      mWorkers.emplace_back([this] {
+        while (true) {
+          std::function<void()> task;
+          {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this] { return mStop || !mTasks.empty(); });
+            if (mStop && mTasks.empty()) {
+              return;
+            }
+            task = std::move(mTasks.top());
+            mTasks.pop();
+          }
+          task();
+        }
+      });
+    }
+  }
+
+  LegacyThreadPool(LegacyThreadPool const& other) = delete;
+  LegacyThreadPool(LegacyThreadPool&& other)      = delete;
+
+  LegacyThreadPool& operator=(LegacyThreadPool const& other) = delete;
+  LegacyThreadPool& operator=(LegacyThreadPool&& other) = delete;
+
+  ~LegacyThreadPool() {
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mStop = true;
+    }
+    mCondition.notify_all();
+    for (std::thread& worker : mWorkers) {
+      worker.join();
+    }
+  }
+
+  template <class F>
+  auto enqueue(F&& f) -> std::future<typename std::invoke_result<F>::type> {
+    using return_type = typename std::invoke_result<F>::type;
+    auto task         = std::make_shared<std::packaged_task<return_type()>>(
+        [Func = std::forward<F>(f)] { return Func(); });
+    std::future<return_type> res = task->get_future();
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mTasks.emplace([task]() { (*task)(); });
+    }
+    mCondition.notify_one();
+    return res;
+  }
+
+ private:
+  std::vector<std::thread>          mWorkers;
+  std::stack<std::function<void()>> mTasks;
+  std::mutex                        mMutex;
+  std::condition_variable           mCondition;
+  bool                              mStop = false;
+};
+
+// Enqueues the given number of tiny tasks and returns the time in milliseconds until all of them
+// have been executed.
+template <typename Pool>
+double measure(size_t threads, size_t tasks) {
+  std::atomic<size_t> counter{0};
+  auto                start = std::chrono::high_resolution_clock::now();
+
+  {
+    Pool pool(threads);
+    for (size_t i = 0; i < tasks; ++i) {
+      pool.enqueue([&counter] { ++counter; });
+    }
+  }
+
+  auto end = std::chrono::high_resolution_clock::now();
+
+  CHECK_EQ(counter.load(), tasks);
+
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+} // namespace
+
+TEST_CASE("cs::utils::ThreadPool") {
+  ThreadPool pool(4);
+
+  std::vector<std::future<int>> results;
+  for (int i = 0; i < 1000; ++i) {
+    results.push_back(pool.enqueue([i] { return i; }));
+  }
+
+  int sum = 0;
+  for (auto& r : results) {
+    sum += r.get();
+  }
+
+  CHECK_EQ(sum, 999 * 1000 / 2);
+};
+
+TEST_CASE("cs::utils::ThreadPool priorities and cancellation") {
+  ThreadPool pool(1);
+
+  // Block the only worker until all tasks have been enqueued.
+  std::promise<void> started;
+  std::promise<void> gate;
+  auto               gateFuture = gate.get_future().share();
+  pool.enqueue([&started, gateFuture] {
+    started.set_value();
+    gateFuture.wait();
+  });
+  started.get_future().wait();
+
+  std::mutex       mutex;
+  std::vector<int> order;
+
+  TaskHandle low(1.0);
+  TaskHandle high(2.0);
+  TaskHandle cancelled(3.0);
+  TaskHandle changed(0.0);
+
+  auto add = [&mutex, &order](int i) {
+    std::unique_lock<std::mutex> lock(mutex);
+    order.push_back(i);
+  };
+
+  pool.enqueue([&add] { add(1); }, low);
+  pool.enqueue([&add] { add(2); }, high);
+  auto cancelledResult = pool.enqueue([&add] { add(3); }, cancelled);
+  pool.enqueue([&add] { add(4); }, changed);
+
+  cancelled.cancel();
+  changed.setPriority(10.0);
+  pool.reprioritize();
+
+  gate.set_value();
+
+  CHECK_THROWS_AS(cancelledResult.get(), std::future_error);
+
+  while (!pool.hasFinished()) {
+    std::this_thread::yield();
+  }
+
+  CHECK_EQ(order, (std::vector<int>{4, 2, 1}));
+};
+
+TEST_CASE("cs::utils::parallelFor") {
+  SUBCASE("Each index is processed exactly once") {
+    for (std::size_t chunkSize : {1UL, 7UL, 1000UL}) {
+      std::vector<std::atomic<int>> counts(1000);
+      parallelFor(
+          counts.size(), [&counts](std::size_t i) { ++counts[i]; }, chunkSize);
+
+      for (auto const& count : counts) {
+        CHECK_EQ(count.load(), 1);
+      }
+    }
+  }
+
+  SUBCASE("Exceptions are rethrown on the calling thread") {
+    CHECK_THROWS_AS(parallelFor(100,
+                        [](std::size_t i) {
+                          if (i == 50) {
+                            throw std::runtime_error("Test error.");
+                          }
+                        }),
+        std::runtime_error);
+  }
+
+  SUBCASE("Nested calls do not block each other") {
+    std::atomic<int> sum{0};
+    parallelFor(16, [&sum](std::size_t) { parallelFor(16, [&sum](std::size_t) { ++sum; }); });
+    CHECK_EQ(sum.load(), 256);
+  }
+};
+
+TEST_CASE("[benchmark] cs::utils::ThreadPool contention") {
+  size_t threads = std::max(std::thread::hardware_concurrency(), 2U);
+
+  for (size_t tasks : {10000UL, 100000UL, 1000000UL}) {
+    double legacy  = measure<LegacyThreadPool>(threads, tasks);
+    double current = measure<ThreadPool>(threads, tasks);
+
+    logger().info("{} tasks on {} threads: LIFO stack {:.1f} ms, work-stealing queues {:.1f} ms.",
+        tasks, threads, legacy, current);
+  }
+};
+
+} // namespace cs::utils
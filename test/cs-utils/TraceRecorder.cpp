@@ -0,0 +1,229 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//                               This file is part of CosmoScout VR                               //
+//      and may be used under the terms of the MIT license. See the LICENSE file for details.     //
+//                        Copyright: (c) 2019 German Aerospace Center (DLR)                       //
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "../../src/cs-utils/TraceRecorder.hpp"
+#include "../../src/cs-utils/doctest.hpp"
+#include "../../src/cs-utils/logger.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace cs::utils {
+
+namespace {
+
+// Returns the number of CPU zones with the given name in the given trace.
+std::size_t countZones(std::string const& trace, std::string const& name) {
+  std::regex  pattern(R"("cat":"cpu",[^}]*"name":")" + name + R"(")");
+  std::size_t count = 0;
+
+  for (auto it = std::sregex_iterator(trace.begin(), trace.end(), pattern);
+       it != std::sregex_iterator(); ++it) {
+    ++count;
+  }
+
+  return count;
+}
+
+// Returns the track, the id and the parent id of the first CPU zone with the given name.
+std::array<uint64_t, 3> getZone(std::string const& trace, std::string const& name) {
+  std::regex pattern(R"("tid":(\d+),"cat":"cpu",[^}]*"name":")" + name +
+                     R"(","args":\{"id":(\d+),"parent":(\d+)\})");
+  std::smatch match;
+
+  REQUIRE(std::regex_search(trace, match, pattern));
+
+  return {std::stoull(match[1]), std::stoull(match[2]), std::stoull(match[3])};
+}
+
+// Enables the recording and starts a new frame. All previously recorded frames are dropped. Returns
+// the number of the new frame.
+uint64_t startFrame() {
+  TraceRecorder::setEnabled(true);
+  uint64_t frame = TraceRecorder::endFrame() + 1;
+  TraceRecorder::clear();
+  return frame;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("cs::utils::TraceRecorder") {
+  SUBCASE("Nothing is recorded while disabled") {
+    uint64_t frame = startFrame();
+    TraceRecorder::setEnabled(false);
+
+    { CS_TRACE_ZONE("disabled"); }
+
+    REQUIRE(TraceRecorder::endFrame() == frame);
+    CHECK(TraceRecorder::getFirstFrame() == 0);
+    CHECK(TraceRecorder::getLastFrame() == frame);
+    CHECK(countZones(TraceRecorder::exportChromeTrace(0, frame), "disabled") == 0);
+  }
+
+  SUBCASE("Nested zones reference their parent") {
+    uint64_t frame = startFrame();
+
+    {
+      CS_TRACE_ZONE("outer");
+      { CS_TRACE_ZONE("first"); }
+      {
+        CS_TRACE_ZONE("second");
+        { CS_TRACE_ZONE("third"); }
+      }
+    }
+
+    REQUIRE(TraceRecorder::endFrame() == frame);
+    CHECK(TraceRecorder::getFirstFrame() == frame);
+    CHECK(TraceRecorder::getLastFrame() == frame);
+
+    auto trace  = TraceRecorder::exportChromeTrace(frame, frame);
+    auto outer  = getZone(trace, "outer");
+    auto first  = getZone(trace, "first");
+    auto second = getZone(trace, "second");
+    auto third  = getZone(trace, "third");
+
+    CHECK(outer[2] == 0);
+    CHECK(first[2] == outer[1]);
+    CHECK(second[2] == outer[1]);
+    CHECK(third[2] == second[1]);
+    CHECK(outer[0] == third[0]);
+    CHECK(trace.find("\"name\":\"Frame " + std::to_string(frame) + "\"") != std::string::npos);
+  }
+
+  SUBCASE("Zones of other threads are recorded on separate tracks") {
+    uint64_t frame = startFrame();
+
+    { CS_TRACE_ZONE("main"); }
+
+    std::thread worker([]() {
+      TraceRecorder::setThreadName("Worker \"A\"");
+      CS_TRACE_ZONE("worker");
+    });
+    worker.join();
+
+    REQUIRE(TraceRecorder::endFrame() == frame);
+
+    auto trace = TraceRecorder::exportChromeTrace(frame, frame);
+    CHECK(getZone(trace, "main")[0] != getZone(trace, "worker")[0]);
+    CHECK(trace.find(R"("name":"Worker \"A\"")") != std::string::npos);
+  }
+
+  SUBCASE("Only zones of the requested frames are exported") {
+    uint64_t frame = startFrame();
+
+    { CS_TRACE_ZONE("early"); }
+    REQUIRE(TraceRecorder::endFrame() == frame);
+
+    { CS_TRACE_ZONE("late"); }
+    REQUIRE(TraceRecorder::endFrame() == frame + 1);
+
+    auto trace = TraceRecorder::exportChromeTrace(frame + 1, frame + 1);
+    CHECK(countZones(trace, "early") == 0);
+    CHECK(countZones(trace, "late") == 1);
+
+    trace = TraceRecorder::exportChromeTrace(frame, frame + 1);
+    CHECK(countZones(trace, "early") == 1);
+    CHECK(countZones(trace, "late") == 1);
+
+    CHECK(countZones(TraceRecorder::exportChromeTrace(frame + 2, frame + 10), "late") == 0);
+  }
+
+  SUBCASE("The oldest zones are overwritten") {
+    uint64_t frame = startFrame();
+
+    TraceRecorder::setBufferSize(20);
+
+    std::thread worker([]() {
+      for (int i = 0; i < 100; ++i) {
+        CS_TRACE_ZONE("overwritten");
+      }
+    });
+    worker.join();
+
+    TraceRecorder::setBufferSize(32768);
+
+    REQUIRE(TraceRecorder::endFrame() == frame);
+    CHECK(countZones(TraceRecorder::exportChromeTrace(frame, frame), "overwritten") == 32);
+  }
+
+  SUBCASE("Interned names are unique and escaped") {
+    uint64_t    frame = startFrame();
+    std::string name  = "interned\n";
+
+    char const* interned = TraceRecorder::intern(name);
+    CHECK(interned == TraceRecorder::intern("interned\n"));
+    CHECK(interned != name.c_str());
+
+    { TraceRecorder::Zone zone(interned); }
+
+    REQUIRE(TraceRecorder::endFrame() == frame);
+    CHECK(countZones(TraceRecorder::exportChromeTrace(frame, frame), R"(interned\\u000a)") == 1);
+  }
+
+  SUBCASE("Traces can be saved to a file") {
+    uint64_t frame = startFrame();
+
+    { CS_TRACE_ZONE("saved"); }
+    REQUIRE(TraceRecorder::endFrame() == frame);
+
+    std::string fileName = "TraceRecorderTest.json";
+    TraceRecorder::save(fileName, frame, frame);
+
+    std::ifstream file(fileName);
+    std::string   content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+    std::remove(fileName.c_str());
+
+    CHECK(countZones(content, "saved") == 1);
+    CHECK_THROWS_AS(
+        TraceRecorder::save("does/not/exist/trace.json", frame, frame), std::runtime_error);
+  }
+
+  TraceRecorder::setEnabled(false);
+  TraceRecorder::clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("[benchmark] cs::utils::TraceRecorder") {
+  int const zoneCount = 1000000;
+
+  auto measure = [&]() {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (int i = 0; i < zoneCount / 2; ++i) {
+      CS_TRACE_ZONE("outer");
+      { CS_TRACE_ZONE("inner"); }
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / zoneCount;
+  };
+
+  TraceRecorder::setEnabled(false);
+  double disabled = measure();
+
+  TraceRecorder::setEnabled(true);
+  double enabled = measure();
+
+  TraceRecorder::setEnabled(false);
+  TraceRecorder::clear();
+
+  logger().info("Recording a zone takes {:.1f} ns ({:.1f} ns while disabled).", enabled, disabled);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace cs::utils
@@ -7,6 +7,8 @@
 #include "../../src/cs-utils/utils.hpp"
 #include "../../src/cs-utils/doctest.hpp"
 
+#include <array>
+
 namespace cs::utils {
 TEST_CASE("cs::utils::contains(std::string, std::string)") {
   CHECK_UNARY(contains("lorem ipsum", "lor"));
@@ -49,4 +51,23 @@ TEST_CASE("cs::utils::endsWith") {
   CHECK_UNARY_FALSE(endsWith("lorem ipsum", "abracadabra simsalabim"));
 }
 
+TEST_CASE("cs::utils::Fnv1aHash") {
+  CHECK_EQ(Fnv1aHash().get(), 0xcbf29ce484222325U);
+
+  Fnv1aHash hash;
+  hash.add("foobar", 6);
+  CHECK_EQ(hash.get(), 0x85944171f73967e8U);
+
+  // Values are hashed byte by byte, so adding them one after another is the same as adding them
+  // at once.
+  Fnv1aHash a;
+  a.add(uint16_t{1});
+  a.add(uint16_t{2});
+
+  Fnv1aHash b;
+  b.add(std::array<uint16_t, 2>{1, 2});
+
+  CHECK_EQ(a.get(), b.get());
+}
+
 } // namespace cs::utils
\ No newline at end of file